@@ -27,7 +27,7 @@
  * @{
  */
 
-#define LTO_API_VERSION 4
+#define LTO_API_VERSION 5
 
 typedef enum {
     LTO_SYMBOL_ALIGNMENT_MASK              = 0x0000001F, /* log2 of alignment */
@@ -284,6 +284,24 @@ lto_codegen_compile(lto_code_gen_t cg, size_t* length);
 extern bool
 lto_codegen_compile_to_file(lto_code_gen_t cg, const char** name);
 
+/**
+ * Sets the number of partitions (and worker threads) used by
+ * lto_codegen_compile_to_files().  The default of 1 disables partitioned
+ * code generation.
+ */
+extern void
+lto_codegen_set_parallelism(lto_code_gen_t cg, unsigned int parallelism);
+
+/**
+ * Generates code for all added modules into one native object file per
+ * partition, running code generation for the partitions on parallel
+ * threads.  On success, names points to an array of num_names file paths
+ * owned by the lto_code_gen_t.  Returns true on error.
+ */
+extern bool
+lto_codegen_compile_to_files(lto_code_gen_t cg, const char*** names,
+                             size_t* num_names);
+
 
 /**
  * Sets options to help debug codegen bugs.
@@ -0,0 +1,62 @@
+//===- llvm/ADT/CachedHash.h - Key wrapper caching its hash -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines CachedHash, a DenseMap key adaptor that computes the hash
+// of the underlying key once and stores it alongside. DenseMap recomputes the
+// key hash at the start of every probe sequence and again for every entry
+// when the table grows; for keys that are expensive to hash (long APInts,
+// constant expression keys, ...) that recomputation dominates. Wrapping the
+// key in CachedHash makes getHashValue a field load, makes growth
+// redistribute entries without touching the underlying keys, and lets
+// equality tests reject mismatched entries on the cached hash before doing a
+// full key comparison.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_CACHEDHASH_H
+#define LLVM_ADT_CACHEDHASH_H
+
+#include "llvm/ADT/DenseMapInfo.h"
+
+namespace llvm {
+
+template <typename KeyT, typename InfoT = DenseMapInfo<KeyT> >
+struct CachedHash {
+  KeyT Key;
+  unsigned Hash;
+
+  CachedHash(const KeyT &Key) : Key(Key), Hash(InfoT::getHashValue(Key)) {}
+  CachedHash(const KeyT &Key, unsigned Hash) : Key(Key), Hash(Hash) {}
+};
+
+// Provide DenseMapInfo for CachedHash keys. The empty and tombstone keys
+// carry the hash of the underlying sentinel, so the hash prefilter below
+// never gives a different answer than comparing the keys directly would.
+template <typename KeyT, typename InfoT>
+struct DenseMapInfo<CachedHash<KeyT, InfoT> > {
+  static CachedHash<KeyT, InfoT> getEmptyKey() {
+    return CachedHash<KeyT, InfoT>(InfoT::getEmptyKey());
+  }
+  static CachedHash<KeyT, InfoT> getTombstoneKey() {
+    return CachedHash<KeyT, InfoT>(InfoT::getTombstoneKey());
+  }
+  static unsigned getHashValue(const CachedHash<KeyT, InfoT> &Val) {
+    return Val.Hash;
+  }
+  static bool isEqual(const CachedHash<KeyT, InfoT> &LHS,
+                      const CachedHash<KeyT, InfoT> &RHS) {
+    if (LHS.Hash != RHS.Hash)
+      return false;
+    return InfoT::isEqual(LHS.Key, RHS.Key);
+  }
+};
+
+} // end namespace llvm
+
+#endif
@@ -0,0 +1,289 @@
+//===--- CompactStringMap.h - Open-addressed string map ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the CompactStringMap class.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_COMPACTSTRINGMAP_H
+#define LLVM_ADT_COMPACTSTRINGMAP_H
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/Compiler.h"
+#include <cassert>
+#include <cstring>
+#include <new>
+
+namespace llvm {
+
+template<typename ValueTy, typename AllocatorTy> class CompactStringMap;
+
+/// CompactStringMapEntry - One bucket of a CompactStringMap, holding the full
+/// hash, the key, and the value inline.  Keys short enough to fit are stored
+/// in the bucket itself; longer keys are spilled to the map's allocator.
+template<typename ValueTy>
+class CompactStringMapEntry {
+  template<typename VT, typename AT> friend class CompactStringMap;
+public:
+  enum {
+    /// InlineKeyBytes - Keys of up to this many bytes live in the bucket.
+    InlineKeyBytes = 2 * sizeof(void*)
+  };
+
+private:
+  /// EmptyKeyLength - KeyLength value marking an unoccupied bucket.
+  enum { EmptyKeyLength = ~0U };
+
+  unsigned FullHash;
+  unsigned KeyLength;
+  union {
+    char InlineKey[InlineKeyBytes];
+    const char *SpillKey;
+  };
+  ValueTy Val;
+
+  bool isOccupied() const { return KeyLength != unsigned(EmptyKeyLength); }
+
+public:
+  /// getKey - Return the entry's key.  For keys longer than InlineKeyBytes
+  /// the underlying bytes live in the map's allocator and never move; for
+  /// shorter keys they live in the bucket array and are invalidated by any
+  /// operation that can grow the map.
+  StringRef getKey() const {
+    return StringRef(KeyLength <= unsigned(InlineKeyBytes) ? InlineKey
+                                                           : SpillKey,
+                     KeyLength);
+  }
+
+  const ValueTy &getValue() const { return Val; }
+  ValueTy &getValue() { return Val; }
+
+  void setValue(const ValueTy &V) { Val = V; }
+};
+
+/// CompactStringMap - A string map tuned for dense interning tables.  Unlike
+/// StringMap, which allocates a node per entry, this map stores the hash, the
+/// key and the value directly in the bucket array, so a lookup probes one
+/// contiguous allocation and a hit costs at most one pointer chase (none for
+/// short keys).  The tradeoffs relative to StringMap:
+///
+///   * Entry and value references, and getKey() of short keys, are
+///     invalidated whenever the map grows.
+///   * Entries cannot be erased individually.
+///
+/// This fits tables that are built up monotonically and probed heavily, like
+/// symbol interning, and is not a general StringMap replacement.
+template<typename ValueTy, typename AllocatorTy = MallocAllocator>
+class CompactStringMap {
+public:
+  typedef CompactStringMapEntry<ValueTy> EntryTy;
+
+private:
+  EntryTy *TheTable;
+  unsigned NumBuckets;
+  unsigned NumItems;
+  AllocatorTy Allocator;
+
+  CompactStringMap(const CompactStringMap &) LLVM_DELETED_FUNCTION;
+  void operator=(const CompactStringMap &) LLVM_DELETED_FUNCTION;
+
+public:
+  CompactStringMap() : TheTable(0), NumBuckets(0), NumItems(0) {}
+  explicit CompactStringMap(AllocatorTy A)
+    : TheTable(0), NumBuckets(0), NumItems(0), Allocator(A) {}
+
+  ~CompactStringMap() {
+    clear();
+    operator delete(TheTable);
+  }
+
+  typedef typename ReferenceAdder<AllocatorTy>::result AllocatorRefTy;
+  typedef typename ReferenceAdder<const AllocatorTy>::result AllocatorCRefTy;
+  AllocatorRefTy getAllocator() { return Allocator; }
+  AllocatorCRefTy getAllocator() const { return Allocator; }
+
+  unsigned size() const { return NumItems; }
+  bool empty() const { return NumItems == 0; }
+
+  /// clear - Empty the table, retaining the bucket array.
+  void clear() {
+    if (!TheTable)
+      return;
+    for (unsigned i = 0; i != NumBuckets; ++i) {
+      EntryTy &B = TheTable[i];
+      if (!B.isOccupied())
+        continue;
+      if (B.KeyLength > unsigned(EntryTy::InlineKeyBytes))
+        Allocator.Deallocate(B.SpillKey);
+      B.Val.~ValueTy();
+    }
+    memset(TheTable, 0xFF, NumBuckets * sizeof(EntryTy));
+    NumItems = 0;
+  }
+
+  /// count - Return 1 if the element is in the map, 0 otherwise.
+  unsigned count(StringRef Key) const {
+    if (NumBuckets == 0)
+      return 0;
+    return TheTable[LookupBucketFor(Key, HashString(Key))].isOccupied();
+  }
+
+  /// lookup - Return the value for the given key, or a default-constructed
+  /// value if the key is not in the map.
+  ValueTy lookup(StringRef Key) const {
+    if (NumBuckets == 0)
+      return ValueTy();
+    const EntryTy &B = TheTable[LookupBucketFor(Key, HashString(Key))];
+    if (B.isOccupied())
+      return B.Val;
+    return ValueTy();
+  }
+
+  /// GetOrCreateValue - Return the entry for the given key, creating it with
+  /// a default-constructed value if it is not already present.  The returned
+  /// reference is invalidated by any subsequent insertion.
+  EntryTy &GetOrCreateValue(StringRef Key) {
+    if (NumBuckets == 0)
+      init(16);
+
+    unsigned FullHash = HashString(Key);
+    unsigned BucketNo = LookupBucketFor(Key, FullHash);
+    if (TheTable[BucketNo].isOccupied())
+      return TheTable[BucketNo];
+
+    // Grow before inserting so the load factor stays under 3/4.
+    if ((NumItems + 1) * 4 > NumBuckets * 3) {
+      RehashTable();
+      BucketNo = LookupBucketFor(Key, FullHash);
+    }
+
+    EntryTy &B = TheTable[BucketNo];
+    B.FullHash = FullHash;
+    B.KeyLength = Key.size();
+    char *KeyCopy;
+    if (Key.size() <= unsigned(EntryTy::InlineKeyBytes)) {
+      KeyCopy = B.InlineKey;
+    } else {
+      KeyCopy = static_cast<char*>(Allocator.Allocate(Key.size(), 1));
+      B.SpillKey = KeyCopy;
+    }
+    memcpy(KeyCopy, Key.data(), Key.size());
+    new (&B.Val) ValueTy();
+    ++NumItems;
+    return B;
+  }
+
+  ValueTy &operator[](StringRef Key) {
+    return GetOrCreateValue(Key).getValue();
+  }
+
+  /// const_iterator - Walks the occupied buckets in table order.
+  class const_iterator {
+    const EntryTy *Ptr, *End;
+
+    void AdvancePastEmpty() {
+      while (Ptr != End && !Ptr->isOccupied())
+        ++Ptr;
+    }
+
+  public:
+    const_iterator(const EntryTy *P, const EntryTy *E) : Ptr(P), End(E) {
+      AdvancePastEmpty();
+    }
+
+    const EntryTy &operator*() const { return *Ptr; }
+    const EntryTy *operator->() const { return Ptr; }
+
+    const_iterator &operator++() {
+      ++Ptr;
+      AdvancePastEmpty();
+      return *this;
+    }
+
+    bool operator==(const const_iterator &RHS) const { return Ptr == RHS.Ptr; }
+    bool operator!=(const const_iterator &RHS) const { return Ptr != RHS.Ptr; }
+  };
+
+  const_iterator begin() const {
+    return const_iterator(TheTable, TheTable + NumBuckets);
+  }
+  const_iterator end() const {
+    return const_iterator(TheTable + NumBuckets, TheTable + NumBuckets);
+  }
+
+private:
+  /// init - Allocate the initial bucket array.  Size must be a power of two.
+  void init(unsigned Size) {
+    assert((Size & (Size-1)) == 0 && "Init Size must be a power of 2!");
+    TheTable = static_cast<EntryTy*>(operator new(Size * sizeof(EntryTy)));
+    memset(TheTable, 0xFF, Size * sizeof(EntryTy));
+    NumBuckets = Size;
+  }
+
+  /// LookupBucketFor - Return the index of the bucket holding the given key,
+  /// or of the empty bucket where it would be inserted.  The table must not
+  /// be full.
+  unsigned LookupBucketFor(StringRef Key, unsigned FullHash) const {
+    unsigned BucketNo = FullHash & (NumBuckets-1);
+    unsigned ProbeAmt = 1;
+    while (1) {
+      const EntryTy &B = TheTable[BucketNo];
+      if (!B.isOccupied())
+        return BucketNo;
+      // Compare the stored hash before touching the key bytes.
+      if (B.FullHash == FullHash && B.getKey().equals(Key))
+        return BucketNo;
+
+      // Use quadratic probing, it has fewer clumping artifacts than linear
+      // probing and has good cache behavior in the common case.
+      BucketNo = (BucketNo + ProbeAmt++) & (NumBuckets-1);
+    }
+  }
+
+  /// RehashTable - Double the bucket array and reinsert every entry.  Spilled
+  /// key bytes stay where they are; inline keys move with their bucket.
+  void RehashTable() {
+    unsigned NewSize = NumBuckets * 2;
+    EntryTy *NewTable =
+      static_cast<EntryTy*>(operator new(NewSize * sizeof(EntryTy)));
+    memset(NewTable, 0xFF, NewSize * sizeof(EntryTy));
+
+    for (unsigned i = 0; i != NumBuckets; ++i) {
+      EntryTy &Old = TheTable[i];
+      if (!Old.isOccupied())
+        continue;
+
+      // There are no tombstones, so the first empty bucket ends the probe.
+      unsigned BucketNo = Old.FullHash & (NewSize-1);
+      unsigned ProbeAmt = 1;
+      while (NewTable[BucketNo].isOccupied())
+        BucketNo = (BucketNo + ProbeAmt++) & (NewSize-1);
+
+      EntryTy &New = NewTable[BucketNo];
+      New.FullHash = Old.FullHash;
+      New.KeyLength = Old.KeyLength;
+      if (Old.KeyLength <= unsigned(EntryTy::InlineKeyBytes))
+        memcpy(New.InlineKey, Old.InlineKey, Old.KeyLength);
+      else
+        New.SpillKey = Old.SpillKey;
+      new (&New.Val) ValueTy(Old.Val);
+      Old.Val.~ValueTy();
+    }
+
+    operator delete(TheTable);
+    TheTable = NewTable;
+    NumBuckets = NewSize;
+  }
+};
+
+} // end llvm namespace
+
+#endif
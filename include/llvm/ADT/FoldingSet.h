@@ -781,6 +781,37 @@ public:
   }
 };
 
+//===----------------------------------------------------------------------===//
+/// HashedFoldingSetNode - This is a subclass of FoldingSetNode which caches
+/// the node's profile hash.  Probes reject nodes whose hash does not match
+/// before re-profiling them, and table growth rehashes without profiling at
+/// all.  Pair it with HashedFoldingSetTrait.  The node must be immutable
+/// once hashed, and the hash must be set -- normally from the
+/// FoldingSetNodeID used for the failed lookup -- before the node is
+/// inserted into a set.
+class HashedFoldingSetNode : public FoldingSetNode {
+  unsigned FoldingSetHash;
+protected:
+  HashedFoldingSetNode() : FoldingSetHash(0) {}
+public:
+  unsigned getFoldingSetHash() const { return FoldingSetHash; }
+  void setFoldingSetHash(unsigned Hash) { FoldingSetHash = Hash; }
+};
+
+/// HashedFoldingSetTrait - FoldingSetTrait for HashedFoldingSetNode
+/// subclasses, short-circuiting profile comparison through the cached hash.
+template<typename T> struct HashedFoldingSetTrait
+  : public DefaultFoldingSetTrait<T> {
+  static bool Equals(T &X, const FoldingSetNodeID &ID, unsigned IDHash,
+                     FoldingSetNodeID &TempID) {
+    return X.getFoldingSetHash() == IDHash &&
+           DefaultFoldingSetTrait<T>::Equals(X, ID, IDHash, TempID);
+  }
+  static unsigned ComputeHash(T &X, FoldingSetNodeID &TempID) {
+    return X.getFoldingSetHash();
+  }
+};
+
 //===----------------------------------------------------------------------===//
 // Partial specializations of FoldingSetTrait.
 
@@ -0,0 +1,120 @@
+//===- llvm/ADT/FrozenMap.h - Immutable columnar key/value table -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements FrozenMap, an immutable key/value table laid out in
+// struct-of-arrays form: the keys and values live in two separate packed
+// arrays sorted by key.  It is built in one shot from any key/value pair
+// range (typically a DenseMap or MapVector that an analysis populated) and
+// afterwards only supports queries.  Iterating one column touches no bytes
+// of the other, and lookups binary search the key column alone, which makes
+// repeated scans over large analysis result tables far more cache friendly
+// than chasing hash table buckets.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_FROZENMAP_H
+#define LLVM_ADT_FROZENMAP_H
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+/// FrozenMap - An immutable sorted map with the keys and values stored in
+/// two parallel packed arrays.  Keys must be unique and totally ordered by
+/// the Compare functor.
+template<typename KeyT, typename ValueT, typename Compare = std::less<KeyT> >
+class FrozenMap {
+  std::vector<KeyT> Keys;
+  std::vector<ValueT> Values;
+  Compare Less;
+
+  // Orders staging pairs by key during freeze().
+  struct PairLess {
+    Compare Less;
+    explicit PairLess(Compare L) : Less(L) {}
+    bool operator()(const std::pair<KeyT, ValueT> &A,
+                    const std::pair<KeyT, ValueT> &B) const {
+      return Less(A.first, B.first);
+    }
+  };
+
+public:
+  typedef typename std::vector<KeyT>::const_iterator key_iterator;
+  typedef typename std::vector<ValueT>::const_iterator value_iterator;
+  typedef typename std::vector<KeyT>::size_type size_type;
+
+  explicit FrozenMap(Compare L = Compare()) : Less(L) {}
+
+  /// freeze - Replace the table contents with a snapshot of the [I, E) range
+  /// of key/value pairs.  The keys in the range must be distinct.
+  template<typename IterT>
+  void freeze(IterT I, IterT E) {
+    std::vector<std::pair<KeyT, ValueT> > Table;
+    for (; I != E; ++I)
+      Table.push_back(std::make_pair(I->first, I->second));
+    std::sort(Table.begin(), Table.end(), PairLess(Less));
+
+    Keys.clear();
+    Values.clear();
+    Keys.reserve(Table.size());
+    Values.reserve(Table.size());
+    for (size_type i = 0, e = Table.size(); i != e; ++i) {
+      Keys.push_back(Table[i].first);
+      Values.push_back(Table[i].second);
+    }
+  }
+
+  /// freeze - Replace the table contents with a snapshot of an entire map.
+  template<typename MapT>
+  void freeze(const MapT &M) { freeze(M.begin(), M.end()); }
+
+  void clear() {
+    Keys.clear();
+    Values.clear();
+  }
+
+  bool empty() const { return Keys.empty(); }
+  size_type size() const { return Keys.size(); }
+
+  key_iterator key_begin() const { return Keys.begin(); }
+  key_iterator key_end() const { return Keys.end(); }
+
+  value_iterator value_begin() const { return Values.begin(); }
+  value_iterator value_end() const { return Values.end(); }
+
+  /// getKey - Positional access to the key column.
+  const KeyT &getKey(size_type i) const { return Keys[i]; }
+
+  /// getValue - Positional access to the value column.
+  const ValueT &getValue(size_type i) const { return Values[i]; }
+
+  /// find - Return the position of Key, or size() if it is not present.
+  size_type find(const KeyT &Key) const {
+    key_iterator I = std::lower_bound(Keys.begin(), Keys.end(), Key, Less);
+    if (I != Keys.end() && !Less(Key, *I))
+      return I - Keys.begin();
+    return Keys.size();
+  }
+
+  bool count(const KeyT &Key) const { return find(Key) != size(); }
+
+  /// lookup - Return the value for Key, or a default constructed value if it
+  /// is not present.
+  ValueT lookup(const KeyT &Key) const {
+    size_type i = find(Key);
+    return i == size() ? ValueT() : Values[i];
+  }
+};
+
+} // end namespace llvm
+
+#endif
@@ -755,9 +755,15 @@ hash_code hash_value(const std::pair<T, U> &arg) {
 
 // Declared and documented above, but defined here so that any of the hashing
 // infrastructure is available.
+//
+// Note that we hash via a pointer range rather than the string's iterators:
+// iterators of class type would select the buffering hash_combine_range_impl
+// overload and copy the string a character at a time, while a pointer range
+// is guaranteed to take the contiguous fast path.
 template <typename T>
 hash_code hash_value(const std::basic_string<T> &arg) {
-  return hash_combine_range(arg.begin(), arg.end());
+  const T *data = arg.data();
+  return hash_combine_range(data, data + arg.size());
 }
 
 } // namespace llvm
@@ -39,11 +39,15 @@ class SmallPtrSetIteratorImpl;
 /// sets are often small.  In this case, no memory allocation is used, and only
 /// light-weight and cache-efficient scanning is used.
 ///
-/// Large sets use a classic exponentially-probed hash table.  Empty buckets are
-/// represented with an illegal pointer value (-1) to allow null pointers to be
-/// inserted.  Tombstones are represented with another illegal pointer value
-/// (-2), to allow deletion.  The hash table is resized when the table is 3/4 or
-/// more.  When this happens, the table is doubled in size.
+/// Large sets use a robin-hood hash table: elements are probed linearly, and
+/// an insertion displaces any element that sits closer to its ideal bucket
+/// than the new element does, keeping probe sequences short and uniform even
+/// at mid-range sizes.  Lookups stop as soon as they see an element closer to
+/// its ideal bucket than the query would be, so missing elements are cheap
+/// too.  Deletion shifts the following chain back a bucket, so no tombstones
+/// are needed.  Empty buckets are represented with an illegal pointer value
+/// (-1) to allow null pointers to be inserted.  The hash table is resized when
+/// the table is 3/4 or more.  When this happens, the table is doubled in size.
 ///
 class SmallPtrSetImpl {
   friend class SmallPtrSetIteratorImpl;
@@ -60,7 +64,6 @@ protected:
 
   // If small, this is # elts allocated consecutively
   unsigned NumElements;
-  unsigned NumTombstones;
 
   // Helper to copy construct a SmallPtrSet.
   SmallPtrSetImpl(const void **SmallStorage, const SmallPtrSetImpl& that);
@@ -88,11 +91,9 @@ public:
     // Fill the array with empty markers.
     memset(CurArray, -1, CurArraySize*sizeof(void*));
     NumElements = 0;
-    NumTombstones = 0;
   }
 
 protected:
-  static void *getTombstoneMarker() { return reinterpret_cast<void*>(-2); }
   static void *getEmptyMarker() {
     // Note that -1 is chosen to make clear() efficiently implementable with
     // memset and because it's not a valid pointer value.
@@ -128,6 +129,11 @@ private:
   bool isSmall() const { return CurArray == SmallArray; }
 
   const void * const *FindBucketFor(const void *Ptr) const;
+
+  /// PlaceEntry - Insert a pointer known not to be in the set into the big
+  /// mode table, displacing richer elements as needed.
+  void PlaceEntry(const void *Ptr);
+
   void shrink_and_clear();
 
   /// Grow - Allocate a larger backing store for the buckets and move it over.
@@ -164,8 +170,7 @@ protected:
   /// that is.   This is guaranteed to stop because the end() bucket is marked
   /// valid.
   void AdvanceIfNotValid() {
-    while (*Bucket == SmallPtrSetImpl::getEmptyMarker() ||
-           *Bucket == SmallPtrSetImpl::getTombstoneMarker())
+    while (*Bucket == SmallPtrSetImpl::getEmptyMarker())
       ++Bucket;
   }
 };
@@ -41,6 +41,12 @@ protected:
   /// on POD-like data types and is out of line to reduce code duplication.
   void grow_pod(void *FirstEl, size_t MinSizeInBytes, size_t TSize);
 
+  /// record_grow - Count one heap growth event against the given call site.
+  /// Only called from builds instrumented with -DLLVM_SMALLVECTOR_STATS; the
+  /// per-site totals are dumped to stderr at exit so that chronically
+  /// undersized inline capacities can be found with a symbolizer.
+  static void record_grow(void *CallSite, size_t TSize);
+
 public:
   /// size_in_bytes - This returns size()*sizeof(T).
   size_t size_in_bytes() const {
@@ -267,9 +273,21 @@ template <typename T, bool isPodLike>
 void SmallVectorTemplateBase<T, isPodLike>::grow(size_t MinSize) {
   size_t CurCapacity = this->capacity();
   size_t CurSize = this->size();
-  size_t NewCapacity = 2*CurCapacity + 1; // Always grow, even from zero.
+  // Double while the buffer is small, then grow by 1.5x: a small vector wants
+  // to escape the reallocation regime quickly, while a large one is dominated
+  // by peak memory and copy cost.
+  size_t NewCapacity;
+  if (CurCapacity*sizeof(T) < 4096)
+    NewCapacity = 2*CurCapacity + 1; // Always grow, even from zero.
+  else
+    // CurCapacity/2 is zero for a capacity-1 vector of a huge T; make sure
+    // the capacity always actually grows.
+    NewCapacity = CurCapacity + (CurCapacity/2 ? CurCapacity/2 : 1);
   if (NewCapacity < MinSize)
     NewCapacity = MinSize;
+#ifdef LLVM_SMALLVECTOR_STATS
+  SmallVectorBase::record_grow(__builtin_return_address(0), sizeof(T));
+#endif
   T *NewElts = static_cast<T*>(malloc(NewCapacity*sizeof(T)));
 
   // Move the elements over.
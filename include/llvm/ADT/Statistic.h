@@ -27,6 +27,7 @@
 #define LLVM_ADT_STATISTIC_H
 
 #include "llvm/Support/Atomic.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/Valgrind.h"
 
 namespace llvm {
@@ -57,45 +58,46 @@ public:
   }
 
   const Statistic &operator++() {
-    // FIXME: This function and all those that follow carefully use an
-    // atomic operation to update the value safely in the presence of
-    // concurrent accesses, but not to read the return value, so the
-    // return value is not thread safe.
-    sys::AtomicIncrement(&Value);
+    // Note: the return value of these operators is Value, which is not
+    // updated until the per-thread shards are folded in, so the return
+    // value is neither thread safe nor exact while threads are running.
+    add(1);
     return init();
   }
 
   unsigned operator++(int) {
     init();
     unsigned OldValue = Value;
-    sys::AtomicIncrement(&Value);
+    add(1);
     return OldValue;
   }
 
   const Statistic &operator--() {
-    sys::AtomicDecrement(&Value);
+    add(-1);
     return init();
   }
 
   unsigned operator--(int) {
     init();
     unsigned OldValue = Value;
-    sys::AtomicDecrement(&Value);
+    add(-1);
     return OldValue;
   }
 
   const Statistic &operator+=(const unsigned &V) {
     if (!V) return *this;
-    sys::AtomicAdd(&Value, V);
+    add((int)V);
     return init();
   }
 
   const Statistic &operator-=(const unsigned &V) {
     if (!V) return *this;
-    sys::AtomicAdd(&Value, -V);
+    add(-(int)V);
     return init();
   }
 
+  // Multiplicative updates cannot be sharded; they are applied to the global
+  // value directly and remain atomic read-modify-write operations.
   const Statistic &operator*=(const unsigned &V) {
     sys::AtomicMul(&Value, V);
     return init();
@@ -107,6 +109,19 @@ public:
   }
 
 protected:
+  /// add - Add V to the statistic.  In single threaded mode this updates
+  /// Value directly.  Once threads have been started the update goes to a
+  /// per-thread shard instead, so concurrent increments from many threads do
+  /// not contend on one cache line; the shards are folded back into Value
+  /// when the statistics are printed.
+  void add(int V) {
+    if (!llvm_is_multithreaded())
+      Value += V;
+    else
+      addSharded(V);
+  }
+  void addSharded(int V);
+
   Statistic &init() {
     bool tmp = Initialized;
     sys::MemoryFence();
@@ -578,6 +578,37 @@ public:
     if (first != last) transfer(where, L2, first, last);
   }
 
+  /// splice_if - Transfer every node in [first, last) of L2 satisfying the
+  /// predicate to before 'where', preserving relative order.  Nodes are moved
+  /// in maximal contiguous runs, so a run of any length costs the same list
+  /// surgery (and a single transferNodesFromList callback) as a single node.
+  /// 'where' may not be one of the transferred nodes, and may not lie
+  /// strictly inside [first, last): runs would be spliced around it and the
+  /// relative order of the moved nodes lost.
+  template<class Pr1> void splice_if(iterator where, iplist &L2,
+                                     iterator first, iterator last, Pr1 pred) {
+    while (first != last) {
+      // Skip over nodes that are staying put.
+      while (first != last && !pred(*first))
+        ++first;
+      if (first == last)
+        break;
+
+      // Find the maximal contiguous run of nodes to move.
+      iterator RunEnd = first;
+      do
+        ++RunEnd;
+      while (RunEnd != last && pred(*RunEnd));
+
+      // The node at RunEnd is not moved, so the iterator stays valid in L2
+      // and resumes the scan after the transfer.  Moving a run to just
+      // before or just after itself is a noop.
+      if (where != first && where != RunEnd)
+        transfer(where, L2, first, RunEnd);
+      first = RunEnd;
+    }
+  }
+
 
 
   //===----------------------------------------------------------------------===
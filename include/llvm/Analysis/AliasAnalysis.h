@@ -552,6 +552,30 @@ public:
     copyValue(Old, New);
     deleteValue(Old);
   }
+
+  //===--------------------------------------------------------------------===//
+  /// Batched queries: clients that issue a large number of queries in a row
+  /// can bracket them with beginQueryBatch/endQueryBatch.  While a batch is
+  /// active, implementations are allowed to memoize query results, so the
+  /// client must announce every IR change through the methods above
+  /// (deleteValue, copyValue, replaceWithNewValue); values may only be
+  /// replaced by semantically equivalent values.  Batches may nest.
+  ///
+
+  /// beginQueryBatch - Start a window in which query results may be memoized.
+  virtual void beginQueryBatch();
+
+  /// endQueryBatch - End a window opened with beginQueryBatch, releasing any
+  /// memoized state.
+  virtual void endQueryBatch();
+
+  /// QueryBatch - An RAII object to bracket a batch of alias queries.
+  class QueryBatch {
+    AliasAnalysis &AA;
+  public:
+    explicit QueryBatch(AliasAnalysis &aa) : AA(aa) { AA.beginQueryBatch(); }
+    ~QueryBatch() { AA.endQueryBatch(); }
+  };
 };
 
 // Specialize DenseMapInfo for Location.
@@ -18,6 +18,7 @@
 #define LLVM_ANALYSIS_ALIASSETTRACKER_H
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/ilist.h"
 #include "llvm/ADT/ilist_node.h"
 #include "llvm/Support/CallSite.h"
@@ -113,6 +114,15 @@ class AliasSet : public ilist_node<AliasSet> {
   // All instructions without a specific address in this alias set.
   std::vector<AssertingVH<Instruction> > UnknownInsts;
 
+  /// The distinct identified memory objects (see isIdentifiedObject) that the
+  /// pointers in this set are based on.  Storage for two such objects is never
+  /// the same, so when every pointer in the set is based on an identified
+  /// object, a pointer based on a different identified object cannot alias
+  /// any member and the set can be skipped without querying alias analysis.
+  /// Entries may go stale when pointers are removed; that only costs
+  /// precision, never correctness.
+  SmallPtrSet<const Value *, 4> UnderlyingObjects;
+
   // RefCount - Number of nodes pointing to this AliasSet plus the number of
   // AliasSets forwarding to it.
   unsigned RefCount : 28;
@@ -139,6 +149,12 @@ class AliasSet : public ilist_node<AliasSet> {
   // Volatile - True if this alias set contains volatile loads or stores.
   bool Volatile : 1;
 
+  /// HasUnknownObject - True if some pointer in this set is based on a value
+  /// that is not a distinct identified object (a PHI, argument, or other
+  /// unknown pointer), in which case UnderlyingObjects is incomplete and
+  /// cannot be used to rule out aliasing.
+  bool HasUnknownObject : 1;
+
   void addRef() { ++RefCount; }
   void dropRef(AliasSetTracker &AST) {
     assert(RefCount >= 1 && "Invalid reference count detected!");
@@ -222,7 +238,8 @@ private:
   // to serve as a sentinel.
   friend struct ilist_sentinel_traits<AliasSet>;
   AliasSet() : PtrList(0), PtrListEnd(&PtrList), Forward(0), RefCount(0),
-               AccessTy(NoModRef), AliasTy(MustAlias), Volatile(false) {
+               AccessTy(NoModRef), AliasTy(MustAlias), Volatile(false),
+               HasUnknownObject(false) {
   }
 
   AliasSet(const AliasSet &AS) LLVM_DELETED_FUNCTION;
@@ -263,6 +280,18 @@ private:
   }
   void setVolatile() { Volatile = true; }
 
+  /// addUnderlyingObject - Record the underlying object of a pointer that is
+  /// being added to this set.
+  void addUnderlyingObject(const Value *Obj);
+
+  /// mayAliasObject - Return false if a pointer based on the identified
+  /// object Obj provably does not alias any member of this set.  This is a
+  /// cheap summary test; it never queries alias analysis.
+  bool mayAliasObject(const Value *Obj) const {
+    return HasUnknownObject || !UnknownInsts.empty() ||
+           UnderlyingObjects.count(Obj);
+  }
+
 public:
   /// aliasesPointer - Return true if the specified pointer "may" (or must)
   /// alias one of the members in the set.
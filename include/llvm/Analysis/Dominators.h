@@ -64,6 +64,7 @@ template <class NodeT>
 class DomTreeNodeBase {
   NodeT *TheBB;
   DomTreeNodeBase<NodeT> *IDom;
+  unsigned Level;
   std::vector<DomTreeNodeBase<NodeT> *> Children;
   int DFSNumIn, DFSNumOut;
 
@@ -81,12 +82,18 @@ public:
 
   NodeT *getBlock() const { return TheBB; }
   DomTreeNodeBase<NodeT> *getIDom() const { return IDom; }
+
+  /// getLevel - Return the distance of this node from the root of the tree.
+  /// The level is always exactly one more than the immediate dominator's.
+  unsigned getLevel() const { return Level; }
+
   const std::vector<DomTreeNodeBase<NodeT>*> &getChildren() const {
     return Children;
   }
 
   DomTreeNodeBase(NodeT *BB, DomTreeNodeBase<NodeT> *iDom)
-    : TheBB(BB), IDom(iDom), DFSNumIn(-1), DFSNumOut(-1) { }
+    : TheBB(BB), IDom(iDom), Level(iDom ? iDom->Level + 1 : 0),
+      DFSNumIn(-1), DFSNumOut(-1) { }
 
   DomTreeNodeBase<NodeT> *addChild(DomTreeNodeBase<NodeT> *C) {
     Children.push_back(C);
@@ -132,6 +139,8 @@ public:
       // Switch to new dominator
       IDom = NewIDom;
       IDom->Children.push_back(this);
+
+      UpdateLevel();
     }
   }
 
@@ -140,6 +149,23 @@ public:
   unsigned getDFSNumIn() const { return DFSNumIn; }
   unsigned getDFSNumOut() const { return DFSNumOut; }
 private:
+  /// UpdateLevel - Re-establish the level invariant for this node and any
+  /// descendants knocked out of place by an immediate dominator change.
+  void UpdateLevel() {
+    if (Level == IDom->Level + 1)
+      return;
+
+    SmallVector<DomTreeNodeBase<NodeT> *, 64> WorkStack(1, this);
+    while (!WorkStack.empty()) {
+      DomTreeNodeBase<NodeT> *Current = WorkStack.pop_back_val();
+      Current->Level = Current->IDom->Level + 1;
+
+      for (iterator I = Current->begin(), E = Current->end(); I != E; ++I)
+        if ((*I)->Level != Current->Level + 1)
+          WorkStack.push_back(*I);
+    }
+  }
+
   // Return true if this node is dominated by other. Use this only if DFS info
   // is valid.
   bool DominatedBy(const DomTreeNodeBase<NodeT> *other) const {
@@ -191,10 +217,13 @@ class DominatorTreeBase : public DominatorBase<NodeT> {
     assert(isReachableFromEntry(B));
     assert(isReachableFromEntry(A));
 
-    const DomTreeNodeBase<NodeT> *IDom;
-    while ((IDom = B->getIDom()) != 0 && IDom != A && IDom != B)
-      B = IDom;   // Walk up the tree
-    return IDom != 0;
+    // Every step up the tree decreases the level by exactly one, so B has a
+    // unique ancestor at A's level and A dominates B iff that ancestor is A.
+    // This bounds the walk by the level difference instead of B's depth.
+    const unsigned ALevel = A->getLevel();
+    while (B->getLevel() > ALevel)
+      B = B->getIDom();   // Walk up the tree
+    return B == A;
   }
 
 protected:
@@ -857,6 +886,19 @@ public:
     DT->splitBlock(NewBB);
   }
 
+  /// insertEdge - Update dominator tree information to reflect the insertion
+  /// of the CFG edge From -> To.  Must be called *after* the edge has been
+  /// added to the CFG.  The common cases are patched in place; when a local
+  /// update is not possible the tree is recomputed, so the tree is always
+  /// correct on return.
+  void insertEdge(BasicBlock *From, BasicBlock *To);
+
+  /// deleteEdge - Update dominator tree information to reflect the removal
+  /// of the CFG edge From -> To.  Must be called *after* the edge has been
+  /// removed from the CFG.  Like insertEdge, this patches the tree when it
+  /// can and falls back to recomputing it otherwise.
+  void deleteEdge(BasicBlock *From, BasicBlock *To);
+
   bool isReachableFromEntry(const BasicBlock* A) const {
     return DT->isReachableFromEntry(A);
   }
@@ -72,12 +72,15 @@ class LoopBase {
   // Blocks - The list of blocks in this loop.  First entry is the header node.
   std::vector<BlockT*> Blocks;
 
+  // IsAnalysisClean - See isAnalysisClean().
+  bool IsAnalysisClean;
+
   LoopBase(const LoopBase<BlockT, LoopT> &) LLVM_DELETED_FUNCTION;
   const LoopBase<BlockT, LoopT>&
     operator=(const LoopBase<BlockT, LoopT> &) LLVM_DELETED_FUNCTION;
 public:
   /// Loop ctor - This creates an empty loop.
-  LoopBase() : ParentLoop(0) {}
+  LoopBase() : ParentLoop(0), IsAnalysisClean(false) {}
   ~LoopBase() {
     for (size_t i = 0, e = SubLoops.size(); i != e; ++i)
       delete SubLoops[i];
@@ -255,6 +258,7 @@ public:
     assert(NewChild->ParentLoop == 0 && "NewChild already has a parent!");
     NewChild->ParentLoop = static_cast<LoopT *>(this);
     SubLoops.push_back(NewChild);
+    NewChild->markAnalysisDirty();
   }
 
   /// removeChildLoop - This removes the specified child from being a subloop of
@@ -266,6 +270,8 @@ public:
     assert(Child->ParentLoop == this && "Child is not a child of this loop!");
     SubLoops.erase(SubLoops.begin()+(I-begin()));
     Child->ParentLoop = 0;
+    markAnalysisDirty();
+    Child->IsAnalysisClean = false;
     return Child;
   }
 
@@ -274,6 +280,7 @@ public:
   /// transformations should use addBasicBlockToLoop.
   void addBlockEntry(BlockT *BB) {
     Blocks.push_back(BB);
+    markAnalysisDirty();
   }
 
   /// moveToHeader - This method is used to move BB (which must be part of this
@@ -281,6 +288,7 @@ public:
   /// others).
   void moveToHeader(BlockT *BB) {
     if (Blocks[0] == BB) return;
+    markAnalysisDirty();
     for (unsigned i = 0; ; ++i) {
       assert(i != Blocks.size() && "Loop does not contain BB!");
       if (Blocks[i] == BB) {
@@ -296,6 +304,25 @@ public:
   /// the mapping in the LoopInfo class.
   void removeBlockFromLoop(BlockT *BB) {
     RemoveFromVector(Blocks, BB);
+    markAnalysisDirty();
+  }
+
+  /// isAnalysisClean - Return true if no structural mutation has touched
+  /// this loop (or a loop nested inside it) since the bit was last set.
+  /// LoopSimplify sets the bit once it has put a loop into canonical form
+  /// and uses it to re-examine only the dirty subtrees of the forest on
+  /// later runs; every mutator on this class clears the bit on the whole
+  /// ancestor chain.  A freshly discovered loop starts out dirty.
+  bool isAnalysisClean() const { return IsAnalysisClean; }
+
+  /// setAnalysisClean - Record that this loop has been (re)verified.
+  void setAnalysisClean() { IsAnalysisClean = true; }
+
+  /// markAnalysisDirty - Tag this loop and all of its ancestors as
+  /// structurally modified.
+  void markAnalysisDirty() {
+    for (LoopBase<BlockT, LoopT> *L = this; L; L = L->ParentLoop)
+      L->IsAnalysisClean = false;
   }
 
   /// verifyLoop - Verify loop structure
@@ -308,7 +335,7 @@ public:
 
 protected:
   friend class LoopInfoBase<BlockT, LoopT>;
-  explicit LoopBase(BlockT *BB) : ParentLoop(0) {
+  explicit LoopBase(BlockT *BB) : ParentLoop(0), IsAnalysisClean(false) {
     Blocks.push_back(BB);
   }
 };
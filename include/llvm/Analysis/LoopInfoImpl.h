@@ -229,6 +229,8 @@ replaceChildLoopWith(LoopT *OldChild, LoopT *NewChild) {
   *I = NewChild;
   OldChild->ParentLoop = 0;
   NewChild->ParentLoop = static_cast<LoopT *>(this);
+  OldChild->markAnalysisDirty();
+  NewChild->markAnalysisDirty();
 }
 
 /// verifyLoop - Verify loop structure
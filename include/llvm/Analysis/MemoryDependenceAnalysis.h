@@ -320,7 +320,13 @@ namespace llvm {
     
     // A reverse mapping from dependencies to the non-local dependees.
     ReverseDepMapType ReverseNonLocalDeps;
-    
+
+    /// BlockAccessesMemory - Lazily computed per-block summaries saying
+    /// whether a block contains any instruction a pointer dependency scan
+    /// could report as a dependency.  Blocks without one are skipped by the
+    /// non-local walk without scanning their instructions.
+    DenseMap<const BasicBlock*, bool> BlockAccessesMemory;
+
     /// Current AA implementation, just a cache.
     AliasAnalysis *AA;
     DataLayout *TD;
@@ -430,7 +436,9 @@ namespace llvm {
                                          unsigned NumSortedEntries);
 
     void RemoveCachedNonLocalPointerDependencies(ValueIsLoadPair P);
-    
+
+    bool blockAccessesMemory(const BasicBlock *BB);
+
     /// verifyRemoved - Verify that the specified instruction does not occur
     /// in our internal data structures.
     void verifyRemoved(Instruction *Inst) const;
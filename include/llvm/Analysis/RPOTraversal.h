@@ -0,0 +1,68 @@
+//===- llvm/Analysis/RPOTraversal.h - Cached RPO/PO orders ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file exposes a cached block-ordering analysis.  Many passes start by
+// walking the function in reverse post-order, each allocating its own
+// visited set and order vector; this analysis computes the post-order once
+// per function and hands out both orders, staying valid across any pass
+// that preserves the CFG.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_RPOTRAVERSAL_H
+#define LLVM_ANALYSIS_RPOTRAVERSAL_H
+
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Pass.h"
+#include <vector>
+
+namespace llvm {
+
+class BasicBlock;
+
+/// RPOTraversal - An analysis that caches the post-order (and therefore
+/// reverse post-order) of a function's blocks.  The visited-set and order
+/// storage persist across functions, so repeated runs allocate nothing.
+class RPOTraversal : public FunctionPass {
+  std::vector<BasicBlock*> PO;       // Blocks in post-order.
+  SmallPtrSet<BasicBlock*, 64> Visited; // Pooled traversal scratch.
+public:
+  static char ID; // Pass identification, replacement for typeid
+
+  RPOTraversal();
+
+  virtual bool runOnFunction(Function &F);
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    AU.setPreservesAll();
+  }
+
+  virtual void releaseMemory();
+
+  typedef std::vector<BasicBlock*>::const_iterator po_iterator;
+  typedef std::vector<BasicBlock*>::const_reverse_iterator rpo_iterator;
+
+  /// Iterate the cached order; rpo iterators yield the entry block first.
+  po_iterator po_begin() const { return PO.begin(); }
+  po_iterator po_end() const { return PO.end(); }
+  rpo_iterator rpo_begin() const { return PO.rbegin(); }
+  rpo_iterator rpo_end() const { return PO.rend(); }
+
+  unsigned size() const { return PO.size(); }
+
+  /// recompute - Recompute the order after an in-pass CFG mutation.  Passes
+  /// that change the CFG and keep using the analysis within the same run
+  /// must call this themselves; across passes the pass manager invalidates
+  /// the analysis for them.
+  void recompute(Function &F);
+};
+
+} // End llvm namespace
+
+#endif
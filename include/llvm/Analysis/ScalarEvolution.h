@@ -399,6 +399,13 @@ namespace llvm {
       return Pair.first->second;
     }
 
+    /// getExistingSCEV - Return the uniqued expression of kind \p SCEVType
+    /// with exactly the operand list \p Ops if one has already been created,
+    /// or null. The expression factories use this to recognize operand lists
+    /// that are already in canonical form and skip refolding them.
+    const SCEV *getExistingSCEV(unsigned SCEVType,
+                                const SmallVectorImpl<const SCEV *> &Ops);
+
     /// createSCEV - We know that there is no SCEV for the specified value.
     /// Analyze the expression.
     const SCEV *createSCEV(Value *V);
@@ -793,12 +800,17 @@ namespace llvm {
     uint32_t GetMinTrailingZeros(const SCEV *S);
 
     /// getUnsignedRange - Determine the unsigned range for a particular SCEV.
+    /// The returned reference points into the memoization cache and is only
+    /// valid until the next range query, which may grow the cache; copy the
+    /// range if it needs to outlive that.
     ///
-    ConstantRange getUnsignedRange(const SCEV *S);
+    const ConstantRange &getUnsignedRange(const SCEV *S);
 
     /// getSignedRange - Determine the signed range for a particular SCEV.
+    /// The returned reference has the same lifetime caveat as the one
+    /// returned by getUnsignedRange.
     ///
-    ConstantRange getSignedRange(const SCEV *S);
+    const ConstantRange &getSignedRange(const SCEV *S);
 
     /// isKnownNegative - Test if the given expression is known to be negative.
     ///
@@ -17,6 +17,7 @@
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Support/Allocator.h"
 #include <set>
 #include <vector>
 
@@ -29,6 +30,8 @@ namespace llvm {
   class TerminatorInst;
   class BasicBlock;
   class Function;
+  class Module;
+  class CallGraph;
   class SparseSolver;
   class raw_ostream;
 
@@ -118,7 +121,11 @@ class SparseSolver {
   /// LatticeFunc - This is the object that knows the lattice and how to do
   /// compute transfer functions.
   AbstractLatticeFunction *LatticeFunc;
-  
+
+  /// OwnsLatticeFunc - Whether the solver should delete LatticeFunc.  Drivers
+  /// that run many solvers over one lattice function pass false.
+  bool OwnsLatticeFunc;
+
   DenseMap<Value*, LatticeVal> ValueState;  // The state each value is in.
   SmallPtrSet<BasicBlock*, 16> BBExecutable;   // The bbs that are executable.
   
@@ -134,10 +141,12 @@ class SparseSolver {
   SparseSolver(const SparseSolver&) LLVM_DELETED_FUNCTION;
   void operator=(const SparseSolver&) LLVM_DELETED_FUNCTION;
 public:
-  explicit SparseSolver(AbstractLatticeFunction *Lattice)
-    : LatticeFunc(Lattice) {}
+  explicit SparseSolver(AbstractLatticeFunction *Lattice,
+                        bool OwnsLattice = true)
+    : LatticeFunc(Lattice), OwnsLatticeFunc(OwnsLattice) {}
   ~SparseSolver() {
-    delete LatticeFunc;
+    if (OwnsLatticeFunc)
+      delete LatticeFunc;
   }
   
   /// Solve - Solve for constants and executable blocks.
@@ -161,7 +170,14 @@ public:
   /// constants should be marked as constants.
   ///
   LatticeVal getOrInitValueState(Value *V);
-  
+
+  /// setLatticeState - Seed the state of a value before solving.  This is how
+  /// interprocedural drivers inject boundary conditions, such as argument
+  /// states merged over call edges, into a function-local solve.
+  void setLatticeState(Value *V, LatticeVal LV) {
+    ValueState[V] = LV;
+  }
+
   /// isEdgeFeasible - Return true if the control flow edge from the 'From'
   /// basic block to the 'To' basic block is currently feasible.  If
   /// AggressiveUndef is true, then this treats values with unknown lattice
@@ -201,6 +217,98 @@ private:
 
 };
 
+/// InterproceduralSparseSolver - Drives SparseSolver over a whole module.
+///
+/// Functions are solved one at a time in bottom-up call graph SCC order, and
+/// only the lattice state that crosses a function boundary is retained: the
+/// formal argument states merged over the discovered call edges and the merge
+/// of every value the function can return.  The per-value maps therefore
+/// never cover more than one function at a time.  When a later solve lowers
+/// the boundary summary of a function that has already been solved, that
+/// function and its known callers are re-queued, so the result is a true
+/// module-wide fixed point; termination follows from the same finite-descent
+/// assumption SparseSolver already makes about MergeValues.
+///
+/// Clients consult getReturnState from their call-site transfer function and
+/// getArgumentState from ComputeArgument, falling back to their conservative
+/// defaults whenever untracked is returned.
+class InterproceduralSparseSolver {
+public:
+  typedef AbstractLatticeFunction::LatticeVal LatticeVal;
+
+private:
+  /// FunctionSummary - The lattice state visible across a function boundary.
+  struct FunctionSummary {
+    /// Args - Formal argument states merged over the call edges seen so far,
+    /// allocated from SummaryAlloc.  Only trusted for functions whose callers
+    /// are all visible (internal and not address taken).
+    LatticeVal *Args;
+    unsigned NumArgs;
+
+    /// Ret - The merge of every value the function can return.
+    LatticeVal Ret;
+
+    /// Callers - Functions containing a discovered call edge to this one,
+    /// re-queued when Ret changes.
+    SmallPtrSet<Function*, 4> Callers;
+
+    bool Initialized;
+
+    /// Seedable - True if every caller of the function is visible, making it
+    /// sound to seed its formal arguments from Args.
+    bool Seedable;
+
+    FunctionSummary()
+      : Args(0), NumArgs(0), Ret(0), Initialized(false), Seedable(false) {}
+  };
+
+  /// LatticeFunc - The client lattice, shared by every per-function solve.
+  AbstractLatticeFunction *LatticeFunc;
+
+  DenseMap<Function*, FunctionSummary> Summaries;
+
+  /// SummaryAlloc - Slab storage for the argument arrays in Summaries.
+  BumpPtrAllocator SummaryAlloc;
+
+  /// Order - The functions left to solve; re-queued functions are appended.
+  std::vector<Function*> Order;
+  SmallPtrSet<Function*, 16> InQueue;
+
+  InterproceduralSparseSolver(const InterproceduralSparseSolver&)
+    LLVM_DELETED_FUNCTION;
+  void operator=(const InterproceduralSparseSolver&) LLVM_DELETED_FUNCTION;
+public:
+  explicit InterproceduralSparseSolver(AbstractLatticeFunction *Lattice)
+    : LatticeFunc(Lattice) {}
+  ~InterproceduralSparseSolver() {
+    delete LatticeFunc;
+  }
+
+  /// Solve - Solve every function in the module to a global fixed point.
+  void Solve(Module &M, CallGraph &CG);
+
+  /// getReturnState - Return the merge of every value the function can
+  /// return, or untracked if the function has not been solved (external
+  /// declarations, or queries made before its first solve).
+  LatticeVal getReturnState(Function *F) const;
+
+  /// getArgumentState - Return the state of a formal argument as merged over
+  /// all call edges, or untracked if the function's callers are not all
+  /// visible.
+  LatticeVal getArgumentState(Argument *A) const;
+
+private:
+  FunctionSummary &getSummary(Function *F);
+
+  /// requeue - Schedule a function to be (re)solved.
+  void requeue(Function *F) {
+    if (InQueue.insert(F))
+      Order.push_back(F);
+  }
+
+  void SolveFunction(Function &F);
+};
+
 } // end namespace llvm
 
 #endif // LLVM_ANALYSIS_SPARSEPROPAGATION_H
@@ -31,6 +31,8 @@
 
 namespace llvm {
 
+class Instruction;
+
 /// TargetTransformInfo - This pass provides access to the codegen
 /// interfaces that are needed for IR-level transformations.
 class TargetTransformInfo {
@@ -169,6 +171,14 @@ public:
   /// comments for a detailed explanation of the cost values.
   virtual unsigned getUserCost(const User *U) const;
 
+  /// \brief Estimate the throughput cost of a formed instruction.
+  ///
+  /// This dispatches on the instruction's opcode to the dedicated per-kind
+  /// cost interfaces below, so clients holding only IR see the same cost the
+  /// vectorizers compute for it.  Returns -1 if the cost is unknown.  Not
+  /// virtual; implemented entirely in terms of the per-kind queries.
+  unsigned getInstructionCost(const Instruction *I) const;
+
   /// \brief Test whether calls to a function lower to actual program function
   /// calls.
   ///
@@ -274,6 +284,14 @@ public:
   /// and the number of execution units in the CPU.
   virtual unsigned getMaximumUnrollFactor() const;
 
+  /// \return How many bytes ahead of a strided access software prefetches
+  /// should be issued, or zero if prefetch insertion does not pay off on
+  /// this target.
+  virtual unsigned getPrefetchDistance() const;
+
+  /// \return The size of a cache line in bytes.
+  virtual unsigned getCacheLineSize() const;
+
   /// \return The expected cost of arithmetic ops, such as mul, xor, fsub, etc.
   virtual unsigned getArithmeticInstrCost(unsigned Opcode, Type *Ty) const;
 
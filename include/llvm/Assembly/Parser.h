@@ -14,6 +14,8 @@
 #ifndef LLVM_ASSEMBLY_PARSER_H
 #define LLVM_ASSEMBLY_PARSER_H
 
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Compiler.h"
 #include <string>
 
 namespace llvm {
@@ -59,6 +61,39 @@ Module *ParseAssembly(
     LLVMContext &Context
 );
 
+/// Parses LLVM assembly fed to it in multiple chunks, materializing each
+/// chunk's types, globals and functions into the module as the chunk is
+/// parsed.  Parser state persists across chunks, so later chunks may refer to
+/// entities from earlier ones without the client re-feeding the accumulated
+/// text.  Each chunk must end on a top-level entity boundary; forward
+/// references may span chunks and are checked by Finish(), which must be
+/// called after the last chunk and before the module is used.  As with the
+/// one-shot entry points above, the module is not verified.
+/// @brief Parse LLVM Assembly incrementally into a module.
+class IncrementalAssemblyParser {
+  void *Impl;  ///< Opaque parser state, owned, defined in lib/AsmParser.
+
+  IncrementalAssemblyParser(const IncrementalAssemblyParser&)
+    LLVM_DELETED_FUNCTION;
+  IncrementalAssemblyParser &operator=(const IncrementalAssemblyParser&)
+    LLVM_DELETED_FUNCTION;
+public:
+  /// Chunks are materialized into M, which must outlive the parser; errors
+  /// are reported through Err, which must too.
+  IncrementalAssemblyParser(Module *M, SMDiagnostic &Err);
+  ~IncrementalAssemblyParser();
+
+  /// ParseChunk - Parse one chunk of assembly into the module.  The text is
+  /// copied, so the caller's buffer need not outlive the call.  Returns true
+  /// on error with the diagnostic in the constructor's SMDiagnostic; the
+  /// parser must not be used further after an error.
+  bool ParseChunk(StringRef Chunk, StringRef Name = "<chunk>");
+
+  /// Finish - Check that no forward references remain unresolved and run the
+  /// end-of-module fixups.  Returns true on error.
+  bool Finish();
+};
+
 } // End llvm namespace
 
 #endif
@@ -474,21 +474,11 @@ class Archive {
     /// @brief Load just the symbol table.
     bool loadSymbolTable(std::string* ErrMessage);
 
-    /// @brief Write the symbol table to an ofstream.
-    void writeSymbolTable(std::ofstream& ARFile);
-
-    /// Writes one ArchiveMember to an ofstream. If an error occurs, returns
-    /// false, otherwise true. If an error occurs and error is non-null then
-    /// it will be set to an error message.
-    /// @returns false if writing member succeeded,
-    /// returns true if writing member failed, \p error set to error message.
-    bool writeMember(
-      const ArchiveMember& member, ///< The member to be written
-      std::ofstream& ARFile,       ///< The file to write member onto
-      bool CreateSymbolTable,      ///< Should symbol table be created?
-      bool TruncateNames,          ///< Should names be truncated to 11 chars?
-      std::string* ErrMessage      ///< If non-null, place were error msg is set
-    );
+    /// Writes the symbol table as an archive member at \p Out, which must
+    /// have room for its pre-computed size.
+    /// @returns the output cursor advanced past the symbol table member.
+    /// @brief Write the symbol table into an output buffer.
+    char *writeSymbolTable(char *Out);
 
     /// @brief Fill in an ArchiveMemberHeader from ArchiveMember.
     bool fillHeader(const ArchiveMember&mbr,
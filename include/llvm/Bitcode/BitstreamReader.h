@@ -46,6 +46,13 @@ public:
 private:
   OwningPtr<StreamableMemoryObject> BitcodeBytes;
 
+  /// RawStart/RawEnd - When the entire stream is a contiguous in-memory
+  /// buffer (e.g. an mmap'ed file), these delimit it and the cursors read
+  /// words directly from it.  Null for truly streamed inputs, which go
+  /// through the StreamableMemoryObject interface instead.
+  const unsigned char *RawStart;
+  const unsigned char *RawEnd;
+
   std::vector<BlockInfo> BlockInfoRecords;
 
   /// IgnoreBlockInfoNames - This is set to true if we don't care about the
@@ -56,25 +63,33 @@ private:
   BitstreamReader(const BitstreamReader&) LLVM_DELETED_FUNCTION;
   void operator=(const BitstreamReader&) LLVM_DELETED_FUNCTION;
 public:
-  BitstreamReader() : IgnoreBlockInfoNames(true) {
+  BitstreamReader() : RawStart(0), RawEnd(0), IgnoreBlockInfoNames(true) {
   }
 
-  BitstreamReader(const unsigned char *Start, const unsigned char *End) {
+  BitstreamReader(const unsigned char *Start, const unsigned char *End)
+      : RawStart(0), RawEnd(0) {
     IgnoreBlockInfoNames = true;
     init(Start, End);
   }
 
-  BitstreamReader(StreamableMemoryObject *bytes) {
+  BitstreamReader(StreamableMemoryObject *bytes) : RawStart(0), RawEnd(0) {
     BitcodeBytes.reset(bytes);
   }
 
   void init(const unsigned char *Start, const unsigned char *End) {
     assert(((End-Start) & 3) == 0 &&"Bitcode stream not a multiple of 4 bytes");
     BitcodeBytes.reset(getNonStreamedMemoryObject(Start, End));
+    RawStart = Start;
+    RawEnd = End;
   }
 
   StreamableMemoryObject &getBitcodeBytes() { return *BitcodeBytes; }
 
+  /// getRawStart/getRawEnd - Direct access to the underlying buffer for the
+  /// zero-copy read path; getRawStart() is null for streamed inputs.
+  const unsigned char *getRawStart() const { return RawStart; }
+  const unsigned char *getRawEnd() const { return RawEnd; }
+
   ~BitstreamReader() {
     // Free the BlockInfoRecords.
     while (!BlockInfoRecords.empty()) {
@@ -124,6 +139,13 @@ public:
     BlockInfoRecords.back().BlockID = BlockID;
     return BlockInfoRecords.back();
   }
+
+  /// getBlockInfoRecords - Direct access to all of the parsed blockinfo
+  /// records, used by the cross-module abbreviation cache in
+  /// ReadBlockInfoBlock.
+  const std::vector<BlockInfo> &getBlockInfoRecords() const {
+    return BlockInfoRecords;
+  }
 };
 
   
@@ -228,16 +250,30 @@ public:
   void freeState();
   
   bool isEndPos(size_t pos) {
+    // Fast path: the entire stream is a contiguous in-memory buffer.
+    if (const unsigned char *Start = BitStream->getRawStart())
+      return Start + pos == BitStream->getRawEnd();
     return BitStream->getBitcodeBytes().isObjectEnd(static_cast<uint64_t>(pos));
   }
 
   bool canSkipToPos(size_t pos) const {
+    if (const unsigned char *Start = BitStream->getRawStart())
+      return pos <= size_t(BitStream->getRawEnd() - Start);
     // pos can be skipped to if it is a valid address or one byte past the end.
     return pos == 0 || BitStream->getBitcodeBytes().isValidAddress(
         static_cast<uint64_t>(pos - 1));
   }
 
   uint32_t getWord(size_t pos) {
+    // Fast path: read the word straight out of the buffer with a single end
+    // check, avoiding the per-read copy and bounds logic of the memory
+    // object interface.  The stream is a multiple of 4 bytes, so a word read
+    // at any valid position is fully in bounds.
+    if (const unsigned char *Start = BitStream->getRawStart()) {
+      const unsigned char *P = Start + pos;
+      if (P + 4 <= BitStream->getRawEnd())
+        return *reinterpret_cast<const support::ulittle32_t *>(P);
+    }
     uint8_t buf[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
     BitStream->getBitcodeBytes().readBytes(pos, sizeof(buf), buf, NULL);
     return *reinterpret_cast<support::ulittle32_t *>(buf);
@@ -114,6 +114,25 @@ public:
   /// \brief Retrieve the current position in the stream, in bits.
   uint64_t GetCurrentBitNo() const { return GetBufferOffset() * 8 + CurBit; }
 
+  /// \brief Backpatch a 32-bit field in the output at the specified bit
+  /// offset, which need not be byte aligned.  The field must already have
+  /// been flushed to the buffer.
+  void BackpatchWordAtBit(uint64_t BitNo, uint32_t NewWord) {
+    size_t ByteNo = size_t(BitNo / 8);
+    unsigned BitOff = unsigned(BitNo & 7);
+    assert(ByteNo + 4 + (BitOff != 0) <= Out.size() &&
+           "Backpatch target not yet flushed");
+    uint64_t Val = uint64_t(NewWord) << BitOff;
+    uint64_t Mask = uint64_t(0xFFFFFFFFULL) << BitOff;
+    for (unsigned i = 0; i != 5; ++i) {
+      unsigned char ByteMask = (unsigned char)(Mask >> (8*i));
+      if (!ByteMask)
+        continue;
+      Out[ByteNo+i] = (char)((Out[ByteNo+i] & ~ByteMask) |
+                             ((unsigned char)(Val >> (8*i)) & ByteMask));
+    }
+  }
+
   //===--------------------------------------------------------------------===//
   // Basic Primitives for emitting bits to the stream.
   //===--------------------------------------------------------------------===//
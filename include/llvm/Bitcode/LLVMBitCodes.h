@@ -43,7 +43,11 @@ namespace bitc {
 
     TYPE_BLOCK_ID_NEW,
 
-    USELIST_BLOCK_ID
+    USELIST_BLOCK_ID,
+
+    FUNCTION_INDEX_BLOCK_ID,
+
+    FUNCTION_SUMMARY_BLOCK_ID
   };
 
 
@@ -72,7 +76,30 @@ namespace bitc {
     /// MODULE_CODE_PURGEVALS: [numvals]
     MODULE_CODE_PURGEVALS   = 10,
 
-    MODULE_CODE_GCNAME      = 11   // GCNAME: [strchr x N]
+    MODULE_CODE_GCNAME      = 11,  // GCNAME: [strchr x N]
+
+    /// MODULE_CODE_FNINDEXOFFSET: [offset]
+    /// Bit offset of the function index block, backpatched by the writer once
+    /// the function bodies have been emitted.  Zero when no index is present
+    /// (e.g. the offset did not fit in the fixed 32-bit field).
+    MODULE_CODE_FNINDEXOFFSET = 12
+  };
+
+  /// The function index block (FUNCTION_INDEX_BLOCK_ID) maps functions to the
+  /// bit offsets of their bodies, so lazy readers can seek directly to a
+  /// deferred body instead of scanning the stream.
+  enum FunctionIndexCodes {
+    // ENTRY: [function#, bit offset of the function block]
+    FNINDEX_CODE_ENTRY = 1
+  };
+
+  /// The function summary block (FUNCTION_SUMMARY_BLOCK_ID) describes each
+  /// function defined in the module without requiring its body to be read.
+  /// A thin link uses the summaries to decide which bodies are worth
+  /// importing across module boundaries.
+  enum FunctionSummaryCodes {
+    // ENTRY: [instcount, callcount, strchr x N]  (N = function name length)
+    FNSUMMARY_CODE_ENTRY = 1
   };
 
   /// PARAMATTR blocks have code for defining a parameter attribute set.
@@ -14,6 +14,8 @@
 #ifndef LLVM_BITCODE_READERWRITER_H
 #define LLVM_BITCODE_READERWRITER_H
 
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/DataTypes.h"
 #include <string>
 
 namespace llvm {
@@ -52,6 +54,23 @@ namespace llvm {
                                      LLVMContext &Context,
                                      std::string *ErrMsg = 0);
 
+  /// FunctionSummary - Per-function information recorded in the bitcode
+  /// function summary block.  A thin link uses these to decide which bodies
+  /// to import without materializing them.
+  struct FunctionSummary {
+    uint64_t NumInsts;     ///< Number of instructions in the body.
+    uint64_t NumCallSites; ///< Number of call and invoke sites in the body.
+  };
+
+  /// getBitcodeFunctionSummaries - Read the function summary block of the
+  /// specified bitcode buffer, if present, filling in a map from function
+  /// name to summary.  A module without a summary block simply leaves the
+  /// map empty.  This *does not* take ownership of 'buffer'.  On error, this
+  /// returns true and fills in *ErrMsg if it is non-null.
+  bool getBitcodeFunctionSummaries(MemoryBuffer *Buffer, LLVMContext &Context,
+                                   StringMap<FunctionSummary> &Summaries,
+                                   std::string *ErrMsg = 0);
+
   /// ParseBitcodeFile - Read the specified bitcode file, returning the module.
   /// If an error occurs, this returns null and fills in *ErrMsg if it is
   /// non-null.  This method *never* takes ownership of Buffer.
@@ -63,6 +82,15 @@ namespace llvm {
   /// should be in "binary" mode.
   void WriteBitcodeToFile(const Module *M, raw_ostream &Out);
 
+  /// WriteCompressedBitcodeToFile - Write the specified module to the
+  /// specified raw output stream inside the compressed container described
+  /// at isCompressedBitcodeWrapper.  Chunks are compressed independently so
+  /// readers can decompress them lazily; ChunkSize selects the uncompressed
+  /// chunk granularity (0 selects a reasonable default).  Chunks that do not
+  /// shrink are stored raw.
+  void WriteCompressedBitcodeToFile(const Module *M, raw_ostream &Out,
+                                    unsigned ChunkSize = 0);
+
   /// createBitcodeWriterPass - Create and return a pass that writes the module
   /// to the specified ostream.
   ModulePass *createBitcodeWriterPass(raw_ostream &Str);
@@ -96,13 +124,44 @@ namespace llvm {
            BufPtr[3] == 0xde;
   }
 
+  /// isCompressedBitcodeWrapper - Return true if the given bytes are the
+  /// magic bytes for the compressed bitcode container produced by
+  /// WriteCompressedBitcodeToFile.  The container format is:
+  ///
+  /// struct compressed_bc_header {
+  ///   uint32_t Magic;      // 0x0B17C0DF
+  ///   uint32_t Version;    // Version, currently always 0.
+  ///   uint32_t ChunkSize;  // Uncompressed bytes per chunk.
+  ///   uint32_t NumChunks;  // Number of chunks that follow.
+  ///   struct {
+  ///     uint32_t CompressedSize;   // Payload bytes of this chunk.
+  ///     uint32_t UncompressedSize; // Chunk size after decompression; equal
+  ///                                // to CompressedSize if stored raw.
+  ///   } Index[NumChunks];
+  ///   ... chunk payloads, back to back ...
+  /// };
+  ///
+  /// All fields are little-endian.  The concatenated decompressed chunks
+  /// form an ordinary bitcode file (possibly itself wrapped); because the
+  /// index is uncompressed, readers can materialize lazily and decompress
+  /// only the chunks they actually touch.
+  inline bool isCompressedBitcodeWrapper(const unsigned char *BufPtr,
+                                         const unsigned char *BufEnd) {
+    return BufEnd-BufPtr >= 4 &&
+           BufPtr[0] == 0xDF &&
+           BufPtr[1] == 0xC0 &&
+           BufPtr[2] == 0x17 &&
+           BufPtr[3] == 0x0B;
+  }
+
   /// isBitcode - Return true if the given bytes are the magic bytes for
   /// LLVM IR bitcode, either with or without a wrapper.
   ///
   inline bool isBitcode(const unsigned char *BufPtr,
                         const unsigned char *BufEnd) {
     return isBitcodeWrapper(BufPtr, BufEnd) ||
-           isRawBitcode(BufPtr, BufEnd);
+           isRawBitcode(BufPtr, BufEnd) ||
+           isCompressedBitcodeWrapper(BufPtr, BufEnd);
   }
 
   /// SkipBitcodeWrapperHeader - Some systems wrap bc files with a special
@@ -0,0 +1,71 @@
+//===- llvm/CodeGen/LazyLiveness.h - On-demand liveness queries -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// LazyLiveness answers live-in/live-out queries for virtual registers
+// without running the whole-function LiveVariables dataflow. The liveness
+// of a register is computed from its MachineRegisterInfo use and def chains
+// the first time that register is queried, and cached afterwards. This pays
+// off in passes that only query a handful of registers on large functions.
+//
+// The queries follow the LiveVariables conventions: a value read only by a
+// PHI node is not considered live-out of the corresponding predecessor.
+// Unlike LiveVariables, no kill or dead flags are computed, so this cannot
+// substitute for LiveVariables in consumers that read those.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_LAZYLIVENESS_H
+#define LLVM_CODEGEN_LAZYLIVENESS_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SparseBitVector.h"
+
+namespace llvm {
+
+class MachineBasicBlock;
+class MachineFunction;
+class MachineRegisterInfo;
+
+class LazyLiveness {
+public:
+  explicit LazyLiveness(MachineFunction &mf);
+  ~LazyLiveness();
+
+  /// isLiveIn - Return true if Reg is live at the entry of MBB.
+  bool isLiveIn(unsigned Reg, const MachineBasicBlock &MBB);
+
+  /// isLiveOut - Return true if Reg is live at the exit of MBB for some
+  /// reason other than a PHI use in a successor.
+  bool isLiveOut(unsigned Reg, const MachineBasicBlock &MBB);
+
+  /// clear - Discard all cached liveness. Call this after changing the CFG
+  /// or the instructions that define or use a queried register.
+  void clear();
+
+private:
+  /// The cached result for one register: the blocks where it is live at
+  /// entry, and the blocks where it is live at exit.
+  struct RegLiveness {
+    SparseBitVector<> LiveInBlocks;
+    SparseBitVector<> LiveOutBlocks;
+  };
+
+  MachineRegisterInfo &MRI;
+  DenseMap<unsigned, RegLiveness*> Cache;
+
+  RegLiveness &compute(unsigned Reg);
+  // DefBlocks is not const: SparseBitVector::test() updates its internal
+  // element iterator cache.
+  void markLiveIn(RegLiveness &RL, SparseBitVector<> &DefBlocks,
+                  const MachineBasicBlock *MBB);
+};
+
+} // end namespace llvm
+
+#endif
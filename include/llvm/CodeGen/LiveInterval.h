@@ -135,10 +135,15 @@ namespace llvm {
   class LiveInterval {
   public:
 
-    typedef SmallVector<LiveRange,4> Ranges;
+    // Eight segments fit inline; splitting in the greedy register allocator
+    // commonly pushes intervals past four, and recycled intervals keep
+    // whatever heap capacity they grew beyond that.
+    typedef SmallVector<LiveRange,8> Ranges;
     typedef SmallVector<VNInfo*,4> VNInfoList;
 
-    const unsigned reg;  // the register or stack slot of this interval.
+    // Not const: LiveIntervals recycles interval objects and re-targets them
+    // at a new register.
+    unsigned reg;        // the register or stack slot of this interval.
     float weight;        // weight of this interval
     Ranges ranges;       // the ranges in which this register is live
     VNInfoList valnos;   // value#'s
@@ -566,6 +571,118 @@ namespace llvm {
     }
   };
 
+  /// CompressedLiveRanges - A compact, read-only snapshot of a live
+  /// interval's segment list.
+  ///
+  /// Segments are stored as byte-oriented variable-width deltas over the raw
+  /// slot numbering, relative to the interval's first start index: the gap
+  /// from the previous segment's end, the segment length, and the defining
+  /// value number id.  Most deltas fit in one byte, shrinking a segment from
+  /// 24 bytes to typically 3-5, which is what matters when a huge function
+  /// holds every vreg's interval in memory at once.  A SlotIndex cannot be
+  /// rebuilt from a raw number without the index list, so the snapshot
+  /// answers queries (liveAt, overlaps, forward iteration) but is not
+  /// convertible back into a LiveInterval; it suits analyses and diagnostics
+  /// that only need to read liveness after the interval itself can be
+  /// recycled.  Queries decode on the fly and are linear in the number of
+  /// segments.
+  class CompressedLiveRanges {
+    /// BaseIdx - The start of the first segment; all encoded positions are
+    /// distances from here.
+    SlotIndex BaseIdx;
+
+    SmallVector<uint8_t, 16> Bytes;
+    unsigned NumSegments;
+
+    static void encode(SmallVectorImpl<uint8_t> &Bytes, unsigned Value);
+
+  public:
+    CompressedLiveRanges() : NumSegments(0) {}
+
+    /// Segment - A decoded segment.  Start and End are distances from the
+    /// base index; End is exclusive.
+    struct Segment {
+      unsigned Start;
+      unsigned End;
+      unsigned ValNoId;   ///< VNInfo::id of the defining value.
+    };
+
+    class const_iterator {
+      friend class CompressedLiveRanges;
+      const uint8_t *Pos;
+      unsigned SegsLeft;
+      Segment Seg;
+
+      unsigned readVarint() {
+        unsigned Value = 0, Shift = 0;
+        uint8_t Byte;
+        do {
+          Byte = *Pos++;
+          Value |= unsigned(Byte & 0x7f) << Shift;
+          Shift += 7;
+        } while (Byte & 0x80);
+        return Value;
+      }
+
+      void decode() {
+        Seg.Start = Seg.End + readVarint();
+        Seg.End = Seg.Start + readVarint();
+        Seg.ValNoId = readVarint();
+      }
+
+      const_iterator(const uint8_t *P, unsigned N) : Pos(P), SegsLeft(N) {
+        Seg.Start = Seg.End = Seg.ValNoId = 0;
+        if (SegsLeft)
+          decode();
+      }
+
+    public:
+      const Segment &operator*() const { return Seg; }
+      const Segment *operator->() const { return &Seg; }
+
+      const_iterator &operator++() {
+        if (--SegsLeft)
+          decode();
+        return *this;
+      }
+
+      bool operator==(const const_iterator &RHS) const {
+        return SegsLeft == RHS.SegsLeft;
+      }
+      bool operator!=(const const_iterator &RHS) const {
+        return !operator==(RHS);
+      }
+    };
+
+    const_iterator begin() const {
+      return const_iterator(Bytes.begin(), NumSegments);
+    }
+    const_iterator end() const {
+      return const_iterator(Bytes.end(), 0);
+    }
+
+    unsigned size() const { return NumSegments; }
+    bool empty() const { return NumSegments == 0; }
+
+    /// getBaseIndex - The position the encoded distances are relative to.
+    SlotIndex getBaseIndex() const { return BaseIdx; }
+
+    /// getSizeInBytes - Memory used by the encoded form.  Clients decide per
+    /// function whether snapshotting pays off by comparing this against the
+    /// source interval's segment count.
+    size_t getSizeInBytes() const { return Bytes.size(); }
+
+    /// compress - Snapshot the segment list of the given interval,
+    /// discarding any previous contents.
+    void compress(const LiveInterval &LI);
+
+    /// liveAt - Return true if some segment covers the given index.
+    bool liveAt(SlotIndex I) const;
+
+    /// overlaps - Return true if any segment intersects the other snapshot.
+    bool overlaps(const CompressedLiveRanges &Other) const;
+  };
+
   /// ConnectedVNInfoEqClasses - Helper class that can divide VNInfos in a
   /// LiveInterval into equivalence clases of connected components. A
   /// LiveInterval that has multiple connected components can be broken into
@@ -65,6 +65,12 @@ namespace llvm {
     /// Live interval pointers for all the virtual registers.
     IndexedMap<LiveInterval*, VirtReg2IndexFunctor> VirtRegIntervals;
 
+    /// RetiredIntervals - Interval objects removed by removeInterval, kept
+    /// for reuse by createInterval. A recycled interval retains the heap
+    /// capacity its segment array grew to, which spares the splitting-heavy
+    /// greedy allocator most of its realloc traffic.
+    SmallVector<LiveInterval*, 8> RetiredIntervals;
+
     /// RegMaskSlots - Sorted list of instructions with register mask operands.
     /// Always use the 'r' slot, RegMasks are normal clobbers, not early
     /// clobbers.
@@ -126,9 +132,9 @@ namespace llvm {
       return getInterval(Reg);
     }
 
-    // Interval removal.
+    // Interval removal. The interval object is recycled, not freed.
     void removeInterval(unsigned Reg) {
-      delete VirtRegIntervals[Reg];
+      retireInterval(VirtRegIntervals[Reg]);
       VirtRegIntervals[Reg] = 0;
     }
 
@@ -382,7 +388,8 @@ namespace llvm {
                                   unsigned MOIdx,
                                   LiveInterval& interval);
 
-    static LiveInterval* createInterval(unsigned Reg);
+    LiveInterval *createInterval(unsigned Reg);
+    void retireInterval(LiveInterval *LI);
 
     void printInstrs(raw_ostream &O) const;
     void dumpInstrs() const;
@@ -312,6 +312,10 @@ namespace llvm {
   createMachineFunctionPrinterPass(raw_ostream &OS,
                                    const std::string &Banner ="");
 
+  /// MachineFunctionTelemetry pass - This pass emits per-function code size,
+  /// spill and register pressure telemetry to the given file.
+  MachineFunctionPass *createMachineFunctionTelemetryPass(StringRef Filename);
+
   /// MachineLoopInfo - This pass is a loop analysis pass.
   extern char &MachineLoopInfoID;
 
@@ -416,6 +420,9 @@ namespace llvm {
   /// MachineFunctionPrinterPass - This pass prints out MachineInstr's.
   extern char &MachineFunctionPrinterPassID;
 
+  /// MachineFunctionTelemetry pass. Emits per-function codegen telemetry.
+  extern char &MachineFunctionTelemetryID;
+
   /// TailDuplicate - Duplicate blocks with unconditional branches
   /// into tails of their predecessors.
   extern char &TailDuplicateID;
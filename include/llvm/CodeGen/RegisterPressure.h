@@ -15,6 +15,7 @@
 #ifndef LLVM_CODEGEN_REGISTERPRESSURE_H
 #define LLVM_CODEGEN_REGISTERPRESSURE_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SparseSet.h"
 #include "llvm/CodeGen/SlotIndexes.h"
 #include "llvm/Target/TargetRegisterInfo.h"
@@ -194,12 +195,37 @@ class RegPressureTracker {
   /// Set of live registers.
   LiveRegSet LiveRegs;
 
+  /// A memoized max pressure delta query result, stamped with the tracker
+  /// generation at which it was computed.
+  struct CachedDelta {
+    RegPressureDelta Delta;
+    unsigned Generation;
+    CachedDelta() : Generation(0) {}
+  };
+
+  /// Generation stamp for the tracker's position, liveness and pressure
+  /// state.  Starts at 1 so a default-constructed CachedDelta is never
+  /// current.
+  unsigned Generation;
+
+  /// Memoized per-instruction results of the getMax*PressureDelta queries.
+  /// The scheduler's candidate evaluation asks for the same instruction's
+  /// delta once per pick, and the answer only changes when the tracker moves.
+  DenseMap<const MachineInstr*, CachedDelta> DeltaCache;
+
+  /// Persistent scratch space for the pressure snapshot taken around
+  /// speculative queries, so they do not reallocate it per query.
+  std::vector<unsigned> SnapshotPressure;
+  std::vector<unsigned> SnapshotMaxPressure;
+
 public:
   RegPressureTracker(IntervalPressure &rp) :
-    MF(0), TRI(0), RCI(0), LIS(0), MBB(0), P(rp), RequireIntervals(true) {}
+    MF(0), TRI(0), RCI(0), LIS(0), MBB(0), P(rp), RequireIntervals(true),
+    Generation(1) {}
 
   RegPressureTracker(RegionPressure &rp) :
-    MF(0), TRI(0), RCI(0), LIS(0), MBB(0), P(rp), RequireIntervals(false) {}
+    MF(0), TRI(0), RCI(0), LIS(0), MBB(0), P(rp), RequireIntervals(false),
+    Generation(1) {}
 
   void init(const MachineFunction *mf, const RegisterClassInfo *rci,
             const LiveIntervals *lis, const MachineBasicBlock *mbb,
@@ -217,7 +243,18 @@ public:
   // schedulers to move instructions above the RegPressureTracker's
   // CurrPos. Since the pressure is computed before CurrPos, the iterator
   // position changes while pressure does not.
-  void setPos(MachineBasicBlock::const_iterator Pos) { CurrPos = Pos; }
+  void setPos(MachineBasicBlock::const_iterator Pos) {
+    CurrPos = Pos;
+    // Downward delta queries depend on the position.
+    invalidateCachedDeltas();
+  }
+
+  /// Invalidate all memoized pressure delta query results.  Any mutation of
+  /// the tracker's position, liveness or pressure invalidates them
+  /// implicitly; clients must call this when query inputs that live outside
+  /// the tracker, such as the critical pressure set baselines or the pressure
+  /// limit, change between queries.
+  void invalidateCachedDeltas() { ++Generation; }
 
   /// \brief Get the SlotIndex for the first nondebug instruction including or
   /// after the current position.
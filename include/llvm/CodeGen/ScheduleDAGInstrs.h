@@ -15,6 +15,7 @@
 #ifndef LLVM_CODEGEN_SCHEDULEDAGINSTRS_H
 #define LLVM_CODEGEN_SCHEDULEDAGINSTRS_H
 
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SparseSet.h"
 #include "llvm/ADT/SparseMultiSet.h"
@@ -31,6 +32,7 @@ namespace llvm {
   class MachineDominatorTree;
   class LiveIntervals;
   class RegPressureTracker;
+  class Value;
 
   /// An individual mapping from virtual register number to SUnit.
   struct VReg2SUnit {
@@ -132,6 +134,17 @@ namespace llvm {
     /// to minimize construction/destruction.
     std::vector<SUnit *> PendingLoads;
 
+    /// Memory references to specific known memory locations are tracked
+    /// so that they can be given more precise dependencies. We track
+    /// separately the known memory locations that may alias and those
+    /// that are known not to alias. As with Defs and Uses, these live here
+    /// rather than in buildSchedGraph so that their table storage is
+    /// recycled from one scheduling region to the next.
+    MapVector<const Value *, SUnit *> AliasMemDefs;
+    MapVector<const Value *, SUnit *> NonAliasMemDefs;
+    MapVector<const Value *, std::vector<SUnit *> > AliasMemUses;
+    MapVector<const Value *, std::vector<SUnit *> > NonAliasMemUses;
+
     /// DbgValues - Remember instruction that precedes DBG_VALUE.
     /// These are generated by buildSchedGraph but persist so they can be
     /// referenced when emitting the final schedule.
@@ -214,6 +214,19 @@ public:
     llvm_unreachable("Tblgen should generate the implementation of this!");
   }
 
+  /// CheckCachedPatternPredicate - Memoizing wrapper around
+  /// CheckPatternPredicate.  Pattern predicates only test subtarget features
+  /// and target machine flags, which cannot change during selection, so each
+  /// predicate is evaluated once and then served out of a small table.
+  bool CheckCachedPatternPredicate(unsigned PredNo) const {
+    if (PredNo >= PatternPredicateCache.size())
+      PatternPredicateCache.resize(PredNo+1);
+    unsigned char &Entry = PatternPredicateCache[PredNo];
+    if (Entry == 0)
+      Entry = 1 + unsigned(CheckPatternPredicate(PredNo));
+    return Entry == 2;
+  }
+
   /// CheckNodePredicate - This function is generated by tblgen in the target.
   /// It runs node predicate number PredNo and returns true if it succeeds or
   /// false if it fails.  The number is a private implementation
@@ -272,6 +285,10 @@ private:
   /// state machines that start with a OPC_SwitchOpcode node.
   std::vector<unsigned> OpcodeOffset;
 
+  /// PatternPredicateCache - Memoized CheckPatternPredicate results, indexed
+  /// by predicate number: 0 = not yet evaluated, 1 = false, 2 = true.
+  mutable std::vector<unsigned char> PatternPredicateCache;
+
   void UpdateChainsAndGlue(SDNode *NodeToMatch, SDValue InputChain,
                            const SmallVectorImpl<SDNode*> &ChainNodesMatched,
                            SDValue InputGlue, const SmallVectorImpl<SDNode*> &F,
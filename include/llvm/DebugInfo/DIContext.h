@@ -127,6 +127,11 @@ public:
 
   virtual void dump(raw_ostream &OS, DIDumpType DumpType = DIDT_All) = 0;
 
+  /// setArangesCachePath - Use the given file as an on-disk cache for the
+  /// address range table, so repeated runs against the same binary do not
+  /// rebuild it from the DIEs.  Implementations without caching ignore it.
+  virtual void setArangesCachePath(StringRef Path) {}
+
   virtual DILineInfo getLineInfoForAddress(uint64_t Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) = 0;
   virtual DILineInfoTable getLineInfoForAddressRange(uint64_t Address,
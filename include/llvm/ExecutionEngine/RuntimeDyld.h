@@ -14,6 +14,7 @@
 #ifndef LLVM_EXECUTIONENGINE_RUNTIMEDYLD_H
 #define LLVM_EXECUTIONENGINE_RUNTIMEDYLD_H
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ExecutionEngine/ObjectBuffer.h"
 #include "llvm/Support/Memory.h"
@@ -58,6 +59,21 @@ public:
   virtual void *getPointerToNamedFunction(const std::string &Name,
                                           bool AbortOnFailure = true) = 0;
 
+  /// Resolve the addresses of a set of external symbols in a single call.
+  /// On return Addrs contains one entry per name, in the same order as Names.
+  /// The dynamic linker hands over every unresolved symbol of an object at
+  /// once, so memory managers backed by an expensive per-symbol lookup (e.g.
+  /// dlsym) can sort, dedupe and resolve the whole set in one pass. The
+  /// default implementation simply calls getPointerToNamedFunction for each
+  /// name.
+  ///
+  /// AbortOnFailure behaves as it does for getPointerToNamedFunction, applied
+  /// to each name individually.
+  virtual void getPointersToNamedFunctions(
+      const SmallVectorImpl<std::string> &Names,
+      SmallVectorImpl<void *> &Addrs,
+      bool AbortOnFailure = true);
+
   /// This method is called when object loading is complete and section page
   /// permissions can be applied.  It is up to the memory manager implementation
   /// to decide whether or not to act on this method.  The memory manager will
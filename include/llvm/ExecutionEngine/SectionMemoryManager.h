@@ -40,7 +40,12 @@ class SectionMemoryManager : public JITMemoryManager {
   void operator=(const SectionMemoryManager&) LLVM_DELETED_FUNCTION;
 
 public:
-  SectionMemoryManager() { }
+  /// Create a memory manager that maps memory in slabs of \p SlabSize bytes
+  /// and carves section allocations out of them, so loading a module costs a
+  /// handful of kernel VM operations instead of one mmap and one mprotect per
+  /// section. Requests larger than the slab size get a mapping of their own.
+  SectionMemoryManager(uintptr_t SlabSize = 512 * 1024)
+    : SlabSize(SlabSize) { }
   virtual ~SectionMemoryManager();
 
   /// \brief Allocates a memory block of (at least) the given size suitable for
@@ -105,6 +110,9 @@ private:
   error_code applyMemoryGroupPermissions(MemoryGroup &MemGroup,
                                          unsigned Permissions);
 
+  // Granularity of the underlying memory mappings.
+  uintptr_t SlabSize;
+
   MemoryGroup CodeMem;
   MemoryGroup RWDataMem;
   MemoryGroup RODataMem;
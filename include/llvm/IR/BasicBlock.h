@@ -14,6 +14,7 @@
 #ifndef LLVM_IR_BASICBLOCK_H
 #define LLVM_IR_BASICBLOCK_H
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/ADT/ilist.h"
 #include "llvm/IR/Instruction.h"
@@ -71,12 +72,25 @@ private:
 class BasicBlock : public Value, // Basic blocks are data objects also
                    public ilist_node<BasicBlock> {
   friend class BlockAddress;
+  friend class Value; // Value::adjustPredecessorCount maintains PredCount.
 public:
   typedef iplist<Instruction> InstListType;
 private:
   InstListType InstList;
   Function *Parent;
 
+  /// InstrOrderValid - Whether the Order fields of the contained
+  /// instructions form a valid numbering.  Cleared whenever an instruction
+  /// is inserted into, removed from, or moved within this block, and
+  /// rebuilt on demand by renumberInstructions.
+  mutable bool InstrOrderValid;
+
+  /// PredCount - The number of CFG edges into this block, i.e. the number of
+  /// uses of this block whose user is a terminator instruction.  Maintained
+  /// eagerly by the use-list code (see Value::adjustPredecessorCount), so it
+  /// is always in sync and never needs invalidation.
+  unsigned PredCount;
+
   void setParent(Function *parent);
   friend class SymbolTableListTraits<BasicBlock, Function>;
 
@@ -169,6 +183,13 @@ public:
   void moveAfter(BasicBlock *MovePos);
 
 
+  /// \brief Return the number of CFG edges into this block.
+  ///
+  /// This counts edges, not distinct predecessor blocks: a switch with several
+  /// cases branching to the same block contributes one edge per case, matching
+  /// std::distance(pred_begin(BB), pred_end(BB)) at constant cost.
+  unsigned getNumPredecessors() const { return PredCount; }
+
   /// \brief Return this block if it has a single predecessor block. Otherwise
   /// return a null pointer.
   BasicBlock *getSinglePredecessor();
@@ -218,6 +239,22 @@ public:
     return &BasicBlock::InstList;
   }
 
+  /// \brief Returns true if the cached instruction ordering is valid.
+  bool isInstrOrderValid() const { return InstrOrderValid; }
+
+  /// \brief Mark the cached instruction ordering invalid.
+  ///
+  /// This happens automatically through the instruction list callbacks, but
+  /// code that reorders the list without going through them (a splice within
+  /// this block) must call it explicitly.
+  void invalidateInstrOrder() const { InstrOrderValid = false; }
+
+  /// \brief Renumber the instructions in this block so that
+  /// Instruction::comesBefore can answer in constant time.
+  ///
+  /// Called lazily from comesBefore; there is no need to call it directly.
+  void renumberInstructions() const;
+
   /// \brief Returns a pointer to the symbol table if one exists.
   ValueSymbolTable *getValueSymbolTable();
 
@@ -298,6 +335,32 @@ private:
   }
 };
 
+/// InstructionMover - Deferred bulk instruction movement.  Passes that move
+/// many instructions to the same point (hoisting to a preheader, sinking into
+/// a successor) traditionally call Instruction::moveBefore once per
+/// instruction, paying an ilist unlink/relink each time.  Record the moves
+/// with addMove() instead and call apply(), which performs all moves with the
+/// same source block and insertion point in a single pass over the source
+/// block, splicing maximal contiguous runs at once and preserving the
+/// instructions' relative order.
+///
+/// The insertion points must not themselves be among the moved instructions,
+/// and a moved instruction may be recorded only once.
+class InstructionMover {
+  SmallVector<std::pair<Instruction*, Instruction*>, 16> Moves;
+
+public:
+  /// addMove - Record that I is to be moved immediately before MovePos.
+  void addMove(Instruction *I, Instruction *MovePos) {
+    Moves.push_back(std::make_pair(I, MovePos));
+  }
+
+  bool empty() const { return Moves.empty(); }
+
+  /// apply - Perform all recorded moves and forget them.
+  void apply();
+};
+
 } // End llvm namespace
 
 #endif
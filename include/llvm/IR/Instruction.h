@@ -35,6 +35,12 @@ class Instruction : public User, public ilist_node<Instruction> {
   BasicBlock *Parent;
   DebugLoc DbgLoc;                         // 'dbg' Metadata cache.
 
+  /// Order - Relative order of this instruction in its parent basic block.
+  /// Only valid while the parent's ordering cache is valid; maintained
+  /// lazily by BasicBlock::renumberInstructions.
+  mutable unsigned Order;
+  friend class BasicBlock;
+
   enum {
     /// HasMetadataBit - This is a bit stored in the SubClassData field which
     /// indicates whether this instruction has metadata attached to it or not.
@@ -75,6 +81,13 @@ public:
   /// MovePos.
   void moveBefore(Instruction *MovePos);
 
+  /// comesBefore - Return true if this instruction comes before Other in the
+  /// same basic block.  Both instructions must have a parent and it must be
+  /// the same block.  Answered in constant time from the block's lazily
+  /// built instruction numbering, so unlike walking the instruction list
+  /// this is cheap even in very large blocks.
+  bool comesBefore(const Instruction *Other) const;
+
   //===--------------------------------------------------------------------===//
   // Subclass classification.
   //===--------------------------------------------------------------------===//
@@ -1168,6 +1168,14 @@ public:
 ///
 class CallInst : public Instruction {
   AttributeSet AttributeList; ///< parameter attributes for call
+
+  /// ReservedOperands - The number of Use slots co-allocated with this
+  /// instruction, always >= NumOperands.  The unused slots sit in front of
+  /// the operand list and let the argument list grow in place; the
+  /// destructor re-exposes them so operator delete sees the original
+  /// allocation.
+  unsigned ReservedOperands;
+
   CallInst(const CallInst &CI);
   void init(Value *Func, ArrayRef<Value *> Args, const Twine &NameStr);
   void init(Value *Func, const Twine &NameStr);
@@ -1205,6 +1213,12 @@ public:
     return new(unsigned(Args.size() + 1))
       CallInst(Func, Args, NameStr, InsertAtEnd);
   }
+  /// Create - Construct a call with room for ReservedArgs argument operands,
+  /// so that the argument list can later grow in place via addArgOperand
+  /// instead of re-creating the instruction.
+  static CallInst *Create(Value *Func, ArrayRef<Value *> Args,
+                          unsigned ReservedArgs, const Twine &NameStr = "",
+                          Instruction *InsertBefore = 0);
   static CallInst *Create(Value *F, const Twine &NameStr = "",
                           Instruction *InsertBefore = 0) {
     return new(1) CallInst(F, NameStr, InsertBefore);
@@ -1253,6 +1267,21 @@ public:
   Value *getArgOperand(unsigned i) const { return getOperand(i); }
   void setArgOperand(unsigned i, Value *v) { setOperand(i, v); }
 
+  /// getReservedArgOperands - Return the number of argument operands the
+  /// call has room for without re-creating the instruction.
+  unsigned getReservedArgOperands() const { return ReservedOperands - 1; }
+
+  /// addArgOperand - Append an argument operand in place.  There must be
+  /// reserved space left; the caller is responsible for keeping the callee
+  /// and the attributes consistent with the new argument list.
+  void addArgOperand(Value *V);
+
+  /// removeArgOperand - Remove the i-th argument operand in place, shifting
+  /// the preceding arguments down.  The vacated slot becomes reserved space,
+  /// so any call can shrink without re-allocation.  Attributes on arguments
+  /// past i are not adjusted; the caller must rebuild them.
+  void removeArgOperand(unsigned i);
+
   /// getCallingConv/setCallingConv - Get or set the calling convention of this
   /// function call.
   CallingConv::ID getCallingConv() const {
@@ -20,6 +20,7 @@
 namespace llvm {
 
 class LLVMContextImpl;
+class MemoryBuffer;
 class StringRef;
 class Twine;
 class Instruction;
@@ -107,6 +108,22 @@ public:
   void emitWarning(const Instruction *I, const Twine &ErrorStr);
   void emitWarning(const Twine &ErrorStr);
 
+  /// addExternalDataBuffer - Take ownership of an immutable buffer (typically
+  /// a memory-mapped file) and keep it alive for the lifetime of this context.
+  /// Constant data constants (ConstantDataArray/Vector) whose element bytes
+  /// lie inside a registered buffer reference those bytes in place instead of
+  /// copying them into the context, so large file-backed blobs can be turned
+  /// into constants without duplicating their storage.
+  void addExternalDataBuffer(MemoryBuffer *Buf);
+
+  /// enableSharedConstantData - Make this context intern the payload bytes of
+  /// its constant data constants into a process-wide, content-addressed,
+  /// read-only store instead of its own allocator.  Contexts that opt in and
+  /// build identical big initializers (string tables, lookup tables) share
+  /// one copy of the bytes; each context still owns its lightweight constant
+  /// handle objects.  The shared bytes live until process shutdown.
+  void enableSharedConstantData();
+
 private:
   LLVMContext(LLVMContext&) LLVM_DELETED_FUNCTION;
   void operator=(LLVMContext&) LLVM_DELETED_FUNCTION;
@@ -96,7 +96,11 @@ class MDNode : public Value, public FoldingSetNode {
 
     /// DestroyFlag - This bit is set by destroy() so the destructor can assert
     /// that the node isn't being destroyed with a plain 'delete'.
-    DestroyFlag      = 1 << 2
+    DestroyFlag      = 1 << 2,
+
+    /// ArenaAllocatedBit - This is set on MDNodes allocated out of the
+    /// LLVMContextImpl's metadata arena; destroy() must not free() them.
+    ArenaAllocatedBit = 1 << 3
   };
 
   // FunctionLocal enums.
@@ -41,6 +41,10 @@ class MDNode;
 class Type;
 class StringRef;
 
+namespace sys {
+  class EpochReclamationManager;
+}
+
 //===----------------------------------------------------------------------===//
 //                                 Value Class
 //===----------------------------------------------------------------------===//
@@ -84,6 +88,12 @@ private:
   void operator=(const Value &) LLVM_DELETED_FUNCTION;
   Value(const Value &) LLVM_DELETED_FUNCTION;
 
+  /// adjustPredecessorCount - Keep BasicBlock's cached predecessor edge count
+  /// in sync as uses of this value are added and removed.  Only called by
+  /// addUse/removeUse when this value is a basic block; defined out-of-line in
+  /// BasicBlock.cpp, where the user of U can be inspected.
+  void adjustPredecessorCount(const Use &U, int Delta);
+
 protected:
   /// printCustom - Value subclasses can override this to implement custom
   /// printing behavior.
@@ -93,6 +103,16 @@ protected:
 public:
   virtual ~Value();
 
+  /// deleteDeferred - Queue this value for destruction instead of deleting it
+  /// now.  Destroying a value unlinks its use list and erases it from context
+  /// maps, which races with any other thread walking the IR; deferred values
+  /// stay allocated until the value reclamation manager's grace period has
+  /// expired, so readers inside one of its critical regions never see the
+  /// storage disappear.  In single-threaded mode the value is deleted
+  /// immediately.  The value must already be unused and removed from its
+  /// parent, exactly as if it were being deleted.
+  void deleteDeferred();
+
   /// dump - Support for debugging, callable in GDB: V->dump()
   //
   void dump() const;
@@ -177,7 +197,19 @@ public:
 
   /// addUse - This method should only be used by the Use class.
   ///
-  void addUse(Use &U) { U.addToList(&UseList); }
+  void addUse(Use &U) {
+    U.addToList(&UseList);
+    if (SubclassID == BasicBlockVal)
+      adjustPredecessorCount(U, 1);
+  }
+
+  /// removeUse - Notification that the use U of this value is about to be
+  /// removed from the use list.  Like addUse, this method should only be used
+  /// by the Use class.
+  void removeUse(Use &U) {
+    if (SubclassID == BasicBlockVal)
+      adjustPredecessorCount(U, -1);
+  }
 
   /// An enumeration for keeping track of the concrete subclass of Value that
   /// is actually instantiated. Values of this enumeration are kept in the 
@@ -321,9 +353,18 @@ inline raw_ostream &operator<<(raw_ostream &OS, const Value &V) {
   V.print(OS);
   return OS;
 }
+
+/// getValueReclamationManager - The process-wide epoch manager through which
+/// deleteDeferred funnels.  Threads that read IR concurrently with deletion
+/// bracket their reads with its critical regions, and a parallel pass driver
+/// calls collect() or drain() at the quiescent points between pass batches.
+sys::EpochReclamationManager &getValueReclamationManager();
   
 void Use::set(Value *V) {
-  if (Val) removeFromList();
+  if (Val) {
+    Val->removeUse(*this);
+    removeFromList();
+  }
   Val = V;
   if (V) V->addUse(*this);
 }
@@ -14,6 +14,7 @@
 #ifndef LLVM_LINKER_H
 #define LLVM_LINKER_H
 
+#include "llvm/ADT/SmallPtrSet.h"
 #include <memory>
 #include <string>
 #include <vector>
@@ -21,6 +22,7 @@
 namespace llvm {
   namespace sys { class Path; }
 
+class Function;
 class Module;
 class LLVMContext;
 class StringRef;
@@ -173,6 +175,20 @@ class Linker {
     static bool LinkModules(Module* Dest, Module* Src, unsigned Mode,
                             std::string* ErrorMsg);
 
+    /// This variant gives the caller explicit control over which function
+    /// bodies cross the module boundary: only functions in \p
+    /// FunctionsToImport have their bodies linked in (materializing them on
+    /// demand if \p Src was lazily loaded); every other function from \p Src
+    /// becomes a plain declaration in \p Dest.  This is the primitive a thin
+    /// link is built on: importing decisions are made from function
+    /// summaries, and only the chosen bodies are ever read.  Passing a null
+    /// set behaves exactly like the variant above.
+    /// @returns True if an error occurs, false otherwise.
+    /// @brief Link two modules, importing only selected function bodies.
+    static bool LinkModules(Module* Dest, Module* Src, unsigned Mode,
+                            const SmallPtrSet<Function*, 8> *FunctionsToImport,
+                            std::string* ErrorMsg);
+
   /// @}
   /// @name Implementation
   /// @{
@@ -11,12 +11,14 @@
 #define LLVM_MC_MCASSEMBLER_H
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/ilist.h"
 #include "llvm/ADT/ilist_node.h"
 #include "llvm/MC/MCFixup.h"
 #include "llvm/MC/MCInst.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/DataTypes.h"
 #include <vector> // FIXME: Shouldn't be needed.
@@ -797,6 +799,28 @@ struct DataRegionData {
   MCSymbol *End;
 };
 
+/// \brief A memoized fixup-free instruction encoding, uniqued by the opcode
+/// and operands that produced it.  See MCAssembler::encodeInstruction.
+class MCMemoizedEncoding : public FoldingSetNode {
+  friend class MCAssembler;
+
+  /// The uniquing key (opcode and operands), interned in the assembler's
+  /// memo allocator.
+  FoldingSetNodeIDRef FastID;
+
+  /// The emitter's output for this instruction, interned in the same
+  /// allocator.
+  const char *Code;
+  unsigned CodeSize;
+
+  MCMemoizedEncoding(FoldingSetNodeIDRef ID, const char *Code,
+                     unsigned CodeSize)
+    : FastID(ID), Code(Code), CodeSize(CodeSize) {}
+
+public:
+  void Profile(FoldingSetNodeID &ID) { ID = FastID; }
+};
+
 class MCAssembler {
   friend class MCAsmLayout;
 
@@ -877,6 +901,13 @@ private:
   // Access to the flags is necessary in cases where assembler directives affect
   // which flags to be set.
   unsigned ELFHeaderEFlags;
+
+  /// Memoized encodings of fixup-free instructions.  Generated code repeats
+  /// a small number of instruction shapes, so keep the emitter's output for
+  /// each distinct (opcode, operands) key and copy it on repeats.  Nodes and
+  /// their keys live in EncodingMemoAllocator.
+  FoldingSet<MCMemoizedEncoding> EncodingMemo;
+  BumpPtrAllocator EncodingMemoAllocator;
 private:
   /// Evaluate a fixup to a relocatable expression and the value which should be
   /// placed into the fixup.
@@ -905,12 +936,16 @@ private:
                                const MCAsmLayout &Layout) const;
 
   /// \brief Perform one layout iteration and return true if any offsets
-  /// were adjusted.
-  bool layoutOnce(MCAsmLayout &Layout);
+  /// were adjusted. \p Relaxable holds each section's relaxation candidates,
+  /// indexed by section ordinal.
+  bool layoutOnce(MCAsmLayout &Layout,
+                  std::vector<std::vector<MCFragment *> > &Relaxable);
 
-  /// \brief Perform one layout iteration of the given section and return true
-  /// if any offsets were adjusted.
-  bool layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD);
+  /// \brief Perform one layout iteration over one section's relaxation
+  /// candidates and return true if any offsets were adjusted. Fragments that
+  /// can no longer change size are pruned from \p Relaxable.
+  bool layoutSectionOnce(MCAsmLayout &Layout,
+                         std::vector<MCFragment *> &Relaxable);
 
   bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF);
 
@@ -984,6 +1019,20 @@ public:
 
   MCObjectWriter &getWriter() const { return Writer; }
 
+  /// encodeInstruction - Encode \p Inst with the code emitter, appending the
+  /// bytes to \p Code and any fixups to \p Fixups.  Instructions whose
+  /// operands are all registers or immediates and whose encoding produced no
+  /// fixups are memoized, so repeats are served by a copy instead of a trip
+  /// through the emitter; anything else is context dependent and re-encoded
+  /// every time.
+  void encodeInstruction(const MCInst &Inst, SmallVectorImpl<char> &Code,
+                         SmallVectorImpl<MCFixup> &Fixups);
+
+  /// flushEncodingMemo - Drop the memoized instruction encodings.  Streamers
+  /// must call this when the encoding context changes under the emitter,
+  /// e.g. on a .code16/.code32/.thumb mode switch.
+  void flushEncodingMemo();
+
   /// Finish - Do final processing and write the object to the output stream.
   /// \p Writer is used for custom object writer (as the MCJIT does),
   /// if not specified it is automatically created from backend.
@@ -10,6 +10,7 @@
 #ifndef LLVM_MC_MCCONTEXT_H
 #define LLVM_MC_MCCONTEXT_H
 
+#include "llvm/ADT/CompactStringMap.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/MC/MCDwarf.h"
@@ -43,7 +44,11 @@ namespace llvm {
     MCContext(const MCContext&) LLVM_DELETED_FUNCTION;
     MCContext &operator=(const MCContext&) LLVM_DELETED_FUNCTION;
   public:
-    typedef StringMap<MCSymbol*, BumpPtrAllocator&> SymbolTable;
+    /// SymbolTable - Symbol interning is hot enough during object emission
+    /// that it uses the open-addressed CompactStringMap; the table only ever
+    /// grows, and nothing retains references to its keys (symbol names point
+    /// into UsedNames).
+    typedef CompactStringMap<MCSymbol*, BumpPtrAllocator&> SymbolTable;
   private:
     /// The SourceMgr for this object, if any.
     const SourceMgr *SrcMgr;
@@ -104,6 +109,16 @@ namespace llvm {
     std::vector<MCDwarfFile *> MCDwarfFiles;
     std::vector<StringRef> MCDwarfDirs;
 
+    /// MCDwarfDirIndex - Hash index over MCDwarfDirs, mapping a directory
+    /// name to its one based DirIndex so GetDwarfFile need not rescan the
+    /// table for every .file directive.  The map's key storage also provides
+    /// the bytes the MCDwarfDirs entries point at.
+    StringMap<unsigned, BumpPtrAllocator&> MCDwarfDirIndex;
+
+    /// MCDwarfFileNames - Interned file name storage; many file numbers end
+    /// up with the same basename once the directory part is split off.
+    StringMap<bool, BumpPtrAllocator&> MCDwarfFileNames;
+
     /// The current dwarf line information from the last dwarf .loc directive.
     MCDwarfLoc CurrentDwarfLoc;
     bool DwarfLocSeen;
@@ -138,6 +153,14 @@ namespace llvm {
     /// Darwin).
     bool AllowTemporaryLabels;
 
+    /// Assign names to assembler temporary labels.  Object emitters that
+    /// never need a name for temporaries (the ELF writer resolves them to
+    /// section-relative offsets) turn this off, letting CreateTempSymbol
+    /// skip name formatting and string table interning entirely.  Temporary
+    /// labels created for debug info dominate symbol creation, so this is a
+    /// significant saving in object-file mode.
+    bool UseNamesOnTempLabels;
+
     /// The dwarf line information from the .loc directives for the sections
     /// with assembled machine instructions have after seeing .loc directives.
     DenseMap<const MCSection *, MCLineSection *> MCLineSections;
@@ -171,6 +194,7 @@ namespace llvm {
     const MCObjectFileInfo *getObjectFileInfo() const { return MOFI; }
 
     void setAllowTemporaryLabels(bool Value) { AllowTemporaryLabels = Value; }
+    void setUseNamesOnTempLabels(bool Value) { UseNamesOnTempLabels = Value; }
 
     /// @name Module Lifetime Management
     /// @{
@@ -15,6 +15,7 @@
 #define LLVM_OBJECT_ARCHIVE_H
 
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Object/Binary.h"
@@ -172,6 +173,9 @@ public:
     uint32_t SymbolIndex;
     uint32_t StringIndex; // Extra index to the string.
 
+    // findSym reads the indices when building its lookup map.
+    friend class Archive;
+
   public:
     bool operator ==(const Symbol &other) const {
       return (Parent == other.Parent) && (SymbolIndex == other.SymbolIndex);
@@ -238,6 +242,14 @@ private:
   child_iterator SymbolTable;
   child_iterator StringTable;
   Kind Format;
+
+  /// SymbolIndexMap - Map from symbol name to the (SymbolIndex, StringIndex)
+  /// pair identifying the symbol in the symbol table.  Built lazily by
+  /// findSym so that clients resolving many symbols against one archive pay
+  /// a single walk over the symbol table instead of one per query, while
+  /// clients that only iterate members never pay for it.
+  mutable StringMap<std::pair<uint32_t, uint32_t> > SymbolIndexMap;
+  mutable bool SymbolIndexBuilt;
 };
 
 }
@@ -696,6 +696,9 @@ public:
   virtual symbol_iterator begin_dynamic_symbols() const;
   virtual symbol_iterator end_dynamic_symbols() const;
 
+  virtual error_code readSymbols(SmallVectorImpl<SymbolDesc> &Syms,
+                                 bool Dynamic = false) const;
+
   virtual section_iterator begin_sections() const;
   virtual section_iterator end_sections() const;
 
@@ -910,6 +913,43 @@ error_code ELFObjectFile<ELFT>::getSymbolNext(DataRefImpl Symb,
   return object_error::success;
 }
 
+template<class ELFT>
+error_code ELFObjectFile<ELFT>::readSymbols(SmallVectorImpl<SymbolDesc> &Syms,
+                                            bool Dynamic) const {
+  // Walk each symbol table section directly instead of round-tripping every
+  // attribute of every symbol through the generic virtual interface.  The
+  // attribute helpers are resolved statically here, so the compiler can
+  // inline them and the names come straight out of the mapped string table.
+  unsigned TableBegin = Dynamic ? 0 : 1;
+  unsigned TableEnd = Dynamic ? 1 : SymbolTableSections.size();
+  for (unsigned b = TableBegin; b < TableEnd; ++b) {
+    const Elf_Shdr *SymTab = SymbolTableSections[b];
+    if (!SymTab)
+      continue;
+    // The 0th symbol in ELF is fake.
+    for (uint32_t a = 1, e = SymTab->getEntityCount(); a < e; ++a) {
+      DataRefImpl Symb;
+      Symb.d.a = a;
+      Symb.d.b = b;
+      SymbolDesc D;
+      if (error_code ec = ELFObjectFile<ELFT>::getSymbolFlags(Symb, D.Flags))
+        return ec;
+      if (error_code ec = ELFObjectFile<ELFT>::getSymbolName(Symb, D.Name))
+        return ec;
+      if (error_code ec =
+            ELFObjectFile<ELFT>::getSymbolAddress(Symb, D.Address))
+        return ec;
+      if (error_code ec = ELFObjectFile<ELFT>::getSymbolSize(Symb, D.Size))
+        return ec;
+      if (error_code ec =
+            ELFObjectFile<ELFT>::getSymbolNMTypeChar(Symb, D.TypeChar))
+        return ec;
+      Syms.push_back(D);
+    }
+  }
+  return object_error::success;
+}
+
 template<class ELFT>
 error_code ELFObjectFile<ELFT>::getSymbolName(DataRefImpl Symb,
                                               StringRef &Result) const {
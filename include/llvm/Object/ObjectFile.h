@@ -14,6 +14,7 @@
 #ifndef LLVM_OBJECT_OBJECTFILE_H
 #define LLVM_OBJECT_OBJECTFILE_H
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Object/Binary.h"
 #include "llvm/Support/DataTypes.h"
@@ -364,6 +365,26 @@ public:
   virtual symbol_iterator begin_dynamic_symbols() const = 0;
   virtual symbol_iterator end_dynamic_symbols() const = 0;
 
+  /// SymbolDesc - A plain record describing one symbol, filled in by
+  /// readSymbols().  The name points into the object's (memory mapped)
+  /// string table and is only valid while the ObjectFile is alive.
+  struct SymbolDesc {
+    StringRef Name;
+    uint64_t Address;
+    uint64_t Size;
+    uint32_t Flags;
+    char TypeChar;
+  };
+
+  /// readSymbols - Read the whole static (or, if \p Dynamic is set, dynamic)
+  /// symbol table into \p Syms in one pass.  This is the bulk alternative to
+  /// walking begin_symbols(): the generic iteration costs several virtual
+  /// calls per symbol, so format implementations can override this to walk
+  /// their symbol table directly.  The default implementation loops over the
+  /// generic iterators.
+  virtual error_code readSymbols(SmallVectorImpl<SymbolDesc> &Syms,
+                                 bool Dynamic = false) const;
+
   virtual section_iterator begin_sections() const = 0;
   virtual section_iterator end_sections() const = 0;
 
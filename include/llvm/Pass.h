@@ -358,6 +358,13 @@ public:
 /// @brief This is the storage for the -time-passes option.
 extern bool TimePassesIsEnabled;
 
+/// PassBudgetExceeded - Return true if the -pass-budget time budget for the
+/// currently executing pass has run out.  Passes with potentially unbounded
+/// work loops may poll this and stop transforming when it returns true; the
+/// result they have computed so far must remain valid.  Always returns false
+/// when no budget is configured.
+bool PassBudgetExceeded();
+
 } // End llvm namespace
 
 // Include support files that contain important APIs commonly used by Passes,
@@ -98,6 +98,47 @@ private:
   Module *M;
 };
 
+/// ParallelFunctionPassManager - Runs a per-function pass pipeline over the
+/// functions of a module on a pool of worker threads.  Each worker owns a
+/// private FunctionPassManager (passes keep per-run state and cannot be
+/// shared), and the workers pull functions from a shared work queue so the
+/// load balances dynamically across uneven function sizes.
+///
+/// The caller is responsible for ensuring the scheduled passes are safe to
+/// run concurrently on distinct functions of one module: they must not
+/// mutate module-level state (globals, named metadata, the function list)
+/// and llvm_start_multithreaded() must have succeeded.  Beware that the
+/// functions all live in one LLVMContext, whose uniquing tables are not
+/// locked: any pass that creates a constant, type, or metadata node -- which
+/// includes essentially every transform pass -- mutates shared context state
+/// and is only safe here if the caller serializes those mutations with an
+/// external lock on the context.
+class ParallelFunctionPassManager {
+public:
+  /// PipelineBuilder - Callback interface used to populate the per-worker
+  /// pipelines.  populate() is invoked once per worker thread's pass manager
+  /// and must add equivalent passes to each.
+  class PipelineBuilder {
+  public:
+    virtual ~PipelineBuilder();
+    virtual void populate(FunctionPassManager &FPM) = 0;
+  };
+
+  /// ParallelFunctionPassManager ctor - This initializes the pass manager.
+  /// It needs, but does not take ownership of, the specified Module.
+  ParallelFunctionPassManager(Module *M, unsigned NumThreads);
+  ~ParallelFunctionPassManager();
+
+  /// run - Populate one pipeline per worker using \p Builder, then run the
+  /// pipelines over every function that is not a declaration.  Returns true
+  /// if any function was modified.
+  bool run(PipelineBuilder &Builder);
+
+private:
+  Module *M;
+  unsigned NumThreads;
+};
+
 } // End llvm namespace
 
 #endif
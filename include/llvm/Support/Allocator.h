@@ -56,6 +56,12 @@ public:
   MemSlab *NextPtr;
 };
 
+/// SlabAllocatedBytes - Return the total number of bytes currently held in
+/// slabs by the Malloc and Mmap slab allocators, process-wide.  This is
+/// maintained for the -track-memory accounting in Timer.cpp, which uses it
+/// to attribute transient bump-allocated memory to the running passes.
+size_t SlabAllocatedBytes();
+
 /// SlabAllocator - This class can be used to parameterize the underlying
 /// allocation strategy for the bump allocator.  In particular, this is used
 /// by the JIT to allocate contiguous swathes of executable memory.  The
@@ -83,6 +89,22 @@ public:
   virtual void Deallocate(MemSlab *Slab) LLVM_OVERRIDE;
 };
 
+/// MmapSlabAllocator - A slab allocator that gets every slab directly from
+/// the operating system as a private anonymous mapping instead of going
+/// through malloc.  Freshly mapped pages are placed on the NUMA node of the
+/// thread that first touches them and large mappings are eligible for huge
+/// pages on systems that provide them, so this is a good fit for big
+/// thread-private allocators in heavily parallel builds.  Deallocated slabs
+/// are returned to the operating system immediately rather than to a shared
+/// malloc pool.
+class MmapSlabAllocator : public SlabAllocator {
+public:
+  MmapSlabAllocator() { }
+  virtual ~MmapSlabAllocator();
+  virtual MemSlab *Allocate(size_t Size) LLVM_OVERRIDE;
+  virtual void Deallocate(MemSlab *Slab) LLVM_OVERRIDE;
+};
+
 /// BumpPtrAllocator - This allocator is useful for containers that need
 /// very simple memory allocation strategies.  In particular, this just keeps
 /// allocating memory, and never deletes it until the entire block is dead. This
@@ -99,6 +121,12 @@ class BumpPtrAllocator {
   /// allocate a separate slab.
   size_t SizeThreshold;
 
+  /// GrowthDelay - Double the slab size each time roughly this many slabs'
+  /// worth of memory has been handed out.  Small values reach large slabs
+  /// quickly, which suits allocators that are expected to grow very big;
+  /// large values keep slabs small and waste less memory on tear-down.
+  size_t GrowthDelay;
+
   /// Allocator - The underlying allocator we use to get slabs of memory.  This
   /// defaults to MallocSlabAllocator, which wraps malloc, but it could be
   /// changed to use a custom allocator.
@@ -108,6 +136,10 @@ class BumpPtrAllocator {
   ///
   MemSlab *CurSlab;
 
+  /// FreeSlabs - Slabs retained by ResetForReuse, ready to be reused by
+  /// StartNewSlab instead of going back to the slab allocator.
+  MemSlab *FreeSlabs;
+
   /// CurPtr - The current pointer into the current slab.  This points to the
   /// next free byte in the slab.
   char *CurPtr;
@@ -138,13 +170,21 @@ class BumpPtrAllocator {
   template<typename T> friend class SpecificBumpPtrAllocator;
 public:
   BumpPtrAllocator(size_t size = 4096, size_t threshold = 4096,
-                   SlabAllocator &allocator = DefaultSlabAllocator);
+                   SlabAllocator &allocator = DefaultSlabAllocator,
+                   size_t growthDelay = 128);
   ~BumpPtrAllocator();
 
   /// Reset - Deallocate all but the current slab and reset the current pointer
   /// to the beginning of it, freeing all memory allocated so far.
   void Reset();
 
+  /// ResetForReuse - Like Reset, but retain the allocated slabs on an
+  /// internal free list instead of returning them to the slab allocator.
+  /// This is useful for allocators that are repeatedly filled to a similar
+  /// high-water mark, because the next round of allocations reuses the warm
+  /// slabs instead of paying for fresh ones.
+  void ResetForReuse();
+
   /// Allocate - Allocate space at the specified alignment.
   ///
   void *Allocate(size_t Size, size_t Alignment);
@@ -286,6 +286,16 @@
 # define LLVM_ASSUME_ALIGNED(p, a) (p)
 #endif
 
+/// \macro LLVM_PREFETCH
+/// \brief Expands to an expression which prefetches the cache line holding
+/// the given address for a read, on compilers which support it.  Otherwise,
+/// evaluates the address and does nothing.
+#ifdef __GNUC__
+# define LLVM_PREFETCH(p) __builtin_prefetch(p)
+#else
+# define LLVM_PREFETCH(p) ((void)(p))
+#endif
+
 /// \macro LLVM_FUNCTION_NAME
 /// \brief Expands to __func__ on compilers which support it.  Otherwise,
 /// expands to a compiler-dependent replacement.
@@ -0,0 +1,46 @@
+//===-- llvm/Support/Compression.h ---Compression----------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains basic functions for compression/uncompression.  The
+// codec is a small self-contained byte-oriented LZ77 variant that favors
+// speed over ratio; it has no external library dependencies and a fixed,
+// documented wire format, so compressed data is portable between hosts.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_COMPRESSION_H
+#define LLVM_SUPPORT_COMPRESSION_H
+
+#include "llvm/Support/DataTypes.h"
+#include <cstddef>
+
+namespace llvm {
+
+template<typename T> class SmallVectorImpl;
+class StringRef;
+
+namespace compression {
+
+  /// compress - Compress Input, appending the result to Output.  This never
+  /// fails; incompressible input simply expands slightly (by at most
+  /// Input.size()/255 + 16 bytes), so callers that care should compare the
+  /// sizes and store the original bytes when compression does not help.
+  void compress(StringRef Input, SmallVectorImpl<char> &Output);
+
+  /// uncompress - Decompress Input, which must have been produced by
+  /// compress() from exactly UncompressedSize bytes, into Output.  Returns
+  /// false if the input is truncated or malformed.
+  bool uncompress(StringRef Input, SmallVectorImpl<char> &Output,
+                  size_t UncompressedSize);
+
+}  // End of namespace compression
+
+}  // End of namespace llvm
+
+#endif
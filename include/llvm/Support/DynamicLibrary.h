@@ -14,6 +14,7 @@
 #ifndef LLVM_SYSTEM_DYNAMICLIBRARY_H
 #define LLVM_SYSTEM_DYNAMICLIBRARY_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include <string>
 
 namespace llvm {
@@ -91,6 +92,15 @@ namespace sys {
       return SearchForAddressOfSymbol(symbolName.c_str());
     }
 
+    /// This function resolves all of the given symbols in one pass under a
+    /// single lock acquisition and remembers the results, including the
+    /// symbols that were not found.  Subsequent SearchForAddressOfSymbol()
+    /// calls for these names are answered from the snapshot without walking
+    /// the opened libraries.  Useful for JIT clients that know the set of
+    /// external symbols a module references before resolution starts.
+    /// @brief Resolve a batch of symbols up front.
+    static void PreloadSymbols(ArrayRef<const char *> symbolNames);
+
     /// This functions permanently adds the symbol \p symbolName with the
     /// value \p symbolValue.  These symbols are searched before any
     /// libraries.
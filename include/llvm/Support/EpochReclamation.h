@@ -0,0 +1,126 @@
+//===- llvm/Support/EpochReclamation.h - Deferred reclamation ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the EpochReclamationManager class, an epoch-based
+// deferred destruction scheme.  Threads that read a shared structure bracket
+// each read region with enterCriticalRegion/exitCriticalRegion; writers
+// retire objects instead of deleting them.  A retired object is destroyed
+// only once every thread has left the epoch in which it was retired, so
+// readers inside a critical region may traverse the structure without
+// per-object reference counts or atomic operations: nothing they can reach
+// is freed underneath them.
+//
+// In single-threaded mode retire() destroys the object immediately and the
+// epoch machinery collapses to nothing.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_EPOCHRECLAMATION_H
+#define LLVM_SUPPORT_EPOCHRECLAMATION_H
+
+#include "llvm/Support/Atomic.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/ThreadLocal.h"
+#include <vector>
+
+namespace llvm {
+namespace sys {
+
+class EpochReclamationManager {
+public:
+  /// DeleterTy - Destroys one retired object.
+  typedef void (*DeleterTy)(void *);
+
+private:
+  struct Retired {
+    void *Ptr;
+    DeleterTy Deleter;
+  };
+
+  struct ThreadState {
+    /// InCritical - Non-zero while the owning thread is inside a critical
+    /// region.  Written only by the owner, read by epoch advancement.
+    volatile cas_flag InCritical;
+
+    /// LocalEpoch - The global epoch the owner observed when it entered its
+    /// current critical region.
+    volatile cas_flag LocalEpoch;
+
+    /// RetireLists - Objects retired by this thread, bucketed by the epoch
+    /// they were retired in modulo the grace period.
+    std::vector<Retired> RetireLists[3];
+
+    /// BucketEpoch - The epoch whose retirements each bucket currently
+    /// holds.  Epochs are monotonic, so a bucket two or more epochs behind
+    /// the global epoch is safe to free.
+    cas_flag BucketEpoch[3];
+
+    ThreadState *Next;
+
+    ThreadState() : InCritical(0), LocalEpoch(0), Next(0) {
+      BucketEpoch[0] = BucketEpoch[1] = BucketEpoch[2] = 0;
+    }
+  };
+
+  volatile cas_flag GlobalEpoch;
+
+  /// ThreadList - All thread states ever handed out, linked so collectors
+  /// can scan them.  Guarded by RegistryLock; states outlive their threads
+  /// and are freed by the manager destructor.
+  ThreadState *ThreadList;
+  SmartMutex<true> RegistryLock;
+  ThreadLocal<const ThreadState> CurThreadState;
+
+  ThreadState &getThreadState();
+  bool canAdvanceEpoch() const;
+  static unsigned freeList(std::vector<Retired> &List);
+
+  EpochReclamationManager(const EpochReclamationManager &)
+    LLVM_DELETED_FUNCTION;
+  void operator=(const EpochReclamationManager &) LLVM_DELETED_FUNCTION;
+
+public:
+  EpochReclamationManager();
+
+  /// The destructor destroys every object still retired.  No thread may be
+  /// inside a critical region.
+  ~EpochReclamationManager();
+
+  /// enterCriticalRegion - Announce that the calling thread is about to read
+  /// structures whose retired nodes this manager protects.  Objects retired
+  /// from this point on stay allocated until after the matching
+  /// exitCriticalRegion.  Critical regions do not nest.
+  void enterCriticalRegion();
+  void exitCriticalRegion();
+
+  /// retire - Queue an object for destruction once no critical region that
+  /// could reference it remains.  In single-threaded mode the object is
+  /// destroyed before retire returns.
+  void retire(void *Ptr, DeleterTy Deleter);
+
+  /// collect - Advance the global epoch if every thread in a critical region
+  /// has caught up with it, then destroy the calling thread's retirements
+  /// that have aged beyond the grace period.  Safe to call concurrently with
+  /// critical regions on other threads.  Returns the number of objects
+  /// destroyed.
+  unsigned collect();
+
+  /// drain - Destroy every retired object on every thread immediately.  May
+  /// only be called from a quiescent point, i.e. when no thread is inside a
+  /// critical region.  Returns the number of objects destroyed.
+  unsigned drain();
+
+  unsigned getGlobalEpoch() const { return GlobalEpoch; }
+};
+
+} // End sys namespace
+} // End llvm namespace
+
+#endif
@@ -14,6 +14,7 @@
 #ifndef LLVM_SUPPORT_FILEOUTPUTBUFFER_H
 #define LLVM_SUPPORT_FILEOUTPUTBUFFER_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
@@ -34,7 +35,8 @@ class FileOutputBuffer {
 public:
 
   enum  {
-    F_executable = 1  /// set the 'x' bit on the resulting file
+    F_executable = 1, /// set the 'x' bit on the resulting file
+    F_durable    = 2  /// flush buffer contents to the device before committing
   };
 
   /// Factory method to create an OutputBuffer object which manages a read/write
@@ -71,6 +73,14 @@ public:
   /// initially requested.
   error_code commit(int64_t NewSmallerSize = -1);
 
+  /// Commit a group of buffers together.  Writeback is started on every
+  /// durable buffer before waiting on any of them, and all buffers are
+  /// flushed and unmapped before any is renamed to its final path, so the
+  /// device sees one batched flush instead of a serial flush-rename pair per
+  /// file.  Stops at the first error; buffers beyond it are left uncommitted
+  /// and are cleaned up by their destructors as usual.
+  static error_code commitAll(ArrayRef<FileOutputBuffer*> Buffers);
+
   /// If this object was previously committed, the destructor just deletes
   /// this object.  If this object was not committed, the destructor
   /// deallocates the buffer and the target file is never written.
@@ -81,11 +91,12 @@ private:
   FileOutputBuffer &operator=(const FileOutputBuffer &) LLVM_DELETED_FUNCTION;
 
   FileOutputBuffer(llvm::sys::fs::mapped_file_region *R,
-                   StringRef Path, StringRef TempPath);
+                   StringRef Path, StringRef TempPath, bool Durable);
 
   OwningPtr<llvm::sys::fs::mapped_file_region> Region;
   SmallString<128>    FinalPath;
   SmallString<128>    TempPath;
+  bool                Durable;
 };
 } // end namespace llvm
 
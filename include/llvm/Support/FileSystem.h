@@ -650,6 +650,11 @@ public:
   /// behaivor.
   const char *const_data() const;
 
+  /// Flush modified pages of a readwrite mapping to the file on disk.  If
+  /// \a Wait is true, block until the data has reached the device; otherwise
+  /// only schedule the writeback.
+  error_code sync(bool Wait = true) const;
+
   /// \returns The minimum alignment offset must be.
   static int alignment();
 };
@@ -50,6 +50,12 @@ namespace llvm
     ///
     unsigned ColumnScanned;
 
+    /// ColumnTracking - When false, bytes are passed through without being
+    /// scanned for column tracking.  Clients that never use PadToColumn can
+    /// turn this off to avoid paying for a scan of every output byte.
+    ///
+    bool ColumnTracking;
+
     /// Scanned - This points to one past the last character in the
     /// buffer we've scanned.
     ///
@@ -83,11 +89,13 @@ namespace llvm
     /// underneath it.
     ///
     formatted_raw_ostream(raw_ostream &Stream, bool Delete = false) 
-      : raw_ostream(), TheStream(0), DeleteStream(false), ColumnScanned(0) {
+      : raw_ostream(), TheStream(0), DeleteStream(false), ColumnScanned(0),
+        ColumnTracking(true) {
       setStream(Stream, Delete);
     }
     explicit formatted_raw_ostream()
-      : raw_ostream(), TheStream(0), DeleteStream(false), ColumnScanned(0) {
+      : raw_ostream(), TheStream(0), DeleteStream(false), ColumnScanned(0),
+        ColumnTracking(true) {
       Scanned = 0;
     }
 
@@ -117,11 +125,26 @@ namespace llvm
 
     /// PadToColumn - Align the output to some column number.  If the current
     /// column is already equal to or more than NewCol, PadToColumn inserts one
-    /// space.
+    /// space.  If column tracking is disabled, a single space is inserted.
     ///
     /// \param NewCol - The column to move to.
     formatted_raw_ostream &PadToColumn(unsigned NewCol);
 
+    /// setColumnTracking - Enable or disable column tracking.  While
+    /// disabled, output bytes are not scanned and PadToColumn degenerates to
+    /// emitting a single space, so only disable it when no padding is
+    /// needed.  Tracking should be re-enabled at the start of a line, since
+    /// the column of previously written bytes is unknown.
+    void setColumnTracking(bool Enable) {
+      if (Enable && !ColumnTracking) {
+        // Scanning restarts at the current end of the buffer, in column 0.
+        flush();
+        ColumnScanned = 0;
+        Scanned = 0;
+      }
+      ColumnTracking = Enable;
+    }
+
   private:
     void releaseStream() {
       // Delete the stream if needed. Otherwise, transfer the buffer
@@ -190,7 +190,10 @@ public:
   ~GCOVBlock();
   void addEdge(uint32_t N) { Edges.push_back(N); }
   void addLine(StringRef Filename, uint32_t LineNo);
-  void addCount(uint64_t N) { Counter = N; }
+  /// addCount - Accumulate an execution count for this block.  Counts from
+  /// successive .gcda reads add up, so reading many .gcda files into one
+  /// GCOVFile merges their counters.
+  void addCount(uint64_t N) { Counter += N; }
   void dump();
   void collectLineCounts(FileInfo &FI);
 private:
@@ -46,6 +46,21 @@ namespace sys {
   /// code to be loaded into the current process, e.g. when using the JIT.
   std::string getProcessTriple();
 
+  /// getHostNumPhysicalCores - Get the number of physical cores in the host
+  /// machine, not counting the extra logical CPUs that simultaneous
+  /// multithreading exposes.  Parallel workers sized and pinned to physical
+  /// cores avoid both SMT contention and cross-socket migration.
+  ///
+  /// \return - The number of physical cores, or -1 if it cannot be
+  /// determined on this platform.
+  int getHostNumPhysicalCores();
+
+  /// getHostNumLogicalCores - Get the number of logical CPUs that are online
+  /// in the host machine.
+  ///
+  /// \return - The number of logical CPUs, or -1 if it cannot be determined.
+  int getHostNumLogicalCores();
+
   /// getHostCPUName - Get the LLVM name for the host CPU. The particular format
   /// of the name is target dependent, and suitable for passing as -mcpu to the
   /// target which matches the host.
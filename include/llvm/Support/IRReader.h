@@ -98,7 +98,10 @@ namespace llvm {
                              SMDiagnostic &Err,
                              LLVMContext &Context) {
     OwningPtr<MemoryBuffer> File;
-    if (error_code ec = MemoryBuffer::getFileOrSTDIN(Filename.c_str(), File)) {
+    // The whole file is about to be parsed; prefetch it.
+    if (error_code ec = MemoryBuffer::getFileOrSTDIN(Filename.c_str(), File,
+                                                     -1,
+                                                     MemoryBuffer::AccessWillNeed)) {
       Err = SMDiagnostic(Filename, SourceMgr::DK_Error,
                          "Could not open input file: " + ec.message());
       return 0;
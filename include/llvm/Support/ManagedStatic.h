@@ -43,6 +43,11 @@ protected:
   mutable void *Ptr;
   mutable void (*DeleterFn)(void*);
   mutable const ManagedStaticBase *Next;
+  // Per-static creation guard for multithreaded mode: 0 = untouched,
+  // 1 = being created, 2 = fully published.  Claimed with a compare-and-swap
+  // so statics being created on different threads do not serialize on the
+  // global lock.
+  mutable volatile sys::cas_flag InitFlag;
 
   void RegisterManagedStatic(void *(*creator)(), void (*deleter)(void*)) const;
 public:
@@ -60,17 +60,29 @@ public:
     return "Unknown buffer";
   }
 
+  /// AccessPattern - A hint describing how the caller intends to read a
+  /// file-backed buffer.  For memory-mapped buffers this is forwarded to the
+  /// operating system so readahead can start before the first page is
+  /// touched; cold-cache reads otherwise pay a fault per page mid-parse.
+  enum AccessPattern {
+    AccessNormal,     ///< No predictable access pattern (default).
+    AccessSequential, ///< One front-to-back pass; aggressive readahead.
+    AccessWillNeed    ///< The whole buffer will be read soon; prefetch it.
+  };
+
   /// getFile - Open the specified file as a MemoryBuffer, returning a new
   /// MemoryBuffer if successful, otherwise returning null.  If FileSize is
   /// specified, this means that the client knows that the file exists and that
   /// it has the specified size.
   static error_code getFile(StringRef Filename, OwningPtr<MemoryBuffer> &result,
                             int64_t FileSize = -1,
-                            bool RequiresNullTerminator = true);
+                            bool RequiresNullTerminator = true,
+                            AccessPattern Access = AccessNormal);
   static error_code getFile(const char *Filename,
                             OwningPtr<MemoryBuffer> &result,
                             int64_t FileSize = -1,
-                            bool RequiresNullTerminator = true);
+                            bool RequiresNullTerminator = true,
+                            AccessPattern Access = AccessNormal);
 
   /// getOpenFile - Given an already-open file descriptor, read the file and
   /// return a MemoryBuffer.
@@ -79,7 +91,8 @@ public:
                                 uint64_t FileSize = -1,
                                 uint64_t MapSize = -1,
                                 int64_t Offset = 0,
-                                bool RequiresNullTerminator = true);
+                                bool RequiresNullTerminator = true,
+                                AccessPattern Access = AccessNormal);
 
   /// getMemBuffer - Open the specified memory range as a MemoryBuffer.  Note
   /// that InputData must be null terminated if RequiresNullTerminator is true.
@@ -116,10 +129,12 @@ public:
   /// ec.
   static error_code getFileOrSTDIN(StringRef Filename,
                                    OwningPtr<MemoryBuffer> &result,
-                                   int64_t FileSize = -1);
+                                   int64_t FileSize = -1,
+                                   AccessPattern Access = AccessNormal);
   static error_code getFileOrSTDIN(const char *Filename,
                                    OwningPtr<MemoryBuffer> &result,
-                                   int64_t FileSize = -1);
+                                   int64_t FileSize = -1,
+                                   AccessPattern Access = AccessNormal);
   
   
   //===--------------------------------------------------------------------===//
@@ -604,6 +604,21 @@ namespace sys {
       /// MemoryBuffer::getFile instead.
       static void UnMapFilePages(const char *Base, size_t FileSize);
 
+      /// FilePagesAdvice - Access pattern hints for AdviseFilePages.
+      enum FilePagesAdvice {
+        AdviceNormal,     ///< No predictable access pattern.
+        AdviceSequential, ///< One front-to-back pass; aggressive readahead.
+        AdviceWillNeed    ///< Whole range needed soon; prefetch it all.
+      };
+
+      /// AdviseFilePages - Tell the operating system how pages mapped by
+      /// MapInFilePages are about to be accessed so it can prime readahead
+      /// before the first touch.  Base must be the page-aligned address
+      /// MapInFilePages returned.  This is only a hint; on systems without
+      /// madvise it does nothing.
+      static void AdviseFilePages(const char *Base, size_t FileSize,
+                                  FilePagesAdvice Advice);
+
     /// @}
     /// @name Data
     /// @{
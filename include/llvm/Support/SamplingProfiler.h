@@ -0,0 +1,45 @@
+//===- llvm/Support/SamplingProfiler.h - In-process CPU sampler -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a low-overhead, signal-driven CPU sampler that attributes
+// samples to the pass and function currently being executed by the pass
+// manager.  Unlike -time-passes, which brackets every pass with clock reads,
+// sampling only perturbs the compile when a (rare) profiling tick fires, so
+// it can be left enabled on production compiles.  Enabled with the hidden
+// -sample-passes=<hz> option; the profile is printed at shutdown in
+// collapsed-stack format ("pass;function count"), one line per scope.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_SAMPLINGPROFILER_H
+#define LLVM_SUPPORT_SAMPLINGPROFILER_H
+
+#include "llvm/ADT/StringRef.h"
+
+namespace llvm {
+
+/// SamplingProfilerEnabled - Return true if -sample-passes requested a
+/// profile.  Scope markers are cheap no-ops when this is false.
+bool SamplingProfilerEnabled();
+
+/// SamplingScope - RAII marker placed by the pass managers around the
+/// execution of a single pass.  Samples taken while the scope is live are
+/// attributed to the given pass and function; the previous scope is restored
+/// on destruction so nested pass managers attribute correctly.
+class SamplingScope {
+  const char *OldPass;
+  const char *OldUnit;
+public:
+  SamplingScope(const char *PassName, StringRef UnitName);
+  ~SamplingScope();
+};
+
+} // End llvm namespace
+
+#endif
@@ -515,6 +515,14 @@ namespace llvm {
     /// Maintained for compatibility through 2.6.
     static const Target *getClosestTargetForJIT(std::string &Error);
 
+    /// freezeRegistry - Declare that target registration is complete. After
+    /// this call, registering further targets is an error, and triple lookups
+    /// are memoized in a lock-free cache, so repeated TargetMachine creation
+    /// skips the registry walk. Clients that create many targets from
+    /// concurrent threads should call this once after their
+    /// InitializeAll/InitializeNative calls.
+    static void freezeRegistry();
+
     /// @}
     /// @name Target Registration
     /// @{
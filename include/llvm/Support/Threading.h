@@ -54,6 +54,32 @@ namespace llvm {
   /// the thread stack.
   void llvm_execute_on_thread(void (*UserFn)(void*), void *UserData,
                               unsigned RequestedStackSize = 0);
+
+  /// llvm_launch_thread - Start executing the given \p UserFn on a separate
+  /// thread, passing it the provided \p UserData, and return immediately.
+  ///
+  /// Returns an opaque handle which must be passed to llvm_join_thread().  If
+  /// threads are unavailable (or thread creation fails), \p UserFn is executed
+  /// on the calling thread and null is returned; passing null to
+  /// llvm_join_thread() is a no-op, so callers may unconditionally join.
+  ///
+  /// \param RequestedStackSize - If non-zero, a requested size (in bytes) for
+  /// the thread stack.
+  void *llvm_launch_thread(void (*UserFn)(void*), void *UserData,
+                           unsigned RequestedStackSize = 0);
+
+  /// llvm_join_thread - Wait for a thread started with llvm_launch_thread()
+  /// to finish, and release its resources.
+  void llvm_join_thread(void *Thread);
+
+  /// llvm_set_thread_affinity - Pin the calling thread to the given logical
+  /// CPU.  Worker threads created with llvm_launch_thread() should pin
+  /// themselves over the host's physical cores (see
+  /// sys::getHostNumPhysicalCores()) so the scheduler cannot migrate them
+  /// across sockets mid-task.
+  ///
+  /// Returns false if thread affinity is not supported on this platform.
+  bool llvm_set_thread_affinity(unsigned CPU);
 }
 
 #endif
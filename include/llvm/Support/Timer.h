@@ -85,9 +85,17 @@ public:
 class Timer {
   TimeRecord Time;
   std::string Name;      // The name of this time variable.
+  std::string Parent;    // Name of the timer active when this was first
+                         // started, capturing scope nesting (e.g. a module
+                         // pass running function passes).  Empty for
+                         // top-level timers.
+  ssize_t PeakMem;       // Largest number of slab bytes live above the level
+                         // at startTimer() while this timer was running.
+                         // Only maintained under -track-memory.
+  size_t MemBaseline;    // Slab bytes live when this timer last started.
   bool Started;          // Has this time variable ever been started?
   TimerGroup *TG;        // The TimerGroup this Timer is in.
-  
+
   Timer **Prev, *Next;   // Doubly linked list of timers in the group.
 public:
   explicit Timer(StringRef N) : TG(0) { init(N); }
@@ -119,6 +127,13 @@ public:
   ///
   void stopTimer();
 
+  /// trackSlabMemory - Called by the slab allocators whenever a slab is
+  /// acquired, with the new process-wide live slab byte count.  Under
+  /// -track-memory this attributes the high-water mark to every running
+  /// timer, which exposes transient allocation spikes that the start/stop
+  /// malloc sampling cannot see.  A no-op otherwise.
+  static void trackSlabMemory(size_t BytesInUse);
+
 private:
   friend class TimerGroup;
 };
@@ -164,10 +179,22 @@ struct NamedRegionTimer : public TimeRegion {
 /// TimerGroup can be specified for a newly created timer in its constructor.
 ///
 class TimerGroup {
+  struct PrintRecord {
+    TimeRecord Time;
+    std::string Name;
+    std::string Parent;
+    ssize_t PeakMem;
+    PrintRecord() : PeakMem(0) {}
+    PrintRecord(const TimeRecord &T, const std::string &N,
+                const std::string &P, ssize_t PM)
+      : Time(T), Name(N), Parent(P), PeakMem(PM) {}
+    bool operator<(const PrintRecord &RHS) const { return Time < RHS.Time; }
+  };
+
   std::string Name;
   Timer *FirstTimer;   // First timer in the group.
-  std::vector<std::pair<TimeRecord, std::string> > TimersToPrint;
-  
+  std::vector<PrintRecord> TimersToPrint;
+
   TimerGroup **Prev, *Next; // Doubly linked list of TimerGroup's.
   TimerGroup(const TimerGroup &TG) LLVM_DELETED_FUNCTION;
   void operator=(const TimerGroup &TG) LLVM_DELETED_FUNCTION;
@@ -188,6 +215,7 @@ private:
   void addTimer(Timer &T);
   void removeTimer(Timer &T);
   void PrintQueuedTimers(raw_ostream &OS);
+  void printJSONQueuedTimers(raw_ostream &OS);
 };
 
 } // End llvm namespace
@@ -122,6 +122,12 @@ public:
     return OutBufCur - OutBufStart;
   }
 
+  /// reserveExtraSpace - Hint that at least ExtraSize more bytes will be
+  /// written to the stream.  Streams backed by a growable buffer use this to
+  /// allocate their final size in one step instead of growing write by
+  /// write; other streams ignore it.
+  virtual void reserveExtraSpace(uint64_t ExtraSize) {}
+
   //===--------------------------------------------------------------------===//
   // Data Output Interface
   //===--------------------------------------------------------------------===//
@@ -321,9 +327,23 @@ class raw_fd_ostream : public raw_ostream {
 
   uint64_t pos;
 
+  /// AsyncState - Bookkeeping for asynchronous writes: the two flush buffers
+  /// and the pending writer thread.  Null unless EnableAsyncWrites() has been
+  /// called.
+  struct AsyncState;
+  AsyncState *Async;
+
   /// write_impl - See raw_ostream::write_impl.
   virtual void write_impl(const char *Ptr, size_t Size) LLVM_OVERRIDE;
 
+  /// writeSync - Write Size bytes at Ptr to FD on the calling thread,
+  /// retrying partial and interrupted writes.  This is the tail of
+  /// write_impl, split out so the background writer thread can share it.
+  void writeSync(const char *Ptr, size_t Size);
+
+  /// joinAsyncWrite - Wait for any outstanding asynchronous write to finish.
+  void joinAsyncWrite();
+
   /// current_pos - Return the current position within the stream, not
   /// counting the bytes currently in the buffer.
   virtual uint64_t current_pos() const LLVM_OVERRIDE { return pos; }
@@ -349,7 +369,12 @@ public:
 
     /// F_Binary - The file should be opened in binary mode on platforms that
     /// make this distinction.
-    F_Binary = 4
+    F_Binary = 4,
+
+    /// F_Async - Flush buffers to disk on a background writer thread, so the
+    /// producing thread keeps running while the previous buffer is written.
+    /// See EnableAsyncWrites().
+    F_Async = 8
   };
 
   /// raw_fd_ostream - Open the specified file for writing. If an error occurs,
@@ -389,6 +414,16 @@ public:
     UseAtomicWrites = Value;
   }
 
+  /// EnableAsyncWrites - Switch the stream to double-buffered asynchronous
+  /// output: each time the buffer fills, it is handed to a background writer
+  /// thread and the stream continues into a second buffer, so the producer
+  /// does not block in write(2).  flush() still only guarantees the data has
+  /// been handed off; close() and seek() wait for the writer.  This is most
+  /// useful for large outputs on slow filesystems.  It is a no-op after an
+  /// error has been detected, and degrades to synchronous writes when
+  /// threads are unavailable.
+  void EnableAsyncWrites();
+
   virtual raw_ostream &changeColor(enum Colors colors, bool bold=false,
                                    bool bg=false) LLVM_OVERRIDE;
   virtual raw_ostream &resetColor() LLVM_OVERRIDE;
@@ -485,6 +520,10 @@ public:
   /// if the raw_svector_ostream has previously been flushed.
   void resync();
 
+  /// reserveExtraSpace - Grow the target vector to hold ExtraSize more bytes
+  /// up front.
+  virtual void reserveExtraSpace(uint64_t ExtraSize) LLVM_OVERRIDE;
+
   /// str - Flushes the stream contents to the target vector and return a
   /// StringRef for the vector contents.
   StringRef str();
@@ -648,7 +648,7 @@ public:
 /// BitsInit - { a, b, c } - Represents an initializer for a BitsRecTy value.
 /// It contains a vector of bits, whose size is determined by the type.
 ///
-class BitsInit : public Init, public FoldingSetNode {
+class BitsInit : public Init {
   std::vector<Init*> Bits;
 
   BitsInit(ArrayRef<Init *> Range)
@@ -663,8 +663,6 @@ public:
   }
   static BitsInit *get(ArrayRef<Init *> Range);
 
-  void Profile(FoldingSetNodeID &ID) const;
-
   unsigned getNumBits() const { return Bits.size(); }
 
   virtual Init *convertInitializerTo(RecTy *Ty) const {
@@ -777,7 +775,7 @@ public:
 
 /// ListInit - [AL, AH, CL] - Represent a list of defs
 ///
-class ListInit : public TypedInit, public FoldingSetNode {
+class ListInit : public TypedInit {
   std::vector<Init*> Values;
 public:
   typedef std::vector<Init*>::const_iterator const_iterator;
@@ -796,8 +794,6 @@ public:
   }
   static ListInit *get(ArrayRef<Init *> Range, RecTy *EltTy);
 
-  void Profile(FoldingSetNodeID &ID) const;
-
   unsigned getSize() const { return Values.size(); }
   Init *getElement(unsigned i) const {
     assert(i < Values.size() && "List element index out of range!");
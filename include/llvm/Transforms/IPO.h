@@ -49,6 +49,15 @@ ModulePass *createStripDebugDeclarePass();
 // These pass removes unused symbols' debug info.
 ModulePass *createStripDeadDebugInfoPass();
 
+//===----------------------------------------------------------------------===//
+//
+// These passes detach non-essential instruction metadata (debug locations
+// and attachments outside a keep list) into a sidecar before heavy IPO, and
+// reattach the surviving mappings afterwards.
+//
+ModulePass *createMetadataDetachPass();
+ModulePass *createMetadataReattachPass();
+
 //===----------------------------------------------------------------------===//
 /// createConstantMergePass - This function returns a new pass that merges
 /// duplicate global constants together into a single constant that is shared.
@@ -183,6 +192,13 @@ ModulePass *createMergeFunctionsPass();
 /// createPartialInliningPass - This pass inlines parts of functions.
 ///
 ModulePass *createPartialInliningPass();
+
+//===----------------------------------------------------------------------===//
+/// createHotColdSplittingPass - This pass outlines cold regions of hot
+/// functions into separate functions placed in a cold text section, using
+/// ProfileInfo counts when available and static prediction otherwise.
+///
+ModulePass *createHotColdSplittingPass();
   
 //===----------------------------------------------------------------------===//
 // createMetaRenamerPass - Rename everything with metasyntatic names.
@@ -23,6 +23,7 @@ namespace llvm {
   class CallSite;
   class DataLayout;
   class InlineCost;
+  class InlineCostCache;
   template<class PtrType, unsigned SmallSize>
   class SmallPtrSet;
 
@@ -81,9 +82,21 @@ private:
   // InsertLifetime - Insert @llvm.lifetime intrinsics.
   bool InsertLifetime;
 
+  /// CostCache - Memoized inline costs for the SCC currently being
+  /// processed.  Only non-null while runOnSCC is executing.
+  InlineCostCache *CostCache;
+
+  /// InlinedCostTotal - Total estimated cost of all call sites inlined so
+  /// far, charged against -inline-module-budget.
+  int InlinedCostTotal;
+
   /// shouldInline - Return true if the inliner should attempt to
   /// inline at the given CallSite.
   bool shouldInline(CallSite CS);
+
+  /// getCachedInlineCost - Like getInlineCost, but memoizes the result in
+  /// CostCache when one is active.
+  InlineCost getCachedInlineCost(CallSite CS);
 };
 
 } // End llvm namespace
@@ -15,6 +15,7 @@
 #ifndef LLVM_TRANSFORMS_IPO_PASSMANAGERBUILDER_H
 #define LLVM_TRANSFORMS_IPO_PASSMANAGERBUILDER_H
 
+#include <string>
 #include <vector>
 
 namespace llvm {
@@ -100,11 +101,19 @@ public:
   /// added to the per-module passes.
   Pass *Inliner;
 
+  /// ProfileDataFile - If non-empty, a profile dump file (as written by
+  /// -insert-edge-profiling) to load at the start of the per-module passes.
+  /// The measured edge counts are attached to branches as branch weight
+  /// metadata, where they feed branch probability and block frequency
+  /// analyses and ultimately drive machine block placement in codegen.
+  std::string ProfileDataFile;
+
   bool DisableSimplifyLibCalls;
   bool DisableUnitAtATime;
   bool DisableUnrollLoops;
   bool Vectorize;
   bool LoopVectorize;
+  bool SLPVectorize;
 
 private:
   /// ExtensionList - This is list of all of the extensions that are registered.
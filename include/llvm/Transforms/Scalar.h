@@ -150,6 +150,14 @@ Pass *createLoopRotatePass();
 // LoopIdiom - This pass recognizes and replaces idioms in loops.
 //
 Pass *createLoopIdiomPass();
+
+//===----------------------------------------------------------------------===//
+//
+// LoopDataPrefetch - This pass inserts llvm.prefetch intrinsics ahead of
+// strided loads in innermost loops, using SCEV to recognize the strides and
+// TargetTransformInfo for the lookahead distance.
+//
+Pass *createLoopDataPrefetchPass();
   
 //===----------------------------------------------------------------------===//
 //
@@ -288,6 +296,14 @@ FunctionPass *createGVNPass(bool NoLoads = false);
 //
 FunctionPass *createMemCpyOptPass();
 
+//===----------------------------------------------------------------------===//
+//
+// LoadWidening - This pass merges pairs of adjacent narrow integer loads into
+// a single wider load plus shift/truncate sequences where the widened access
+// is provably in bounds and the target considers the wide type legal.
+//
+FunctionPass *createLoadWideningPass();
+
 //===----------------------------------------------------------------------===//
 //
 // LoopDeletion - This pass performs DCE of non-infinite loops that it
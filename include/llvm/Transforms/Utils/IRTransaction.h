@@ -0,0 +1,95 @@
+//===-- IRTransaction.h - Journaled speculative IR mutation -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the IRTransaction class, an undo log for IR mutations.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_UTILS_IRTRANSACTION_H
+#define LLVM_TRANSFORMS_UTILS_IRTRANSACTION_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Compiler.h"
+
+namespace llvm {
+  class Instruction;
+  class Value;
+
+/// IRTransaction - A journal of IR mutations that can be rolled back in time
+/// proportional to the number of changes made.  Passes that transform
+/// speculatively and want to keep the result only if a cost model approves
+/// can apply mutations through a transaction and abort() the losers, instead
+/// of cloning a region up front and deleting the copy that did not pan out.
+///
+/// Only mutations made through the transaction's methods are journaled;
+/// changes made behind its back cannot be undone.  Instructions removed
+/// through the transaction are unlinked from their parent but kept alive
+/// until commit(), so aborting can splice them back where they were.
+/// Undo replays the journal in reverse, which is what makes positions
+/// recorded by earlier entries valid again by the time they are restored.
+class IRTransaction {
+public:
+  /// SavePoint - An opaque position in the journal.  Rolling back to a save
+  /// point undoes everything journaled after it was taken.
+  typedef unsigned SavePoint;
+
+  IRTransaction() {}
+
+  /// An open transaction aborts on destruction, restoring the original IR.
+  /// Call commit() to keep the changes.
+  ~IRTransaction();
+
+  /// setOperand - Set operand Idx of I to V, journaling the old operand.
+  void setOperand(Instruction *I, unsigned Idx, Value *V);
+
+  /// replaceAllUsesWith - Replace all uses of I with V, journaling every
+  /// rewritten use individually so abort can restore them.
+  void replaceAllUsesWith(Instruction *I, Value *V);
+
+  /// moveBefore - Unlink I and insert it before Before, journaling the old
+  /// position.
+  void moveBefore(Instruction *I, Instruction *Before);
+
+  /// insertBefore - Insert the detached (newly created) instruction I before
+  /// Before.  On abort the instruction is removed and deleted.
+  void insertBefore(Instruction *I, Instruction *Before);
+
+  /// remove - Unlink I from its parent, first replacing any remaining uses
+  /// with ReplaceWith if it is non-null.  The instruction stays alive until
+  /// commit() deletes it; abort reinserts it and restores its uses.
+  void remove(Instruction *I, Value *ReplaceWith = 0);
+
+  /// getSavePoint - Return a save point for partial rollback with
+  /// rollbackTo.  Invalidated by commit, abort, or an earlier rollback.
+  SavePoint getSavePoint() const { return Actions.size(); }
+
+  /// rollbackTo - Undo every mutation journaled after SP was taken.
+  void rollbackTo(SavePoint SP);
+
+  /// commit - Accept all journaled mutations, deleting instructions removed
+  /// through the transaction, and empty the journal.
+  void commit();
+
+  /// abort - Undo all journaled mutations in reverse order and empty the
+  /// journal.
+  void abort();
+
+  class Action;
+
+private:
+  IRTransaction(const IRTransaction &) LLVM_DELETED_FUNCTION;
+  void operator=(const IRTransaction &) LLVM_DELETED_FUNCTION;
+
+  /// Actions - The journal, in application order.  Undo walks it backwards.
+  SmallVector<Action*, 16> Actions;
+};
+
+} // End llvm namespace
+
+#endif
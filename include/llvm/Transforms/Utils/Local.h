@@ -259,7 +259,12 @@ bool replaceDbgDeclareForAlloca(AllocaInst *AI, Value *NewAllocaAddress,
 
 /// \brief Remove all blocks that can not be reached from the function's entry.
 ///
-/// Returns true if any basic block was removed.
+/// While computing reachability this also canonicalizes trivially dead code:
+/// code after a no-return call or a store to null/undef becomes unreachable,
+/// and invokes of nounwind callees become calls.  Dead blocks are freed in
+/// bulk rather than one instruction at a time.
+///
+/// Returns true if the function was changed.
 bool removeUnreachableBlocks(Function &F);
 
 } // End llvm namespace
@@ -113,6 +113,12 @@ createBBVectorizePass(const VectorizeConfig &C = VectorizeConfig());
 //
 Pass *createLoopVectorizePass();
 
+//===----------------------------------------------------------------------===//
+//
+// SLPVectorizer - Create a bottom-up SLP vectorizer pass.
+//
+Pass *createSLPVectorizerPass();
+
 //===----------------------------------------------------------------------===//
 /// @brief Vectorize the BasicBlock.
 ///
@@ -74,6 +74,16 @@ void AliasAnalysis::addEscapingUse(Use &U) {
   AA->addEscapingUse(U);
 }
 
+void AliasAnalysis::beginQueryBatch() {
+  assert(AA && "AA didn't call InitializeAliasAnalysis in its run method!");
+  AA->beginQueryBatch();
+}
+
+void AliasAnalysis::endQueryBatch() {
+  assert(AA && "AA didn't call InitializeAliasAnalysis in its run method!");
+  AA->endQueryBatch();
+}
+
 
 AliasAnalysis::ModRefResult
 AliasAnalysis::getModRefInfo(ImmutableCallSite CS,
@@ -13,6 +13,7 @@
 
 #include "llvm/Analysis/AliasSetTracker.h"
 #include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/Assembly/Writer.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Instructions.h"
@@ -64,6 +65,12 @@ void AliasSet::mergeSetIn(AliasSet &AS, AliasSetTracker &AST) {
     AS.UnknownInsts.clear();
   }
 
+  // Merge the underlying object summaries.
+  HasUnknownObject |= AS.HasUnknownObject;
+  UnderlyingObjects.insert(AS.UnderlyingObjects.begin(),
+                           AS.UnderlyingObjects.end());
+  AS.UnderlyingObjects.clear();
+
   AS.Forward = this;  // Forward across AS now...
   addRef();           // AS is now pointing to us...
 
@@ -114,6 +121,7 @@ void AliasSet::addPointer(AliasSetTracker &AST, PointerRec &Entry,
 
   Entry.setAliasSet(this);
   Entry.updateSizeAndTBAAInfo(Size, TBAAInfo);
+  addUnderlyingObject(GetUnderlyingObject(Entry.getValue()));
 
   // Add it to the end of the list...
   assert(*PtrListEnd == 0 && "End of list is not null?");
@@ -123,6 +131,13 @@ void AliasSet::addPointer(AliasSetTracker &AST, PointerRec &Entry,
   addRef();               // Entry points to alias set.
 }
 
+void AliasSet::addUnderlyingObject(const Value *Obj) {
+  if (isIdentifiedObject(Obj))
+    UnderlyingObjects.insert(Obj);
+  else
+    HasUnknownObject = true;
+}
+
 void AliasSet::addUnknownInst(Instruction *I, AliasAnalysis &AA) {
   UnknownInsts.push_back(I);
 
@@ -218,9 +233,17 @@ void AliasSetTracker::clear() {
 AliasSet *AliasSetTracker::findAliasSetForPointer(const Value *Ptr,
                                                   uint64_t Size,
                                                   const MDNode *TBAAInfo) {
+  // If Ptr is based on a distinct identified object, every set whose pointers
+  // are all based on other identified objects can be skipped with a hash
+  // probe instead of a round of alias queries.
+  const Value *Obj = GetUnderlyingObject(const_cast<Value*>(Ptr));
+  bool IdentifiedBase = isIdentifiedObject(Obj);
+
   AliasSet *FoundSet = 0;
   for (iterator I = begin(), E = end(); I != E; ++I) {
-    if (I->Forward || !I->aliasesPointer(Ptr, Size, TBAAInfo, AA)) continue;
+    if (I->Forward) continue;
+    if (IdentifiedBase && !I->mayAliasObject(Obj)) continue;
+    if (!I->aliasesPointer(Ptr, Size, TBAAInfo, AA)) continue;
     
     if (FoundSet == 0) {  // If this is the first alias set ptr can go into.
       FoundSet = I;       // Remember it.
@@ -237,9 +260,14 @@ AliasSet *AliasSetTracker::findAliasSetForPointer(const Value *Ptr,
 /// alias sets.
 bool AliasSetTracker::containsPointer(Value *Ptr, uint64_t Size,
                                       const MDNode *TBAAInfo) const {
-  for (const_iterator I = begin(), E = end(); I != E; ++I)
-    if (!I->Forward && I->aliasesPointer(Ptr, Size, TBAAInfo, AA))
+  const Value *Obj = GetUnderlyingObject(Ptr);
+  bool IdentifiedBase = isIdentifiedObject(Obj);
+  for (const_iterator I = begin(), E = end(); I != E; ++I) {
+    if (I->Forward) continue;
+    if (IdentifiedBase && !I->mayAliasObject(Obj)) continue;
+    if (I->aliasesPointer(Ptr, Size, TBAAInfo, AA))
       return true;
+  }
   return false;
 }
 
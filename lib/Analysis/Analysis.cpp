@@ -63,6 +63,7 @@ void llvm::initializeAnalysis(PassRegistry &Registry) {
   initializeProfileVerifierPassPass(Registry);
   initializePathProfileVerifierPass(Registry);
   initializeProfileMetadataLoaderPassPass(Registry);
+  initializeRPOTraversalPass(Registry);
   initializeRegionInfoPass(Registry);
   initializeRegionViewerPass(Registry);
   initializeRegionPrinterPass(Registry);
@@ -43,28 +43,40 @@ using namespace llvm;
 //===----------------------------------------------------------------------===//
 
 /// isNonEscapingLocalObject - Return true if the pointer is to a function-local
-/// object that never escapes from the function.
-static bool isNonEscapingLocalObject(const Value *V) {
-  // If this is a local allocation, check to see if it escapes.
-  if (isa<AllocaInst>(V) || isNoAliasCall(V))
-    // Set StoreCaptures to True so that we can assume in our callers that the
-    // pointer is not the result of a load instruction. Currently
-    // PointerMayBeCaptured doesn't have any special analysis for the
-    // StoreCaptures=false case; if it did, our callers could be refined to be
-    // more precise.
-    return !PointerMayBeCaptured(V, false, /*StoreCaptures=*/true);
-
-  // If this is an argument that corresponds to a byval or noalias argument,
-  // then it has not escaped before entering the function.  Check if it escapes
-  // inside the function.
-  if (const Argument *A = dyn_cast<Argument>(V))
-    if (A->hasByValAttr() || A->hasNoAliasAttr())
+/// object that never escapes from the function.  If CaptureCache is non-null,
+/// capture walks are memoized in it; the caller is responsible for dropping
+/// entries that a transformation may have invalidated.
+static bool isNonEscapingLocalObject(const Value *V,
+                            SmallDenseMap<const Value*, bool, 8> *CaptureCache) {
+  // A local allocation has not escaped before entering the function.  Neither
+  // has an argument that corresponds to a byval or noalias argument.
+  bool IsLocal = isa<AllocaInst>(V) || isNoAliasCall(V);
+  if (!IsLocal)
+    if (const Argument *A = dyn_cast<Argument>(V))
       // Note even if the argument is marked nocapture we still need to check
       // for copies made inside the function. The nocapture attribute only
       // specifies that there are no copies made that outlive the function.
-      return !PointerMayBeCaptured(V, false, /*StoreCaptures=*/true);
+      IsLocal = A->hasByValAttr() || A->hasNoAliasAttr();
+  if (!IsLocal)
+    return false;
 
-  return false;
+  if (CaptureCache) {
+    SmallDenseMap<const Value*, bool, 8>::iterator I = CaptureCache->find(V);
+    if (I != CaptureCache->end())
+      return I->second;
+  }
+
+  // Check to see if the object escapes inside the function.
+  // Set StoreCaptures to True so that we can assume in our callers that the
+  // pointer is not the result of a load instruction. Currently
+  // PointerMayBeCaptured doesn't have any special analysis for the
+  // StoreCaptures=false case; if it did, our callers could be refined to be
+  // more precise.
+  bool Ret = !PointerMayBeCaptured(V, false, /*StoreCaptures=*/true);
+
+  if (CaptureCache)
+    (*CaptureCache)[V] = Ret;
+  return Ret;
 }
 
 /// isEscapeSource - Return true if the pointer is one which would have
@@ -428,7 +440,7 @@ namespace {
   /// BasicAliasAnalysis - This is the primary alias analysis implementation.
   struct BasicAliasAnalysis : public ImmutablePass, public AliasAnalysis {
     static char ID; // Class identification, replacement for typeinfo
-    BasicAliasAnalysis() : ImmutablePass(ID) {
+    BasicAliasAnalysis() : ImmutablePass(ID), BatchDepth(0) {
       initializeBasicAliasAnalysisPass(*PassRegistry::getPassRegistry());
     }
 
@@ -443,11 +455,16 @@ namespace {
 
     virtual AliasResult alias(const Location &LocA,
                               const Location &LocB) {
-      assert(AliasCache.empty() && "AliasCache must be cleared after use!");
+      assert((BatchDepth || AliasCache.empty()) &&
+             "AliasCache must be cleared after use!");
       assert(notDifferentParent(LocA.Ptr, LocB.Ptr) &&
              "BasicAliasAnalysis doesn't support interprocedural queries.");
       AliasResult Alias = aliasCheck(LocA.Ptr, LocA.Size, LocA.TBAATag,
                                      LocB.Ptr, LocB.Size, LocB.TBAATag);
+      // Inside a query batch the cache persists across queries, memoizing
+      // results until the client ends the batch.
+      if (BatchDepth)
+        return Alias;
       // AliasCache rarely has more than 1 or 2 elements, always use
       // shrink_and_clear so it quickly returns to the inline capacity of the
       // SmallDenseMap if it ever grows larger.
@@ -477,6 +494,17 @@ namespace {
     /// For use when the call site is not known.
     virtual ModRefBehavior getModRefBehavior(const Function *F);
 
+    /// While a query batch is active, alias results and GEP decompositions
+    /// are memoized, so announced value deletions must invalidate them.
+    virtual void beginQueryBatch();
+    virtual void endQueryBatch();
+    virtual void deleteValue(Value *V);
+
+    /// addEscapingUse - A new escaping use can turn a memoized "does not
+    /// escape" capture result stale, so conservatively drop the capture
+    /// cache.
+    virtual void addEscapingUse(Use &U);
+
     /// getAdjustedAnalysisPointer - This method is used when a pass implements
     /// an analysis interface through multiple inheritance.  If needed, it
     /// should override this to adjust the this pointer as needed for the
@@ -488,14 +516,53 @@ namespace {
     }
     
   private:
-    // AliasCache - Track alias queries to guard against recursion.
+    // AliasCache - Track alias queries to guard against recursion.  While a
+    // query batch is active it doubles as a persistent memoization table.
     typedef std::pair<Location, Location> LocPair;
     typedef SmallDenseMap<LocPair, AliasResult, 8> AliasCacheTy;
     AliasCacheTy AliasCache;
 
+    // BatchDepth - Nesting depth of active query batches; zero when the
+    // caches are per-query only.
+    unsigned BatchDepth;
+
+    // CacheIndex - Maps a value to the cached alias pairs it participates in,
+    // so deleteValue can invalidate exactly the affected entries.  Only
+    // maintained while a query batch is active.
+    typedef DenseMap<const Value*, std::vector<LocPair> > CacheIndexTy;
+    CacheIndexTy CacheIndex;
+
+    // DecompCache - Memoized GEP decompositions, maintained while a query
+    // batch is active so repeated queries against the same pointer don't
+    // re-walk its use-def chain.
+    struct DecompEntry {
+      const Value *Base;
+      int64_t BaseOffs;
+      SmallVector<VariableGEPIndex, 4> VarIndices;
+    };
+    typedef DenseMap<const Value*, DecompEntry> DecompCacheTy;
+    DecompCacheTy DecompCache;
+
+    // DecompIndex - Maps a value to the decomposition cache keys whose
+    // entries refer to it, for invalidation by deleteValue.
+    typedef DenseMap<const Value*, std::vector<const Value*> > DecompIndexTy;
+    DecompIndexTy DecompIndex;
+
+    // CaptureCache - Memoized capture walks for function-local objects,
+    // maintained while a query batch is active.  The capture walk is the most
+    // expensive predicate evaluated here, and batched clients ask about the
+    // same handful of underlying objects over and over.
+    typedef SmallDenseMap<const Value*, bool, 8> CaptureCacheTy;
+    CaptureCacheTy CaptureCache;
+
     // Visited - Track instructions visited by pointsToConstantMemory.
     SmallPtrSet<const Value*, 16> Visited;
 
+    /// decomposeGEP - Wrapper around DecomposeGEPExpression that memoizes
+    /// the decomposition while a query batch is active.
+    const Value *decomposeGEP(const Value *V, int64_t &BaseOffs,
+                              SmallVectorImpl<VariableGEPIndex> &VarIndices);
+
     // aliasGEP - Provide a bunch of ad-hoc rules to disambiguate a GEP
     // instruction against another.
     AliasResult aliasGEP(const GEPOperator *V1, uint64_t V1Size,
@@ -539,6 +606,93 @@ ImmutablePass *llvm::createBasicAliasAnalysisPass() {
   return new BasicAliasAnalysis();
 }
 
+void BasicAliasAnalysis::beginQueryBatch() {
+  assert((BatchDepth || AliasCache.empty()) &&
+         "AliasCache must be cleared after use!");
+  ++BatchDepth;
+  AliasAnalysis::beginQueryBatch();
+}
+
+void BasicAliasAnalysis::endQueryBatch() {
+  assert(BatchDepth && "endQueryBatch without a matching beginQueryBatch!");
+  if (--BatchDepth == 0) {
+    AliasCache.shrink_and_clear();
+    CacheIndex.clear();
+    DecompCache.clear();
+    DecompIndex.clear();
+    CaptureCache.clear();
+  }
+  AliasAnalysis::endQueryBatch();
+}
+
+void BasicAliasAnalysis::deleteValue(Value *V) {
+  if (BatchDepth) {
+    // Drop every memoized alias result the value participates in.
+    CacheIndexTy::iterator CI = CacheIndex.find(V);
+    if (CI != CacheIndex.end()) {
+      for (unsigned i = 0, e = CI->second.size(); i != e; ++i)
+        AliasCache.erase(CI->second[i]);
+      CacheIndex.erase(CI);
+    }
+
+    // Likewise for decompositions that refer to it.
+    DecompIndexTy::iterator DI = DecompIndex.find(V);
+    if (DI != DecompIndex.end()) {
+      for (unsigned i = 0, e = DI->second.size(); i != e; ++i)
+        DecompCache.erase(DI->second[i]);
+      DecompIndex.erase(DI);
+    }
+
+    // Deleting an instruction can only remove captures, so memoized capture
+    // results for other objects stay conservatively correct; only the entry
+    // for the value itself has to go.
+    CaptureCache.erase(V);
+  }
+  AliasAnalysis::deleteValue(V);
+}
+
+void BasicAliasAnalysis::addEscapingUse(Use &U) {
+  // The new use may capture any object the used value is reachable from, and
+  // the capture walk traverses phis and selects that GetUnderlyingObject does
+  // not look through, so there is no way to pin down which cached objects are
+  // affected.  Escaping-use notifications are rare; just start over.
+  if (BatchDepth)
+    CaptureCache.clear();
+  AliasAnalysis::addEscapingUse(U);
+}
+
+/// decomposeGEP - Decompose V into a base pointer with a constant offset and
+/// a list of scaled variable indices.  While a query batch is active the
+/// decomposition is memoized, since batched clients typically query the same
+/// pointer against many others.
+const Value *
+BasicAliasAnalysis::decomposeGEP(const Value *V, int64_t &BaseOffs,
+                              SmallVectorImpl<VariableGEPIndex> &VarIndices) {
+  VarIndices.clear();
+  if (!BatchDepth)
+    return DecomposeGEPExpression(V, BaseOffs, VarIndices, TD);
+
+  DecompCacheTy::iterator I = DecompCache.find(V);
+  if (I == DecompCache.end()) {
+    DecompEntry &E = DecompCache[V];
+    E.Base = DecomposeGEPExpression(V, E.BaseOffs, E.VarIndices, TD);
+
+    // Index the entry under every value it refers to, so deleteValue can
+    // find it.
+    DecompIndex[V].push_back(V);
+    if (E.Base != V)
+      DecompIndex[E.Base].push_back(V);
+    for (unsigned i = 0, e = E.VarIndices.size(); i != e; ++i)
+      DecompIndex[E.VarIndices[i].V].push_back(V);
+
+    I = DecompCache.find(V);
+  }
+
+  BaseOffs = I->second.BaseOffs;
+  VarIndices.append(I->second.VarIndices.begin(), I->second.VarIndices.end());
+  return I->second.Base;
+}
+
 /// pointsToConstantMemory - Returns whether the given pointer value
 /// points to memory that is local to the function, with global constants being
 /// considered local to all functions.
@@ -671,7 +825,7 @@ BasicAliasAnalysis::getModRefInfo(ImmutableCallSite CS,
   // then the call can not mod/ref the pointer unless the call takes the pointer
   // as an argument, and itself doesn't capture it.
   if (!isa<Constant>(Object) && CS.getInstruction() != Object &&
-      isNonEscapingLocalObject(Object)) {
+      isNonEscapingLocalObject(Object, BatchDepth ? &CaptureCache : 0)) {
     bool PassedAsArg = false;
     unsigned ArgNo = 0;
     for (ImmutableCallSite::arg_iterator CI = CS.arg_begin(), CE = CS.arg_end();
@@ -864,9 +1018,9 @@ BasicAliasAnalysis::aliasGEP(const GEPOperator *GEP1, uint64_t V1Size,
         int64_t GEP2BaseOffset;
         SmallVector<VariableGEPIndex, 4> GEP2VariableIndices;
         const Value *GEP2BasePtr =
-          DecomposeGEPExpression(GEP2, GEP2BaseOffset, GEP2VariableIndices, TD);
+          decomposeGEP(GEP2, GEP2BaseOffset, GEP2VariableIndices);
         const Value *GEP1BasePtr =
-          DecomposeGEPExpression(GEP1, GEP1BaseOffset, GEP1VariableIndices, TD);
+          decomposeGEP(GEP1, GEP1BaseOffset, GEP1VariableIndices);
         // DecomposeGEPExpression and GetUnderlyingObject should return the
         // same result except when DecomposeGEPExpression has no DataLayout.
         if (GEP1BasePtr != UnderlyingV1 || GEP2BasePtr != UnderlyingV2) {
@@ -894,12 +1048,12 @@ BasicAliasAnalysis::aliasGEP(const GEPOperator *GEP1, uint64_t V1Size,
     // exactly, see if the computed offset from the common pointer tells us
     // about the relation of the resulting pointer.
     const Value *GEP1BasePtr =
-      DecomposeGEPExpression(GEP1, GEP1BaseOffset, GEP1VariableIndices, TD);
-    
+      decomposeGEP(GEP1, GEP1BaseOffset, GEP1VariableIndices);
+
     int64_t GEP2BaseOffset;
     SmallVector<VariableGEPIndex, 4> GEP2VariableIndices;
     const Value *GEP2BasePtr =
-      DecomposeGEPExpression(GEP2, GEP2BaseOffset, GEP2VariableIndices, TD);
+      decomposeGEP(GEP2, GEP2BaseOffset, GEP2VariableIndices);
     
     // DecomposeGEPExpression and GetUnderlyingObject should return the
     // same result except when DecomposeGEPExpression has no DataLayout.
@@ -934,8 +1088,8 @@ BasicAliasAnalysis::aliasGEP(const GEPOperator *GEP1, uint64_t V1Size,
       return R;
 
     const Value *GEP1BasePtr =
-      DecomposeGEPExpression(GEP1, GEP1BaseOffset, GEP1VariableIndices, TD);
-    
+      decomposeGEP(GEP1, GEP1BaseOffset, GEP1VariableIndices);
+
     // DecomposeGEPExpression and GetUnderlyingObject should return the
     // same result except when DecomposeGEPExpression has no DataLayout.
     if (GEP1BasePtr != UnderlyingV1) {
@@ -1196,9 +1350,11 @@ BasicAliasAnalysis::aliasCheck(const Value *V1, uint64_t V1Size,
     // temporary store the nocapture argument's value in a temporary memory
     // location if that memory location doesn't escape. Or it may pass a
     // nocapture value to other functions as long as they don't capture it.
-    if (isEscapeSource(O1) && isNonEscapingLocalObject(O2))
+    if (isEscapeSource(O1) &&
+        isNonEscapingLocalObject(O2, BatchDepth ? &CaptureCache : 0))
       return NoAlias;
-    if (isEscapeSource(O2) && isNonEscapingLocalObject(O1))
+    if (isEscapeSource(O2) &&
+        isNonEscapingLocalObject(O1, BatchDepth ? &CaptureCache : 0))
       return NoAlias;
   }
 
@@ -1220,6 +1376,14 @@ BasicAliasAnalysis::aliasCheck(const Value *V1, uint64_t V1Size,
   if (!Pair.second)
     return Pair.first->second;
 
+  // During a query batch the cache outlives this query, so remember which
+  // values each entry is keyed on for invalidation by deleteValue.
+  if (BatchDepth) {
+    CacheIndex[Locs.first.Ptr].push_back(Locs);
+    if (Locs.first.Ptr != Locs.second.Ptr)
+      CacheIndex[Locs.second.Ptr].push_back(Locs);
+  }
+
   // FIXME: This isn't aggressively handling alias(GEP, PHI) for example: if the
   // GEP can't simplify, we don't even look at the PHI cases.
   if (!isa<GEPOperator>(V1) && isa<GEPOperator>(V2)) {
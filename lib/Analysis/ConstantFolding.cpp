@@ -878,6 +878,80 @@ Constant *llvm::ConstantFoldConstantExpression(const ConstantExpr *CE,
   return ConstantFoldInstOperands(CE->getOpcode(), CE->getType(), Ops, TD, TLI);
 }
 
+/// ConstantFoldVectorFPBinop - Fold a floating point binary operator over two
+/// ConstantDataVectors with native host arithmetic instead of going through
+/// APFloat element by element.  Native IEEE arithmetic produces the same bits
+/// as APFloat for the ordinary cases; anything exceptional (invalid, overflow,
+/// underflow, division by zero) is detected with the same fenv guard that
+/// ConstantFoldFP already relies on and deferred to the APFloat path, as are
+/// NaN inputs, whose payload propagation is host-specific.  Returns null to
+/// request the generic path.
+static Constant *ConstantFoldVectorFPBinop(unsigned Opcode, Constant *LHS,
+                                           Constant *RHS) {
+#if defined(__FLT_EVAL_METHOD__) && __FLT_EVAL_METHOD__ != 0
+  // Hosts that evaluate in extended precision (classic x87) would double
+  // round; leave everything to APFloat there.
+  return 0;
+#else
+  ConstantDataVector *L = dyn_cast<ConstantDataVector>(LHS);
+  ConstantDataVector *R = dyn_cast<ConstantDataVector>(RHS);
+  if (!L || !R)
+    return 0;
+
+  Type *EltTy = L->getElementType();
+  if (!EltTy->isFloatTy() && !EltTy->isDoubleTy())
+    return 0;
+
+  unsigned NumElts = L->getNumElements();
+  LLVMContext &Context = L->getContext();
+  sys::llvm_fenv_clearexcept();
+
+  if (EltTy->isFloatTy()) {
+    SmallVector<float, 16> Elts(NumElts);
+    for (unsigned i = 0; i != NumElts; ++i) {
+      float A = L->getElementAsFloat(i), B = R->getElementAsFloat(i);
+      if (A != A || B != B) {  // NaN input.
+        sys::llvm_fenv_clearexcept();
+        return 0;
+      }
+      switch (Opcode) {
+      default: return 0;
+      case Instruction::FAdd: Elts[i] = A + B; break;
+      case Instruction::FSub: Elts[i] = A - B; break;
+      case Instruction::FMul: Elts[i] = A * B; break;
+      case Instruction::FDiv: Elts[i] = A / B; break;
+      }
+    }
+    if (sys::llvm_fenv_testexcept()) {
+      sys::llvm_fenv_clearexcept();
+      return 0;
+    }
+    return ConstantDataVector::get(Context, Elts);
+  }
+
+  SmallVector<double, 16> Elts(NumElts);
+  for (unsigned i = 0; i != NumElts; ++i) {
+    double A = L->getElementAsDouble(i), B = R->getElementAsDouble(i);
+    if (A != A || B != B) {  // NaN input.
+      sys::llvm_fenv_clearexcept();
+      return 0;
+    }
+    switch (Opcode) {
+    default: return 0;
+    case Instruction::FAdd: Elts[i] = A + B; break;
+    case Instruction::FSub: Elts[i] = A - B; break;
+    case Instruction::FMul: Elts[i] = A * B; break;
+    case Instruction::FDiv: Elts[i] = A / B; break;
+    }
+  }
+  if (sys::llvm_fenv_testexcept()) {
+    sys::llvm_fenv_clearexcept();
+    return 0;
+  }
+  return ConstantDataVector::get(Context, Elts);
+#endif
+}
+
 /// ConstantFoldInstOperands - Attempt to constant fold an instruction with the
 /// specified opcode and operands.  If successful, the constant result is
 /// returned, if not, null is returned.  Note that this function can fail when
@@ -898,6 +972,9 @@ Constant *llvm::ConstantFoldInstOperands(unsigned Opcode, Type *DestTy,
       if (Constant *C = SymbolicallyEvaluateBinop(Opcode, Ops[0], Ops[1], TD))
         return C;
 
+    if (Constant *C = ConstantFoldVectorFPBinop(Opcode, Ops[0], Ops[1]))
+      return C;
+
     return ConstantExpr::get(Opcode, Ops[0], Ops[1]);
   }
 
@@ -18,6 +18,7 @@
 #define DEBUG_TYPE "cgscc-passmgr"
 #include "llvm/Analysis/CallGraphSCCPass.h"
 #include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/IR/Function.h"
@@ -96,9 +97,11 @@ private:
   
   bool RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
                     CallGraph &CG, bool &CallGraphUpToDate,
-                    bool &DevirtualizedCall);
+                    bool &DevirtualizedCall,
+                    SmallPtrSet<Function*, 8> &DirtyFunctions);
   bool RefreshCallGraph(CallGraphSCC &CurSCC, CallGraph &CG,
-                        bool IsCheckingMode);
+                        bool IsCheckingMode,
+                        const SmallPtrSet<Function*, 8> *DirtyFunctions = 0);
 };
 
 } // end anonymous namespace.
@@ -108,14 +111,17 @@ char CGPassManager::ID = 0;
 
 bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
                                  CallGraph &CG, bool &CallGraphUpToDate,
-                                 bool &DevirtualizedCall) {
+                                 bool &DevirtualizedCall,
+                                 SmallPtrSet<Function*, 8> &DirtyFunctions) {
   bool Changed = false;
   PMDataManager *PM = P->getAsPMDataManager();
 
   if (PM == 0) {
     CallGraphSCCPass *CGSP = (CallGraphSCCPass*)P;
     if (!CallGraphUpToDate) {
-      DevirtualizedCall |= RefreshCallGraph(CurSCC, CG, false);
+      DevirtualizedCall |= RefreshCallGraph(CurSCC, CG, false,
+                                            &DirtyFunctions);
+      DirtyFunctions.clear();
       CallGraphUpToDate = true;
     }
 
@@ -139,13 +145,18 @@ bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
          "Invalid CGPassManager member");
   FPPassManager *FPP = (FPPassManager*)P;
   
-  // Run pass P on all functions in the current SCC.
+  // Run pass P on all functions in the current SCC.  Remember which functions
+  // were actually modified: a FunctionPass only mutates the function it runs
+  // on, so any later call graph refresh can limit its body re-scan to these.
   for (CallGraphSCC::iterator I = CurSCC.begin(), E = CurSCC.end();
        I != E; ++I) {
     if (Function *F = (*I)->getFunction()) {
       dumpPassInfo(P, EXECUTION_MSG, ON_FUNCTION_MSG, F->getName());
       TimeRegion PassTimer(getPassTimer(FPP));
-      Changed |= FPP->runOnFunction(*F);
+      if (FPP->runOnFunction(*F)) {
+        Changed = true;
+        DirtyFunctions.insert(F);
+      }
     }
   }
   
@@ -170,8 +181,15 @@ bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
 /// a function pass like GVN optimizes away stuff feeding the indirect call.
 /// This never happens in checking mode.
 ///
+/// If DirtyFunctions is non-null, it is the set of functions the function
+/// passes actually modified, and the scan is restricted to those: an
+/// unmodified function's call sites are still in sync with its callgraph
+/// node.  Checking mode always scans everything since CallGraphSCC passes
+/// may touch any function in the SCC.
+///
 bool CGPassManager::RefreshCallGraph(CallGraphSCC &CurSCC,
-                                     CallGraph &CG, bool CheckingMode) {
+                                     CallGraph &CG, bool CheckingMode,
+                                  const SmallPtrSet<Function*, 8> *DirtyFunctions) {
   DenseMap<Value*, CallGraphNode*> CallSites;
   
   DEBUG(dbgs() << "CGSCCPASSMGR: Refreshing SCC with " << CurSCC.size()
@@ -191,7 +209,8 @@ bool CGPassManager::RefreshCallGraph(CallGraphSCC &CurSCC,
     CallGraphNode *CGN = *SCCIdx;
     Function *F = CGN->getFunction();
     if (F == 0 || F->isDeclaration()) continue;
-    
+    if (DirtyFunctions && !DirtyFunctions->count(F)) continue;
+
     // Walk the function body looking for call sites.  Sync up the call sites in
     // CGN with those actually in the function.
 
@@ -376,6 +395,11 @@ bool CGPassManager::RunAllPassesOnSCC(CallGraphSCC &CurSCC, CallGraph &CG,
   // the callgraph when we need to run a CGSCCPass again.
   bool CallGraphUpToDate = true;
 
+  // DirtyFunctions - The functions modified by function passes since the last
+  // refresh; only these need their bodies re-scanned when the callgraph is
+  // brought back up to date.
+  SmallPtrSet<Function*, 8> DirtyFunctions;
+
   // Run all passes on current SCC.
   for (unsigned PassNo = 0, e = getNumContainedPasses();
        PassNo != e; ++PassNo) {
@@ -402,7 +426,8 @@ bool CGPassManager::RunAllPassesOnSCC(CallGraphSCC &CurSCC, CallGraph &CG,
     
     // Actually run this pass on the current SCC.
     Changed |= RunPassOnSCC(P, CurSCC, CG,
-                            CallGraphUpToDate, DevirtualizedCall);
+                            CallGraphUpToDate, DevirtualizedCall,
+                            DirtyFunctions);
     
     if (Changed)
       dumpPassInfo(P, MODIFICATION_MSG, ON_CG_MSG, "");
@@ -417,7 +442,7 @@ bool CGPassManager::RunAllPassesOnSCC(CallGraphSCC &CurSCC, CallGraph &CG,
   // If the callgraph was left out of date (because the last pass run was a
   // functionpass), refresh it before we move on to the next SCC.
   if (!CallGraphUpToDate)
-    DevirtualizedCall |= RefreshCallGraph(CurSCC, CG, false);
+    DevirtualizedCall |= RefreshCallGraph(CurSCC, CG, false, &DirtyFunctions);
   return Changed;
 }
 
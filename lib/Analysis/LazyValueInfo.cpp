@@ -14,8 +14,10 @@
 
 #define DEBUG_TYPE "lazy-value-info"
 #include "llvm/Analysis/LazyValueInfo.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Analysis/ConstantFolding.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Constants.h"
@@ -314,20 +316,43 @@ namespace {
   /// LazyValueInfoCache - This is the cache kept by LazyValueInfo which
   /// maintains information about queries across the clients' queries.
   class LazyValueInfoCache {
+    /// CacheEntry - A cached lattice value, stamped with the epoch of the
+    /// block it was computed in.  An entry whose stamp is older than its
+    /// block's current epoch is stale and is treated as missing; it is
+    /// overwritten in place the next time the (value, block) pair is
+    /// touched.
+    struct CacheEntry {
+      unsigned Epoch;
+      LVILatticeVal Val;
+      CacheEntry() : Epoch(0) {}
+    };
+
     /// ValueCacheEntryTy - This is all of the cached block information for
     /// exactly one Value*.  The entries are sorted by the BasicBlock* of the
-    /// entries, allowing us to do a lookup with a binary search.
-    typedef std::map<AssertingVH<BasicBlock>, LVILatticeVal> ValueCacheEntryTy;
+    /// entries, allowing us to do a lookup with a binary search.  The keys
+    /// are plain pointers rather than value handles: entries for an erased
+    /// block are left behind as stale epochs and never looked at again, so
+    /// clients must call eraseBlock before deleting a block (which the
+    /// asserting handles previously enforced).
+    typedef std::map<BasicBlock*, CacheEntry> ValueCacheEntryTy;
 
     /// ValueCache - This is all of the cached information for all values,
     /// mapped from Value* to key information.
     std::map<LVIValueHandle, ValueCacheEntryTy> ValueCache;
-    
-    /// OverDefinedCache - This tracks, on a per-block basis, the set of 
-    /// values that are over-defined at the end of that block.  This is required
-    /// for cache updating.
-    typedef std::pair<AssertingVH<BasicBlock>, Value*> OverDefinedPairTy;
-    DenseSet<OverDefinedPairTy> OverDefinedCache;
+
+    /// OverDefinedCache - This tracks, per basic block, the set of values
+    /// that are over-defined at the end of that block.  This is required for
+    /// cache updating.  Keeping the markers grouped by block lets threadEdge
+    /// and the value-deleted callback touch only the blocks involved instead
+    /// of scanning every (block, value) pair ever recorded.
+    typedef SmallPtrSet<Value*, 4> OverDefinedSetTy;
+    DenseMap<AssertingVH<BasicBlock>, OverDefinedSetTy> OverDefinedCache;
+
+    /// BlockEpochs - The current epoch of every block that has ever been
+    /// invalidated.  eraseBlock just bumps the block's epoch instead of
+    /// walking the per-value maps, so invalidating one region stays cheap
+    /// no matter how much of the function is cached.
+    DenseMap<BasicBlock*, unsigned> BlockEpochs;
 
     /// SeenBlocks - Keep track of all blocks that we have ever seen, so we
     /// don't spend time removing unused blocks from our caches.
@@ -352,9 +377,9 @@ namespace {
                        LazyValueInfoCache *P)
         : Parent(P), Val(V), BB(B), BBLV(LV) { }
       
-      bool markResult(bool changed) { 
+      bool markResult(bool changed) {
         if (changed && BBLV.isOverdefined())
-          Parent->OverDefinedCache.insert(std::make_pair(BB, Val));
+          Parent->OverDefinedCache[BB].insert(Val);
         return changed;
       }
     };
@@ -378,11 +403,16 @@ namespace {
                                       Instruction *BBI, BasicBlock *BB);
 
     void solve();
-    
+
     ValueCacheEntryTy &lookup(Value *V) {
       return ValueCache[LVIValueHandle(V, this)];
     }
 
+    unsigned blockEpoch(BasicBlock *BB) const {
+      DenseMap<BasicBlock*, unsigned>::const_iterator I = BlockEpochs.find(BB);
+      return I == BlockEpochs.end() ? 0 : I->second;
+    }
+
   public:
     /// getValueInBlock - This is the query interface to determine the lattice
     /// value for the specified Value* at the end of the specified block.
@@ -406,26 +436,27 @@ namespace {
       SeenBlocks.clear();
       ValueCache.clear();
       OverDefinedCache.clear();
+      BlockEpochs.clear();
     }
   };
 } // end anonymous namespace
 
 void LVIValueHandle::deleted() {
-  typedef std::pair<AssertingVH<BasicBlock>, Value*> OverDefinedPairTy;
-  
-  SmallVector<OverDefinedPairTy, 4> ToErase;
-  for (DenseSet<OverDefinedPairTy>::iterator 
+  SmallVector<AssertingVH<BasicBlock>, 4> EmptiedBlocks;
+  for (DenseMap<AssertingVH<BasicBlock>,
+                LazyValueInfoCache::OverDefinedSetTy>::iterator
        I = Parent->OverDefinedCache.begin(),
        E = Parent->OverDefinedCache.end();
        I != E; ++I) {
-    if (I->second == getValPtr())
-      ToErase.push_back(*I);
+    I->second.erase(getValPtr());
+    if (I->second.empty())
+      EmptiedBlocks.push_back(I->first);
   }
-  
-  for (SmallVector<OverDefinedPairTy, 4>::iterator I = ToErase.begin(),
-       E = ToErase.end(); I != E; ++I)
+
+  for (SmallVector<AssertingVH<BasicBlock>, 4>::iterator
+       I = EmptiedBlocks.begin(), E = EmptiedBlocks.end(); I != E; ++I)
     Parent->OverDefinedCache.erase(*I);
-  
+
   // This erasure deallocates *this, so it MUST happen after we're done
   // using any and all members of *this.
   Parent->ValueCache.erase(*this);
@@ -438,20 +469,12 @@ void LazyValueInfoCache::eraseBlock(BasicBlock *BB) {
     return;
   SeenBlocks.erase(I);
 
-  SmallVector<OverDefinedPairTy, 4> ToErase;
-  for (DenseSet<OverDefinedPairTy>::iterator  I = OverDefinedCache.begin(),
-       E = OverDefinedCache.end(); I != E; ++I) {
-    if (I->first == BB)
-      ToErase.push_back(*I);
-  }
-  
-  for (SmallVector<OverDefinedPairTy, 4>::iterator I = ToErase.begin(),
-       E = ToErase.end(); I != E; ++I)
-    OverDefinedCache.erase(*I);
+  OverDefinedCache.erase(BB);
 
-  for (std::map<LVIValueHandle, ValueCacheEntryTy>::iterator
-       I = ValueCache.begin(), E = ValueCache.end(); I != E; ++I)
-    I->second.erase(BB);
+  // Bump the block's epoch instead of scanning every per-value map.  All
+  // entries cached for this block now carry an older stamp and will be
+  // ignored (and overwritten) the next time they are touched.
+  ++BlockEpochs[BB];
 }
 
 void LazyValueInfoCache::solve() {
@@ -473,7 +496,11 @@ bool LazyValueInfoCache::hasBlockValue(Value *Val, BasicBlock *BB) {
   std::map<LVIValueHandle, ValueCacheEntryTy>::iterator I =
     ValueCache.find(ValHandle);
   if (I == ValueCache.end()) return false;
-  return I->second.count(BB);
+  ValueCacheEntryTy::iterator CI = I->second.find(BB);
+  if (CI == I->second.end()) return false;
+  // An entry from before the block's last invalidation is stale and counts
+  // as missing.
+  return CI->second.Epoch == blockEpoch(BB);
 }
 
 LVILatticeVal LazyValueInfoCache::getBlockValue(Value *Val, BasicBlock *BB) {
@@ -482,7 +509,12 @@ LVILatticeVal LazyValueInfoCache::getBlockValue(Value *Val, BasicBlock *BB) {
     return LVILatticeVal::get(VC);
 
   SeenBlocks.insert(BB);
-  return lookup(Val)[BB];
+  CacheEntry &CE = lookup(Val)[BB];
+  if (CE.Epoch != blockEpoch(BB)) {
+    CE.Epoch = blockEpoch(BB);
+    CE.Val = LVILatticeVal();
+  }
+  return CE.Val;
 }
 
 bool LazyValueInfoCache::solveBlockValue(Value *Val, BasicBlock *BB) {
@@ -491,8 +523,15 @@ bool LazyValueInfoCache::solveBlockValue(Value *Val, BasicBlock *BB) {
 
   ValueCacheEntryTy &Cache = lookup(Val);
   SeenBlocks.insert(BB);
-  LVILatticeVal &BBLV = Cache[BB];
-  
+  CacheEntry &CE = Cache[BB];
+  if (CE.Epoch != blockEpoch(BB)) {
+    // Stale value from before the block's last invalidation; recompute it
+    // in place under the current epoch.
+    CE.Epoch = blockEpoch(BB);
+    CE.Val = LVILatticeVal();
+  }
+  LVILatticeVal &BBLV = CE.Val;
+
   // OverDefinedCacheUpdater is a helper object that will update
   // the OverDefinedCache for us when this method exits.  Make sure to
   // call markResult on it as we exist, passing a bool to indicate if the
@@ -952,14 +991,13 @@ void LazyValueInfoCache::threadEdge(BasicBlock *PredBB, BasicBlock *OldSucc,
   // also marked overdefined.
   std::vector<BasicBlock*> worklist;
   worklist.push_back(OldSucc);
-  
-  DenseSet<Value*> ClearSet;
-  for (DenseSet<OverDefinedPairTy>::iterator I = OverDefinedCache.begin(),
-       E = OverDefinedCache.end(); I != E; ++I) {
-    if (I->first == OldSucc)
-      ClearSet.insert(I->second);
-  }
-  
+
+  DenseMap<AssertingVH<BasicBlock>, OverDefinedSetTy>::iterator ODI =
+    OverDefinedCache.find(OldSucc);
+  if (ODI == OverDefinedCache.end())
+    return;  // Nothing was overdefined in OldSucc; nothing to do.
+  SmallVector<Value*, 8> ClearSet(ODI->second.begin(), ODI->second.end());
+
   // Use a worklist to perform a depth-first search of OldSucc's successors.
   // NOTE: We do not need a visited list since any blocks we have already
   // visited will have had their overdefined markers cleared already, and we
@@ -967,33 +1005,39 @@ void LazyValueInfoCache::threadEdge(BasicBlock *PredBB, BasicBlock *OldSucc,
   while (!worklist.empty()) {
     BasicBlock *ToUpdate = worklist.back();
     worklist.pop_back();
-    
+
     // Skip blocks only accessible through NewSucc.
     if (ToUpdate == NewSucc) continue;
-    
+
+    // If nothing is overdefined in this block, none of the values in
+    // ClearSet can be either.
+    ODI = OverDefinedCache.find(ToUpdate);
+    if (ODI == OverDefinedCache.end()) continue;
+    OverDefinedSetTy &BlockSet = ODI->second;
+
     bool changed = false;
-    for (DenseSet<Value*>::iterator I = ClearSet.begin(), E = ClearSet.end();
-         I != E; ++I) {
+    for (SmallVector<Value*, 8>::iterator I = ClearSet.begin(),
+         E = ClearSet.end(); I != E; ++I) {
       // If a value was marked overdefined in OldSucc, and is here too...
-      DenseSet<OverDefinedPairTy>::iterator OI =
-        OverDefinedCache.find(std::make_pair(ToUpdate, *I));
-      if (OI == OverDefinedCache.end()) continue;
+      if (!BlockSet.erase(*I)) continue;
 
-      // Remove it from the caches.
+      // Remove it from the value cache.
       ValueCacheEntryTy &Entry = ValueCache[LVIValueHandle(*I, this)];
       ValueCacheEntryTy::iterator CI = Entry.find(ToUpdate);
 
       assert(CI != Entry.end() && "Couldn't find entry to update?");
       Entry.erase(CI);
-      OverDefinedCache.erase(OI);
 
-      // If we removed anything, then we potentially need to update 
+      // If we removed anything, then we potentially need to update
       // blocks successors too.
       changed = true;
     }
 
+    if (BlockSet.empty())
+      OverDefinedCache.erase(ToUpdate);
+
     if (!changed) continue;
-    
+
     worklist.insert(worklist.end(), succ_begin(ToUpdate), succ_end(ToUpdate));
   }
 }
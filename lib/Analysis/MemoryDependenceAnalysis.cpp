@@ -75,6 +75,7 @@ void MemoryDependenceAnalysis::releaseMemory() {
   ReverseLocalDeps.clear();
   ReverseNonLocalDeps.clear();
   ReverseNonLocalPtrDeps.clear();
+  BlockAccessesMemory.clear();
   PredCache->clear();
 }
 
@@ -770,6 +771,28 @@ getNonLocalPointerDependency(const AliasAnalysis::Location &Loc, bool isLoad,
                                      const_cast<Value *>(Loc.Ptr)));
 }
 
+/// blockAccessesMemory - Return true if BB contains any instruction that a
+/// pointer dependency scan could report as a dependency: anything that may
+/// read or write memory, plus allocas, which getPointerDependencyFrom treats
+/// as defs of their own storage.  The summary is computed once per block and
+/// cached; removeInstruction resets the cache when a memory access goes away.
+bool MemoryDependenceAnalysis::blockAccessesMemory(const BasicBlock *BB) {
+  std::pair<DenseMap<const BasicBlock*, bool>::iterator, bool> Pair =
+    BlockAccessesMemory.insert(std::make_pair(BB, true));
+  if (!Pair.second)
+    return Pair.first->second;
+
+  bool Result = false;
+  for (BasicBlock::const_iterator I = BB->begin(), E = BB->end(); I != E; ++I)
+    if (I->mayReadFromMemory() || I->mayWriteToMemory() ||
+        isa<AllocaInst>(I)) {
+      Result = true;
+      break;
+    }
+  Pair.first->second = Result;
+  return Result;
+}
+
 /// GetNonLocalInfoForBlock - Compute the memdep value for BB with
 /// Pointer/PointeeSize using either cached information in Cache or by doing a
 /// lookup (which may use dirty cache info if available).  If we do a lookup,
@@ -815,9 +838,17 @@ GetNonLocalInfoForBlock(const AliasAnalysis::Location &Loc,
     ++NumUncacheNonLocalPtr;
   }
   
-  // Scan the block for the dependency.
-  MemDepResult Dep = getPointerDependencyFrom(Loc, isLoad, ScanPos, BB);
-  
+  // Scan the block for the dependency.  When scanning the whole block, check
+  // the per-block summary first: a block with no memory-accessing
+  // instructions at all cannot provide a dependency, so skip the scan and
+  // all of its alias queries.
+  MemDepResult Dep;
+  if (ScanPos == BB->end() && !blockAccessesMemory(BB))
+    Dep = BB != &BB->getParent()->getEntryBlock()
+            ? MemDepResult::getNonLocal() : MemDepResult::getNonFuncLocal();
+  else
+    Dep = getPointerDependencyFrom(Loc, isLoad, ScanPos, BB);
+
   // If we had a dirty entry for the block, update it.  Otherwise, just add
   // a new entry.
   if (ExistingResult)
@@ -1282,6 +1313,13 @@ void MemoryDependenceAnalysis::invalidateCachedPredecessors() {
 /// updating the dependence of instructions that previously depended on it.
 /// This method attempts to keep the cache coherent using the reverse map.
 void MemoryDependenceAnalysis::removeInstruction(Instruction *RemInst) {
+  // Reset the per-block memory access summaries.  Clients pair removals of
+  // memory accesses with newly inserted ones (PRE'd loads, merged memsets),
+  // and there is no notification for insertions, so this is the point where
+  // stale summaries get dropped.
+  if (RemInst->mayReadFromMemory() || RemInst->mayWriteToMemory())
+    BlockAccessesMemory.clear();
+
   // Walk through the Non-local dependencies, removing this one as the value
   // for any cached queries.
   NonLocalDepMapType::iterator NLDI = NonLocalDeps.find(RemInst);
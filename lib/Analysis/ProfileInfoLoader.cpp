@@ -8,17 +8,23 @@
 //===----------------------------------------------------------------------===//
 //
 // The ProfileInfoLoader class is used to load and represent profiling
-// information read in from the dump file.
+// information read in from the dump file.  The file is mapped into memory
+// rather than read packet-by-packet: profiles are re-read by every compile
+// of a PGO build, and mapping lets repeated loads share page cache instead
+// of paying for a copy each time.
 //
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Analysis/ProfileInfoLoader.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/Analysis/ProfileInfoTypes.h"
 #include "llvm/IR/InstrTypes.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
-#include <cstdio>
+#include "llvm/Support/system_error.h"
 #include <cstdlib>
+#include <cstring>
 using namespace llvm;
 
 // ByteSwap - Byteswap 'Var' if 'Really' is true.
@@ -38,27 +44,40 @@ static unsigned AddCounts(unsigned A, unsigned B) {
   return A + B;
 }
 
-static void ReadProfilingBlock(const char *ToolName, FILE *F,
-                               bool ShouldByteSwap,
-                               std::vector<unsigned> &Data) {
-  // Read the number of entries...
-  unsigned NumEntries;
-  if (fread(&NumEntries, sizeof(unsigned), 1, F) != 1) {
+/// ReadWord - Consume one word from the mapped file, exiting the program on
+/// a truncated packet just as the fread-based loader did.
+static unsigned ReadWord(const char *ToolName, const char *&Cur,
+                         const char *End) {
+  if (End - Cur < (ptrdiff_t)sizeof(unsigned)) {
     errs() << ToolName << ": data packet truncated!\n";
-    perror(0);
     exit(1);
   }
-  NumEntries = ByteSwap(NumEntries, ShouldByteSwap);
-
-  // Read the counts...
-  std::vector<unsigned> TempSpace(NumEntries);
+  unsigned Result;
+  memcpy(&Result, Cur, sizeof(unsigned));
+  Cur += sizeof(unsigned);
+  return Result;
+}
 
-  // Read in the block of data...
-  if (fread(&TempSpace[0], sizeof(unsigned)*NumEntries, 1, F) != 1) {
+static void ReadProfilingBlock(const char *ToolName, const char *&Cur,
+                               const char *End, bool ShouldByteSwap,
+                               std::vector<unsigned> &Data) {
+  // Read the number of entries...
+  unsigned NumEntries = ByteSwap(ReadWord(ToolName, Cur, End), ShouldByteSwap);
+  if ((End - Cur) / sizeof(unsigned) < NumEntries) {
     errs() << ToolName << ": data packet truncated!\n";
-    perror(0);
     exit(1);
   }
+  const char *Counts = Cur;
+  Cur += NumEntries * sizeof(unsigned);
+
+  // The common case is a single run in native byte order; take the counts
+  // wholesale from the mapped file.
+  if (Data.empty() && !ShouldByteSwap) {
+    Data.resize(NumEntries);
+    if (NumEntries)
+      memcpy(&Data[0], Counts, NumEntries * sizeof(unsigned));
+    return;
+  }
 
   // Make sure we have enough space... The space is initialised to -1 to
   // facitiltate the loading of missing values for OptimalEdgeProfiling.
@@ -66,36 +85,36 @@ static void ReadProfilingBlock(const char *ToolName, FILE *F,
     Data.resize(NumEntries, ProfileInfoLoader::Uncounted);
 
   // Accumulate the data we just read into the data.
-  if (!ShouldByteSwap) {
-    for (unsigned i = 0; i != NumEntries; ++i) {
-      Data[i] = AddCounts(TempSpace[i], Data[i]);
-    }
-  } else {
-    for (unsigned i = 0; i != NumEntries; ++i) {
-      Data[i] = AddCounts(ByteSwap(TempSpace[i], true), Data[i]);
-    }
+  for (unsigned i = 0; i != NumEntries; ++i) {
+    unsigned Count;
+    memcpy(&Count, Counts + i * sizeof(unsigned), sizeof(unsigned));
+    Data[i] = AddCounts(ByteSwap(Count, ShouldByteSwap), Data[i]);
   }
-  //outs() << "Call edge count for printf -> vfprintf: " << Data[2078*3238 + 2895] << "\n";
 }
 
 const unsigned ProfileInfoLoader::Uncounted = ~0U;
 
-// ProfileInfoLoader ctor - Read the specified profiling data file, exiting the
+// ProfileInfoLoader ctor - Map the specified profiling data file, exiting the
 // program if the file is invalid or broken.
 //
 ProfileInfoLoader::ProfileInfoLoader(const char *ToolName,
                                      const std::string &Filename)
   : Filename(Filename) {
-  FILE *F = fopen(Filename.c_str(), "rb");
-  if (F == 0) {
-    errs() << ToolName << ": Error opening '" << Filename << "': ";
-    perror(0);
+  OwningPtr<MemoryBuffer> Buffer;
+  if (error_code ec = MemoryBuffer::getFile(Filename, Buffer, -1,
+                                            /*RequiresNullTerminator=*/false)) {
+    errs() << ToolName << ": Error opening '" << Filename << "': "
+           << ec.message() << "\n";
     exit(1);
   }
 
+  const char *Cur = Buffer->getBufferStart();
+  const char *End = Buffer->getBufferEnd();
+
   // Keep reading packets until we run out of them.
-  unsigned PacketType;
-  while (fread(&PacketType, sizeof(unsigned), 1, F) == 1) {
+  while (End - Cur >= (ptrdiff_t)sizeof(unsigned)) {
+    unsigned PacketType = ReadWord(ToolName, Cur, End);
+
     // If the low eight bits of the packet are zero, we must be dealing with an
     // endianness mismatch.  Byteswap all words read from the profiling
     // information.
@@ -104,49 +123,42 @@ ProfileInfoLoader::ProfileInfoLoader(const char *ToolName,
 
     switch (PacketType) {
     case ArgumentInfo: {
-      unsigned ArgLength;
-      if (fread(&ArgLength, sizeof(unsigned), 1, F) != 1) {
+      unsigned ArgLength = ByteSwap(ReadWord(ToolName, Cur, End),
+                                    ShouldByteSwap);
+
+      // Read in the arguments...
+      unsigned PaddedLength = (ArgLength+3) & ~3;
+      if (End - Cur < (ptrdiff_t)PaddedLength) {
         errs() << ToolName << ": arguments packet truncated!\n";
-        perror(0);
         exit(1);
       }
-      ArgLength = ByteSwap(ArgLength, ShouldByteSwap);
-
-      // Read in the arguments...
-      std::vector<char> Chars(ArgLength+4);
-
-      if (ArgLength)
-        if (fread(&Chars[0], (ArgLength+3) & ~3, 1, F) != 1) {
-          errs() << ToolName << ": arguments packet truncated!\n";
-          perror(0);
-          exit(1);
-        }
-      CommandLines.push_back(std::string(&Chars[0], &Chars[ArgLength]));
+      CommandLines.push_back(std::string(Cur, Cur+ArgLength));
+      Cur += PaddedLength;
       break;
     }
 
     case FunctionInfo:
-      ReadProfilingBlock(ToolName, F, ShouldByteSwap, FunctionCounts);
+      ReadProfilingBlock(ToolName, Cur, End, ShouldByteSwap, FunctionCounts);
       break;
 
     case BlockInfo:
-      ReadProfilingBlock(ToolName, F, ShouldByteSwap, BlockCounts);
+      ReadProfilingBlock(ToolName, Cur, End, ShouldByteSwap, BlockCounts);
       break;
 
     case EdgeInfo:
-      ReadProfilingBlock(ToolName, F, ShouldByteSwap, EdgeCounts);
+      ReadProfilingBlock(ToolName, Cur, End, ShouldByteSwap, EdgeCounts);
       break;
 
     case OptEdgeInfo:
-      ReadProfilingBlock(ToolName, F, ShouldByteSwap, OptimalEdgeCounts);
+      ReadProfilingBlock(ToolName, Cur, End, ShouldByteSwap, OptimalEdgeCounts);
       break;
 
     case BBTraceInfo:
-      ReadProfilingBlock(ToolName, F, ShouldByteSwap, BBTrace);
+      ReadProfilingBlock(ToolName, Cur, End, ShouldByteSwap, BBTrace);
       break;
 
     case CallEdgeInfo:
-      ReadProfilingBlock(ToolName, F, ShouldByteSwap, CallEdgeCounts);
+      ReadProfilingBlock(ToolName, Cur, End, ShouldByteSwap, CallEdgeCounts);
       break;
 
     default:
@@ -154,7 +166,4 @@ ProfileInfoLoader::ProfileInfoLoader(const char *ToolName,
       exit(1);
     }
   }
-
-  fclose(F);
 }
-
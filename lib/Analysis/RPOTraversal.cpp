@@ -0,0 +1,50 @@
+//===- RPOTraversal.cpp - Cached RPO/PO orders ----------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the cached block-ordering analysis.  Only blocks
+// reachable from the entry block appear in the orders, matching a direct
+// ReversePostOrderTraversal of the function.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/RPOTraversal.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/IR/Function.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Support/CFG.h"
+using namespace llvm;
+
+char RPOTraversal::ID = 0;
+INITIALIZE_PASS(RPOTraversal, "rpo-traversal",
+                "Cached Reverse Post-Order Traversal", true, true)
+
+RPOTraversal::RPOTraversal() : FunctionPass(ID) {
+  initializeRPOTraversalPass(*PassRegistry::getPassRegistry());
+}
+
+bool RPOTraversal::runOnFunction(Function &F) {
+  recompute(F);
+  return false;
+}
+
+void RPOTraversal::recompute(Function &F) {
+  PO.clear();
+  Visited.clear();
+  // Reuse the member visited set so back-to-back functions share one
+  // allocation.
+  for (po_ext_iterator<BasicBlock*, SmallPtrSet<BasicBlock*, 64> >
+         I = po_ext_begin(&F.getEntryBlock(), Visited),
+         E = po_ext_end(&F.getEntryBlock(), Visited); I != E; ++I)
+    PO.push_back(*I);
+}
+
+void RPOTraversal::releaseMemory() {
+  std::vector<BasicBlock*>().swap(PO);
+  Visited.clear();
+}
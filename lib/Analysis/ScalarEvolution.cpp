@@ -645,8 +645,20 @@ static void GroupByComplexity(SmallVectorImpl<const SCEV *> &Ops,
     return;
   }
 
+  // Callers commonly rebuild expressions from operands that are already
+  // canonically ordered, so check for sortedness with one linear scan before
+  // paying for a sort.
+  SCEVComplexityCompare Cmp(LI);
+  bool IsSorted = true;
+  for (unsigned i = 1, e = Ops.size(); i != e; ++i)
+    if (Cmp(Ops[i], Ops[i-1])) {
+      IsSorted = false;
+      break;
+    }
+
   // Do the rough sort by complexity.
-  std::stable_sort(Ops.begin(), Ops.end(), SCEVComplexityCompare(LI));
+  if (!IsSorted)
+    std::stable_sort(Ops.begin(), Ops.end(), Cmp);
 
   // Now that we are sorted by complexity, group elements of the same
   // complexity.  Note that this is, at worst, N^2, but the vector is likely to
@@ -669,6 +681,17 @@ static void GroupByComplexity(SmallVectorImpl<const SCEV *> &Ops,
   }
 }
 
+const SCEV *
+ScalarEvolution::getExistingSCEV(unsigned SCEVType,
+                                 const SmallVectorImpl<const SCEV *> &Ops) {
+  FoldingSetNodeID ID;
+  ID.AddInteger(SCEVType);
+  for (unsigned i = 0, e = Ops.size(); i != e; ++i)
+    ID.AddPointer(Ops[i]);
+  void *IP = 0;
+  return UniqueSCEVs.FindNodeOrInsertPos(ID, IP);
+}
+
 
 
 //===----------------------------------------------------------------------===//
@@ -1486,6 +1509,14 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
   // Sort by complexity, this groups all similar expression types together.
   GroupByComplexity(Ops, LI);
 
+  // Canonical expressions are fixpoints of the folds below, so if this exact
+  // operand list has already been folded into one, it is the answer the folds
+  // would produce; return it without re-running them.
+  if (const SCEV *S = getExistingSCEV(scAddExpr, Ops)) {
+    cast<SCEVAddExpr>(const_cast<SCEV *>(S))->setNoWrapFlags(Flags);
+    return S;
+  }
+
   // If there are any constants, fold them together.
   unsigned Idx = 0;
   if (const SCEVConstant *LHSC = dyn_cast<SCEVConstant>(Ops[0])) {
@@ -1889,6 +1920,14 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
   // Sort by complexity, this groups all similar expression types together.
   GroupByComplexity(Ops, LI);
 
+  // Canonical expressions are fixpoints of the folds below, so if this exact
+  // operand list has already been folded into one, it is the answer the folds
+  // would produce; return it without re-running them.
+  if (const SCEV *S = getExistingSCEV(scMulExpr, Ops)) {
+    cast<SCEVMulExpr>(const_cast<SCEV *>(S))->setNoWrapFlags(Flags);
+    return S;
+  }
+
   // If there are any constants, fold them together.
   unsigned Idx = 0;
   if (const SCEVConstant *LHSC = dyn_cast<SCEVConstant>(Ops[0])) {
@@ -3269,7 +3308,7 @@ ScalarEvolution::GetMinTrailingZeros(const SCEV *S) {
 
 /// getUnsignedRange - Determine the unsigned range for a particular SCEV.
 ///
-ConstantRange
+const ConstantRange &
 ScalarEvolution::getUnsignedRange(const SCEV *S) {
   // See if we've computed this range already.
   DenseMap<const SCEV *, ConstantRange>::iterator I = UnsignedRanges.find(S);
@@ -3410,7 +3449,7 @@ ScalarEvolution::getUnsignedRange(const SCEV *S) {
 
 /// getSignedRange - Determine the signed range for a particular SCEV.
 ///
-ConstantRange
+const ConstantRange &
 ScalarEvolution::getSignedRange(const SCEV *S) {
   // See if we've computed this range already.
   DenseMap<const SCEV *, ConstantRange>::iterator I = SignedRanges.find(S);
@@ -5990,9 +6029,13 @@ ScalarEvolution::isKnownPredicateWithRanges(ICmpInst::Predicate Pred,
     break;
   }
   case ICmpInst::ICMP_NE: {
-    if (getUnsignedRange(LHS).intersectWith(getUnsignedRange(RHS)).isEmptySet())
+    // Copy the first range out of the cache: computing the second one may
+    // grow the cache and invalidate a reference to the first.
+    ConstantRange ULHSRange = getUnsignedRange(LHS);
+    if (ULHSRange.intersectWith(getUnsignedRange(RHS)).isEmptySet())
       return true;
-    if (getSignedRange(LHS).intersectWith(getSignedRange(RHS)).isEmptySet())
+    ConstantRange SLHSRange = getSignedRange(LHS);
+    if (SLHSRange.intersectWith(getSignedRange(RHS)).isEmptySet())
       return true;
 
     const SCEV *Diff = getMinusSCEV(LHS, RHS);
@@ -6330,13 +6373,15 @@ ScalarEvolution::HowManyLessThans(const SCEV *LHS, const SCEV *RHS,
       const SCEV *One = getConstant(Step->getType(), 1);
       if (isSigned) {
         APInt Max = APInt::getSignedMaxValue(BitWidth);
-        if ((Max - getSignedRange(getMinusSCEV(Step, One)).getSignedMax())
-              .slt(getSignedRange(RHS).getSignedMax()))
+        APInt StepMax =
+          getSignedRange(getMinusSCEV(Step, One)).getSignedMax();
+        if ((Max - StepMax).slt(getSignedRange(RHS).getSignedMax()))
           return getCouldNotCompute();
       } else {
         APInt Max = APInt::getMaxValue(BitWidth);
-        if ((Max - getUnsignedRange(getMinusSCEV(Step, One)).getUnsignedMax())
-              .ult(getUnsignedRange(RHS).getUnsignedMax()))
+        APInt StepMax =
+          getUnsignedRange(getMinusSCEV(Step, One)).getUnsignedMax();
+        if ((Max - StepMax).ult(getUnsignedRange(RHS).getUnsignedMax()))
           return getCouldNotCompute();
       }
     } else
@@ -14,9 +14,13 @@
 
 #define DEBUG_TYPE "sparseprop"
 #include "llvm/Analysis/SparsePropagation.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/Analysis/CallGraph.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CallSite.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 using namespace llvm;
@@ -326,6 +330,151 @@ void SparseSolver::Solve(Function &F) {
   }
 }
 
+//===----------------------------------------------------------------------===//
+//                 InterproceduralSparseSolver Implementation
+//===----------------------------------------------------------------------===//
+
+InterproceduralSparseSolver::FunctionSummary &
+InterproceduralSparseSolver::getSummary(Function *F) {
+  FunctionSummary &Sum = Summaries[F];
+  if (!Sum.Initialized) {
+    Sum.NumArgs = F->arg_size();
+    Sum.Args = Sum.NumArgs
+      ? SummaryAlloc.Allocate<LatticeVal>(Sum.NumArgs) : 0;
+    for (unsigned i = 0; i != Sum.NumArgs; ++i)
+      Sum.Args[i] = LatticeFunc->getUndefVal();
+    Sum.Ret = LatticeFunc->getUndefVal();
+    Sum.Seedable = F->hasLocalLinkage() && !F->hasAddressTaken();
+    Sum.Initialized = true;
+  }
+  return Sum;
+}
+
+InterproceduralSparseSolver::LatticeVal
+InterproceduralSparseSolver::getReturnState(Function *F) const {
+  DenseMap<Function*, FunctionSummary>::const_iterator I = Summaries.find(F);
+  if (I == Summaries.end() || !I->second.Initialized)
+    return LatticeFunc->getUntrackedVal();
+  return I->second.Ret;
+}
+
+InterproceduralSparseSolver::LatticeVal
+InterproceduralSparseSolver::getArgumentState(Argument *A) const {
+  DenseMap<Function*, FunctionSummary>::const_iterator I =
+    Summaries.find(A->getParent());
+  if (I == Summaries.end() || !I->second.Initialized || !I->second.Seedable)
+    return LatticeFunc->getUntrackedVal();
+  return I->second.Args[A->getArgNo()];
+}
+
+/// SolveFunction - Run a function-local solve, fold the results into the
+/// function's boundary summary, and push argument states across its outgoing
+/// call edges.  Any function whose summary is lowered gets re-queued.
+void InterproceduralSparseSolver::SolveFunction(Function &F) {
+  SparseSolver S(LatticeFunc, /*OwnsLattice=*/false);
+
+  // Seed the formal arguments from the call-edge merges when every caller is
+  // visible; otherwise leave them to the client's ComputeArgument.
+  FunctionSummary &Sum = getSummary(&F);
+  if (Sum.Seedable) {
+    unsigned ArgNo = 0;
+    for (Function::arg_iterator AI = F.arg_begin(), AE = F.arg_end();
+         AI != AE; ++AI, ++ArgNo)
+      S.setLatticeState(AI, Sum.Args[ArgNo]);
+  }
+
+  S.Solve(F);
+
+  LatticeVal Undef = LatticeFunc->getUndefVal();
+  LatticeVal Overdefined = LatticeFunc->getOverdefinedVal();
+
+  // Merge the values flowing out of every executable return.
+  LatticeVal Ret = Undef;
+  for (Function::iterator BB = F.begin(), BE = F.end(); BB != BE; ++BB) {
+    if (!S.isBlockExecutable(BB))
+      continue;
+    ReturnInst *RI = dyn_cast<ReturnInst>(BB->getTerminator());
+    if (!RI || RI->getNumOperands() == 0)
+      continue;
+    LatticeVal RV = S.getOrInitValueState(RI->getOperand(0));
+    if (Ret == Undef)
+      Ret = RV;
+    else if (RV != Undef && RV != Ret)
+      Ret = LatticeFunc->MergeValues(Ret, RV);
+    if (Ret == Overdefined)
+      break;
+  }
+  if (Ret != Sum.Ret) {
+    Sum.Ret = Ret;
+    // The callers computed with the old return state; solve them again.
+    for (SmallPtrSet<Function*, 4>::iterator CI = Sum.Callers.begin(),
+           CE = Sum.Callers.end(); CI != CE; ++CI)
+      requeue(*CI);
+  }
+
+  // Push the actual argument states across every direct call edge leaving an
+  // executable block.
+  for (Function::iterator BB = F.begin(), BE = F.end(); BB != BE; ++BB) {
+    if (!S.isBlockExecutable(BB))
+      continue;
+    for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I) {
+      CallSite CS(I);
+      if (!CS)
+        continue;
+      Function *Callee = CS.getCalledFunction();
+      if (!Callee || Callee->isDeclaration())
+        continue;
+
+      FunctionSummary &CalleeSum = getSummary(Callee);
+      CalleeSum.Callers.insert(&F);
+
+      bool Lowered = false;
+      unsigned NumArgs = std::min(CalleeSum.NumArgs,
+                                  unsigned(CS.arg_size()));
+      for (unsigned i = 0; i != NumArgs; ++i) {
+        LatticeVal Actual = S.getOrInitValueState(CS.getArgument(i));
+        LatticeVal &Formal = CalleeSum.Args[i];
+        LatticeVal Merged = Formal;
+        if (Formal == Undef)
+          Merged = Actual;
+        else if (Actual != Undef && Actual != Formal)
+          Merged = LatticeFunc->MergeValues(Formal, Actual);
+        if (Merged != Formal) {
+          Formal = Merged;
+          Lowered = true;
+        }
+      }
+      if (Lowered && CalleeSum.Seedable)
+        requeue(Callee);
+    }
+  }
+}
+
+void InterproceduralSparseSolver::Solve(Module &M, CallGraph &CG) {
+  // Queue every function with a body in bottom-up SCC order, so the first
+  // visit of a caller normally finds its callees already summarized.
+  for (scc_iterator<CallGraph*> I = scc_begin(&CG), E = scc_end(&CG);
+       I != E; ++I) {
+    const std::vector<CallGraphNode*> &SCC = *I;
+    for (unsigned i = 0, e = SCC.size(); i != e; ++i)
+      if (Function *F = SCC[i]->getFunction())
+        if (!F->isDeclaration())
+          requeue(F);
+  }
+
+  // Iterate to a global fixed point.  Summary changes append the affected
+  // functions back onto the queue; each per-function solve discards its
+  // value map on completion.
+  for (unsigned i = 0; i != Order.size(); ++i) {
+    Function *F = Order[i];
+    InQueue.erase(F);
+    DEBUG(dbgs() << "\nIP-solving function: " << F->getName() << "\n");
+    SolveFunction(*F);
+  }
+
+  Order.clear();
+}
+
 void SparseSolver::Print(Function &F, raw_ostream &OS) const {
   OS << "\nFUNCTION: " << F.getName() << "\n";
   for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
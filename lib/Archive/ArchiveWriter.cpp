@@ -14,30 +14,29 @@
 #include "llvm/Bitcode/Archive.h"
 #include "ArchiveInternals.h"
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/FileOutputBuffer.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Process.h"
-#include "llvm/Support/Signals.h"
 #include "llvm/Support/system_error.h"
-#include <fstream>
-#include <iomanip>
-#include <ostream>
+#include <vector>
 using namespace llvm;
 
 // Write an integer using variable bit rate encoding. This saves a few bytes
-// per entry in the symbol table.
-static inline void writeInteger(unsigned num, std::ofstream& ARFile) {
+// per entry in the symbol table. Returns the advanced output cursor.
+static inline char *writeInteger(unsigned num, char *Out) {
   while (1) {
     if (num < 0x80) { // done?
-      ARFile << (unsigned char)num;
-      return;
+      *Out++ = (char)num;
+      return Out;
     }
 
     // Nope, we are bigger than a character, output the next 7 bits and set the
     // high bit to say that there is more coming...
-    ARFile << (unsigned char)(0x80 | ((unsigned char)num & 0x7F));
+    *Out++ = (char)(0x80 | ((unsigned char)num & 0x7F));
     num >>= 7;  // Shift out 7 bits now...
   }
 }
@@ -198,100 +197,40 @@ Archive::addFileBefore(const sys::Path& filePath, iterator where,
   return false;
 }
 
-// Write one member out to the file.
-bool
-Archive::writeMember(
-  const ArchiveMember& member,
-  std::ofstream& ARFile,
-  bool CreateSymbolTable,
-  bool TruncateNames,
-  std::string* ErrMsg
-) {
-
-  unsigned filepos = ARFile.tellp();
-  filepos -= 8;
-
-  // Get the data and its size either from the
-  // member's in-memory data or directly from the file.
-  size_t fSize = member.getSize();
-  const char *data = (const char*)member.getData();
-  MemoryBuffer *mFile = 0;
-  if (!data) {
-    OwningPtr<MemoryBuffer> File;
-    if (error_code ec = MemoryBuffer::getFile(member.getPath().c_str(), File)) {
-      if (ErrMsg)
-        *ErrMsg = ec.message();
-      return true;
-    }
-    mFile = File.take();
-    data = mFile->getBufferStart();
-    fSize = mFile->getBufferSize();
-  }
-
-  // Now that we have the data in memory, update the
-  // symbol table if it's a bitcode file.
-  if (CreateSymbolTable && member.isBitcode()) {
-    std::vector<std::string> symbols;
-    std::string FullMemberName = archPath.str() + "(" + member.getPath().str()
-      + ")";
-    Module* M =
-      GetBitcodeSymbols(data, fSize, FullMemberName, Context, symbols, ErrMsg);
-
-    // If the bitcode parsed successfully
-    if ( M ) {
-      for (std::vector<std::string>::iterator SI = symbols.begin(),
-           SE = symbols.end(); SI != SE; ++SI) {
-
-        std::pair<SymTabType::iterator,bool> Res =
-          symTab.insert(std::make_pair(*SI,filepos));
-
-        if (Res.second) {
-          symTabSize += SI->length() +
-                        numVbrBytes(SI->length()) +
-                        numVbrBytes(filepos);
-        }
-      }
-      // We don't need this module any more.
-      delete M;
-    } else {
-      delete mFile;
-      if (ErrMsg)
-        *ErrMsg = "Can't parse bitcode member: " + member.getPath().str()
-          + ": " + *ErrMsg;
-      return true;
-    }
-  }
-
-  int hdrSize = fSize;
-
-  // Compute the fields of the header
-  ArchiveMemberHeader Hdr;
-  bool writeLongName = fillHeader(member,Hdr,hdrSize,TruncateNames);
-
-  // Write header to archive file
-  ARFile.write((char*)&Hdr, sizeof(Hdr));
+namespace {
+  /// The layout of one member in the final archive, computed by the scan
+  /// pass of Archive::writeToDisk before any output is produced. Data points
+  /// either at the member's in-memory contents or into its mapped file.
+  struct MemberLayout {
+    const ArchiveMember *Member;
+    std::string Path;       // the member's path, written out for long names
+    const char *Data;
+    unsigned Size;
+    ArchiveMemberHeader Hdr;
+    bool LongName;          // whether Path follows the header
+    bool Pad;               // whether a padding byte follows the data
+  };
+}
 
-  // Write the long filename if its long
-  if (writeLongName) {
-    ARFile.write(member.getPath().str().data(),
-                 member.getPath().str().length());
+// Copy one laid-out member into the output, returning the advanced cursor.
+static char *writeMemberBytes(const MemberLayout &ML, char *Out) {
+  memcpy(Out, &ML.Hdr, sizeof(ArchiveMemberHeader));
+  Out += sizeof(ArchiveMemberHeader);
+  if (ML.LongName) {
+    memcpy(Out, ML.Path.data(), ML.Path.length());
+    Out += ML.Path.length();
   }
-
-  // Write the (possibly compressed) member's content to the file.
-  ARFile.write(data,fSize);
-
-  // Make sure the member is an even length
-  if ((ARFile.tellp() & 1) == 1)
-    ARFile << ARFILE_PAD;
-
-  // Close the mapped file if it was opened
-  delete mFile;
-  return false;
+  memcpy(Out, ML.Data, ML.Size);
+  Out += ML.Size;
+  if (ML.Pad)
+    *Out++ = ARFILE_PAD[0];
+  return Out;
 }
 
-// Write out the LLVM symbol table as an archive member to the file.
-void
-Archive::writeSymbolTable(std::ofstream& ARFile) {
+// Write out the LLVM symbol table as an archive member at Out, returning the
+// advanced cursor.
+char *
+Archive::writeSymbolTable(char *Out) {
 
   // Construct the symbol table's header
   ArchiveMemberHeader Hdr;
@@ -311,11 +250,12 @@ Archive::writeSymbolTable(std::ofstream& ARFile) {
   memcpy(Hdr.size,buffer,10);
 
   // Write the header
-  ARFile.write((char*)&Hdr, sizeof(Hdr));
+  memcpy(Out, &Hdr, sizeof(Hdr));
+  Out += sizeof(Hdr);
 
 #ifndef NDEBUG
   // Save the starting position of the symbol tables data content.
-  unsigned startpos = ARFile.tellp();
+  char *startpos = Out;
 #endif
 
   // Write out the symbols sequentially
@@ -323,31 +263,33 @@ Archive::writeSymbolTable(std::ofstream& ARFile) {
         I != E; ++I)
   {
     // Write out the file index
-    writeInteger(I->second, ARFile);
+    Out = writeInteger(I->second, Out);
     // Write out the length of the symbol
-    writeInteger(I->first.length(), ARFile);
+    Out = writeInteger(I->first.length(), Out);
     // Write out the symbol
-    ARFile.write(I->first.data(), I->first.length());
+    memcpy(Out, I->first.data(), I->first.length());
+    Out += I->first.length();
   }
 
-#ifndef NDEBUG
-  // Now that we're done with the symbol table, get the ending file position
-  unsigned endpos = ARFile.tellp();
-#endif
-
   // Make sure that the amount we wrote is what we pre-computed. This is
   // critical for file integrity purposes.
-  assert(endpos - startpos == symTabSize && "Invalid symTabSize computation");
+  assert(unsigned(Out - startpos) == symTabSize &&
+         "Invalid symTabSize computation");
 
   // Make sure the symbol table is even sized
-  if (symTabSize % 2 != 0 )
-    ARFile << ARFILE_PAD;
+  if (symTabSize % 2 != 0)
+    *Out++ = ARFILE_PAD[0];
+  return Out;
 }
 
 // Write the entire archive to the file specified when the archive was created.
-// This writes to a temporary file first. Options are for creating a symbol
-// table, flattening the file names (no directories, 15 chars max) and
-// compressing each archive member.
+// Options are for creating a symbol table and flattening the file names (no
+// directories, 15 chars max). The write happens in two passes: the first maps
+// every member into memory, merges bitcode symbols into the symbol table and
+// computes the final layout of the file; the second preallocates the output
+// at its exact size with FileOutputBuffer and copies the bytes straight from
+// the mapped members. This avoids both the small serial writes and the
+// write-then-recopy dance the symbol table used to require.
 bool
 Archive::writeToDisk(bool CreateSymbolTable, bool TruncateNames,
                      std::string* ErrMsg)
@@ -360,126 +302,167 @@ Archive::writeToDisk(bool CreateSymbolTable, bool TruncateNames,
     return true;
   }
 
-  // Create a temporary file to store the archive in
-  sys::Path TmpArchive = archPath;
-  if (TmpArchive.createTemporaryFileOnDisk(ErrMsg))
-    return true;
-
-  // Make sure the temporary gets removed if we crash
-  sys::RemoveFileOnSignal(TmpArchive);
-
-  // Create archive file for output.
-  std::ios::openmode io_mode = std::ios::out | std::ios::trunc |
-                               std::ios::binary;
-  std::ofstream ArchiveFile(TmpArchive.c_str(), io_mode);
-
-  // Check for errors opening or creating archive file.
-  if (!ArchiveFile.is_open() || ArchiveFile.bad()) {
-    TmpArchive.eraseFromDisk();
-    if (ErrMsg)
-      *ErrMsg = "Error opening archive file: " + archPath.str();
-    return true;
-  }
-
   // If we're creating a symbol table, reset it now
   if (CreateSymbolTable) {
     symTabSize = 0;
     symTab.clear();
   }
 
-  // Write magic string to archive.
-  ArchiveFile << ARFILE_MAGIC;
+  // Scan all member files and lay them out. Member offsets are recorded
+  // relative to the end of the archive magic and do not account for the
+  // symbol table; the reader adjusts them by the offset of the first real
+  // member, so the symbol table's final size need not be known yet.
+  std::vector<MemberLayout> Layout;
+  Layout.reserve(members.size());
+  std::vector<MemoryBuffer*> MappedFiles;
+  unsigned MembersSize = 0;
+  bool Failed = false;
 
-  // Loop over all member files, and write them out. Note that this also
-  // builds the symbol table, symTab.
   for (MembersList::iterator I = begin(), E = end(); I != E; ++I) {
-    if (writeMember(*I, ArchiveFile, CreateSymbolTable,
-                     TruncateNames, ErrMsg)) {
-      TmpArchive.eraseFromDisk();
-      ArchiveFile.close();
-      return true;
-    }
-  }
-
-  // Close archive file.
-  ArchiveFile.close();
-
-  // Write the symbol table
-  if (CreateSymbolTable) {
-    // At this point we have written a file that is a legal archive but it
-    // doesn't have a symbol table in it. To aid in faster reading and to
-    // ensure compatibility with other archivers we need to put the symbol
-    // table first in the file. Unfortunately, this means mapping the file
-    // we just wrote back in and copying it to the destination file.
-    sys::Path FinalFilePath = archPath;
-
-    // Map in the archive we just wrote.
-    {
-    OwningPtr<MemoryBuffer> arch;
-    if (error_code ec = MemoryBuffer::getFile(TmpArchive.c_str(), arch)) {
-      if (ErrMsg)
-        *ErrMsg = ec.message();
-      return true;
-    }
-    const char* base = arch->getBufferStart();
-
-    // Open another temporary file in order to avoid invalidating the
-    // mmapped data
-    if (FinalFilePath.createTemporaryFileOnDisk(ErrMsg))
-      return true;
-    sys::RemoveFileOnSignal(FinalFilePath);
-
-    std::ofstream FinalFile(FinalFilePath.c_str(), io_mode);
-    if (!FinalFile.is_open() || FinalFile.bad()) {
-      TmpArchive.eraseFromDisk();
-      if (ErrMsg)
-        *ErrMsg = "Error opening archive file: " + FinalFilePath.str();
-      return true;
+    const ArchiveMember &member = *I;
+    MemberLayout ML;
+    ML.Member = &member;
+    ML.Path = member.getPath().str();
+
+    // Get the data and its size either from the
+    // member's in-memory data or directly from the file.
+    ML.Data = (const char*)member.getData();
+    ML.Size = member.getSize();
+    if (!ML.Data) {
+      OwningPtr<MemoryBuffer> File;
+      if (error_code ec = MemoryBuffer::getFile(member.getPath().c_str(),
+                                                File)) {
+        if (ErrMsg)
+          *ErrMsg = ec.message();
+        Failed = true;
+        break;
+      }
+      MappedFiles.push_back(File.take());
+      ML.Data = MappedFiles.back()->getBufferStart();
+      ML.Size = MappedFiles.back()->getBufferSize();
     }
 
-    // Write the file magic number
-    FinalFile << ARFILE_MAGIC;
-
-    // If there is a foreign symbol table, put it into the file now. Most
-    // ar(1) implementations require the symbol table to be first but llvm-ar
-    // can deal with it being after a foreign symbol table. This ensures
-    // compatibility with other ar(1) implementations as well as allowing the
-    // archive to store both native .o and LLVM .bc files, both indexed.
-    if (foreignST) {
-      if (writeMember(*foreignST, FinalFile, false, false, ErrMsg)) {
-        FinalFile.close();
-        TmpArchive.eraseFromDisk();
-        return true;
+    unsigned filepos = MembersSize;
+
+    // Now that we have the data in memory, update the
+    // symbol table if it's a bitcode file.
+    if (CreateSymbolTable && member.isBitcode()) {
+      std::vector<std::string> symbols;
+      std::string FullMemberName = archPath.str() + "(" + member.getPath().str()
+        + ")";
+      Module* M = GetBitcodeSymbols(ML.Data, ML.Size, FullMemberName, Context,
+                                    symbols, ErrMsg);
+
+      // If the bitcode parsed successfully
+      if ( M ) {
+        for (std::vector<std::string>::iterator SI = symbols.begin(),
+             SE = symbols.end(); SI != SE; ++SI) {
+
+          std::pair<SymTabType::iterator,bool> Res =
+            symTab.insert(std::make_pair(*SI,filepos));
+
+          if (Res.second) {
+            symTabSize += SI->length() +
+                          numVbrBytes(SI->length()) +
+                          numVbrBytes(filepos);
+          }
+        }
+        // We don't need this module any more.
+        delete M;
+      } else {
+        if (ErrMsg)
+          *ErrMsg = "Can't parse bitcode member: " + member.getPath().str()
+            + ": " + *ErrMsg;
+        Failed = true;
+        break;
       }
     }
 
-    // Put out the LLVM symbol table now.
-    writeSymbolTable(FinalFile);
+    // Compute the fields of the header
+    ML.LongName = fillHeader(member, ML.Hdr, ML.Size, TruncateNames);
+    unsigned Bytes = sizeof(ArchiveMemberHeader) + ML.Size +
+                     (ML.LongName ? ML.Path.length() : 0);
+    // Make sure the member is an even length
+    ML.Pad = (filepos + Bytes) & 1;
+    MembersSize = filepos + Bytes + ML.Pad;
+    Layout.push_back(ML);
+  }
 
-    // Copy the temporary file contents being sure to skip the file's magic
-    // number.
-    FinalFile.write(base + sizeof(ARFILE_MAGIC)-1,
-      arch->getBufferSize()-sizeof(ARFILE_MAGIC)+1);
+  if (Failed) {
+    DeleteContainerPointers(MappedFiles);
+    return true;
+  }
 
-    // Close up shop
-    FinalFile.close();
-    } // free arch.
+  // If there is a foreign symbol table, it goes out before the LLVM symbol
+  // table. Most ar(1) implementations require the symbol table to be first
+  // but llvm-ar can deal with it being after a foreign symbol table. This
+  // ensures compatibility with other ar(1) implementations as well as
+  // allowing the archive to store both native .o and LLVM .bc files, both
+  // indexed.
+  MemberLayout STLayout;
+  bool HaveForeignST = CreateSymbolTable && foreignST && foreignST->getData();
+  if (HaveForeignST) {
+    STLayout.Member = foreignST;
+    STLayout.Path = foreignST->getPath().str();
+    STLayout.Data = (const char*)foreignST->getData();
+    STLayout.Size = foreignST->getSize();
+    STLayout.LongName = fillHeader(*foreignST, STLayout.Hdr, STLayout.Size,
+                                   false);
+    STLayout.Pad = (sizeof(ArchiveMemberHeader) + STLayout.Size +
+                    (STLayout.LongName ? STLayout.Path.length() : 0)) & 1;
+  }
 
-    // Move the final file over top of TmpArchive
-    if (FinalFilePath.renamePathOnDisk(TmpArchive, ErrMsg))
-      return true;
+  // Compute the total file size and preallocate the output. FileOutputBuffer
+  // writes to a temporary and renames it over the archive on commit.
+  size_t TotalSize = ARFILE_MAGIC_LEN + MembersSize;
+  if (HaveForeignST)
+    TotalSize += sizeof(ArchiveMemberHeader) + STLayout.Size +
+                 (STLayout.LongName ? STLayout.Path.length() : 0) +
+                 STLayout.Pad;
+  if (CreateSymbolTable)
+    TotalSize += sizeof(ArchiveMemberHeader) + symTabSize + (symTabSize & 1);
+
+  OwningPtr<FileOutputBuffer> Output;
+  if (error_code ec = FileOutputBuffer::create(archPath.str(), TotalSize,
+                                               Output)) {
+    DeleteContainerPointers(MappedFiles);
+    if (ErrMsg)
+      *ErrMsg = "Error opening archive file: " + archPath.str() + ": " +
+                ec.message();
+    return true;
   }
 
+  // Copy everything into place.
+  char *Out = (char*)Output->getBufferStart();
+  memcpy(Out, ARFILE_MAGIC, ARFILE_MAGIC_LEN);
+  Out += ARFILE_MAGIC_LEN;
+  if (HaveForeignST)
+    Out = writeMemberBytes(STLayout, Out);
+  if (CreateSymbolTable)
+    Out = writeSymbolTable(Out);
+  for (std::vector<MemberLayout>::iterator I = Layout.begin(),
+         E = Layout.end(); I != E; ++I)
+    Out = writeMemberBytes(*I, Out);
+  assert(Out == (char*)Output->getBufferStart() + TotalSize &&
+         "Laid-out size does not match the bytes written!");
+
+  // All member bytes have been copied, so the mapped files can go away.
+  DeleteContainerPointers(MappedFiles);
+
   // Before we replace the actual archive, we need to forget all the
   // members, since they point to data in that old archive. We need to do
   // this because we cannot replace an open file on Windows.
   cleanUpMemory();
 
-  if (TmpArchive.renamePathOnDisk(archPath, ErrMsg))
+  if (error_code ec = Output->commit()) {
+    if (ErrMsg)
+      *ErrMsg = "Error writing archive file: " + archPath.str() + ": " +
+                ec.message();
     return true;
+  }
 
-  // Set correct read and write permissions after temporary file is moved
-  // to final destination path.
+  // Set correct read and write permissions after the buffer is committed
+  // to the final destination path.
   if (archPath.makeReadableOnDisk(ErrMsg))
     return true;
   if (archPath.makeWriteableOnDisk(ErrMsg))
@@ -47,6 +47,10 @@ namespace llvm {
                      LLVMContext &C);
     ~LLLexer() {}
 
+    /// SwitchBuffer - Continue lexing from the start of a new buffer.  The
+    /// buffer is registered with the SourceMgr, which takes ownership of it.
+    void SwitchBuffer(MemoryBuffer *Buf);
+
     lltok::Kind Lex() {
       return CurKind = LexToken();
     }
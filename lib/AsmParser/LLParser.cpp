@@ -42,6 +42,13 @@ bool LLParser::Run() {
          ValidateEndOfModule();
 }
 
+bool LLParser::RunChunk(MemoryBuffer *F) {
+  Lex.SwitchBuffer(F);
+  Lex.Lex();
+
+  return ParseTopLevelEntities();
+}
+
 /// ValidateEndOfModule - Do final validity and sanity checks at the end of the
 /// module.
 bool LLParser::ValidateEndOfModule() {
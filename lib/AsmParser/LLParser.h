@@ -135,6 +135,17 @@ namespace llvm {
       M(m) {}
     bool Run();
 
+    /// RunChunk - Parse the top-level entities in F into the module, keeping
+    /// the parser state (named and numbered types, value numbering, forward
+    /// references) alive so later chunks can refer to entities from earlier
+    /// ones.  A chunk must end on a top-level entity boundary.  Forward
+    /// references that span chunks are resolved in Finish().
+    bool RunChunk(MemoryBuffer *F);
+
+    /// Finish - Resolve any remaining forward references and run the
+    /// end-of-module checks after the last chunk.
+    bool Finish() { return ValidateEndOfModule(); }
+
     LLVMContext &getContext() { return Context; }
 
   private:
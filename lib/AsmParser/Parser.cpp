@@ -60,3 +60,42 @@ Module *llvm::ParseAssemblyString(const char *AsmString, Module *M,
 
   return ParseAssembly(F, M, Err, Context);
 }
+
+//===----------------------------------------------------------------------===//
+// IncrementalAssemblyParser
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// IncrementalParserState - The LLParser and the SourceMgr holding the chunk
+/// buffers, kept alive together between ParseChunk calls.
+struct IncrementalParserState {
+  SourceMgr SM;
+  LLParser Parser;
+
+  IncrementalParserState(MemoryBuffer *F, SMDiagnostic &Err, Module *M)
+    : Parser(F, SM, Err, M) {
+    SM.AddNewSourceBuffer(F, SMLoc());
+  }
+};
+} // end anonymous namespace.
+
+IncrementalAssemblyParser::IncrementalAssemblyParser(Module *M,
+                                                     SMDiagnostic &Err) {
+  // The lexer wants a buffer from birth; give it an empty one that hits EOF
+  // immediately.  Each chunk then switches the lexer to its own buffer.
+  MemoryBuffer *F = MemoryBuffer::getMemBuffer("", "<incremental>");
+  Impl = new IncrementalParserState(F, Err, M);
+}
+
+IncrementalAssemblyParser::~IncrementalAssemblyParser() {
+  delete static_cast<IncrementalParserState*>(Impl);
+}
+
+bool IncrementalAssemblyParser::ParseChunk(StringRef Chunk, StringRef Name) {
+  MemoryBuffer *F = MemoryBuffer::getMemBufferCopy(Chunk, Name);
+  return static_cast<IncrementalParserState*>(Impl)->Parser.RunChunk(F);
+}
+
+bool IncrementalAssemblyParser::Finish() {
+  return static_cast<IncrementalParserState*>(Impl)->Parser.Finish();
+}
@@ -9,6 +9,7 @@
 
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "BitcodeReader.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/AutoUpgrade.h"
@@ -19,11 +20,24 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/OperandTraits.h"
 #include "llvm/IR/Operator.h"
+#include "llvm/Support/Atomic.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Compression.h"
 #include "llvm/Support/DataStream.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Threading.h"
 using namespace llvm;
 
+/// BitcodeDecodeThreads - Number of worker threads used to pre-decode
+/// deferred function blocks before materialization.  Records are staged in
+/// parallel but IR is still built serially, since use lists of shared
+/// constants and context uniquing tables cannot be mutated concurrently.
+static cl::opt<unsigned>
+BitcodeDecodeThreads("bitcode-decode-threads", cl::init(0), cl::Hidden,
+  cl::desc("Decode deferred function bodies with this many threads "
+           "(0 = serial)"));
+
 enum {
   SWITCH_INST_MAGIC = 0x4B5 // May 2012 => 1205 => Hex
 };
@@ -49,9 +63,220 @@ void BitcodeReader::FreeState() {
   DeferredFunctionInfo.clear();
   MDKindMap.clear();
 
+  for (DenseMap<Function*, StagedBodyTy*>::iterator I = StagedBodies.begin(),
+       E = StagedBodies.end(); I != E; ++I)
+    delete I->second;
+  StagedBodies.clear();
+  StagedBody = 0;
+
   assert(BlockAddrFwdRefs.empty() && "Unresolved blockaddress fwd references");
 }
 
+//===----------------------------------------------------------------------===//
+//  Staged function-body decoding
+//===----------------------------------------------------------------------===//
+//
+// Once the global tables have been parsed, deferred function blocks are
+// independent spans of the bitstream, so the expensive part of reading them
+// (bit unpacking and abbreviation decoding) can run on worker threads, each
+// with a private cursor over the shared, read-only BitstreamReader.  The
+// workers stage each block as a flat list of already-decoded records; IR is
+// then built serially from the staged records, because instruction creation
+// mutates the use lists of shared constants and globals as well as the
+// context's uniquing tables.
+
+BitstreamEntry BitcodeReader::bodyAdvance() {
+  if (!StagedBody)
+    return Stream.advance();
+  if (StagedIdx == StagedBody->size())
+    return BitstreamEntry::getError();
+  const StagedRecord &R = (*StagedBody)[StagedIdx];
+  switch (R.Kind) {
+  case BitstreamEntry::EndBlock:
+    ++StagedIdx;
+    return BitstreamEntry::getEndBlock();
+  case BitstreamEntry::SubBlock:
+    ++StagedIdx;
+    return BitstreamEntry::getSubBlock(R.Code);
+  case BitstreamEntry::Record:
+    // Leave the record in place; bodyReadRecord consumes it.
+    return BitstreamEntry::getRecord(R.Code);
+  default:
+    return BitstreamEntry::getError();
+  }
+}
+
+bool BitcodeReader::bodySkipBlock() {
+  if (!StagedBody)
+    return Stream.SkipBlock();
+  // The SubBlock marker has already been consumed by bodyAdvance; skip
+  // forward to the matching EndBlock marker.
+  unsigned Depth = 1;
+  while (StagedIdx != StagedBody->size()) {
+    const StagedRecord &R = (*StagedBody)[StagedIdx++];
+    if (R.Kind == BitstreamEntry::SubBlock)
+      ++Depth;
+    else if (R.Kind == BitstreamEntry::EndBlock && --Depth == 0)
+      return false;
+  }
+  return true;
+}
+
+BitstreamEntry BitcodeReader::bodyAdvanceSkippingSubblocks() {
+  if (!StagedBody)
+    return Stream.advanceSkippingSubblocks();
+  while (1) {
+    BitstreamEntry Entry = bodyAdvance();
+    if (Entry.Kind != BitstreamEntry::SubBlock)
+      return Entry;
+    if (bodySkipBlock())
+      return BitstreamEntry::getError();
+  }
+}
+
+unsigned BitcodeReader::bodyReadRecord(unsigned AbbrevID,
+                                       SmallVectorImpl<uint64_t> &Vals) {
+  if (!StagedBody)
+    return Stream.readRecord(AbbrevID, Vals);
+  const StagedRecord &R = (*StagedBody)[StagedIdx++];
+  assert(R.Kind == BitstreamEntry::Record && "Not positioned on a record");
+  Vals.append(R.Vals.begin(), R.Vals.end());
+  return R.Code;
+}
+
+bool BitcodeReader::bodyEnterSubBlock(unsigned BlockID) {
+  // In staged mode the enclosing SubBlock marker has already been consumed
+  // and there is no abbreviation scope to push.
+  if (!StagedBody)
+    return Stream.EnterSubBlock(BlockID);
+  return false;
+}
+
+/// PreDecodeBlock - Decode the block the cursor is positioned to enter into
+/// a flat list of staged records, recursing into nested blocks.  Blobs are
+/// unpacked into the value list, which readRecord does for us when no blob
+/// StringRef is supplied.  Returns true on error.
+static bool PreDecodeBlock(BitstreamCursor &Cursor, unsigned BlockID,
+                           BitcodeReader::StagedBodyTy &Out) {
+  if (Cursor.EnterSubBlock(BlockID))
+    return true;
+
+  while (1) {
+    BitstreamEntry Entry = Cursor.advance();
+
+    Out.push_back(BitcodeReader::StagedRecord());
+    BitcodeReader::StagedRecord &R = Out.back();
+    R.Kind = Entry.Kind;
+    switch (Entry.Kind) {
+    default:
+      return true;
+    case BitstreamEntry::EndBlock:
+      return false;
+    case BitstreamEntry::SubBlock:
+      R.Code = Entry.ID;
+      if (PreDecodeBlock(Cursor, Entry.ID, Out))
+        return true;
+      break;
+    case BitstreamEntry::Record:
+      R.Code = Cursor.readRecord(Entry.ID, R.Vals);
+      break;
+    }
+  }
+}
+
+namespace {
+  /// PreDecodeContext - Shared state for the function-body pre-decode
+  /// workers.  Workers claim function indices with an atomic counter, so
+  /// each Bodies slot is written by exactly one thread.
+  struct PreDecodeContext {
+    BitstreamReader *StreamFile;
+    bool IsBlockStart;
+    std::vector<uint64_t> Offsets;
+    std::vector<BitcodeReader::StagedBodyTy*> Bodies;
+    volatile sys::cas_flag NextIdx;
+    volatile sys::cas_flag Failed;
+  };
+}
+
+static void PreDecodeWorker(void *Arg) {
+  PreDecodeContext &Ctx = *static_cast<PreDecodeContext*>(Arg);
+  while (1) {
+    unsigned Idx = sys::AtomicIncrement(&Ctx.NextIdx) - 1;
+    if (Idx >= Ctx.Offsets.size())
+      return;
+
+    BitstreamCursor Cursor(*Ctx.StreamFile);
+    Cursor.JumpToBit(Ctx.Offsets[Idx]);
+
+    // Offsets that came from the function index point at the ENTER_SUBBLOCK
+    // for the body; step over it first.
+    if (Ctx.IsBlockStart) {
+      BitstreamEntry Entry = Cursor.advance();
+      if (Entry.Kind != BitstreamEntry::SubBlock ||
+          Entry.ID != bitc::FUNCTION_BLOCK_ID) {
+        Ctx.Failed = 1;
+        return;
+      }
+    }
+
+    if (PreDecodeBlock(Cursor, bitc::FUNCTION_BLOCK_ID, *Ctx.Bodies[Idx]))
+      Ctx.Failed = 1;
+  }
+}
+
+void BitcodeReader::PreDecodeFunctionBodies() {
+  if (BitcodeDecodeThreads < 2 || !llvm_is_multithreaded() || LazyStreamer)
+    return;
+
+  // Collect the functions whose body positions are already known.  Offsets
+  // of zero mean the body hasn't been seen yet and would require parsing
+  // more of the module serially, so give up in that case.
+  std::vector<Function*> Fns;
+  PreDecodeContext Ctx;
+  Ctx.StreamFile = StreamFile.get();
+  Ctx.IsBlockStart = DeferredIsBlockStart;
+  Ctx.NextIdx = 0;
+  Ctx.Failed = 0;
+  for (Module::iterator F = TheModule->begin(), E = TheModule->end();
+       F != E; ++F) {
+    if (!F->isMaterializable())
+      continue;
+    DenseMap<Function*, uint64_t>::iterator DFII =
+      DeferredFunctionInfo.find(F);
+    assert(DFII != DeferredFunctionInfo.end() &&
+           "Deferred function not found!");
+    if (DFII->second == 0)
+      return;
+    Fns.push_back(F);
+    Ctx.Offsets.push_back(DFII->second);
+  }
+  if (Fns.size() < 2)
+    return;
+
+  Ctx.Bodies.resize(Fns.size());
+  for (unsigned i = 0, e = Fns.size(); i != e; ++i)
+    Ctx.Bodies[i] = new StagedBodyTy();
+
+  unsigned NumThreads = BitcodeDecodeThreads;
+  if (NumThreads > Fns.size())
+    NumThreads = Fns.size();
+  std::vector<void*> Threads(NumThreads);
+  for (unsigned i = 0; i != NumThreads; ++i)
+    Threads[i] = llvm_launch_thread(PreDecodeWorker, &Ctx);
+  for (unsigned i = 0; i != NumThreads; ++i)
+    llvm_join_thread(Threads[i]);
+
+  if (Ctx.Failed) {
+    // Fall back to the serial path; Materialize will re-read the stream.
+    for (unsigned i = 0, e = Ctx.Bodies.size(); i != e; ++i)
+      delete Ctx.Bodies[i];
+    return;
+  }
+
+  for (unsigned i = 0, e = Fns.size(); i != e; ++i)
+    StagedBodies[Fns[i]] = Ctx.Bodies[i];
+}
+
 //===----------------------------------------------------------------------===//
 //  Helper functions to implement forward reference resolution, etc.
 //===----------------------------------------------------------------------===//
@@ -725,7 +950,7 @@ bool BitcodeReader::ParseTypeTableBody() {
 }
 
 bool BitcodeReader::ParseValueSymbolTable() {
-  if (Stream.EnterSubBlock(bitc::VALUE_SYMTAB_BLOCK_ID))
+  if (bodyEnterSubBlock(bitc::VALUE_SYMTAB_BLOCK_ID))
     return Error("Malformed block record");
 
   SmallVector<uint64_t, 64> Record;
@@ -733,7 +958,7 @@ bool BitcodeReader::ParseValueSymbolTable() {
   // Read all the records for this value table.
   SmallString<128> ValueName;
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = bodyAdvanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -748,7 +973,7 @@ bool BitcodeReader::ParseValueSymbolTable() {
 
     // Read a record.
     Record.clear();
-    switch (Stream.readRecord(Entry.ID, Record)) {
+    switch (bodyReadRecord(Entry.ID, Record)) {
     default:  // Default behavior: unknown type.
       break;
     case bitc::VST_CODE_ENTRY: {  // VST_ENTRY: [valueid, namechar x N]
@@ -781,14 +1006,14 @@ bool BitcodeReader::ParseValueSymbolTable() {
 bool BitcodeReader::ParseMetadata() {
   unsigned NextMDValueNo = MDValueList.size();
 
-  if (Stream.EnterSubBlock(bitc::METADATA_BLOCK_ID))
+  if (bodyEnterSubBlock(bitc::METADATA_BLOCK_ID))
     return Error("Malformed block record");
 
   SmallVector<uint64_t, 64> Record;
 
   // Read all the records.
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = bodyAdvanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -805,7 +1030,7 @@ bool BitcodeReader::ParseMetadata() {
     bool IsFunctionLocal = false;
     // Read a record.
     Record.clear();
-    unsigned Code = Stream.readRecord(Entry.ID, Record);
+    unsigned Code = bodyReadRecord(Entry.ID, Record);
     switch (Code) {
     default:  // Default behavior: ignore.
       break;
@@ -813,10 +1038,18 @@ bool BitcodeReader::ParseMetadata() {
       // Read name of the named metadata.
       SmallString<8> Name(Record.begin(), Record.end());
       Record.clear();
-      Code = Stream.ReadCode();
 
       // METADATA_NAME is always followed by METADATA_NAMED_NODE.
-      unsigned NextBitCode = Stream.readRecord(Code, Record);
+      unsigned NextBitCode;
+      if (StagedBody) {
+        BitstreamEntry NextEntry = bodyAdvance();
+        if (NextEntry.Kind != BitstreamEntry::Record)
+          return Error("malformed metadata block");
+        NextBitCode = bodyReadRecord(NextEntry.ID, Record);
+      } else {
+        Code = Stream.ReadCode();
+        NextBitCode = Stream.readRecord(Code, Record);
+      }
       assert(NextBitCode == bitc::METADATA_NAMED_NODE); (void)NextBitCode;
 
       // Read named metadata elements.
@@ -934,7 +1167,7 @@ static APInt ReadWideAPInt(ArrayRef<uint64_t> Vals, unsigned TypeBits) {
 }
 
 bool BitcodeReader::ParseConstants() {
-  if (Stream.EnterSubBlock(bitc::CONSTANTS_BLOCK_ID))
+  if (bodyEnterSubBlock(bitc::CONSTANTS_BLOCK_ID))
     return Error("Malformed block record");
 
   SmallVector<uint64_t, 64> Record;
@@ -943,7 +1176,7 @@ bool BitcodeReader::ParseConstants() {
   Type *CurTy = Type::getInt32Ty(Context);
   unsigned NextCstNo = ValueList.size();
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = bodyAdvanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -965,7 +1198,7 @@ bool BitcodeReader::ParseConstants() {
     // Read a record.
     Record.clear();
     Value *V = 0;
-    unsigned BitCode = Stream.readRecord(Entry.ID, Record);
+    unsigned BitCode = bodyReadRecord(Entry.ID, Record);
     switch (BitCode) {
     default:  // Default behavior: unknown constant
     case bitc::CST_CODE_UNDEF:     // UNDEF
@@ -1329,14 +1562,14 @@ bool BitcodeReader::ParseConstants() {
 }
 
 bool BitcodeReader::ParseUseLists() {
-  if (Stream.EnterSubBlock(bitc::USELIST_BLOCK_ID))
+  if (bodyEnterSubBlock(bitc::USELIST_BLOCK_ID))
     return Error("Malformed block record");
 
   SmallVector<uint64_t, 64> Record;
 
   // Read all the records.
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = bodyAdvanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -1351,7 +1584,7 @@ bool BitcodeReader::ParseUseLists() {
 
     // Read a use list record.
     Record.clear();
-    switch (Stream.readRecord(Entry.ID, Record)) {
+    switch (bodyReadRecord(Entry.ID, Record)) {
     default:  // Default behavior: unknown type.
       break;
     case bitc::USELIST_CODE_ENTRY: { // USELIST_CODE_ENTRY: TBD.
@@ -1386,6 +1619,76 @@ bool BitcodeReader::RememberAndSkipFunctionBody() {
   return false;
 }
 
+/// ParseFunctionIndex - Parse the function index block at FunctionIndexBit and
+/// record the position of every deferred function body at once, so the module
+/// parser does not have to skip through each function block.  On success the
+/// cursor is left just past the index block, which the writer places after the
+/// last function body.
+bool BitcodeReader::ParseFunctionIndex() {
+  // Recreate the function numbering the writer used.
+  std::vector<Function*> FunctionsByNumber;
+  for (Module::iterator F = TheModule->begin(), E = TheModule->end();
+       F != E; ++F)
+    FunctionsByNumber.push_back(F);
+
+  // Entries are only valid for functions still awaiting a deferred body.
+  // Note that isDeclaration() can't distinguish them here: no body has been
+  // materialized yet, so every defined function still looks like one.
+  SmallPtrSet<Function*, 16> AwaitingBody(FunctionsWithBodies.begin(),
+                                          FunctionsWithBodies.end());
+
+  Stream.JumpToBit(FunctionIndexBit);
+
+  BitstreamEntry Entry = Stream.advance();
+  if (Entry.Kind != BitstreamEntry::SubBlock ||
+      Entry.ID != bitc::FUNCTION_INDEX_BLOCK_ID)
+    return Error("Malformed function index");
+
+  if (Stream.EnterSubBlock(bitc::FUNCTION_INDEX_BLOCK_ID))
+    return Error("Malformed block record");
+
+  unsigned NumEntries = 0;
+  SmallVector<uint64_t, 64> Record;
+  while (1) {
+    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    switch (Entry.Kind) {
+    case BitstreamEntry::SubBlock: // Handled for us already.
+    case BitstreamEntry::Error:
+      return Error("Malformed function index");
+    case BitstreamEntry::EndBlock:
+      if (NumEntries != FunctionsWithBodies.size())
+        return Error("Insufficient function index entries");
+      // The index covers every deferred body; the pending list is no longer
+      // needed, and Materialize must know the recorded offsets point at the
+      // ENTER_SUBBLOCK for each body.
+      FunctionsWithBodies.clear();
+      DeferredIsBlockStart = true;
+      return false;
+    case BitstreamEntry::Record:
+      break;
+    }
+
+    // Read an index entry.
+    Record.clear();
+    switch (Stream.readRecord(Entry.ID, Record)) {
+    default:  // Default behavior: ignore unknown content.
+      break;
+    case bitc::FNINDEX_CODE_ENTRY: {  // ENTRY: [function#, offset]
+      if (Record.size() < 2)
+        return Error("Invalid FNINDEX_CODE_ENTRY record");
+      if (Record[0] >= FunctionsByNumber.size())
+        return Error("Invalid function number in function index");
+      Function *F = FunctionsByNumber[Record[0]];
+      if (!AwaitingBody.erase(F))
+        return Error("Function index entry for a function without a body");
+      DeferredFunctionInfo[F] = Record[1];
+      ++NumEntries;
+      break;
+    }
+    }
+  }
+}
+
 bool BitcodeReader::GlobalCleanup() {
   // Patch the initializers for globals and aliases up.
   ResolveGlobalAndAliasInits();
@@ -1474,6 +1777,16 @@ bool BitcodeReader::ParseModule(bool Resume) {
           SeenFirstFunctionBody = true;
         }
 
+        // If the writer emitted a function index, record the position of
+        // every body from it at once rather than skipping through each
+        // function block.  The cursor is left just past the index, after the
+        // last function body.
+        if (FunctionIndexBit) {
+          if (ParseFunctionIndex())
+            return true;
+          break;
+        }
+
         if (RememberAndSkipFunctionBody())
           return true;
         // For streaming bitcode, suspend parsing when we reach the function
@@ -1690,6 +2003,15 @@ bool BitcodeReader::ParseModule(bool Resume) {
         return Error("Invalid MODULE_PURGEVALS record");
       ValueList.shrinkTo(Record[0]);
       break;
+    /// MODULE_CODE_FNINDEXOFFSET: [offset]
+    case bitc::MODULE_CODE_FNINDEXOFFSET:
+      if (Record.size() < 1)
+        return Error("Invalid MODULE_CODE_FNINDEXOFFSET record");
+      // The index is only usable when the input supports random access; a
+      // zero offset means the writer did not emit one.
+      if (!LazyStreamer)
+        FunctionIndexBit = Record[0];
+      break;
     }
     Record.clear();
   }
@@ -1840,14 +2162,135 @@ bool BitcodeReader::ParseTriple(std::string &Triple) {
   }
 }
 
+/// ParseFunctionSummaryBlock - Parse the records of a function summary
+/// block into the given map.
+bool BitcodeReader::ParseFunctionSummaryBlock(
+                                      StringMap<FunctionSummary> &Summaries) {
+  if (Stream.EnterSubBlock(bitc::FUNCTION_SUMMARY_BLOCK_ID))
+    return Error("Malformed block record");
+
+  SmallVector<uint64_t, 64> Record;
+  SmallString<128> Name;
+  while (1) {
+    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::SubBlock: // Handled for us already.
+    case BitstreamEntry::Error:
+      return Error("malformed function summary block");
+    case BitstreamEntry::EndBlock:
+      return false;
+    case BitstreamEntry::Record:
+      // The interesting case.
+      break;
+    }
+
+    Record.clear();
+    switch (Stream.readRecord(Entry.ID, Record)) {
+    default: break;  // Default behavior: ignore.
+    case bitc::FNSUMMARY_CODE_ENTRY: {  // ENTRY: [instcount, callcount,
+                                        //         strchr x N]
+      if (Record.size() < 2)
+        return Error("Invalid FNSUMMARY_CODE_ENTRY record");
+      Name.clear();
+      for (unsigned i = 2, e = Record.size(); i != e; ++i)
+        Name.push_back((char)Record[i]);
+      FunctionSummary &S = Summaries[Name.str()];
+      S.NumInsts = Record[0];
+      S.NumCallSites = Record[1];
+      break;
+    }
+    }
+  }
+}
+
+/// ParseModuleFunctionSummaries - Skim the module block looking for the
+/// function summary block, skipping everything else (in particular the
+/// function bodies).
+bool BitcodeReader::ParseModuleFunctionSummaries(
+                                      StringMap<FunctionSummary> &Summaries) {
+  if (Stream.EnterSubBlock(bitc::MODULE_BLOCK_ID))
+    return Error("Malformed block record");
+
+  // Read all the records for this module.
+  while (1) {
+    BitstreamEntry Entry = Stream.advance();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return Error("malformed module block");
+    case BitstreamEntry::EndBlock:
+      return false;
+
+    case BitstreamEntry::SubBlock:
+      // There is at most one summary block per module; once it is parsed
+      // nothing further in the stream is of interest.
+      if (Entry.ID == bitc::FUNCTION_SUMMARY_BLOCK_ID)
+        return ParseFunctionSummaryBlock(Summaries);
+
+      // Ignore other sub-blocks.
+      if (Stream.SkipBlock())
+        return Error("malformed block record in AST file");
+      continue;
+
+    case BitstreamEntry::Record:
+      Stream.skipRecord(Entry.ID);
+      continue;
+    }
+  }
+}
+
+bool BitcodeReader::ParseFunctionSummaries(
+                                      StringMap<FunctionSummary> &Summaries) {
+  if (InitStream()) return true;
+
+  // Sniff for the signature.
+  if (Stream.Read(8) != 'B' ||
+      Stream.Read(8) != 'C' ||
+      Stream.Read(4) != 0x0 ||
+      Stream.Read(4) != 0xC ||
+      Stream.Read(4) != 0xE ||
+      Stream.Read(4) != 0xD)
+    return Error("Invalid bitcode signature");
+
+  // We expect a number of well-defined blocks, though we don't necessarily
+  // need to understand them all.
+  while (1) {
+    BitstreamEntry Entry = Stream.advance();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      Error("malformed module file");
+      return true;
+    case BitstreamEntry::EndBlock:
+      return false;
+
+    case BitstreamEntry::SubBlock:
+      if (Entry.ID == bitc::MODULE_BLOCK_ID)
+        return ParseModuleFunctionSummaries(Summaries);
+
+      // Ignore other sub-blocks.
+      if (Stream.SkipBlock()) {
+        Error("malformed block record in AST file");
+        return true;
+      }
+      continue;
+
+    case BitstreamEntry::Record:
+      Stream.skipRecord(Entry.ID);
+      continue;
+    }
+  }
+}
+
 /// ParseMetadataAttachment - Parse metadata attachments.
 bool BitcodeReader::ParseMetadataAttachment() {
-  if (Stream.EnterSubBlock(bitc::METADATA_ATTACHMENT_ID))
+  if (bodyEnterSubBlock(bitc::METADATA_ATTACHMENT_ID))
     return Error("Malformed block record");
 
   SmallVector<uint64_t, 64> Record;
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = bodyAdvanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -1862,7 +2305,7 @@ bool BitcodeReader::ParseMetadataAttachment() {
 
     // Read a metadata attachment record.
     Record.clear();
-    switch (Stream.readRecord(Entry.ID, Record)) {
+    switch (bodyReadRecord(Entry.ID, Record)) {
     default:  // Default behavior: ignore.
       break;
     case bitc::METADATA_ATTACHMENT: {
@@ -1887,7 +2330,7 @@ bool BitcodeReader::ParseMetadataAttachment() {
 
 /// ParseFunctionBody - Lazily parse the specified function body block.
 bool BitcodeReader::ParseFunctionBody(Function *F) {
-  if (Stream.EnterSubBlock(bitc::FUNCTION_BLOCK_ID))
+  if (bodyEnterSubBlock(bitc::FUNCTION_BLOCK_ID))
     return Error("Malformed block record");
 
   InstructionList.clear();
@@ -1907,7 +2350,7 @@ bool BitcodeReader::ParseFunctionBody(Function *F) {
   // Read all the records.
   SmallVector<uint64_t, 64> Record;
   while (1) {
-    BitstreamEntry Entry = Stream.advance();
+    BitstreamEntry Entry = bodyAdvance();
 
     switch (Entry.Kind) {
     case BitstreamEntry::Error:
@@ -1918,7 +2361,7 @@ bool BitcodeReader::ParseFunctionBody(Function *F) {
     case BitstreamEntry::SubBlock:
       switch (Entry.ID) {
       default:  // Skip unknown content.
-        if (Stream.SkipBlock())
+        if (bodySkipBlock())
           return Error("Malformed block record");
         break;
       case bitc::CONSTANTS_BLOCK_ID:
@@ -1945,7 +2388,7 @@ bool BitcodeReader::ParseFunctionBody(Function *F) {
     // Read a record.
     Record.clear();
     Instruction *I = 0;
-    unsigned BitCode = Stream.readRecord(Entry.ID, Record);
+    unsigned BitCode = bodyReadRecord(Entry.ID, Record);
     switch (BitCode) {
     default: // Default behavior: reject
       return Error("Unknown instruction");
@@ -2805,12 +3248,40 @@ bool BitcodeReader::Materialize(GlobalValue *GV, std::string *ErrInfo) {
   if (DFII->second == 0)
     if (LazyStreamer && FindFunctionInStream(F, DFII)) return true;
 
-  // Move the bit stream to the saved position of the deferred function body.
-  Stream.JumpToBit(DFII->second);
+  // If the body was pre-decoded by a worker thread, build IR from the staged
+  // records instead of re-reading the stream.
+  DenseMap<Function*, StagedBodyTy*>::iterator SBI = StagedBodies.find(F);
+  if (SBI != StagedBodies.end()) {
+    StagedBody = SBI->second;
+    StagedIdx = 0;
+    bool Failed = ParseFunctionBody(F);
+    delete SBI->second;
+    StagedBodies.erase(SBI);
+    StagedBody = 0;
+    if (Failed) {
+      if (ErrInfo) *ErrInfo = ErrorString;
+      return true;
+    }
+  } else {
+    // Move the bit stream to the saved position of the deferred function body.
+    Stream.JumpToBit(DFII->second);
+
+    // Positions that came from the function index point at the ENTER_SUBBLOCK
+    // for the body; step over it first.
+    if (DeferredIsBlockStart) {
+      BitstreamEntry Entry = Stream.advance();
+      if (Entry.Kind != BitstreamEntry::SubBlock ||
+          Entry.ID != bitc::FUNCTION_BLOCK_ID) {
+        Error("Malformed function block");
+        if (ErrInfo) *ErrInfo = ErrorString;
+        return true;
+      }
+    }
 
-  if (ParseFunctionBody(F)) {
-    if (ErrInfo) *ErrInfo = ErrorString;
-    return true;
+    if (ParseFunctionBody(F)) {
+      if (ErrInfo) *ErrInfo = ErrorString;
+      return true;
+    }
   }
 
   // Upgrade any old intrinsic calls in the function.
@@ -2851,6 +3322,11 @@ void BitcodeReader::Dematerialize(GlobalValue *GV) {
 bool BitcodeReader::MaterializeModule(Module *M, std::string *ErrInfo) {
   assert(M == TheModule &&
          "Can only Materialize the Module this BitcodeReader is attached to.");
+
+  // Pre-decode the remaining function blocks on worker threads if requested;
+  // the loop below then builds IR from the staged records serially.
+  PreDecodeFunctionBodies();
+
   // Iterate over the module, deserializing any functions that are still on
   // disk.
   for (Module::iterator F = TheModule->begin(), E = TheModule->end();
@@ -2939,6 +3415,97 @@ bool BitcodeReader::InitLazyStream() {
   return false;
 }
 
+//===----------------------------------------------------------------------===//
+// Compressed bitcode support
+//===----------------------------------------------------------------------===//
+
+static uint32_t ReadLE32(const unsigned char *P) {
+  return (uint32_t)P[0] | ((uint32_t)P[1] << 8) |
+         ((uint32_t)P[2] << 16) | ((uint32_t)P[3] << 24);
+}
+
+namespace {
+
+/// CompressedBCStreamer - A DataStreamer that feeds the bitstream reader
+/// from the compressed container described at isCompressedBitcodeWrapper,
+/// decompressing one chunk at a time as the stream position advances.
+/// Chunks beyond the furthest byte the reader touches are never
+/// decompressed, so lazy materialization stays lazy on compressed modules.
+/// The streamer does not own the underlying buffer.
+class CompressedBCStreamer : public DataStreamer {
+  const unsigned char *Index;      // Chunk index entries.
+  const unsigned char *NextChunk;  // Payload of the next chunk to decode.
+  unsigned NumChunks, CurChunk;
+  SmallVector<char, 0> Decoded;    // Current decompressed chunk.
+  size_t DecodedPos;               // Bytes of Decoded already consumed.
+
+  CompressedBCStreamer(const unsigned char *Idx,
+                       const unsigned char *Payload, unsigned Chunks)
+    : Index(Idx), NextChunk(Payload), NumChunks(Chunks), CurChunk(0),
+      DecodedPos(0) {}
+public:
+  /// create - Validate the container header of Buf and return a streamer
+  /// over its chunks, or null (filling in *ErrMsg if non-null) if the
+  /// header is malformed.
+  static CompressedBCStreamer *create(MemoryBuffer *Buf, std::string *ErrMsg);
+
+  virtual size_t GetBytes(unsigned char *OutBuf, size_t Len);
+};
+
+} // end anonymous namespace
+
+CompressedBCStreamer *CompressedBCStreamer::create(MemoryBuffer *Buf,
+                                                   std::string *ErrMsg) {
+  const unsigned char *P = (const unsigned char *)Buf->getBufferStart();
+  const unsigned char *End = (const unsigned char *)Buf->getBufferEnd();
+
+  uint64_t NumChunks = 0, IndexBytes = 0, PayloadBytes = 0;
+  bool Valid = End - P >= 16 && ReadLE32(P + 4) == 0;
+  if (Valid) {
+    NumChunks = ReadLE32(P + 12);
+    IndexBytes = NumChunks * 8;
+    Valid = (uint64_t)(End - P) - 16 >= IndexBytes;
+  }
+  if (Valid) {
+    for (uint64_t i = 0; i != NumChunks; ++i)
+      PayloadBytes += ReadLE32(P + 16 + 8*i);
+    Valid = (uint64_t)(End - P) - 16 - IndexBytes >= PayloadBytes;
+  }
+  if (!Valid) {
+    if (ErrMsg)
+      *ErrMsg = "Invalid compressed bitcode wrapper header";
+    return 0;
+  }
+  return new CompressedBCStreamer(P + 16, P + 16 + IndexBytes,
+                                  (unsigned)NumChunks);
+}
+
+size_t CompressedBCStreamer::GetBytes(unsigned char *OutBuf, size_t Len) {
+  size_t Copied = 0;
+  while (Copied != Len) {
+    if (DecodedPos == Decoded.size()) {
+      if (CurChunk == NumChunks)
+        break;
+      uint32_t CSize = ReadLE32(Index + 8*CurChunk);
+      uint32_t USize = ReadLE32(Index + 8*CurChunk + 4);
+      Decoded.clear();
+      DecodedPos = 0;
+      StringRef Chunk((const char *)NextChunk, CSize);
+      if (CSize == USize)  // Stored raw.
+        Decoded.append(Chunk.begin(), Chunk.end());
+      else if (!compression::uncompress(Chunk, Decoded, USize))
+        break;  // Malformed chunk: truncate the stream.
+      NextChunk += CSize;
+      ++CurChunk;
+    }
+    size_t N = std::min(Len - Copied, Decoded.size() - DecodedPos);
+    memcpy(OutBuf + Copied, &Decoded[DecodedPos], N);
+    DecodedPos += N;
+    Copied += N;
+  }
+  return Copied;
+}
+
 //===----------------------------------------------------------------------===//
 // External interface
 //===----------------------------------------------------------------------===//
@@ -2948,6 +3515,31 @@ bool BitcodeReader::InitLazyStream() {
 Module *llvm::getLazyBitcodeModule(MemoryBuffer *Buffer,
                                    LLVMContext& Context,
                                    std::string *ErrMsg) {
+  const unsigned char *BufPtr = (const unsigned char *)Buffer->getBufferStart();
+  if (isCompressedBitcodeWrapper(BufPtr, BufPtr + Buffer->getBufferSize())) {
+    // Stream compressed modules through a decompressing streamer so that
+    // only the chunks the reader actually touches are decompressed.
+    CompressedBCStreamer *Streamer =
+      CompressedBCStreamer::create(Buffer, ErrMsg);
+    if (!Streamer)
+      return 0;
+    Module *M = new Module(Buffer->getBufferIdentifier(), Context);
+    BitcodeReader *R = new BitcodeReader(Streamer, Context);
+    // Track the underlying buffer so the usual ownership contract applies
+    // to it.
+    R->setBuffer(Buffer);
+    M->setMaterializer(R);
+    if (R->ParseBitcodeInto(M)) {
+      if (ErrMsg)
+        *ErrMsg = R->getErrorString();
+      delete M;  // Also deletes R, but not Buffer.
+      return 0;
+    }
+    R->setBufferOwned(true);
+    R->materializeForwardReferencedFunctions();
+    return M;
+  }
+
   Module *M = new Module(Buffer->getBufferIdentifier(), Context);
   BitcodeReader *R = new BitcodeReader(Buffer, Context);
   M->setMaterializer(R);
@@ -3007,12 +3599,36 @@ Module *llvm::ParseBitcodeFile(MemoryBuffer *Buffer, LLVMContext& Context,
   return M;
 }
 
+/// createReaderForBuffer - Create a BitcodeReader for a query on the given
+/// buffer, routing compressed buffers through a decompressing streamer so
+/// only the leading chunks the query touches are decompressed.  The
+/// returned reader never owns the buffer.  Returns null (filling in
+/// *ErrMsg) on a malformed compressed wrapper.
+static BitcodeReader *createReaderForBuffer(MemoryBuffer *Buffer,
+                                            LLVMContext &Context,
+                                            std::string *ErrMsg) {
+  const unsigned char *BufPtr = (const unsigned char *)Buffer->getBufferStart();
+  BitcodeReader *R;
+  if (isCompressedBitcodeWrapper(BufPtr, BufPtr + Buffer->getBufferSize())) {
+    CompressedBCStreamer *Streamer =
+      CompressedBCStreamer::create(Buffer, ErrMsg);
+    if (!Streamer)
+      return 0;
+    R = new BitcodeReader(Streamer, Context);
+  } else {
+    R = new BitcodeReader(Buffer, Context);
+  }
+  // Don't let the BitcodeReader dtor delete 'Buffer'.
+  R->setBufferOwned(false);
+  return R;
+}
+
 std::string llvm::getBitcodeTargetTriple(MemoryBuffer *Buffer,
                                          LLVMContext& Context,
                                          std::string *ErrMsg) {
-  BitcodeReader *R = new BitcodeReader(Buffer, Context);
-  // Don't let the BitcodeReader dtor delete 'Buffer'.
-  R->setBufferOwned(false);
+  BitcodeReader *R = createReaderForBuffer(Buffer, Context, ErrMsg);
+  if (!R)
+    return "";
 
   std::string Triple("");
   if (R->ParseTriple(Triple))
@@ -3022,3 +3638,19 @@ std::string llvm::getBitcodeTargetTriple(MemoryBuffer *Buffer,
   delete R;
   return Triple;
 }
+
+bool llvm::getBitcodeFunctionSummaries(MemoryBuffer *Buffer,
+                                       LLVMContext &Context,
+                                       StringMap<FunctionSummary> &Summaries,
+                                       std::string *ErrMsg) {
+  BitcodeReader *R = createReaderForBuffer(Buffer, Context, ErrMsg);
+  if (!R)
+    return true;
+
+  bool Failed = R->ParseFunctionSummaries(Summaries);
+  if (Failed && ErrMsg)
+    *ErrMsg = R->getErrorString();
+
+  delete R;
+  return Failed;
+}
@@ -17,6 +17,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Bitcode/LLVMBitCodes.h"
+#include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/GVMaterializer.h"
 #include "llvm/IR/Attributes.h"
 #include "llvm/IR/OperandTraits.h"
@@ -122,6 +123,20 @@ public:
 };
 
 class BitcodeReader : public GVMaterializer {
+public:
+  /// StagedRecord - One entry or structural marker pre-decoded from a
+  /// deferred function block by a worker thread.  Kind is a
+  /// BitstreamEntry::Kind; for Record entries, Code and Vals hold the
+  /// already-unpacked record, and for SubBlock entries Code holds the
+  /// block ID.
+  struct StagedRecord {
+    unsigned Kind;
+    unsigned Code;
+    SmallVector<uint64_t, 8> Vals;
+  };
+  typedef std::vector<StagedRecord> StagedBodyTy;
+
+private:
   LLVMContext &Context;
   Module *TheModule;
   MemoryBuffer *Buffer;
@@ -174,6 +189,25 @@ class BitcodeReader : public GVMaterializer {
   /// stream.
   DenseMap<Function*, uint64_t> DeferredFunctionInfo;
 
+  /// FunctionIndexBit - Bit offset of the function index block, when the
+  /// module has one and the input supports random access.  Zero when absent.
+  uint64_t FunctionIndexBit;
+
+  /// DeferredIsBlockStart - True when DeferredFunctionInfo was populated from
+  /// the function index, in which case the recorded offsets point at the
+  /// ENTER_SUBBLOCK for the body rather than just inside it.
+  bool DeferredIsBlockStart;
+
+  /// StagedBodies - Function bodies that have been pre-decoded into record
+  /// lists by worker threads and not yet built into IR.  The reader owns the
+  /// record lists; each is destroyed as its function is materialized.
+  DenseMap<Function*, StagedBodyTy*> StagedBodies;
+
+  /// StagedBody - When non-null, the function-body parsers read records from
+  /// this list (via the body* helpers below) instead of from Stream.
+  StagedBodyTy *StagedBody;
+  unsigned StagedIdx;
+
   /// BlockAddrFwdRefs - These are blockaddr references to basic blocks.  These
   /// are resolved lazily when functions are loaded.
   typedef std::pair<unsigned, GlobalVariable*> BlockAddrRefTy;
@@ -193,13 +227,17 @@ public:
     : Context(C), TheModule(0), Buffer(buffer), BufferOwned(false),
       LazyStreamer(0), NextUnreadBit(0), SeenValueSymbolTable(false),
       ErrorString(0), ValueList(C), MDValueList(C),
-      SeenFirstFunctionBody(false), UseRelativeIDs(false) {
+      SeenFirstFunctionBody(false), FunctionIndexBit(0),
+      DeferredIsBlockStart(false), StagedBody(0), StagedIdx(0),
+      UseRelativeIDs(false) {
   }
   explicit BitcodeReader(DataStreamer *streamer, LLVMContext &C)
     : Context(C), TheModule(0), Buffer(0), BufferOwned(false),
       LazyStreamer(streamer), NextUnreadBit(0), SeenValueSymbolTable(false),
       ErrorString(0), ValueList(C), MDValueList(C),
-      SeenFirstFunctionBody(false), UseRelativeIDs(false) {
+      SeenFirstFunctionBody(false), FunctionIndexBit(0),
+      DeferredIsBlockStart(false), StagedBody(0), StagedIdx(0),
+      UseRelativeIDs(false) {
   }
   ~BitcodeReader() {
     FreeState();
@@ -213,6 +251,11 @@ public:
   /// when the reader is destroyed.
   void setBufferOwned(bool Owned) { BufferOwned = Owned; }
 
+  /// setBuffer - Associate a MemoryBuffer with this reader even when the
+  /// bits are drawn through a streamer, so that the ownership contract of
+  /// setBufferOwned also covers streamed (e.g. compressed) buffer input.
+  void setBuffer(MemoryBuffer *B) { Buffer = B; }
+
   virtual bool isMaterializable(const GlobalValue *GV) const;
   virtual bool isDematerializable(const GlobalValue *GV) const;
   virtual bool Materialize(GlobalValue *GV, std::string *ErrInfo = 0);
@@ -233,6 +276,11 @@ public:
   /// @returns true if an error occurred.
   bool ParseTriple(std::string &Triple);
 
+  /// @brief Cheap mechanism to extract the function summary block without
+  /// materializing any function bodies.
+  /// @returns true if an error occurred.
+  bool ParseFunctionSummaries(StringMap<FunctionSummary> &Summaries);
+
   static uint64_t decodeSignRotatedValue(uint64_t V);
 
 private:
@@ -318,6 +366,22 @@ private:
     return getFnValueByID(ValNo, Ty);
   }
 
+  /// bodyAdvance and friends mirror the BitstreamCursor operations used by
+  /// the function-body parsers, but read from StagedBody when one is
+  /// attached.  With no staged body they fall through to Stream, so the
+  /// parsers behave identically in the serial path.
+  BitstreamEntry bodyAdvance();
+  BitstreamEntry bodyAdvanceSkippingSubblocks();
+  unsigned bodyReadRecord(unsigned AbbrevID, SmallVectorImpl<uint64_t> &Vals);
+  bool bodyEnterSubBlock(unsigned BlockID);
+  bool bodySkipBlock();
+
+  /// PreDecodeFunctionBodies - If enabled and the input supports random
+  /// access, decode all deferred function blocks into StagedBodies on worker
+  /// threads.  Failure is not an error; un-staged functions are simply
+  /// materialized from the stream as before.
+  void PreDecodeFunctionBodies();
+
   bool ParseModule(bool Resume);
   bool ParseAttributeBlock();
   bool ParseTypeTable();
@@ -326,12 +390,15 @@ private:
   bool ParseValueSymbolTable();
   bool ParseConstants();
   bool RememberAndSkipFunctionBody();
+  bool ParseFunctionIndex();
   bool ParseFunctionBody(Function *F);
   bool GlobalCleanup();
   bool ResolveGlobalAndAliasInits();
   bool ParseMetadata();
   bool ParseMetadataAttachment();
   bool ParseModuleTriple(std::string &Triple);
+  bool ParseModuleFunctionSummaries(StringMap<FunctionSummary> &Summaries);
+  bool ParseFunctionSummaryBlock(StringMap<FunctionSummary> &Summaries);
   bool ParseUseLists();
   bool InitStream();
   bool InitStreamFromBuffer();
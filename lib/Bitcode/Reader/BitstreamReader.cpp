@@ -8,6 +8,11 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Bitcode/BitstreamReader.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Threading.h"
+#include <cstring>
 
 using namespace llvm;
 
@@ -296,12 +301,89 @@ void BitstreamCursor::ReadAbbrevRecord() {
   CurAbbrevs.push_back(Abbv);
 }
 
+//===----------------------------------------------------------------------===//
+//  Cross-module blockinfo cache
+//===----------------------------------------------------------------------===//
+
+// All modules emitted by one writer version carry byte-identical
+// BLOCKINFO_BLOCK contents, and llvm-link and the gold plugin decode hundreds
+// of them per run.  Rather than re-parsing the abbreviation definitions for
+// every module, remember the decoded BlockInfo records keyed by a hash of the
+// block's raw bytes and splice them into subsequent readers directly.
+namespace {
+struct CachedBlockInfo {
+  /// Raw - The verbatim block contents, compared on lookup to guard against
+  /// hash collisions.
+  std::string Raw;
+  std::vector<BitstreamReader::BlockInfo> Records;
+};
+
+struct BlockInfoCache {
+  DenseMap<uint64_t, CachedBlockInfo*> Entries;
+  ~BlockInfoCache() {
+    for (DenseMap<uint64_t, CachedBlockInfo*>::iterator I = Entries.begin(),
+         E = Entries.end(); I != E; ++I) {
+      CachedBlockInfo *CBI = I->second;
+      for (unsigned i = 0, e = static_cast<unsigned>(CBI->Records.size());
+           i != e; ++i) {
+        std::vector<BitCodeAbbrev*> &Abbrevs = CBI->Records[i].Abbrevs;
+        for (unsigned j = 0, je = static_cast<unsigned>(Abbrevs.size());
+             j != je; ++j)
+          Abbrevs[j]->dropRef();
+      }
+      delete CBI;
+    }
+  }
+};
+} // end anonymous namespace
+
+static ManagedStatic<BlockInfoCache> TheBlockInfoCache;
+
 bool BitstreamCursor::ReadBlockInfoBlock() {
   // If this is the second stream to get to the block info block, skip it.
   if (BitStream->hasBlockInfoRecords())
     return SkipBlock();
 
-  if (EnterSubBlock(bitc::BLOCKINFO_BLOCK_ID)) return true;
+  unsigned NumWords = 0;
+  if (EnterSubBlock(bitc::BLOCKINFO_BLOCK_ID, &NumWords)) return true;
+
+  // When the stream is a contiguous in-memory buffer, try to satisfy this
+  // block from the cache of previously decoded ones.  The cached
+  // abbreviations are shared by reference count, which is not atomic, so
+  // stay off the cache in multithreaded mode.  Name collection
+  // (llvm-bcanalyzer) also bypasses it because cached entries are decoded
+  // without names.
+  const unsigned char *ContentStart = 0;
+  uint64_t ContentHash = 0;
+  if (BitStream->getRawStart() && BitStream->isIgnoringBlockInfoNames() &&
+      !llvm_is_multithreaded()) {
+    ContentStart = BitStream->getRawStart() + GetCurrentBitNo()/8;
+    ContentHash = hash_combine_range(ContentStart, ContentStart + NumWords*4);
+
+    if (CachedBlockInfo *CBI = TheBlockInfoCache->Entries.lookup(ContentHash)) {
+      if (CBI->Raw.size() == NumWords*4 &&
+          memcmp(CBI->Raw.data(), ContentStart, CBI->Raw.size()) == 0) {
+        // Splice the decoded records into this reader, bumping the reference
+        // count on each shared abbreviation.
+        for (unsigned i = 0, e = static_cast<unsigned>(CBI->Records.size());
+             i != e; ++i) {
+          const BitstreamReader::BlockInfo &Src = CBI->Records[i];
+          BitstreamReader::BlockInfo &Dst =
+            BitStream->getOrCreateBlockInfo(Src.BlockID);
+          Dst.Abbrevs = Src.Abbrevs;
+          for (unsigned j = 0, je = static_cast<unsigned>(Dst.Abbrevs.size());
+               j != je; ++j)
+            Dst.Abbrevs[j]->addRef();
+        }
+
+        // Position the cursor as if the block had been skipped.
+        JumpToBit(GetCurrentBitNo() + NumWords*32);
+        return ReadBlockEnd();
+      }
+      // Hash collision: decode normally and leave the cache alone.
+      ContentStart = 0;
+    }
+  }
 
   SmallVector<uint64_t, 64> Record;
   BitstreamReader::BlockInfo *CurBlockInfo = 0;
@@ -315,6 +397,21 @@ bool BitstreamCursor::ReadBlockInfoBlock() {
     case llvm::BitstreamEntry::Error:
       return true;
     case llvm::BitstreamEntry::EndBlock:
+      // Remember the decoded records for subsequent modules.
+      if (ContentStart) {
+        CachedBlockInfo *CBI = new CachedBlockInfo();
+        CBI->Raw.assign(reinterpret_cast<const char*>(ContentStart),
+                        NumWords*4);
+        CBI->Records = BitStream->getBlockInfoRecords();
+        for (unsigned i = 0, e = static_cast<unsigned>(CBI->Records.size());
+             i != e; ++i) {
+          std::vector<BitCodeAbbrev*> &Abbrevs = CBI->Records[i].Abbrevs;
+          for (unsigned j = 0, je = static_cast<unsigned>(Abbrevs.size());
+               j != je; ++j)
+            Abbrevs[j]->addRef();
+        }
+        TheBlockInfoCache->Entries[ContentHash] = CBI;
+      }
       return false;
     case llvm::BitstreamEntry::Record:
       // The interesting case.
@@ -24,6 +24,7 @@
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/ValueSymbolTable.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Compression.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Program.h"
@@ -1840,6 +1841,83 @@ static void WriteModuleUseLists(const Module *M, ValueEnumerator &VE,
 }
 
 /// WriteModule - Emit the specified module to the bitstream.
+/// WriteFunctionIndexOffsetPlaceholder - Emit a MODULE_CODE_FNINDEXOFFSET
+/// record with a fixed 32-bit zero operand, and return the bit offset of that
+/// operand so it can be backpatched with the position of the function index
+/// block once the function bodies have been written.
+static uint64_t WriteFunctionIndexOffsetPlaceholder(BitstreamWriter &Stream) {
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::MODULE_CODE_FNINDEXOFFSET));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+  unsigned AbbrevID = Stream.EmitAbbrev(Abbv);
+
+  SmallVector<uint64_t, 2> Vals;
+  Vals.push_back(bitc::MODULE_CODE_FNINDEXOFFSET);
+  Vals.push_back(0);
+  Stream.EmitRecordWithAbbrev(AbbrevID, Vals);
+
+  // The placeholder is the last 32 bits of the record.
+  return Stream.GetCurrentBitNo() - 32;
+}
+
+/// WriteFunctionIndex - Emit the table of function-number-to-bit-offset
+/// entries collected while the bodies were written, and backpatch the
+/// placeholder emitted at the top of the module block so readers can seek
+/// straight to it.
+static void WriteFunctionIndex(const std::vector<uint64_t> &Index,
+                               uint64_t OffsetPlaceholderBit,
+                               BitstreamWriter &Stream) {
+  uint64_t IndexBit = Stream.GetCurrentBitNo();
+  // The placeholder is a fixed 32-bit field.  If the module is too large for
+  // the index position to fit, leave the offset zero; readers then fall back
+  // to skipping through the stream as before.
+  if (IndexBit > uint64_t(0xFFFFFFFFULL))
+    return;
+  Stream.BackpatchWordAtBit(OffsetPlaceholderBit, uint32_t(IndexBit));
+
+  Stream.EnterSubblock(bitc::FUNCTION_INDEX_BLOCK_ID, 3);
+  SmallVector<uint64_t, 2> Vals;
+  for (unsigned i = 0, e = Index.size(); i != e; i += 2) {
+    Vals.clear();
+    Vals.push_back(Index[i]);
+    Vals.push_back(Index[i+1]);
+    Stream.EmitRecord(bitc::FNINDEX_CODE_ENTRY, Vals);
+  }
+  Stream.ExitBlock();
+}
+
+/// WriteFunctionSummary - Emit one record per function body in the module
+/// carrying the function's name, instruction count and call-site count.  A
+/// thin link reads these records to make importing decisions without
+/// materializing any bodies.
+static void WriteFunctionSummary(const Module *M, BitstreamWriter &Stream) {
+  Stream.EnterSubblock(bitc::FUNCTION_SUMMARY_BLOCK_ID, 3);
+  SmallVector<uint64_t, 64> Vals;
+  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F) {
+    if (F->isDeclaration())
+      continue;
+
+    uint64_t NumInsts = 0, NumCalls = 0;
+    for (Function::const_iterator BB = F->begin(), BE = F->end();
+         BB != BE; ++BB)
+      for (BasicBlock::const_iterator I = BB->begin(), IE = BB->end();
+           I != IE; ++I) {
+        ++NumInsts;
+        if (isa<CallInst>(I) || isa<InvokeInst>(I))
+          ++NumCalls;
+      }
+
+    Vals.clear();
+    Vals.push_back(NumInsts);
+    Vals.push_back(NumCalls);
+    StringRef Name = F->getName();
+    for (unsigned i = 0, e = Name.size(); i != e; ++i)
+      Vals.push_back((unsigned char)Name[i]);
+    Stream.EmitRecord(bitc::FNSUMMARY_CODE_ENTRY, Vals);
+  }
+  Stream.ExitBlock();
+}
+
 static void WriteModule(const Module *M, BitstreamWriter &Stream) {
   Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
 
@@ -1848,6 +1926,10 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream) {
   Vals.push_back(CurVersion);
   Stream.EmitRecord(bitc::MODULE_CODE_VERSION, Vals);
 
+  // Reserve space for the offset of the function index block.
+  uint64_t FnIndexOffsetPlaceholder =
+    WriteFunctionIndexOffsetPlaceholder(Stream);
+
   // Analyze the module, enumerating globals, functions, etc.
   ValueEnumerator VE(M);
 
@@ -1880,10 +1962,25 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream) {
   if (EnablePreserveUseListOrdering)
     WriteModuleUseLists(M, VE, Stream);
 
-  // Emit function bodies.
-  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
-    if (!F->isDeclaration())
+  // Emit function bodies, remembering where each one lands so the function
+  // index can be emitted afterwards.
+  std::vector<uint64_t> FunctionIndex;  // (function #, bit offset) pairs.
+  unsigned FnNumber = 0;
+  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F) {
+    if (!F->isDeclaration()) {
+      FunctionIndex.push_back(FnNumber);
+      FunctionIndex.push_back(Stream.GetCurrentBitNo());
       WriteFunction(*F, VE, Stream);
+    }
+    ++FnNumber;
+  }
+
+  // Emit the function index and backpatch its offset into the placeholder.
+  WriteFunctionIndex(FunctionIndex, FnIndexOffsetPlaceholder, Stream);
+
+  // Emit per-function summaries so a thin link can decide which bodies to
+  // import without reading them.
+  WriteFunctionSummary(M, Stream);
 
   Stream.ExitBlock();
 }
@@ -1995,3 +2092,55 @@ void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out) {
   // Write the generated bitstream to "Out".
   Out.write((char*)&Buffer.front(), Buffer.size());
 }
+
+/// WriteCompressedBitcodeToFile - Write the specified module to the
+/// specified output stream inside the compressed container described at
+/// isCompressedBitcodeWrapper in ReaderWriter.h.
+void llvm::WriteCompressedBitcodeToFile(const Module *M, raw_ostream &Out,
+                                        unsigned ChunkSize) {
+  if (ChunkSize == 0)
+    ChunkSize = 256*1024;
+
+  // Emit the ordinary bitcode file into a buffer.
+  SmallVector<char, 0> BC;
+  {
+    raw_svector_ostream OS(BC);
+    WriteBitcodeToFile(M, OS);
+  }
+
+  unsigned NumChunks = (BC.size() + ChunkSize - 1) / ChunkSize;
+
+  // Compress the chunks, accumulating the payload and the index.  A chunk
+  // that does not shrink is stored raw, which the index encodes as
+  // CompressedSize == UncompressedSize.
+  SmallVector<char, 0> Payload;
+  SmallVector<char, 0> Header;
+  Header.resize(4*4 + 8*NumChunks);
+  uint32_t Position = 0;
+  WriteInt32ToBuffer(0x0B17C0DF, Header, Position);
+  WriteInt32ToBuffer(0         , Header, Position); // Version.
+  WriteInt32ToBuffer(ChunkSize , Header, Position);
+  WriteInt32ToBuffer(NumChunks , Header, Position);
+
+  SmallVector<char, 0> Scratch;
+  for (unsigned i = 0; i != NumChunks; ++i) {
+    size_t Offset = (size_t)i * ChunkSize;
+    size_t Size = std::min((size_t)ChunkSize, BC.size() - Offset);
+    StringRef Chunk(&BC[Offset], Size);
+
+    Scratch.clear();
+    compression::compress(Chunk, Scratch);
+    if (Scratch.size() < Size) {
+      WriteInt32ToBuffer(Scratch.size(), Header, Position);
+      Payload.append(Scratch.begin(), Scratch.end());
+    } else {
+      WriteInt32ToBuffer(Size, Header, Position);
+      Payload.append(Chunk.begin(), Chunk.end());
+    }
+    WriteInt32ToBuffer(Size, Header, Position);
+  }
+
+  Out.write(&Header.front(), Header.size());
+  if (!Payload.empty())
+    Out.write(&Payload.front(), Payload.size());
+}
@@ -19,11 +19,21 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/ValueSymbolTable.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 using namespace llvm;
 
+// Reordering the constant pool by use frequency gives a denser encoding, but
+// the sort re-queries type IDs for every comparison and is a measurable part
+// of write time on large (LTO-merged) modules.  This trades a slightly larger
+// file for a faster write.
+static cl::opt<bool>
+FastBitcodeEmission("bitcode-fast-emit", cl::Hidden, cl::init(false),
+  cl::desc("Skip constant pool reordering when writing bitcode; "
+           "faster writes, slightly larger files"));
+
 static bool isIntOrIntVectorValue(const std::pair<const Value*, unsigned> &V) {
   return V.first->getType()->isIntOrIntVectorTy();
 }
@@ -189,8 +199,10 @@ namespace {
 void ValueEnumerator::OptimizeConstants(unsigned CstStart, unsigned CstEnd) {
   if (CstStart == CstEnd || CstStart+1 == CstEnd) return;
 
-  CstSortPredicate P(*this);
-  std::stable_sort(Values.begin()+CstStart, Values.begin()+CstEnd, P);
+  if (!FastBitcodeEmission) {
+    CstSortPredicate P(*this);
+    std::stable_sort(Values.begin()+CstStart, Values.begin()+CstEnd, P);
+  }
 
   // Ensure that integer and vector of integer constants are at the start of the
   // constant pool.  This is important so that GEP structure indices come before
@@ -15,6 +15,7 @@
 #include "llvm/CodeGen/AsmPrinter.h"
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/CodeGen/MachineBasicBlock.h"
 #include "llvm/CodeGen/MachineModuleInfo.h"
@@ -28,7 +29,9 @@
 #include "llvm/MC/MCSymbol.h"
 #include "llvm/MC/MCTargetAsmParser.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/raw_ostream.h"
@@ -235,15 +238,81 @@ static void EmitMSInlineAsmStr(const char *AsmStr, const MachineInstr *MI,
   OS << "\n\t.att_syntax\n" << (char)0;  // null terminate string.
 }
 
-static void EmitGCCInlineAsmStr(const char *AsmStr, const MachineInstr *MI,
-                                MachineModuleInfo *MMI, int InlineAsmVariant,
-                                int AsmPrinterVariant, AsmPrinter *AP,
-                                unsigned LocCookie, raw_ostream &OS) {
+namespace {
+  /// CompiledAsmTemplate - The variant-resolved action sequence for one GCC
+  /// inline asm template string.  Lowering commonly emits the same few
+  /// templates an enormous number of times, so the template is scanned once
+  /// and replayed per instance; the only per-instance work left is mapping
+  /// operand numbers onto the MachineInstr and printing the operands.
+  struct CompiledAsmTemplate {
+    enum ActionKind {
+      Literal,   ///< Emit Len template bytes starting at Begin.
+      Char,      ///< Emit the single character Payload.
+      Special,   ///< PrintSpecial on the template text [Begin, Begin+Len).
+      Operand    ///< Print asm operand AsmOpNo, modified by Payload if set.
+    };
+
+    struct Action {
+      uint8_t Kind;
+      /// Payload - The character for Char actions, or the operand modifier
+      /// (0 if none) for Operand actions.
+      char Payload;
+      /// Active - For Operand actions, whether the reference is in the
+      /// selected assembler variant.  Inactive references are not printed
+      /// but still have their operand numbers validated.
+      bool Active;
+      unsigned Begin;
+      unsigned Len;
+      unsigned AsmOpNo;
+    };
+
+    SmallVector<Action, 8> Actions;
+
+    void addLiteral(unsigned Begin, unsigned Len) {
+      Action A = { Literal, 0, true, Begin, Len, 0 };
+      Actions.push_back(A);
+    }
+    void addChar(char C) {
+      Action A = { Char, C, true, 0, 0, 0 };
+      Actions.push_back(A);
+    }
+    void addSpecial(unsigned Begin, unsigned Len) {
+      Action A = { Special, 0, true, Begin, Len, 0 };
+      Actions.push_back(A);
+    }
+    void addOperand(unsigned AsmOpNo, char Modifier, bool Active) {
+      Action A = { Operand, Modifier, Active, 0, 0, AsmOpNo };
+      Actions.push_back(A);
+    }
+  };
+
+  /// AsmTemplateCache - Process-wide cache of compiled templates, keyed by
+  /// template contents and assembler variant.  Content keying makes the
+  /// cache safe across modules and contexts; the lock is only held around
+  /// lookup and compilation, entries are immutable afterwards.
+  struct AsmTemplateCache {
+    sys::SmartMutex<true> Lock;
+    StringMap<CompiledAsmTemplate*> Templates;
+
+    ~AsmTemplateCache() {
+      for (StringMap<CompiledAsmTemplate*>::iterator I = Templates.begin(),
+             E = Templates.end(); I != E; ++I)
+        delete I->second;
+    }
+  };
+}
+
+static ManagedStatic<AsmTemplateCache> CompiledTemplates;
+
+/// compileGCCAsmTemplate - Scan a GCC inline asm template once, resolving
+/// escapes and {.|.} assembler variant regions, and record the resulting
+/// action sequence.  Malformed templates are fatal here, exactly as they
+/// were when the scan ran per instance.
+static CompiledAsmTemplate *compileGCCAsmTemplate(const char *AsmStr,
+                                                  int AsmPrinterVariant) {
+  CompiledAsmTemplate *T = new CompiledAsmTemplate();
   int CurVariant = -1;            // The number of the {.|.|.} region we are in.
   const char *LastEmitted = AsmStr; // One past the last character emitted.
-  unsigned NumOperands = MI->getNumOperands();
-
-  OS << '\t';
 
   while (*LastEmitted) {
     switch (*LastEmitted) {
@@ -254,13 +323,13 @@ static void EmitGCCInlineAsmStr(const char *AsmStr, const MachineInstr *MI,
              *LiteralEnd != '}' && *LiteralEnd != '$' && *LiteralEnd != '\n')
         ++LiteralEnd;
       if (CurVariant == -1 || CurVariant == AsmPrinterVariant)
-        OS.write(LastEmitted, LiteralEnd-LastEmitted);
+        T->addLiteral(LastEmitted-AsmStr, LiteralEnd-LastEmitted);
       LastEmitted = LiteralEnd;
       break;
     }
     case '\n':
       ++LastEmitted;   // Consume newline character.
-      OS << '\n';      // Indent code with newline.
+      T->addChar('\n'); // Indent code with newline.
       break;
     case '$': {
       ++LastEmitted;   // Consume '$' character.
@@ -271,7 +340,7 @@ static void EmitGCCInlineAsmStr(const char *AsmStr, const MachineInstr *MI,
       default: Done = false; break;
       case '$':     // $$ -> $
         if (CurVariant == -1 || CurVariant == AsmPrinterVariant)
-          OS << '$';
+          T->addChar('$');
         ++LastEmitted;  // Consume second '$' character.
         break;
       case '(':             // $( -> same as GCC's { character.
@@ -284,14 +353,14 @@ static void EmitGCCInlineAsmStr(const char *AsmStr, const MachineInstr *MI,
       case '|':
         ++LastEmitted;  // consume '|' character.
         if (CurVariant == -1)
-          OS << '|';       // this is gcc's behavior for | outside a variant
+          T->addChar('|'); // this is gcc's behavior for | outside a variant
         else
           ++CurVariant;   // We're in the next variant.
         break;
       case ')':         // $) -> same as GCC's } char.
         ++LastEmitted;  // consume ')' character.
         if (CurVariant == -1)
-          OS << '}';     // this is gcc's behavior for } outside a variant
+          T->addChar('}'); // this is gcc's behavior for } outside a variant
         else
           CurVariant = -1;
         break;
@@ -315,8 +384,7 @@ static void EmitGCCInlineAsmStr(const char *AsmStr, const MachineInstr *MI,
           report_fatal_error("Unterminated ${:foo} operand in inline asm"
                              " string: '" + Twine(AsmStr) + "'");
 
-        std::string Val(StrStart, StrEnd);
-        AP->PrintSpecial(MI, OS, Val.c_str());
+        T->addSpecial(StrStart-AsmStr, StrEnd-StrStart);
         LastEmitted = StrEnd+1;
         break;
       }
@@ -331,7 +399,7 @@ static void EmitGCCInlineAsmStr(const char *AsmStr, const MachineInstr *MI,
                            Twine(AsmStr) + "'");
       LastEmitted = IDEnd;
 
-      char Modifier[2] = { 0, 0 };
+      char Modifier = 0;
 
       if (HasCurlyBraces) {
         // If we have curly braces, check for a modifier character.  This
@@ -342,7 +410,7 @@ static void EmitGCCInlineAsmStr(const char *AsmStr, const MachineInstr *MI,
             report_fatal_error("Bad ${:} expression in inline asm string: '" +
                                Twine(AsmStr) + "'");
 
-          Modifier[0] = *LastEmitted;
+          Modifier = *LastEmitted;
           ++LastEmitted;    // Consume modifier character.
         }
 
@@ -352,54 +420,107 @@ static void EmitGCCInlineAsmStr(const char *AsmStr, const MachineInstr *MI,
         ++LastEmitted;    // Consume '}' character.
       }
 
+      T->addOperand(Val, Modifier,
+                    CurVariant == -1 || CurVariant == AsmPrinterVariant);
+      break;
+    }
+    }
+  }
+  return T;
+}
+
+/// getCompiledTemplate - Return the compiled form of the given template,
+/// compiling and caching it on first sight.
+static const CompiledAsmTemplate &getCompiledTemplate(const char *AsmStr,
+                                                      int AsmPrinterVariant) {
+  SmallString<256> Key;
+  Key += AsmStr;
+  Key.push_back('\0');
+  Key.push_back(char('0' + AsmPrinterVariant));
+
+  sys::SmartScopedLock<true> Guard(CompiledTemplates->Lock);
+  CompiledAsmTemplate *&Entry =
+    CompiledTemplates->Templates.GetOrCreateValue(Key.str()).getValue();
+  if (!Entry)
+    Entry = compileGCCAsmTemplate(AsmStr, AsmPrinterVariant);
+  return *Entry;
+}
+
+static void EmitGCCInlineAsmStr(const char *AsmStr, const MachineInstr *MI,
+                                MachineModuleInfo *MMI, int InlineAsmVariant,
+                                int AsmPrinterVariant, AsmPrinter *AP,
+                                unsigned LocCookie, raw_ostream &OS) {
+  const CompiledAsmTemplate &T = getCompiledTemplate(AsmStr, AsmPrinterVariant);
+  unsigned NumOperands = MI->getNumOperands();
+
+  OS << '\t';
+
+  for (unsigned i = 0, e = T.Actions.size(); i != e; ++i) {
+    const CompiledAsmTemplate::Action &A = T.Actions[i];
+    switch (A.Kind) {
+    case CompiledAsmTemplate::Literal:
+      OS.write(AsmStr+A.Begin, A.Len);
+      break;
+    case CompiledAsmTemplate::Char:
+      OS << A.Payload;
+      break;
+    case CompiledAsmTemplate::Special: {
+      std::string Val(AsmStr+A.Begin, AsmStr+A.Begin+A.Len);
+      AP->PrintSpecial(MI, OS, Val.c_str());
+      break;
+    }
+    case CompiledAsmTemplate::Operand: {
+      unsigned Val = A.AsmOpNo;
       if (Val >= NumOperands-1)
         report_fatal_error("Invalid $ operand number in inline asm string: '" +
                            Twine(AsmStr) + "'");
 
       // Okay, we finally have a value number.  Ask the target to print this
       // operand!
-      if (CurVariant == -1 || CurVariant == AsmPrinterVariant) {
-        unsigned OpNo = InlineAsm::MIOp_FirstOperand;
+      if (!A.Active)
+        break;
 
-        bool Error = false;
+      char Modifier[2] = { A.Payload, 0 };
+      unsigned OpNo = InlineAsm::MIOp_FirstOperand;
 
-        // Scan to find the machine operand number for the operand.
-        for (; Val; --Val) {
-          if (OpNo >= MI->getNumOperands()) break;
-          unsigned OpFlags = MI->getOperand(OpNo).getImm();
-          OpNo += InlineAsm::getNumOperandRegisters(OpFlags) + 1;
-        }
+      bool Error = false;
 
-        // We may have a location metadata attached to the end of the
-        // instruction, and at no point should see metadata at any
-        // other point while processing. It's an error if so.
-        if (OpNo >= MI->getNumOperands() ||
-            MI->getOperand(OpNo).isMetadata()) {
-          Error = true;
-        } else {
-          unsigned OpFlags = MI->getOperand(OpNo).getImm();
-          ++OpNo;  // Skip over the ID number.
-
-          if (Modifier[0] == 'l')  // labels are target independent
-            // FIXME: What if the operand isn't an MBB, report error?
-            OS << *MI->getOperand(OpNo).getMBB()->getSymbol();
-          else {
-            if (InlineAsm::isMemKind(OpFlags)) {
-              Error = AP->PrintAsmMemoryOperand(MI, OpNo, InlineAsmVariant,
-                                                Modifier[0] ? Modifier : 0,
-                                                OS);
-            } else {
-              Error = AP->PrintAsmOperand(MI, OpNo, InlineAsmVariant,
-                                          Modifier[0] ? Modifier : 0, OS);
-            }
+      // Scan to find the machine operand number for the operand.
+      for (; Val; --Val) {
+        if (OpNo >= MI->getNumOperands()) break;
+        unsigned OpFlags = MI->getOperand(OpNo).getImm();
+        OpNo += InlineAsm::getNumOperandRegisters(OpFlags) + 1;
+      }
+
+      // We may have a location metadata attached to the end of the
+      // instruction, and at no point should see metadata at any
+      // other point while processing. It's an error if so.
+      if (OpNo >= MI->getNumOperands() ||
+          MI->getOperand(OpNo).isMetadata()) {
+        Error = true;
+      } else {
+        unsigned OpFlags = MI->getOperand(OpNo).getImm();
+        ++OpNo;  // Skip over the ID number.
+
+        if (Modifier[0] == 'l')  // labels are target independent
+          // FIXME: What if the operand isn't an MBB, report error?
+          OS << *MI->getOperand(OpNo).getMBB()->getSymbol();
+        else {
+          if (InlineAsm::isMemKind(OpFlags)) {
+            Error = AP->PrintAsmMemoryOperand(MI, OpNo, InlineAsmVariant,
+                                              Modifier[0] ? Modifier : 0,
+                                              OS);
+          } else {
+            Error = AP->PrintAsmOperand(MI, OpNo, InlineAsmVariant,
+                                        Modifier[0] ? Modifier : 0, OS);
           }
         }
-        if (Error) {
-          std::string msg;
-          raw_string_ostream Msg(msg);
-          Msg << "invalid operand in inline asm: '" << AsmStr << "'";
-          MMI->getModule()->getContext().emitError(LocCookie, Msg.str());
-        }
+      }
+      if (Error) {
+        std::string msg;
+        raw_string_ostream Msg(msg);
+        Msg << "invalid operand in inline asm: '" << AsmStr << "'";
+        MMI->getModule()->getContext().emitError(LocCookie, Msg.str());
       }
       break;
     }
@@ -131,9 +131,10 @@ namespace llvm {
 
     DIE *Parent;
 
-    /// Attribute values.
+    /// Attribute values.  Sized for the common DIE; keeping the inline
+    /// storage small matters, as -g LTO links hold millions of these.
     ///
-    SmallVector<DIEValue*, 32> Values;
+    SmallVector<DIEValue*, 12> Values;
 
     // Private data for print()
     mutable unsigned IndentCount;
@@ -150,7 +151,7 @@ namespace llvm {
     unsigned getOffset() const { return Offset; }
     unsigned getSize() const { return Size; }
     const std::vector<DIE *> &getChildren() const { return Children; }
-    const SmallVector<DIEValue*, 32> &getValues() const { return Values; }
+    const SmallVectorImpl<DIEValue*> &getValues() const { return Values; }
     DIE *getParent() const { return Parent; }
     void setTag(unsigned Tag) { Abbrev.setTag(Tag); }
     void setOffset(unsigned O) { Offset = O; }
@@ -175,6 +176,15 @@ namespace llvm {
       Child->Parent = this;
     }
 
+    /// releaseChildren - Recursively delete the children of this DIE, for
+    /// emitters that stream units out one at a time and discard each tree
+    /// once its bytes have been written.
+    void releaseChildren() {
+      for (unsigned i = 0, N = Children.size(); i != N; ++i)
+        delete Children[i];
+      std::vector<DIE *>().swap(Children);
+    }
+
 #ifndef NDEBUG
     void print(raw_ostream &O, unsigned IncIndent = 0);
     void dump();
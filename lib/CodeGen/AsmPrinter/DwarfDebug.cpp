@@ -78,6 +78,11 @@ static cl::opt<DefaultOnOff> DarwinGDBCompat("darwin-gdb-compat", cl::Hidden,
                 clEnumValEnd),
      cl::init(Default));
 
+static cl::opt<bool> EagerDIERelease("dwarf-eager-die-release", cl::Hidden,
+     cl::desc("Release each compile unit's DIE tree as soon as it has been "
+              "emitted"),
+     cl::init(true));
+
 static cl::opt<DefaultOnOff> SplitDwarf("split-dwarf", cl::Hidden,
      cl::desc("Output prototype dwarf split debug info."),
      cl::values(
@@ -199,6 +204,9 @@ DwarfDebug::DwarfDebug(AsmPrinter *A, Module *M)
   }
 }
 DwarfDebug::~DwarfDebug() {
+  // The abbreviation lists own their entries; see assignAbbrevNumber.
+  DeleteContainerPointers(Abbreviations);
+  DeleteContainerPointers(SkeletonAbbrevs);
 }
 
 // Switch to the specified MCSection and emit an assembler
@@ -253,19 +261,26 @@ void DwarfUnits::assignAbbrevNumber(DIEAbbrev &Abbrev) {
   Abbrev.Profile(ID);
 
   // Check the set for priors.
-  DIEAbbrev *InSet = AbbreviationsSet->GetOrInsertNode(&Abbrev);
-
-  // If it's newly added.
-  if (InSet == &Abbrev) {
-    // Add to abbreviation list.
-    Abbreviations->push_back(&Abbrev);
+  void *InsertPos;
+  DIEAbbrev *InSet = AbbreviationsSet->FindNodeOrInsertPos(ID, InsertPos);
+
+  // If it's newly seen, the set and list keep their own copy rather than
+  // pointing into the DIE, so that an emitted unit's DIE tree can be
+  // released before the abbrev section is written.
+  if (!InSet) {
+    DIEAbbrev *Copy = new DIEAbbrev(Abbrev.getTag(), Abbrev.getChildrenFlag());
+    const SmallVector<DIEAbbrevData, 8> &Data = Abbrev.getData();
+    for (unsigned i = 0, N = Data.size(); i != N; ++i)
+      Copy->AddAttribute(Data[i].getAttribute(), Data[i].getForm());
+    AbbreviationsSet->InsertNode(Copy, InsertPos);
+    Abbreviations->push_back(Copy);
 
     // Assign the vector position + 1 as its number.
-    Abbrev.setNumber(Abbreviations->size());
-  } else {
-    // Assign existing abbreviation number.
-    Abbrev.setNumber(InSet->getNumber());
+    Copy->setNumber(Abbreviations->size());
+    InSet = Copy;
   }
+
+  Abbrev.setNumber(InSet->getNumber());
 }
 
 // If special LLVM prefix that is used to inform the asm
@@ -1722,7 +1737,7 @@ DwarfUnits::computeSizeAndOffset(DIE *Die, unsigned Offset) {
   // Start the size with the size of abbreviation code.
   Offset += MCAsmInfo::getULEB128Size(AbbrevNumber);
 
-  const SmallVector<DIEValue*, 32> &Values = Die->getValues();
+  const SmallVectorImpl<DIEValue*> &Values = Die->getValues();
   const SmallVector<DIEAbbrevData, 8> &AbbrevData = Abbrev->getData();
 
   // Size the DIE attribute values.
@@ -1811,7 +1826,7 @@ void DwarfDebug::emitDIE(DIE *Die, std::vector<DIEAbbrev *> *Abbrevs) {
                                 dwarf::TagString(Abbrev->getTag()));
   Asm->EmitULEB128(AbbrevNumber);
 
-  const SmallVector<DIEValue*, 32> &Values = Die->getValues();
+  const SmallVectorImpl<DIEValue*> &Values = Die->getValues();
   const SmallVector<DIEAbbrevData, 8> &AbbrevData = Abbrev->getData();
 
   // Emit the DIE attribute values.
@@ -1922,6 +1937,15 @@ void DwarfUnits::emitUnits(DwarfDebug *DD,
     DD->emitDIE(Die, Abbreviations);
     Asm->OutStreamer.EmitLabel(Asm->GetTempSymbol(USection->getLabelEndName(),
                                                   TheCU->getUniqueID()));
+
+    // Nothing reads this unit's DIE tree again once its bytes are out,
+    // unless the accelerator tables or the darwin gdb compat sections need
+    // DIE offsets later.  Drop the tree now instead of holding every unit
+    // in memory until the module is torn down; on big -g LTO links this is
+    // most of the debug-info footprint.
+    if (EagerDIERelease && !DD->useDwarfAccelTables() &&
+        !DD->useDarwinGDBCompat())
+      Die->releaseChildren();
   }
 }
 
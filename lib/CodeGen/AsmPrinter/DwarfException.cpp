@@ -30,6 +30,7 @@
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/LEB128.h"
 #include "llvm/Target/Mangler.h"
 #include "llvm/Target/TargetFrameLowering.h"
 #include "llvm/Target/TargetLoweringObjectFile.h"
@@ -101,6 +102,24 @@ ComputeActionsTable(const SmallVectorImpl<const LandingPadInfo*> &LandingPads,
   // output using a fixed width encoding.  FilterOffsets[i] holds the byte
   // offset corresponding to FilterIds[i].
 
+  // Functions with the same EH shape share one actions table computation;
+  // see ActionTableCache.
+  std::vector<int> Signature;
+  for (SmallVectorImpl<const LandingPadInfo *>::const_iterator
+         I = LandingPads.begin(), E = LandingPads.end(); I != E; ++I) {
+    const std::vector<int> &TypeIds = (*I)->TypeIds;
+    Signature.push_back(TypeIds.size());
+    Signature.insert(Signature.end(), TypeIds.begin(), TypeIds.end());
+  }
+  std::map<std::vector<int>, CachedActionTable>::const_iterator Cached =
+    ActionTableCache.find(Signature);
+  if (Cached != ActionTableCache.end()) {
+    const CachedActionTable &CAT = Cached->second;
+    Actions.append(CAT.Actions.begin(), CAT.Actions.end());
+    FirstActions.append(CAT.FirstActions.begin(), CAT.FirstActions.end());
+    return CAT.SizeActions;
+  }
+
   const std::vector<unsigned> &FilterIds = MMI->getFilterIds();
   SmallVector<int, 16> FilterOffsets;
   FilterOffsets.reserve(FilterIds.size());
@@ -179,6 +198,11 @@ ComputeActionsTable(const SmallVectorImpl<const LandingPadInfo*> &LandingPads,
     PrevLPI = LPI;
   }
 
+  CachedActionTable &CAT = ActionTableCache[Signature];
+  CAT.Actions.assign(Actions.begin(), Actions.end());
+  CAT.FirstActions.assign(FirstActions.begin(), FirstActions.end());
+  CAT.SizeActions = SizeActions;
+
   return SizeActions;
 }
 
@@ -630,7 +654,26 @@ void DwarfException::EmitExceptionTable() {
     }
   }
 
-  // Emit the Action Table.
+  // Emit the Action Table.  When no per-entry comments are wanted, render the
+  // whole table into a buffer and hand it to the streamer in one piece; the
+  // entries are plain LEB pairs with no relocations, so there is no need to
+  // go through the directive machinery for each byte.
+  if (!VerboseAsm) {
+    SmallString<64> ActionBytes;
+    raw_svector_ostream ActionOS(ActionBytes);
+    for (SmallVectorImpl<ActionEntry>::const_iterator
+           I = Actions.begin(), E = Actions.end(); I != E; ++I) {
+      encodeSLEB128(I->ValueForTypeID, ActionOS);
+      encodeSLEB128(I->NextAction, ActionOS);
+    }
+    Asm->OutStreamer.EmitBytes(ActionOS.str(), 0);
+
+    EmitTypeInfos(TTypeEncoding);
+
+    Asm->EmitAlignment(2);
+    return;
+  }
+
   int Entry = 0;
   for (SmallVectorImpl<ActionEntry>::const_iterator
          I = Actions.begin(), E = Actions.end(); I != E; ++I) {
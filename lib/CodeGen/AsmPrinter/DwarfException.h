@@ -16,6 +16,7 @@
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/CodeGen/AsmPrinter.h"
+#include <map>
 #include <vector>
 
 namespace llvm {
@@ -78,8 +79,24 @@ protected:
     unsigned Action;
   };
 
+  /// CachedActionTable - A fully computed actions table for one EH shape.
+  /// Generated code is full of functions whose landing pads list identical
+  /// type ids, and the actions table depends only on that shape (filter
+  /// offsets are stable within a module because the filter id list is
+  /// append-only), so the table is computed once per shape and replayed.
+  struct CachedActionTable {
+    std::vector<ActionEntry> Actions;
+    std::vector<unsigned> FirstActions;
+    unsigned SizeActions;
+  };
+
+  /// ActionTableCache - Maps the flattened type-id signature of a function's
+  /// landing pads to its memoized actions table.
+  std::map<std::vector<int>, CachedActionTable> ActionTableCache;
+
   /// ComputeActionsTable - Compute the actions table and gather the first
-  /// action index for each landing pad site.
+  /// action index for each landing pad site.  Results are memoized in
+  /// ActionTableCache across functions with the same EH shape.
   unsigned ComputeActionsTable(const SmallVectorImpl<const LandingPadInfo*>&LPs,
                                SmallVectorImpl<ActionEntry> &Actions,
                                SmallVectorImpl<unsigned> &FirstActions);
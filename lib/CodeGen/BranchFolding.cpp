@@ -46,11 +46,14 @@ STATISTIC(NumHoist     , "Number of times common instructions are hoisted");
 static cl::opt<cl::boolOrDefault> FlagEnableTailMerge("enable-tail-merge",
                               cl::init(cl::BOU_UNSET), cl::Hidden);
 
-// Throttle for huge numbers of predecessors (compile speed problems)
+// Throttle for huge numbers of predecessors (compile speed problems).  Since
+// candidate pairs are rejected via cached tail hashes before their
+// instructions are compared, a much larger pool than the historical 150 is
+// affordable.
 static cl::opt<unsigned>
 TailMergeThreshold("tail-merge-threshold",
           cl::desc("Max number of predecessors to consider tail merging"),
-          cl::init(150), cl::Hidden);
+          cl::init(1000), cl::Hidden);
 
 // Heuristic for tail merging (and, inversely, tail duplication).
 // TODO: This should be replaced with a target query.
@@ -299,6 +302,53 @@ static unsigned HashEndOfMBB(const MachineBasicBlock *MBB) {
   return HashMachineInstr(I);
 }
 
+/// ComputeTailHashes - Populate the tail hash cache entry for MBB: the
+/// rolling hashes of its last TailHashLimit non-debug instructions.
+void BranchFolder::ComputeTailHashes(const MachineBasicBlock *MBB) {
+  std::pair<TailHashCacheTy::iterator, bool> P =
+    TailHashCache.insert(std::make_pair(MBB, TailHashesTy()));
+  if (!P.second)
+    return;   // Already cached.
+
+  TailHashesTy &Hashes = P.first->second;
+  unsigned Hash = 0;
+  for (MachineBasicBlock::const_iterator I = MBB->end(), B = MBB->begin();
+       I != B && Hashes.size() < TailHashLimit; ) {
+    --I;
+    // Skip debug info so it will not affect codegen.
+    if (I->isDebugValue())
+      continue;
+    Hash = Hash*33 + HashMachineInstr(I);
+    Hashes.push_back(Hash);
+  }
+}
+
+/// CommonTailHashLength - Return the number of positions for which the cached
+/// rolling tail hashes of MBB1 and MBB2 agree.  Identical instructions hash
+/// identically, so this is an upper bound on the length of the blocks' common
+/// tail unless it equals TailHashLimit, where the cached hashes run out.
+/// WholeMBB1/WholeMBB2 indicate that the agreement extends through all cached
+/// positions of the respective block, i.e. the common tail may cover it
+/// entirely.
+unsigned BranchFolder::CommonTailHashLength(const MachineBasicBlock *MBB1,
+                                            const MachineBasicBlock *MBB2,
+                                            bool &WholeMBB1, bool &WholeMBB2) {
+  // Take the references only after both entries exist; inserting into the
+  // DenseMap may relocate earlier entries.
+  ComputeTailHashes(MBB1);
+  ComputeTailHashes(MBB2);
+  const TailHashesTy &Hashes1 = TailHashCache.find(MBB1)->second;
+  const TailHashesTy &Hashes2 = TailHashCache.find(MBB2)->second;
+
+  unsigned MaxLen = std::min(Hashes1.size(), Hashes2.size());
+  unsigned Len = 0;
+  while (Len != MaxLen && Hashes1[Len] == Hashes2[Len])
+    ++Len;
+  WholeMBB1 = Len == Hashes1.size();
+  WholeMBB2 = Len == Hashes2.size();
+  return Len;
+}
+
 /// ComputeCommonTailLength - Given two machine basic blocks, compute the number
 /// of instructions they actually have in common together at their end.  Return
 /// iterators for the first shared instruction in each block.
@@ -518,14 +568,30 @@ static unsigned CountTerminators(MachineBasicBlock *MBB,
 /// and decide if it would be profitable to merge those tails.  Return the
 /// length of the common tail and iterators to the first common instruction
 /// in each block.
-static bool ProfitableToMerge(MachineBasicBlock *MBB1,
-                              MachineBasicBlock *MBB2,
-                              unsigned minCommonTailLength,
-                              unsigned &CommonTailLen,
-                              MachineBasicBlock::iterator &I1,
-                              MachineBasicBlock::iterator &I2,
-                              MachineBasicBlock *SuccBB,
-                              MachineBasicBlock *PredBB) {
+bool BranchFolder::ProfitableToMerge(MachineBasicBlock *MBB1,
+                                     MachineBasicBlock *MBB2,
+                                     unsigned minCommonTailLength,
+                                     unsigned &CommonTailLen,
+                                     MachineBasicBlock::iterator &I1,
+                                     MachineBasicBlock::iterator &I2,
+                                     MachineBasicBlock *SuccBB,
+                                     MachineBasicBlock *PredBB) {
+  // Before walking the blocks instruction by instruction, bound the length of
+  // the common tail with the cached rolling tail hashes.  Most candidate
+  // pairs within a hash bucket share only their final instruction; they can
+  // be rejected here without their operands ever being compared, as long as
+  // none of the short-tail special cases below could apply: neither block is
+  // the fall-through predecessor, the tail cannot cover either block
+  // entirely, and it is too short even with the stripped unconditional
+  // branch counted.
+  bool WholeMBB1, WholeMBB2;
+  unsigned HashTailLen = CommonTailHashLength(MBB1, MBB2, WholeMBB1,
+                                              WholeMBB2);
+  if (HashTailLen < TailHashLimit && !WholeMBB1 && !WholeMBB2 &&
+      MBB1 != PredBB && MBB2 != PredBB &&
+      HashTailLen + 1 < minCommonTailLength)
+    return false;
+
   CommonTailLen = ComputeCommonTailLength(MBB1, MBB2, I1, I2);
   if (CommonTailLen == 0)
     return false;
@@ -728,6 +794,13 @@ bool BranchFolder::TryTailMergeBlocks(MachineBasicBlock *SuccBB,
   // together.
   std::stable_sort(MergePotentials.begin(), MergePotentials.end());
 
+  // The rolling tail hashes are valid for the duration of this run: every
+  // block whose tail is modified below is erased from MergePotentials at the
+  // same time (a split block's worklist entry is repointed at the tail-only
+  // half, whose trailing instructions are unchanged), so it is never hashed
+  // or compared again.
+  TailHashCache.clear();
+
   // Walk through equivalence sets looking for actual exact matches.
   while (MergePotentials.size() > 1) {
     unsigned CurHash = MergePotentials.back().getHash();
@@ -10,7 +10,9 @@
 #ifndef LLVM_CODEGEN_BRANCHFOLDING_HPP
 #define LLVM_CODEGEN_BRANCHFOLDING_HPP
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/CodeGen/MachineBasicBlock.h"
 #include <vector>
 
@@ -85,6 +87,18 @@ namespace llvm {
     };
     std::vector<SameTailElt> SameTails;
 
+    /// TailHashLimit - Number of trailing instructions covered by the cached
+    /// rolling tail hashes.
+    enum { TailHashLimit = 16 };
+
+    /// TailHashCache - For each block, the rolling hashes of its trailing
+    /// non-debug instructions: entry i is the hash of the last i+1 of them,
+    /// capped at TailHashLimit.  Valid for the duration of one
+    /// TryTailMergeBlocks run.
+    typedef SmallVector<unsigned, 8> TailHashesTy;
+    typedef DenseMap<const MachineBasicBlock *, TailHashesTy> TailHashCacheTy;
+    TailHashCacheTy TailHashCache;
+
     bool EnableTailMerge;
     bool EnableHoistCommonCode;
     const TargetInstrInfo *TII;
@@ -101,6 +115,17 @@ namespace llvm {
                                  MachineBasicBlock *NewDest);
     MachineBasicBlock *SplitMBBAt(MachineBasicBlock &CurMBB,
                                   MachineBasicBlock::iterator BBI1);
+    void ComputeTailHashes(const MachineBasicBlock *MBB);
+    unsigned CommonTailHashLength(const MachineBasicBlock *MBB1,
+                                  const MachineBasicBlock *MBB2,
+                                  bool &WholeMBB1, bool &WholeMBB2);
+    bool ProfitableToMerge(MachineBasicBlock *MBB1, MachineBasicBlock *MBB2,
+                           unsigned minCommonTailLength,
+                           unsigned &CommonTailLen,
+                           MachineBasicBlock::iterator &I1,
+                           MachineBasicBlock::iterator &I2,
+                           MachineBasicBlock *SuccBB,
+                           MachineBasicBlock *PredBB);
     unsigned ComputeSameTails(unsigned CurHash, unsigned minCommonTailLength,
                               MachineBasicBlock *SuccBB,
                               MachineBasicBlock *PredBB);
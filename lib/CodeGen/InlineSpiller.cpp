@@ -20,6 +20,7 @@
 #include "llvm/CodeGen/LiveIntervalAnalysis.h"
 #include "llvm/CodeGen/LiveRangeEdit.h"
 #include "llvm/CodeGen/LiveStackAnalysis.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
 #include "llvm/CodeGen/MachineDominators.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineFunction.h"
@@ -58,6 +59,9 @@ class InlineSpiller : public Spiller {
   AliasAnalysis *AA;
   MachineDominatorTree &MDT;
   MachineLoopInfo &Loops;
+  // Block frequencies when the register allocator provides them; spill
+  // hoisting falls back to loop depth when they are not available.
+  MachineBlockFrequencyInfo *MBFI;
   VirtRegMap &VRM;
   MachineFrameInfo &MFI;
   MachineRegisterInfo &MRI;
@@ -142,6 +146,7 @@ public:
       AA(&pass.getAnalysis<AliasAnalysis>()),
       MDT(pass.getAnalysis<MachineDominatorTree>()),
       Loops(pass.getAnalysis<MachineLoopInfo>()),
+      MBFI(pass.getAnalysisIfAvailable<MachineBlockFrequencyInfo>()),
       VRM(vrm),
       MFI(*mf.getFrameInfo()),
       MRI(mf.getRegInfo()),
@@ -428,14 +433,23 @@ void InlineSpiller::propagateSiblingValue(SibValueMap::iterator SVI,
             DepSV.SpillMBB = SV.SpillMBB;
           }
         } else {
-          // DepSV is in a different block.
-          if (SpillDepth == ~0u)
-            SpillDepth = Loops.getLoopDepth(SV.SpillMBB);
-
-          // Also hoist spills to blocks with smaller loop depth, but make sure
-          // that the new value dominates.  Non-phi dependents are always
-          // dominated, phis need checking.
-          if ((Loops.getLoopDepth(DepSV.SpillMBB) > SpillDepth) &&
+          // DepSV is in a different block.  Hoist the spill when SpillMBB is
+          // a cheaper place for it: colder by block frequency when the
+          // allocator provides MachineBlockFrequencyInfo, at a smaller loop
+          // depth otherwise.
+          bool CheaperBlock;
+          if (MBFI) {
+            CheaperBlock = MBFI->getBlockFreq(SV.SpillMBB) <
+                           MBFI->getBlockFreq(DepSV.SpillMBB);
+          } else {
+            if (SpillDepth == ~0u)
+              SpillDepth = Loops.getLoopDepth(SV.SpillMBB);
+            CheaperBlock = Loops.getLoopDepth(DepSV.SpillMBB) > SpillDepth;
+          }
+
+          // Make sure that the new value dominates.  Non-phi dependents are
+          // always dominated, phis need checking.
+          if (CheaperBlock &&
               (!DepSVI->first->isPHIDef() ||
                MDT.dominates(SV.SpillMBB, DepSV.SpillMBB))) {
             Changed = true;
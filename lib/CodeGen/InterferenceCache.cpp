@@ -14,11 +14,20 @@
 #define DEBUG_TYPE "regalloc"
 #include "InterferenceCache.h"
 #include "llvm/CodeGen/LiveIntervalAnalysis.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Target/TargetRegisterInfo.h"
 
 using namespace llvm;
 
+// The entry array is recycled in a round-robin manner, so a larger cache
+// trades memory for fewer interference recomputations when the allocator
+// revisits physregs. PhysRegEntries stores 8-bit indices, so 256 is the
+// hard upper limit.
+static cl::opt<unsigned>
+CacheSize("interference-cache-size", cl::Hidden, cl::init(32),
+          cl::desc("Number of physreg entries in the interference cache"));
+
 // Static member used for null interference cursors.
 InterferenceCache::BlockInterference InterferenceCache::Cursor::NoInterference;
 
@@ -31,6 +40,10 @@ void InterferenceCache::init(MachineFunction *mf,
   LIUArray = liuarray;
   TRI = tri;
   PhysRegEntries.assign(TRI->getNumRegs(), 0);
+  if (!Entries) {
+    CacheEntries = std::min(std::max(CacheSize.getValue(), 1u), 256u);
+    Entries = new Entry[CacheEntries];
+  }
   for (unsigned i = 0; i != CacheEntries; ++i)
     Entries[i].clear(mf, indexes, lis);
 }
@@ -130,8 +130,9 @@ class InterferenceCache {
 
   // We don't keep a cache entry for every physical register, that would use too
   // much memory. Instead, a fixed number of cache entries are used in a round-
-  // robin manner.
-  enum { CacheEntries = 32 };
+  // robin manner. The number of entries is set once by the first call to
+  // init(), from the -interference-cache-size option.
+  unsigned CacheEntries;
 
   // Point to an entry for each physreg. The entry pointed to may not be up to
   // date, and it may have been reused for a different physreg.
@@ -140,14 +141,18 @@ class InterferenceCache {
   // Next round-robin entry to be picked.
   unsigned RoundRobin;
 
-  // The actual cache entries.
-  Entry Entries[CacheEntries];
+  // The actual cache entries, allocated by init(). Cursors hold pointers into
+  // this array, so it is never resized once allocated.
+  Entry *Entries;
 
   // get - Get a valid entry for PhysReg.
   Entry *get(unsigned PhysReg);
 
 public:
-  InterferenceCache() : TRI(0), LIUArray(0), MF(0), RoundRobin(0) {}
+  InterferenceCache()
+    : TRI(0), LIUArray(0), MF(0), CacheEntries(0), RoundRobin(0), Entries(0) {}
+
+  ~InterferenceCache() { delete[] Entries; }
 
   /// init - Prepare cache for a new function.
   void init(MachineFunction*, LiveIntervalUnion*, SlotIndexes*, LiveIntervals*,
@@ -0,0 +1,133 @@
+//===- LazyLiveness.cpp - On-demand liveness queries ----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the LazyLiveness class, which computes and caches the
+// liveness of one virtual register at a time from its use and def chains.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/LazyLiveness.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/Target/TargetRegisterInfo.h"
+using namespace llvm;
+
+LazyLiveness::LazyLiveness(MachineFunction &mf) : MRI(mf.getRegInfo()) {}
+
+LazyLiveness::~LazyLiveness() {
+  clear();
+}
+
+void LazyLiveness::clear() {
+  for (DenseMap<unsigned, RegLiveness*>::iterator I = Cache.begin(),
+         E = Cache.end(); I != E; ++I)
+    delete I->second;
+  Cache.clear();
+}
+
+bool LazyLiveness::isLiveIn(unsigned Reg, const MachineBasicBlock &MBB) {
+  return compute(Reg).LiveInBlocks.test(MBB.getNumber());
+}
+
+bool LazyLiveness::isLiveOut(unsigned Reg, const MachineBasicBlock &MBB) {
+  return compute(Reg).LiveOutBlocks.test(MBB.getNumber());
+}
+
+/// markLiveIn - Record that Reg is live at the entry of MBB and propagate
+/// that to the exits of its predecessors, stopping at blocks that define the
+/// register. LiveOutBlocks doubles as the visited set: a block is only ever
+/// pushed after its live-out bit is newly set.
+void LazyLiveness::markLiveIn(RegLiveness &RL,
+                              SparseBitVector<> &DefBlocks,
+                              const MachineBasicBlock *MBB) {
+  if (RL.LiveInBlocks.test(MBB->getNumber()))
+    return;
+  RL.LiveInBlocks.set(MBB->getNumber());
+
+  SmallVector<const MachineBasicBlock*, 16> Worklist(MBB->pred_begin(),
+                                                     MBB->pred_end());
+  while (!Worklist.empty()) {
+    const MachineBasicBlock *B = Worklist.pop_back_val();
+    unsigned Num = B->getNumber();
+    if (RL.LiveOutBlocks.test(Num))
+      continue;
+    RL.LiveOutBlocks.set(Num);
+    // A def in this block provides the live-out value; the register is not
+    // exposed to this block's predecessors.
+    if (DefBlocks.test(Num))
+      continue;
+    if (!RL.LiveInBlocks.test(Num)) {
+      RL.LiveInBlocks.set(Num);
+      Worklist.append(B->pred_begin(), B->pred_end());
+    }
+  }
+}
+
+LazyLiveness::RegLiveness &LazyLiveness::compute(unsigned Reg) {
+  assert(TargetRegisterInfo::isVirtualRegister(Reg) &&
+         "LazyLiveness only tracks virtual registers");
+  RegLiveness *&Entry = Cache[Reg];
+  if (Entry)
+    return *Entry;
+  Entry = new RegLiveness();
+  RegLiveness &RL = *Entry;
+
+  // Collect the blocks containing defs. Within-block def/use ordering is
+  // resolved by scanning the use's block below.
+  SparseBitVector<> DefBlocks;
+  for (MachineRegisterInfo::def_iterator I = MRI.def_begin(Reg),
+         E = MRI.def_end(); I != E; ++I)
+    DefBlocks.set(I->getParent()->getNumber());
+
+  for (MachineRegisterInfo::use_nodbg_iterator UI = MRI.use_nodbg_begin(Reg),
+         UE = MRI.use_nodbg_end(); UI != UE; ++UI) {
+    if (UI.getOperand().isUndef())
+      continue;
+    MachineInstr *UseMI = &*UI;
+
+    if (UseMI->isPHI()) {
+      // A PHI reads the register on the edge from the incoming block, i.e.
+      // at the exit of that predecessor. Following the LiveVariables
+      // convention this does not make the register live-out of the
+      // predecessor itself, but it is live-in there (and live-out of the
+      // blocks above) unless the predecessor contains a def.
+      const MachineBasicBlock *Pred =
+        UseMI->getOperand(UI.getOperandNo() + 1).getMBB();
+      if (!DefBlocks.test(Pred->getNumber()))
+        markLiveIn(RL, DefBlocks, Pred);
+      continue;
+    }
+
+    const MachineBasicBlock *BB = UseMI->getParent();
+    if (RL.LiveInBlocks.test(BB->getNumber()))
+      continue;
+
+    // If the block contains a def, the use is only upward exposed when it
+    // appears before every def.
+    if (DefBlocks.test(BB->getNumber())) {
+      bool UpwardExposed = false;
+      for (MachineBasicBlock::const_iterator I = BB->begin(), E = BB->end();
+           I != E; ++I) {
+        if (&*I == UseMI) {
+          UpwardExposed = true;
+          break;
+        }
+        if (I->definesRegister(Reg))
+          break;
+      }
+      if (!UpwardExposed)
+        continue;
+    }
+
+    markLiveIn(RL, DefBlocks, BB);
+  }
+
+  return RL;
+}
@@ -785,6 +785,78 @@ void LiveRange::print(raw_ostream &os) const {
   os << *this;
 }
 
+//===----------------------------------------------------------------------===//
+// CompressedLiveRanges implementation
+//===----------------------------------------------------------------------===//
+
+void CompressedLiveRanges::encode(SmallVectorImpl<uint8_t> &Bytes,
+                                  unsigned Value) {
+  while (Value >= 0x80) {
+    Bytes.push_back(uint8_t(Value) | 0x80);
+    Value >>= 7;
+  }
+  Bytes.push_back(uint8_t(Value));
+}
+
+void CompressedLiveRanges::compress(const LiveInterval &LI) {
+  Bytes.clear();
+  NumSegments = 0;
+  if (LI.empty()) {
+    BaseIdx = SlotIndex();
+    return;
+  }
+
+  BaseIdx = LI.begin()->start;
+  unsigned PrevEnd = 0;
+  for (LiveInterval::const_iterator I = LI.begin(), E = LI.end(); I != E;
+       ++I) {
+    unsigned Start = BaseIdx.distance(I->start);
+    unsigned End = BaseIdx.distance(I->end);
+    encode(Bytes, Start - PrevEnd);
+    encode(Bytes, End - Start);
+    encode(Bytes, I->valno->id);
+    PrevEnd = End;
+    ++NumSegments;
+  }
+}
+
+bool CompressedLiveRanges::liveAt(SlotIndex I) const {
+  if (!NumSegments || !I.isValid())
+    return false;
+  int Off = BaseIdx.distance(I);
+  if (Off < 0)
+    return false;
+  for (const_iterator SI = begin(), SE = end(); SI != SE; ++SI) {
+    if (unsigned(Off) < SI->Start)
+      return false;
+    if (unsigned(Off) < SI->End)
+      return true;
+  }
+  return false;
+}
+
+bool CompressedLiveRanges::overlaps(const CompressedLiveRanges &Other) const {
+  if (!NumSegments || !Other.NumSegments)
+    return false;
+
+  // Translate the other snapshot's positions into this one's coordinates.
+  int Shift = BaseIdx.distance(Other.BaseIdx);
+
+  const_iterator I = begin(), IE = end();
+  const_iterator J = Other.begin(), JE = Other.end();
+  while (I != IE && J != JE) {
+    int JStart = int(J->Start) + Shift;
+    int JEnd = int(J->End) + Shift;
+    if (int(I->End) <= JStart)
+      ++I;
+    else if (JEnd <= int(I->Start))
+      ++J;
+    else
+      return true;
+  }
+  return false;
+}
+
 unsigned ConnectedVNInfoEqClasses::Classify(const LiveInterval *LI) {
   // Create initial equivalence classes.
   EqClass.clear();
@@ -92,6 +92,10 @@ void LiveIntervals::releaseMemory() {
     delete RegUnitIntervals[i];
   RegUnitIntervals.clear();
 
+  for (unsigned i = 0, e = RetiredIntervals.size(); i != e; ++i)
+    delete RetiredIntervals[i];
+  RetiredIntervals.clear();
+
   // Release VNInfo memory regions, VNInfo objects don't need to be dtor'd.
   VNInfoAllocator.Reset();
 }
@@ -459,9 +463,26 @@ void LiveIntervals::computeIntervals() {
 
 LiveInterval* LiveIntervals::createInterval(unsigned reg) {
   float Weight = TargetRegisterInfo::isPhysicalRegister(reg) ? HUGE_VALF : 0.0F;
+  // Prefer a retired interval: its segment array keeps the capacity it grew
+  // to, so re-splitting the same registers doesn't start from scratch.
+  if (!RetiredIntervals.empty()) {
+    LiveInterval *LI = RetiredIntervals.pop_back_val();
+    LI->reg = reg;
+    LI->weight = Weight;
+    return LI;
+  }
   return new LiveInterval(reg, Weight);
 }
 
+void LiveIntervals::retireInterval(LiveInterval *LI) {
+  if (!LI)
+    return;
+  // The VNInfos are owned by VNInfoAllocator and freed in bulk by
+  // releaseMemory, so clearing the lists is all that's needed here.
+  LI->clear();
+  RetiredIntervals.push_back(LI);
+}
+
 
 /// computeVirtRegInterval - Compute the live interval of a virtual register,
 /// based on defs and uses.
@@ -0,0 +1,171 @@
+//===-- MachineFunctionTelemetry.cpp --------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// MachineFunctionTelemetry emits one record per function into a sidecar file:
+// final instruction and block counts, spill and reload counts, an estimate of
+// the register pressure high-water mark, and the entropy of the block size
+// distribution.  Unlike -stats, which aggregates Statistic counters over the
+// whole module, the records are keyed by function so codegen changes can be
+// A/B tested per function without diffing disassembly.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/Passes.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetInstrInfo.h"
+#include <cmath>
+
+using namespace llvm;
+
+namespace {
+/// MachineFunctionTelemetry - Runs after all machine passes and appends a
+/// per-function record to the requested file.
+///
+struct MachineFunctionTelemetry : public MachineFunctionPass {
+  static char ID;
+
+  std::string Filename;
+  OwningPtr<raw_fd_ostream> OS;
+
+  MachineFunctionTelemetry() : MachineFunctionPass(ID) {}
+  MachineFunctionTelemetry(StringRef filename)
+      : MachineFunctionPass(ID), Filename(filename) {}
+
+  const char *getPassName() const { return "Machine Function Telemetry"; }
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    AU.setPreservesAll();
+    MachineFunctionPass::getAnalysisUsage(AU);
+  }
+
+  virtual bool doInitialization(Module &M) {
+    std::string Error;
+    OS.reset(new raw_fd_ostream(Filename.c_str(), Error));
+    if (!Error.empty()) {
+      errs() << "warning: cannot open telemetry file '" << Filename
+             << "': " << Error << "\n";
+      OS.reset();
+    }
+    return false;
+  }
+
+  bool runOnMachineFunction(MachineFunction &MF);
+};
+
+char MachineFunctionTelemetry::ID = 0;
+}
+
+char &llvm::MachineFunctionTelemetryID = MachineFunctionTelemetry::ID;
+INITIALIZE_PASS(MachineFunctionTelemetry, "machine-telemetry",
+                "Machine Function Telemetry", false, false)
+
+/// getPressureHighWater - Estimate the register pressure high-water mark of
+/// MBB from live-ins and kill/dead flags.  LiveIntervals is long gone by the
+/// time spills are final, so this stands in for RegisterPressure's exact
+/// tracker; it counts registers, not register units, and ignores regmasks.
+static unsigned getPressureHighWater(const MachineBasicBlock &MBB) {
+  SmallSet<unsigned, 32> Live;
+  for (MachineBasicBlock::livein_iterator LI = MBB.livein_begin(),
+       LE = MBB.livein_end(); LI != LE; ++LI)
+    Live.insert(*LI);
+
+  unsigned Max = Live.size();
+  for (MachineBasicBlock::const_iterator MI = MBB.begin(), ME = MBB.end();
+       MI != ME; ++MI) {
+    if (MI->isDebugValue())
+      continue;
+    for (unsigned i = 0, e = MI->getNumOperands(); i != e; ++i) {
+      const MachineOperand &MO = MI->getOperand(i);
+      if (!MO.isReg() || !MO.getReg())
+        continue;
+      if (MO.isUse() && MO.isKill())
+        Live.erase(MO.getReg());
+      else if (MO.isDef() && !MO.isDead())
+        Live.insert(MO.getReg());
+    }
+    if (Live.size() > Max)
+      Max = Live.size();
+  }
+  return Max;
+}
+
+bool MachineFunctionTelemetry::runOnMachineFunction(MachineFunction &MF) {
+  if (!OS)
+    return false;
+
+  const MachineFrameInfo *MFI = MF.getFrameInfo();
+  const TargetInstrInfo *TII = MF.getTarget().getInstrInfo();
+
+  unsigned NumInsts = 0, NumSpills = 0, NumReloads = 0, MaxPressure = 0;
+  SmallVector<unsigned, 32> BlockSizes;
+
+  for (MachineFunction::const_iterator MBB = MF.begin(), MBBE = MF.end();
+       MBB != MBBE; ++MBB) {
+    unsigned BlockSize = 0;
+    for (MachineBasicBlock::const_iterator MI = MBB->begin(), ME = MBB->end();
+         MI != ME; ++MI) {
+      if (MI->isDebugValue())
+        continue;
+      ++BlockSize;
+
+      // Count accesses to spill slots; this sees the final result of
+      // InlineSpiller after any later cleanup passes.
+      int FI;
+      if (TII->isStoreToStackSlot(MI, FI) && MFI->isSpillSlotObjectIndex(FI))
+        ++NumSpills;
+      else if (TII->isLoadFromStackSlot(MI, FI) &&
+               MFI->isSpillSlotObjectIndex(FI))
+        ++NumReloads;
+    }
+    NumInsts += BlockSize;
+    BlockSizes.push_back(BlockSize);
+
+    unsigned Pressure = getPressureHighWater(*MBB);
+    if (Pressure > MaxPressure)
+      MaxPressure = Pressure;
+  }
+
+  // Entropy of the block size distribution; a function whose instructions
+  // are spread evenly over its blocks scores high, one dominated by a single
+  // large block scores near zero.
+  double Entropy = 0;
+  if (NumInsts) {
+    for (unsigned i = 0, e = BlockSizes.size(); i != e; ++i) {
+      if (!BlockSizes[i])
+        continue;
+      double P = double(BlockSizes[i]) / double(NumInsts);
+      Entropy -= P * std::log(P);
+    }
+    Entropy /= std::log(2.0);
+  }
+
+  *OS << format("%08x", HashString(MF.getName())) << ' ' << MF.getName()
+      << " insts=" << NumInsts << " blocks=" << MF.size()
+      << " spills=" << NumSpills << " reloads=" << NumReloads
+      << " maxpressure=" << MaxPressure
+      << format(" layoutentropy=%.3f", Entropy) << '\n';
+  return false;
+}
+
+namespace llvm {
+/// Returns a newly-created Machine Function Telemetry pass writing to the
+/// given file.
+///
+MachineFunctionPass *createMachineFunctionTelemetryPass(StringRef Filename) {
+  return new MachineFunctionTelemetry(Filename);
+}
+
+}
@@ -535,8 +535,17 @@ MachineInstr::MachineInstr(MachineFunction &MF, const MCInstrDesc &tid,
     Flags(0), AsmPrinterFlags(0),
     NumMemRefs(0), MemRefs(0), debugLoc(dl) {
   // Reserve space for the expected number of operands.
-  if (unsigned NumOps = MCID->getNumOperands() +
-    MCID->getNumImplicitDefs() + MCID->getNumImplicitUses()) {
+  unsigned NumOps = MCID->getNumOperands() +
+    MCID->getNumImplicitDefs() + MCID->getNumImplicitUses();
+
+  // Variadic instructions (calls, inline asm) almost always receive operands
+  // beyond the declared count, so start them one capacity class higher.  This
+  // avoids the common reallocate-and-move in addOperand when the first extra
+  // operand arrives during ISel emission.
+  if (MCID->isVariadic())
+    NumOps = NumOps ? 2 * NumOps : 4;
+
+  if (NumOps) {
     CapOperands = OperandCapacity::get(NumOps);
     Operands = MF.allocateOperandArray(CapOperands);
   }
@@ -488,11 +488,20 @@ void ScheduleDAGMI::initRegPressure() {
 // iterate over all RegionCriticalPSets[i].
 void ScheduleDAGMI::
 updateScheduledPressure(std::vector<unsigned> NewMaxPressure) {
+  bool Changed = false;
   for (unsigned i = 0, e = RegionCriticalPSets.size(); i < e; ++i) {
     unsigned ID = RegionCriticalPSets[i].PSetID;
     int &MaxUnits = RegionCriticalPSets[i].UnitIncrease;
-    if ((int)NewMaxPressure[ID] > MaxUnits)
+    if ((int)NewMaxPressure[ID] > MaxUnits) {
       MaxUnits = NewMaxPressure[ID];
+      Changed = true;
+    }
+  }
+  // The critical set baselines feed both zones' max pressure delta queries;
+  // deltas memoized against the old baselines are stale once they move.
+  if (Changed) {
+    TopRPTracker.invalidateCachedDeltas();
+    BotRPTracker.invalidateCachedDeltas();
   }
 }
 
@@ -2210,6 +2219,131 @@ static MachineSchedRegistry ILPMaxRegistry(
 static MachineSchedRegistry ILPMinRegistry(
   "ilpmin", "Schedule bottom-up for min ILP", createILPMinScheduler);
 
+//===----------------------------------------------------------------------===//
+// Slack Scheduler. Bottom-up scheduling by precomputed critical-path slack.
+//===----------------------------------------------------------------------===//
+
+static cl::opt<unsigned> SlackSchedBudget("slack-sched-budget", cl::Hidden,
+  cl::desc("Ready queue operations allowed per region in the slack scheduler "
+           "before it degrades to source order (0 = unlimited)"),
+  cl::init(0));
+
+namespace {
+/// \brief Order nodes by precomputed height, i.e. by slack against the
+/// region's critical path, falling back to source order.
+struct SlackOrder {
+  const std::vector<unsigned> *Heights;
+  bool SourceOrder;
+
+  SlackOrder(): Heights(0), SourceOrder(false) {}
+
+  /// \brief Apply a less-than relation on node priority.
+  ///
+  /// (Return true if A comes after B in the Q.)
+  bool operator()(const SUnit *A, const SUnit *B) const {
+    if (!SourceOrder) {
+      // The critical path is the same for every node, so least slack is
+      // simply greatest height.
+      unsigned HeightA = (*Heights)[A->NodeNum];
+      unsigned HeightB = (*Heights)[B->NodeNum];
+      if (HeightA != HeightB)
+        return HeightA < HeightB;
+    }
+    // Schedule the later instruction first when scheduling bottom-up.
+    return A->NodeNum < B->NodeNum;
+  }
+};
+
+/// \brief Schedule bottom-up by slack against the critical path.
+///
+/// Heights are forced out of the lazy depth/height machinery once per DAG
+/// and frozen, so a pick costs one heap operation instead of a scan over
+/// the pending queue.  An optional compile-time budget caps the number of
+/// queue operations per region; once it is spent, the remaining picks
+/// degrade to source order.
+class SlackScheduler : public MachineSchedStrategy {
+  ScheduleDAGMI *DAG;
+  SlackOrder Cmp;
+
+  /// Heights indexed by NodeNum, frozen at initialization.
+  std::vector<unsigned> Heights;
+
+  /// CriticalPath - The maximum height in the region, for debug output.
+  unsigned CriticalPath;
+
+  /// QOps - Ready queue operations performed so far in this region.
+  unsigned QOps;
+
+  std::vector<SUnit*> ReadyQ;
+public:
+  SlackScheduler(): DAG(0), CriticalPath(0), QOps(0) {}
+
+  virtual void initialize(ScheduleDAGMI *dag) {
+    DAG = dag;
+    CriticalPath = 0;
+    Heights.resize(DAG->SUnits.size());
+    for (unsigned i = 0, e = DAG->SUnits.size(); i != e; ++i) {
+      Heights[i] = DAG->SUnits[i].getHeight();
+      if (Heights[i] > CriticalPath)
+        CriticalPath = Heights[i];
+    }
+    Cmp.Heights = &Heights;
+    Cmp.SourceOrder = false;
+    QOps = 0;
+    ReadyQ.clear();
+  }
+
+  virtual void registerRoots() {
+    std::make_heap(ReadyQ.begin(), ReadyQ.end(), Cmp);
+  }
+
+  /// Implement MachineSchedStrategy interface.
+  /// -----------------------------------------
+
+  /// Callback to select the highest priority node from the ready Q.
+  virtual SUnit *pickNode(bool &IsTopNode) {
+    if (ReadyQ.empty()) return NULL;
+    countQOp();
+    std::pop_heap(ReadyQ.begin(), ReadyQ.end(), Cmp);
+    SUnit *SU = ReadyQ.back();
+    ReadyQ.pop_back();
+    IsTopNode = false;
+    DEBUG(dbgs() << "*** Scheduling " << "SU(" << SU->NodeNum << "): "
+          << *SU->getInstr()
+          << " Slack: " << (CriticalPath - Heights[SU->NodeNum]) << '\n');
+    return SU;
+  }
+
+  virtual void schedNode(SUnit *SU, bool IsTopNode) {}
+
+  virtual void releaseTopNode(SUnit *) { /*only called for top roots*/ }
+
+  virtual void releaseBottomNode(SUnit *SU) {
+    countQOp();
+    ReadyQ.push_back(SU);
+    std::push_heap(ReadyQ.begin(), ReadyQ.end(), Cmp);
+  }
+
+private:
+  /// \brief Charge one operation against the region's budget, degrading to
+  /// source order when it is spent.
+  void countQOp() {
+    if (!SlackSchedBudget || Cmp.SourceOrder)
+      return;
+    if (++QOps > SlackSchedBudget) {
+      Cmp.SourceOrder = true;
+      std::make_heap(ReadyQ.begin(), ReadyQ.end(), Cmp);
+    }
+  }
+};
+} // namespace
+
+static ScheduleDAGInstrs *createSlackScheduler(MachineSchedContext *C) {
+  return new ScheduleDAGMI(C, new SlackScheduler());
+}
+static MachineSchedRegistry SlackSchedRegistry(
+  "slack", "Schedule bottom-up by critical-path slack", createSlackScheduler);
+
 //===----------------------------------------------------------------------===//
 // Machine Instruction Shuffler for Correctness Testing
 //===----------------------------------------------------------------------===//
@@ -16,9 +16,12 @@
 #define DEBUG_TYPE "phielim"
 #include "llvm/CodeGen/Passes.h"
 #include "PHIEliminationUtils.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/LazyLiveness.h"
 #include "llvm/CodeGen/LiveVariables.h"
 #include "llvm/CodeGen/MachineDominators.h"
 #include "llvm/CodeGen/MachineInstr.h"
@@ -32,6 +35,7 @@
 #include "llvm/Target/TargetInstrInfo.h"
 #include "llvm/Target/TargetMachine.h"
 #include <algorithm>
+#include <vector>
 using namespace llvm;
 
 static cl::opt<bool>
@@ -39,6 +43,12 @@ DisableEdgeSplitting("disable-phi-elim-edge-splitting", cl::init(false),
                      cl::Hidden, cl::desc("Disable critical edge splitting "
                                           "during PHI elimination"));
 
+static cl::opt<bool>
+SplitWithLazyLiveness("phi-elim-lazy-liveness", cl::init(false), cl::Hidden,
+                      cl::desc("Answer the liveness queries for critical edge "
+                               "splitting on demand instead of requiring "
+                               "LiveVariables"));
+
 namespace {
   class PHIElimination : public MachineFunctionPass {
     MachineRegisterInfo *MRI; // Machine register information
@@ -57,8 +67,13 @@ namespace {
     /// in predecessor basic blocks.
     ///
     bool EliminatePHINodes(MachineFunction &MF, MachineBasicBlock &MBB);
-    void LowerAtomicPHINode(MachineBasicBlock &MBB,
-                            MachineBasicBlock::iterator AfterPHIsIt);
+
+    /// LowerPHINodes - Lower all PHI nodes of MBB as one batch: the incoming
+    /// copies are grouped by predecessor so each predecessor block is visited
+    /// once no matter how many PHIs it feeds, and the kill updates for a
+    /// predecessor are applied in a single pass over its copies.
+    void LowerPHINodes(MachineBasicBlock &MBB,
+                       MachineBasicBlock::iterator AfterPHIsIt);
 
     /// analyzePHINodes - Gather information about the PHI nodes in
     /// here. In particular, we want to map the number of uses of a virtual
@@ -69,8 +84,11 @@ namespace {
     void analyzePHINodes(const MachineFunction& Fn);
 
     /// Split critical edges where necessary for good coalescer performance.
+    /// Liveness queries are answered by LV when it is available and by LL
+    /// otherwise; exactly one of the two must be non-null.
     bool SplitPHIEdges(MachineFunction &MF, MachineBasicBlock &MBB,
-                       LiveVariables &LV, MachineLoopInfo *MLI);
+                       LiveVariables *LV, LazyLiveness *LL,
+                       MachineLoopInfo *MLI);
 
     typedef std::pair<unsigned, unsigned> BBVRegPair;
     typedef DenseMap<BBVRegPair, unsigned> VRegPHIUse;
@@ -116,12 +134,19 @@ bool PHIElimination::runOnMachineFunction(MachineFunction &MF) {
   // This pass takes the function out of SSA form.
   MRI->leaveSSA();
 
-  // Split critical edges to help the coalescer
+  // Split critical edges to help the coalescer. With -phi-elim-lazy-liveness
+  // the liveness queries are computed on demand from the use chains when
+  // LiveVariables is not around, so edges can be split without paying for
+  // the whole-function dataflow.
   if (!DisableEdgeSplitting) {
-    if (LiveVariables *LV = getAnalysisIfAvailable<LiveVariables>()) {
+    LiveVariables *LV = getAnalysisIfAvailable<LiveVariables>();
+    OwningPtr<LazyLiveness> LL;
+    if (!LV && SplitWithLazyLiveness)
+      LL.reset(new LazyLiveness(MF));
+    if (LV || LL) {
       MachineLoopInfo *MLI = getAnalysisIfAvailable<MachineLoopInfo>();
       for (MachineFunction::iterator I = MF.begin(), E = MF.end(); I != E; ++I)
-        Changed |= SplitPHIEdges(MF, *I, *LV, MLI);
+        Changed |= SplitPHIEdges(MF, *I, LV, LL.get(), MLI);
     }
   }
 
@@ -165,8 +190,7 @@ bool PHIElimination::EliminatePHINodes(MachineFunction &MF,
   // also be the end of the basic block).
   MachineBasicBlock::iterator AfterPHIsIt = MBB.SkipPHIsAndLabels(MBB.begin());
 
-  while (MBB.front().isPHI())
-    LowerAtomicPHINode(MBB, AfterPHIsIt);
+  LowerPHINodes(MBB, AfterPHIsIt);
 
   return true;
 }
@@ -193,212 +217,306 @@ static bool isSourceDefinedByImplicitDef(const MachineInstr *MPhi,
 }
 
 
-/// LowerAtomicPHINode - Lower the PHI node at the top of the specified block,
-/// under the assumption that it needs to be lowered in a way that supports
-/// atomic execution of PHIs.  This lowering method is always correct all of the
-/// time.
+namespace {
+  /// PHISourceCopy - One queued incoming-side copy.  Copy is filled in once
+  /// the instruction has been inserted so the kill pass can point at it.
+  struct PHISourceCopy {
+    MachineInstr *MPhi;    // Supplies the debug location.
+    unsigned IncomingReg;  // 0 when no copy is needed.
+    unsigned SrcReg;
+    unsigned SrcSubReg;
+    bool SrcUndef;
+    bool ReusedIncoming;
+    MachineInstr *Copy;
+  };
+}
+
+/// LowerPHINodes - Lower every PHI node at the top of MBB, under the
+/// assumption that they need to be lowered in a way that supports atomic
+/// execution of PHIs.  This lowering method is always correct all of the
+/// time.  The incoming copies are grouped by predecessor: each predecessor
+/// block has its insert point located once, receives all of its copies
+/// together, and has its kill information updated in one pass, instead of
+/// being revisited by every PHI it feeds.
 ///
-void PHIElimination::LowerAtomicPHINode(
-                                      MachineBasicBlock &MBB,
-                                      MachineBasicBlock::iterator AfterPHIsIt) {
-  ++NumAtomic;
-  // Unlink the PHI node from the basic block, but don't delete the PHI yet.
-  MachineInstr *MPhi = MBB.remove(MBB.begin());
-
-  unsigned NumSrcs = (MPhi->getNumOperands() - 1) / 2;
-  unsigned DestReg = MPhi->getOperand(0).getReg();
-  assert(MPhi->getOperand(0).getSubReg() == 0 && "Can't handle sub-reg PHIs");
-  bool isDead = MPhi->getOperand(0).isDead();
-
-  // Create a new register for the incoming PHI arguments.
+void PHIElimination::LowerPHINodes(MachineBasicBlock &MBB,
+                                   MachineBasicBlock::iterator AfterPHIsIt) {
   MachineFunction &MF = *MBB.getParent();
-  unsigned IncomingReg = 0;
-  bool reusedIncoming = false;  // Is IncomingReg reused from an earlier PHI?
-
-  // Insert a register to register copy at the top of the current block (but
-  // after any remaining phi nodes) which copies the new incoming register
-  // into the phi node destination.
   const TargetInstrInfo *TII = MF.getTarget().getInstrInfo();
-  if (isSourceDefinedByImplicitDef(MPhi, MRI))
-    // If all sources of a PHI node are implicit_def, just emit an
-    // implicit_def instead of a copy.
-    BuildMI(MBB, AfterPHIsIt, MPhi->getDebugLoc(),
-            TII->get(TargetOpcode::IMPLICIT_DEF), DestReg);
-  else {
-    // Can we reuse an earlier PHI node? This only happens for critical edges,
-    // typically those created by tail duplication.
-    unsigned &entry = LoweredPHIs[MPhi];
-    if (entry) {
-      // An identical PHI node was already lowered. Reuse the incoming register.
-      IncomingReg = entry;
-      reusedIncoming = true;
-      ++NumReused;
-      DEBUG(dbgs() << "Reusing " << PrintReg(IncomingReg) << " for " << *MPhi);
-    } else {
-      const TargetRegisterClass *RC = MF.getRegInfo().getRegClass(DestReg);
-      entry = IncomingReg = MF.getRegInfo().createVirtualRegister(RC);
+  LiveVariables *LV = getAnalysisIfAvailable<LiveVariables>();
+
+  // Unlink every PHI node from the basic block up front, but don't delete
+  // them yet; the copy insertion below still reads their operands.
+  SmallVector<MachineInstr*, 16> PHIs;
+  while (!MBB.empty() && MBB.front().isPHI())
+    PHIs.push_back(MBB.remove(MBB.begin()));
+
+  // The copies each predecessor block must receive, in deterministic
+  // first-seen order.
+  SmallVector<MachineBasicBlock*, 8> PredOrder;
+  DenseMap<MachineBasicBlock*, unsigned> PredIndex;
+  std::vector<std::vector<PHISourceCopy> > PredCopies;
+
+  // PHI nodes which did not donate themselves to the LoweredPHIs map and
+  // must be deleted once the copies are in place.
+  SmallVector<MachineInstr*, 16> DeadPHIs;
+
+  // First pass, per PHI: emit the copy from the incoming join register into
+  // the destination, update the destination-side liveness, and queue the
+  // per-predecessor copies.
+  for (unsigned pi = 0, pe = PHIs.size(); pi != pe; ++pi) {
+    MachineInstr *MPhi = PHIs[pi];
+    ++NumAtomic;
+
+    unsigned NumSrcs = (MPhi->getNumOperands() - 1) / 2;
+    unsigned DestReg = MPhi->getOperand(0).getReg();
+    assert(MPhi->getOperand(0).getSubReg() == 0 && "Can't handle sub-reg PHIs");
+    bool isDead = MPhi->getOperand(0).isDead();
+
+    // Create a new register for the incoming PHI arguments.
+    unsigned IncomingReg = 0;
+    bool reusedIncoming = false;  // Is IncomingReg reused from an earlier PHI?
+
+    // Insert a register to register copy at the top of the current block (but
+    // after any remaining phi nodes) which copies the new incoming register
+    // into the phi node destination.
+    if (isSourceDefinedByImplicitDef(MPhi, MRI))
+      // If all sources of a PHI node are implicit_def, just emit an
+      // implicit_def instead of a copy.
+      BuildMI(MBB, AfterPHIsIt, MPhi->getDebugLoc(),
+              TII->get(TargetOpcode::IMPLICIT_DEF), DestReg);
+    else {
+      // Can we reuse an earlier PHI node? This only happens for critical
+      // edges, typically those created by tail duplication.
+      unsigned &entry = LoweredPHIs[MPhi];
+      if (entry) {
+        // An identical PHI node was already lowered. Reuse the incoming
+        // register.
+        IncomingReg = entry;
+        reusedIncoming = true;
+        ++NumReused;
+        DEBUG(dbgs() << "Reusing " << PrintReg(IncomingReg) << " for "
+                     << *MPhi);
+      } else {
+        const TargetRegisterClass *RC = MF.getRegInfo().getRegClass(DestReg);
+        entry = IncomingReg = MF.getRegInfo().createVirtualRegister(RC);
+      }
+      BuildMI(MBB, AfterPHIsIt, MPhi->getDebugLoc(),
+              TII->get(TargetOpcode::COPY), DestReg)
+        .addReg(IncomingReg);
     }
-    BuildMI(MBB, AfterPHIsIt, MPhi->getDebugLoc(),
-            TII->get(TargetOpcode::COPY), DestReg)
-      .addReg(IncomingReg);
-  }
 
-  // Update live variable information if there is any.
-  LiveVariables *LV = getAnalysisIfAvailable<LiveVariables>();
-  if (LV) {
-    MachineInstr *PHICopy = prior(AfterPHIsIt);
-
-    if (IncomingReg) {
-      LiveVariables::VarInfo &VI = LV->getVarInfo(IncomingReg);
-
-      // Increment use count of the newly created virtual register.
-      LV->setPHIJoin(IncomingReg);
-
-      // When we are reusing the incoming register, it may already have been
-      // killed in this block. The old kill will also have been inserted at
-      // AfterPHIsIt, so it appears before the current PHICopy.
-      if (reusedIncoming)
-        if (MachineInstr *OldKill = VI.findKill(&MBB)) {
-          DEBUG(dbgs() << "Remove old kill from " << *OldKill);
-          LV->removeVirtualRegisterKilled(IncomingReg, OldKill);
-          DEBUG(MBB.dump());
-        }
+    // Update live variable information if there is any.
+    if (LV) {
+      MachineInstr *PHICopy = prior(AfterPHIsIt);
+
+      if (IncomingReg) {
+        LiveVariables::VarInfo &VI = LV->getVarInfo(IncomingReg);
+
+        // Increment use count of the newly created virtual register.
+        LV->setPHIJoin(IncomingReg);
+
+        // When we are reusing the incoming register, it may already have been
+        // killed in this block. The old kill will also have been inserted at
+        // AfterPHIsIt, so it appears before the current PHICopy.
+        if (reusedIncoming)
+          if (MachineInstr *OldKill = VI.findKill(&MBB)) {
+            DEBUG(dbgs() << "Remove old kill from " << *OldKill);
+            LV->removeVirtualRegisterKilled(IncomingReg, OldKill);
+            DEBUG(MBB.dump());
+          }
 
-      // Add information to LiveVariables to know that the incoming value is
-      // killed.  Note that because the value is defined in several places (once
-      // each for each incoming block), the "def" block and instruction fields
-      // for the VarInfo is not filled in.
-      LV->addVirtualRegisterKilled(IncomingReg, PHICopy);
+        // Add information to LiveVariables to know that the incoming value is
+        // killed.  Note that because the value is defined in several places
+        // (once each for each incoming block), the "def" block and
+        // instruction fields for the VarInfo is not filled in.
+        LV->addVirtualRegisterKilled(IncomingReg, PHICopy);
+      }
+
+      // Since we are going to be deleting the PHI node, if it is the last use
+      // of any registers, or if the value itself is dead, we need to move
+      // this information over to the new copy we just inserted.
+      LV->removeVirtualRegistersKilled(MPhi);
+
+      // If the result is dead, update LV.
+      if (isDead) {
+        LV->addVirtualRegisterDead(DestReg, PHICopy);
+        LV->removeVirtualRegisterDead(DestReg, MPhi);
+      }
     }
 
-    // Since we are going to be deleting the PHI node, if it is the last use of
-    // any registers, or if the value itself is dead, we need to move this
-    // information over to the new copy we just inserted.
-    LV->removeVirtualRegistersKilled(MPhi);
+    // Adjust the VRegPHIUseCount map to account for the removal of this PHI
+    // node.  All of the block's PHIs are accounted for before any kills are
+    // placed, so a source register feeding several of them is killed by the
+    // last copy that reads it.
+    for (unsigned i = 1; i != MPhi->getNumOperands(); i += 2)
+      --VRegPHIUseCount[BBVRegPair(MPhi->getOperand(i+1).getMBB()->getNumber(),
+                                   MPhi->getOperand(i).getReg())];
+
+    // Queue the incoming-side copies, grouped by predecessor.
+    SmallPtrSet<MachineBasicBlock*, 8> MBBsInsertedInto;
+    for (int i = NumSrcs - 1; i >= 0; --i) {
+      unsigned SrcReg = MPhi->getOperand(i*2+1).getReg();
+      assert(TargetRegisterInfo::isVirtualRegister(SrcReg) &&
+             "Machine PHI Operands must all be virtual registers!");
+
+      // Get the MachineBasicBlock equivalent of the BasicBlock that is the
+      // source path the PHI.
+      MachineBasicBlock &opBlock = *MPhi->getOperand(i*2+2).getMBB();
+
+      // Check to make sure we haven't already queued the copy for this block.
+      // This can happen because PHI nodes may have multiple entries for the
+      // same basic block.
+      if (!MBBsInsertedInto.insert(&opBlock))
+        continue;  // If the copy has already been queued, we're done.
+
+      std::pair<DenseMap<MachineBasicBlock*, unsigned>::iterator, bool> Ins =
+        PredIndex.insert(std::make_pair(&opBlock, PredOrder.size()));
+      if (Ins.second) {
+        PredOrder.push_back(&opBlock);
+        PredCopies.push_back(std::vector<PHISourceCopy>());
+      }
 
-    // If the result is dead, update LV.
-    if (isDead) {
-      LV->addVirtualRegisterDead(DestReg, PHICopy);
-      LV->removeVirtualRegisterDead(DestReg, MPhi);
+      PHISourceCopy SC;
+      SC.MPhi = MPhi;
+      SC.IncomingReg = IncomingReg;
+      SC.SrcReg = SrcReg;
+      SC.SrcSubReg = MPhi->getOperand(i*2+1).getSubReg();
+      SC.SrcUndef = MPhi->getOperand(i*2+1).isUndef() ||
+        isImplicitlyDefined(SrcReg, MRI);
+      SC.ReusedIncoming = reusedIncoming;
+      SC.Copy = 0;
+      PredCopies[Ins.first->second].push_back(SC);
     }
+
+    if (reusedIncoming || !IncomingReg)
+      DeadPHIs.push_back(MPhi);
   }
 
-  // Adjust the VRegPHIUseCount map to account for the removal of this PHI node.
-  for (unsigned i = 1; i != MPhi->getNumOperands(); i += 2)
-    --VRegPHIUseCount[BBVRegPair(MPhi->getOperand(i+1).getMBB()->getNumber(),
-                                 MPhi->getOperand(i).getReg())];
-
-  // Now loop over all of the incoming arguments, changing them to copy into the
-  // IncomingReg register in the corresponding predecessor basic block.
-  SmallPtrSet<MachineBasicBlock*, 8> MBBsInsertedInto;
-  for (int i = NumSrcs - 1; i >= 0; --i) {
-    unsigned SrcReg = MPhi->getOperand(i*2+1).getReg();
-    unsigned SrcSubReg = MPhi->getOperand(i*2+1).getSubReg();
-    bool SrcUndef = MPhi->getOperand(i*2+1).isUndef() ||
-      isImplicitlyDefined(SrcReg, MRI);
-    assert(TargetRegisterInfo::isVirtualRegister(SrcReg) &&
-           "Machine PHI Operands must all be virtual registers!");
-
-    // Get the MachineBasicBlock equivalent of the BasicBlock that is the source
-    // path the PHI.
-    MachineBasicBlock &opBlock = *MPhi->getOperand(i*2+2).getMBB();
-
-    // Check to make sure we haven't already emitted the copy for this block.
-    // This can happen because PHI nodes may have multiple entries for the same
-    // basic block.
-    if (!MBBsInsertedInto.insert(&opBlock))
-      continue;  // If the copy has already been emitted, we're done.
-
-    // Find a safe location to insert the copy, this may be the first terminator
-    // in the block (or end()).
-    MachineBasicBlock::iterator InsertPos =
-      findPHICopyInsertPoint(&opBlock, &MBB, SrcReg);
-
-    // Insert the copy.
-    if (!reusedIncoming && IncomingReg) {
-      if (SrcUndef) {
-        // The source register is undefined, so there is no need for a real
-        // COPY, but we still need to ensure joint dominance by defs.
-        // Insert an IMPLICIT_DEF instruction.
-        BuildMI(opBlock, InsertPos, MPhi->getDebugLoc(),
-                TII->get(TargetOpcode::IMPLICIT_DEF), IncomingReg);
-
-        // Clean up the old implicit-def, if there even was one.
-        if (MachineInstr *DefMI = MRI->getVRegDef(SrcReg))
-          if (DefMI->isImplicitDef())
-            ImpDefs.insert(DefMI);
-      } else {
-        BuildMI(opBlock, InsertPos, MPhi->getDebugLoc(),
-                TII->get(TargetOpcode::COPY), IncomingReg)
-          .addReg(SrcReg, 0, SrcSubReg);
+  // Second pass, per predecessor: insert the copies, then update the kill
+  // information for the block in one go.
+  for (unsigned pi = 0, pe = PredOrder.size(); pi != pe; ++pi) {
+    MachineBasicBlock &opBlock = *PredOrder[pi];
+    std::vector<PHISourceCopy> &Copies = PredCopies[pi];
+
+    // Find a safe location to insert the copies, this may be the first
+    // terminator in the block (or end()).  The location only depends on the
+    // source register when this block feeds a landing pad, so everything
+    // else shares a single lookup.
+    MachineBasicBlock::iterator InsertPos;
+    bool HaveInsertPos = false;
+
+    for (unsigned ci = 0, ce = Copies.size(); ci != ce; ++ci) {
+      PHISourceCopy &SC = Copies[ci];
+      if (MBB.isLandingPad())
+        InsertPos = findPHICopyInsertPoint(&opBlock, &MBB, SC.SrcReg);
+      else if (!HaveInsertPos) {
+        InsertPos = findPHICopyInsertPoint(&opBlock, &MBB, SC.SrcReg);
+        HaveInsertPos = true;
+      }
+
+      // Insert the copy.
+      if (!SC.ReusedIncoming && SC.IncomingReg) {
+        if (SC.SrcUndef) {
+          // The source register is undefined, so there is no need for a real
+          // COPY, but we still need to ensure joint dominance by defs.
+          // Insert an IMPLICIT_DEF instruction.
+          BuildMI(opBlock, InsertPos, SC.MPhi->getDebugLoc(),
+                  TII->get(TargetOpcode::IMPLICIT_DEF), SC.IncomingReg);
+
+          // Clean up the old implicit-def, if there even was one.
+          if (MachineInstr *DefMI = MRI->getVRegDef(SC.SrcReg))
+            if (DefMI->isImplicitDef())
+              ImpDefs.insert(DefMI);
+        } else {
+          SC.Copy = BuildMI(opBlock, InsertPos, SC.MPhi->getDebugLoc(),
+                            TII->get(TargetOpcode::COPY), SC.IncomingReg)
+            .addReg(SC.SrcReg, 0, SC.SrcSubReg);
+        }
       }
     }
 
-    // Now update live variable information if we have it.  Otherwise we're done
-    if (SrcUndef || !LV) continue;
+    // Now update live variable information if we have it.  Otherwise we're
+    // done.
+    if (!LV)
+      continue;
 
-    // We want to be able to insert a kill of the register if this PHI (aka, the
-    // copy we just inserted) is the last use of the source value.  Live
-    // variable analysis conservatively handles this by saying that the value is
-    // live until the end of the block the PHI entry lives in.  If the value
-    // really is dead at the PHI copy, there will be no successor blocks which
+    // We want to be able to insert a kill of the register if the copies we
+    // just inserted are the last use of the source value.  Live variable
+    // analysis conservatively handles this by saying that the value is live
+    // until the end of the block the PHI entry lives in.  If the value
+    // really is dead at the copy, there will be no successor blocks which
     // have the value live-in.
 
-    // Also check to see if this register is in use by another PHI node which
-    // has not yet been eliminated.  If so, it will be killed at an appropriate
-    // point later.
+    // The walk is backwards so that for a source register feeding several
+    // PHIs the kill lands on the last copy that reads it; the earlier ones
+    // are skipped.
+    MachineBasicBlock::iterator FirstTerm = opBlock.getFirstTerminator();
+    SmallSet<unsigned, 16> KilledSrcs;
+    for (unsigned ci = Copies.size(); ci != 0; --ci) {
+      PHISourceCopy &SC = Copies[ci-1];
+      if (SC.SrcUndef)
+        continue;
+      if (!KilledSrcs.insert(SC.SrcReg))
+        continue;
 
-    // Is it used by any PHI instructions in this block?
-    bool ValueIsUsed = VRegPHIUseCount[BBVRegPair(opBlock.getNumber(), SrcReg)];
+      // Also check to see if this register is in use by another PHI node
+      // which has not yet been eliminated.  If so, it will be killed at an
+      // appropriate point later.
+      bool ValueIsUsed =
+        VRegPHIUseCount[BBVRegPair(opBlock.getNumber(), SC.SrcReg)];
+      if (ValueIsUsed || LV->isLiveOut(SC.SrcReg, opBlock))
+        continue;
 
-    // Okay, if we now know that the value is not live out of the block, we can
-    // add a kill marker in this block saying that it kills the incoming value!
-    if (!ValueIsUsed && !LV->isLiveOut(SrcReg, opBlock)) {
-      // In our final twist, we have to decide which instruction kills the
+      // Okay, we now know that the value is not live out of the block; we
+      // can add a kill marker in this block saying that it kills the
+      // incoming value!  We have to decide which instruction kills the
       // register.  In most cases this is the copy, however, terminator
       // instructions at the end of the block may also use the value. In this
       // case, we should mark the last such terminator as being the killing
       // block, not the copy.
       MachineBasicBlock::iterator KillInst = opBlock.end();
-      MachineBasicBlock::iterator FirstTerm = opBlock.getFirstTerminator();
       for (MachineBasicBlock::iterator Term = FirstTerm;
-          Term != opBlock.end(); ++Term) {
-        if (Term->readsRegister(SrcReg))
+           Term != opBlock.end(); ++Term) {
+        if (Term->readsRegister(SC.SrcReg))
           KillInst = Term;
       }
 
       if (KillInst == opBlock.end()) {
         // No terminator uses the register.
 
-        if (reusedIncoming || !IncomingReg) {
-          // We may have to rewind a bit if we didn't insert a copy this time.
+        if (SC.Copy) {
+          // We just inserted this copy.
+          KillInst = SC.Copy;
+        } else {
+          // We may have to rewind a bit if we didn't insert a copy this
+          // time.
           KillInst = FirstTerm;
           while (KillInst != opBlock.begin()) {
             --KillInst;
             if (KillInst->isDebugValue())
               continue;
-            if (KillInst->readsRegister(SrcReg))
+            if (KillInst->readsRegister(SC.SrcReg))
               break;
           }
-        } else {
-          // We just inserted this copy.
-          KillInst = prior(InsertPos);
         }
       }
-      assert(KillInst->readsRegister(SrcReg) && "Cannot find kill instruction");
+      assert(KillInst->readsRegister(SC.SrcReg) &&
+             "Cannot find kill instruction");
 
       // Finally, mark it killed.
-      LV->addVirtualRegisterKilled(SrcReg, KillInst);
+      LV->addVirtualRegisterKilled(SC.SrcReg, KillInst);
 
       // This vreg no longer lives all of the way through opBlock.
       unsigned opBlockNum = opBlock.getNumber();
-      LV->getVarInfo(SrcReg).AliveBlocks.reset(opBlockNum);
+      LV->getVarInfo(SC.SrcReg).AliveBlocks.reset(opBlockNum);
     }
   }
 
-  // Really delete the PHI instruction now, if it is not in the LoweredPHIs map.
-  if (reusedIncoming || !IncomingReg)
-    MF.DeleteMachineInstr(MPhi);
+  // Really delete the PHI instructions now, the ones that are not held alive
+  // by the LoweredPHIs map.
+  for (unsigned i = 0, e = DeadPHIs.size(); i != e; ++i)
+    MF.DeleteMachineInstr(DeadPHIs[i]);
 }
 
 /// analyzePHINodes - Gather information about the PHI nodes in here. In
@@ -418,7 +536,8 @@ void PHIElimination::analyzePHINodes(const MachineFunction& MF) {
 
 bool PHIElimination::SplitPHIEdges(MachineFunction &MF,
                                    MachineBasicBlock &MBB,
-                                   LiveVariables &LV,
+                                   LiveVariables *LV,
+                                   LazyLiveness *LL,
                                    MachineLoopInfo *MLI) {
   if (MBB.empty() || !MBB.front().isPHI() || MBB.isLandingPad())
     return false;   // Quick exit for basic blocks without PHIs.
@@ -426,7 +545,15 @@ bool PHIElimination::SplitPHIEdges(MachineFunction &MF,
   const MachineLoop *CurLoop = MLI ? MLI->getLoopFor(&MBB) : 0;
   bool IsLoopHeader = CurLoop && &MBB == CurLoop->getHeader();
 
-  bool Changed = false;
+  // Scan all PHIs first and collect the edges to split as a set; the splits
+  // are applied in bulk afterwards.  With many PHIs per block the same
+  // registers and predecessors recur, so the liveness queries are memoized.
+  // Nothing mutates during the scan, which keeps the caches trivially valid.
+  SmallVector<MachineBasicBlock*, 8> ToSplit;
+  SmallPtrSet<MachineBasicBlock*, 8> ToSplitSet;
+  DenseMap<std::pair<unsigned, MachineBasicBlock*>, bool> LiveOutCache;
+  DenseMap<unsigned, bool> LiveInCache;
+
   for (MachineBasicBlock::iterator BBI = MBB.begin(), BBE = MBB.end();
        BBI != BBE && BBI->isPHI(); ++BBI) {
     for (unsigned i = 1, e = BBI->getNumOperands(); i != e; i += 2) {
@@ -436,6 +563,10 @@ bool PHIElimination::SplitPHIEdges(MachineFunction &MF,
       if (PreMBB->succ_size() == 1)
         continue;
 
+      // Already queued by an earlier PHI.
+      if (ToSplitSet.count(PreMBB))
+        continue;
+
       // Avoid splitting backedges of loops. It would introduce small
       // out-of-line blocks into the loop which is very bad for code placement.
       if (PreMBB == &MBB)
@@ -450,7 +581,14 @@ bool PHIElimination::SplitPHIEdges(MachineFunction &MF,
       // there is a risk it may not be coalesced away.
       //
       // If the copy would be a kill, there is no need to split the edge.
-      if (!LV.isLiveOut(Reg, *PreMBB))
+      std::pair<DenseMap<std::pair<unsigned, MachineBasicBlock*>, bool>
+                  ::iterator, bool> LO =
+        LiveOutCache.insert(std::make_pair(std::make_pair(Reg, PreMBB),
+                                           false));
+      if (LO.second)
+        LO.first->second = LV ? LV->isLiveOut(Reg, *PreMBB)
+                              : LL->isLiveOut(Reg, *PreMBB);
+      if (!LO.first->second)
         continue;
 
       DEBUG(dbgs() << PrintReg(Reg) << " live-out before critical edge BB#"
@@ -465,7 +603,11 @@ bool PHIElimination::SplitPHIEdges(MachineFunction &MF,
       // is likely to be left after coalescing. If we are looking at a loop
       // exiting edge, split it so we won't insert code in the loop, otherwise
       // don't bother.
-      bool ShouldSplit = !LV.isLiveIn(Reg, MBB);
+      std::pair<DenseMap<unsigned, bool>::iterator, bool> LI =
+        LiveInCache.insert(std::make_pair(Reg, false));
+      if (LI.second)
+        LI.first->second = LV ? LV->isLiveIn(Reg, MBB) : LL->isLiveIn(Reg, MBB);
+      bool ShouldSplit = !LI.first->second;
 
       // Check for a loop exiting edge.
       if (!ShouldSplit && CurLoop != PreLoop) {
@@ -482,13 +624,25 @@ bool PHIElimination::SplitPHIEdges(MachineFunction &MF,
       }
       if (!ShouldSplit)
         continue;
-      if (!PreMBB->SplitCriticalEdge(&MBB, this)) {
-        DEBUG(dbgs() << "Failed to split ciritcal edge.\n");
-        continue;
-      }
-      Changed = true;
-      ++NumCriticalEdgesSplit;
+      ToSplit.push_back(PreMBB);
+      ToSplitSet.insert(PreMBB);
+    }
+  }
+
+  // Apply the collected splits in bulk.
+  bool Changed = false;
+  for (unsigned i = 0, e = ToSplit.size(); i != e; ++i) {
+    if (!ToSplit[i]->SplitCriticalEdge(&MBB, this)) {
+      DEBUG(dbgs() << "Failed to split ciritcal edge.\n");
+      continue;
     }
+    Changed = true;
+    ++NumCriticalEdgesSplit;
   }
+
+  // Splitting an edge changed the CFG, so cached lazy liveness is stale.
+  // LiveVariables is updated by SplitCriticalEdge itself.
+  if (Changed && LL)
+    LL->clear();
   return Changed;
 }
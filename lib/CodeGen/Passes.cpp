@@ -81,6 +81,8 @@ static cl::opt<bool> PrintISelInput("print-isel-input", cl::Hidden,
     cl::desc("Print LLVM IR input to isel pass"));
 static cl::opt<bool> PrintGCInfo("print-gc", cl::Hidden,
     cl::desc("Dump garbage collector data"));
+static cl::opt<std::string> TelemetryFile("codegen-telemetry-file", cl::Hidden,
+    cl::desc("Emit per-function code size and spill telemetry to this file"));
 static cl::opt<bool> VerifyMachineCode("verify-machineinstrs", cl::Hidden,
     cl::desc("Verify generated machine code"),
     cl::init(getenv("LLVM_VERIFY_MACHINEINSTRS")!=NULL));
@@ -521,6 +523,10 @@ void TargetPassConfig::addMachinePasses() {
 
   if (addPreEmitPass())
     printAndVerify("After PreEmit passes");
+
+  // Per-function telemetry runs last so it records the final code.
+  if (!TelemetryFile.empty())
+    addPass(createMachineFunctionTelemetryPass(TelemetryFile));
 }
 
 /// Add passes that optimize machine instructions in SSA form.
@@ -292,6 +292,12 @@ bool PostRAScheduler::runOnMachineFunction(MachineFunction &Fn) {
   // Loop over all of the basic blocks
   for (MachineFunction::iterator MBB = Fn.begin(), MBBe = Fn.end();
        MBB != MBBe; ++MBB) {
+    // A block with fewer than two instructions cannot be reordered and has no
+    // anti-dependence to break; don't pay for the per-block live-range and
+    // anti-dependence state setup on it.  Entry stubs, landing pads and bare
+    // fall-through blocks are common enough for this to matter.
+    if (MBB->size() < 2)
+      continue;
 #ifndef NDEBUG
     // If DebugDiv > 0 then only schedule MBB with (ID % DebugDiv) == DebugMod
     if (DebugDiv > 0) {
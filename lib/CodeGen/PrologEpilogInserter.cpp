@@ -25,6 +25,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
 #include "llvm/CodeGen/MachineDominators.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineInstr.h"
@@ -47,8 +48,16 @@ using namespace llvm;
 char PEI::ID = 0;
 char &llvm::PrologEpilogCodeInserterID = PEI::ID;
 
+// Pack the non-fixed stack slots hottest-first instead of in index order.
+// Also read by PEI::getAnalysisUsage in ShrinkWrapping.cpp.
+cl::opt<bool>
+PEIPackFrameObjects("pei-pack-frame-objects", cl::Hidden,
+             cl::desc("Order stack slots by estimated access frequency when "
+                      "assigning frame offsets"));
+
 INITIALIZE_PASS_BEGIN(PEI, "prologepilog",
                 "Prologue/Epilogue Insertion", false, false)
+INITIALIZE_PASS_DEPENDENCY(MachineBlockFrequencyInfo)
 INITIALIZE_PASS_DEPENDENCY(MachineLoopInfo)
 INITIALIZE_PASS_DEPENDENCY(MachineDominatorTree)
 INITIALIZE_PASS_DEPENDENCY(TargetPassConfig)
@@ -475,6 +484,61 @@ AdjustStackOffset(MachineFrameInfo *MFI, int FrameIdx,
   }
 }
 
+namespace {
+  /// FrameObjectCompare - Orders frame objects hottest-first.  Ties fall to
+  /// the more aligned object, which keeps alignment padding to a minimum, and
+  /// then to index order for determinism.
+  class FrameObjectCompare {
+    const MachineFrameInfo *MFI;
+    const std::vector<uint64_t> &Weights;
+  public:
+    FrameObjectCompare(const MachineFrameInfo *MFI,
+                       const std::vector<uint64_t> &Weights)
+      : MFI(MFI), Weights(Weights) {}
+
+    bool operator()(unsigned A, unsigned B) const {
+      if (Weights[A] != Weights[B])
+        return Weights[A] > Weights[B];
+      unsigned AlignA = MFI->getObjectAlignment(A);
+      unsigned AlignB = MFI->getObjectAlignment(B);
+      if (AlignA != AlignB)
+        return AlignA > AlignB;
+      return A < B;
+    }
+  };
+}
+
+/// orderFrameObjects - Reorder the given stack slots so that the most
+/// frequently accessed ones are assigned offsets first.  Hot slots end up
+/// clustered near the start of the local area, sharing cache lines and, on
+/// targets with scaled frame addressing, the shortest encodings; sorting
+/// equal-weight slots by decreasing alignment keeps padding down.
+void PEI::orderFrameObjects(MachineFunction &Fn,
+                            SmallVectorImpl<unsigned> &Objects) {
+  MachineFrameInfo *MFI = Fn.getFrameInfo();
+  MachineBlockFrequencyInfo &MBFI = getAnalysis<MachineBlockFrequencyInfo>();
+
+  // Accumulate a block-frequency-weighted access count for every stack slot.
+  std::vector<uint64_t> Weights(MFI->getObjectIndexEnd(), 0);
+  for (MachineFunction::const_iterator BB = Fn.begin(), BE = Fn.end();
+       BB != BE; ++BB) {
+    uint64_t Freq = MBFI.getBlockFreq(BB).getFrequency();
+    if (!Freq)
+      Freq = 1;
+    for (MachineBasicBlock::const_iterator MI = BB->begin(), ME = BB->end();
+         MI != ME; ++MI)
+      for (unsigned i = 0, e = MI->getNumOperands(); i != e; ++i) {
+        const MachineOperand &MO = MI->getOperand(i);
+        if (MO.isFI() && MO.getIndex() >= 0 &&
+            MO.getIndex() < (int)Weights.size())
+          Weights[MO.getIndex()] += Freq;
+      }
+  }
+
+  std::stable_sort(Objects.begin(), Objects.end(),
+                   FrameObjectCompare(MFI, Weights));
+}
+
 /// calculateFrameObjectOffsets - Calculate actual frame offsets for all of the
 /// abstract stack objects.
 ///
@@ -611,6 +675,7 @@ void PEI::calculateFrameObjectOffsets(MachineFunction &Fn) {
 
   // Then assign frame offsets to stack objects that are not used to spill
   // callee saved registers.
+  SmallVector<unsigned, 32> ObjectsToAllocate;
   for (unsigned i = 0, e = MFI->getObjectIndexEnd(); i != e; ++i) {
     if (MFI->isObjectPreAllocated(i) &&
         MFI->getUseLocalStackAllocationBlock())
@@ -626,9 +691,18 @@ void PEI::calculateFrameObjectOffsets(MachineFunction &Fn) {
     if (LargeStackObjs.count(i))
       continue;
 
-    AdjustStackOffset(MFI, i, StackGrowsDown, Offset, MaxAlign);
+    ObjectsToAllocate.push_back(i);
   }
 
+  // When requested, lay the remaining objects out hottest-first instead of in
+  // index order.
+  if (PEIPackFrameObjects && !ObjectsToAllocate.empty())
+    orderFrameObjects(Fn, ObjectsToAllocate);
+
+  for (unsigned i = 0, e = ObjectsToAllocate.size(); i != e; ++i)
+    AdjustStackOffset(MFI, ObjectsToAllocate[i], StackGrowsDown, Offset,
+                      MaxAlign);
+
   // Make sure the special register scavenging spill slot is closest to the
   // stack pointer.
   if (RS && (!TFI.hasFP(Fn) || RegInfo->needsStackRealignment(Fn) ||
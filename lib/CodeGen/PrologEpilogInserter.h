@@ -125,6 +125,8 @@ namespace llvm {
     void calculateCallsInformation(MachineFunction &Fn);
     void calculateCalleeSavedRegisters(MachineFunction &Fn);
     void insertCSRSpillsAndRestores(MachineFunction &Fn);
+    void orderFrameObjects(MachineFunction &Fn,
+                           SmallVectorImpl<unsigned> &Objects);
     void calculateFrameObjectOffsets(MachineFunction &Fn);
     void replaceFrameIndices(MachineFunction &Fn);
     void scavengeFrameVirtualRegs(MachineFunction &Fn);
@@ -216,6 +216,11 @@ void RegPressureTracker::init(const MachineFunction *mf,
   CurrPos = pos;
   CurrSetPressure.assign(TRI->getNumRegPressureSets(), 0);
 
+  // Instructions from a previous region may have been deleted; drop their
+  // memoized deltas rather than just stamping them stale.
+  DeltaCache.clear();
+  invalidateCachedDeltas();
+
   if (RequireIntervals)
     static_cast<IntervalPressure&>(P).reset();
   else
@@ -370,6 +375,7 @@ static void collectOperands(const MachineInstr *MI,
 
 /// Force liveness of registers.
 void RegPressureTracker::addLiveRegs(ArrayRef<unsigned> Regs) {
+  invalidateCachedDeltas();
   for (unsigned i = 0, e = Regs.size(); i != e; ++i) {
     if (LiveRegs.insert(Regs[i]))
       increaseRegPressure(Regs[i]);
@@ -400,6 +406,8 @@ void RegPressureTracker::discoverLiveOut(unsigned Reg) {
 
 /// Recede across the previous instruction.
 bool RegPressureTracker::recede() {
+  invalidateCachedDeltas();
+
   // Check for the top of the analyzable region.
   if (CurrPos == MBB->begin()) {
     closeRegion();
@@ -465,6 +473,8 @@ bool RegPressureTracker::recede() {
 
 /// Advance across the current instruction.
 bool RegPressureTracker::advance() {
+  invalidateCachedDeltas();
+
   // Check for the bottom of the analyzable region.
   if (CurrPos == MBB->end()) {
     closeRegion();
@@ -645,30 +655,37 @@ void RegPressureTracker::bumpUpwardPressure(const MachineInstr *MI) {
 ///
 /// This assumes that the current LiveOut set is sufficient.
 ///
-/// FIXME: This is expensive for an on-the-fly query. We need to cache the
-/// result per-SUnit with enough information to adjust for the current
-/// scheduling position. But this works as a proof of concept.
+/// The result is memoized per instruction and reused until the tracker's
+/// state changes, since candidate evaluation asks for the same instruction's
+/// delta once per scheduler pick.
 void RegPressureTracker::
 getMaxUpwardPressureDelta(const MachineInstr *MI, RegPressureDelta &Delta,
                           ArrayRef<PressureElement> CriticalPSets,
                           ArrayRef<unsigned> MaxPressureLimit) {
+  CachedDelta &CD = DeltaCache[MI];
+  if (CD.Generation == Generation) {
+    Delta = CD.Delta;
+    return;
+  }
+
   // Snapshot Pressure.
-  // FIXME: The snapshot heap space should persist. But I'm planning to
-  // summarize the pressure effect so we don't need to snapshot at all.
-  std::vector<unsigned> SavedPressure = CurrSetPressure;
-  std::vector<unsigned> SavedMaxPressure = P.MaxSetPressure;
+  SnapshotPressure = CurrSetPressure;
+  SnapshotMaxPressure = P.MaxSetPressure;
 
   bumpUpwardPressure(MI);
 
-  computeExcessPressureDelta(SavedPressure, CurrSetPressure, Delta, TRI);
-  computeMaxPressureDelta(SavedMaxPressure, P.MaxSetPressure, CriticalPSets,
+  computeExcessPressureDelta(SnapshotPressure, CurrSetPressure, Delta, TRI);
+  computeMaxPressureDelta(SnapshotMaxPressure, P.MaxSetPressure, CriticalPSets,
                           MaxPressureLimit, Delta);
   assert(Delta.CriticalMax.UnitIncrease >= 0 &&
          Delta.CurrentMax.UnitIncrease >= 0 && "cannot decrease max pressure");
 
   // Restore the tracker's state.
-  P.MaxSetPressure.swap(SavedMaxPressure);
-  CurrSetPressure.swap(SavedPressure);
+  P.MaxSetPressure.swap(SnapshotMaxPressure);
+  CurrSetPressure.swap(SnapshotPressure);
+
+  CD.Delta = Delta;
+  CD.Generation = Generation;
 }
 
 /// Helper to find a vreg use between two indices [PriorUseIdx, NextUseIdx).
@@ -744,21 +761,30 @@ void RegPressureTracker::
 getMaxDownwardPressureDelta(const MachineInstr *MI, RegPressureDelta &Delta,
                             ArrayRef<PressureElement> CriticalPSets,
                             ArrayRef<unsigned> MaxPressureLimit) {
+  CachedDelta &CD = DeltaCache[MI];
+  if (CD.Generation == Generation) {
+    Delta = CD.Delta;
+    return;
+  }
+
   // Snapshot Pressure.
-  std::vector<unsigned> SavedPressure = CurrSetPressure;
-  std::vector<unsigned> SavedMaxPressure = P.MaxSetPressure;
+  SnapshotPressure = CurrSetPressure;
+  SnapshotMaxPressure = P.MaxSetPressure;
 
   bumpDownwardPressure(MI);
 
-  computeExcessPressureDelta(SavedPressure, CurrSetPressure, Delta, TRI);
-  computeMaxPressureDelta(SavedMaxPressure, P.MaxSetPressure, CriticalPSets,
+  computeExcessPressureDelta(SnapshotPressure, CurrSetPressure, Delta, TRI);
+  computeMaxPressureDelta(SnapshotMaxPressure, P.MaxSetPressure, CriticalPSets,
                           MaxPressureLimit, Delta);
   assert(Delta.CriticalMax.UnitIncrease >= 0 &&
          Delta.CurrentMax.UnitIncrease >= 0 && "cannot decrease max pressure");
 
   // Restore the tracker's state.
-  P.MaxSetPressure.swap(SavedMaxPressure);
-  CurrSetPressure.swap(SavedPressure);
+  P.MaxSetPressure.swap(SnapshotMaxPressure);
+  CurrSetPressure.swap(SnapshotPressure);
+
+  CD.Delta = Delta;
+  CD.Generation = Generation;
 }
 
 /// Get the pressure of each PSet after traversing this instruction bottom-up.
@@ -699,14 +699,12 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
   // Remember where a generic side-effecting instruction is as we procede.
   SUnit *BarrierChain = 0, *AliasChain = 0;
 
-  // Memory references to specific known memory locations are tracked
-  // so that they can be given more precise dependencies. We track
-  // separately the known memory locations that may alias and those
-  // that are known not to alias
-  MapVector<const Value *, SUnit *> AliasMemDefs, NonAliasMemDefs;
-  MapVector<const Value *, std::vector<SUnit *> > AliasMemUses, NonAliasMemUses;
   std::set<SUnit*> RejectMemNodes;
 
+  assert(AliasMemDefs.empty() && NonAliasMemDefs.empty() &&
+         AliasMemUses.empty() && NonAliasMemUses.empty() &&
+         "Only BuildGraph should update the memory location maps");
+
   // Remove any stale debug info; sometimes BuildSchedGraph is called again
   // without emitting the info from the previous call.
   DbgValues.clear();
@@ -978,6 +976,10 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
   Uses.clear();
   VRegDefs.clear();
   PendingLoads.clear();
+  AliasMemDefs.clear();
+  NonAliasMemDefs.clear();
+  AliasMemUses.clear();
+  NonAliasMemUses.clear();
 }
 
 void ScheduleDAGInstrs::dumpNode(const SUnit *SU) const {
@@ -18,6 +18,7 @@
 
 #define DEBUG_TYPE "dagcombine"
 #include "llvm/CodeGen/SelectionDAG.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
@@ -27,6 +28,7 @@
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
@@ -65,23 +67,14 @@ namespace {
 
     // Worklist of all of the nodes that need to be simplified.
     //
-    // This has the semantics that when adding to the worklist,
-    // the item added must be next to be processed. It should
-    // also only appear once. The naive approach to this takes
-    // linear time.
-    //
-    // To reduce the insert/remove time to logarithmic, we use
-    // a set and a vector to maintain our worklist.
-    //
-    // The set contains the items on the worklist, but does not
-    // maintain the order they should be visited.
-    //
-    // The vector maintains the order nodes should be visited, but may
-    // contain duplicate or removed nodes. When choosing a node to
-    // visit, we pop off the order stack until we find an item that is
-    // also in the contents set. All operations are O(log N).
-    SmallPtrSet<SDNode*, 64> WorkListContents;
+    // Each node holds at most one live slot in the order vector; the map
+    // holds the vector index of every queued node.  Re-adding a queued node
+    // nulls its old slot and pushes it to the back, preserving the contract
+    // that the most recently touched node is the next to be processed, and
+    // removal nulls out the node's slot through the map.  The pop loop in
+    // Run skips null slots.
     SmallVector<SDNode*, 64> WorkListOrder;
+    DenseMap<SDNode*, unsigned> WorkListMap;
 
     // AA - Used for DAG load/store alias analysis.
     AliasAnalysis &AA;
@@ -101,17 +94,28 @@ namespace {
     SDValue visit(SDNode *N);
 
   public:
-    /// AddToWorkList - Add to the work list making sure its instance is at the
-    /// back (next to be processed.)
+    /// AddToWorkList - Add to the work list, making sure its entry will be
+    /// the next to be processed by nulling out any earlier entry for it.
     void AddToWorkList(SDNode *N) {
-      WorkListContents.insert(N);
+      std::pair<DenseMap<SDNode*, unsigned>::iterator, bool> Ins =
+        WorkListMap.insert(std::make_pair(N, WorkListOrder.size()));
+      if (!Ins.second) {
+        WorkListOrder[Ins.first->second] = 0;
+        Ins.first->second = WorkListOrder.size();
+      }
       WorkListOrder.push_back(N);
     }
 
-    /// removeFromWorkList - remove all instances of N from the worklist.
+    /// removeFromWorkList - remove N from the worklist if it is present.
     ///
     void removeFromWorkList(SDNode *N) {
-      WorkListContents.erase(N);
+      DenseMap<SDNode*, unsigned>::iterator It = WorkListMap.find(N);
+      if (It == WorkListMap.end())
+        return;
+      // Null out the slot rather than shifting the vector; the pop loop in
+      // Run skips null entries.
+      WorkListOrder[It->second] = 0;
+      WorkListMap.erase(It);
     }
 
     SDValue CombineTo(SDNode *N, const SDValue *To, unsigned NumTo,
@@ -1006,15 +1010,19 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
 
   // while the worklist isn't empty, find a node and
   // try and combine it.
-  while (!WorkListContents.empty()) {
-    SDNode *N;
-    // The WorkListOrder holds the SDNodes in order, but it may contain duplicates.
-    // In order to avoid a linear scan, we use a set (O(log N)) to hold what the
-    // worklist *should* contain, and check the node we want to visit is should
-    // actually be visited.
-    do {
-      N = WorkListOrder.pop_back_val();
-    } while (!WorkListContents.erase(N));
+  unsigned BudgetPollCount = 0;
+  while (!WorkListOrder.empty()) {
+    // Every combine leaves the DAG in a consistent state, so when the
+    // -pass-budget runs out we simply stop pulling work off the list.  Poll
+    // sparingly; reading the clock on every node would be noticeable.
+    if ((++BudgetPollCount & 255) == 0 && PassBudgetExceeded())
+      break;
+
+    // Slots nulled out by removeFromWorkList are skipped here.
+    SDNode *N = WorkListOrder.pop_back_val();
+    if (N == 0)
+      continue;
+    WorkListMap.erase(N);
 
     // If N has no uses, it is dead.  Make sure to revisit all N's operands once
     // N is deleted from the DAG, since they too may now be dead or may have a
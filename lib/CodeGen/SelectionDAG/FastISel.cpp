@@ -935,6 +935,92 @@ FastISel::SelectExtractValue(const User *U) {
   return true;
 }
 
+bool
+FastISel::SelectInsertValue(const User *U) {
+  const InsertValueInst *IVI = dyn_cast<InsertValueInst>(U);
+  if (!IVI)
+    return false;
+
+  const Value *Agg = IVI->getAggregateOperand();
+  const Value *Val = IVI->getInsertedValueOperand();
+  Type *AggTy = Agg->getType();
+
+  // Compute the register layout of the aggregate and the position of the
+  // slice being replaced, mirroring the arithmetic in SelectExtractValue.
+  SmallVector<EVT, 4> AggValueVTs;
+  ComputeValueVTs(TLI, AggTy, AggValueVTs);
+  unsigned VTIndex = ComputeLinearIndex(AggTy, IVI->getIndices());
+
+  unsigned StartReg = 0, NumAggRegs = 0;
+  for (unsigned i = 0, e = AggValueVTs.size(); i != e; ++i) {
+    unsigned N = TLI.getNumRegisters(FuncInfo.Fn->getContext(),
+                                     AggValueVTs[i]);
+    if (i < VTIndex)
+      StartReg += N;
+    NumAggRegs += N;
+  }
+  if (NumAggRegs == 0)
+    return false;
+
+  SmallVector<EVT, 4> ValVTs;
+  ComputeValueVTs(TLI, Val->getType(), ValVTs);
+  unsigned NumValRegs = 0;
+  for (unsigned i = 0, e = ValVTs.size(); i != e; ++i)
+    NumValRegs += TLI.getNumRegisters(FuncInfo.Fn->getContext(), ValVTs[i]);
+
+  // Get the base register of the incoming aggregate.  An undef aggregate is
+  // common (chained inserts start from one) and needs no source registers at
+  // all; other aggregate constants are not handled, as in SelectExtractValue.
+  unsigned AggBaseReg = 0;
+  if (!isa<UndefValue>(Agg)) {
+    DenseMap<const Value *, unsigned>::iterator I = FuncInfo.ValueMap.find(Agg);
+    if (I != FuncInfo.ValueMap.end())
+      AggBaseReg = I->second;
+    else if (isa<Instruction>(Agg))
+      AggBaseReg = FuncInfo.InitializeRegForValue(Agg);
+    else
+      return false;
+  }
+
+  // Get the registers holding the value being inserted.  If it is itself an
+  // aggregate (a nested insert), it can only come from the value map; scalar
+  // values can be materialized.
+  unsigned ValBaseReg;
+  if (Val->getType()->isAggregateType()) {
+    DenseMap<const Value *, unsigned>::iterator I = FuncInfo.ValueMap.find(Val);
+    if (I != FuncInfo.ValueMap.end())
+      ValBaseReg = I->second;
+    else if (isa<Instruction>(Val))
+      ValBaseReg = FuncInfo.InitializeRegForValue(Val);
+    else
+      return false;
+  } else {
+    ValBaseReg = getRegForValue(Val);
+    if (ValBaseReg == 0)
+      return false;
+  }
+
+  // Build the result by copying the unchanged registers of the aggregate and
+  // the registers of the inserted value into a fresh consecutive range.
+  unsigned ResultReg = FuncInfo.CreateRegs(IVI->getType());
+  for (unsigned i = 0; i != NumAggRegs; ++i) {
+    if (i >= StartReg && i < StartReg + NumValRegs)
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+              TII.get(TargetOpcode::COPY), ResultReg + i)
+        .addReg(ValBaseReg + (i - StartReg));
+    else if (AggBaseReg)
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+              TII.get(TargetOpcode::COPY), ResultReg + i)
+        .addReg(AggBaseReg + i);
+    else
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+              TII.get(TargetOpcode::IMPLICIT_DEF), ResultReg + i);
+  }
+
+  UpdateValueMap(IVI, ResultReg, NumAggRegs);
+  return true;
+}
+
 bool
 FastISel::SelectOperator(const User *I, unsigned Opcode) {
   switch (Opcode) {
@@ -1042,6 +1128,9 @@ FastISel::SelectOperator(const User *I, unsigned Opcode) {
   case Instruction::ExtractValue:
     return SelectExtractValue(I);
 
+  case Instruction::InsertValue:
+    return SelectInsertValue(I);
+
   case Instruction::PHI:
     llvm_unreachable("FastISel shouldn't visit PHI nodes!");
 
@@ -53,6 +53,13 @@
 #include <cmath>
 using namespace llvm;
 
+/// RecycleDAGMemory - The DAG is built and torn down once per basic block,
+/// and the operand pool usually refills to a similar size each time.  Keep
+/// the slabs warm across blocks instead of handing them back to malloc.
+static cl::opt<bool>
+RecycleDAGMemory("dag-recycle-memory", cl::Hidden, cl::init(true),
+                 cl::desc("Reuse SelectionDAG allocator memory across blocks"));
+
 /// makeVTList - Return an instance of the SDVTList struct initialized with the
 /// specified members.
 static SDVTList makeVTList(const EVT *VTs, unsigned NumVTs) {
@@ -904,7 +911,14 @@ void SelectionDAG::allnodes_clear() {
 
 void SelectionDAG::clear() {
   allnodes_clear();
-  OperandAllocator.Reset();
+  // Node memory is already recycled by NodeAllocator, and CSEMap retains its
+  // bucket array (the previous block's high-water mark) across clear().
+  // Keeping the operand slabs warm as well makes clearing the DAG between
+  // blocks nearly malloc-free.
+  if (RecycleDAGMemory)
+    OperandAllocator.ResetForReuse();
+  else
+    OperandAllocator.Reset();
   CSEMap.clear();
 
   ExtendedValueTypeNodes.clear();
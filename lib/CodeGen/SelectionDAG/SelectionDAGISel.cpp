@@ -136,6 +136,12 @@ STATISTIC(NumFastIselFailShuffleVector,"Fast isel fails on ShuffleVector");
 STATISTIC(NumFastIselFailExtractValue,"Fast isel fails on ExtractValue");
 STATISTIC(NumFastIselFailInsertValue,"Fast isel fails on InsertValue");
 STATISTIC(NumFastIselFailLandingPad,"Fast isel fails on LandingPad");
+
+  // Intrinsic instructions...
+STATISTIC(NumFastIselFailIntrinsicCall, "Fast isel fails on Intrinsic call");
+STATISTIC(NumFastIselFailMemcpy,"Fast isel fails on llvm.memcpy");
+STATISTIC(NumFastIselFailMemmove,"Fast isel fails on llvm.memmove");
+STATISTIC(NumFastIselFailMemset,"Fast isel fails on llvm.memset");
 #endif
 
 static cl::opt<bool>
@@ -969,7 +975,18 @@ static void collectFailStats(const Instruction *I) {
   case Instruction::FCmp:           NumFastIselFailFCmp++; return;
   case Instruction::PHI:            NumFastIselFailPHI++; return;
   case Instruction::Select:         NumFastIselFailSelect++; return;
-  case Instruction::Call:           NumFastIselFailCall++; return;
+  case Instruction::Call:
+    // Break calls down further: intrinsic calls are the coverage targets
+    // worth acting on, and the memory intrinsics in particular.
+    if (const IntrinsicInst *Intrin = dyn_cast<IntrinsicInst>(I)) {
+      switch (Intrin->getIntrinsicID()) {
+      default: NumFastIselFailIntrinsicCall++; return;
+      case Intrinsic::memcpy:  NumFastIselFailMemcpy++; return;
+      case Intrinsic::memmove: NumFastIselFailMemmove++; return;
+      case Intrinsic::memset:  NumFastIselFailMemset++; return;
+      }
+    }
+    NumFastIselFailCall++; return;
   case Instruction::Shl:            NumFastIselFailShl++; return;
   case Instruction::LShr:           NumFastIselFailLShr++; return;
   case Instruction::AShr:           NumFastIselFailAShr++; return;
@@ -2005,7 +2022,7 @@ CheckSame(const unsigned char *MatcherTable, unsigned &MatcherIndex,
 LLVM_ATTRIBUTE_ALWAYS_INLINE static bool
 CheckPatternPredicate(const unsigned char *MatcherTable, unsigned &MatcherIndex,
                       const SelectionDAGISel &SDISel) {
-  return SDISel.CheckPatternPredicate(MatcherTable[MatcherIndex++]);
+  return SDISel.CheckCachedPatternPredicate(MatcherTable[MatcherIndex++]);
 }
 
 /// CheckNodePredicate - Implements OP_CheckNodePredicate.
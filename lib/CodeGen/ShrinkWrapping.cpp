@@ -40,6 +40,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SparseBitVector.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
 #include "llvm/CodeGen/MachineDominators.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineInstr.h"
@@ -68,6 +69,10 @@ ShrinkWrapFunc("shrink-wrap-func", cl::Hidden,
                cl::value_desc("funcname"),
                cl::init(""));
 
+// Defined in PrologEpilogInserter.cpp; frequency-aware frame packing needs
+// MachineBlockFrequencyInfo.
+extern cl::opt<bool> PEIPackFrameObjects;
+
 // Debugging level for shrink wrapping.
 enum ShrinkWrapDebugLevel {
   None, BasicInfo, Iterations, Details
@@ -90,6 +95,8 @@ void PEI::getAnalysisUsage(AnalysisUsage &AU) const {
     AU.addRequired<MachineLoopInfo>();
     AU.addRequired<MachineDominatorTree>();
   }
+  if (PEIPackFrameObjects)
+    AU.addRequired<MachineBlockFrequencyInfo>();
   AU.addPreserved<MachineLoopInfo>();
   AU.addPreserved<MachineDominatorTree>();
   AU.addRequired<TargetPassConfig>();
@@ -33,6 +33,7 @@
 #include "llvm/Analysis/Dominators.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/CodeGen/LiveInterval.h"
+#include "llvm/CodeGen/LiveIntervalUnion.h"
 #include "llvm/CodeGen/MachineBasicBlock.h"
 #include "llvm/CodeGen/MachineBranchProbabilityInfo.h"
 #include "llvm/CodeGen/MachineDominators.h"
@@ -711,56 +712,68 @@ bool StackColoring::runOnMachineFunction(MachineFunction &Func) {
   }
 
   // This is a simple greedy algorithm for merging allocas. First, sort the
-  // slots, placing the largest slots first. Next, perform an n^2 scan and look
-  // for disjoint slots. When you find disjoint slots, merge the samller one
-  // into the bigger one and update the live interval. Remove the small alloca
-  // and continue.
+  // slots, placing the largest slots first. Then walk the slots in that
+  // order and assign each one to the first merge class (headed by an earlier,
+  // larger slot) whose accumulated live ranges it does not overlap; a slot
+  // that overlaps every existing class starts a class of its own.  Each
+  // class keeps its merged ranges in a LiveIntervalUnion, so the overlap
+  // test is a range query over an interval tree instead of a segment-list
+  // walk, and each (slot, class) pair is examined at most once.  This makes
+  // the same merging decisions as the old quadratic fixpoint scan: classes
+  // only ever grow, so a slot that conflicted with every class when it was
+  // visited can never become mergeable later.
 
   // Sort the slots according to their size. Place unused slots at the end.
   // Use stable sort to guarantee deterministic code generation.
   std::stable_sort(SortedSlots.begin(), SortedSlots.end(),
                    SlotSizeSorter(MFI));
 
-  bool Chanded = true;
-  while (Chanded) {
-    Chanded = false;
-    for (unsigned I = 0; I < NumSlots; ++I) {
-      if (SortedSlots[I] == -1)
+  LiveIntervalUnion::Allocator UnionAllocator;
+  LiveIntervalUnion::Array Classes;
+  Classes.init(UnionAllocator, NumSlots);
+  SmallVector<int, 8> ClassSlot; // Representative slot of each merge class.
+
+  for (unsigned I = 0; I < NumSlots; ++I) {
+    if (SortedSlots[I] == -1)
+      continue;
+
+    int SecondSlot = SortedSlots[I];
+    LiveInterval *Second = Intervals[SecondSlot];
+    assert(!Second->empty() && "Found an empty range");
+
+    bool Merged = false;
+    for (unsigned C = 0, CE = ClassSlot.size(); C != CE; ++C) {
+      LiveIntervalUnion::Query Q(Second, &Classes[C]);
+      if (Q.checkInterference())
         continue;
 
-      for (unsigned J=I+1; J < NumSlots; ++J) {
-        if (SortedSlots[J] == -1)
-          continue;
+      // Merge the slot into this class.
+      int FirstSlot = ClassSlot[C];
+      Classes[C].unify(*Second);
+      SlotRemap[SecondSlot] = FirstSlot;
+      SortedSlots[I] = -1;
+      DEBUG(dbgs()<<"Merging #"<<FirstSlot<<" and slots #"<<
+            SecondSlot<<" together.\n");
+      unsigned MaxAlignment = std::max(MFI->getObjectAlignment(FirstSlot),
+                                       MFI->getObjectAlignment(SecondSlot));
+
+      assert(MFI->getObjectSize(FirstSlot) >=
+             MFI->getObjectSize(SecondSlot) &&
+             "Merging a small object into a larger one");
+
+      RemovedSlots+=1;
+      ReducedSize += MFI->getObjectSize(SecondSlot);
+      MFI->setObjectAlignment(FirstSlot, MaxAlignment);
+      MFI->RemoveStackObject(SecondSlot);
+      Merged = true;
+      break;
+    }
 
-        int FirstSlot = SortedSlots[I];
-        int SecondSlot = SortedSlots[J];
-        LiveInterval *First = Intervals[FirstSlot];
-        LiveInterval *Second = Intervals[SecondSlot];
-        assert (!First->empty() && !Second->empty() && "Found an empty range");
-
-        // Merge disjoint slots.
-        if (!First->overlaps(*Second)) {
-          Chanded = true;
-          First->MergeRangesInAsValue(*Second, First->getValNumInfo(0));
-          SlotRemap[SecondSlot] = FirstSlot;
-          SortedSlots[J] = -1;
-          DEBUG(dbgs()<<"Merging #"<<FirstSlot<<" and slots #"<<
-                SecondSlot<<" together.\n");
-          unsigned MaxAlignment = std::max(MFI->getObjectAlignment(FirstSlot),
-                                           MFI->getObjectAlignment(SecondSlot));
-
-          assert(MFI->getObjectSize(FirstSlot) >=
-                 MFI->getObjectSize(SecondSlot) &&
-                 "Merging a small object into a larger one");
-
-          RemovedSlots+=1;
-          ReducedSize += MFI->getObjectSize(SecondSlot);
-          MFI->setObjectAlignment(FirstSlot, MaxAlignment);
-          MFI->RemoveStackObject(SecondSlot);
-        }
-      }
+    if (!Merged) {
+      Classes[ClassSlot.size()].unify(*Second);
+      ClassSlot.push_back(SecondSlot);
     }
-  }// While changed.
+  }
 
   // Record statistics.
   StackSpaceSaved += ReducedSize;
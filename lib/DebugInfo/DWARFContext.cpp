@@ -9,16 +9,46 @@
 
 #include "DWARFContext.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
 #include <algorithm>
 using namespace llvm;
 using namespace dwarf;
 
 typedef DWARFDebugLine::LineTable DWARFLineTable;
 
+// Compile units are disjoint byte ranges of .debug_info and DIE extraction
+// only writes per-unit state, so once the compile unit headers and the
+// (shared, read-only) abbreviation table have been parsed, units can be
+// extracted on several threads.  This pre-extracts everything, so the dump
+// holds all DIE arrays in memory at once instead of clearing them unit by
+// unit; hence it is opt-in.
+static cl::opt<unsigned>
+ParallelDIEThreads("dwarf-parallel-extract-threads", cl::Hidden, cl::init(1),
+                   cl::desc("Number of threads to use for DIE extraction "
+                            "when dumping .debug_info"));
+
+namespace {
+  struct DIEExtractJob {
+    DWARFContext *Ctx;
+    unsigned Index;
+    unsigned Stride;
+  };
+}
+
+static void ExtractDIEsWorker(void *Arg) {
+  DIEExtractJob *Job = static_cast<DIEExtractJob*>(Arg);
+  for (unsigned i = Job->Index, e = Job->Ctx->getNumCompileUnits(); i < e;
+       i += Job->Stride)
+    Job->Ctx->getCompileUnitAtIndex(i)->extractDIEsIfNeeded(false);
+}
+
 void DWARFContext::dump(raw_ostream &OS, DIDumpType DumpType) {
   if (DumpType == DIDT_All || DumpType == DIDT_Abbrev) {
     OS << ".debug_abbrev contents:\n";
@@ -27,6 +57,20 @@ void DWARFContext::dump(raw_ostream &OS, DIDumpType DumpType) {
 
   if (DumpType == DIDT_All || DumpType == DIDT_Info) {
     OS << "\n.debug_info contents:\n";
+    if (ParallelDIEThreads > 1 && getNumCompileUnits() > 1) {
+      unsigned NumThreads = std::min(unsigned(ParallelDIEThreads),
+                                     getNumCompileUnits());
+      SmallVector<DIEExtractJob, 8> Jobs(NumThreads);
+      SmallVector<void *, 8> Handles(NumThreads);
+      for (unsigned t = 0; t != NumThreads; ++t) {
+        Jobs[t].Ctx = this;
+        Jobs[t].Index = t;
+        Jobs[t].Stride = NumThreads;
+        Handles[t] = llvm_launch_thread(ExtractDIEsWorker, &Jobs[t]);
+      }
+      for (unsigned t = 0; t != NumThreads; ++t)
+        llvm_join_thread(Handles[t]);
+    }
     for (unsigned i = 0, e = getNumCompileUnits(); i != e; ++i)
       getCompileUnitAtIndex(i)->dump(OS);
   }
@@ -146,14 +190,38 @@ const DWARFDebugAranges *DWARFContext::getDebugAranges() {
   if (Aranges)
     return Aranges.get();
 
+  Aranges.reset(new DWARFDebugAranges());
+
+  // Try the on-disk cache first.  Building the table below parses the DIEs
+  // of every compile unit whenever .debug_aranges is incomplete, which is
+  // the expensive part of symbolizing against a fresh context.
+  if (!ArangesCachePath.empty()) {
+    OwningPtr<MemoryBuffer> Buffer;
+    if (!MemoryBuffer::getFile(ArangesCachePath, Buffer) &&
+        Aranges->readCache(Buffer->getBuffer(), getInfoSection().size(),
+                           getARangeSection().size()))
+      return Aranges.get();
+    Aranges->clear();
+  }
+
   DataExtractor arangesData(getARangeSection(), isLittleEndian(), 0);
 
-  Aranges.reset(new DWARFDebugAranges());
   Aranges->extract(arangesData);
   // Generate aranges from DIEs: even if .debug_aranges section is present,
   // it may describe only a small subset of compilation units, so we need to
   // manually build aranges for the rest of them.
   Aranges->generate(this);
+
+  if (!ArangesCachePath.empty()) {
+    // Failing to write the cache is not an error; the next run simply
+    // rebuilds the table again.
+    std::string ErrorInfo;
+    raw_fd_ostream OS(ArangesCachePath.c_str(), ErrorInfo,
+                      raw_fd_ostream::F_Binary);
+    if (ErrorInfo.empty())
+      Aranges->writeCache(OS, getInfoSection().size(),
+                          getARangeSection().size());
+  }
   return Aranges.get();
 }
 
@@ -35,6 +35,10 @@ class DWARFContext : public DIContext {
   SmallVector<DWARFCompileUnit, 1> DWOCUs;
   OwningPtr<DWARFDebugAbbrev> AbbrevDWO;
 
+  /// File used to cache the address range table between runs, empty if
+  /// caching is disabled.
+  std::string ArangesCachePath;
+
   DWARFContext(DWARFContext &) LLVM_DELETED_FUNCTION;
   DWARFContext &operator=(DWARFContext &) LLVM_DELETED_FUNCTION;
 
@@ -49,6 +53,10 @@ public:
   DWARFContext() {}
   virtual void dump(raw_ostream &OS, DIDumpType DumpType = DIDT_All);
 
+  virtual void setArangesCachePath(StringRef Path) {
+    ArangesCachePath = Path.str();
+  }
+
   /// Get the number of compile units in this context.
   unsigned getNumCompileUnits() {
     if (CUs.empty())
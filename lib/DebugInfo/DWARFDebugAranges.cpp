@@ -14,6 +14,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 using namespace llvm;
 
 // Compare function DWARFDebugAranges::Range structures
@@ -103,6 +104,75 @@ bool DWARFDebugAranges::generate(DWARFContext *ctx) {
   return !isEmpty();
 }
 
+namespace {
+  // On-disk layout of the cache written by writeCache.  Everything is in
+  // host byte order; the cache is only meant to be read back on the machine
+  // that wrote it.
+  struct ArangesCacheHeader {
+    char     Magic[4];     // "DWAI"
+    uint32_t Version;
+    uint64_t InfoSize;     // Size of .debug_info the table was built from.
+    uint64_t ArangesSize;  // Size of .debug_aranges likewise.
+    uint32_t NumRanges;
+    uint32_t NumParsedCUs;
+  };
+}
+
+static const char ArangesCacheMagic[4] = { 'D', 'W', 'A', 'I' };
+static const uint32_t ArangesCacheVersion = 1;
+
+void DWARFDebugAranges::writeCache(raw_ostream &OS, uint64_t InfoSize,
+                                   uint64_t ArangesSize) const {
+  ArangesCacheHeader Header;
+  memcpy(Header.Magic, ArangesCacheMagic, sizeof(Header.Magic));
+  Header.Version = ArangesCacheVersion;
+  Header.InfoSize = InfoSize;
+  Header.ArangesSize = ArangesSize;
+  Header.NumRanges = Aranges.size();
+  Header.NumParsedCUs = ParsedCUOffsets.size();
+  OS.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+  if (!Aranges.empty())
+    OS.write(reinterpret_cast<const char*>(&Aranges[0]),
+             Aranges.size() * sizeof(Range));
+  for (ParsedCUOffsetColl::const_iterator I = ParsedCUOffsets.begin(),
+         E = ParsedCUOffsets.end(); I != E; ++I) {
+    uint32_t Offset = *I;
+    OS.write(reinterpret_cast<const char*>(&Offset), sizeof(Offset));
+  }
+}
+
+bool DWARFDebugAranges::readCache(StringRef Data, uint64_t InfoSize,
+                                  uint64_t ArangesSize) {
+  if (Data.size() < sizeof(ArangesCacheHeader))
+    return false;
+  ArangesCacheHeader Header;
+  memcpy(&Header, Data.data(), sizeof(Header));
+  if (memcmp(Header.Magic, ArangesCacheMagic, sizeof(Header.Magic)) != 0 ||
+      Header.Version != ArangesCacheVersion ||
+      Header.InfoSize != InfoSize || Header.ArangesSize != ArangesSize)
+    return false;
+  uint64_t ExpectedSize = sizeof(Header) +
+                          uint64_t(Header.NumRanges) * sizeof(Range) +
+                          uint64_t(Header.NumParsedCUs) * sizeof(uint32_t);
+  if (Data.size() != ExpectedSize)
+    return false;
+
+  clear();
+  const char *P = Data.data() + sizeof(Header);
+  if (Header.NumRanges) {
+    Aranges.resize(Header.NumRanges);
+    memcpy(&Aranges[0], P, Header.NumRanges * sizeof(Range));
+    P += Header.NumRanges * sizeof(Range);
+  }
+  for (uint32_t i = 0; i != Header.NumParsedCUs; ++i) {
+    uint32_t Offset;
+    memcpy(&Offset, P, sizeof(Offset));
+    P += sizeof(Offset);
+    ParsedCUOffsets.insert(Offset);
+  }
+  return true;
+}
+
 void DWARFDebugAranges::dump(raw_ostream &OS) const {
   const uint32_t num_ranges = getNumRanges();
   for (uint32_t i = 0; i < num_ranges; ++i) {
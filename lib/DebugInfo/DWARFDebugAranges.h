@@ -12,6 +12,7 @@
 
 #include "DWARFDebugArangeSet.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringRef.h"
 #include <list>
 
 namespace llvm {
@@ -74,6 +75,16 @@ public:
   void appendRange(uint32_t cu_offset, uint64_t low_pc, uint64_t high_pc);
   void sort(bool minimize, uint32_t n);
 
+  /// writeCache - Serialize the finalized table to OS.  InfoSize and
+  /// ArangesSize identify the debug info the table was built from and are
+  /// checked by readCache.
+  void writeCache(raw_ostream &OS, uint64_t InfoSize,
+                  uint64_t ArangesSize) const;
+
+  /// readCache - Load a table previously written by writeCache.  Returns
+  /// false if Data is malformed or was built from different debug info.
+  bool readCache(StringRef Data, uint64_t InfoSize, uint64_t ArangesSize);
+
   const Range *rangeAtIndex(uint32_t idx) const {
     if (idx < Aranges.size())
       return &Aranges[idx];
@@ -84,6 +84,11 @@ void DWARFDebugLine::LineTable::dump(raw_ostream &OS) const {
   Prologue.dump(OS);
   OS << '\n';
 
+  // Dumping reads every row, so bring in any sequences that have not been
+  // materialized yet.
+  for (SequenceVector::size_type i = 0, e = Sequences.size(); i != e; ++i)
+    materializeSequence(Sequences[i]);
+
   if (!Rows.empty()) {
     OS << "Address            Line   Column File   ISA Flags\n"
        << "------------------ ------ ------ ------ --- -------------\n";
@@ -101,21 +106,29 @@ void DWARFDebugLine::State::appendRowToMatrix(uint32_t offset) {
     Sequence::Empty = false;
     Sequence::LowPC = Address;
     Sequence::FirstRowIndex = row;
+    Sequence::StmtOffset = NextStmtOffset;
   }
   ++row;  // Increase the row number.
-  LineTable::appendRow(*this);
+  if (!SkipRows)
+    LineTable::appendRow(*this);
   if (EndSequence) {
-    // Record the end of instruction sequence.
+    // Record the end of instruction sequence. The current offset is the
+    // first byte after the DW_LNE_end_sequence opcode, which is where the
+    // next sequence starts.
     Sequence::HighPC = Address;
     Sequence::LastRowIndex = row;
+    Sequence::StmtOffsetEnd = offset;
+    Sequence::Materialized = !SkipRows;
     if (Sequence::isValid())
       LineTable::appendSequence(*this);
     Sequence::reset();
+    NextStmtOffset = offset;
   }
   Row::postAppend();
 }
 
 void DWARFDebugLine::State::finalize() {
+  NumRows = row;
   row = DoneParsingLineTable;
   if (!Sequence::Empty) {
     fprintf(stderr, "warning: last sequence in debug line table is not"
@@ -153,8 +166,12 @@ DWARFDebugLine::getOrParseLineTable(DataExtractor debug_line_data,
   std::pair<LineTableIter, bool> pos =
     LineTableMap.insert(LineTableMapTy::value_type(offset, LineTable()));
   if (pos.second) {
-    // Parse and cache the line table for at this offset.
+    // Parse and cache the line table for at this offset. Only count rows
+    // and record sequence boundaries here; the rows of a sequence are
+    // decoded the first time a lookup touches it, so sequences that are
+    // never queried are never replayed in full.
     State state;
+    state.SkipRows = true;
     if (!parseStatementTable(debug_line_data, RelocMap, &offset, state))
       return 0;
     pos.first->second = state;
@@ -236,6 +253,24 @@ DWARFDebugLine::parseStatementTable(DataExtractor debug_line_data,
                               sizeof(prologue->TotalLength);
 
   state.reset();
+  // Remember where the statement program bytes came from so that sequences
+  // can be replayed when they are materialized.
+  state.LineData = debug_line_data;
+  state.RelocMap = RMap;
+  state.NextStmtOffset = *offset_ptr;
+
+  parseRows(debug_line_data, RMap, offset_ptr, end_offset, state);
+
+  state.finalize();
+
+  return end_offset;
+}
+
+void
+DWARFDebugLine::parseRows(DataExtractor debug_line_data,
+                          const RelocAddrMap *RMap, uint32_t *offset_ptr,
+                          uint32_t end_offset, State &state) {
+  Prologue *prologue = &state.Prologue;
 
   while (*offset_ptr < end_offset) {
     uint8_t opcode = debug_line_data.getU8(offset_ptr);
@@ -472,10 +507,27 @@ DWARFDebugLine::parseStatementTable(DataExtractor debug_line_data,
       state.appendRowToMatrix(*offset_ptr);
     }
   }
+}
 
-  state.finalize();
-
-  return end_offset;
+void DWARFDebugLine::LineTable::materializeSequence(Sequence &Seq) const {
+  if (Seq.Materialized)
+    return;
+  Seq.Materialized = true;
+  if (Rows.size() < NumRows)
+    Rows.resize(NumRows);
+  // Replay just this sequence's slice of the statement program. Fresh
+  // state machine registers are correct here because every sequence starts
+  // right after a DW_LNE_end_sequence (or the prologue), both of which
+  // reset the registers.
+  State state;
+  state.Prologue = Prologue;
+  state.reset();
+  uint32_t offset = Seq.StmtOffset;
+  parseRows(LineData, RelocMap, &offset, Seq.StmtOffsetEnd, state);
+  assert(state.Rows.size() == Seq.LastRowIndex - Seq.FirstRowIndex &&
+         "sequence replay produced a different number of rows");
+  std::copy(state.Rows.begin(), state.Rows.end(),
+            Rows.begin() + Seq.FirstRowIndex);
 }
 
 uint32_t
@@ -490,18 +542,20 @@ DWARFDebugLine::LineTable::lookupAddress(uint64_t address) const {
   SequenceIter last_seq = Sequences.end();
   SequenceIter seq_pos = std::lower_bound(first_seq, last_seq, sequence,
       DWARFDebugLine::Sequence::orderByLowPC);
-  DWARFDebugLine::Sequence found_seq;
+  SequenceVector::size_type found_idx;
   if (seq_pos == last_seq) {
-    found_seq = Sequences.back();
+    found_idx = Sequences.size() - 1;
   } else if (seq_pos->LowPC == address) {
-    found_seq = *seq_pos;
+    found_idx = seq_pos - first_seq;
   } else {
     if (seq_pos == first_seq)
       return unknown_index;
-    found_seq = *(seq_pos - 1);
+    found_idx = (seq_pos - first_seq) - 1;
   }
+  Sequence &found_seq = Sequences[found_idx];
   if (!found_seq.containsPC(address))
     return unknown_index;
+  materializeSequence(found_seq);
   // Search for instruction address in the rows describing the sequence.
   // Rows are stored in a vector, so we may use arithmetical operations with
   // iterators.
@@ -552,6 +606,7 @@ DWARFDebugLine::LineTable::lookupAddressRange(uint64_t address,
   // index we just calculated
 
   while (seq_pos != last_seq && seq_pos->LowPC < end_addr) {
+    materializeSequence(Sequences[seq_pos - first_seq]);
     DWARFDebugLine::Sequence cur_seq = *seq_pos;
     uint32_t first_row_index;
     uint32_t last_row_index;
@@ -142,7 +142,17 @@ public:
     uint64_t HighPC;
     unsigned FirstRowIndex;
     unsigned LastRowIndex;
+    // Byte range [StmtOffset, StmtOffsetEnd) of the statement program
+    // opcodes that produce this sequence. The DWARF state machine resets
+    // all registers after DW_LNE_end_sequence, so this range can be
+    // replayed with fresh registers independently of the rest of the
+    // program, which is how rows are materialized on demand.
+    uint32_t StmtOffset;
+    uint32_t StmtOffsetEnd;
     bool Empty;
+    // True once rows [FirstRowIndex, LastRowIndex) are present in the
+    // owning line table's row matrix.
+    bool Materialized;
 
     Sequence() { reset(); }
     void reset() {
@@ -150,7 +160,10 @@ public:
       HighPC = 0;
       FirstRowIndex = 0;
       LastRowIndex = 0;
+      StmtOffset = 0;
+      StmtOffsetEnd = 0;
       Empty = true;
+      Materialized = false;
     }
     static bool orderByLowPC(const Sequence& LHS, const Sequence& RHS) {
       return LHS.LowPC < RHS.LowPC;
@@ -164,6 +177,8 @@ public:
   };
 
   struct LineTable {
+    LineTable() : NumRows(0), LineData(StringRef(), true, 0), RelocMap(0) {}
+
     void appendRow(const DWARFDebugLine::Row &state) { Rows.push_back(state); }
     void appendSequence(const DWARFDebugLine::Sequence &sequence) {
       Sequences.push_back(sequence);
@@ -172,6 +187,7 @@ public:
       Prologue.clear();
       Rows.clear();
       Sequences.clear();
+      NumRows = 0;
     }
 
     // Returns the index of the row with file/line info for a given address,
@@ -190,13 +206,30 @@ public:
 
     void dump(raw_ostream &OS) const;
 
+    // Replays the statement program range of Seq and fills in its rows in
+    // the matrix, if they are not present yet. Tables built by
+    // getOrParseLineTable only record row counts and sequence boundaries up
+    // front; the rows themselves are decoded here the first time a lookup
+    // touches the sequence.
+    void materializeSequence(Sequence &Seq) const;
+
     struct Prologue Prologue;
     typedef std::vector<Row> RowVector;
     typedef RowVector::const_iterator RowIter;
     typedef std::vector<Sequence> SequenceVector;
     typedef SequenceVector::const_iterator SequenceIter;
-    RowVector Rows;
-    SequenceVector Sequences;
+    // Rows and Sequences are mutable so that sequences can be materialized
+    // on demand from the const lookup methods.
+    mutable RowVector Rows;
+    mutable SequenceVector Sequences;
+    // Total number of rows in the matrix, including rows of sequences that
+    // have not been materialized yet.
+    unsigned NumRows;
+    // Where the statement program came from, kept so that sequences can be
+    // replayed on demand. The extractor references the .debug_line section
+    // contents, which must outlive this table.
+    DataExtractor LineData;
+    const RelocAddrMap *RelocMap;
   };
 
   struct State : public Row, public Sequence, public LineTable {
@@ -206,7 +239,7 @@ public:
       DoneParsingLineTable = -1
     };
 
-    State() : row(StartParsingLineTable) {}
+    State() : row(StartParsingLineTable), SkipRows(false), NextStmtOffset(0) {}
     virtual ~State();
 
     virtual void appendRowToMatrix(uint32_t offset);
@@ -219,6 +252,14 @@ public:
     // The row number that starts at zero for the prologue, and increases for
     // each row added to the matrix.
     unsigned row;
+    // When true, rows are counted and sequences recorded but the rows
+    // themselves are not stored; they are materialized per sequence on
+    // demand by LineTable::materializeSequence.
+    bool SkipRows;
+    // Statement program offset where the next sequence starts, i.e. the
+    // first byte after the previous DW_LNE_end_sequence (or after the
+    // prologue for the first sequence).
+    uint32_t NextStmtOffset;
   };
 
   struct DumpingState : public State {
@@ -235,6 +276,13 @@ public:
   static bool parseStatementTable(DataExtractor debug_line_data,
                                   const RelocAddrMap *RMap,
                                   uint32_t *offset_ptr, State &state);
+  /// Interpret statement program opcodes in [*offset_ptr, end_offset),
+  /// feeding rows into \p state. The prologue of \p state must already be
+  /// filled in. Used both for whole-table parsing and for replaying a
+  /// single sequence when it is materialized.
+  static void parseRows(DataExtractor debug_line_data,
+                        const RelocAddrMap *RMap, uint32_t *offset_ptr,
+                        uint32_t end_offset, State &state);
 
   const LineTable *getLineTable(uint32_t offset) const;
   const LineTable *getOrParseLineTable(DataExtractor debug_line_data,
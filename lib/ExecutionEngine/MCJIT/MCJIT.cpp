@@ -13,18 +13,31 @@
 #include "llvm/ExecutionEngine/JITMemoryManager.h"
 #include "llvm/ExecutionEngine/MCJIT.h"
 #include "llvm/ExecutionEngine/ObjectBuffer.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
 #include "llvm/ExecutionEngine/ObjectImage.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Function.h"
 #include "llvm/MC/MCAsmInfo.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/DynamicLibrary.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/Threading.h"
 
 using namespace llvm;
 
+// Compiling the module synchronously on the first getPointerToFunction call
+// stalls the caller for the full codegen time. With this option the engine
+// starts compiling on a background thread as soon as it is constructed, and
+// the first call that needs generated code waits for the result instead.
+// The client must not touch the module while compilation is in flight.
+static cl::opt<bool>
+AsyncCompile("mcjit-async-compile", cl::Hidden, cl::init(false),
+             cl::desc("Compile MCJIT modules on a background thread starting "
+                      "at engine construction"));
+
 namespace {
 
 static struct RegisterJIT {
@@ -52,18 +65,47 @@ ExecutionEngine *MCJIT::createJIT(Module *M,
 MCJIT::MCJIT(Module *m, TargetMachine *tm, RTDyldMemoryManager *MM,
              bool AllocateGVsWithCode)
   : ExecutionEngine(m), TM(tm), Ctx(0), MemMgr(MM), Dyld(MM),
-    isCompiled(false), M(m)  {
+    isCompiled(false), M(m), CompileThread(0), ObjCache(0)  {
 
   setDataLayout(TM->getDataLayout());
+
+  if (AsyncCompile)
+    startAsyncCompilation();
 }
 
 MCJIT::~MCJIT() {
+  awaitCompilation();
   if (LoadedObject)
     NotifyFreeingObject(*LoadedObject.get());
   delete MemMgr;
   delete TM;
 }
 
+void MCJIT::setObjectCache(ObjectCache* NewCache) {
+  ObjCache = NewCache;
+}
+
+void MCJIT::CompileThreadMain(void *Arg) {
+  MCJIT *JIT = static_cast<MCJIT*>(Arg);
+  JIT->emitObject(JIT->M);
+}
+
+void MCJIT::startAsyncCompilation() {
+  // If threads are unavailable this runs CompileThreadMain inline and
+  // returns a null handle, degrading to the synchronous behavior.
+  CompileThread = llvm_launch_thread(CompileThreadMain, this);
+}
+
+void MCJIT::awaitCompilation() {
+  // Claim the handle first so that re-entry (e.g. getPointerToFunction
+  // resolving a declaration through getPointerToNamedFunction) does not
+  // join the thread twice.
+  void *Thread = CompileThread;
+  CompileThread = 0;
+  if (Thread)
+    llvm_join_thread(Thread);
+}
+
 void MCJIT::emitObject(Module *m) {
   /// Currently, MCJIT only supports a single module and the module passed to
   /// this function call is expected to be the contained module.  The module
@@ -80,23 +122,37 @@ void MCJIT::emitObject(Module *m) {
   if (isCompiled)
     return;
 
-  PassManager PM;
+  // The RuntimeDyld will take ownership of this shortly
+  OwningPtr<ObjectBuffer> Buffer;
 
-  PM.add(new DataLayout(*TM->getDataLayout()));
+  // First, check to see if we already have a cached object for this module.
+  if (ObjCache != 0)
+    Buffer.reset(ObjCache->getObject(m));
 
-  // The RuntimeDyld will take ownership of this shortly
-  OwningPtr<ObjectBufferStream> Buffer(new ObjectBufferStream());
+  if (!Buffer) {
+    // There is no cached object; compile the module.
+    PassManager PM;
 
-  // Turn the machine code intermediate representation into bytes in memory
-  // that may be executed.
-  if (TM->addPassesToEmitMC(PM, Ctx, Buffer->getOStream(), false)) {
-    report_fatal_error("Target does not support MC emission!");
-  }
+    PM.add(new DataLayout(*TM->getDataLayout()));
 
-  // Initialize passes.
-  PM.run(*m);
-  // Flush the output buffer to get the generated code into memory
-  Buffer->flush();
+    OwningPtr<ObjectBufferStream> CompiledObject(new ObjectBufferStream());
+
+    // Turn the machine code intermediate representation into bytes in memory
+    // that may be executed.
+    if (TM->addPassesToEmitMC(PM, Ctx, CompiledObject->getOStream(), false)) {
+      report_fatal_error("Target does not support MC emission!");
+    }
+
+    // Initialize passes.
+    PM.run(*m);
+    // Flush the output buffer to get the generated code into memory
+    CompiledObject->flush();
+    Buffer.reset(CompiledObject.take());
+
+    // If we have an object cache, tell it about the new object.
+    if (ObjCache != 0)
+      ObjCache->notifyObjectCompiled(m, Buffer.get());
+  }
 
   // Load the object into the dynamic linker.
   // handing off ownership of the buffer
@@ -121,6 +177,8 @@ void MCJIT::emitObject(Module *m) {
 // FIXME: Provide a way to separate code emission, relocations and page 
 // protection in the interface.
 void MCJIT::finalizeObject() {
+  awaitCompilation();
+
   // If the module hasn't been compiled, just do that.
   if (!isCompiled) {
     // If the call to Dyld.resolveRelocations() is removed from emitObject()
@@ -151,6 +209,7 @@ void *MCJIT::getPointerToFunction(Function *F) {
   // dies.
 
   // FIXME: Add support for per-module compilation state
+  awaitCompilation();
   if (!isCompiled)
     emitObject(M);
 
@@ -284,6 +343,7 @@ GenericValue MCJIT::runFunction(Function *F,
 void *MCJIT::getPointerToNamedFunction(const std::string &Name,
                                        bool AbortOnFailure) {
   // FIXME: Add support for per-module compilation state
+  awaitCompilation();
   if (!isCompiled)
     emitObject(M);
 
@@ -38,12 +38,23 @@ class MCJIT : public ExecutionEngine {
   Module *M;
   OwningPtr<ObjectImage> LoadedObject;
 
+  // Handle of the background compilation thread while asynchronous
+  // compilation is in flight, null otherwise. See startAsyncCompilation().
+  void *CompileThread;
+
+  // An optional ObjectCache to be notified of compiled objects and asked for
+  // objects from previous runs.  Not owned by MCJIT.
+  ObjectCache *ObjCache;
+
 public:
   ~MCJIT();
 
   /// @name ExecutionEngine interface implementation
   /// @{
 
+  /// Sets the object manager that MCJIT should use to avoid compilation.
+  virtual void setObjectCache(ObjectCache *manager);
+
   virtual void finalizeObject();
 
   virtual void *getPointerToBasicBlock(BasicBlock *BB);
@@ -104,6 +115,20 @@ protected:
   /// the future.
   void emitObject(Module *M);
 
+  /// startAsyncCompilation - Kick off emitObject on a background thread so
+  /// that the caller can keep doing useful work while the module is being
+  /// compiled. The caller must not touch the module (or its context) until
+  /// the next call that needs generated code, which joins the thread. If
+  /// threads are unavailable this compiles synchronously.
+  void startAsyncCompilation();
+
+  /// awaitCompilation - Wait for an in-flight background compilation, if
+  /// any. Must be called before querying generated code and before tearing
+  /// the engine down.
+  void awaitCompilation();
+
+  static void CompileThreadMain(void *Arg);
+
   void NotifyObjectEmitted(const ObjectImage& Obj);
   void NotifyFreeingObject(const ObjectImage& Obj);
 };
@@ -71,17 +71,17 @@ uint8_t *SectionMemoryManager::allocateSection(MemoryGroup &MemGroup,
     }
   }
 
-  // No pre-allocated free block was large enough. Allocate a new memory region.
-  // Note that all sections get allocated as read-write.  The permissions will
-  // be updated later based on memory group.
-  //
-  // FIXME: It would be useful to define a default allocation size (or add
-  // it as a constructor parameter) to minimize the number of allocations.
+  // No pre-allocated free block was large enough. Allocate a new memory
+  // region. Map at least a whole slab so subsequent sections are carved out
+  // of the slack instead of costing a mapping each; the leftover is recorded
+  // as a free block below. Note that all sections get allocated as
+  // read-write. The permissions will be updated later based on memory group.
   //
   // FIXME: Initialize the Near member for each memory group to avoid
   // interleaving.
+  uintptr_t MapSize = RequiredSize < SlabSize ? SlabSize : RequiredSize;
   error_code ec;
-  sys::MemoryBlock MB = sys::Memory::allocateMappedMemory(RequiredSize,
+  sys::MemoryBlock MB = sys::Memory::allocateMappedMemory(MapSize,
                                                           &MemGroup.Near,
                                                           sys::Memory::MF_READ |
                                                             sys::Memory::MF_WRITE,
@@ -144,9 +144,21 @@ bool SectionMemoryManager::applyPermissions(std::string *ErrMsg)
 error_code SectionMemoryManager::applyMemoryGroupPermissions(MemoryGroup &MemGroup,
                                                              unsigned Permissions) {
 
-  for (int i = 0, e = MemGroup.AllocatedMem.size(); i != e; ++i) {
+  // Flip adjacent mappings with a single permission change. The Near hint
+  // makes consecutive slabs frequently contiguous, so a group typically
+  // batches down to one kernel VM operation.
+  for (int i = 0, e = MemGroup.AllocatedMem.size(); i != e;) {
+      uintptr_t Start = (uintptr_t)MemGroup.AllocatedMem[i].base();
+      uintptr_t End = Start + MemGroup.AllocatedMem[i].size();
+      for (++i; i != e; ++i) {
+        sys::MemoryBlock &Next = MemGroup.AllocatedMem[i];
+        if ((uintptr_t)Next.base() != End)
+          break;
+        End += Next.size();
+      }
       error_code ec;
-      ec = sys::Memory::protectMappedMemory(MemGroup.AllocatedMem[i],
+      ec = sys::Memory::protectMappedMemory(sys::MemoryBlock((void*)Start,
+                                                             End - Start),
                                             Permissions);
       if (ec) {
         return ec;
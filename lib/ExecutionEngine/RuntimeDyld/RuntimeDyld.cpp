@@ -25,6 +25,16 @@ using namespace llvm::object;
 
 // Empty out-of-line virtual destructor as the key function.
 RTDyldMemoryManager::~RTDyldMemoryManager() {}
+
+void RTDyldMemoryManager::getPointersToNamedFunctions(
+    const SmallVectorImpl<std::string> &Names,
+    SmallVectorImpl<void *> &Addrs,
+    bool AbortOnFailure) {
+  Addrs.clear();
+  Addrs.reserve(Names.size());
+  for (unsigned i = 0, e = Names.size(); i != e; ++i)
+    Addrs.push_back(getPointerToNamedFunction(Names[i], AbortOnFailure));
+}
 RuntimeDyldImpl::~RuntimeDyldImpl() {}
 
 namespace llvm {
@@ -425,24 +435,36 @@ void RuntimeDyldImpl::resolveRelocationList(const RelocationList &Relocs,
 }
 
 void RuntimeDyldImpl::resolveExternalSymbols() {
+  // Gather all unresolved external symbols first so the memory manager can
+  // look them up in a single batch rather than one expensive query (e.g.
+  // dlsym) per symbol.
+  SmallVector<std::string, 16> Names;
   StringMap<RelocationList>::iterator i = ExternalSymbolRelocations.begin(),
                                       e = ExternalSymbolRelocations.end();
   for (; i != e; i++) {
     StringRef Name = i->first();
-    RelocationList &Relocs = i->second;
-    SymbolTableMap::const_iterator Loc = GlobalSymbolTable.find(Name);
-    if (Loc == GlobalSymbolTable.end()) {
-      // This is an external symbol, try to get it address from
-      // MemoryManager.
-      uint8_t *Addr = (uint8_t*) MemMgr->getPointerToNamedFunction(Name.data(),
-                                                                   true);
-      DEBUG(dbgs() << "Resolving relocations Name: " << Name
-              << "\t" << format("%p", Addr)
-              << "\n");
-      resolveRelocationList(Relocs, (uintptr_t)Addr);
-    } else {
+    if (GlobalSymbolTable.find(Name) == GlobalSymbolTable.end())
+      Names.push_back(Name.str());
+    else
       report_fatal_error("Expected external symbol");
-    }
+  }
+
+  SmallVector<void *, 16> Addrs;
+  MemMgr->getPointersToNamedFunctions(Names, Addrs, true);
+  assert(Addrs.size() == Names.size() &&
+         "Memory manager resolved the wrong number of symbols!");
+
+  // StringMap iteration order is stable, so the addresses line up with the
+  // relocation lists when we walk the map a second time.
+  unsigned Idx = 0;
+  for (i = ExternalSymbolRelocations.begin(); i != e; i++) {
+    StringRef Name = i->first();
+    RelocationList &Relocs = i->second;
+    uint8_t *Addr = (uint8_t*)Addrs[Idx++];
+    DEBUG(dbgs() << "Resolving relocations Name: " << Name
+            << "\t" << format("%p", Addr)
+            << "\n");
+    resolveRelocationList(Relocs, (uintptr_t)Addr);
   }
 }
 
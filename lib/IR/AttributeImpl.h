@@ -99,7 +99,7 @@ public:
 /// \class
 /// \brief This class represents a single, uniqued attribute. That attribute
 /// could be a single enum, a tuple, or a string.
-class AttributeImpl : public FoldingSetNode {
+class AttributeImpl : public HashedFoldingSetNode {
   LLVMContext &Context;  ///< Global context for uniquing objects
 
   AttributeEntry *Entry; ///< Holds the kind and value of the attribute
@@ -157,7 +157,7 @@ public:
 /// \class
 /// \brief This class represents a group of attributes that apply to one
 /// element: function, return type, or parameter.
-class AttributeSetNode : public FoldingSetNode {
+class AttributeSetNode : public HashedFoldingSetNode {
   SmallVector<Attribute, 4> AttrList;
 
   AttributeSetNode(ArrayRef<Attribute> Attrs)
@@ -198,7 +198,7 @@ public:
 /// \class
 /// \brief This class represents a set of attributes that apply to the function,
 /// return type, and parameters.
-class AttributeSetImpl : public FoldingSetNode {
+class AttributeSetImpl : public HashedFoldingSetNode {
   friend class AttributeSet;
 
   LLVMContext &Context;
@@ -269,6 +269,16 @@ public:
   uint64_t Raw(uint64_t Index) const;
 };
 
+// The attribute uniquing tables are probed far more often than they are
+// extended; the cached hash lets probes reject nodes without re-profiling
+// them.
+template<> struct FoldingSetTrait<AttributeImpl>
+  : public HashedFoldingSetTrait<AttributeImpl> {};
+template<> struct FoldingSetTrait<AttributeSetNode>
+  : public HashedFoldingSetTrait<AttributeSetNode> {};
+template<> struct FoldingSetTrait<AttributeSetImpl>
+  : public HashedFoldingSetTrait<AttributeSetImpl> {};
+
 } // end llvm namespace
 
 #endif
@@ -33,6 +33,13 @@ using namespace llvm;
 Attribute Attribute::get(LLVMContext &Context, Attribute::AttrKind Kind,
                          uint64_t Val) {
   LLVMContextImpl *pImpl = Context.pImpl;
+
+  // Valueless enum attributes are resolved through a direct-mapped cache;
+  // only the first request for each kind pays for a FoldingSet probe.
+  if (!Val)
+    if (AttributeImpl *PA = pImpl->SimpleEnumAttrs[Kind])
+      return Attribute(PA);
+
   FoldingSetNodeID ID;
   ID.AddInteger(Kind);
   if (Val) ID.AddInteger(Val);
@@ -46,9 +53,13 @@ Attribute Attribute::get(LLVMContext &Context, Attribute::AttrKind Kind,
     PA = !Val ?
       new AttributeImpl(Context, Kind) :
       new AttributeImpl(Context, Kind, Val);
+    PA->setFoldingSetHash(ID.ComputeHash());
     pImpl->AttrsSet.InsertNode(PA, InsertPoint);
   }
 
+  if (!Val)
+    pImpl->SimpleEnumAttrs[Kind] = PA;
+
   // Return the Attribute that we found or created.
   return Attribute(PA);
 }
@@ -66,6 +77,7 @@ Attribute Attribute::get(LLVMContext &Context, StringRef Kind, StringRef Val) {
     // If we didn't find any existing attributes of the same shape then create a
     // new one and insert it.
     PA = new AttributeImpl(Context, Kind, Val);
+    PA->setFoldingSetHash(ID.ComputeHash());
     pImpl->AttrsSet.InsertNode(PA, InsertPoint);
   }
 
@@ -414,6 +426,7 @@ AttributeSetNode *AttributeSetNode::get(LLVMContext &C,
   // new one and insert it.
   if (!PA) {
     PA = new AttributeSetNode(SortedAttrs);
+    PA->setFoldingSetHash(ID.ComputeHash());
     pImpl->AttrsSetNodes.InsertNode(PA, InsertPoint);
   }
 
@@ -502,6 +515,7 @@ AttributeSet::getImpl(LLVMContext &C,
   // create a new one and insert it.
   if (!PA) {
     PA = new AttributeSetImpl(C, Attrs);
+    PA->setFoldingSetHash(ID.ComputeHash());
     pImpl->AttrsLists.InsertNode(PA, InsertPoint);
   }
 
@@ -557,35 +571,46 @@ AttributeSet AttributeSet::get(LLVMContext &C, unsigned Idx, AttrBuilder &B) {
   if (!B.hasAttributes())
     return AttributeSet();
 
+  // All attributes go in the same slot, so build the attribute vector in stack
+  // storage and intern the node and the list directly instead of going through
+  // the (Idx, Attribute) pair grouping in the ArrayRef overload.
+  SmallVector<Attribute, 8> Attrs;
+
   // Add target-independent attributes.
-  SmallVector<std::pair<unsigned, Attribute>, 8> Attrs;
   for (AttrBuilder::iterator I = B.begin(), E = B.end(); I != E; ++I) {
     Attribute::AttrKind Kind = *I;
     if (Kind == Attribute::Alignment)
-      Attrs.push_back(std::make_pair(Idx, Attribute::
-                                     getWithAlignment(C, B.getAlignment())));
+      Attrs.push_back(Attribute::getWithAlignment(C, B.getAlignment()));
     else if (Kind == Attribute::StackAlignment)
-      Attrs.push_back(std::make_pair(Idx, Attribute::
-                              getWithStackAlignment(C, B.getStackAlignment())));
+      Attrs.push_back(Attribute::getWithStackAlignment(C,
+                                                       B.getStackAlignment()));
     else
-      Attrs.push_back(std::make_pair(Idx, Attribute::get(C, Kind)));
+      Attrs.push_back(Attribute::get(C, Kind));
   }
 
   // Add target-dependent (string) attributes.
   for (AttrBuilder::td_iterator I = B.td_begin(), E = B.td_end();
        I != E; ++I)
-    Attrs.push_back(std::make_pair(Idx, Attribute::get(C, I->first,I->second)));
+    Attrs.push_back(Attribute::get(C, I->first, I->second));
 
-  return get(C, Attrs);
+  std::pair<unsigned, AttributeSetNode*>
+    Slot(Idx, AttributeSetNode::get(C, Attrs));
+  return getImpl(C, Slot);
 }
 
 AttributeSet AttributeSet::get(LLVMContext &C, unsigned Idx,
                                ArrayRef<Attribute::AttrKind> Kind) {
-  SmallVector<std::pair<unsigned, Attribute>, 8> Attrs;
+  if (Kind.empty())
+    return AttributeSet();
+
+  SmallVector<Attribute, 8> Attrs;
   for (ArrayRef<Attribute::AttrKind>::iterator I = Kind.begin(),
          E = Kind.end(); I != E; ++I)
-    Attrs.push_back(std::make_pair(Idx, Attribute::get(C, *I)));
-  return get(C, Attrs);
+    Attrs.push_back(Attribute::get(C, *I));
+
+  std::pair<unsigned, AttributeSetNode*>
+    Slot(Idx, AttributeSetNode::get(C, Attrs));
+  return getImpl(C, Slot);
 }
 
 AttributeSet AttributeSet::get(LLVMContext &C, ArrayRef<AttributeSet> Attrs) {
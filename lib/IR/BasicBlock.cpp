@@ -14,6 +14,7 @@
 #include "llvm/IR/BasicBlock.h"
 #include "SymbolTableListTraitsImpl.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
@@ -41,7 +42,8 @@ template class llvm::SymbolTableListTraits<Instruction, BasicBlock>;
 
 BasicBlock::BasicBlock(LLVMContext &C, const Twine &Name, Function *NewParent,
                        BasicBlock *InsertBefore)
-  : Value(Type::getLabelTy(C), Value::BasicBlockVal), Parent(0) {
+  : Value(Type::getLabelTy(C), Value::BasicBlockVal), Parent(0),
+    InstrOrderValid(false), PredCount(0) {
 
   // Make sure that we get added to a function
   LeakDetector::addGarbageObject(this);
@@ -178,14 +180,25 @@ void BasicBlock::dropAllReferences() {
     I->dropAllReferences();
 }
 
+/// adjustPredecessorCount - Called by the use-list maintenance code in Value
+/// whenever a use of a basic block is added or removed.  Uses whose user is a
+/// terminator instruction are CFG edges and are reflected in the cached
+/// predecessor count; other users (blockaddress) are not.
+void Value::adjustPredecessorCount(const Use &U, int Delta) {
+  assert(getValueID() == BasicBlockVal && "Not a basic block!");
+  if (!isa<TerminatorInst>(U.getUser()))
+    return;
+  BasicBlock *BB = static_cast<BasicBlock*>(this);
+  assert((Delta > 0 || BB->PredCount) && "Predecessor count underflow!");
+  BB->PredCount += Delta;
+}
+
 /// getSinglePredecessor - If this basic block has a single predecessor block,
 /// return the block, otherwise return a null pointer.
 BasicBlock *BasicBlock::getSinglePredecessor() {
-  pred_iterator PI = pred_begin(this), E = pred_end(this);
-  if (PI == E) return 0;         // No preds.
-  BasicBlock *ThePred = *PI;
-  ++PI;
-  return (PI == E) ? ThePred : 0 /*multiple preds*/;
+  if (PredCount != 1)
+    return 0;         // No preds, or multiple incoming edges.
+  return *pred_begin(this);
 }
 
 /// getUniquePredecessor - If this basic block has a unique predecessor block,
@@ -194,9 +207,10 @@ BasicBlock *BasicBlock::getSinglePredecessor() {
 /// multiple edges from the unique predecessor to this block (for example
 /// a switch statement with multiple cases having the same destination).
 BasicBlock *BasicBlock::getUniquePredecessor() {
+  if (PredCount == 0) return 0; // No preds.
   pred_iterator PI = pred_begin(this), E = pred_end(this);
-  if (PI == E) return 0; // No preds.
   BasicBlock *PredBB = *PI;
+  if (PredCount == 1) return PredBB; // Exactly one edge.
   ++PI;
   for (;PI != E; ++PI) {
     if (*PI != PredBB)
@@ -355,6 +369,18 @@ void BasicBlock::replaceSuccessorsPhiUsesWith(BasicBlock *New) {
   }
 }
 
+/// renumberInstructions - Assign each instruction its position in the block.
+/// The numbering stays valid until the instruction list is next mutated, at
+/// which point the list callbacks (or the mutator itself, for a reordering
+/// splice within this block) clear InstrOrderValid and the next
+/// Instruction::comesBefore query renumbers again.
+void BasicBlock::renumberInstructions() const {
+  unsigned Order = 0;
+  for (const_iterator I = begin(), E = end(); I != E; ++I)
+    I->Order = Order++;
+  InstrOrderValid = true;
+}
+
 /// isLandingPad - Return true if this basic block is a landing pad. I.e., it's
 /// the destination of the 'unwind' edge of an invoke instruction.
 bool BasicBlock::isLandingPad() const {
@@ -369,3 +395,57 @@ LandingPadInst *BasicBlock::getLandingPadInst() {
 const LandingPadInst *BasicBlock::getLandingPadInst() const {
   return dyn_cast<LandingPadInst>(getFirstNonPHI());
 }
+
+//===----------------------------------------------------------------------===//
+// InstructionMover Implementation
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// InBatch - Predicate selecting the instructions of the current batch for
+/// iplist::splice_if.
+struct InBatch {
+  const SmallPtrSet<Instruction*, 16> &Batch;
+  explicit InBatch(const SmallPtrSet<Instruction*, 16> &B) : Batch(B) {}
+  bool operator()(Instruction &I) const { return Batch.count(&I); }
+};
+}
+
+void InstructionMover::apply() {
+  SmallPtrSet<Instruction*, 16> Batch;
+  for (unsigned i = 0, e = Moves.size(); i != e; ++i) {
+    Instruction *First = Moves[i].first;
+    if (First == 0) continue;   // Already moved as part of an earlier batch.
+
+    // Gather every recorded move with the same source block and insertion
+    // point into one batch.
+    BasicBlock *SrcBB = First->getParent();
+    Instruction *MovePos = Moves[i].second;
+    Batch.clear();
+    for (unsigned j = i; j != e; ++j) {
+      Instruction *I = Moves[j].first;
+      if (I && I->getParent() == SrcBB && Moves[j].second == MovePos) {
+        Batch.insert(I);
+        Moves[j].first = 0;
+      }
+    }
+
+    // One pass over the source block moves the whole batch, splicing
+    // contiguous instructions together.
+    BasicBlock *DestBB = MovePos->getParent();
+    if (DestBB == SrcBB) {
+      // Within one block the insertion point lies inside the range being
+      // scanned, which splice_if does not allow; move the instructions one
+      // at a time in block order instead.
+      for (BasicBlock::iterator I = SrcBB->begin(), E = SrcBB->end(); I != E;){
+        Instruction *Cur = I++;
+        if (Batch.count(Cur) && Cur != MovePos)
+          Cur->moveBefore(MovePos);
+      }
+      continue;
+    }
+    DestBB->getInstList().splice_if(MovePos, SrcBB->getInstList(),
+                                    SrcBB->begin(), SrcBB->end(),
+                                    InBatch(Batch));
+  }
+  Moves.clear();
+}
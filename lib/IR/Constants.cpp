@@ -31,6 +31,7 @@
 #include "llvm/Support/GetElementPtrTypeIterator.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstdarg>
@@ -460,12 +461,25 @@ Constant *ConstantInt::getFalse(Type *Ty) {
 // compare APInt's of different widths, which would violate an APInt class
 // invariant which generates an assertion.
 ConstantInt *ConstantInt::get(LLVMContext &Context, const APInt &V) {
+  LLVMContextImpl *pImpl = Context.pImpl;
+
+  // Check the recently-used cache first; most requests repeat a handful of
+  // small values and can skip hashing into the uniquing map entirely.
+  unsigned CacheIdx =
+    unsigned(V.getLimitedValue() ^ (V.getBitWidth() << 3)) %
+    LLVMContextImpl::NumRecentIntConstants;
+  ConstantInt *Cached = pImpl->RecentIntConstants[CacheIdx];
+  if (Cached && Cached->getValue().getBitWidth() == V.getBitWidth() &&
+      Cached->getValue() == V)
+    return Cached;
+
   // Get the corresponding integer type for the bit width of the value.
   IntegerType *ITy = IntegerType::get(Context, V.getBitWidth());
   // get an existing value or the insertion position
   DenseMapAPIntKeyInfo::KeyTy Key(V, ITy);
-  ConstantInt *&Slot = Context.pImpl->IntConstants[Key]; 
+  ConstantInt *&Slot = pImpl->IntConstants[Key];
   if (!Slot) Slot = new ConstantInt(ITy, V);
+  pImpl->RecentIntConstants[CacheIdx] = Slot;
   return Slot;
 }
 
@@ -2209,6 +2223,29 @@ static bool isAllZeros(StringRef Arr) {
   return true;
 }
 
+namespace {
+/// SharedConstantDataStore - A process-wide, content-addressed pool of
+/// constant payload bytes, shared read-only between every context that
+/// opted in with LLVMContext::enableSharedConstantData.  Each context keeps
+/// its own lightweight ConstantDataSequential handles pointing into the
+/// pool, so identical big table initializers built in many contexts are
+/// stored once.  Entries are immutable and live until llvm_shutdown.
+class SharedConstantDataStore {
+  sys::SmartMutex<true> Lock;
+  StringMap<char> Pool;
+public:
+  /// intern - Return stable storage holding a copy of Bytes, creating it on
+  /// first use.  Safe to call from multiple contexts on multiple threads.
+  StringRef intern(StringRef Bytes) {
+    sys::SmartScopedLock<true> Guard(Lock);
+    StringMapEntry<char> &Entry = Pool.GetOrCreateValue(Bytes);
+    return StringRef(Entry.getKeyData(), Entry.getKeyLength());
+  }
+};
+} // end anonymous namespace
+
+static ManagedStatic<SharedConstantDataStore> SharedConstantData;
+
 /// getImpl - This is the underlying implementation of all of the
 /// ConstantDataSequential::get methods.  They all thunk down to here, providing
 /// the correct element type.  We take the bytes in as a StringRef because
@@ -2221,14 +2258,36 @@ Constant *ConstantDataSequential::getImpl(StringRef Elements, Type *Ty) {
     return ConstantAggregateZero::get(Ty);
 
   // Do a lookup to see if we have already formed one of these.
-  StringMap<ConstantDataSequential*>::MapEntryTy &Slot =
-    Ty->getContext().pImpl->CDSConstants.GetOrCreateValue(Elements);
+  LLVMContextImpl *pImpl = Ty->getContext().pImpl;
+  LLVMContextImpl::CDSMapTy &CDSConstants = pImpl->CDSConstants;
+
+  LLVMContextImpl::CDSMapTy::iterator I = CDSConstants.find(Elements);
+  if (I == CDSConstants.end()) {
+    // First constant with this body.  The map does not copy its key, so pick
+    // stable storage for the bytes: if they live inside one of the context's
+    // registered external data buffers, reference them in place (zero copy);
+    // otherwise copy them into the context's allocator.
+    StringRef StableBytes;
+    if (pImpl->isExternalData(Elements)) {
+      StableBytes = Elements;
+    } else if (pImpl->UseSharedConstantData) {
+      // Identical payloads requested from any opted-in context resolve to
+      // the same read-only bytes; this context only allocates the handle.
+      StableBytes = SharedConstantData->intern(Elements);
+    } else {
+      char *Data = (char*)pImpl->CDSDataAllocator.Allocate(Elements.size(), 1);
+      memcpy(Data, Elements.data(), Elements.size());
+      StableBytes = StringRef(Data, Elements.size());
+    }
+    I = CDSConstants.insert(std::make_pair(StableBytes,
+                                  (ConstantDataSequential*)0)).first;
+  }
 
   // The bucket can point to a linked list of different CDS's that have the same
   // body but different types.  For example, 0,0,0,1 could be a 4 element array
   // of i8, or a 1-element array of i32.  They'll both end up in the same
-  /// StringMap bucket, linked up by their Next pointers.  Walk the list.
-  ConstantDataSequential **Entry = &Slot.getValue();
+  // bucket, linked up by their Next pointers.  Walk the list.
+  ConstantDataSequential **Entry = &I->second;
   for (ConstantDataSequential *Node = *Entry; Node != 0;
        Entry = &Node->Next, Node = *Entry)
     if (Node->getType() == Ty)
@@ -2237,25 +2296,27 @@ Constant *ConstantDataSequential::getImpl(StringRef Elements, Type *Ty) {
   // Okay, we didn't get a hit.  Create a node of the right class, link it in,
   // and return it.
   if (isa<ArrayType>(Ty))
-    return *Entry = new ConstantDataArray(Ty, Slot.getKeyData());
+    return *Entry = new ConstantDataArray(Ty, I->first.data());
 
   assert(isa<VectorType>(Ty));
-  return *Entry = new ConstantDataVector(Ty, Slot.getKeyData());
+  return *Entry = new ConstantDataVector(Ty, I->first.data());
 }
 
 void ConstantDataSequential::destroyConstant() {
-  // Remove the constant from the StringMap.
-  StringMap<ConstantDataSequential*> &CDSConstants = 
+  // Remove the constant from the uniquing map.
+  LLVMContextImpl::CDSMapTy &CDSConstants =
     getType()->getContext().pImpl->CDSConstants;
 
-  StringMap<ConstantDataSequential*>::iterator Slot =
+  LLVMContextImpl::CDSMapTy::iterator Slot =
     CDSConstants.find(getRawDataValues());
 
   assert(Slot != CDSConstants.end() && "CDS not found in uniquing table");
 
-  ConstantDataSequential **Entry = &Slot->getValue();
+  ConstantDataSequential **Entry = &Slot->second;
 
-  // Remove the entry from the hash table.
+  // Remove the entry from the hash table.  Note that a copied payload stays
+  // in the context's allocator until the context is destroyed; it is not
+  // worth tracking individual allocations to reclaim it earlier.
   if ((*Entry)->Next == 0) {
     // If there is only one value in the bucket (common case) it must be this
     // entry, and removing the entry should remove the bucket completely.
@@ -2605,37 +2666,28 @@ void ConstantStruct::replaceUsesOfWithOnConstant(Value *From, Value *To,
   assert(isa<Constant>(To) && "Cannot make Constant refer to non-constant!");
   Constant *ToC = cast<Constant>(To);
 
-  unsigned OperandToUpdate = U-OperandList;
-  assert(getOperand(OperandToUpdate) == From && "ReplaceAllUsesWith broken!");
-
   SmallVector<Constant*, 8> Values;
   LLVMContextImpl::StructConstantsTy::LookupKey Lookup;
   Lookup.first = cast<StructType>(getType());
   Values.reserve(getNumOperands());  // Build replacement struct.
 
-  // Fill values with the modified operands of the constant struct.  Also,
-  // compute whether this turns into an all-zeros struct.
-  bool isAllZeros = false;
-  bool isAllUndef = false;
-  if (ToC->isNullValue()) {
-    isAllZeros = true;
-    for (Use *O = OperandList, *E = OperandList+getNumOperands(); O != E; ++O) {
-      Constant *Val = cast<Constant>(O->get());
-      Values.push_back(Val);
-      if (isAllZeros) isAllZeros = Val->isNullValue();
-    }
-  } else if (isa<UndefValue>(ToC)) {
-    isAllUndef = true;
-    for (Use *O = OperandList, *E = OperandList+getNumOperands(); O != E; ++O) {
-      Constant *Val = cast<Constant>(O->get());
-      Values.push_back(Val);
-      if (isAllUndef) isAllUndef = isa<UndefValue>(Val);
+  // Fill values with the modified operands of the constant struct, replacing
+  // every use of 'From' at once so that a struct which uses it many times is
+  // only re-uniqued a single time, as ConstantArray does.  Also, compute
+  // whether this turns into an all-zeros or all-undef struct.
+  unsigned NumUpdated = 0;
+  bool isAllZeros = ToC->isNullValue();
+  bool isAllUndef = isa<UndefValue>(ToC);
+  for (Use *O = OperandList, *E = OperandList+getNumOperands(); O != E; ++O) {
+    Constant *Val = cast<Constant>(O->get());
+    if (Val == From) {
+      Val = ToC;
+      ++NumUpdated;
     }
-  } else {
-    for (Use *O = OperandList, *E = OperandList + getNumOperands(); O != E; ++O)
-      Values.push_back(cast<Constant>(O->get()));
+    Values.push_back(Val);
+    if (isAllZeros) isAllZeros = Val->isNullValue();
+    if (isAllUndef) isAllUndef = isa<UndefValue>(Val);
   }
-  Values[OperandToUpdate] = ToC;
 
   LLVMContextImpl *pImpl = getContext().pImpl;
 
@@ -2659,8 +2711,18 @@ void ConstantStruct::replaceUsesOfWithOnConstant(Value *From, Value *To,
       // in place!
       pImpl->StructConstants.remove(this);
 
-      // Update to the new value.
-      setOperand(OperandToUpdate, ToC);
+      // Update to the new value.  Optimize for the case when we have a single
+      // operand that we're changing, but handle bulk updates efficiently.
+      if (NumUpdated == 1) {
+        unsigned OperandToUpdate = U - OperandList;
+        assert(getOperand(OperandToUpdate) == From &&
+               "ReplaceAllUsesWith broken!");
+        setOperand(OperandToUpdate, ToC);
+      } else {
+        for (unsigned i = 0, e = getNumOperands(); i != e; ++i)
+          if (getOperand(i) == From)
+            setOperand(i, ToC);
+      }
       pImpl->StructConstants.insert(this);
       return;
     }
@@ -73,6 +73,93 @@ bool DominatorTree::runOnFunction(Function &F) {
   return false;
 }
 
+/// insertEdge - Update dominator tree information to reflect the insertion
+/// of the CFG edge From -> To.  The edge must already be in the CFG.
+void DominatorTree::insertEdge(BasicBlock *From, BasicBlock *To) {
+  // An edge leaving an unreachable block cannot change the dominance of any
+  // reachable block.
+  DomTreeNode *FromNode = getNode(From);
+  if (!FromNode)
+    return;
+
+  DomTreeNode *ToNode = getNode(To);
+  if (!ToNode) {
+    // To has just become reachable, and only through From.  If nothing new
+    // can be reached from To it is simply a new leaf under From; otherwise
+    // the newly reachable region has to be rebuilt.
+    if (succ_begin(To) == succ_end(To)) {
+      addNewBlock(To, From);
+      return;
+    }
+    DT->recalculate(*From->getParent());
+    return;
+  }
+
+  BasicBlock *NCD = findNearestCommonDominator(From, To);
+
+  // A new edge into a block that dominates its source adds no path that
+  // avoids any dominator: nothing changes.
+  if (NCD == To)
+    return;
+
+  // The new immediate dominator of To is the nearest common dominator of
+  // From and To's old immediate dominator, which is exactly NCD.  If To's
+  // immediate dominator does not change, no immediate dominator anywhere in
+  // the tree changes.
+  DomTreeNode *IDomNode = ToNode->getIDom();
+  if (IDomNode && IDomNode->getBlock() == NCD)
+    return;
+
+  // If no CFG path leaves To, it is the only block whose dominance can be
+  // affected.
+  if (succ_begin(To) == succ_end(To)) {
+    changeImmediateDominator(To, NCD);
+    return;
+  }
+
+  // Blocks reachable from To may be affected as well; identifying exactly
+  // which ones requires a search of the region below NCD, so rebuild the
+  // tree instead.
+  DT->recalculate(*From->getParent());
+}
+
+/// deleteEdge - Update dominator tree information to reflect the removal of
+/// the CFG edge From -> To.  The edge must already be gone from the CFG.
+void DominatorTree::deleteEdge(BasicBlock *From, BasicBlock *To) {
+  // Edges touching unreachable blocks do not show up in the tree.
+  DomTreeNode *ToNode = getNode(To);
+  if (!getNode(From) || !ToNode)
+    return;
+
+  // For a reachable block the immediate dominator is the nearest common
+  // dominator of all of its predecessors; recompute it from the remaining
+  // predecessor edges.
+  BasicBlock *NewIDom = 0;
+  for (pred_iterator PI = pred_begin(To), PE = pred_end(To); PI != PE; ++PI) {
+    BasicBlock *Pred = *PI;
+    if (!isReachableFromEntry(Pred))
+      continue;
+    NewIDom = NewIDom ? findNearestCommonDominator(NewIDom, Pred) : Pred;
+  }
+
+  // If To lost its last reachable predecessor, the region that was only
+  // reachable through it has to be carved out of the tree.
+  if (!NewIDom) {
+    DT->recalculate(*From->getParent());
+    return;
+  }
+
+  // Removing an edge can only add dominators.  If the immediate dominator of
+  // To is unchanged, the old tree is still the unique solution for the new
+  // CFG and nothing needs to be done.
+  DomTreeNode *IDomNode = ToNode->getIDom();
+  if (IDomNode && IDomNode->getBlock() == NewIDom)
+    return;
+
+  // To's subtree and blocks that shared dominators with it may be affected.
+  DT->recalculate(*From->getParent());
+}
+
 void DominatorTree::verifyAnalysis() const {
   if (!VerifyDomInfo) return;
 
@@ -123,12 +210,9 @@ bool DominatorTree::dominates(const Instruction *Def,
   if (DefBB != UseBB)
     return dominates(DefBB, UseBB);
 
-  // Loop through the basic block until we find Def or User.
-  BasicBlock::const_iterator I = DefBB->begin();
-  for (; &*I != Def && &*I != User; ++I)
-    /*empty*/;
-
-  return &*I == Def;
+  // Use the block-local instruction numbering; walking the instruction list
+  // here is quadratic in blocks with many locally-used definitions.
+  return Def->comesBefore(User);
 }
 
 // true if Def would dominate a use in any instruction in UseBB.
@@ -278,12 +362,9 @@ bool DominatorTree::dominates(const Instruction *Def,
   if (isa<PHINode>(UserInst))
     return true;
 
-  // Otherwise, just loop through the basic block until we find Def or User.
-  BasicBlock::const_iterator I = DefBB->begin();
-  for (; &*I != Def && &*I != UserInst; ++I)
-    /*empty*/;
-
-  return &*I != UserInst;
+  // Otherwise, compare the positions via the block-local instruction
+  // numbering.
+  return Def->comesBefore(UserInst);
 }
 
 bool DominatorTree::isReachableFromEntry(const Use &U) const {
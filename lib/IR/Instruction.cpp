@@ -23,7 +23,7 @@ using namespace llvm;
 
 Instruction::Instruction(Type *ty, unsigned it, Use *Ops, unsigned NumOps,
                          Instruction *InsertBefore)
-  : User(ty, Value::InstructionVal + it, Ops, NumOps), Parent(0) {
+  : User(ty, Value::InstructionVal + it, Ops, NumOps), Parent(0), Order(0) {
   // Make sure that we get added to a basicblock
   LeakDetector::addGarbageObject(this);
 
@@ -37,7 +37,7 @@ Instruction::Instruction(Type *ty, unsigned it, Use *Ops, unsigned NumOps,
 
 Instruction::Instruction(Type *ty, unsigned it, Use *Ops, unsigned NumOps,
                          BasicBlock *InsertAtEnd)
-  : User(ty, Value::InstructionVal + it, Ops, NumOps), Parent(0) {
+  : User(ty, Value::InstructionVal + it, Ops, NumOps), Parent(0), Order(0) {
   // Make sure that we get added to a basicblock
   LeakDetector::addGarbageObject(this);
 
@@ -62,6 +62,13 @@ void Instruction::setParent(BasicBlock *P) {
     if (P) LeakDetector::removeGarbageObject(this);
   }
 
+  // Insertion into or removal from a block invalidates its cached
+  // instruction numbering.
+  if (Parent)
+    Parent->invalidateInstrOrder();
+  if (P)
+    P->invalidateInstrOrder();
+
   Parent = P;
 }
 
@@ -89,10 +96,26 @@ void Instruction::insertAfter(Instruction *InsertPos) {
 /// insert it into the basic block that MovePos lives in, right before
 /// MovePos.
 void Instruction::moveBefore(Instruction *MovePos) {
+  // A move within one block does not pass through the list callbacks that
+  // normally invalidate the cached instruction numbering, so do it here.
+  if (MovePos->getParent() == getParent())
+    getParent()->invalidateInstrOrder();
   MovePos->getParent()->getInstList().splice(MovePos,getParent()->getInstList(),
                                              this);
 }
 
+/// comesBefore - Return true if this instruction comes before Other in the
+/// same basic block.
+bool Instruction::comesBefore(const Instruction *Other) const {
+  assert(Parent && Other->Parent &&
+         "instructions without a parent block have no order");
+  assert(Parent == Other->Parent &&
+         "cross-block instruction order comparison");
+  if (!Parent->isInstrOrderValid())
+    Parent->renumberInstructions();
+  return Order < Other->Order;
+}
+
 /// Set or clear the unsafe-algebra flag on this instruction, which must be an
 /// operator which supports this flag. See LangRef.html for the meaning of this
 /// flag.
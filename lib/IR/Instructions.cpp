@@ -261,10 +261,55 @@ void LandingPadInst::addClause(Value *Val) {
 //===----------------------------------------------------------------------===//
 
 CallInst::~CallInst() {
+  // Re-expose any reserved operand slots so that ~User and operator delete
+  // see the allocation operator new originally made.
+  if (ReservedOperands > NumOperands) {
+    Use *End = op_end();
+    OperandList = End - ReservedOperands;
+    NumOperands = ReservedOperands;
+  }
+}
+
+CallInst *CallInst::Create(Value *Func, ArrayRef<Value *> Args,
+                           unsigned ReservedArgs, const Twine &NameStr,
+                           Instruction *InsertBefore) {
+  assert(ReservedArgs >= Args.size() && "Reservation smaller than the call");
+  // The constructor only claims the last Args.size()+1 slots of the
+  // allocation; the slack in front of them stays tagged but unused until
+  // addArgOperand exposes it.
+  CallInst *CI =
+    new(ReservedArgs + 1) CallInst(Func, Args, NameStr, InsertBefore);
+  CI->ReservedOperands = ReservedArgs + 1;
+  return CI;
+}
+
+void CallInst::addArgOperand(Value *V) {
+  assert(NumOperands < ReservedOperands &&
+         "No reserved space left; create the call with reserved arguments");
+  // Expose one reserved slot at the front of the operand list and shift the
+  // existing arguments into it, freeing the slot before the callee for the
+  // new argument.
+  --OperandList;
+  ++NumOperands;
+  for (unsigned i = 0, e = NumOperands - 2; i != e; ++i)
+    OperandList[i] = OperandList[i+1];
+  OperandList[NumOperands-2] = V;
+}
+
+void CallInst::removeArgOperand(unsigned i) {
+  assert(i < getNumArgOperands() && "Removing out of range argument!");
+  // Shift the arguments preceding i down a slot and retire the first slot;
+  // it becomes reserved space for addArgOperand.
+  for (unsigned j = i; j != 0; --j)
+    OperandList[j] = OperandList[j-1];
+  OperandList[0].set(0);
+  ++OperandList;
+  --NumOperands;
 }
 
 void CallInst::init(Value *Func, ArrayRef<Value *> Args, const Twine &NameStr) {
   assert(NumOperands == Args.size() + 1 && "NumOperands not set up?");
+  ReservedOperands = NumOperands;
   Op<-1>() = Func;
 
 #ifndef NDEBUG
@@ -287,6 +332,7 @@ void CallInst::init(Value *Func, ArrayRef<Value *> Args, const Twine &NameStr) {
 
 void CallInst::init(Value *Func, const Twine &NameStr) {
   assert(NumOperands == 1 && "NumOperands not set up?");
+  ReservedOperands = NumOperands;
   Op<-1>() = Func;
 
 #ifndef NDEBUG
@@ -323,6 +369,8 @@ CallInst::CallInst(const CallInst &CI)
   : Instruction(CI.getType(), Instruction::Call,
                 OperandTraits<CallInst>::op_end(this) - CI.getNumOperands(),
                 CI.getNumOperands()) {
+  // Clones are allocated with an exact-size operand array.
+  ReservedOperands = CI.getNumOperands();
   setAttributes(CI.getAttributes());
   setTailCall(CI.isTailCall());
   setCallingConv(CI.getCallingConv());
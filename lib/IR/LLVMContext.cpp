@@ -69,6 +69,14 @@ void LLVMContext::removeModule(Module *M) {
   pImpl->OwnedModules.erase(M);
 }
 
+void LLVMContext::enableSharedConstantData() {
+  pImpl->UseSharedConstantData = true;
+}
+
+void LLVMContext::addExternalDataBuffer(MemoryBuffer *Buf) {
+  pImpl->ExternalDataBuffers.push_back(Buf);
+}
+
 //===----------------------------------------------------------------------===//
 // Recoverable Backend Errors
 //===----------------------------------------------------------------------===//
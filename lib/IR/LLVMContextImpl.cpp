@@ -15,7 +15,9 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/IR/Attributes.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include <algorithm>
+#include <cstring>
 using namespace llvm;
 
 LLVMContextImpl::LLVMContextImpl(LLVMContext &C)
@@ -38,6 +40,9 @@ LLVMContextImpl::LLVMContextImpl(LLVMContext &C)
   DiagHandler = 0;
   DiagContext = 0;
   NamedStructTypesUniqueID = 0;
+  UseSharedConstantData = false;
+  std::memset(RecentIntConstants, 0, sizeof(RecentIntConstants));
+  std::memset(SimpleEnumAttrs, 0, sizeof(SimpleEnumAttrs));
 }
 
 namespace {
@@ -90,11 +95,15 @@ LLVMContextImpl::~LLVMContextImpl() {
   DeleteContainerSeconds(IntConstants);
   DeleteContainerSeconds(FPConstants);
   
-  for (StringMap<ConstantDataSequential*>::iterator I = CDSConstants.begin(),
+  for (CDSMapTy::iterator I = CDSConstants.begin(),
        E = CDSConstants.end(); I != E; ++I)
     delete I->second;
   CDSConstants.clear();
 
+  // Free the external data buffers after the constants that may point into
+  // them have been destroyed.
+  DeleteContainerPointers(ExternalDataBuffers);
+
   // Destroy attributes.
   for (FoldingSetIterator<AttributeImpl> I = AttrsSet.begin(),
          E = AttrsSet.end(); I != E; ) {
@@ -130,8 +139,22 @@ LLVMContextImpl::~LLVMContextImpl() {
   assert(MDNodeSet.empty() && NonUniquedMDNodes.empty() &&
          "Destroying all MDNodes didn't empty the Context's sets.");
 
-  // Destroy MDStrings.
-  DeleteContainerSeconds(MDStringCache);
+  // Destroy MDStrings.  They live in the metadata arena, so just run the
+  // destructors and let the arena reclaim the memory.
+  for (StringMap<Value*>::iterator I = MDStringCache.begin(),
+         E = MDStringCache.end(); I != E; ++I)
+    I->second->~Value();
+  MDStringCache.clear();
+}
+
+bool LLVMContextImpl::isExternalData(StringRef Bytes) const {
+  for (unsigned i = 0, e = ExternalDataBuffers.size(); i != e; ++i) {
+    const MemoryBuffer *Buf = ExternalDataBuffers[i];
+    if (Bytes.data() >= Buf->getBufferStart() &&
+        Bytes.data() + Bytes.size() <= Buf->getBufferEnd())
+      return true;
+  }
+  return false;
 }
 
 // ConstantsContext anchors
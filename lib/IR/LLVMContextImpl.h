@@ -21,6 +21,7 @@
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/CachedHash.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/Hashing.h"
@@ -30,6 +31,7 @@
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Metadata.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/ValueHandle.h"
 #include <vector>
 
@@ -38,6 +40,7 @@ namespace llvm {
 class ConstantInt;
 class ConstantFP;
 class LLVMContext;
+class MemoryBuffer;
 class Type;
 class Value;
 
@@ -239,18 +242,43 @@ public:
   LLVMContext::DiagHandlerTy DiagHandler;
   void *DiagContext;
   
-  typedef DenseMap<DenseMapAPIntKeyInfo::KeyTy, ConstantInt*, 
-                         DenseMapAPIntKeyInfo> IntMapTy;
+  // The APInt and APFloat keys are expensive to hash, so cache the hash with
+  // each entry: lookups hash once, growth redistributes without rehashing,
+  // and probing rejects mismatches on the cached hash first.
+  typedef DenseMap<CachedHash<DenseMapAPIntKeyInfo::KeyTy,
+                              DenseMapAPIntKeyInfo>, ConstantInt*> IntMapTy;
   IntMapTy IntConstants;
-  
-  typedef DenseMap<DenseMapAPFloatKeyInfo::KeyTy, ConstantFP*, 
-                         DenseMapAPFloatKeyInfo> FPMapTy;
+
+  // RecentIntConstants - A small direct-mapped cache in front of
+  // IntConstants.  Integer constant creation is dominated by the same few
+  // values (0, 1, small array indices) being re-requested, so most lookups
+  // can skip building the map key and hashing the APInt.  ConstantInts are
+  // never destroyed before the context is, so entries cannot go stale.
+  enum { NumRecentIntConstants = 64 };
+  ConstantInt *RecentIntConstants[NumRecentIntConstants];
+
+  typedef DenseMap<CachedHash<DenseMapAPFloatKeyInfo::KeyTy,
+                              DenseMapAPFloatKeyInfo>, ConstantFP*> FPMapTy;
   FPMapTy FPConstants;
 
   FoldingSet<AttributeImpl> AttrsSet;
   FoldingSet<AttributeSetImpl> AttrsLists;
   FoldingSet<AttributeSetNode> AttrsSetNodes;
 
+  // SimpleEnumAttrs - Direct-mapped cache in front of AttrsSet for enum
+  // attributes without a value. Bulk interning of attribute lists looks up
+  // every attribute individually, and these kinds dominate, so resolve them
+  // with an array index instead of a FoldingSet probe. AttributeImpls are
+  // never destroyed before the context, so entries cannot go stale.
+  AttributeImpl *SimpleEnumAttrs[Attribute::EndAttrKinds];
+
+  // Metadata is created in huge quantities by debug info and almost all of it
+  // lives as long as the context, so MDNodes and MDStrings are carved out of
+  // this slab allocator instead of being malloc'd individually.  Nodes that
+  // die early (see MDNode::destroy) run their destructor but their memory is
+  // only reclaimed when the context itself goes away.
+  BumpPtrAllocator MDNodeAllocator;
+
   StringMap<Value*> MDStringCache;
 
   FoldingSet<MDNode> MDNodeSet;
@@ -275,10 +303,53 @@ public:
   DenseMap<PointerType*, ConstantPointerNull*> CPNConstants;
 
   DenseMap<Type*, UndefValue*> UVConstants;
-  
-  StringMap<ConstantDataSequential*> CDSConstants;
 
-  
+  /// CDSMapInfo - DenseMap traits for uniquing ConstantDataSequentials by
+  /// their byte payload.  Unlike a StringMap, this map does not own the key
+  /// bytes; ordinary constants copy their payload into CDSDataAllocator,
+  /// while payloads inside a registered external data buffer are referenced
+  /// in place.  Zero-length keys never occur (all-zero payloads become
+  /// ConstantAggregateZero), so the sentinel keys are safe.
+  struct CDSMapInfo {
+    static inline StringRef getEmptyKey() {
+      return StringRef(reinterpret_cast<const char *>(intptr_t(-1)), 0);
+    }
+    static inline StringRef getTombstoneKey() {
+      return StringRef(reinterpret_cast<const char *>(intptr_t(-2)), 0);
+    }
+    static unsigned getHashValue(StringRef Val) {
+      return (unsigned)hash_value(Val);
+    }
+    static bool isEqual(StringRef LHS, StringRef RHS) {
+      if (LHS.size() == 0 && RHS.size() == 0)
+        return LHS.data() == RHS.data();
+      return LHS == RHS;
+    }
+  };
+  typedef DenseMap<StringRef, ConstantDataSequential *, CDSMapInfo> CDSMapTy;
+  CDSMapTy CDSConstants;
+
+  /// CDSDataAllocator - Owns the copied payload bytes of the constants in
+  /// CDSConstants.  Individual payloads are not reclaimed when a constant is
+  /// destroyed; everything is freed with the context.
+  BumpPtrAllocator CDSDataAllocator;
+
+  /// ExternalDataBuffers - Immutable buffers handed to the context with
+  /// LLVMContext::addExternalDataBuffer.  Constant data payloads that point
+  /// into one of these are referenced directly instead of being copied.  The
+  /// buffers are owned by the context and freed with it.
+  std::vector<MemoryBuffer *> ExternalDataBuffers;
+
+  /// isExternalData - Return true if Bytes lies entirely within one of the
+  /// registered external data buffers.
+  bool isExternalData(StringRef Bytes) const;
+
+  /// UseSharedConstantData - When set (LLVMContext::enableSharedConstantData)
+  /// constant data payloads are interned into the process-wide shared store
+  /// rather than copied into CDSDataAllocator.
+  bool UseSharedConstantData;
+
+
   DenseMap<std::pair<Function*, BasicBlock*> , BlockAddress*> BlockAddresses;
   ConstantUniqueMap<ExprMapKeyType, const ExprMapKeyType&, Type, ConstantExpr>
     ExprConstants;
@@ -316,12 +387,25 @@ public:
   DenseMap<std::pair<Type*, unsigned>, PointerType*> ASPointerTypes;
 
 
-  /// ValueHandles - This map keeps track of all of the value handles that are
-  /// watching a Value*.  The Value::HasValueHandle bit is used to know
-  // whether or not a value has an entry in this map.
+  /// ValueHandles - These maps keep track of all of the value handles that
+  /// are watching a Value*.  The Value::HasValueHandle bit is used to know
+  /// whether or not a value has an entry in this map.  The registry is
+  /// sharded by pointer hash: inserting the first handle for a value can
+  /// rehash the table, after which every handle heading a list must have its
+  /// back-pointer into the bucket array fixed up, so many small independent
+  /// tables keep that walk short during bulk RAUW and deletion.
+  enum { NumValueHandleShards = 16 };
   typedef DenseMap<Value*, ValueHandleBase*> ValueHandlesTy;
-  ValueHandlesTy ValueHandles;
-  
+  ValueHandlesTy ValueHandleShards[NumValueHandleShards];
+
+  /// getValueHandles - Return the value handle shard covering V.  The low
+  /// bits of a Value* are alignment noise, so skip them when picking one.
+  ValueHandlesTy &getValueHandles(const Value *V) {
+    uintptr_t Ptr = reinterpret_cast<uintptr_t>(V);
+    return ValueHandleShards[(Ptr >> 4) & (NumValueHandleShards - 1)];
+  }
+
+
   /// CustomMDKindNames - Map to hold the metadata string to ID mapping.
   StringMap<unsigned> CustomMDKindNames;
   
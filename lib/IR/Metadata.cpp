@@ -21,6 +21,8 @@
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/AlignOf.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/ConstantRange.h"
 #include "llvm/Support/LeakDetector.h"
 #include "llvm/Support/ValueHandle.h"
@@ -40,7 +42,9 @@ MDString *MDString::get(LLVMContext &Context, StringRef Str) {
   StringMapEntry<Value*> &Entry =
     pImpl->MDStringCache.GetOrCreateValue(Str);
   Value *&S = Entry.getValue();
-  if (!S) S = new MDString(Context);
+  // The string bytes are interned in MDStringCache itself; the MDString
+  // object is just a fixed-size Value, so carve it out of the metadata arena.
+  if (!S) S = new (pImpl->MDNodeAllocator) MDString(Context);
   S->setValueName(&Entry);
   return cast<MDString>(S);
 }
@@ -199,10 +203,14 @@ const Function *MDNode::getFunction() const {
 
 // destroy - Delete this node.  Only when there are no uses.
 void MDNode::destroy() {
+  bool InArena = (getSubclassDataFromValue() & ArenaAllocatedBit) != 0;
   setValueSubclassData(getSubclassDataFromValue() | DestroyFlag);
-  // Placement delete, then free the memory.
+  // Placement delete.  Memory from the context's metadata arena is only
+  // reclaimed when the context is destroyed; temporary nodes were malloc'd
+  // by getTemporary() and are freed immediately.
   this->~MDNode();
-  free(this);
+  if (!InArena)
+    free(this);
 }
 
 /// isFunctionLocalValue - Return true if this is a value that would require a
@@ -250,9 +258,14 @@ MDNode *MDNode::getMDNode(LLVMContext &Context, ArrayRef<Value*> Vals,
     break;
   }
 
-  // Coallocate space for the node and Operands together, then placement new.
-  void *Ptr = malloc(sizeof(MDNode) + Vals.size() * sizeof(MDNodeOperand));
+  // Coallocate space for the node and Operands together in the context's
+  // metadata arena, then placement new.
+  void *Ptr =
+    pImpl->MDNodeAllocator.Allocate(sizeof(MDNode) +
+                                    Vals.size() * sizeof(MDNodeOperand),
+                                    AlignOf<MDNode>::Alignment);
   N = new (Ptr) MDNode(Context, Vals, isFunctionLocal);
+  N->setValueSubclassData(N->getSubclassDataFromValue() | ArenaAllocatedBit);
 
   // Cache the operand hash.
   N->Hash = ID.ComputeHash();
@@ -278,6 +291,8 @@ MDNode *MDNode::getIfExists(LLVMContext &Context, ArrayRef<Value*> Vals) {
 }
 
 MDNode *MDNode::getTemporary(LLVMContext &Context, ArrayRef<Value*> Vals) {
+  // Temporary nodes are deleted eagerly via deleteTemporary, so they come
+  // from malloc rather than the metadata arena.
   MDNode *N =
     (MDNode *)malloc(sizeof(MDNode) + Vals.size() * sizeof(MDNodeOperand));
   N = new (N) MDNode(Context, Vals, FL_No);
@@ -17,12 +17,16 @@
 #include "llvm/Assembly/Writer.h"
 #include "llvm/IR/Module.h"
 #include "llvm/PassManager.h"
+#include "llvm/Support/Atomic.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/PassNameParser.h"
+#include "llvm/Support/SamplingProfiler.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -488,6 +492,113 @@ public:
 
 static TimingInfo *TheTimeInfo;
 
+//===----------------------------------------------------------------------===//
+/// Pass budget support - With -pass-budget=N every pass run on a function is
+/// given N milliseconds.  Cooperating passes poll PassBudgetExceeded() from
+/// their work loops and stop transforming when the budget runs out; passes
+/// that do not cooperate are unaffected but still show up in the overrun
+/// report printed at shutdown, so pathological pass/function pairs can be
+/// found even before their passes learn to bail out.
+///
+
+static cl::opt<unsigned>
+PassBudgetMillis("pass-budget", cl::Hidden, cl::init(0),
+  cl::desc("Per-pass-per-function time budget in milliseconds; cooperating "
+           "passes stop transforming when it runs out (default: none)"));
+
+namespace {
+/// PassBudgetInfo - Collects the pass runs that overran the -pass-budget
+/// limit and prints them when the process shuts down, the same way
+/// TimingInfo reports -time-passes.
+struct PassBudgetInfo {
+  struct Overrun {
+    std::string PassName;
+    std::string FnName;
+    double Millis;
+    bool Truncated;
+  };
+  std::vector<Overrun> Overruns;
+
+  ~PassBudgetInfo() {
+    if (Overruns.empty())
+      return;
+    raw_ostream &OS = errs();
+    OS << "=== Pass runs exceeding -pass-budget=" << PassBudgetMillis
+       << " ===\n";
+    for (unsigned i = 0, e = Overruns.size(); i != e; ++i) {
+      const Overrun &OR = Overruns[i];
+      OS << format("  %10.1f ms  ", OR.Millis)
+         << (OR.Truncated ? "(truncated) " : "            ")
+         << OR.PassName << " on '" << OR.FnName << "'\n";
+    }
+  }
+};
+} // End of anon namespace
+
+static ManagedStatic<PassBudgetInfo> TheBudgetInfo;
+
+// Budget state for the currently executing pass.  The legacy pass manager
+// runs one pass at a time, so plain globals suffice.
+static bool BudgetArmed = false;
+static bool BudgetNoticed = false;
+static double BudgetStart = 0;
+static double BudgetDeadline = 0;
+
+bool llvm::PassBudgetExceeded() {
+  if (!BudgetArmed)
+    return false;
+  if (BudgetNoticed)
+    return true;
+  if (TimeRecord::getCurrentTime(false).getWallTime() < BudgetDeadline)
+    return false;
+  BudgetNoticed = true;
+  return true;
+}
+
+namespace {
+/// BudgetRegion - RAII object that arms the -pass-budget deadline around one
+/// pass run and records an overrun entry if the run went over budget.  The
+/// previous budget state is restored on exit so that passes running nested
+/// pass managers keep their own budget.
+class BudgetRegion {
+  Pass *P;
+  StringRef FnName;
+  bool SavedArmed, SavedNoticed;
+  double SavedStart, SavedDeadline;
+public:
+  BudgetRegion(Pass *p, const Function &F)
+    : P(p), FnName(F.getName()),
+      SavedArmed(BudgetArmed), SavedNoticed(BudgetNoticed),
+      SavedStart(BudgetStart), SavedDeadline(BudgetDeadline) {
+    if (!PassBudgetMillis || P->getAsPMDataManager()) {
+      P = 0;
+      return;
+    }
+    BudgetStart = TimeRecord::getCurrentTime(true).getWallTime();
+    BudgetDeadline = BudgetStart + PassBudgetMillis * 1e-3;
+    BudgetNoticed = false;
+    BudgetArmed = true;
+  }
+  ~BudgetRegion() {
+    if (P) {
+      double Now = TimeRecord::getCurrentTime(false).getWallTime();
+      if (Now >= BudgetDeadline) {
+        PassBudgetInfo::Overrun OR;
+        OR.PassName = P->getPassName();
+        OR.FnName = FnName.str();
+        OR.Millis = (Now - BudgetStart) * 1e3;
+        OR.Truncated = BudgetNoticed;
+        TheBudgetInfo->Overruns.push_back(OR);
+      }
+    }
+    BudgetArmed = SavedArmed;
+    BudgetNoticed = SavedNoticed;
+    BudgetStart = SavedStart;
+    BudgetDeadline = SavedDeadline;
+  }
+};
+} // End of anon namespace
+
 //===----------------------------------------------------------------------===//
 // PMTopLevelManager implementation
 
@@ -1412,6 +1523,97 @@ bool FunctionPassManager::doFinalization() {
   return FPM->doFinalization(*M);
 }
 
+//===----------------------------------------------------------------------===//
+// ParallelFunctionPassManager implementation
+//
+
+ParallelFunctionPassManager::PipelineBuilder::~PipelineBuilder() {}
+
+namespace {
+  /// ParallelFPMWorkQueue - Shared state for the worker threads: the
+  /// functions still to be processed and a claim index the workers advance
+  /// atomically, so long functions do not serialize the pool.
+  struct ParallelFPMWorkQueue {
+    std::vector<Function*> Work;
+    volatile sys::cas_flag NextIndex;
+
+    ParallelFPMWorkQueue() : NextIndex(0) {}
+
+    /// claim - Pop the next unprocessed function, or null when drained.
+    Function *claim() {
+      sys::cas_flag Index = sys::AtomicIncrement(&NextIndex) - 1;
+      if (Index >= (sys::cas_flag)Work.size())
+        return 0;
+      return Work[Index];
+    }
+  };
+
+  /// ParallelFPMWorker - Per-thread state: a private pipeline over the
+  /// shared queue.
+  struct ParallelFPMWorker {
+    FunctionPassManager *FPM;
+    ParallelFPMWorkQueue *Queue;
+    bool Changed;
+
+    ParallelFPMWorker() : FPM(0), Queue(0), Changed(false) {}
+  };
+}
+
+static void RunParallelFPMWorker(void *Arg) {
+  ParallelFPMWorker *Worker = static_cast<ParallelFPMWorker*>(Arg);
+  while (Function *F = Worker->Queue->claim())
+    Worker->Changed |= Worker->FPM->run(*F);
+}
+
+ParallelFunctionPassManager::ParallelFunctionPassManager(Module *m,
+                                                         unsigned numThreads)
+  : M(m), NumThreads(numThreads ? numThreads : 1) {
+}
+
+ParallelFunctionPassManager::~ParallelFunctionPassManager() {
+}
+
+bool ParallelFunctionPassManager::run(PipelineBuilder &Builder) {
+  // Populate one private pipeline per worker; passes keep per-run state and
+  // cannot be shared between threads.
+  std::vector<FunctionPassManager*> Pipelines(NumThreads);
+  for (unsigned i = 0; i != NumThreads; ++i) {
+    Pipelines[i] = new FunctionPassManager(M);
+    Builder.populate(*Pipelines[i]);
+  }
+
+  bool Changed = false;
+  for (unsigned i = 0; i != NumThreads; ++i)
+    Changed |= Pipelines[i]->doInitialization();
+
+  ParallelFPMWorkQueue Queue;
+  for (Module::iterator I = M->begin(), E = M->end(); I != E; ++I)
+    if (!I->isDeclaration())
+      Queue.Work.push_back(I);
+
+  std::vector<ParallelFPMWorker> Workers(NumThreads);
+  for (unsigned i = 0; i != NumThreads; ++i) {
+    Workers[i].FPM = Pipelines[i];
+    Workers[i].Queue = &Queue;
+  }
+
+  // The calling thread doubles as worker 0.
+  std::vector<void*> Threads(NumThreads, (void*)0);
+  for (unsigned i = 1; i != NumThreads; ++i)
+    Threads[i] = llvm_launch_thread(RunParallelFPMWorker, &Workers[i]);
+  RunParallelFPMWorker(&Workers[0]);
+  for (unsigned i = 1; i != NumThreads; ++i)
+    llvm_join_thread(Threads[i]);
+
+  for (unsigned i = 0; i != NumThreads; ++i) {
+    Changed |= Workers[i].Changed;
+    Changed |= Pipelines[i]->doFinalization();
+    delete Pipelines[i];
+  }
+
+  return Changed;
+}
+
 //===----------------------------------------------------------------------===//
 // FunctionPassManagerImpl implementation
 //
@@ -1526,6 +1728,8 @@ bool FPPassManager::runOnFunction(Function &F) {
     {
       PassManagerPrettyStackEntry X(FP, F);
       TimeRegion PassTimer(getPassTimer(FP));
+      BudgetRegion PassBudget(FP, F);
+      SamplingScope PassSamples(FP->getPassName(), F.getName());
 
       LocalChanged |= FP->runOnFunction(F);
     }
@@ -1604,6 +1808,8 @@ MPPassManager::runOnModule(Module &M) {
     {
       PassManagerPrettyStackEntry X(MP, M);
       TimeRegion PassTimer(getPassTimer(MP));
+      SamplingScope PassSamples(MP->getPassName(),
+                                M.getModuleIdentifier());
 
       LocalChanged |= MP->runOnModule(M);
     }
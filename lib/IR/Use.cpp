@@ -25,10 +25,12 @@ void Use::swap(Use &RHS) {
   Value *V2(RHS.Val);
   if (V1 != V2) {
     if (V1) {
+      V1->removeUse(*this);
       removeFromList();
     }
 
     if (V2) {
+      V2->removeUse(RHS);
       RHS.removeFromList();
       Val = V2;
       V2->addUse(*this);
@@ -124,8 +126,13 @@ Use *Use::initTags(Use * const Start, Use *Stop) {
 //===----------------------------------------------------------------------===//
 
 void Use::zap(Use *Start, const Use *Stop, bool del) {
-  while (Start != Stop)
-    (--Stop)->~Use();
+  Use *End = Start + (Stop - Start);
+  while (Start != End) {
+    --End;
+    if (End->Val)
+      End->Val->removeUse(*End);
+    End->~Use();
+  }
   if (del)
     ::operator delete(Start);
 }
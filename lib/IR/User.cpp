@@ -11,6 +11,125 @@
 #include "llvm/IR/Constant.h"
 #include "llvm/IR/GlobalValue.h"
 #include "llvm/IR/Operator.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/ThreadLocal.h"
+#include <cstring>
+
+using namespace llvm;
+
+/// DisableUserAllocPool - Escape hatch for tools that want every User
+/// allocation to come straight from malloc (e.g. when hunting memory bugs
+/// with external tools that only understand malloc/free).
+static cl::opt<bool>
+DisableUserAllocPool("disable-user-alloc-pool", cl::Hidden, cl::init(false),
+  cl::desc("Allocate Users and their operand arrays directly from malloc"));
+
+//===----------------------------------------------------------------------===//
+//                         User Allocation Pool
+//===----------------------------------------------------------------------===//
+//
+// Instruction create/erase is one of our hottest malloc sites: passes like
+// InstCombine churn millions of instructions, and every one costs a malloc
+// for the User plus its co-allocated Use array.  The pool below carves those
+// allocations out of BumpPtrAllocator slabs and recycles freed chunks on
+// size-class free lists, so steady-state churn never reaches malloc.
+//
+// User::operator new and delete have no LLVMContext argument, so the pool
+// cannot live in LLVMContextImpl next to the type and constant arenas.
+// Instead each thread owns a pool, which gives the same isolation because a
+// context may only be used from one thread at a time.  Every chunk starts
+// with a header word recording its size class (0 for the malloc fallback),
+// which makes frees self-describing.  Pools are deliberately immortal: a
+// chunk freed on another thread, or after llvm_shutdown, just lands on the
+// freeing thread's lists while the slab that backs it stays valid.
+
+namespace {
+class UserAllocPool {
+  enum {
+    /// SizeGranularity - Chunk sizes are rounded up to this many bytes.
+    /// Must be at least sizeof(void*) so free chunks can hold a link.
+    SizeGranularity = 16,
+    /// MaxPooledSize - Requests larger than this fall back to malloc.
+    MaxPooledSize = 1024,
+    NumSizeClasses = MaxPooledSize / SizeGranularity
+  };
+
+  BumpPtrAllocator Arena;
+
+  /// FreeLists - Singly linked lists of recycled chunks, one per size class.
+  /// The link is stored in the first word of the free chunk itself.
+  void *FreeLists[NumSizeClasses];
+
+public:
+  UserAllocPool() {
+    memset(FreeLists, 0, sizeof(FreeLists));
+  }
+
+  /// Allocate - Return a chunk with Bytes of payload preceded by a header
+  /// word, or null if the request is too large for the pool.
+  void *Allocate(size_t Bytes) {
+    size_t Total = RoundUpToAlignment(Bytes + sizeof(size_t),
+                                      SizeGranularity);
+    if (Total > MaxPooledSize)
+      return 0;
+    unsigned Class = Total / SizeGranularity;
+
+    void *Chunk = FreeLists[Class-1];
+    if (Chunk)
+      FreeLists[Class-1] = *static_cast<void**>(Chunk);
+    else
+      Chunk = Arena.Allocate(Total, sizeof(size_t));
+
+    *static_cast<size_t*>(Chunk) = Class;
+    return static_cast<size_t*>(Chunk) + 1;
+  }
+
+  /// Deallocate - Return the chunk starting at the given header to its
+  /// size-class free list.
+  void Deallocate(size_t *Header, unsigned Class) {
+    assert(Class >= 1 && Class <= NumSizeClasses && "Corrupt chunk header");
+    *reinterpret_cast<void**>(Header) = FreeLists[Class-1];
+    FreeLists[Class-1] = Header;
+  }
+};
+} // end anonymous namespace
+
+static ManagedStatic<sys::ThreadLocal<UserAllocPool> > UserPoolTLS;
+
+static UserAllocPool *getUserPool() {
+  UserAllocPool *Pool = UserPoolTLS->get();
+  if (!Pool) {
+    // Never freed; see the rationale above.
+    Pool = new UserAllocPool();
+    UserPoolTLS->set(Pool);
+  }
+  return Pool;
+}
+
+/// allocateUserChunk - Allocate Bytes for a User and its Use array, from the
+/// pool when possible and from malloc otherwise.  The returned payload is
+/// preceded by a header word identifying the allocation for freeUserChunk.
+static void *allocateUserChunk(size_t Bytes) {
+  if (!DisableUserAllocPool)
+    if (void *Payload = getUserPool()->Allocate(Bytes))
+      return Payload;
+
+  size_t *Header = static_cast<size_t*>(::operator new(Bytes+sizeof(size_t)));
+  *Header = 0;
+  return Header + 1;
+}
+
+/// freeUserChunk - Release a payload returned by allocateUserChunk.
+static void freeUserChunk(void *Payload) {
+  size_t *Header = static_cast<size_t*>(Payload) - 1;
+  if (size_t Class = *Header)
+    getUserPool()->Deallocate(Header, Class);
+  else
+    ::operator delete(Header);
+}
 
 namespace llvm {
 
@@ -57,7 +176,7 @@ Use *User::allocHungoffUses(unsigned N) const {
 //===----------------------------------------------------------------------===//
 
 void *User::operator new(size_t s, unsigned Us) {
-  void *Storage = ::operator new(s + sizeof(Use) * Us);
+  void *Storage = allocateUserChunk(s + sizeof(Use) * Us);
   Use *Start = static_cast<Use*>(Storage);
   Use *End = Start + Us;
   User *Obj = reinterpret_cast<User*>(End);
@@ -76,7 +195,7 @@ void User::operator delete(void *Usr) {
   Use *Storage = static_cast<Use*>(Usr) - Start->NumOperands;
   // If there were hung-off uses, they will have been freed already and
   // NumOperands reset to 0, so here we just free the User itself.
-  ::operator delete(Storage);
+  freeUserChunk(Storage);
 }
 
 //===----------------------------------------------------------------------===//
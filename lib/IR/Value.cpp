@@ -24,6 +24,7 @@
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/ValueSymbolTable.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/EpochReclamation.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/GetElementPtrTypeIterator.h"
 #include "llvm/Support/LeakDetector.h"
@@ -87,6 +88,20 @@ Value::~Value() {
   LeakDetector::removeGarbageObject(this);
 }
 
+static ManagedStatic<sys::EpochReclamationManager> ValueReclaimer;
+
+sys::EpochReclamationManager &llvm::getValueReclamationManager() {
+  return *ValueReclaimer;
+}
+
+static void deleteRetiredValue(void *V) {
+  delete static_cast<Value*>(V);
+}
+
+void Value::deleteDeferred() {
+  ValueReclaimer->retire(this, deleteRetiredValue);
+}
+
 /// hasNUses - Return true if this Value has exactly N users.
 ///
 bool Value::hasNUses(unsigned N) const {
@@ -308,20 +323,36 @@ void Value::replaceAllUsesWith(Value *New) {
   if (HasValueHandle)
     ValueHandleBase::ValueIsRAUWd(this, New);
   
+  // First update all of the cheap users -- instructions and global values --
+  // in one tight pass, skipping over uses from uniqued constants.  Doing the
+  // two kinds of work in segregated loops keeps the common loop free of the
+  // constant re-uniquing machinery, which may cascade into recursive RAUWs
+  // and reshuffle the use list.
+  for (use_iterator UI = use_begin(), E = use_end(); UI != E;) {
+    Use &U = UI.getUse();
+    ++UI;
+    if (Constant *C = dyn_cast<Constant>(U.getUser()))
+      if (!isa<GlobalValue>(C))
+        continue;
+    U.set(New);
+  }
+
+  // Only uses from uniqued constants remain.  We cannot call
+  // replaceUsesOfWith on a constant because they are uniqued; rebuilding one
+  // fixes all of its uses of this value at once, and may create or destroy
+  // other constant users, so always restart from the list head.
   while (!use_empty()) {
     Use &U = *UseList;
-    // Must handle Constants specially, we cannot call replaceUsesOfWith on a
-    // constant because they are uniqued.
     if (Constant *C = dyn_cast<Constant>(U.getUser())) {
       if (!isa<GlobalValue>(C)) {
         C->replaceUsesOfWithOnConstant(this, New, &U);
         continue;
       }
     }
-    
+
     U.set(New);
   }
-  
+
   if (BasicBlock *BB = dyn_cast<BasicBlock>(this))
     BB->replaceSuccessorsPhiUsesWith(cast<BasicBlock>(New));
 }
@@ -509,7 +540,8 @@ void ValueHandleBase::AddToUseList() {
   if (VP.getPointer()->HasValueHandle) {
     // If this value already has a ValueHandle, then it must be in the
     // ValueHandles map already.
-    ValueHandleBase *&Entry = pImpl->ValueHandles[VP.getPointer()];
+    ValueHandleBase *&Entry = pImpl->getValueHandles(VP.getPointer())
+                                   [VP.getPointer()];
     assert(Entry != 0 && "Value doesn't have any handles?");
     AddToExistingUseList(&Entry);
     return;
@@ -520,7 +552,8 @@ void ValueHandleBase::AddToUseList() {
   // reallocate itself, which would invalidate all of the PrevP pointers that
   // point into the old table.  Handle this by checking for reallocation and
   // updating the stale pointers only if needed.
-  DenseMap<Value*, ValueHandleBase*> &Handles = pImpl->ValueHandles;
+  DenseMap<Value*, ValueHandleBase*> &Handles =
+    pImpl->getValueHandles(VP.getPointer());
   const void *OldBucketPtr = Handles.getPointerIntoBucketsArray();
 
   ValueHandleBase *&Entry = Handles[VP.getPointer()];
@@ -564,7 +597,8 @@ void ValueHandleBase::RemoveFromUseList() {
   // ValueHandle watching VP.  If so, delete its entry from the ValueHandles
   // map.
   LLVMContextImpl *pImpl = VP.getPointer()->getContext().pImpl;
-  DenseMap<Value*, ValueHandleBase*> &Handles = pImpl->ValueHandles;
+  DenseMap<Value*, ValueHandleBase*> &Handles =
+    pImpl->getValueHandles(VP.getPointer());
   if (Handles.isPointerIntoBucketsArray(PrevPtr)) {
     Handles.erase(VP.getPointer());
     VP.getPointer()->HasValueHandle = false;
@@ -578,7 +612,7 @@ void ValueHandleBase::ValueIsDeleted(Value *V) {
   // Get the linked list base, which is guaranteed to exist since the
   // HasValueHandle flag is set.
   LLVMContextImpl *pImpl = V->getContext().pImpl;
-  ValueHandleBase *Entry = pImpl->ValueHandles[V];
+  ValueHandleBase *Entry = pImpl->getValueHandles(V)[V];
   assert(Entry && "Value bit set but no entries exist");
 
   // We use a local ValueHandleBase as an iterator so that ValueHandles can add
@@ -619,7 +653,7 @@ void ValueHandleBase::ValueIsDeleted(Value *V) {
 #ifndef NDEBUG      // Only in +Asserts mode...
     dbgs() << "While deleting: " << *V->getType() << " %" << V->getName()
            << "\n";
-    if (pImpl->ValueHandles[V]->getKind() == Assert)
+    if (pImpl->getValueHandles(V)[V]->getKind() == Assert)
       llvm_unreachable("An asserting value handle still pointed to this"
                        " value!");
 
@@ -636,7 +670,7 @@ void ValueHandleBase::ValueIsRAUWd(Value *Old, Value *New) {
   // Get the linked list base, which is guaranteed to exist since the
   // HasValueHandle flag is set.
   LLVMContextImpl *pImpl = Old->getContext().pImpl;
-  ValueHandleBase *Entry = pImpl->ValueHandles[Old];
+  ValueHandleBase *Entry = pImpl->getValueHandles(Old)[Old];
 
   assert(Entry && "Value bit set but no entries exist");
 
@@ -675,7 +709,7 @@ void ValueHandleBase::ValueIsRAUWd(Value *Old, Value *New) {
   // If any new tracking or weak value handles were added while processing the
   // list, then complain about it now.
   if (Old->HasValueHandle)
-    for (Entry = pImpl->ValueHandles[Old]; Entry; Entry = Entry->Next)
+    for (Entry = pImpl->getValueHandles(Old)[Old]; Entry; Entry = Entry->Next)
       switch (Entry->getKind()) {
       case Tracking:
       case Weak:
@@ -75,6 +75,24 @@
 using namespace llvm;
 
 namespace {  // Anonymous namespace for class
+  // Check that the prerequisites for successful DominatorTree construction
+  // are satisfied.
+  static bool checkBlockTerminators(Function &F) {
+    bool Broken = false;
+
+    for (Function::iterator I = F.begin(), E = F.end(); I != E; ++I) {
+      if (I->empty() || !I->back().isTerminator()) {
+        dbgs() << "Basic Block in function '" << F.getName()
+               << "' does not have terminator!\n";
+        WriteAsOperand(dbgs(), I, true);
+        dbgs() << "\n";
+        Broken = true;
+      }
+    }
+
+    return Broken;
+  }
+
   struct PreVerifier : public FunctionPass {
     static char ID; // Pass ID, replacement for typeid
 
@@ -86,22 +104,8 @@ namespace {  // Anonymous namespace for class
       AU.setPreservesAll();
     }
 
-    // Check that the prerequisites for successful DominatorTree construction
-    // are satisfied.
     bool runOnFunction(Function &F) {
-      bool Broken = false;
-
-      for (Function::iterator I = F.begin(), E = F.end(); I != E; ++I) {
-        if (I->empty() || !I->back().isTerminator()) {
-          dbgs() << "Basic Block in function '" << F.getName() 
-                 << "' does not have terminator!\n";
-          WriteAsOperand(dbgs(), I, true);
-          dbgs() << "\n";
-          Broken = true;
-        }
-      }
-
-      if (Broken)
+      if (checkBlockTerminators(F))
         report_fatal_error("Broken module, no Basic Block terminator!");
 
       return false;
@@ -163,9 +167,12 @@ namespace {
       return abortIfBroken();
     }
 
-    bool runOnFunction(Function &F) {
-      // Get dominator information if we are being run by PassManager
-      DT = &getAnalysis<DominatorTree>();
+    /// verifyFunctionBody - Run the per-function structural checks on \p F.
+    /// This phase depends only on F itself and its dominator tree, not on any
+    /// other function, so verifyModule drives it directly one function at a
+    /// time before the serial module-level phase.
+    bool verifyFunctionBody(Function &F, DominatorTree *DomTree) {
+      DT = DomTree;
 
       Mod = F.getParent();
       if (!Context) Context = &F.getContext();
@@ -173,6 +180,12 @@ namespace {
       visit(F);
       InstsInThisBlock.clear();
       PersonalityFn = 0;
+      return Broken;
+    }
+
+    bool runOnFunction(Function &F) {
+      // Get dominator information if we are being run by PassManager
+      verifyFunctionBody(F, &getAnalysis<DominatorTree>());
 
       // We must abort before returning back to the pass manager, or else the
       // pass manager may try to run other passes on the broken module.
@@ -917,6 +930,11 @@ void Verifier::visitBasicBlock(BasicBlock &BB) {
   // Ensure that basic blocks have terminators!
   Assert1(BB.getTerminator(), "Basic Block does not have terminator!", &BB);
 
+  // The cached predecessor count must agree with the use list.
+  Assert1(BB.getNumPredecessors() ==
+          (unsigned)std::distance(pred_begin(&BB), pred_end(&BB)),
+          "Cached predecessor count is out of sync!", &BB);
+
   // Check constraints that this basic block imposes on all of the PHI nodes in
   // it.
   if (isa<PHINode>(BB.front())) {
@@ -2128,14 +2146,39 @@ bool llvm::verifyFunction(const Function &f, VerifierFailureAction action) {
 /// verifyModule - Check a module for errors, printing messages on stderr.
 /// Return true if the module is corrupt.
 ///
+/// Verification runs in two phases. First, the body of every defined function
+/// gets the per-function structural checks; each function depends only on
+/// itself and on the dominator tree computed for it. Second, a serial phase
+/// checks the module-level invariants: prototypes, global initializers,
+/// aliases, named metadata, and module flags. The per-function phase is
+/// organized as independent units of work, but runs them on one thread
+/// because the checks intern types in the LLVMContext, which has no internal
+/// locking. Driving the verifier directly also avoids setting up a
+/// PassManager per call, which matters for clients that verify between every
+/// pipeline stage.
 bool llvm::verifyModule(const Module &M, VerifierFailureAction action,
                         std::string *ErrorInfo) {
-  PassManager PM;
-  Verifier *V = new Verifier(action);
-  PM.add(V);
-  PM.run(const_cast<Module&>(M));
+  Module &Mod = const_cast<Module&>(M);
+  Verifier V(action);
+  V.doInitialization(Mod);
 
-  if (ErrorInfo && V->Broken)
-    *ErrorInfo = V->MessagesStr.str();
-  return V->Broken;
+  // Phase 1: per-function checks.
+  for (Module::iterator I = Mod.begin(), E = Mod.end(); I != E; ++I) {
+    if (I->isDeclaration())
+      continue;
+    // DominatorTree construction needs every block terminated.
+    if (checkBlockTerminators(*I))
+      report_fatal_error("Broken module, no Basic Block terminator!");
+    DominatorTree DT;
+    DT.runOnFunction(*I);
+    V.verifyFunctionBody(*I, &DT);
+    V.abortIfBroken();
+  }
+
+  // Phase 2: module-level invariants. This also handles abortIfBroken.
+  V.doFinalization(Mod);
+
+  if (ErrorInfo && V.Broken)
+    *ErrorInfo = V.MessagesStr.str();
+  return V.Broken;
 }
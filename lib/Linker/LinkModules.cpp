@@ -54,6 +54,11 @@ class TypeMapTy : public ValueMapTypeRemapper {
   /// destination modules who are getting a body from the source module.
   SmallPtrSet<StructType*, 16> DstResolvedOpaqueTypes;
 
+  /// StructuralHashes - Cached structural fingerprints of struct types.  Two
+  /// isomorphic types always have equal fingerprints, so unequal fingerprints
+  /// rule out a match without a recursive walk over the type graphs.
+  DenseMap<StructType*, unsigned> StructuralHashes;
+
 public:
   /// addTypeMapping - Indicate that the specified type in the destination
   /// module is conceptually equivalent to the specified type in the source
@@ -90,6 +95,10 @@ private:
   }
   
   bool areTypesIsomorphic(Type *DstTy, Type *SrcTy);
+
+  unsigned getStructuralHash(StructType *STy);
+  unsigned hashType(Type *Ty, SmallVectorImpl<StructType*> &Stack,
+                    DenseMap<StructType*, unsigned> &Memo, bool &Precise);
 };
 }
 
@@ -113,6 +122,93 @@ void TypeMapTy::addTypeMapping(Type *DstTy, Type *SrcTy) {
   SpeculativeTypes.clear();
 }
 
+/// hashType - Compute the structural fingerprint of Ty.  The fingerprint
+/// folds in exactly the properties areTypesIsomorphic compares, so two
+/// isomorphic types always hash identically.  Structs currently being hashed
+/// are recorded on Stack, and a back-edge to one of them is hashed by its
+/// distance down the stack, which is the same in any isomorphic image of the
+/// type graph.  Precise is cleared if an opaque struct is reachable: an
+/// opaque struct may be mapped onto anything, so its fingerprint proves
+/// nothing.  Note that the literal flag is deliberately *not* hashed: a
+/// literal source struct can legally be mapped onto a named opaque
+/// destination, and the destination stays non-literal after it is resolved.
+unsigned TypeMapTy::hashType(Type *Ty, SmallVectorImpl<StructType*> &Stack,
+                             DenseMap<StructType*, unsigned> &Memo,
+                             bool &Precise) {
+  unsigned Hash = Ty->getTypeID();
+
+  if (StructType *STy = dyn_cast<StructType>(Ty)) {
+    if (STy->isOpaque()) {
+      Precise = false;
+      return Hash;
+    }
+
+    // Hash a back-edge by how far up the stack it points instead of
+    // recursing forever.
+    for (unsigned i = 0, e = Stack.size(); i != e; ++i)
+      if (Stack[i] == STy)
+        return Hash*33 + (e - i);
+
+    // Structs can be shared by many of the types we hash; remember the ones
+    // already visited so DAG-shaped type graphs don't blow up.
+    DenseMap<StructType*, unsigned>::iterator I = Memo.find(STy);
+    if (I != Memo.end())
+      return I->second;
+
+    Hash = Hash*33 + STy->isPacked();
+    Hash = Hash*33 + STy->getNumElements();
+    Stack.push_back(STy);
+    for (unsigned i = 0, e = STy->getNumElements(); i != e; ++i)
+      Hash = Hash*33 + hashType(STy->getElementType(i), Stack, Memo, Precise);
+    Stack.pop_back();
+    Memo[STy] = Hash;
+    return Hash;
+  }
+
+  // Fold in the extra properties areTypesIsomorphic checks for each kind.
+  if (IntegerType *ITy = dyn_cast<IntegerType>(Ty))
+    return Hash*33 + ITy->getBitWidth();
+  if (PointerType *PTy = dyn_cast<PointerType>(Ty))
+    Hash = Hash*33 + PTy->getAddressSpace();
+  else if (FunctionType *FTy = dyn_cast<FunctionType>(Ty))
+    Hash = Hash*33 + FTy->isVarArg();
+  else if (ArrayType *ATy = dyn_cast<ArrayType>(Ty))
+    Hash = Hash*33 + unsigned(ATy->getNumElements());
+  else if (VectorType *VTy = dyn_cast<VectorType>(Ty))
+    Hash = Hash*33 + VTy->getNumElements();
+
+  for (unsigned i = 0, e = Ty->getNumContainedTypes(); i != e; ++i)
+    Hash = Hash*33 + hashType(Ty->getContainedType(i), Stack, Memo, Precise);
+  return Hash;
+}
+
+/// getStructuralHash - Return the structural fingerprint of STy, computing
+/// and caching it on the first request.  Returns 0 if the fingerprint is
+/// imprecise because an opaque struct is reachable from STy; imprecise
+/// fingerprints are not cached since the opaque struct may later be given a
+/// body.  Cached fingerprints never go stale: a precise fingerprint only
+/// covers non-opaque types, and only opaque structs can be mutated.
+unsigned TypeMapTy::getStructuralHash(StructType *STy) {
+  if (STy->isOpaque())
+    return 0;
+
+  DenseMap<StructType*, unsigned>::iterator I = StructuralHashes.find(STy);
+  if (I != StructuralHashes.end())
+    return I->second;
+
+  SmallVector<StructType*, 8> Stack;
+  DenseMap<StructType*, unsigned> Memo;
+  bool Precise = true;
+  unsigned Hash = hashType(STy, Stack, Memo, Precise);
+  if (!Precise)
+    return 0;
+
+  // 0 is reserved to mean "imprecise", so cached entries are always non-zero.
+  if (Hash == 0) Hash = 1;
+  StructuralHashes[STy] = Hash;
+  return Hash;
+}
+
 /// areTypesIsomorphic - Recursively walk this pair of types, returning true
 /// if they are isomorphic, false if they are not.
 bool TypeMapTy::areTypesIsomorphic(Type *DstTy, Type *SrcTy) {
@@ -155,8 +251,18 @@ bool TypeMapTy::areTypesIsomorphic(Type *DstTy, Type *SrcTy) {
       Entry = DstTy;
       return true;
     }
+
+    // Both structs are defined.  If their cached structural fingerprints are
+    // precise and disagree, the types cannot be isomorphic; this rejects
+    // name-colliding but structurally different types without the recursive
+    // walk and the speculative-mapping rollback it would cause.
+    if (unsigned SrcHash = getStructuralHash(SSTy)) {
+      unsigned DstHash = getStructuralHash(cast<StructType>(DstTy));
+      if (DstHash && SrcHash != DstHash)
+        return false;
+    }
   }
-  
+
   // If the number of subtypes disagree between the two types, then we fail.
   if (SrcTy->getNumContainedTypes() != DstTy->getNumContainedTypes())
     return false;
@@ -369,18 +475,24 @@ namespace {
     std::vector<AppendingVarInfo> AppendingVars;
     
     unsigned Mode; // Mode to treat source module.
-    
+
+    // If non-null, the only function bodies linked in from source; every
+    // other function is linked as a declaration.  Null means link all bodies.
+    const SmallPtrSet<Function*, 8> *FunctionsToImport;
+
     // Set of items not to link in from source.
     SmallPtrSet<const Value*, 16> DoNotLinkFromSource;
-    
+
     // Vector of functions to lazily link in.
     std::vector<Function*> LazilyLinkFunctions;
-    
+
   public:
     std::string ErrorMsg;
-    
-    ModuleLinker(Module *dstM, Module *srcM, unsigned mode)
-      : DstM(dstM), SrcM(srcM), Mode(mode) { }
+
+    ModuleLinker(Module *dstM, Module *srcM, unsigned mode,
+                 const SmallPtrSet<Function*, 8> *functionsToImport = 0)
+      : DstM(dstM), SrcM(srcM), Mode(mode),
+        FunctionsToImport(functionsToImport) { }
     
     bool run();
     
@@ -1205,7 +1317,17 @@ bool ModuleLinker::run() {
   for (Module::iterator SF = SrcM->begin(), E = SrcM->end(); SF != E; ++SF) {
     // Skip if not linking from source.
     if (DoNotLinkFromSource.count(SF)) continue;
-    
+
+    // If the caller restricted which bodies to import, everything else stays
+    // behind as a plain declaration; in particular the body is never
+    // materialized.
+    if (FunctionsToImport && !FunctionsToImport->count(SF)) {
+      Function *DF = cast<Function>(ValueMap[SF]);
+      if (DF->isDeclaration() && !DF->hasExternalWeakLinkage())
+        DF->setLinkage(GlobalValue::ExternalLinkage);
+      continue;
+    }
+
     // Skip if no body (function is external) or materialize.
     if (SF->isDeclaration()) {
       if (!SF->isMaterializable())
@@ -1242,9 +1364,18 @@ bool ModuleLinker::run() {
       
       Function *SF = *I;
       Function *DF = cast<Function>(ValueMap[SF]);
-      
+
       if (!DF->use_empty()) {
-        
+
+        // Honor the import restriction here too: a used but unselected
+        // lazily-linked function is left behind as a plain declaration.
+        if (FunctionsToImport && !FunctionsToImport->count(SF)) {
+          if (DF->isDeclaration() && !DF->hasExternalWeakLinkage())
+            DF->setLinkage(GlobalValue::ExternalLinkage);
+          *I = 0;
+          continue;
+        }
+
         // Materialize if necessary.
         if (SF->isDeclaration()) {
           if (!SF->isMaterializable())
@@ -1295,9 +1426,19 @@ bool ModuleLinker::run() {
 /// error occurs, true is returned and ErrorMsg (if not null) is set to indicate
 /// the problem.  Upon failure, the Dest module could be in a modified state,
 /// and shouldn't be relied on to be consistent.
-bool Linker::LinkModules(Module *Dest, Module *Src, unsigned Mode, 
+bool Linker::LinkModules(Module *Dest, Module *Src, unsigned Mode,
+                         std::string *ErrorMsg) {
+  return LinkModules(Dest, Src, Mode, 0, ErrorMsg);
+}
+
+/// LinkModules - This variant restricts which function bodies are linked in
+/// from Src: only functions in FunctionsToImport get their bodies, every
+/// other function is linked as a declaration.  A null set links everything,
+/// exactly like the variant above.
+bool Linker::LinkModules(Module *Dest, Module *Src, unsigned Mode,
+                         const SmallPtrSet<Function*, 8> *FunctionsToImport,
                          std::string *ErrorMsg) {
-  ModuleLinker TheLinker(Dest, Src, Mode);
+  ModuleLinker TheLinker(Dest, Src, Mode, FunctionsToImport);
   if (TheLinker.run()) {
     if (ErrorMsg) *ErrorMsg = TheLinker.ErrorMsg;
     return true;
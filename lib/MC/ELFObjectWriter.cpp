@@ -570,6 +570,21 @@ void ELFObjectWriter::WriteSymbol(MCDataFragment *SymtabF,
                    Size, Other, MSD.SectionIndex, IsReserved);
 }
 
+/// WantsSectionSymbol - Return true if this section gets an STT_SECTION
+/// entry in the symbol table.
+static bool WantsSectionSymbol(const MCSectionELF &Section) {
+  switch (Section.getType()) {
+  case ELF::SHT_RELA:
+  case ELF::SHT_REL:
+  case ELF::SHT_STRTAB:
+  case ELF::SHT_SYMTAB:
+  case ELF::SHT_SYMTAB_SHNDX:
+    return false;
+  default:
+    return true;
+  }
+}
+
 void ELFObjectWriter::WriteSymbolTable(MCDataFragment *SymtabF,
                                        MCDataFragment *ShndxF,
                                        const MCAssembler &Asm,
@@ -581,6 +596,20 @@ void ELFObjectWriter::WriteSymbolTable(MCDataFragment *SymtabF,
 
   // FIXME: Make sure the start of the symbol table is aligned.
 
+  // The number of entries is known up front: the null entry, one entry per
+  // emitted symbol and one per regular section.  Size the fragments once so
+  // the entry writers below append into pre-allocated space.
+  unsigned NumSectionSymbols = 0;
+  for (MCAssembler::const_iterator i = Asm.begin(), e = Asm.end(); i != e; ++i)
+    if (WantsSectionSymbol(static_cast<const MCSectionELF&>(i->getSection())))
+      ++NumSectionSymbols;
+  size_t NumEntries = 1 + LocalSymbolData.size() + NumSectionSymbols +
+                      ExternalSymbolData.size() + UndefinedSymbolData.size();
+  unsigned EntrySize = is64Bit() ? ELF::SYMENTRY_SIZE64 : ELF::SYMENTRY_SIZE32;
+  SymtabF->getContents().reserve(NumEntries * EntrySize);
+  if (ShndxF)
+    ShndxF->getContents().reserve(NumEntries * 4);
+
   // The first entry is the undefined symbol entry.
   WriteSymbolEntry(SymtabF, ShndxF, 0, 0, 0, 0, 0, 0, false);
 
@@ -596,11 +625,7 @@ void ELFObjectWriter::WriteSymbolTable(MCDataFragment *SymtabF,
        ++i) {
     const MCSectionELF &Section =
       static_cast<const MCSectionELF&>(i->getSection());
-    if (Section.getType() == ELF::SHT_RELA ||
-        Section.getType() == ELF::SHT_REL ||
-        Section.getType() == ELF::SHT_STRTAB ||
-        Section.getType() == ELF::SHT_SYMTAB ||
-        Section.getType() == ELF::SHT_SYMTAB_SHNDX)
+    if (!WantsSectionSymbol(Section))
       continue;
     WriteSymbolEntry(SymtabF, ShndxF, 0, ELF::STT_SECTION, 0, 0,
                      ELF::STV_DEFAULT, SectionIndexMap.lookup(&Section),
@@ -874,6 +899,17 @@ void ELFObjectWriter::ComputeSymbolTable(MCAssembler &Asm,
   StringMap<uint64_t> StringIndexMap;
   StringTable += '\x00';
 
+  // Pre-size the string table; the sum of all symbol name lengths is an
+  // upper bound (duplicate and filtered names make it smaller), so the
+  // appends below never have to grow it.
+  {
+    size_t StrtabSize = 1;
+    for (MCAssembler::symbol_iterator it = Asm.symbol_begin(),
+           ie = Asm.symbol_end(); it != ie; ++it)
+      StrtabSize += it->getSymbol().getName().size() + 1;
+    StringTable.reserve(StrtabSize);
+  }
+
   // FIXME: We could optimize suffixes in strtab in the same way we
   // optimize them in shstrtab.
 
@@ -1055,6 +1091,14 @@ void ELFObjectWriter::WriteRelocationsFragment(const MCAssembler &Asm,
   // (e.g., MIPS) have additional constraints.
   TargetObjectWriter->sortRelocs(Asm, Relocs);
 
+  // All entries have a fixed size, so allocate the fragment in one step.
+  unsigned EntrySize;
+  if (hasRelocationAddend())
+    EntrySize = is64Bit() ? sizeof(ELF::Elf64_Rela) : sizeof(ELF::Elf32_Rela);
+  else
+    EntrySize = is64Bit() ? sizeof(ELF::Elf64_Rel) : sizeof(ELF::Elf32_Rel);
+  F->getContents().reserve(Relocs.size() * EntrySize);
+
   for (unsigned i = 0, e = Relocs.size(); i != e; ++i) {
     ELFRelocationEntry entry = Relocs[e - i - 1];
 
@@ -1549,6 +1593,11 @@ void ELFObjectWriter::WriteObject(MCAssembler &Asm,
     FileOff += GetSectionFileSize(Layout, SD);
   }
 
+  // The total file size is now known, so streams with a growable backing
+  // store (e.g. the MCJIT's in-memory objects) can allocate it in one step
+  // and the sequential writes below become plain stores.
+  OS.reserveExtraSpace(FileOff);
+
   // Write out the ELF header ...
   WriteHeader(Asm, SectionHeaderOffset, NumSections + 1);
 
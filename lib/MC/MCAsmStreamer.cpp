@@ -78,6 +78,15 @@ public:
       UseDwarfDirectory(useDwarfDirectory) {
     if (InstPrinter && IsVerboseAsm)
       InstPrinter->setCommentStream(CommentStream);
+
+    // Nothing is ever padded to the comment column unless we are emitting
+    // verbose assembly, so tell the stream not to scan every byte for column
+    // tracking, and use a large buffer to cut down on flushes to the
+    // underlying (unbuffered) stream.
+    if (!IsVerboseAsm) {
+      OS.setColumnTracking(false);
+      OS.SetBufferSize(1 << 20);
+    }
   }
   ~MCAsmStreamer() {}
 
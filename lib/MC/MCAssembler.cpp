@@ -46,6 +46,8 @@ STATISTIC(EmittedFillFragments,
           "Number of emitted assembler fragments - fill");
 STATISTIC(EmittedOrgFragments,
           "Number of emitted assembler fragments - org");
+STATISTIC(EncodingMemoHits, "Number of instruction encodings served from "
+          "the memo");
 STATISTIC(evaluateFixup, "Number of evaluated fixups");
 STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
@@ -284,12 +286,78 @@ void MCAssembler::reset() {
   SubsectionsViaSymbols = false;
   ELFHeaderEFlags = 0;
 
+  flushEncodingMemo();
+
   // reset objects owned by us
   getBackend().reset();
   getEmitter().reset();
   getWriter().reset();
 }
 
+/// Build the memo key for \p Inst, returning false if the instruction is not
+/// memoizable.  Expression and sub-instruction operands are resolved against
+/// context the key cannot capture, so only register and immediate operands
+/// qualify.
+static bool profileInstruction(const MCInst &Inst, FoldingSetNodeID &ID) {
+  ID.AddInteger(Inst.getOpcode());
+  for (unsigned i = 0, e = Inst.getNumOperands(); i != e; ++i) {
+    const MCOperand &Op = Inst.getOperand(i);
+    if (Op.isReg()) {
+      ID.AddBoolean(true);
+      ID.AddInteger(Op.getReg());
+    } else if (Op.isImm()) {
+      ID.AddBoolean(false);
+      ID.AddInteger((uint64_t)Op.getImm());
+    } else
+      return false;
+  }
+  return true;
+}
+
+void MCAssembler::encodeInstruction(const MCInst &Inst,
+                                    SmallVectorImpl<char> &Code,
+                                    SmallVectorImpl<MCFixup> &Fixups) {
+  FoldingSetNodeID ID;
+  if (!profileInstruction(Inst, ID)) {
+    raw_svector_ostream VecOS(Code);
+    getEmitter().EncodeInstruction(Inst, VecOS, Fixups);
+    return;
+  }
+
+  void *InsertPos = 0;
+  if (MCMemoizedEncoding *ME =
+        EncodingMemo.FindNodeOrInsertPos(ID, InsertPos)) {
+    ++stats::EncodingMemoHits;
+    Code.append(ME->Code, ME->Code + ME->CodeSize);
+    return;
+  }
+
+  size_t Start = Code.size();
+  {
+    raw_svector_ostream VecOS(Code);
+    getEmitter().EncodeInstruction(Inst, VecOS, Fixups);
+  }
+
+  // A fixup makes the bytes a function of layout, not just of the MCInst;
+  // don't memoize those.
+  if (!Fixups.empty())
+    return;
+
+  unsigned Size = Code.size() - Start;
+  char *Bytes = EncodingMemoAllocator.Allocate<char>(Size);
+  memcpy(Bytes, Code.begin() + Start, Size);
+  MCMemoizedEncoding *ME = new (EncodingMemoAllocator)
+    MCMemoizedEncoding(ID.Intern(EncodingMemoAllocator), Bytes, Size);
+  EncodingMemo.InsertNode(ME, InsertPos);
+}
+
+void MCAssembler::flushEncodingMemo() {
+  // The nodes are bump allocated and trivially destructible; dropping the
+  // allocator frees them all.
+  EncodingMemo.clear();
+  EncodingMemoAllocator.Reset();
+}
+
 bool MCAssembler::isSymbolLinkerVisible(const MCSymbol &Symbol) const {
   // Non-temporary labels should always be visible to the linker.
   if (!Symbol.isTemporary())
@@ -749,8 +817,37 @@ void MCAssembler::Finish() {
       iFrag->setLayoutOrder(FragmentIndex++);
   }
 
+  // Gather the fragments that can change size during relaxation, so that the
+  // relaxation passes below revisit only those instead of re-walking every
+  // fragment of every section. Most fragments are plain data and can never
+  // relax.
+  std::vector<std::vector<MCFragment *> > Relaxable(SectionIndex);
+  for (iterator it = begin(), ie = end(); it != ie; ++it) {
+    std::vector<MCFragment *> &SecRelaxable = Relaxable[it->getOrdinal()];
+    for (MCSectionData::iterator iFrag = it->begin(), iFragEnd = it->end();
+         iFrag != iFragEnd; ++iFrag) {
+      switch (iFrag->getKind()) {
+      default:
+        break;
+      case MCFragment::FT_Relaxable:
+        assert(!getRelaxAll() &&
+               "Did not expect a MCRelaxableFragment in RelaxAll mode");
+        // Instructions the backend can never relax are not candidates.
+        if (getBackend().mayNeedRelaxation(
+              cast<MCRelaxableFragment>(iFrag)->getInst()))
+          SecRelaxable.push_back(iFrag);
+        break;
+      case MCFragment::FT_Dwarf:
+      case MCFragment::FT_DwarfFrame:
+      case MCFragment::FT_LEB:
+        SecRelaxable.push_back(iFrag);
+        break;
+      }
+    }
+  }
+
   // Layout until everything fits.
-  while (layoutOnce(Layout))
+  while (layoutOnce(Layout, Relaxable))
     continue;
 
   DEBUG_WITH_TYPE("mc-dump", {
@@ -904,41 +1001,50 @@ bool MCAssembler::relaxDwarfCallFrameFragment(MCAsmLayout &Layout,
   return OldSize != Data.size();
 }
 
-bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
+bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout,
+                                    std::vector<MCFragment *> &Relaxable) {
   // Holds the first fragment which needed relaxing during this layout. It will
   // remain NULL if none were relaxed.
   // When a fragment is relaxed, all the fragments following it should get
   // invalidated because their offset is going to change.
   MCFragment *FirstRelaxedFragment = NULL;
 
-  // Attempt to relax all the fragments in the section.
-  for (MCSectionData::iterator I = SD.begin(), IE = SD.end(); I != IE; ++I) {
-    // Check if this is a fragment that needs relaxation.
+  // Attempt to relax the candidate fragments, in layout order. Instructions
+  // that relaxed into a form the backend can never grow again are dropped
+  // from the candidate list.
+  unsigned Kept = 0;
+  for (unsigned i = 0, e = Relaxable.size(); i != e; ++i) {
+    MCFragment *F = Relaxable[i];
     bool RelaxedFrag = false;
-    switch(I->getKind()) {
+    bool Keep = true;
+    switch (F->getKind()) {
     default:
+      llvm_unreachable("Unexpected fragment kind in relaxation candidates!");
+    case MCFragment::FT_Relaxable: {
+      MCRelaxableFragment &RF = *cast<MCRelaxableFragment>(F);
+      RelaxedFrag = relaxInstruction(Layout, RF);
+      Keep = getBackend().mayNeedRelaxation(RF.getInst());
       break;
-    case MCFragment::FT_Relaxable:
-      assert(!getRelaxAll() &&
-             "Did not expect a MCRelaxableFragment in RelaxAll mode");
-      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(I));
-      break;
+    }
     case MCFragment::FT_Dwarf:
       RelaxedFrag = relaxDwarfLineAddr(Layout,
-                                       *cast<MCDwarfLineAddrFragment>(I));
+                                       *cast<MCDwarfLineAddrFragment>(F));
       break;
     case MCFragment::FT_DwarfFrame:
       RelaxedFrag =
         relaxDwarfCallFrameFragment(Layout,
-                                    *cast<MCDwarfCallFrameFragment>(I));
+                                    *cast<MCDwarfCallFrameFragment>(F));
       break;
     case MCFragment::FT_LEB:
-      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(I));
+      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(F));
       break;
     }
     if (RelaxedFrag && !FirstRelaxedFragment)
-      FirstRelaxedFragment = I;
+      FirstRelaxedFragment = F;
+    if (Keep)
+      Relaxable[Kept++] = F;
   }
+  Relaxable.resize(Kept);
   if (FirstRelaxedFragment) {
     Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
     return true;
@@ -946,13 +1052,17 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
   return false;
 }
 
-bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
+bool MCAssembler::layoutOnce(MCAsmLayout &Layout,
+                             std::vector<std::vector<MCFragment *> > &
+                               Relaxable) {
   ++stats::RelaxationSteps;
 
   bool WasRelaxed = false;
   for (iterator it = begin(), ie = end(); it != ie; ++it) {
-    MCSectionData &SD = *it;
-    while (layoutSectionOnce(Layout, SD))
+    std::vector<MCFragment *> &SecRelaxable = Relaxable[it->getOrdinal()];
+    if (SecRelaxable.empty())
+      continue;
+    while (layoutSectionOnce(Layout, SecRelaxable))
       WasRelaxed = true;
   }
 
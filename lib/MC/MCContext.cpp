@@ -36,11 +36,13 @@ MCContext::MCContext(const MCAsmInfo &mai, const MCRegisterInfo &mri,
                      bool DoAutoReset) :
   SrcMgr(mgr), MAI(mai), MRI(mri), MOFI(mofi),
   Allocator(), Symbols(Allocator), UsedNames(Allocator),
+  MCDwarfDirIndex(Allocator), MCDwarfFileNames(Allocator),
   NextUniqueID(0),
   CompilationDir(llvm::sys::Path::GetCurrentDirectory().str()),
   CurrentDwarfLoc(0,0,0,DWARF2_FLAG_IS_STMT,0,0), 
   DwarfLocSeen(false), GenDwarfForAssembly(false), GenDwarfFileNumber(0),
-  AllowTemporaryLabels(true), DwarfCompileUnitID(0), AutoReset(DoAutoReset) {
+  AllowTemporaryLabels(true), UseNamesOnTempLabels(true),
+  DwarfCompileUnitID(0), AutoReset(DoAutoReset) {
 
   MachOUniquingMap = 0;
   ELFUniquingMap = 0;
@@ -75,6 +77,10 @@ MCContext::~MCContext() {
 void MCContext::reset() {
   UsedNames.clear();
   Symbols.clear();
+  // The dwarf string maps must be emptied before the allocator holding their
+  // key bytes is reset.
+  MCDwarfDirIndex.clear();
+  MCDwarfFileNames.clear();
   Allocator.Reset();
   Instances.clear();
   MCDwarfFiles.clear();
@@ -107,9 +113,9 @@ void MCContext::reset() {
 MCSymbol *MCContext::GetOrCreateSymbol(StringRef Name) {
   assert(!Name.empty() && "Normal symbols cannot be unnamed!");
 
-  // Do the lookup and get the entire StringMapEntry.  We want access to the
-  // key if we are creating the entry.
-  StringMapEntry<MCSymbol*> &Entry = Symbols.GetOrCreateValue(Name);
+  // Do the lookup and get the entry.  The entry reference stays valid across
+  // CreateSymbol because that only inserts into UsedNames, never Symbols.
+  SymbolTable::EntryTy &Entry = Symbols.GetOrCreateValue(Name);
   MCSymbol *Sym = Entry.getValue();
 
   if (Sym)
@@ -152,6 +158,12 @@ MCSymbol *MCContext::GetOrCreateSymbol(const Twine &Name) {
 }
 
 MCSymbol *MCContext::CreateTempSymbol() {
+  // If the emitter never needs names on temporaries, skip name formatting
+  // and the string table entirely.  Unnamed temporaries cannot collide with
+  // anything, so there is no uniquing to do either.
+  if (AllowTemporaryLabels && !UseNamesOnTempLabels)
+    return new (*this) MCSymbol(StringRef(), /*isTemporary=*/true);
+
   SmallString<128> NameSV;
   raw_svector_ostream(NameSV)
     << MAI.getPrivateGlobalPrefix() << "tmp" << NextUniqueID++;
@@ -325,35 +337,31 @@ unsigned MCContext::GetDwarfFile(StringRef Directory, StringRef FileName,
     }
   }
 
-  // Find or make a entry in the MCDwarfDirs vector for this Directory.
-  // Capture directory name.
+  // Find or make a entry in the MCDwarfDirs vector for this Directory, via
+  // the hash index.  The map's key storage lives in the context allocator, so
+  // the vector can point straight at it.
   unsigned DirIndex;
   if (Directory.empty()) {
     // For FileNames with no directories a DirIndex of 0 is used.
     DirIndex = 0;
   } else {
-    DirIndex = 0;
-    for (unsigned End = MCDwarfDirs.size(); DirIndex < End; DirIndex++) {
-      if (Directory == MCDwarfDirs[DirIndex])
-        break;
-    }
-    if (DirIndex >= MCDwarfDirs.size()) {
-      char *Buf = static_cast<char *>(Allocate(Directory.size()));
-      memcpy(Buf, Directory.data(), Directory.size());
-      MCDwarfDirs.push_back(StringRef(Buf, Directory.size()));
+    StringMapEntry<unsigned> &Dir = MCDwarfDirIndex.GetOrCreateValue(Directory);
+    if (!Dir.getValue()) {
+      MCDwarfDirs.push_back(Dir.getKey());
+      // The DirIndex is one based, as DirIndex of 0 is used for FileNames with
+      // no directories.  MCDwarfDirs[] is unlike MCDwarfFiles[] in that the
+      // directory names are stored at MCDwarfDirs[DirIndex-1] where FileNames
+      // are stored at MCDwarfFiles[FileNumber].Name .
+      Dir.setValue(MCDwarfDirs.size());
     }
-    // The DirIndex is one based, as DirIndex of 0 is used for FileNames with
-    // no directories.  MCDwarfDirs[] is unlike MCDwarfFiles[] in that the
-    // directory names are stored at MCDwarfDirs[DirIndex-1] where FileNames
-    // are stored at MCDwarfFiles[FileNumber].Name .
-    DirIndex++;
+    DirIndex = Dir.getValue();
   }
 
   // Now make the MCDwarfFile entry and place it in the slot in the MCDwarfFiles
-  // vector.
-  char *Buf = static_cast<char *>(Allocate(FileName.size()));
-  memcpy(Buf, FileName.data(), FileName.size());
-  File = new (*this) MCDwarfFile(StringRef(Buf, FileName.size()), DirIndex);
+  // vector.  The name is interned; duplicate basenames across file numbers
+  // share one copy of the bytes.
+  StringRef Name = MCDwarfFileNames.GetOrCreateValue(FileName).getKey();
+  File = new (*this) MCDwarfFile(Name, DirIndex);
 
   // return the allocated FileNumber.
   return FileNumber;
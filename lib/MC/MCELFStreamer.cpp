@@ -97,9 +97,11 @@ void MCELFStreamer::EmitDebugLabel(MCSymbol *Symbol) {
 void MCELFStreamer::EmitAssemblerFlag(MCAssemblerFlag Flag) {
   switch (Flag) {
   case MCAF_SyntaxUnified: return; // no-op here.
-  case MCAF_Code16: return; // Change parsing mode; no-op here.
-  case MCAF_Code32: return; // Change parsing mode; no-op here.
-  case MCAF_Code64: return; // Change parsing mode; no-op here.
+  case MCAF_Code16: // Change parsing mode; the encodings memoized under the
+  case MCAF_Code32: // old mode are no longer valid.
+  case MCAF_Code64:
+    getAssembler().flushEncodingMemo();
+    return;
   case MCAF_SubsectionsViaSymbols:
     getAssembler().setSubsectionsViaSymbols(true);
     return;
@@ -359,9 +361,7 @@ void MCELFStreamer::EmitInstToData(const MCInst &Inst) {
   MCAssembler &Assembler = getAssembler();
   SmallVector<MCFixup, 4> Fixups;
   SmallString<256> Code;
-  raw_svector_ostream VecOS(Code);
-  Assembler.getEmitter().EncodeInstruction(Inst, VecOS, Fixups);
-  VecOS.flush();
+  Assembler.encodeInstruction(Inst, Code, Fixups);
 
   for (unsigned i = 0, e = Fixups.size(); i != e; ++i)
     fixSymbolsInTLSFixups(Fixups[i].getValue());
@@ -492,6 +492,10 @@ MCStreamer *llvm::createELFStreamer(MCContext &Context, MCAsmBackend &MAB,
                                     raw_ostream &OS, MCCodeEmitter *CE,
                                     bool RelaxAll, bool NoExecStack) {
   MCELFStreamer *S = new MCELFStreamer(Context, MAB, OS, CE);
+  // The ELF object writer resolves temporary labels to section-relative
+  // offsets and never puts them in the symbol table, so they do not need
+  // names here.
+  Context.setUseNamesOnTempLabels(false);
   if (RelaxAll)
     S->getAssembler().setRelaxAll(true);
   if (NoExecStack)
@@ -57,8 +57,20 @@ MCFragment *MCObjectStreamer::getCurrentFragment() const {
   return 0;
 }
 
+/// Cap on the size of a single data fragment's contents.  Fragments already
+/// chain in their section and the object writers stream them out one at a
+/// time, so starting a new block once the current one is full keeps
+/// SmallVector growth (and its realloc copies) bounded for megabyte-scale
+/// sections.
+static const size_t DataFragmentBlockSize = 64 * 1024;
+
 MCDataFragment *MCObjectStreamer::getOrCreateDataFragment() const {
   MCDataFragment *F = dyn_cast_or_null<MCDataFragment>(getCurrentFragment());
+  // Start a new block when the current one is full, but never split a
+  // bundle-locked group: all of its instructions must share one fragment.
+  if (F && F->getContents().size() >= DataFragmentBlockSize &&
+      !getCurrentSectionData()->isBundleLocked())
+    F = 0;
   if (!F)
     F = new MCDataFragment(getCurrentSectionData());
   return F;
@@ -218,9 +230,7 @@ void MCObjectStreamer::EmitInstToFragment(const MCInst &Inst) {
     new MCRelaxableFragment(Inst, getCurrentSectionData());
 
   SmallString<128> Code;
-  raw_svector_ostream VecOS(Code);
-  getAssembler().getEmitter().EncodeInstruction(Inst, VecOS, IF->getFixups());
-  VecOS.flush();
+  getAssembler().encodeInstruction(Inst, Code, IF->getFixups());
   IF->getContents().append(Code.begin(), Code.end());
 }
 
@@ -205,9 +205,7 @@ void MCPureStreamer::EmitInstToFragment(const MCInst &Inst) {
   // able to get away with not storing any extra data in the MCInst.
   SmallVector<MCFixup, 4> Fixups;
   SmallString<256> Code;
-  raw_svector_ostream VecOS(Code);
-  getAssembler().getEmitter().EncodeInstruction(Inst, VecOS, Fixups);
-  VecOS.flush();
+  getAssembler().encodeInstruction(Inst, Code, Fixups);
 
   IF->getContents() = Code;
   IF->getFixups() = Fixups;
@@ -218,9 +216,7 @@ void MCPureStreamer::EmitInstToData(const MCInst &Inst) {
 
   SmallVector<MCFixup, 4> Fixups;
   SmallString<256> Code;
-  raw_svector_ostream VecOS(Code);
-  getAssembler().getEmitter().EncodeInstruction(Inst, VecOS, Fixups);
-  VecOS.flush();
+  getAssembler().encodeInstruction(Inst, Code, Fixups);
 
   // Add the fixups and data.
   for (unsigned i = 0, e = Fixups.size(); i != e; ++i) {
@@ -286,15 +286,9 @@ uint64_t SubtargetFeatures::getFeatureBits(const StringRef CPU,
     const SubtargetFeatureKV *CPUEntry = Find(CPU, CPUTable, CPUTableSize);
     // If there is a match
     if (CPUEntry) {
-      // Set base feature bits
+      // Set base feature bits. TableGen already folded the transitive
+      // closure of implied features into the processor's table entry.
       Bits = CPUEntry->Value;
-
-      // Set the feature implied by this CPU feature, if any.
-      for (size_t i = 0; i < FeatureTableSize; ++i) {
-        const SubtargetFeatureKV &FE = FeatureTable[i];
-        if (CPUEntry->Value & FE.Value)
-          SetImpliedBits(Bits, &FE, FeatureTable, FeatureTableSize);
-      }
     } else {
       errs() << "'" << CPU
              << "' is not a recognized processor for this target"
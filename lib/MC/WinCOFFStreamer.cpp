@@ -85,9 +85,7 @@ private:
 
     SmallVector<MCFixup, 4> Fixups;
     SmallString<256> Code;
-    raw_svector_ostream VecOS(Code);
-    getAssembler().getEmitter().EncodeInstruction(Inst, VecOS, Fixups);
-    VecOS.flush();
+    getAssembler().encodeInstruction(Inst, Code, Fixups);
 
     // Add the fixups and data.
     for (unsigned i = 0, e = Fixups.size(); i != e; ++i) {
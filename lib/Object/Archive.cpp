@@ -102,7 +102,7 @@ error_code Archive::Child::getAsBinary(OwningPtr<Binary> &Result) const {
 }
 
 Archive::Archive(MemoryBuffer *source, error_code &ec)
-  : Binary(Binary::ID_Archive, source) {
+  : Binary(Binary::ID_Archive, source), SymbolIndexBuilt(false) {
   // Check for sufficient magic.
   if (!source || source->getBufferSize()
                  < (8 + sizeof(ArchiveMemberHeader) + 2) // Smallest archive.
@@ -283,19 +283,32 @@ Archive::symbol_iterator Archive::end_symbols() const {
 }
 
 Archive::child_iterator Archive::findSym(StringRef name) const {
-  Archive::symbol_iterator bs = begin_symbols();
-  Archive::symbol_iterator es = end_symbols();
-  Archive::child_iterator result;
-  
-  StringRef symname;
-  for (; bs != es; ++bs) {
-    if (bs->getName(symname))
-        return end_children();
-    if (symname == name) {
-      if (bs->getMember(result))
+  // Build the name lookup map on the first query.  One walk over the symbol
+  // table here turns every subsequent lookup into a single hash probe.
+  if (!SymbolIndexBuilt) {
+    Archive::symbol_iterator bs = begin_symbols();
+    Archive::symbol_iterator es = end_symbols();
+
+    StringRef symname;
+    for (; bs != es; ++bs) {
+      if (bs->getName(symname))
         return end_children();
-      return result;
+      // GetOrCreateValue keeps the first entry for a duplicated name, which
+      // matches what the linear scan used to find.
+      SymbolIndexMap.GetOrCreateValue(
+          symname, std::make_pair(bs->SymbolIndex, bs->StringIndex));
     }
+    SymbolIndexBuilt = true;
   }
-  return end_children();
+
+  StringMap<std::pair<uint32_t, uint32_t> >::const_iterator I =
+    SymbolIndexMap.find(name);
+  if (I == SymbolIndexMap.end())
+    return end_children();
+
+  Symbol sym(this, I->second.first, I->second.second);
+  Archive::child_iterator result;
+  if (sym.getMember(result))
+    return end_children();
+  return result;
 }
@@ -97,7 +97,10 @@ error_code object::createBinary(MemoryBuffer *Source,
 
 error_code object::createBinary(StringRef Path, OwningPtr<Binary> &Result) {
   OwningPtr<MemoryBuffer> File;
-  if (error_code ec = MemoryBuffer::getFileOrSTDIN(Path, File))
+  // Object files and archives are read roughly front to back; ask the
+  // operating system for sequential readahead.
+  if (error_code ec = MemoryBuffer::getFileOrSTDIN(Path, File, -1,
+                                               MemoryBuffer::AccessSequential))
     return ec;
   return createBinary(File.take(), Result);
 }
@@ -27,6 +27,24 @@ ObjectFile::ObjectFile(unsigned int Type, MemoryBuffer *source, error_code &ec)
   : Binary(Type, source) {
 }
 
+error_code ObjectFile::readSymbols(SmallVectorImpl<SymbolDesc> &Syms,
+                                   bool Dynamic) const {
+  error_code ec;
+  symbol_iterator I = Dynamic ? begin_dynamic_symbols() : begin_symbols();
+  symbol_iterator E = Dynamic ? end_dynamic_symbols() : end_symbols();
+  for (; I != E; I.increment(ec)) {
+    if (ec) return ec;
+    SymbolDesc D;
+    if ((ec = I->getFlags(D.Flags))) return ec;
+    if ((ec = I->getName(D.Name))) return ec;
+    if ((ec = I->getAddress(D.Address))) return ec;
+    if ((ec = I->getSize(D.Size))) return ec;
+    if ((ec = I->getNMTypeChar(D.TypeChar))) return ec;
+    Syms.push_back(D);
+  }
+  return object_error::success;
+}
+
 ObjectFile *ObjectFile::createObjectFile(MemoryBuffer *Object) {
   if (!Object || Object->getBufferSize() < 64)
     return 0;
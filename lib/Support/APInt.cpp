@@ -28,6 +28,16 @@
 #include <limits>
 using namespace llvm;
 
+/// Some hosts provide an unsigned integer type twice the width of a word
+/// (e.g. __uint128_t on 64-bit GCC and Clang targets). The multi-word
+/// kernels below use it to form full 64x64->128 products and to fold carry
+/// propagation into one wide accumulation per word instead of composing
+/// half-word products; the half-word code is kept as the portable fallback.
+#if defined(__SIZEOF_INT128__)
+#define APINT_HAS_DOUBLEWORD 1
+typedef __uint128_t DoubleWord;
+#endif
+
 /// A utility function for allocating memory, checking for allocation failures,
 /// and ensuring the contents are zeroed.
 inline static uint64_t* getClearedMemory(unsigned numWords) {
@@ -236,6 +246,15 @@ APInt& APInt::operator--() {
 /// @brief General addition of 64-bit integer arrays
 static bool add(uint64_t *dest, const uint64_t *x, const uint64_t *y,
                 unsigned len) {
+#ifdef APINT_HAS_DOUBLEWORD
+  uint64_t carry = 0;
+  for (unsigned i = 0; i < len; ++i) {
+    DoubleWord result = (DoubleWord)x[i] + y[i] + carry;
+    dest[i] = (uint64_t)result;
+    carry = (uint64_t)(result >> 64);
+  }
+  return carry;
+#else
   bool carry = false;
   for (unsigned i = 0; i< len; ++i) {
     uint64_t limit = std::min(x[i],y[i]); // must come first in case dest == x
@@ -243,6 +262,7 @@ static bool add(uint64_t *dest, const uint64_t *x, const uint64_t *y,
     carry = dest[i] < limit || (carry && dest[i] == limit);
   }
   return carry;
+#endif
 }
 
 /// Adds the RHS APint to this APInt.
@@ -263,6 +283,15 @@ APInt& APInt::operator+=(const APInt& RHS) {
 /// @brief Generalized subtraction of 64-bit integer arrays.
 static bool sub(uint64_t *dest, const uint64_t *x, const uint64_t *y,
                 unsigned len) {
+#ifdef APINT_HAS_DOUBLEWORD
+  uint64_t borrow = 0;
+  for (unsigned i = 0; i < len; ++i) {
+    DoubleWord result = (DoubleWord)x[i] - y[i] - borrow;
+    dest[i] = (uint64_t)result;
+    borrow = (uint64_t)(result >> 64) & 1;
+  }
+  return borrow;
+#else
   bool borrow = false;
   for (unsigned i = 0; i < len; ++i) {
     uint64_t x_tmp = borrow ? x[i] - 1 : x[i];
@@ -270,6 +299,7 @@ static bool sub(uint64_t *dest, const uint64_t *x, const uint64_t *y,
     dest[i] = x_tmp - y[i];
   }
   return borrow;
+#endif
 }
 
 /// Subtracts the RHS APInt from this APInt
@@ -289,6 +319,17 @@ APInt& APInt::operator-=(const APInt& RHS) {
 /// @returns the carry out of the multiplication.
 /// @brief Multiply a multi-digit APInt by a single digit (64-bit) integer.
 static uint64_t mul_1(uint64_t dest[], uint64_t x[], unsigned len, uint64_t y) {
+#ifdef APINT_HAS_DOUBLEWORD
+  // x[i] * y + carry cannot overflow two words:
+  // (2^64-1)^2 + (2^64-1) < 2^128.
+  uint64_t carry = 0;
+  for (unsigned i = 0; i < len; ++i) {
+    DoubleWord result = (DoubleWord)x[i] * y + carry;
+    dest[i] = (uint64_t)result;
+    carry = (uint64_t)(result >> 64);
+  }
+  return carry;
+#else
   // Split y into high 32-bit part (hy)  and low 32-bit part (ly)
   uint64_t ly = y & 0xffffffffULL, hy = y >> 32;
   uint64_t carry = 0;
@@ -317,6 +358,7 @@ static uint64_t mul_1(uint64_t dest[], uint64_t x[], unsigned len, uint64_t y) {
             (carry >> 32) + ((lx * hy) >> 32) + hx * hy;
   }
   return carry;
+#endif
 }
 
 /// Multiplies integer array x by integer array y and stores the result into
@@ -325,6 +367,19 @@ static uint64_t mul_1(uint64_t dest[], uint64_t x[], unsigned len, uint64_t y) {
 static void mul(uint64_t dest[], uint64_t x[], unsigned xlen, uint64_t y[],
                 unsigned ylen) {
   dest[xlen] = mul_1(dest, x, xlen, y[0]);
+#ifdef APINT_HAS_DOUBLEWORD
+  for (unsigned i = 1; i < ylen; ++i) {
+    // x[j] * y[i] + dest[i+j] + carry cannot overflow two words:
+    // (2^64-1)^2 + 2*(2^64-1) = 2^128-1.
+    uint64_t carry = 0;
+    for (unsigned j = 0; j < xlen; ++j) {
+      DoubleWord result = (DoubleWord)x[j] * y[i] + dest[i+j] + carry;
+      dest[i+j] = (uint64_t)result;
+      carry = (uint64_t)(result >> 64);
+    }
+    dest[i+xlen] = carry;
+  }
+#else
   for (unsigned i = 1; i < ylen; ++i) {
     uint64_t ly = y[i] & 0xffffffffULL, hy = y[i] >> 32;
     uint64_t carry = 0, lx = 0, hx = 0;
@@ -350,6 +405,7 @@ static void mul(uint64_t dest[], uint64_t x[], unsigned xlen, uint64_t y[],
     }
     dest[i+xlen] = carry;
   }
+#endif
 }
 
 APInt& APInt::operator*=(const APInt& RHS) {
@@ -2454,6 +2510,13 @@ APInt::tcAdd(integerPart *dst, const integerPart *rhs,
 
   assert(c <= 1);
 
+#ifdef APINT_HAS_DOUBLEWORD
+  for (i = 0; i < parts; i++) {
+    DoubleWord result = (DoubleWord)dst[i] + rhs[i] + c;
+    dst[i] = (integerPart)result;
+    c = (integerPart)(result >> integerPartWidth);
+  }
+#else
   for (i = 0; i < parts; i++) {
     integerPart l;
 
@@ -2466,6 +2529,7 @@ APInt::tcAdd(integerPart *dst, const integerPart *rhs,
       c = (dst[i] < l);
     }
   }
+#endif
 
   return c;
 }
@@ -2479,6 +2543,13 @@ APInt::tcSubtract(integerPart *dst, const integerPart *rhs,
 
   assert(c <= 1);
 
+#ifdef APINT_HAS_DOUBLEWORD
+  for (i = 0; i < parts; i++) {
+    DoubleWord result = (DoubleWord)dst[i] - rhs[i] - c;
+    dst[i] = (integerPart)result;
+    c = (integerPart)(result >> integerPartWidth) & 1;
+  }
+#else
   for (i = 0; i < parts; i++) {
     integerPart l;
 
@@ -2491,6 +2562,7 @@ APInt::tcSubtract(integerPart *dst, const integerPart *rhs,
       c = (dst[i] > l);
     }
   }
+#endif
 
   return c;
 }
@@ -2529,6 +2601,17 @@ APInt::tcMultiplyPart(integerPart *dst, const integerPart *src,
   /* N loops; minimum of dstParts and srcParts.  */
   n = dstParts < srcParts ? dstParts: srcParts;
 
+#ifdef APINT_HAS_DOUBLEWORD
+  for (i = 0; i < n; i++) {
+    /* MULTIPLIER * SRC[i] + DST[i] + CARRY cannot overflow two parts; see
+       the overflow argument in the fallback below.  */
+    DoubleWord result = (DoubleWord)src[i] * multiplier + carry;
+    if (add)
+      result += dst[i];
+    dst[i] = (integerPart)result;
+    carry = (integerPart)(result >> integerPartWidth);
+  }
+#else
   for (i = 0; i < n; i++) {
     integerPart low, mid, high, srcPart;
 
@@ -2579,6 +2662,7 @@ APInt::tcMultiplyPart(integerPart *dst, const integerPart *src,
 
     carry = high;
   }
+#endif
 
   if (i < dstParts) {
     /* Full multiplication, there is no overflow.  */
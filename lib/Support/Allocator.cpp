@@ -14,20 +14,25 @@
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/DataTypes.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Memory.h"
 #include "llvm/Support/Recycler.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstring>
 
 namespace llvm {
 
 BumpPtrAllocator::BumpPtrAllocator(size_t size, size_t threshold,
-                                   SlabAllocator &allocator)
+                                   SlabAllocator &allocator,
+                                   size_t growthDelay)
     : SlabSize(size), SizeThreshold(std::min(size, threshold)),
-      Allocator(allocator), CurSlab(0), BytesAllocated(0) { }
+      GrowthDelay(growthDelay), Allocator(allocator), CurSlab(0), FreeSlabs(0),
+      BytesAllocated(0) { }
 
 BumpPtrAllocator::~BumpPtrAllocator() {
   DeallocateSlabs(CurSlab);
+  DeallocateSlabs(FreeSlabs);
 }
 
 /// AlignPtr - Align Ptr to Alignment bytes, rounding up.  Alignment should
@@ -45,13 +50,23 @@ char *BumpPtrAllocator::AlignPtr(char *Ptr, size_t Alignment) {
 /// StartNewSlab - Allocate a new slab and move the bump pointers over into
 /// the new slab.  Modifies CurPtr and End.
 void BumpPtrAllocator::StartNewSlab() {
-  // If we allocated a big number of slabs already it's likely that we're going
-  // to allocate more. Increase slab size to reduce mallocs and possibly memory
-  // overhead. The factors are chosen conservatively to avoid overallocation.
-  if (BytesAllocated >= SlabSize * 128)
-    SlabSize *= 2;
+  MemSlab *NewSlab;
+  if (FreeSlabs) {
+    // Reuse a slab retained by ResetForReuse.  Any retained slab is at least
+    // as large as the smallest slab we would allocate, so this is always
+    // safe for allocations below the size threshold.
+    NewSlab = FreeSlabs;
+    FreeSlabs = FreeSlabs->NextPtr;
+  } else {
+    // If we allocated a big number of slabs already it's likely that we're
+    // going to allocate more. Increase slab size to reduce mallocs and
+    // possibly memory overhead. The default growth delay is chosen
+    // conservatively to avoid overallocation.
+    if (BytesAllocated >= SlabSize * GrowthDelay)
+      SlabSize *= 2;
 
-  MemSlab *NewSlab = Allocator.Allocate(SlabSize);
+    NewSlab = Allocator.Allocate(SlabSize);
+  }
   NewSlab->NextPtr = CurSlab;
   CurSlab = NewSlab;
   CurPtr = (char*)(CurSlab + 1);
@@ -77,6 +92,8 @@ void BumpPtrAllocator::DeallocateSlabs(MemSlab *Slab) {
 /// Reset - Deallocate all but the current slab and reset the current pointer
 /// to the beginning of it, freeing all memory allocated so far.
 void BumpPtrAllocator::Reset() {
+  DeallocateSlabs(FreeSlabs);
+  FreeSlabs = 0;
   if (!CurSlab)
     return;
   DeallocateSlabs(CurSlab->NextPtr);
@@ -85,6 +102,29 @@ void BumpPtrAllocator::Reset() {
   End = ((char*)CurSlab) + CurSlab->Size;
 }
 
+/// ResetForReuse - Like Reset, but retain the allocated slabs on an internal
+/// free list instead of returning them to the slab allocator.
+void BumpPtrAllocator::ResetForReuse() {
+  if (!CurSlab)
+    return;
+  MemSlab *Slab = CurSlab->NextPtr;
+  while (Slab) {
+    MemSlab *NextSlab = Slab->NextPtr;
+#ifndef NDEBUG
+    // Poison the memory so stale pointers crash sooner.  Note we must
+    // preserve the Size and NextPtr fields at the beginning.
+    sys::Memory::setRangeWritable(Slab + 1, Slab->Size - sizeof(MemSlab));
+    memset(Slab + 1, 0xCD, Slab->Size - sizeof(MemSlab));
+#endif
+    Slab->NextPtr = FreeSlabs;
+    FreeSlabs = Slab;
+    Slab = NextSlab;
+  }
+  CurSlab->NextPtr = 0;
+  CurPtr = (char*)(CurSlab + 1);
+  End = ((char*)CurSlab) + CurSlab->Size;
+}
+
 /// Allocate - Allocate space at the specified alignment.
 ///
 void *BumpPtrAllocator::Allocate(size_t Size, size_t Alignment) {
@@ -169,6 +209,27 @@ void BumpPtrAllocator::PrintStats() const {
 MallocSlabAllocator BumpPtrAllocator::DefaultSlabAllocator =
   MallocSlabAllocator();
 
+/// SlabBytesInUse - Process-wide count of bytes currently held in slabs.
+/// Like the rest of the -track-memory machinery this assumes the slab
+/// clients are single-threaded, so a plain counter suffices.
+static size_t SlabBytesInUse;
+
+size_t SlabAllocatedBytes() {
+  return SlabBytesInUse;
+}
+
+/// TrackSlabAllocation - Record that the live slab byte count changed and
+/// give the timers a chance to attribute the new high-water mark to the
+/// running passes.
+static void TrackSlabAllocation(size_t Size) {
+  SlabBytesInUse += Size;
+  Timer::trackSlabMemory(SlabBytesInUse);
+}
+
+static void TrackSlabDeallocation(size_t Size) {
+  SlabBytesInUse -= Size;
+}
+
 SlabAllocator::~SlabAllocator() { }
 
 MallocSlabAllocator::~MallocSlabAllocator() { }
@@ -177,13 +238,38 @@ MemSlab *MallocSlabAllocator::Allocate(size_t Size) {
   MemSlab *Slab = (MemSlab*)Allocator.Allocate(Size, 0);
   Slab->Size = Size;
   Slab->NextPtr = 0;
+  TrackSlabAllocation(Size);
   return Slab;
 }
 
 void MallocSlabAllocator::Deallocate(MemSlab *Slab) {
+  TrackSlabDeallocation(Slab->Size);
   Allocator.Deallocate(Slab);
 }
 
+MmapSlabAllocator::~MmapSlabAllocator() { }
+
+MemSlab *MmapSlabAllocator::Allocate(size_t Size) {
+  error_code EC;
+  sys::MemoryBlock MB = sys::Memory::allocateMappedMemory(
+      Size, 0, sys::Memory::MF_READ | sys::Memory::MF_WRITE, EC);
+  if (MB.base() == 0)
+    report_fatal_error("Failed to mmap a memory slab: " + EC.message());
+  MemSlab *Slab = (MemSlab*)MB.base();
+  // The mapping is rounded up to a whole number of pages; let the bump
+  // allocator use the slack.
+  Slab->Size = MB.size();
+  Slab->NextPtr = 0;
+  TrackSlabAllocation(Slab->Size);
+  return Slab;
+}
+
+void MmapSlabAllocator::Deallocate(MemSlab *Slab) {
+  TrackSlabDeallocation(Slab->Size);
+  sys::MemoryBlock MB(Slab, Slab->Size);
+  sys::Memory::releaseMappedMemory(MB);
+}
+
 void PrintRecyclerStats(size_t Size,
                         size_t Align,
                         size_t FreeListSize) {
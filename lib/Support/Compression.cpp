@@ -0,0 +1,176 @@
+//===--- Compression.cpp - Compression implementation ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements compression functions.
+//
+// The format is a sequence of token-prefixed records.  Each record starts
+// with a token byte whose high nibble is a literal count and whose low
+// nibble is a match length minus four; a nibble value of 15 is extended by
+// following bytes, each adding 0-255 (a byte below 255 terminates the
+// extension).  The literal bytes follow the token.  If the output is not
+// yet complete, a two-byte little-endian match offset (1-65535, counted
+// back from the current output position) follows the literals and the
+// match bytes are copied from earlier output.  The final record carries
+// only literals; because the decompressor knows the uncompressed size it
+// never looks for an offset once the output is full.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/Compression.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include <cstring>
+using namespace llvm;
+
+namespace {
+  enum {
+    HashLog = 13,                      // 8K entry match table.
+    MaxOffset = 65535,                 // Two-byte offsets.
+    MinMatch = 4                       // Matches shorter than this expand.
+  };
+}
+
+static inline uint32_t ReadUnaligned32(const unsigned char *P) {
+  uint32_t V;
+  memcpy(&V, P, sizeof(V));
+  return V;
+}
+
+static inline unsigned HashSequence(uint32_t V) {
+  return (V * 2654435761U) >> (32 - HashLog);
+}
+
+/// EmitCount - Emit a token nibble's extension bytes for counts >= 15.
+static void EmitCount(size_t Count, SmallVectorImpl<char> &Out) {
+  while (Count >= 255) {
+    Out.push_back((char)255);
+    Count -= 255;
+  }
+  Out.push_back((char)Count);
+}
+
+/// EmitRecord - Emit one record: the literals [LitStart, LitEnd) followed,
+/// if MatchLen is non-zero, by the offset and match length.
+static void EmitRecord(const unsigned char *LitStart,
+                       const unsigned char *LitEnd,
+                       unsigned Offset, size_t MatchLen,
+                       SmallVectorImpl<char> &Out) {
+  size_t LitLen = LitEnd - LitStart;
+  unsigned char Token = 0;
+  Token |= (LitLen >= 15 ? 15 : (unsigned char)LitLen) << 4;
+  if (MatchLen)
+    Token |= MatchLen - MinMatch >= 15 ? 15 : (unsigned char)(MatchLen -
+                                                              MinMatch);
+  Out.push_back((char)Token);
+  if (LitLen >= 15)
+    EmitCount(LitLen - 15, Out);
+  Out.append((const char *)LitStart, (const char *)LitEnd);
+  if (!MatchLen)
+    return;
+  Out.push_back((char)(Offset & 0xFF));
+  Out.push_back((char)(Offset >> 8));
+  if (MatchLen - MinMatch >= 15)
+    EmitCount(MatchLen - MinMatch - 15, Out);
+}
+
+void compression::compress(StringRef Input, SmallVectorImpl<char> &Output) {
+  const unsigned char *In = (const unsigned char *)Input.data();
+  size_t N = Input.size();
+
+  // Positions of previously seen four-byte sequences, biased by one so that
+  // zero means "empty".
+  SmallVector<uint32_t, 0> Table(1u << HashLog, 0);
+
+  size_t Pos = 0, Anchor = 0;
+  while (Pos + MinMatch <= N) {
+    uint32_t Seq = ReadUnaligned32(In + Pos);
+    unsigned H = HashSequence(Seq);
+    size_t Ref = Table[H];
+    Table[H] = Pos + 1;
+
+    if (Ref && Pos - (Ref - 1) <= MaxOffset &&
+        ReadUnaligned32(In + (Ref - 1)) == Seq) {
+      size_t MatchPos = Ref - 1;
+      size_t Len = MinMatch;
+      while (Pos + Len < N && In[MatchPos + Len] == In[Pos + Len])
+        ++Len;
+      EmitRecord(In + Anchor, In + Pos, (unsigned)(Pos - MatchPos), Len,
+                 Output);
+      Pos += Len;
+      Anchor = Pos;
+    } else {
+      ++Pos;
+    }
+  }
+
+  // Trailing literals.
+  if (Anchor != N)
+    EmitRecord(In + Anchor, In + N, 0, 0, Output);
+}
+
+/// ReadCount - Read a token nibble's extension bytes.  Returns false if the
+/// input is exhausted mid-count.
+static bool ReadCount(const unsigned char *&P, const unsigned char *End,
+                      size_t &Count) {
+  unsigned char C;
+  do {
+    if (P == End)
+      return false;
+    C = *P++;
+    Count += C;
+  } while (C == 255);
+  return true;
+}
+
+bool compression::uncompress(StringRef Input, SmallVectorImpl<char> &Output,
+                             size_t UncompressedSize) {
+  const unsigned char *P = (const unsigned char *)Input.data();
+  const unsigned char *End = P + Input.size();
+  size_t Base = Output.size();
+  Output.reserve(Base + UncompressedSize);
+
+  size_t Written = 0;
+  while (Written < UncompressedSize) {
+    if (P == End)
+      return false;
+    unsigned char Token = *P++;
+
+    // Literals.
+    size_t LitLen = Token >> 4;
+    if (LitLen == 15 && !ReadCount(P, End, LitLen))
+      return false;
+    if (LitLen > (size_t)(End - P) || Written + LitLen > UncompressedSize)
+      return false;
+    Output.append((const char *)P, (const char *)P + LitLen);
+    P += LitLen;
+    Written += LitLen;
+    if (Written == UncompressedSize)
+      break;
+
+    // Match.
+    if (End - P < 2)
+      return false;
+    size_t Offset = P[0] | ((size_t)P[1] << 8);
+    P += 2;
+    if (Offset == 0 || Offset > Written)
+      return false;
+    size_t MatchLen = (Token & 0xF) + MinMatch;
+    if ((Token & 0xF) == 15 && !ReadCount(P, End, MatchLen))
+      return false;
+    if (Written + MatchLen > UncompressedSize)
+      return false;
+    // Copy byte-by-byte since the match may overlap the bytes it produces.
+    // The reserve() above guarantees no reallocation happens while an
+    // element reference is live.
+    for (size_t i = 0; i != MatchLen; ++i)
+      Output.push_back(Output[Base + Written - Offset + i]);
+    Written += MatchLen;
+  }
+  return true;
+}
@@ -48,6 +48,7 @@
 
 
 #include "llvm/Support/ConvertUTF.h"
+#include "llvm/Support/DataTypes.h"
 #ifdef CVTUTF_DEBUG
 #include <stdio.h>
 #endif
@@ -103,6 +104,33 @@ static const UTF8 firstByteMark[7] = { 0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC
 
 /* --------------------------------------------------------------------- */
 
+/*
+ * A machine word with the sign bit of every byte set.  ANDing a word of
+ * UTF-8 text with this mask yields zero iff every byte in the word is
+ * plain ASCII, which lets the loops below step over ASCII runs a word at
+ * a time instead of a byte at a time.  Word-sized reads are only issued
+ * once the byte-serial code has brought the source pointer to a word
+ * boundary and at least a full word remains, so no read crosses the
+ * caller's buffer limits.
+ */
+static const uintptr_t asciiWordMask = (uintptr_t)~(uintptr_t)0 / 0xFF * 0x80;
+
+/*
+ * Advance source over any leading run of plain ASCII bytes that can be
+ * checked a whole aligned word at a time.  A byte-serial caller loop
+ * naturally reaches a word boundary after at most wordsize-1 characters.
+ */
+static const UTF8 *skipASCIIWords(const UTF8 *source, const UTF8 *sourceEnd) {
+    if (((uintptr_t)source & (sizeof(uintptr_t) - 1)) == 0) {
+        while ((size_t)(sourceEnd - source) >= sizeof(uintptr_t) &&
+               (*(const uintptr_t *)source & asciiWordMask) == 0)
+            source += sizeof(uintptr_t);
+    }
+    return source;
+}
+
+/* --------------------------------------------------------------------- */
+
 /* The interface converts a whole buffer to avoid function-call overhead.
  * Constants have been gathered. Loops & conditionals have been removed as
  * much as possible for efficiency, in favor of drop-through switches.
@@ -408,7 +436,12 @@ unsigned getNumBytesForUTF8(UTF8 first) {
  */
 Boolean isLegalUTF8String(const UTF8 **source, const UTF8 *sourceEnd) {
     while (*source != sourceEnd) {
-        int length = trailingBytesForUTF8[**source] + 1;
+        int length;
+        /* Plain ASCII is trivially legal; vet it an aligned word at a time. */
+        *source = skipASCIIWords(*source, sourceEnd);
+        if (*source == sourceEnd)
+            break;
+        length = trailingBytesForUTF8[**source] + 1;
         if (length > sourceEnd - *source || !isLegalUTF8(*source, length))
             return false;
         *source += length;
@@ -426,7 +459,26 @@ ConversionResult ConvertUTF8toUTF16 (
     UTF16* target = *targetStart;
     while (source < sourceEnd) {
         UTF32 ch = 0;
-        unsigned short extraBytesToRead = trailingBytesForUTF8[*source];
+        unsigned short extraBytesToRead;
+        /*
+         * Bulk-convert aligned words of plain ASCII; each byte widens to
+         * one UTF16 unit, so a word of source needs a word's worth of
+         * target slots.  Everything else takes the byte-serial code below.
+         */
+        if (*source < 0x80 &&
+            ((uintptr_t)source & (sizeof(uintptr_t) - 1)) == 0) {
+            while ((size_t)(sourceEnd - source) >= sizeof(uintptr_t) &&
+                   (size_t)(targetEnd - target) >= sizeof(uintptr_t) &&
+                   (*(const uintptr_t *)source & asciiWordMask) == 0) {
+                size_t i;
+                for (i = 0; i < sizeof(uintptr_t); ++i)
+                    *target++ = source[i];
+                source += sizeof(uintptr_t);
+            }
+            if (source >= sourceEnd)
+                break;
+        }
+        extraBytesToRead = trailingBytesForUTF8[*source];
         if (extraBytesToRead >= sourceEnd - source) {
             result = sourceExhausted; break;
         }
@@ -499,7 +551,22 @@ ConversionResult ConvertUTF8toUTF32 (
     UTF32* target = *targetStart;
     while (source < sourceEnd) {
         UTF32 ch = 0;
-        unsigned short extraBytesToRead = trailingBytesForUTF8[*source];
+        unsigned short extraBytesToRead;
+        /* Bulk-convert aligned words of plain ASCII, as in UTF8toUTF16. */
+        if (*source < 0x80 &&
+            ((uintptr_t)source & (sizeof(uintptr_t) - 1)) == 0) {
+            while ((size_t)(sourceEnd - source) >= sizeof(uintptr_t) &&
+                   (size_t)(targetEnd - target) >= sizeof(uintptr_t) &&
+                   (*(const uintptr_t *)source & asciiWordMask) == 0) {
+                size_t i;
+                for (i = 0; i < sizeof(uintptr_t); ++i)
+                    *target++ = source[i];
+                source += sizeof(uintptr_t);
+            }
+            if (source >= sourceEnd)
+                break;
+        }
+        extraBytesToRead = trailingBytesForUTF8[*source];
         if (extraBytesToRead >= sourceEnd - source) {
             result = sourceExhausted; break;
         }
@@ -14,6 +14,7 @@
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/ThreadLocal.h"
 #include <cstdio>
+#include <new>
 #include <setjmp.h>
 using namespace llvm;
 
@@ -24,6 +25,12 @@ struct CrashRecoveryContextImpl;
 static sys::ThreadLocal<const CrashRecoveryContextImpl> CurrentContext;
 
 struct CrashRecoveryContextImpl {
+  // When this context is active, the address of the context that was active
+  // when it was entered; this forms a per-thread stack of contexts, so
+  // activation needs no locking and contexts nest properly.  When this
+  // context is on the free pool, the next pooled context.
+  const CrashRecoveryContextImpl *Next;
+
   CrashRecoveryContext *CRC;
   std::string Backtrace;
   ::jmp_buf JumpBuffer;
@@ -32,16 +39,19 @@ struct CrashRecoveryContextImpl {
 public:
   CrashRecoveryContextImpl(CrashRecoveryContext *CRC) : CRC(CRC),
                                                         Failed(false) {
+    Next = CurrentContext.get();
     CurrentContext.set(this);
   }
   ~CrashRecoveryContextImpl() {
-    CurrentContext.erase();
+    // Pop this context off the stack unless HandleCrash already did.
+    if (CurrentContext.get() == this)
+      CurrentContext.set(Next);
   }
 
   void HandleCrash() {
     // Eliminate the current context entry, to avoid re-entering in case the
     // cleanup code crashes.
-    CurrentContext.erase();
+    CurrentContext.set(Next);
 
     assert(!Failed && "Crash recovery context already failed!");
     Failed = true;
@@ -55,6 +65,29 @@ public:
 
 }
 
+// RunSafely is on the hot path for clients that wrap every unit of work in a
+// recovery context, so retired impl objects are recycled through a per-thread
+// pool (chained through their Next field) instead of going back to the heap
+// allocator.  The pool holds at most the thread's maximum activation nesting
+// depth and lives until the thread exits.
+static sys::ThreadLocal<const CrashRecoveryContextImpl> PooledContexts;
+
+static CrashRecoveryContextImpl *createImpl(CrashRecoveryContext *CRC) {
+  const CrashRecoveryContextImpl *Free = PooledContexts.get();
+  if (!Free)
+    return new CrashRecoveryContextImpl(CRC);
+
+  PooledContexts.set(Free->Next);
+  return new (const_cast<CrashRecoveryContextImpl*>(Free))
+      CrashRecoveryContextImpl(CRC);
+}
+
+static void retireImpl(CrashRecoveryContextImpl *CRCI) {
+  CRCI->~CrashRecoveryContextImpl();
+  CRCI->Next = PooledContexts.get();
+  PooledContexts.set(CRCI);
+}
+
 static sys::Mutex gCrashRecoveryContexMutex;
 static bool gCrashRecoveryEnabled = false;
 
@@ -77,7 +110,8 @@ CrashRecoveryContext::~CrashRecoveryContext() {
   tlIsRecoveringFromCrash.erase();
   
   CrashRecoveryContextImpl *CRCI = (CrashRecoveryContextImpl *) Impl;
-  delete CRCI;
+  if (CRCI)
+    retireImpl(CRCI);
 }
 
 bool CrashRecoveryContext::isRecoveringFromCrash() {
@@ -297,7 +331,7 @@ bool CrashRecoveryContext::RunSafely(void (*Fn)(void*), void *UserData) {
   // If crash recovery is disabled, do nothing.
   if (gCrashRecoveryEnabled) {
     assert(!Impl && "Crash recovery context already initialized!");
-    CrashRecoveryContextImpl *CRCI = new CrashRecoveryContextImpl(this);
+    CrashRecoveryContextImpl *CRCI = createImpl(this);
     Impl = CRCI;
 
     if (setjmp(CRCI->JumpBuffer) != 0) {
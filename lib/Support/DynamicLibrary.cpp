@@ -24,11 +24,19 @@
 // Collection of symbol name/value pairs to be searched prior to any libraries.
 static llvm::StringMap<void *> *ExplicitSymbols = 0;
 
+// Cache of SearchForAddressOfSymbol() results, both hits and misses (misses
+// are stored as null).  JITs issue storms of repeated queries on module load;
+// without the cache every one of them walks all opened libraries.  The cache
+// is flushed whenever the set of searchable symbols can change: when a new
+// library is opened or a symbol is added via AddSymbol().
+static llvm::StringMap<void *> *ResolvedSymbols = 0;
+
 namespace {
 
 struct ExplicitSymbolsDeleter {
   ~ExplicitSymbolsDeleter() {
     delete ExplicitSymbols;
+    delete ResolvedSymbols;
   }
 };
 
@@ -48,6 +56,8 @@ void llvm::sys::DynamicLibrary::AddSymbol(StringRef symbolName,
   if (ExplicitSymbols == 0)
     ExplicitSymbols = new StringMap<void*>();
   (*ExplicitSymbols)[symbolName] = symbolValue;
+  if (ResolvedSymbols)
+    ResolvedSymbols->clear();
 }
 
 char llvm::sys::DynamicLibrary::Invalid = 0;
@@ -94,6 +104,8 @@ DynamicLibrary DynamicLibrary::getPermanentLibrary(const char *filename,
   // keep the internal refcount at +1.
   if (!OpenedHandles->insert(handle).second)
     dlclose(handle);
+  else if (ResolvedSymbols)
+    ResolvedSymbols->clear();
 
   return DynamicLibrary(handle);
 }
@@ -125,9 +137,7 @@ namespace llvm {
 void *SearchForAddressOfSpecialSymbol(const char* symbolName);
 }
 
-void* DynamicLibrary::SearchForAddressOfSymbol(const char *symbolName) {
-  SmartScopedLock<true> Lock(getMutex());
-
+static void *SearchForAddressOfSymbolImpl(const char *symbolName) {
   // First check symbols added via AddSymbol().
   if (ExplicitSymbols) {
     StringMap<void *>::iterator i = ExplicitSymbols->find(symbolName);
@@ -187,3 +197,34 @@ void* DynamicLibrary::SearchForAddressOfSymbol(const char *symbolName) {
 }
 
 #endif // LLVM_ON_WIN32
+
+void* llvm::sys::DynamicLibrary::SearchForAddressOfSymbol(
+    const char *symbolName) {
+  llvm::sys::SmartScopedLock<true> Lock(getMutex());
+
+  if (ResolvedSymbols) {
+    llvm::StringMap<void *>::iterator I = ResolvedSymbols->find(symbolName);
+    if (I != ResolvedSymbols->end())
+      return I->second;
+  } else {
+    ResolvedSymbols = new llvm::StringMap<void *>();
+  }
+
+  void *Ptr = SearchForAddressOfSymbolImpl(symbolName);
+  (*ResolvedSymbols)[symbolName] = Ptr;
+  return Ptr;
+}
+
+void llvm::sys::DynamicLibrary::PreloadSymbols(
+    llvm::ArrayRef<const char *> symbolNames) {
+  llvm::sys::SmartScopedLock<true> Lock(getMutex());
+
+  if (ResolvedSymbols == 0)
+    ResolvedSymbols = new llvm::StringMap<void *>();
+
+  for (unsigned i = 0, e = symbolNames.size(); i != e; ++i) {
+    const char *Name = symbolNames[i];
+    if (!ResolvedSymbols->count(Name))
+      (*ResolvedSymbols)[Name] = SearchForAddressOfSymbolImpl(Name);
+  }
+}
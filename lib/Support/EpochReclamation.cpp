@@ -0,0 +1,134 @@
+//===- EpochReclamation.cpp - Deferred reclamation ------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the EpochReclamationManager class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/EpochReclamation.h"
+#include "llvm/Support/Threading.h"
+#include <cassert>
+
+using namespace llvm;
+using namespace llvm::sys;
+
+EpochReclamationManager::EpochReclamationManager()
+  : GlobalEpoch(0), ThreadList(0) {}
+
+EpochReclamationManager::~EpochReclamationManager() {
+  while (ThreadState *TS = ThreadList) {
+    assert(!TS->InCritical &&
+           "Manager destroyed while a thread is in a critical region!");
+    ThreadList = TS->Next;
+    for (unsigned B = 0; B != 3; ++B)
+      freeList(TS->RetireLists[B]);
+    delete TS;
+  }
+}
+
+EpochReclamationManager::ThreadState &
+EpochReclamationManager::getThreadState() {
+  if (const ThreadState *TS = CurThreadState.get())
+    return *const_cast<ThreadState*>(TS);
+  ThreadState *TS = new ThreadState();
+  SmartScopedLock<true> Lock(RegistryLock);
+  TS->Next = ThreadList;
+  ThreadList = TS;
+  CurThreadState.set(TS);
+  return *TS;
+}
+
+/// canAdvanceEpoch - The epoch may advance once every thread inside a
+/// critical region has observed the current one.  A thread that stays in a
+/// critical region therefore holds the epoch back after at most one
+/// advancement, which is what gives retired objects their grace period.
+/// The caller must hold RegistryLock.
+bool EpochReclamationManager::canAdvanceEpoch() const {
+  for (ThreadState *TS = ThreadList; TS; TS = TS->Next)
+    if (TS->InCritical && TS->LocalEpoch != GlobalEpoch)
+      return false;
+  return true;
+}
+
+unsigned EpochReclamationManager::freeList(std::vector<Retired> &List) {
+  unsigned Freed = List.size();
+  for (unsigned i = 0, e = List.size(); i != e; ++i)
+    List[i].Deleter(List[i].Ptr);
+  List.clear();
+  return Freed;
+}
+
+void EpochReclamationManager::enterCriticalRegion() {
+  if (!llvm_is_multithreaded())
+    return;
+  ThreadState &TS = getThreadState();
+  assert(!TS.InCritical && "Critical regions do not nest!");
+  TS.InCritical = 1;
+  // The announcement must be visible before the epoch is sampled, or a
+  // collector could advance past us between the two.
+  MemoryFence();
+  TS.LocalEpoch = GlobalEpoch;
+  MemoryFence();
+}
+
+void EpochReclamationManager::exitCriticalRegion() {
+  if (!llvm_is_multithreaded())
+    return;
+  ThreadState &TS = getThreadState();
+  assert(TS.InCritical && "Not in a critical region!");
+  MemoryFence();
+  TS.InCritical = 0;
+}
+
+void EpochReclamationManager::retire(void *Ptr, DeleterTy Deleter) {
+  if (!llvm_is_multithreaded()) {
+    Deleter(Ptr);
+    return;
+  }
+  ThreadState &TS = getThreadState();
+  cas_flag Epoch = GlobalEpoch;
+  unsigned B = Epoch % 3;
+  if (TS.BucketEpoch[B] != Epoch) {
+    // Anything still in this bucket was retired at least three epochs ago
+    // and is long past its grace period.
+    freeList(TS.RetireLists[B]);
+    TS.BucketEpoch[B] = Epoch;
+  }
+  Retired R = { Ptr, Deleter };
+  TS.RetireLists[B].push_back(R);
+}
+
+unsigned EpochReclamationManager::collect() {
+  if (!llvm_is_multithreaded())
+    return 0;
+  ThreadState &TS = getThreadState();
+  {
+    SmartScopedLock<true> Lock(RegistryLock);
+    if (canAdvanceEpoch())
+      AtomicIncrement(&GlobalEpoch);
+  }
+  cas_flag Epoch = GlobalEpoch;
+  unsigned Freed = 0;
+  for (unsigned B = 0; B != 3; ++B)
+    if (!TS.RetireLists[B].empty() && TS.BucketEpoch[B] + 2 <= Epoch)
+      Freed += freeList(TS.RetireLists[B]);
+  return Freed;
+}
+
+unsigned EpochReclamationManager::drain() {
+  SmartScopedLock<true> Lock(RegistryLock);
+  unsigned Freed = 0;
+  for (ThreadState *TS = ThreadList; TS; TS = TS->Next) {
+    assert(!TS->InCritical &&
+           "drain() called while a thread is in a critical region!");
+    for (unsigned B = 0; B != 3; ++B)
+      Freed += freeList(TS->RetireLists[B]);
+  }
+  return Freed;
+}
@@ -21,10 +21,12 @@ using llvm::sys::fs::mapped_file_region;
 
 namespace llvm {
 FileOutputBuffer::FileOutputBuffer(mapped_file_region * R,
-                                   StringRef Path, StringRef TmpPath)
+                                   StringRef Path, StringRef TmpPath,
+                                   bool durable)
   : Region(R)
   , FinalPath(Path)
-  , TempPath(TmpPath) {
+  , TempPath(TmpPath)
+  , Durable(durable) {
 }
 
 FileOutputBuffer::~FileOutputBuffer() {
@@ -95,7 +97,8 @@ error_code FileOutputBuffer::create(StringRef FilePath,
       return EC;
   }
 
-  Result.reset(new FileOutputBuffer(MappedFile.get(), FilePath, TempFilePath));
+  Result.reset(new FileOutputBuffer(MappedFile.get(), FilePath, TempFilePath,
+                                    (Flags & F_durable) != 0));
   if (Result)
     MappedFile.take();
 
@@ -103,6 +106,14 @@ error_code FileOutputBuffer::create(StringRef FilePath,
 }
 
 error_code FileOutputBuffer::commit(int64_t NewSmallerSize) {
+  // If requested, wait for the content to reach the device before publishing
+  // the file under its final name.
+  if (Durable) {
+    error_code EC = Region->sync();
+    if (EC)
+      return EC;
+  }
+
   // Unmap buffer, letting OS flush dirty pages to file on disk.
   Region.reset(0);
 
@@ -116,4 +127,37 @@ error_code FileOutputBuffer::commit(int64_t NewSmallerSize) {
   // Rename file to final name.
   return sys::fs::rename(Twine(TempPath), Twine(FinalPath));
 }
+
+error_code FileOutputBuffer::commitAll(ArrayRef<FileOutputBuffer*> Buffers) {
+  // Start writeback on every durable buffer before waiting on any of them,
+  // so the flushes overlap instead of completing one file at a time.
+  for (unsigned i = 0, e = Buffers.size(); i != e; ++i) {
+    if (!Buffers[i]->Durable)
+      continue;
+    error_code EC = Buffers[i]->Region->sync(false);
+    if (EC)
+      return EC;
+  }
+
+  // Wait for the durable flushes, then unmap everything.
+  for (unsigned i = 0, e = Buffers.size(); i != e; ++i) {
+    FileOutputBuffer &B = *Buffers[i];
+    if (B.Durable) {
+      error_code EC = B.Region->sync();
+      if (EC)
+        return EC;
+    }
+    B.Region.reset(0);
+  }
+
+  // Rename into place last, so an error above leaves nothing partially
+  // committed under a final name.
+  for (unsigned i = 0, e = Buffers.size(); i != e; ++i) {
+    FileOutputBuffer &B = *Buffers[i];
+    error_code EC = sys::fs::rename(Twine(B.TempPath), Twine(B.FinalPath));
+    if (EC)
+      return EC;
+  }
+  return error_code::success();
+}
 } // namespace
@@ -15,6 +15,7 @@
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/MathExtras.h"
@@ -289,11 +290,15 @@ FoldingSetImpl::Node
   
   FoldingSetNodeID TempID;
   while (Node *NodeInBucket = GetNextPtr(Probe)) {
+    // Bucket chains are scattered through the heap; start pulling in the
+    // next node while this one's profile is being compared.  The tag bit on
+    // a chain-terminating bucket pointer does not bother the prefetcher.
+    Probe = NodeInBucket->getNextInBucket();
+    LLVM_PREFETCH(Probe);
+
     if (NodeEquals(NodeInBucket, ID, IDHash, TempID))
       return NodeInBucket;
     TempID.clear();
-
-    Probe = NodeInBucket->getNextInBucket();
   }
   
   // Didn't find the node, return null with the bucket as the InsertPos.
@@ -59,6 +59,13 @@ void formatted_raw_ostream::ComputeColumn(const char *Ptr, size_t Size) {
 /// \param NewCol - The column to move to.
 ///
 formatted_raw_ostream &formatted_raw_ostream::PadToColumn(unsigned NewCol) { 
+  // Without column tracking the current column is unknown; emit the minimum
+  // separation instead.
+  if (!ColumnTracking) {
+    indent(1);
+    return *this;
+  }
+
   // Figure out what's in the buffer and add it to the column count.
   ComputeColumn(getBufferStart(), GetNumBytesInBuffer());
 
@@ -68,8 +75,10 @@ formatted_raw_ostream &formatted_raw_ostream::PadToColumn(unsigned NewCol) {
 }
 
 void formatted_raw_ostream::write_impl(const char *Ptr, size_t Size) {
-  // Figure out what's in the buffer and add it to the column count.
-  ComputeColumn(Ptr, Size);
+  // Figure out what's in the buffer and add it to the column count, unless
+  // the client has told us it never needs it.
+  if (ColumnTracking)
+    ComputeColumn(Ptr, Size);
 
   // Write the data to the underlying stream (which is unbuffered, so
   // the data will be immediately written out).
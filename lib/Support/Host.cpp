@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/Host.h"
+#include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSwitch.h"
@@ -580,6 +581,80 @@ bool sys::getHostCPUFeatures(StringMap<bool> &Features){
 }
 #endif
 
+#if defined(__linux__)
+int sys::getHostNumPhysicalCores() {
+  // Each distinct (physical id, core id) pair in /proc/cpuinfo names one
+  // physical core; the logical CPUs that SMT exposes share the pair.  As with
+  // the CPU name queries above, /proc/cpuinfo cannot be mmap'ed, so stream it.
+  std::string Err;
+  DataStreamer *DS = getDataFileStreamer("/proc/cpuinfo", &Err);
+  if (!DS) {
+    DEBUG(dbgs() << "Unable to open /proc/cpuinfo: " << Err << "\n");
+    return -1;
+  }
+
+  std::string CPUInfo;
+  char Chunk[4096];
+  for (;;) {
+    size_t N = DS->GetBytes((unsigned char *)Chunk, sizeof(Chunk));
+    CPUInfo.append(Chunk, Chunk + N);
+    if (N < sizeof(Chunk))
+      break;
+  }
+  delete DS;
+
+  SmallVector<StringRef, 64> Lines;
+  StringRef(CPUInfo).split(Lines, "\n");
+
+  int CurPhysicalId = -1;
+  SmallSet<std::pair<int, int>, 32> Cores;
+  for (unsigned I = 0, E = Lines.size(); I != E; ++I) {
+    StringRef Line = Lines[I];
+    if (Line.startswith("physical id")) {
+      Line.substr(Line.find(':') + 1).trim().getAsInteger(10, CurPhysicalId);
+    } else if (Line.startswith("core id")) {
+      int CoreId = -1;
+      Line.substr(Line.find(':') + 1).trim().getAsInteger(10, CoreId);
+      Cores.insert(std::make_pair(CurPhysicalId, CoreId));
+    }
+  }
+
+  // Kernels for CPUs without topology information (many ARM systems) emit
+  // neither field.
+  if (Cores.empty())
+    return -1;
+  return Cores.size();
+}
+#elif defined(__APPLE__)
+#include <sys/sysctl.h>
+int sys::getHostNumPhysicalCores() {
+  int Count;
+  size_t Len = sizeof(Count);
+  if (::sysctlbyname("hw.physicalcpu", &Count, &Len, 0, 0) == 0)
+    return Count;
+  return -1;
+}
+#else
+int sys::getHostNumPhysicalCores() {
+  return -1;
+}
+#endif
+
+int sys::getHostNumLogicalCores() {
+#if defined(LLVM_ON_UNIX) && defined(_SC_NPROCESSORS_ONLN)
+  long N = ::sysconf(_SC_NPROCESSORS_ONLN);
+  if (N > 0)
+    return (int)N;
+  return -1;
+#elif defined(LLVM_ON_WIN32)
+  SYSTEM_INFO SI;
+  ::GetSystemInfo(&SI);
+  return (int)SI.dwNumberOfProcessors;
+#else
+  return -1;
+#endif
+}
+
 std::string sys::getProcessTriple() {
   Triple PT(LLVM_HOSTTRIPLE);
 
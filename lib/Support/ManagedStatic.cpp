@@ -22,9 +22,12 @@ static const ManagedStaticBase *StaticList = 0;
 void ManagedStaticBase::RegisterManagedStatic(void *(*Creator)(),
                                               void (*Deleter)(void*)) const {
   if (llvm_is_multithreaded()) {
-    llvm_acquire_global_lock();
-
-    if (Ptr == 0) {
+    // Claim the per-static creation guard.  Only the thread that moves it
+    // from 0 to 1 runs the creator; statics being created concurrently on
+    // different threads no longer contend on the global lock, which is now
+    // held only for the brief push onto the shutdown list.
+    sys::cas_flag OldVal = sys::CompareAndSwap(&InitFlag, 1, 0);
+    if (OldVal == 0) {
       void* tmp = Creator ? Creator() : 0;
 
       TsanHappensBefore(this);
@@ -37,13 +40,21 @@ void ManagedStaticBase::RegisterManagedStatic(void *(*Creator)(),
       Ptr = tmp;
       TsanIgnoreWritesEnd();
       DeleterFn = Deleter;
-      
+
       // Add to list of managed statics.
+      llvm_acquire_global_lock();
       Next = StaticList;
       StaticList = this;
-    }
+      llvm_release_global_lock();
 
-    llvm_release_global_lock();
+      // Publish.  Losers of the claim race spin on this below.
+      sys::MemoryFence();
+      InitFlag = 2;
+    } else {
+      // Another thread is running the creator; wait until it publishes.
+      while (InitFlag != 2)
+        sys::MemoryFence();
+    }
   } else {
     assert(Ptr == 0 && DeleterFn == 0 && Next == 0 &&
            "Partially initialized ManagedStatic!?");
@@ -67,9 +78,11 @@ void ManagedStaticBase::destroy() const {
   // Destroy memory.
   DeleterFn(Ptr);
   
-  // Cleanup.
+  // Cleanup.  Reset the guard as well so the static can be lazily recreated
+  // after llvm_shutdown.
   Ptr = 0;
   DeleterFn = 0;
+  InitFlag = 0;
 }
 
 /// llvm_shutdown - Deallocate and destroy all ManagedStatic variables.
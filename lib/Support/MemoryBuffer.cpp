@@ -159,18 +159,20 @@ MemoryBuffer *MemoryBuffer::getNewMemBuffer(size_t Size, StringRef BufferName) {
 /// returns an empty buffer.
 error_code MemoryBuffer::getFileOrSTDIN(StringRef Filename,
                                         OwningPtr<MemoryBuffer> &result,
-                                        int64_t FileSize) {
+                                        int64_t FileSize,
+                                        AccessPattern Access) {
   if (Filename == "-")
     return getSTDIN(result);
-  return getFile(Filename, result, FileSize);
+  return getFile(Filename, result, FileSize, true, Access);
 }
 
 error_code MemoryBuffer::getFileOrSTDIN(const char *Filename,
                                         OwningPtr<MemoryBuffer> &result,
-                                        int64_t FileSize) {
+                                        int64_t FileSize,
+                                        AccessPattern Access) {
   if (strcmp(Filename, "-") == 0)
     return getSTDIN(result);
-  return getFile(Filename, result, FileSize);
+  return getFile(Filename, result, FileSize, true, Access);
 }
 
 //===----------------------------------------------------------------------===//
@@ -228,17 +230,19 @@ static error_code getMemoryBufferForStream(int FD,
 error_code MemoryBuffer::getFile(StringRef Filename,
                                  OwningPtr<MemoryBuffer> &result,
                                  int64_t FileSize,
-                                 bool RequiresNullTerminator) {
+                                 bool RequiresNullTerminator,
+                                 AccessPattern Access) {
   // Ensure the path is null terminated.
   SmallString<256> PathBuf(Filename.begin(), Filename.end());
   return MemoryBuffer::getFile(PathBuf.c_str(), result, FileSize,
-                               RequiresNullTerminator);
+                               RequiresNullTerminator, Access);
 }
 
 error_code MemoryBuffer::getFile(const char *Filename,
                                  OwningPtr<MemoryBuffer> &result,
                                  int64_t FileSize,
-                                 bool RequiresNullTerminator) {
+                                 bool RequiresNullTerminator,
+                                 AccessPattern Access) {
   // First check that the "file" is not a directory
   bool is_dir = false;
   error_code err = sys::fs::is_directory(Filename, is_dir);
@@ -256,7 +260,7 @@ error_code MemoryBuffer::getFile(const char *Filename,
     return error_code(errno, posix_category());
 
   error_code ret = getOpenFile(FD, Filename, result, FileSize, FileSize,
-                               0, RequiresNullTerminator);
+                               0, RequiresNullTerminator, Access);
   close(FD);
   return ret;
 }
@@ -308,7 +312,8 @@ error_code MemoryBuffer::getOpenFile(int FD, const char *Filename,
                                      OwningPtr<MemoryBuffer> &result,
                                      uint64_t FileSize, uint64_t MapSize,
                                      int64_t Offset,
-                                     bool RequiresNullTerminator) {
+                                     bool RequiresNullTerminator,
+                                     AccessPattern Access) {
   static int PageSize = sys::process::get_self()->page_size();
 
   // Default is to map the full file.
@@ -342,6 +347,13 @@ error_code MemoryBuffer::getOpenFile(int FD, const char *Filename,
     if (const char *Pages = sys::Path::MapInFilePages(FD,
                                                       RealMapSize,
                                                       RealMapOffset)) {
+      // Prime the kernel's readahead before the first page fault if the
+      // caller told us how the buffer will be read.
+      if (Access != AccessNormal)
+        sys::Path::AdviseFilePages(Pages, RealMapSize,
+                                   Access == AccessSequential
+                                     ? sys::Path::AdviceSequential
+                                     : sys::Path::AdviceWillNeed);
       result.reset(GetNamedBuffer<MemoryBufferMMapFile>(
           StringRef(Pages + Delta, MapSize), Filename, RequiresNullTerminator));
       return error_code::success();
@@ -0,0 +1,226 @@
+//===-- SamplingProfiler.cpp - In-process CPU sampler ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a SIGPROF-driven sampler for pass execution.  The pass
+// managers bracket each pass run with a SamplingScope, which publishes the
+// pass name and the name of the unit (function or module) being transformed
+// in a pair of globals.  When the profiling timer fires, the signal handler
+// charges one sample to that (pass, unit) pair in a fixed-size hash table.
+// The handler performs no allocation and takes no locks, so it is safe to run
+// at any point during compilation.  The accumulated profile is printed at
+// llvm_shutdown time.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/SamplingProfiler.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/config.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#ifdef LLVM_ON_UNIX
+#include <signal.h>
+#include <sys/time.h>
+#endif
+using namespace llvm;
+
+static cl::opt<unsigned>
+SampleFreq("sample-passes", cl::Hidden, cl::value_desc("hz"), cl::init(0),
+           cl::desc("Sample pass execution at the given frequency and print "
+                    "the profile at exit (0 = disabled)"));
+
+bool llvm::SamplingProfilerEnabled() {
+  return SampleFreq != 0;
+}
+
+//===----------------------------------------------------------------------===//
+// Sample storage
+//===----------------------------------------------------------------------===//
+
+/// The scope currently being executed.  Written by SamplingScope on the
+/// compile thread, read asynchronously by the signal handler; each is a
+/// single pointer store, so the handler sees either the old or the new
+/// scope, never a torn value.
+static const char *volatile CurPassName;
+static const char *volatile CurUnitName;
+
+/// The sample table.  Sized and probed so the signal handler never
+/// allocates; collisions past the probe limit are counted as dropped.
+namespace {
+  struct SampleSlot {
+    const char *Pass;
+    const char *Unit;
+    volatile unsigned long Count;
+  };
+}
+
+static const unsigned SampleTableSize = 512;  // Must be a power of two.
+static const unsigned ProbeLimit = 8;
+static SampleSlot SampleTable[SampleTableSize];
+static volatile unsigned long UnattributedSamples;
+static volatile unsigned long DroppedSamples;
+
+#ifdef LLVM_ON_UNIX
+static void SampleTick(int) {
+  const char *Pass = CurPassName;
+  const char *Unit = CurUnitName;
+  if (Pass == 0) {
+    ++UnattributedSamples;
+    return;
+  }
+
+  uintptr_t Hash = ((uintptr_t)Pass >> 4)*33 + ((uintptr_t)Unit >> 4);
+  for (unsigned i = 0; i != ProbeLimit; ++i) {
+    SampleSlot &Slot = SampleTable[(Hash + i) & (SampleTableSize-1)];
+    if (Slot.Pass == 0) {
+      // Claim the empty slot.  Only this handler ever writes the table, and
+      // SIGPROF is not re-entered while it runs, so a plain store suffices.
+      Slot.Pass = Pass;
+      Slot.Unit = Unit;
+      Slot.Count = 1;
+      return;
+    }
+    if (Slot.Pass == Pass && Slot.Unit == Unit) {
+      ++Slot.Count;
+      return;
+    }
+  }
+  ++DroppedSamples;
+}
+#endif
+
+//===----------------------------------------------------------------------===//
+// Timer management and reporting
+//===----------------------------------------------------------------------===//
+
+namespace {
+  /// SamplerInfo - Owns the interned unit names and prints the profile when
+  /// llvm_shutdown destroys it.
+  struct SamplerInfo {
+    /// Unit names are copied here at scope-entry time so that the sample
+    /// table never holds a pointer into a Function that may be deleted
+    /// before the report runs.
+    StringMap<char> UnitNames;
+    bool Armed;
+
+    SamplerInfo() : Armed(false) {}
+
+    void arm() {
+      if (Armed)
+        return;
+      Armed = true;
+#ifdef LLVM_ON_UNIX
+      struct sigaction SA;
+      memset(&SA, 0, sizeof(SA));
+      SA.sa_handler = SampleTick;
+      SA.sa_flags = SA_RESTART;
+      sigemptyset(&SA.sa_mask);
+      sigaction(SIGPROF, &SA, 0);
+
+      struct itimerval IT;
+      IT.it_interval.tv_sec = 0;
+      IT.it_interval.tv_usec = 1000000 / SampleFreq;
+      if (IT.it_interval.tv_usec == 0)
+        IT.it_interval.tv_usec = 1;
+      IT.it_value = IT.it_interval;
+      setitimer(ITIMER_PROF, &IT, 0);
+#endif
+    }
+
+    void disarm() {
+      if (!Armed)
+        return;
+#ifdef LLVM_ON_UNIX
+      struct itimerval IT;
+      memset(&IT, 0, sizeof(IT));
+      setitimer(ITIMER_PROF, &IT, 0);
+      signal(SIGPROF, SIG_DFL);
+#endif
+      Armed = false;
+    }
+
+    ~SamplerInfo() {
+      disarm();
+      print();
+    }
+
+    void print();
+  };
+
+  struct SlotSorter {
+    bool operator()(const SampleSlot *LHS, const SampleSlot *RHS) const {
+      return LHS->Count > RHS->Count;
+    }
+  };
+}
+
+static ManagedStatic<SamplerInfo> TheSampler;
+
+void SamplerInfo::print() {
+  std::vector<const SampleSlot*> Live;
+  unsigned long Total = UnattributedSamples;
+  for (unsigned i = 0; i != SampleTableSize; ++i)
+    if (SampleTable[i].Pass) {
+      Live.push_back(&SampleTable[i]);
+      Total += SampleTable[i].Count;
+    }
+  if (Total == 0 && DroppedSamples == 0)
+    return;
+
+  // Collapsed-stack format: one "pass;unit count" line per scope, hottest
+  // first, ready for flame-graph style post-processing.
+  raw_ostream &OS = errs();
+  OS << "===" << std::string(73, '-') << "===\n";
+  OS << "                          Pass Execution Samples (" << SampleFreq
+     << " Hz)\n";
+  OS << "===" << std::string(73, '-') << "===\n";
+  std::sort(Live.begin(), Live.end(), SlotSorter());
+  for (unsigned i = 0, e = Live.size(); i != e; ++i)
+    OS << Live[i]->Pass << ';' << Live[i]->Unit << ' ' << Live[i]->Count
+       << '\n';
+  if (UnattributedSamples)
+    OS << "<outside passes>; " << UnattributedSamples << '\n';
+  if (DroppedSamples)
+    OS << "; " << DroppedSamples << " sample(s) dropped (table full)\n";
+}
+
+//===----------------------------------------------------------------------===//
+// SamplingScope
+//===----------------------------------------------------------------------===//
+
+SamplingScope::SamplingScope(const char *PassName, StringRef UnitName) {
+  if (!SampleFreq) {
+    OldPass = 0;
+    return;
+  }
+  SamplerInfo &SI = *TheSampler;
+  SI.arm();
+
+  // Intern the unit name to get a pointer that outlives the IR.  This runs
+  // on the compile thread, not in the handler, so allocation is fine.
+  const char *Unit = SI.UnitNames.GetOrCreateValue(UnitName).getKeyData();
+
+  OldPass = CurPassName;
+  OldUnit = CurUnitName;
+  // Publish the unit first so the handler never pairs the new pass with the
+  // old unit's name.
+  CurUnitName = Unit;
+  CurPassName = PassName;
+}
+
+SamplingScope::~SamplingScope() {
+  if (!SampleFreq)
+    return;
+  CurPassName = OldPass;
+  CurUnitName = OldUnit;
+}
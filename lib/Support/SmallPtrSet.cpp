@@ -20,19 +20,28 @@
 
 using namespace llvm;
 
+/// Return how far \p Ptr would sit from its ideal bucket if stored in
+/// \p Bucket of a table with \p ArraySize buckets.
+static inline unsigned ProbeDistance(const void *Ptr, unsigned Bucket,
+                                     unsigned ArraySize) {
+  unsigned IdealBucket =
+    DenseMapInfo<void *>::getHashValue(Ptr) & (ArraySize-1);
+  return (Bucket - IdealBucket) & (ArraySize-1);
+}
+
 void SmallPtrSetImpl::shrink_and_clear() {
   assert(!isSmall() && "Can't shrink a small set!");
   free(CurArray);
 
   // Reduce the number of buckets.
   CurArraySize = NumElements > 16 ? 1 << (Log2_32_Ceil(NumElements) + 1) : 32;
-  NumElements = NumTombstones = 0;
+  NumElements = 0;
 
   // Install the new array.  Clear all the buckets to empty.
   CurArray = (const void**)malloc(sizeof(void*) * (CurArraySize+1));
   assert(CurArray && "Failed to allocate memory?");
   memset(CurArray, -1, CurArraySize*sizeof(void*));
-  
+
   // The end pointer, always valid, is set to a valid element to help the
   // iterator.
   CurArray[CurArraySize] = 0;
@@ -45,7 +54,7 @@ bool SmallPtrSetImpl::insert_imp(const void * Ptr) {
          APtr != E; ++APtr)
       if (*APtr == Ptr)
         return false;
-    
+
     // Nope, there isn't.  If we stay small, just 'pushback' now.
     if (NumElements < CurArraySize-1) {
       SmallArray[NumElements++] = Ptr;
@@ -53,24 +62,23 @@ bool SmallPtrSetImpl::insert_imp(const void * Ptr) {
     }
     // Otherwise, hit the big set case, which will call grow.
   }
-  
+
   if (NumElements*4 >= CurArraySize*3) {
     // If more than 3/4 of the array is full, grow.
     Grow(CurArraySize < 64 ? 128 : CurArraySize*2);
-  } else if (CurArraySize-(NumElements+NumTombstones) < CurArraySize/8) {
-    // If fewer of 1/8 of the array is empty (meaning that many are filled with
-    // tombstones), rehash.
-    Grow(CurArraySize);
   }
-  
+
   // Okay, we know we have space.  Find a hash bucket.
   const void **Bucket = const_cast<const void**>(FindBucketFor(Ptr));
   if (*Bucket == Ptr) return false; // Already inserted, good.
-  
-  // Otherwise, insert it!
-  if (*Bucket == getTombstoneMarker())
-    --NumTombstones;
-  *Bucket = Ptr;
+
+  // Otherwise, insert it!  If the probe stopped on an empty bucket we can
+  // store directly; otherwise it stopped on an element that must keep its
+  // spot, so re-run the insertion with displacement.
+  if (*Bucket == getEmptyMarker())
+    *Bucket = Ptr;
+  else
+    PlaceEntry(Ptr);
   ++NumElements;  // Track density.
   return true;
 }
@@ -87,45 +95,84 @@ bool SmallPtrSetImpl::erase_imp(const void * Ptr) {
         --NumElements;
         return true;
       }
-    
+
     return false;
   }
-  
-  // Okay, we know we have space.  Find a hash bucket.
-  void **Bucket = const_cast<void**>(FindBucketFor(Ptr));
+
+  // Okay, find the hash bucket holding the pointer.
+  const void **Bucket = const_cast<const void**>(FindBucketFor(Ptr));
   if (*Bucket != Ptr) return false;  // Not in the set?
 
-  // Set this as a tombstone.
-  *Bucket = getTombstoneMarker();
+  // Backward-shift deletion: pull the chain behind the hole back one bucket
+  // until we hit an empty bucket or an element already in its ideal spot.
+  // This keeps the robin-hood invariant intact without needing tombstones.
+  unsigned ArraySize = CurArraySize;
+  const void **Array = const_cast<const void**>(CurArray);
+  unsigned Hole = Bucket - Array;
+  while (1) {
+    unsigned Next = (Hole + 1) & (ArraySize-1);
+    const void *Elt = Array[Next];
+    if (Elt == getEmptyMarker() || ProbeDistance(Elt, Next, ArraySize) == 0)
+      break;
+    Array[Hole] = Elt;
+    Hole = Next;
+  }
+  Array[Hole] = getEmptyMarker();
   --NumElements;
-  ++NumTombstones;
   return true;
 }
 
 const void * const *SmallPtrSetImpl::FindBucketFor(const void *Ptr) const {
-  unsigned Bucket = DenseMapInfo<void *>::getHashValue(Ptr) & (CurArraySize-1);
   unsigned ArraySize = CurArraySize;
-  unsigned ProbeAmt = 1;
+  unsigned Bucket = DenseMapInfo<void *>::getHashValue(Ptr) & (ArraySize-1);
   const void *const *Array = CurArray;
-  const void *const *Tombstone = 0;
+  unsigned Dist = 0;
   while (1) {
+    const void *Elt = Array[Bucket];
     // Found Ptr's bucket?
-    if (Array[Bucket] == Ptr)
+    if (Elt == Ptr)
       return Array+Bucket;
-    
+
     // If we found an empty bucket, the pointer doesn't exist in the set.
-    // Return a tombstone if we've seen one so far, or the empty bucket if
-    // not.
-    if (Array[Bucket] == getEmptyMarker())
-      return Tombstone ? Tombstone : Array+Bucket;
-    
-    // If this is a tombstone, remember it.  If Ptr ends up not in the set, we
-    // prefer to return it than something that would require more probing.
-    if (Array[Bucket] == getTombstoneMarker() && !Tombstone)
-      Tombstone = Array+Bucket;  // Remember the first tombstone found.
-    
-    // It's a hash collision or a tombstone. Reprobe.
-    Bucket = (Bucket + ProbeAmt++) & (ArraySize-1);
+    if (Elt == getEmptyMarker())
+      return Array+Bucket;
+
+    // The robin-hood invariant guarantees no element sits further from its
+    // ideal bucket than the elements it displaced, so once the occupant is
+    // closer to its ideal bucket than Ptr would be, Ptr cannot appear later
+    // in the chain.  Returning this (occupied) bucket signals 'not found'.
+    if (ProbeDistance(Elt, Bucket, ArraySize) < Dist)
+      return Array+Bucket;
+
+    // It's a hash collision.  Reprobe.
+    Bucket = (Bucket + 1) & (ArraySize-1);
+    ++Dist;
+  }
+}
+
+void SmallPtrSetImpl::PlaceEntry(const void *Ptr) {
+  unsigned ArraySize = CurArraySize;
+  const void **Array = const_cast<const void**>(CurArray);
+  unsigned Bucket = DenseMapInfo<void *>::getHashValue(Ptr) & (ArraySize-1);
+  unsigned Dist = 0;
+  const void *Carried = Ptr;
+  while (1) {
+    const void *Elt = Array[Bucket];
+    if (Elt == getEmptyMarker()) {
+      Array[Bucket] = Carried;
+      return;
+    }
+
+    // Steal the bucket from any element closer to its ideal spot than the
+    // carried element is to its own, and carry the evictee onwards.
+    unsigned EltDist = ProbeDistance(Elt, Bucket, ArraySize);
+    if (EltDist < Dist) {
+      Array[Bucket] = Carried;
+      Carried = Elt;
+      Dist = EltDist;
+    }
+    Bucket = (Bucket + 1) & (ArraySize-1);
+    ++Dist;
   }
 }
 
@@ -134,40 +181,37 @@ const void * const *SmallPtrSetImpl::FindBucketFor(const void *Ptr) const {
 void SmallPtrSetImpl::Grow(unsigned NewSize) {
   // Allocate at twice as many buckets, but at least 128.
   unsigned OldSize = CurArraySize;
-  
+
   const void **OldBuckets = CurArray;
   bool WasSmall = isSmall();
-  
+
   // Install the new array.  Clear all the buckets to empty.
   CurArray = (const void**)malloc(sizeof(void*) * (NewSize+1));
   assert(CurArray && "Failed to allocate memory?");
   CurArraySize = NewSize;
   memset(CurArray, -1, NewSize*sizeof(void*));
-  
+
   // The end pointer, always valid, is set to a valid element to help the
   // iterator.
   CurArray[NewSize] = 0;
-  
+
   // Copy over all the elements.
   if (WasSmall) {
     // Small sets store their elements in order.
     for (const void **BucketPtr = OldBuckets, **E = OldBuckets+NumElements;
-         BucketPtr != E; ++BucketPtr) {
-      const void *Elt = *BucketPtr;
-      *const_cast<void**>(FindBucketFor(Elt)) = const_cast<void*>(Elt);
-    }
+         BucketPtr != E; ++BucketPtr)
+      PlaceEntry(*BucketPtr);
   } else {
     // Copy over all valid entries.
     for (const void **BucketPtr = OldBuckets, **E = OldBuckets+OldSize;
          BucketPtr != E; ++BucketPtr) {
       // Copy over the element if it is valid.
       const void *Elt = *BucketPtr;
-      if (Elt != getTombstoneMarker() && Elt != getEmptyMarker())
-        *const_cast<void**>(FindBucketFor(Elt)) = const_cast<void*>(Elt);
+      if (Elt != getEmptyMarker())
+        PlaceEntry(Elt);
     }
-    
+
     free(OldBuckets);
-    NumTombstones = 0;
   }
 }
 
@@ -183,15 +227,14 @@ SmallPtrSetImpl::SmallPtrSetImpl(const void **SmallStorage,
     CurArray = (const void**)malloc(sizeof(void*) * (that.CurArraySize+1));
     assert(CurArray && "Failed to allocate memory?");
   }
-  
+
   // Copy over the new array size
   CurArraySize = that.CurArraySize;
 
   // Copy over the contents from the other set
   memcpy(CurArray, that.CurArray, sizeof(void*)*(CurArraySize+1));
-  
+
   NumElements = that.NumElements;
-  NumTombstones = that.NumTombstones;
 }
 
 /// CopyFrom - implement operator= from a smallptrset that has the same pointer
@@ -200,7 +243,7 @@ void SmallPtrSetImpl::CopyFrom(const SmallPtrSetImpl &RHS) {
   if (isSmall() && RHS.isSmall())
     assert(CurArraySize == RHS.CurArraySize &&
            "Cannot assign sets with different small sizes");
-           
+
   // If we're becoming small, prepare to insert into our stack space
   if (RHS.isSmall()) {
     if (!isSmall())
@@ -214,15 +257,14 @@ void SmallPtrSetImpl::CopyFrom(const SmallPtrSetImpl &RHS) {
       CurArray = (const void**)realloc(CurArray, sizeof(void*)*(RHS.CurArraySize+1));
     assert(CurArray && "Failed to allocate memory?");
   }
-  
+
   // Copy over the new array size
   CurArraySize = RHS.CurArraySize;
 
   // Copy over the contents from the other set
   memcpy(CurArray, RHS.CurArray, sizeof(void*)*(CurArraySize+1));
-  
+
   NumElements = RHS.NumElements;
-  NumTombstones = RHS.NumTombstones;
 }
 
 void SmallPtrSetImpl::swap(SmallPtrSetImpl &RHS) {
@@ -233,7 +275,6 @@ void SmallPtrSetImpl::swap(SmallPtrSetImpl &RHS) {
     std::swap(this->CurArray, RHS.CurArray);
     std::swap(this->CurArraySize, RHS.CurArraySize);
     std::swap(this->NumElements, RHS.NumElements);
-    std::swap(this->NumTombstones, RHS.NumTombstones);
     return;
   }
 
@@ -247,9 +288,7 @@ void SmallPtrSetImpl::swap(SmallPtrSetImpl &RHS) {
     std::swap(this->NumElements, RHS.NumElements);
     std::swap(this->CurArraySize, RHS.CurArraySize);
     RHS.CurArray = this->CurArray;
-    RHS.NumTombstones = this->NumTombstones;
     this->CurArray = this->SmallArray;
-    this->NumTombstones = 0;
     return;
   }
 
@@ -261,9 +300,7 @@ void SmallPtrSetImpl::swap(SmallPtrSetImpl &RHS) {
     std::swap(RHS.NumElements, this->NumElements);
     std::swap(RHS.CurArraySize, this->CurArraySize);
     this->CurArray = RHS.CurArray;
-    this->NumTombstones = RHS.NumTombstones;
     RHS.CurArray = RHS.SmallArray;
-    RHS.NumTombstones = 0;
     return;
   }
 
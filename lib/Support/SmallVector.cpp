@@ -12,17 +12,61 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/SmallVector.h"
+#include <cstdio>
+#include <map>
 using namespace llvm;
 
+namespace {
+  /// GrowStatsMap - Per-call-site counts of heap growth events, collected in
+  /// builds instrumented with -DLLVM_SMALLVECTOR_STATS and dumped to stderr
+  /// when the process exits.  Counts are unsynchronized and thus approximate
+  /// in multithreaded runs, which is fine for a sizing survey.
+  struct GrowStatsMap {
+    std::map<void *, std::pair<size_t, unsigned> > Counts;
+    ~GrowStatsMap() {
+      for (std::map<void *, std::pair<size_t, unsigned> >::iterator
+             I = Counts.begin(), E = Counts.end(); I != E; ++I)
+        fprintf(stderr, "smallvector-grow\tsite %p\telt-size %u\tcount %u\n",
+                I->first, unsigned(I->second.first), I->second.second);
+    }
+  };
+}
+
+// Construct the stats map lazily so uninstrumented builds do not pay for a
+// static constructor.
+static GrowStatsMap &getGrowStats() {
+  static GrowStatsMap GrowStats;
+  return GrowStats;
+}
+
+void SmallVectorBase::record_grow(void *CallSite, size_t TSize) {
+  std::pair<size_t, unsigned> &Entry = getGrowStats().Counts[CallSite];
+  Entry.first = TSize;
+  ++Entry.second;
+}
+
 /// grow_pod - This is an implementation of the grow() method which only works
 /// on POD-like datatypes and is out of line to reduce code duplication.
 void SmallVectorBase::grow_pod(void *FirstEl, size_t MinSizeInBytes,
                                size_t TSize) {
   size_t CurSizeBytes = size_in_bytes();
-  size_t NewCapacityInBytes = 2 * capacity_in_bytes() + TSize; // Always grow.
+  size_t CurCapacityBytes = capacity_in_bytes();
+
+  // Double while the buffer is small, then grow by 1.5x: a small vector wants
+  // to escape the reallocation regime quickly, while a large one is dominated
+  // by peak memory and copy cost.
+  size_t NewCapacityInBytes;
+  if (CurCapacityBytes < 4096)
+    NewCapacityInBytes = 2 * CurCapacityBytes + TSize; // Always grow.
+  else
+    NewCapacityInBytes = CurCapacityBytes + CurCapacityBytes / 2;
   if (NewCapacityInBytes < MinSizeInBytes)
     NewCapacityInBytes = MinSizeInBytes;
 
+#ifdef LLVM_SMALLVECTOR_STATS
+  record_grow(__builtin_return_address(0), TSize);
+#endif
+
   void *NewElts;
   if (BeginX == FirstEl) {
     NewElts = malloc(NewCapacityInBytes);
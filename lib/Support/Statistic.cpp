@@ -22,12 +22,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
+#include "llvm/Support/ThreadLocal.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstring>
@@ -63,6 +65,69 @@ public:
 static ManagedStatic<StatisticInfo> StatInfo;
 static ManagedStatic<sys::SmartMutex<true> > StatLock;
 
+namespace {
+/// StatisticShard - The counter deltas accumulated by one thread.  Threads
+/// update their own shard without any synchronization; the deltas are folded
+/// into the global Statistic values when the statistics are printed.
+class StatisticShard {
+public:
+  DenseMap<Statistic *, int> Deltas;
+};
+
+/// ShardRegistry - Hands each thread its own StatisticShard and remembers
+/// all of the shards so they can be aggregated later.  Only shard creation
+/// takes the lock; counter updates are lock free.
+class ShardRegistry {
+  sys::SmartMutex<true> Lock;
+  std::vector<StatisticShard *> Shards;
+  sys::ThreadLocal<const StatisticShard> Current;
+public:
+  ~ShardRegistry() {
+    for (size_t i = 0, e = Shards.size(); i != e; ++i)
+      delete Shards[i];
+  }
+
+  StatisticShard *get() {
+    if (const StatisticShard *S = Current.get())
+      return const_cast<StatisticShard *>(S);
+    StatisticShard *S = new StatisticShard();
+    Current.set(S);
+    sys::SmartScopedLock<true> Writer(Lock);
+    Shards.push_back(S);
+    return S;
+  }
+
+  /// flush - Fold every shard's accumulated deltas into the global
+  /// Statistic values and empty the shards.
+  void flush() {
+    sys::SmartScopedLock<true> Writer(Lock);
+    for (size_t i = 0, e = Shards.size(); i != e; ++i) {
+      DenseMap<Statistic *, int> &Deltas = Shards[i]->Deltas;
+      for (DenseMap<Statistic *, int>::iterator I = Deltas.begin(),
+           E = Deltas.end(); I != E; ++I)
+        sys::AtomicAdd(&I->first->Value, I->second);
+      Deltas.clear();
+    }
+  }
+};
+}
+
+static ManagedStatic<ShardRegistry> StatShards;
+
+/// addSharded - Record a counter update in the calling thread's shard.
+void Statistic::addSharded(int V) {
+  StatShards->get()->Deltas[this] += V;
+}
+
+/// FlushStatisticShards - Fold every thread's accumulated deltas into the
+/// global Statistic values.  Called before the statistics are printed; any
+/// updates made by still-running threads after this point are not lost, they
+/// simply remain in the shards for the next aggregation.
+static void FlushStatisticShards() {
+  if (StatShards.isConstructed())
+    StatShards->flush();
+}
+
 /// RegisterStatistic - The first time a statistic is bumped, this method is
 /// called.
 void Statistic::RegisterStatistic() {
@@ -110,6 +175,9 @@ bool llvm::AreStatisticsEnabled() {
 }
 
 void llvm::PrintStatistics(raw_ostream &OS) {
+  // Fold the per-thread counter shards into the global values first.
+  FlushStatisticShards();
+
   StatisticInfo &Stats = *StatInfo;
 
   // Figure out how long the biggest Value and Name fields are.
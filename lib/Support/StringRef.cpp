@@ -125,12 +125,27 @@ size_t StringRef::find(StringRef Str, size_t From) const {
   size_t N = Str.size();
   if (N > Length)
     return npos;
-
-  // For short haystacks or unsupported needles fall back to the naive algorithm
-  if (Length < 16 || N > 255 || N == 0) {
-    for (size_t e = Length - N + 1, i = min(From, e); i != e; ++i)
+  if (N == 0)
+    return From <= Length ? From : npos;
+
+  // Single characters are better served by memchr.
+  if (N == 1)
+    return find(Str[0], From);
+
+  // For short haystacks or unsupported needles fall back to the naive
+  // algorithm, but let memchr skip to each candidate position instead of
+  // testing every offset.
+  if (Length < 16 || N > 255) {
+    size_t e = Length - N + 1;
+    for (size_t i = min(From, e); i != e; ) {
+      const void *P = ::memchr(Data + i, Str[0], e - i);
+      if (P == 0)
+        return npos;
+      i = static_cast<const char *>(P) - Data;
       if (substr(i, N).equals(Str))
         return i;
+      ++i;
+    }
     return npos;
   }
 
@@ -179,6 +194,10 @@ size_t StringRef::rfind(StringRef Str) const {
 /// Note: O(size() + Chars.size())
 StringRef::size_type StringRef::find_first_of(StringRef Chars,
                                               size_t From) const {
+  // A single character doesn't need the bitmap; memchr is much faster.
+  if (Chars.size() == 1)
+    return find(Chars[0], From);
+
   std::bitset<1 << CHAR_BIT> CharBits;
   for (size_type i = 0; i != Chars.size(); ++i)
     CharBits.set((unsigned char)Chars[i]);
@@ -204,6 +223,9 @@ StringRef::size_type StringRef::find_first_not_of(char C, size_t From) const {
 /// Note: O(size() + Chars.size())
 StringRef::size_type StringRef::find_first_not_of(StringRef Chars,
                                                   size_t From) const {
+  if (Chars.size() == 1)
+    return find_first_not_of(Chars[0], From);
+
   std::bitset<1 << CHAR_BIT> CharBits;
   for (size_type i = 0; i != Chars.size(); ++i)
     CharBits.set((unsigned char)Chars[i]);
@@ -220,6 +242,9 @@ StringRef::size_type StringRef::find_first_not_of(StringRef Chars,
 /// Note: O(size() + Chars.size())
 StringRef::size_type StringRef::find_last_of(StringRef Chars,
                                              size_t From) const {
+  if (Chars.size() == 1)
+    return rfind(Chars[0], From);
+
   std::bitset<1 << CHAR_BIT> CharBits;
   for (size_type i = 0; i != Chars.size(); ++i)
     CharBits.set((unsigned char)Chars[i]);
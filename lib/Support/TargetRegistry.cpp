@@ -9,7 +9,9 @@
 
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Atomic.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
@@ -19,6 +21,28 @@ using namespace llvm;
 // Clients are responsible for avoid race conditions in registration.
 static Target *FirstTarget = 0;
 
+namespace {
+/// LookupCacheEntry - A memoized triple lookup. Entries are immutable once
+/// published and are never deallocated.
+struct LookupCacheEntry {
+  std::string TripleStr;
+  const Target *TheTarget;
+};
+} // end anonymous namespace.
+
+enum { LookupCacheSize = 16 };
+
+// Direct-mapped cache of triple lookups, active only after freezeRegistry().
+// Each slot is claimed with a compare-and-swap and written exactly once, so
+// readers see either null or a fully constructed entry without taking a lock.
+static bool RegistryFrozen = false;
+static LookupCacheEntry *volatile LookupCache[LookupCacheSize];
+static sys::cas_flag LookupCacheClaimed[LookupCacheSize];
+
+void TargetRegistry::freezeRegistry() {
+  RegistryFrozen = true;
+}
+
 TargetRegistry::iterator TargetRegistry::begin() {
   return iterator(FirstTarget);
 }
@@ -66,6 +90,16 @@ const Target *TargetRegistry::lookupTarget(const std::string &ArchName,
 
 const Target *TargetRegistry::lookupTarget(const std::string &TT,
                                            std::string &Error) {
+  // Once the registry is frozen the answer for a triple can never change, so
+  // check the lock-free lookup cache before walking the target list.
+  unsigned CacheIdx = 0;
+  if (RegistryFrozen) {
+    CacheIdx = HashString(TT) % LookupCacheSize;
+    if (LookupCacheEntry *E = LookupCache[CacheIdx])
+      if (E->TripleStr == TT)
+        return E->TheTarget;
+  }
+
   // Provide special warning when no targets are initialized.
   if (begin() == end()) {
     Error = "Unable to find target for this triple (no targets are registered)";
@@ -98,6 +132,17 @@ const Target *TargetRegistry::lookupTarget(const std::string &TT,
     return 0;
   }
 
+  // Memoize the result. The slot is claimed atomically and the entry made
+  // visible before the pointer is published; losers just stay uncached.
+  if (RegistryFrozen &&
+      sys::CompareAndSwap(&LookupCacheClaimed[CacheIdx], 1, 0) == 0) {
+    LookupCacheEntry *E = new LookupCacheEntry();
+    E->TripleStr = TT;
+    E->TheTarget = Best;
+    sys::MemoryFence();
+    LookupCache[CacheIdx] = E;
+  }
+
   return Best;
 }
 
@@ -113,7 +158,10 @@ void TargetRegistry::RegisterTarget(Target &T,
   // convenience to some clients.
   if (T.Name)
     return;
-         
+
+  assert(!RegistryFrozen &&
+         "Cannot register new targets after freezeRegistry()");
+
   // Add to the list of targets.
   T.Next = FirstTarget;
   FirstTarget = &T;
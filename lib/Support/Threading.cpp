@@ -102,6 +102,60 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
  error:
   ::pthread_attr_destroy(&Attr);
 }
+
+struct LaunchedThreadInfo {
+  pthread_t Thread;
+  void (*UserFn)(void *);
+  void *UserData;
+};
+
+static void *LaunchThread_Dispatch(void *Arg) {
+  LaunchedThreadInfo *TI = reinterpret_cast<LaunchedThreadInfo*>(Arg);
+  TI->UserFn(TI->UserData);
+  return 0;
+}
+
+void *llvm::llvm_launch_thread(void (*Fn)(void*), void *UserData,
+                               unsigned RequestedStackSize) {
+  LaunchedThreadInfo *Info = new LaunchedThreadInfo();
+  Info->UserFn = Fn;
+  Info->UserData = UserData;
+
+  pthread_attr_t Attr;
+  if (::pthread_attr_init(&Attr) != 0) {
+    delete Info;
+    Fn(UserData);
+    return 0;
+  }
+
+  bool Failed = false;
+  if (RequestedStackSize != 0 &&
+      ::pthread_attr_setstacksize(&Attr, RequestedStackSize) != 0)
+    Failed = true;
+
+  if (!Failed &&
+      ::pthread_create(&Info->Thread, &Attr, LaunchThread_Dispatch, Info) != 0)
+    Failed = true;
+
+  ::pthread_attr_destroy(&Attr);
+
+  if (Failed) {
+    // Fall back to running the function on the calling thread.
+    delete Info;
+    Fn(UserData);
+    return 0;
+  }
+
+  return Info;
+}
+
+void llvm::llvm_join_thread(void *Thread) {
+  if (!Thread)
+    return;
+  LaunchedThreadInfo *Info = reinterpret_cast<LaunchedThreadInfo*>(Thread);
+  ::pthread_join(Info->Thread, 0);
+  delete Info;
+}
 #elif LLVM_ENABLE_THREADS!=0 && defined(LLVM_ON_WIN32)
 #include "Windows/Windows.h"
 #include <process.h>
@@ -136,6 +190,48 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
     ::CloseHandle(hThread);
   }
 }
+
+struct LaunchedThreadInfo {
+  HANDLE hThread;
+  void (*func)(void*);
+  void *param;
+};
+
+static unsigned __stdcall LaunchedThreadCallback(void *param) {
+  struct LaunchedThreadInfo *info =
+    reinterpret_cast<struct LaunchedThreadInfo *>(param);
+  info->func(info->param);
+
+  return 0;
+}
+
+void *llvm::llvm_launch_thread(void (*Fn)(void*), void *UserData,
+                               unsigned RequestedStackSize) {
+  LaunchedThreadInfo *Info = new LaunchedThreadInfo();
+  Info->func = Fn;
+  Info->param = UserData;
+
+  Info->hThread = (HANDLE)::_beginthreadex(NULL, RequestedStackSize,
+                                           LaunchedThreadCallback, Info,
+                                           0, NULL);
+  if (!Info->hThread) {
+    // Fall back to running the function on the calling thread.
+    delete Info;
+    Fn(UserData);
+    return 0;
+  }
+
+  return Info;
+}
+
+void llvm::llvm_join_thread(void *Thread) {
+  if (!Thread)
+    return;
+  LaunchedThreadInfo *Info = reinterpret_cast<LaunchedThreadInfo*>(Thread);
+  (void)::WaitForSingleObject(Info->hThread, INFINITE);
+  ::CloseHandle(Info->hThread);
+  delete Info;
+}
 #else
 // Support for non-Win32, non-pthread implementation.
 void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
@@ -144,4 +240,35 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
   Fn(UserData);
 }
 
+void *llvm::llvm_launch_thread(void (*Fn)(void*), void *UserData,
+                               unsigned RequestedStackSize) {
+  (void) RequestedStackSize;
+  Fn(UserData);
+  return 0;
+}
+
+void llvm::llvm_join_thread(void *Thread) {
+  (void) Thread;
+}
+
+#endif
+
+#if LLVM_ENABLE_THREADS != 0 && defined(HAVE_PTHREAD_H) && defined(__linux__)
+#include <sched.h>
+
+bool llvm::llvm_set_thread_affinity(unsigned CPU) {
+  cpu_set_t Set;
+  CPU_ZERO(&Set);
+  CPU_SET(CPU, &Set);
+  return ::pthread_setaffinity_np(::pthread_self(), sizeof(Set), &Set) == 0;
+}
+#elif LLVM_ENABLE_THREADS != 0 && defined(LLVM_ON_WIN32)
+bool llvm::llvm_set_thread_affinity(unsigned CPU) {
+  return ::SetThreadAffinityMask(::GetCurrentThread(),
+                                 DWORD_PTR(1) << CPU) != 0;
+}
+#else
+bool llvm::llvm_set_thread_affinity(unsigned) {
+  return false;
+}
 #endif
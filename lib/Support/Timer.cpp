@@ -14,6 +14,7 @@
 #include "llvm/Support/Timer.h"
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Format.h"
@@ -47,6 +48,12 @@ namespace {
                                       "tracking (this may be slow)"),
              cl::Hidden);
 
+  static cl::opt<bool>
+  TimerJSON("timer-json",
+            cl::desc("Emit timer reports as one JSON record per timer group "
+                     "instead of human-readable tables"),
+            cl::Hidden);
+
   static cl::opt<std::string, true>
   InfoOutputFilename("info-output-file", cl::value_desc("filename"),
                      cl::desc("File to append -stats and -timer output to"),
@@ -103,6 +110,8 @@ static TimerGroup *getDefaultTimerGroup() {
 void Timer::init(StringRef N) {
   assert(TG == 0 && "Timer already initialized");
   Name.assign(N.begin(), N.end());
+  PeakMem = 0;
+  MemBaseline = 0;
   Started = false;
   TG = getDefaultTimerGroup();
   TG->addTimer(*this);
@@ -111,6 +120,8 @@ void Timer::init(StringRef N) {
 void Timer::init(StringRef N, TimerGroup &tg) {
   assert(TG == 0 && "Timer already initialized");
   Name.assign(N.begin(), N.end());
+  PeakMem = 0;
+  MemBaseline = 0;
   Started = false;
   TG = &tg;
   TG->addTimer(*this);
@@ -147,11 +158,34 @@ TimeRecord TimeRecord::getCurrentTime(bool Start) {
 static ManagedStatic<std::vector<Timer*> > ActiveTimers;
 
 void Timer::startTimer() {
+  // Remember which timer was active when this one first ran; timers nest the
+  // way their clients do (e.g. pass managers), so this records the scope
+  // hierarchy for reporting.
+  if (!Started && !ActiveTimers->empty())
+    Parent = ActiveTimers->back()->Name;
   Started = true;
+  if (TrackSpace)
+    MemBaseline = SlabAllocatedBytes();
   ActiveTimers->push_back(this);
   Time -= TimeRecord::getCurrentTime(true);
 }
 
+/// trackSlabMemory - The slab allocators call this each time a slab is
+/// acquired.  Record the high-water mark of live slab bytes above each
+/// running timer's baseline; the PassManager's nested timers give this
+/// per-pass attribution under -time-passes.
+void Timer::trackSlabMemory(size_t BytesInUse) {
+  if (!TrackSpace || !ActiveTimers.isConstructed())
+    return;
+  std::vector<Timer*> &Stack = *ActiveTimers;
+  for (unsigned i = 0, e = Stack.size(); i != e; ++i) {
+    Timer *T = Stack[i];
+    if (BytesInUse > T->MemBaseline &&
+        (ssize_t)(BytesInUse - T->MemBaseline) > T->PeakMem)
+      T->PeakMem = BytesInUse - T->MemBaseline;
+  }
+}
+
 void Timer::stopTimer() {
   Time += TimeRecord::getCurrentTime(false);
 
@@ -281,7 +315,7 @@ void TimerGroup::removeTimer(Timer &T) {
   
   // If the timer was started, move its data to TimersToPrint.
   if (T.Started)
-    TimersToPrint.push_back(std::make_pair(T.Time, T.Name));
+    TimersToPrint.push_back(PrintRecord(T.Time, T.Name, T.Parent, T.PeakMem));
 
   T.TG = 0;
   
@@ -312,13 +346,22 @@ void TimerGroup::addTimer(Timer &T) {
 }
 
 void TimerGroup::PrintQueuedTimers(raw_ostream &OS) {
+  if (TimerJSON) {
+    printJSONQueuedTimers(OS);
+    return;
+  }
+
   // Sort the timers in descending order by amount of time taken.
   std::sort(TimersToPrint.begin(), TimersToPrint.end());
-  
+
   TimeRecord Total;
-  for (unsigned i = 0, e = TimersToPrint.size(); i != e; ++i)
-    Total += TimersToPrint[i].first;
-  
+  ssize_t MaxPeakMem = 0;
+  for (unsigned i = 0, e = TimersToPrint.size(); i != e; ++i) {
+    Total += TimersToPrint[i].Time;
+    if (TimersToPrint[i].PeakMem > MaxPeakMem)
+      MaxPeakMem = TimersToPrint[i].PeakMem;
+  }
+
   // Print out timing header.
   OS << "===" << std::string(73, '-') << "===\n";
   // Figure out how many spaces to indent TimerGroup name.
@@ -344,19 +387,73 @@ void TimerGroup::PrintQueuedTimers(raw_ostream &OS) {
   OS << "   ---Wall Time---";
   if (Total.getMemUsed())
     OS << "  ---Mem---";
+  if (MaxPeakMem)
+    OS << "  -Peak Mem-";
   OS << "  --- Name ---\n";
-  
+
   // Loop through all of the timing data, printing it out.
   for (unsigned i = 0, e = TimersToPrint.size(); i != e; ++i) {
-    const std::pair<TimeRecord, std::string> &Entry = TimersToPrint[e-i-1];
-    Entry.first.print(Total, OS);
-    OS << Entry.second << '\n';
+    const PrintRecord &Entry = TimersToPrint[e-i-1];
+    Entry.Time.print(Total, OS);
+    if (MaxPeakMem)
+      OS << format("%10" PRId64 "  ", (int64_t)Entry.PeakMem);
+    OS << Entry.Name << '\n';
   }
-  
+
   Total.print(Total, OS);
+  if (MaxPeakMem)   // Peaks don't sum; leave the column blank on this row.
+    OS.indent(12);
   OS << "Total\n\n";
   OS.flush();
-  
+
+  TimersToPrint.clear();
+}
+
+static void printJSONEscaped(StringRef S, raw_ostream &OS) {
+  for (unsigned i = 0, e = S.size(); i != e; ++i) {
+    char C = S[i];
+    if (C == '"' || C == '\\')
+      OS << '\\';
+    OS << C;
+  }
+}
+
+void TimerGroup::printJSONQueuedTimers(raw_ostream &OS) {
+  // Emit one JSON object per group on a single line, so log scrapers can
+  // consume each record independently.  The "parent" field, when present,
+  // names the timer that was active when this one first started, which
+  // reconstructs the scope nesting.  "mem" is the malloc delta in bytes and
+  // "peakMem" the peak live slab bytes above the timer's baseline; both are
+  // only emitted when -track-memory is in effect.
+  std::sort(TimersToPrint.begin(), TimersToPrint.end());
+
+  OS << "{\"group\":\"";
+  printJSONEscaped(Name, OS);
+  OS << "\",\"timers\":[";
+  for (unsigned i = 0, e = TimersToPrint.size(); i != e; ++i) {
+    const PrintRecord &Entry = TimersToPrint[e-i-1];
+    if (i)
+      OS << ',';
+    OS << "{\"name\":\"";
+    printJSONEscaped(Entry.Name, OS);
+    OS << '"';
+    if (!Entry.Parent.empty()) {
+      OS << ",\"parent\":\"";
+      printJSONEscaped(Entry.Parent, OS);
+      OS << '"';
+    }
+    OS << format(",\"wall\":%.6f,\"user\":%.6f,\"sys\":%.6f",
+                 Entry.Time.getWallTime(), Entry.Time.getUserTime(),
+                 Entry.Time.getSystemTime());
+    if (Entry.Time.getMemUsed())
+      OS << ",\"mem\":" << (int64_t)Entry.Time.getMemUsed();
+    if (Entry.PeakMem)
+      OS << ",\"peakMem\":" << (int64_t)Entry.PeakMem;
+    OS << '}';
+  }
+  OS << "]}\n";
+  OS.flush();
+
   TimersToPrint.clear();
 }
 
@@ -368,11 +465,13 @@ void TimerGroup::print(raw_ostream &OS) {
   // reset them.
   for (Timer *T = FirstTimer; T; T = T->Next) {
     if (!T->Started) continue;
-    TimersToPrint.push_back(std::make_pair(T->Time, T->Name));
-    
+    TimersToPrint.push_back(PrintRecord(T->Time, T->Name, T->Parent,
+                                        T->PeakMem));
+
     // Clear out the time.
     T->Started = 0;
     T->Time = TimeRecord();
+    T->PeakMem = 0;
   }
 
   // If any timers were started, print the group.
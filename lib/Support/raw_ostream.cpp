@@ -21,6 +21,7 @@
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Program.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/system_error.h"
 #include <cctype>
 #include <cerrno>
@@ -417,9 +418,32 @@ void format_object_base::home() {
 /// occurs, information about the error is put into ErrorInfo, and the
 /// stream should be immediately destroyed; the string will be empty
 /// if no error occurred.
+/// AsyncState - The bookkeeping for double-buffered asynchronous output.
+/// The stream formats into Buffers[CurBuffer]; when it fills, the buffer is
+/// handed to a writer thread and the other buffer is installed in its place.
+/// At most one write is in flight at a time, so the writer owns PendingPtr
+/// and PendingSize (and the stream's error flag) until it is joined.
+struct raw_fd_ostream::AsyncState {
+  char *Buffers[2];
+  size_t BufferSize;
+  unsigned CurBuffer;
+
+  /// Thread - The outstanding writer thread, or null if none.
+  void *Thread;
+
+  raw_fd_ostream *Stream;
+  const char *PendingPtr;
+  size_t PendingSize;
+
+  static void WriterMain(void *Arg) {
+    AsyncState *AS = static_cast<AsyncState*>(Arg);
+    AS->Stream->writeSync(AS->PendingPtr, AS->PendingSize);
+  }
+};
+
 raw_fd_ostream::raw_fd_ostream(const char *Filename, std::string &ErrorInfo,
                                unsigned Flags)
-  : Error(false), UseAtomicWrites(false), pos(0)
+  : Error(false), UseAtomicWrites(false), pos(0), Async(0)
 {
   assert(Filename != 0 && "Filename is null");
   // Verify that we don't have both "append" and "excl".
@@ -439,6 +463,8 @@ raw_fd_ostream::raw_fd_ostream(const char *Filename, std::string &ErrorInfo,
       sys::Program::ChangeStdoutToBinary();
     // Close stdout when we're done, to detect any output errors.
     ShouldClose = true;
+    if (Flags & F_Async)
+      EnableAsyncWrites();
     return;
   }
 
@@ -465,13 +491,16 @@ raw_fd_ostream::raw_fd_ostream(const char *Filename, std::string &ErrorInfo,
 
   // Ok, we successfully opened the file, so it'll need to be closed.
   ShouldClose = true;
+
+  if (Flags & F_Async)
+    EnableAsyncWrites();
 }
 
 /// raw_fd_ostream ctor - FD is the file descriptor that this writes to.  If
 /// ShouldClose is true, this closes the file when the stream is destroyed.
 raw_fd_ostream::raw_fd_ostream(int fd, bool shouldClose, bool unbuffered)
   : raw_ostream(unbuffered), FD(fd),
-    ShouldClose(shouldClose), Error(false), UseAtomicWrites(false) {
+    ShouldClose(shouldClose), Error(false), UseAtomicWrites(false), Async(0) {
 #ifdef O_BINARY
   // Setting STDOUT and STDERR to binary mode is necessary in Win32
   // to avoid undesirable linefeed conversion.
@@ -490,6 +519,7 @@ raw_fd_ostream::raw_fd_ostream(int fd, bool shouldClose, bool unbuffered)
 raw_fd_ostream::~raw_fd_ostream() {
   if (FD >= 0) {
     flush();
+    joinAsyncWrite();
     if (ShouldClose)
       while (::close(FD) != 0)
         if (errno != EINTR) {
@@ -498,6 +528,14 @@ raw_fd_ostream::~raw_fd_ostream() {
         }
   }
 
+  if (Async) {
+    joinAsyncWrite();
+    delete [] Async->Buffers[0];
+    delete [] Async->Buffers[1];
+    delete Async;
+    Async = 0;
+  }
+
 #ifdef __MINGW32__
   // On mingw, global dtors should not call exit().
   // report_fatal_error() invokes exit(). We know report_fatal_error()
@@ -515,10 +553,65 @@ raw_fd_ostream::~raw_fd_ostream() {
 }
 
 
+void raw_fd_ostream::EnableAsyncWrites() {
+  if (Async || Error || FD < 0)
+    return;
+
+  // Unbuffered outputs (e.g. terminals) gain nothing from a writer thread.
+  size_t Size = preferred_buffer_size();
+  if (Size == 0)
+    return;
+  // Async flushing pays off with large chunks; a megabyte amortizes the
+  // thread handoff well below the cost of the write itself.
+  if (Size < (1 << 20))
+    Size = 1 << 20;
+
+  // Flush whatever has accumulated so the first async buffer starts clean,
+  // then install it as the stream buffer.
+  flush();
+  Async = new AsyncState();
+  Async->Buffers[0] = new char[Size];
+  Async->Buffers[1] = new char[Size];
+  Async->BufferSize = Size;
+  Async->CurBuffer = 0;
+  Async->Thread = 0;
+  Async->Stream = this;
+  SetBuffer(Async->Buffers[0], Size);
+}
+
+void raw_fd_ostream::joinAsyncWrite() {
+  if (Async && Async->Thread) {
+    llvm_join_thread(Async->Thread);
+    Async->Thread = 0;
+  }
+}
+
 void raw_fd_ostream::write_impl(const char *Ptr, size_t Size) {
   assert(FD >= 0 && "File already closed.");
   pos += Size;
 
+  if (Async) {
+    // The previous buffer must reach the disk before we reuse it, and before
+    // any other write may be reordered around it.
+    joinAsyncWrite();
+    if (Ptr == Async->Buffers[Async->CurBuffer]) {
+      // Hand the filled buffer to the writer thread and keep formatting into
+      // the other one.
+      Async->PendingPtr = Ptr;
+      Async->PendingSize = Size;
+      Async->Thread = llvm_launch_thread(AsyncState::WriterMain, Async);
+      Async->CurBuffer ^= 1;
+      SetBuffer(Async->Buffers[Async->CurBuffer], Async->BufferSize);
+      return;
+    }
+    // Writes that bypass the stream buffer (chunks larger than the buffer)
+    // stay synchronous; they are rare and order matters.
+  }
+
+  writeSync(Ptr, Size);
+}
+
+void raw_fd_ostream::writeSync(const char *Ptr, size_t Size) {
   do {
     ssize_t ret;
 
@@ -569,6 +662,7 @@ void raw_fd_ostream::close() {
   assert(ShouldClose);
   ShouldClose = false;
   flush();
+  joinAsyncWrite();
   while (::close(FD) != 0)
     if (errno != EINTR) {
       error_detected();
@@ -579,6 +673,7 @@ void raw_fd_ostream::close() {
 
 uint64_t raw_fd_ostream::seek(uint64_t off) {
   flush();
+  joinAsyncWrite();
   pos = ::lseek(FD, off, SEEK_SET);
   if (pos != off)
     error_detected();
@@ -731,6 +826,18 @@ void raw_svector_ostream::resync() {
   SetBuffer(OS.end(), OS.capacity() - OS.size());
 }
 
+void raw_svector_ostream::reserveExtraSpace(uint64_t ExtraSize) {
+  // Commit any bytes sitting in the buffer first; reserving may move the
+  // vector's storage out from under them.
+  flush();
+  // Keep the usual 64 bytes of headroom even for tiny hints, matching the
+  // constructor and resync().
+  size_t Space = static_cast<size_t>(ExtraSize) < 64
+                   ? 64 : static_cast<size_t>(ExtraSize);
+  OS.reserve(OS.size() + Space);
+  SetBuffer(OS.end(), OS.capacity() - OS.size());
+}
+
 void raw_svector_ostream::write_impl(const char *Ptr, size_t Size) {
   // If we're writing bytes from the end of the buffer into the smallvector, we
   // don't need to copy the bytes, just commit the bytes because they are
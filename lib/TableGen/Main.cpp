@@ -102,26 +102,40 @@ int TableGenMain(char *argv0, TableGenMainFn *MainFn) {
   if (Parser.ParseFile())
     return 1;
 
-  std::string Error;
-  tool_output_file Out(OutputFilename.c_str(), Error);
-  if (!Error.empty()) {
-    errs() << argv0 << ": error opening " << OutputFilename
-      << ":" << Error << "\n";
-    return 1;
-  }
   if (!DependFilename.empty()) {
     if (int Ret = createDependencyFile(Parser, argv0))
       return Ret;
   }
 
-  if (MainFn(Out.os(), Records))
+  // Write the output to an in-memory buffer first.
+  std::string OutString;
+  raw_string_ostream Out(OutString);
+  if (MainFn(Out, Records))
+    return 1;
+
+  // Only update the real output file if there are any differences.  This
+  // allows everything that depends on the generated file to be rebuilt only
+  // when its contents actually change, which matters for the edit-rebuild
+  // cycle: most .td edits leave many of the generated .inc files identical.
+  if (OutputFilename != "-") {
+    OwningPtr<MemoryBuffer> ExistingFile;
+    if (!MemoryBuffer::getFile(OutputFilename.c_str(), ExistingFile))
+      if (ExistingFile->getBuffer() == Out.str())
+        return 0;
+  }
+
+  std::string Error;
+  tool_output_file OutFile(OutputFilename.c_str(), Error);
+  if (!Error.empty()) {
+    errs() << argv0 << ": error opening " << OutputFilename
+      << ":" << Error << "\n";
     return 1;
+  }
+  OutFile.os() << Out.str();
 
   // Declare success.
-  Out.keep();
+  OutFile.keep();
   return 0;
-
-  return 1;
 }
 
 }
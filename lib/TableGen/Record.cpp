@@ -22,6 +22,7 @@
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/TableGen/Error.h"
 
 using namespace llvm;
@@ -75,8 +76,67 @@ template<> struct DenseMapInfo<TableGenStringKey> {
   }
 };
 
+/// TableGenInitListKey - Hash-consing key for Inits built from a list of
+/// already-uniqued children: the child pointers plus one extra
+/// discriminator (the element type for lists, null otherwise).  Since the
+/// children are themselves interned, combining their pointers is a complete
+/// structural hash; lookups never walk grandchildren, which keeps record
+/// resolution linear in the size of the tree being built.
+class TableGenInitListKey {
+  Init *const *Data;
+  unsigned Size;
+  const void *Extra;
+public:
+  TableGenInitListKey(ArrayRef<Init *> Range, const void *Extra)
+    : Data(Range.data()), Size(Range.size()), Extra(Extra) {}
+  TableGenInitListKey(unsigned SentinelSize)
+    : Data(0), Size(SentinelSize), Extra(0) {}
+
+  unsigned hash() const {
+    return hash_combine(hash_combine_range(Data, Data + Size), Extra);
+  }
+
+  bool equals(const TableGenInitListKey &RHS) const {
+    if (Size != RHS.Size || Extra != RHS.Extra)
+      return false;
+    if (Data == RHS.Data)
+      return true;
+    if (Data == 0 || RHS.Data == 0)
+      return false;
+    for (unsigned i = 0; i != Size; ++i)
+      if (Data[i] != RHS.Data[i])
+        return false;
+    return true;
+  }
+};
+
+/// Specialize DenseMapInfo for TableGenInitListKey.  The sentinel sizes can
+/// never collide with a real key: no Init has anywhere near 2^32 children.
+template<> struct DenseMapInfo<TableGenInitListKey> {
+  static inline TableGenInitListKey getEmptyKey() {
+    return TableGenInitListKey(~0U);
+  }
+  static inline TableGenInitListKey getTombstoneKey() {
+    return TableGenInitListKey(~0U - 1);
+  }
+  static unsigned getHashValue(const TableGenInitListKey &Val) {
+    return Val.hash();
+  }
+  static bool isEqual(const TableGenInitListKey &LHS,
+                      const TableGenInitListKey &RHS) {
+    return LHS.equals(RHS);
+  }
+};
+
 } // namespace llvm
 
+/// InitArena - All interned Init values are allocated here.  They are
+/// immutable, live as long as the records do, and are never destroyed
+/// individually, so a bump allocator released at shutdown both speeds up
+/// allocation and stops multiclass-heavy resolutions from fragmenting the
+/// heap with millions of small nodes.
+static ManagedStatic<BumpPtrAllocator> InitArena;
+
 //===----------------------------------------------------------------------===//
 //    Type implementations
 //===----------------------------------------------------------------------===//
@@ -444,38 +504,21 @@ BitInit *BitInit::get(bool V) {
   return V ? &True : &False;
 }
 
-static void
-ProfileBitsInit(FoldingSetNodeID &ID, ArrayRef<Init *> Range) {
-  ID.AddInteger(Range.size());
-
-  for (ArrayRef<Init *>::iterator i = Range.begin(),
-         iend = Range.end();
-       i != iend;
-       ++i)
-    ID.AddPointer(*i);
-}
-
 BitsInit *BitsInit::get(ArrayRef<Init *> Range) {
-  typedef FoldingSet<BitsInit> Pool;
-  static Pool ThePool;  
-
-  FoldingSetNodeID ID;
-  ProfileBitsInit(ID, Range);
+  typedef DenseMap<TableGenInitListKey, BitsInit *> Pool;
+  static Pool ThePool;
 
-  void *IP = 0;
-  if (BitsInit *I = ThePool.FindNodeOrInsertPos(ID, IP))
-    return I;
-
-  BitsInit *I = new BitsInit(Range);
-  ThePool.InsertNode(I, IP);
+  Pool::iterator It = ThePool.find(TableGenInitListKey(Range, 0));
+  if (It != ThePool.end())
+    return It->second;
 
+  BitsInit *I = new (*InitArena) BitsInit(Range);
+  // Key the entry off the node's own copy of the children so the map never
+  // points at caller storage.
+  ThePool[TableGenInitListKey(I->Bits, 0)] = I;
   return I;
 }
 
-void BitsInit::Profile(FoldingSetNodeID &ID) const {
-  ProfileBitsInit(ID, Bits);
-}
-
 Init *
 BitsInit::convertInitializerBitRange(const std::vector<unsigned> &Bits) const {
   SmallVector<Init *, 16> NewBits(Bits.size());
@@ -562,7 +605,7 @@ IntInit *IntInit::get(int64_t V) {
   static Pool ThePool;
 
   IntInit *&I = ThePool[V];
-  if (!I) I = new IntInit(V);
+  if (!I) I = new (*InitArena) IntInit(V);
   return I;
 }
 
@@ -590,49 +633,25 @@ StringInit *StringInit::get(StringRef V) {
   static Pool ThePool;
 
   StringInit *&I = ThePool[V];
-  if (!I) I = new StringInit(V);
+  if (!I) I = new (*InitArena) StringInit(V);
   return I;
 }
 
-static void ProfileListInit(FoldingSetNodeID &ID,
-                            ArrayRef<Init *> Range,
-                            RecTy *EltTy) {
-  ID.AddInteger(Range.size());
-  ID.AddPointer(EltTy);
-
-  for (ArrayRef<Init *>::iterator i = Range.begin(),
-         iend = Range.end();
-       i != iend;
-       ++i)
-    ID.AddPointer(*i);
-}
-
 ListInit *ListInit::get(ArrayRef<Init *> Range, RecTy *EltTy) {
-  typedef FoldingSet<ListInit> Pool;
+  typedef DenseMap<TableGenInitListKey, ListInit *> Pool;
   static Pool ThePool;
 
-  // Just use the FoldingSetNodeID to compute a hash.  Use a DenseMap
-  // for actual storage.
-  FoldingSetNodeID ID;
-  ProfileListInit(ID, Range, EltTy);
-
-  void *IP = 0;
-  if (ListInit *I = ThePool.FindNodeOrInsertPos(ID, IP))
-    return I;
+  Pool::iterator It = ThePool.find(TableGenInitListKey(Range, EltTy));
+  if (It != ThePool.end())
+    return It->second;
 
-  ListInit *I = new ListInit(Range, EltTy);
-  ThePool.InsertNode(I, IP);
+  ListInit *I = new (*InitArena) ListInit(Range, EltTy);
+  // Key the entry off the node's own copy of the children so the map never
+  // points at caller storage.
+  ThePool[TableGenInitListKey(I->Values, EltTy)] = I;
   return I;
 }
 
-void ListInit::Profile(FoldingSetNodeID &ID) const {
-  ListRecTy *ListType = dyn_cast<ListRecTy>(getType());
-  assert(ListType && "Bad type for ListInit!");
-  RecTy *EltTy = ListType->getElementType();
-
-  ProfileListInit(ID, Values, EltTy);
-}
-
 Init *
 ListInit::convertInitListSlice(const std::vector<unsigned> &Elements) const {
   std::vector<Init*> Vals;
@@ -733,7 +752,7 @@ UnOpInit *UnOpInit::get(UnaryOp opc, Init *lhs, RecTy *Type) {
   Key TheKey(std::make_pair(std::make_pair(opc, lhs), Type));
 
   UnOpInit *&I = ThePool[TheKey];
-  if (!I) I = new UnOpInit(opc, lhs, Type);
+  if (!I) I = new (*InitArena) UnOpInit(opc, lhs, Type);
   return I;
 }
 
@@ -880,7 +899,7 @@ BinOpInit *BinOpInit::get(BinaryOp opc, Init *lhs,
                             Type));
 
   BinOpInit *&I = ThePool[TheKey];
-  if (!I) I = new BinOpInit(opc, lhs, rhs, Type);
+  if (!I) I = new (*InitArena) BinOpInit(opc, lhs, rhs, Type);
   return I;
 }
 
@@ -1003,7 +1022,7 @@ TernOpInit *TernOpInit::get(TernaryOp opc, Init *lhs,
                             rhs));
 
   TernOpInit *&I = ThePool[TheKey];
-  if (!I) I = new TernOpInit(opc, lhs, mhs, rhs, Type);
+  if (!I) I = new (*InitArena) TernOpInit(opc, lhs, mhs, rhs, Type);
   return I;
 }
 
@@ -1304,7 +1323,7 @@ VarInit *VarInit::get(Init *VN, RecTy *T) {
   Key TheKey(std::make_pair(T, VN));
 
   VarInit *&I = ThePool[TheKey];
-  if (!I) I = new VarInit(VN, T);
+  if (!I) I = new (*InitArena) VarInit(VN, T);
   return I;
 }
 
@@ -1391,7 +1410,7 @@ VarBitInit *VarBitInit::get(TypedInit *T, unsigned B) {
   Key TheKey(std::make_pair(T, B));
 
   VarBitInit *&I = ThePool[TheKey];
-  if (!I) I = new VarBitInit(T, B);
+  if (!I) I = new (*InitArena) VarBitInit(T, B);
   return I;
 }
 
@@ -1417,7 +1436,7 @@ VarListElementInit *VarListElementInit::get(TypedInit *T,
   Key TheKey(std::make_pair(T, E));
 
   VarListElementInit *&I = ThePool[TheKey];
-  if (!I) I = new VarListElementInit(T, E);
+  if (!I) I = new (*InitArena) VarListElementInit(T, E);
   return I;
 }
 
@@ -1448,7 +1467,7 @@ Init *VarListElementInit:: resolveListElementReference(Record &R,
     if (TypedInit *TInit = dyn_cast<TypedInit>(Result)) {
       Init *Result2 = TInit->resolveListElementReference(R, RV, Elt);
       if (Result2) return Result2;
-      return new VarListElementInit(TInit, Elt);
+      return new (*InitArena) VarListElementInit(TInit, Elt);
     }
     return Result;
   }
@@ -1484,7 +1503,7 @@ FieldInit *FieldInit::get(Init *R, const std::string &FN) {
   Key TheKey(std::make_pair(R, FN));
 
   FieldInit *&I = ThePool[TheKey];
-  if (!I) I = new FieldInit(R, FN);
+  if (!I) I = new (*InitArena) FieldInit(R, FN);
   return I;
 }
 
@@ -1557,7 +1576,7 @@ DagInit::get(Init *V, const std::string &VN,
   if (DagInit *I = ThePool.FindNodeOrInsertPos(ID, IP))
     return I;
 
-  DagInit *I = new DagInit(V, VN, ArgRange, NameRange);
+  DagInit *I = new (*InitArena) DagInit(V, VN, ArgRange, NameRange);
   ThePool.InsertNode(I, IP);
 
   return I;
@@ -1672,7 +1691,7 @@ void Record::checkName() {
 
 DefInit *Record::getDefInit() {
   if (!TheInit)
-    TheInit = new DefInit(this, new RecordRecTy(this));
+    TheInit = new (*InitArena) DefInit(this, new RecordRecTy(this));
   return TheInit;
 }
 
@@ -12,7 +12,11 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Target/TargetLibraryInfo.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Mutex.h"
 using namespace llvm;
 
 // Register the default implementation.
@@ -377,6 +381,20 @@ static void initialize(TargetLibraryInfo &TLI, const Triple &T,
   }
 }
 
+namespace {
+/// TLITemplates - Memoized per-triple TargetLibraryInfo state.  In-process
+/// clients construct a fresh TargetLibraryInfo for every pass manager they
+/// build; running the triple dispatch in initialize() (and, in +Asserts
+/// builds, the re-verification of the sorted name table) once per triple and
+/// copying thereafter keeps that fixed cost off the per-compilation path.
+struct TLITemplates {
+  sys::SmartMutex<true> Lock;
+  StringMap<TargetLibraryInfo*> Map;
+  ~TLITemplates() { DeleteContainerSeconds(Map); }
+};
+}
+
+static ManagedStatic<TLITemplates> TLITemplateCache;
 
 TargetLibraryInfo::TargetLibraryInfo() : ImmutablePass(ID) {
   // Default to everything being available.
@@ -386,10 +404,23 @@ TargetLibraryInfo::TargetLibraryInfo() : ImmutablePass(ID) {
 }
 
 TargetLibraryInfo::TargetLibraryInfo(const Triple &T) : ImmutablePass(ID) {
+  // If this triple has been seen before, copy the memoized state instead of
+  // rerunning the per-triple initialization.
+  TLITemplates &Templates = *TLITemplateCache;
+  sys::SmartScopedLock<true> Guard(Templates.Lock);
+  TargetLibraryInfo *&Templ =
+    Templates.Map.GetOrCreateValue(T.str()).getValue();
+  if (Templ) {
+    memcpy(AvailableArray, Templ->AvailableArray, sizeof(AvailableArray));
+    CustomNames = Templ->CustomNames;
+    return;
+  }
+
   // Default to everything being available.
   memset(AvailableArray, -1, sizeof(AvailableArray));
-  
+
   initialize(*this, T, StandardNames);
+  Templ = new TargetLibraryInfo(*this);
 }
 
 TargetLibraryInfo::TargetLibraryInfo(const TargetLibraryInfo &TLI)
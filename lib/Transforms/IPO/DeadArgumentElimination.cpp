@@ -267,9 +267,6 @@ bool DAE::DeleteDeadVarargs(Function &Fn) {
     CallSite CS(Fn.use_back());
     Instruction *Call = CS.getInstruction();
 
-    // Pass all the same arguments.
-    Args.assign(CS.arg_begin(), CS.arg_begin() + NumArgs);
-
     // Drop any attributes that were on the vararg arguments.
     AttributeSet PAL = CS.getAttributes();
     if (!PAL.isEmpty() && PAL.getSlotIndex(PAL.getNumSlots() - 1) > NumArgs) {
@@ -282,19 +279,27 @@ bool DAE::DeleteDeadVarargs(Function &Fn) {
       PAL = AttributeSet::get(Fn.getContext(), AttributesVec);
     }
 
-    Instruction *New;
-    if (InvokeInst *II = dyn_cast<InvokeInst>(Call)) {
-      New = InvokeInst::Create(NF, II->getNormalDest(), II->getUnwindDest(),
-                               Args, "", Call);
-      cast<InvokeInst>(New)->setCallingConv(CS.getCallingConv());
-      cast<InvokeInst>(New)->setAttributes(PAL);
-    } else {
-      New = CallInst::Create(NF, Args, "", Call);
-      cast<CallInst>(New)->setCallingConv(CS.getCallingConv());
-      cast<CallInst>(New)->setAttributes(PAL);
-      if (cast<CallInst>(Call)->isTailCall())
-        cast<CallInst>(New)->setTailCall();
+    // Calls can be updated in place: the return type is unchanged and only
+    // trailing arguments are dropped, so shrink the argument list, retarget
+    // the callee and rebuild the attributes without re-creating the
+    // instruction.  Invokes still go through re-creation below.
+    if (CallInst *CI = dyn_cast<CallInst>(Call)) {
+      while (CI->getNumArgOperands() > NumArgs)
+        CI->removeArgOperand(CI->getNumArgOperands() - 1);
+      CI->setCalledFunction(NF);
+      CI->setAttributes(PAL);
+      continue;
     }
+
+    // Pass all the same arguments.
+    Args.assign(CS.arg_begin(), CS.arg_begin() + NumArgs);
+
+    Instruction *New;
+    InvokeInst *II = cast<InvokeInst>(Call);
+    New = InvokeInst::Create(NF, II->getNormalDest(), II->getUnwindDest(),
+                             Args, "", Call);
+    cast<InvokeInst>(New)->setCallingConv(CS.getCallingConv());
+    cast<InvokeInst>(New)->setAttributes(PAL);
     New->setDebugLoc(Call->getDebugLoc());
 
     Args.clear();
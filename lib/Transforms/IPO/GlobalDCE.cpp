@@ -13,11 +13,19 @@
 // deletes whatever is left over.  This allows it to delete recursive chunks of
 // the program which are unreachable.
 //
+// Liveness is computed by numbering every global, building the module
+// reference graph once in compact adjacency form, and running a worklist
+// search over a bitvector.  Constant initializer graphs are shared between
+// globals, so the globals each uniqued constant references are memoized
+// instead of being re-walked per global.
+//
 //===----------------------------------------------------------------------===//
 
 #define DEBUG_TYPE "globaldce"
 #include "llvm/Transforms/IPO.h"
-#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Module.h"
@@ -41,12 +49,32 @@ namespace {
     bool runOnModule(Module &M);
 
   private:
-    SmallPtrSet<GlobalValue*, 32> AliveGlobals;
+    /// The module reference graph.  Globals are numbered in module order and
+    /// the targets each one references are stored as concatenated adjacency
+    /// arrays: node I's references are RefLists[RefListStart[I]] up to
+    /// RefLists[RefListStart[I+1]].
+    std::vector<GlobalValue*> GlobalsByIndex;
+    DenseMap<GlobalValue*, unsigned> GlobalIndices;
+    std::vector<unsigned> RefListStart;
+    std::vector<unsigned> RefLists;
+
+    /// Globals whose index is set here are reachable from a root.
+    BitVector Alive;
+
+    /// The globals each uniqued constant transitively references, interned as
+    /// ranges of ConstantRefLists.  Initializer graphs are heavily shared, so
+    /// each constant is walked once per module instead of once per global.
+    DenseMap<Constant*, std::pair<unsigned, unsigned> > ConstantRefCache;
+    std::vector<unsigned> ConstantRefLists;
 
-    /// GlobalIsNeeded - mark the specific global value as needed, and
-    /// recursively mark anything that it uses as also needed.
-    void GlobalIsNeeded(GlobalValue *GV);
-    void MarkUsedGlobalsAsNeeded(Constant *C);
+    /// Dedup stamps for edge insertion, indexed by target: SeenAt[T] is the
+    /// last source node that emitted an edge to T.
+    std::vector<unsigned> SeenAt;
+
+    void BuildReferenceGraph(Module &M);
+    void AddReferenceEdges(Constant *C, unsigned Source);
+    void AddEdge(unsigned Target, unsigned Source);
+    std::pair<unsigned, unsigned> getConstantRefs(Constant *C);
 
     bool RemoveUnusedGlobalValue(GlobalValue &GV);
   };
@@ -60,14 +88,19 @@ ModulePass *llvm::createGlobalDCEPass() { return new GlobalDCE(); }
 
 bool GlobalDCE::runOnModule(Module &M) {
   bool Changed = false;
-  
-  // Loop over the module, adding globals which are obviously necessary.
+
+  // Loop over the module dropping dead constant users and collecting the
+  // roots: globals which are needed regardless of any references to them.
+  // This must finish before the reference graph is built, because
+  // RemoveUnusedGlobalValue destroys dead constant expressions.
+  std::vector<GlobalValue*> Roots;
+
   for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
     Changed |= RemoveUnusedGlobalValue(*I);
     // Functions with external linkage are needed if they have a body
     if (!I->isDiscardableIfUnused() &&
         !I->isDeclaration() && !I->hasAvailableExternallyLinkage())
-      GlobalIsNeeded(I);
+      Roots.push_back(I);
   }
 
   for (Module::global_iterator I = M.global_begin(), E = M.global_end();
@@ -77,7 +110,7 @@ bool GlobalDCE::runOnModule(Module &M) {
     // initializer.
     if (!I->isDiscardableIfUnused() &&
         !I->isDeclaration() && !I->hasAvailableExternallyLinkage())
-      GlobalIsNeeded(I);
+      Roots.push_back(I);
   }
 
   for (Module::alias_iterator I = M.alias_begin(), E = M.alias_end();
@@ -85,10 +118,35 @@ bool GlobalDCE::runOnModule(Module &M) {
     Changed |= RemoveUnusedGlobalValue(*I);
     // Externally visible aliases are needed.
     if (!I->isDiscardableIfUnused())
-      GlobalIsNeeded(I);
+      Roots.push_back(I);
   }
 
-  // Now that all globals which are needed are in the AliveGlobals set, we loop
+  // Number the globals and build the reference graph once.
+  BuildReferenceGraph(M);
+
+  // Propagate liveness from the roots over the graph.
+  Alive.resize(GlobalsByIndex.size());
+  std::vector<unsigned> Worklist;
+  for (unsigned i = 0, e = Roots.size(); i != e; ++i) {
+    unsigned Idx = GlobalIndices[Roots[i]];
+    if (!Alive.test(Idx)) {
+      Alive.set(Idx);
+      Worklist.push_back(Idx);
+    }
+  }
+  while (!Worklist.empty()) {
+    unsigned Idx = Worklist.back();
+    Worklist.pop_back();
+    for (unsigned i = RefListStart[Idx], e = RefListStart[Idx+1]; i != e; ++i) {
+      unsigned Target = RefLists[i];
+      if (!Alive.test(Target)) {
+        Alive.set(Target);
+        Worklist.push_back(Target);
+      }
+    }
+  }
+
+  // Now that the Alive bitvector covers all globals which are needed, we loop
   // through the program, deleting those which are not alive.
   //
 
@@ -96,7 +154,7 @@ bool GlobalDCE::runOnModule(Module &M) {
   std::vector<GlobalVariable*> DeadGlobalVars;   // Keep track of dead globals
   for (Module::global_iterator I = M.global_begin(), E = M.global_end();
        I != E; ++I)
-    if (!AliveGlobals.count(I)) {
+    if (!Alive.test(GlobalIndices[I])) {
       DeadGlobalVars.push_back(I);         // Keep track of dead globals
       I->setInitializer(0);
     }
@@ -104,7 +162,7 @@ bool GlobalDCE::runOnModule(Module &M) {
   // The second pass drops the bodies of functions which are dead...
   std::vector<Function*> DeadFunctions;
   for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I)
-    if (!AliveGlobals.count(I)) {
+    if (!Alive.test(GlobalIndices[I])) {
       DeadFunctions.push_back(I);         // Keep track of dead globals
       if (!I->isDeclaration())
         I->deleteBody();
@@ -114,7 +172,7 @@ bool GlobalDCE::runOnModule(Module &M) {
   std::vector<GlobalAlias*> DeadAliases;
   for (Module::alias_iterator I = M.alias_begin(), E = M.alias_end(); I != E;
        ++I)
-    if (!AliveGlobals.count(I)) {
+    if (!Alive.test(GlobalIndices[I])) {
       DeadAliases.push_back(I);
       I->setAliasee(0);
     }
@@ -150,52 +208,115 @@ bool GlobalDCE::runOnModule(Module &M) {
   }
 
   // Make sure that all memory is released
-  AliveGlobals.clear();
+  std::vector<GlobalValue*>().swap(GlobalsByIndex);
+  GlobalIndices.clear();
+  std::vector<unsigned>().swap(RefListStart);
+  std::vector<unsigned>().swap(RefLists);
+  Alive.clear();
+  ConstantRefCache.clear();
+  std::vector<unsigned>().swap(ConstantRefLists);
+  std::vector<unsigned>().swap(SeenAt);
 
   return Changed;
 }
 
-/// GlobalIsNeeded - the specific global value as needed, and
-/// recursively mark anything that it uses as also needed.
-void GlobalDCE::GlobalIsNeeded(GlobalValue *G) {
-  // If the global is already in the set, no need to reprocess it.
-  if (!AliveGlobals.insert(G))
+/// BuildReferenceGraph - Number every global in the module and record the
+/// globals each one references as compact adjacency arrays.
+void GlobalDCE::BuildReferenceGraph(Module &M) {
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
+    GlobalIndices[I] = GlobalsByIndex.size();
+    GlobalsByIndex.push_back(I);
+  }
+  for (Module::global_iterator I = M.global_begin(), E = M.global_end();
+       I != E; ++I) {
+    GlobalIndices[I] = GlobalsByIndex.size();
+    GlobalsByIndex.push_back(I);
+  }
+  for (Module::alias_iterator I = M.alias_begin(), E = M.alias_end();
+       I != E; ++I) {
+    GlobalIndices[I] = GlobalsByIndex.size();
+    GlobalsByIndex.push_back(I);
+  }
+
+  unsigned NumGlobals = GlobalsByIndex.size();
+  SeenAt.assign(NumGlobals, ~0u);
+  RefListStart.reserve(NumGlobals + 1);
+  RefListStart.push_back(0);
+
+  for (unsigned Idx = 0; Idx != NumGlobals; ++Idx) {
+    GlobalValue *G = GlobalsByIndex[Idx];
+    if (GlobalVariable *GV = dyn_cast<GlobalVariable>(G)) {
+      // A global variable references whatever its initializer does.
+      if (GV->hasInitializer())
+        AddReferenceEdges(GV->getInitializer(), Idx);
+    } else if (GlobalAlias *GA = dyn_cast<GlobalAlias>(G)) {
+      // An alias references its aliasee.
+      if (GA->getAliasee())
+        AddReferenceEdges(GA->getAliasee(), Idx);
+    } else {
+      // Otherwise this must be a function object.  Scan the body for
+      // constants and global values used as operands.
+      Function *F = cast<Function>(G);
+      for (Function::iterator BB = F->begin(), E = F->end(); BB != E; ++BB)
+        for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I)
+          for (User::op_iterator U = I->op_begin(), E = I->op_end();
+               U != E; ++U)
+            if (Constant *C = dyn_cast<Constant>(*U))
+              AddReferenceEdges(C, Idx);
+    }
+    RefListStart.push_back(RefLists.size());
+  }
+}
+
+/// AddReferenceEdges - Add edges from \p Source to every global \p C
+/// transitively references.
+void GlobalDCE::AddReferenceEdges(Constant *C, unsigned Source) {
+  if (GlobalValue *GV = dyn_cast<GlobalValue>(C)) {
+    AddEdge(GlobalIndices[GV], Source);
     return;
-  
-  if (GlobalVariable *GV = dyn_cast<GlobalVariable>(G)) {
-    // If this is a global variable, we must make sure to add any global values
-    // referenced by the initializer to the alive set.
-    if (GV->hasInitializer())
-      MarkUsedGlobalsAsNeeded(GV->getInitializer());
-  } else if (GlobalAlias *GA = dyn_cast<GlobalAlias>(G)) {
-    // The target of a global alias is needed.
-    MarkUsedGlobalsAsNeeded(GA->getAliasee());
-  } else {
-    // Otherwise this must be a function object.  We have to scan the body of
-    // the function looking for constants and global values which are used as
-    // operands.  Any operands of these types must be processed to ensure that
-    // any globals used will be marked as needed.
-    Function *F = cast<Function>(G);
-
-    for (Function::iterator BB = F->begin(), E = F->end(); BB != E; ++BB)
-      for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I)
-        for (User::op_iterator U = I->op_begin(), E = I->op_end(); U != E; ++U)
-          if (GlobalValue *GV = dyn_cast<GlobalValue>(*U))
-            GlobalIsNeeded(GV);
-          else if (Constant *C = dyn_cast<Constant>(*U))
-            MarkUsedGlobalsAsNeeded(C);
   }
+
+  std::pair<unsigned, unsigned> Range = getConstantRefs(C);
+  for (unsigned i = Range.first; i != Range.second; ++i)
+    AddEdge(ConstantRefLists[i], Source);
+}
+
+/// AddEdge - Append \p Target to \p Source's adjacency array unless it is
+/// already present.  Sources are processed in index order, so a stamp per
+/// target suffices to dedup.
+void GlobalDCE::AddEdge(unsigned Target, unsigned Source) {
+  if (SeenAt[Target] == Source)
+    return;
+  SeenAt[Target] = Source;
+  RefLists.push_back(Target);
 }
 
-void GlobalDCE::MarkUsedGlobalsAsNeeded(Constant *C) {
-  if (GlobalValue *GV = dyn_cast<GlobalValue>(C))
-    return GlobalIsNeeded(GV);
-  
-  // Loop over all of the operands of the constant, adding any globals they
-  // use to the list of needed globals.
-  for (User::op_iterator I = C->op_begin(), E = C->op_end(); I != E; ++I)
-    if (Constant *OpC = dyn_cast<Constant>(*I))
-      MarkUsedGlobalsAsNeeded(OpC);
+/// getConstantRefs - Return the range of ConstantRefLists holding the globals
+/// \p C transitively references, computing and caching it on first use.
+/// Ranges may contain duplicates; AddEdge filters them per source node.
+std::pair<unsigned, unsigned> GlobalDCE::getConstantRefs(Constant *C) {
+  DenseMap<Constant*, std::pair<unsigned, unsigned> >::iterator It =
+    ConstantRefCache.find(C);
+  if (It != ConstantRefCache.end())
+    return It->second;
+
+  // Gather into a local list first: recursing on operands interns their
+  // ranges, and each cached range must be contiguous.
+  SmallVector<unsigned, 8> Local;
+  for (User::op_iterator I = C->op_begin(), E = C->op_end(); I != E; ++I) {
+    if (GlobalValue *GV = dyn_cast<GlobalValue>(*I)) {
+      Local.push_back(GlobalIndices[GV]);
+    } else if (Constant *OpC = dyn_cast<Constant>(*I)) {
+      std::pair<unsigned, unsigned> Range = getConstantRefs(OpC);
+      for (unsigned i = Range.first; i != Range.second; ++i)
+        Local.push_back(ConstantRefLists[i]);
+    }
+  }
+
+  unsigned Begin = ConstantRefLists.size();
+  ConstantRefLists.insert(ConstantRefLists.end(), Local.begin(), Local.end());
+  std::pair<unsigned, unsigned> Range(Begin, ConstantRefLists.size());
+  return ConstantRefCache[C] = Range;
 }
 
 // RemoveUnusedGlobalValue - Loop over all of the uses of the specified
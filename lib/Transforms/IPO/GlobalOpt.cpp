@@ -32,6 +32,7 @@
 #include "llvm/IR/Operator.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/CallSite.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/GetElementPtrTypeIterator.h"
@@ -39,8 +40,14 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetLibraryInfo.h"
 #include <algorithm>
+#include <map>
 using namespace llvm;
 
+static cl::opt<unsigned>
+MaxCtorEvalInsts("globalopt-max-ctor-insts", cl::Hidden, cl::init(1000000),
+  cl::desc("Maximum number of instructions to interpret while evaluating "
+           "a static constructor (0 = no limit)"));
+
 STATISTIC(NumMarked    , "Number of globals marked constant");
 STATISTIC(NumUnnamed   , "Number of globals marked unnamed_addr");
 STATISTIC(NumSRA       , "Number of aggregate globals broken into scalars");
@@ -2462,7 +2469,7 @@ namespace {
 class Evaluator {
 public:
   Evaluator(const DataLayout *TD, const TargetLibraryInfo *TLI)
-    : TD(TD), TLI(TLI) {
+    : NumInstsEvaluated(0), NumLoads(0), NumStores(0), TD(TD), TLI(TLI) {
     ValueStack.push_back(new DenseMap<Value*, Constant*>);
   }
 
@@ -2542,6 +2549,24 @@ private:
   /// simple enough to live in a static initializer of a global.
   SmallPtrSet<Constant*, 8> SimpleConstants;
 
+  /// PureCallCache - Results of fully evaluated calls that neither read nor
+  /// wrote memory, keyed by callee and actual arguments.  Re-evaluating the
+  /// same pure helper for every caller is what makes deep call trees blow up
+  /// exponentially; such calls are safe to replay from the cache because
+  /// their result depends only on their arguments.
+  std::map<std::pair<Function*, std::vector<Constant*> >, Constant*>
+    PureCallCache;
+
+  /// NumInstsEvaluated - Total number of instructions interpreted so far,
+  /// checked against -globalopt-max-ctor-insts so one pathological ctor
+  /// cannot eat the compile.
+  unsigned NumInstsEvaluated;
+
+  /// NumLoads/NumStores - Counters used to detect whether a nested call
+  /// touched memory (and is therefore not cacheable).
+  unsigned NumLoads;
+  unsigned NumStores;
+
   const DataLayout *TD;
   const TargetLibraryInfo *TLI;
 };
@@ -2552,6 +2577,8 @@ private:
 /// P after the stores reflected by 'memory' have been performed.  If we can't
 /// decide, return null.
 Constant *Evaluator::ComputeLoadResult(Constant *P) {
+  ++NumLoads;
+
   // If this memory location has been recently stored, use the stored value: it
   // is the most up-to-date.
   DenseMap<Constant*, Constant*>::const_iterator I = MutatedMemory.find(P);
@@ -2585,6 +2612,13 @@ bool Evaluator::EvaluateBlock(BasicBlock::iterator CurInst,
   while (1) {
     Constant *InstResult = 0;
 
+    // Bail out once the interpretation budget is spent.  Deep call trees can
+    // otherwise re-evaluate shared helpers an exponential number of times.
+    if (MaxCtorEvalInsts && ++NumInstsEvaluated > MaxCtorEvalInsts) {
+      DEBUG(dbgs() << "Evaluation budget exhausted. Can not evaluate.\n");
+      return false;
+    }
+
     DEBUG(dbgs() << "Evaluating Instruction: " << *CurInst << "\n");
 
     if (StoreInst *SI = dyn_cast<StoreInst>(CurInst)) {
@@ -2660,6 +2694,7 @@ bool Evaluator::EvaluateBlock(BasicBlock::iterator CurInst,
       }
 
       MutatedMemory[Ptr] = Val;
+      ++NumStores;
     } else if (BinaryOperator *BO = dyn_cast<BinaryOperator>(CurInst)) {
       InstResult = ConstantExpr::get(BO->getOpcode(),
                                      getVal(BO->getOperand(0)),
@@ -2828,21 +2863,47 @@ bool Evaluator::EvaluateBlock(BasicBlock::iterator CurInst,
           return false;
         }
 
-        Constant *RetVal = 0;
-        // Execute the call, if successful, use the return value.
-        ValueStack.push_back(new DenseMap<Value*, Constant*>);
-        if (!EvaluateFunction(Callee, RetVal, Formals)) {
-          DEBUG(dbgs() << "Failed to evaluate function.\n");
-          return false;
-        }
-        delete ValueStack.pop_back_val();
-        InstResult = RetVal;
-
-        if (InstResult != NULL) {
-          DEBUG(dbgs() << "Successfully evaluated function. Result: " <<
-                InstResult << "\n\n");
+        // If we have already evaluated this callee with the same arguments
+        // and it did not touch memory, replay the cached result.
+        std::pair<Function*, std::vector<Constant*> >
+          CacheKey(Callee, std::vector<Constant*>(Formals.begin(),
+                                                  Formals.end()));
+        std::map<std::pair<Function*, std::vector<Constant*> >,
+                 Constant*>::const_iterator CacheI =
+          PureCallCache.find(CacheKey);
+        if (CacheI != PureCallCache.end()) {
+          InstResult = CacheI->second;
+          DEBUG(dbgs() << "Replayed memoized call. Result: " << *InstResult
+                << "\n\n");
         } else {
-          DEBUG(dbgs() << "Successfully evaluated function. Result: 0\n\n");
+          unsigned LoadsBefore = NumLoads;
+          unsigned StoresBefore = NumStores;
+          unsigned AllocasBefore = AllocaTmps.size();
+          unsigned InvariantsBefore = Invariants.size();
+
+          Constant *RetVal = 0;
+          // Execute the call, if successful, use the return value.
+          ValueStack.push_back(new DenseMap<Value*, Constant*>);
+          if (!EvaluateFunction(Callee, RetVal, Formals)) {
+            DEBUG(dbgs() << "Failed to evaluate function.\n");
+            return false;
+          }
+          delete ValueStack.pop_back_val();
+          InstResult = RetVal;
+
+          // A call whose evaluation neither read nor wrote memory depends
+          // only on its arguments and is safe to memoize.
+          if (InstResult && NumLoads == LoadsBefore &&
+              NumStores == StoresBefore && AllocaTmps.size() == AllocasBefore &&
+              Invariants.size() == InvariantsBefore)
+            PureCallCache[CacheKey] = InstResult;
+
+          if (InstResult != NULL) {
+            DEBUG(dbgs() << "Successfully evaluated function. Result: " <<
+                  InstResult << "\n\n");
+          } else {
+            DEBUG(dbgs() << "Successfully evaluated function. Result: 0\n\n");
+          }
         }
       }
     } else if (isa<TerminatorInst>(CurInst)) {
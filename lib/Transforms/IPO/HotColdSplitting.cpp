@@ -0,0 +1,218 @@
+//===- HotColdSplitting.cpp - Outline cold regions ------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass outlines cold regions of hot functions into separate functions so
+// the hot remainder packs densely in the instruction cache.  A region is cold
+// if its header has a zero execution count while the function itself ran
+// (ProfileInfo), or, absent counts, if it is an EH landing-pad path, ends in
+// unreachable, or is reached only through edges BranchProbabilityInfo
+// considers unlikely.  Everything dominated by a cold block can run at most
+// as often as that block, so regions are dominator subtrees and are pulled
+// out with CodeExtractor.  Outlined functions are marked noinline and
+// optimized for size, and are placed in a cold text section.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "hotcoldsplit"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/ProfileInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CFG.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/CodeExtractor.h"
+using namespace llvm;
+
+STATISTIC(NumColdRegionsOutlined, "Number of cold regions outlined");
+
+static cl::opt<std::string>
+ColdSectionName("hotcoldsplit-cold-section",
+                cl::desc("Section for outlined cold functions "
+                         "(empty to leave the default section)"),
+                cl::init(".text.unlikely"), cl::Hidden);
+
+static cl::opt<unsigned>
+MinOutliningSize("hotcoldsplit-min-size",
+                 cl::desc("Minimum number of instructions in an outlined "
+                          "cold region"),
+                 cl::init(4), cl::Hidden);
+
+namespace {
+  struct HotColdSplitting : public ModulePass {
+    static char ID; // Pass identification, replacement for typeid
+    HotColdSplitting() : ModulePass(ID) {
+      initializeHotColdSplittingPass(*PassRegistry::getPassRegistry());
+    }
+
+    bool runOnModule(Module &M);
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.addRequired<ProfileInfo>();
+      AU.addRequired<BranchProbabilityInfo>();
+      AU.addRequired<DominatorTree>();
+    }
+
+  private:
+    bool processFunction(Function &F);
+  };
+}
+
+char HotColdSplitting::ID = 0;
+INITIALIZE_PASS_BEGIN(HotColdSplitting, "hotcoldsplit",
+                      "Hot/cold function splitting", false, false)
+INITIALIZE_AG_DEPENDENCY(ProfileInfo)
+INITIALIZE_PASS_DEPENDENCY(BranchProbabilityInfo)
+INITIALIZE_PASS_DEPENDENCY(DominatorTree)
+INITIALIZE_PASS_END(HotColdSplitting, "hotcoldsplit",
+                    "Hot/cold function splitting", false, false)
+
+ModulePass *llvm::createHotColdSplittingPass() {
+  return new HotColdSplitting();
+}
+
+/// isColdSeed - Return true if BB itself looks cold.  Blocks dominated by a
+/// seed are handled by the caller.
+static bool isColdSeed(BasicBlock &BB, bool HaveCounts, ProfileInfo &PI,
+                       BranchProbabilityInfo &BPI) {
+  // EH dispatch and everything behind it is assumed cold.
+  if (BB.isLandingPad())
+    return true;
+  // Paths that cannot return: assertion failures, fatal errors.
+  if (isa<UnreachableInst>(BB.getTerminator()))
+    return true;
+  if (HaveCounts)
+    return PI.getExecutionCount(&BB) == 0;
+
+  // Without real counts fall back on static prediction: a block is cold if
+  // no predecessor is at all likely to branch to it.
+  if (&BB == &BB.getParent()->getEntryBlock() ||
+      pred_begin(&BB) == pred_end(&BB))
+    return false;
+  const BranchProbability Unlikely(1, 64);
+  for (pred_iterator PI2 = pred_begin(&BB), E = pred_end(&BB); PI2 != E; ++PI2)
+    if (BPI.getEdgeProbability(*PI2, &BB) > Unlikely)
+      return false;
+  return true;
+}
+
+/// isViableRegion - Check that Region (a dominator subtree) can be pulled out
+/// with CodeExtractor and is big enough to be worth a call.
+static bool isViableRegion(ArrayRef<BasicBlock *> Region) {
+  SmallPtrSet<BasicBlock *, 8> InRegion(Region.begin(), Region.end());
+  unsigned NumInsts = 0;
+  for (unsigned i = 0, e = Region.size(); i != e; ++i) {
+    BasicBlock *BB = Region[i];
+    // A landing pad can only move together with all of its invokes.
+    if (BB->isLandingPad())
+      for (pred_iterator PI = pred_begin(BB), E = pred_end(BB); PI != E; ++PI)
+        if (!InRegion.count(*PI))
+          return false;
+    for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I) {
+      // Static allocations must stay in the caller's frame.
+      if (isa<AllocaInst>(I))
+        return false;
+      ++NumInsts;
+    }
+  }
+  return NumInsts >= MinOutliningSize;
+}
+
+bool HotColdSplitting::processFunction(Function &F) {
+  ProfileInfo &PI = getAnalysis<ProfileInfo>();
+  BranchProbabilityInfo &BPI = getAnalysis<BranchProbabilityInfo>(F);
+  DominatorTree &DT = getAnalysis<DominatorTree>(F);
+
+  double FCount = PI.getExecutionCount(&F);
+  bool HaveCounts = FCount != ProfileInfo::MissingValue && FCount > 0;
+
+  // Mark the seeds and everything they dominate: a block only reachable
+  // through a cold block runs at most as often as that block.
+  SmallPtrSet<BasicBlock *, 16> Cold;
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    if (Cold.count(BB) || !isColdSeed(*BB, HaveCounts, PI, BPI))
+      continue;
+    DomTreeNode *N = DT.getNode(BB);
+    if (!N)
+      continue;
+    SmallVector<DomTreeNode *, 8> Work(1, N);
+    while (!Work.empty()) {
+      DomTreeNode *Node = Work.pop_back_val();
+      if (Cold.insert(Node->getBlock()))
+        Work.append(Node->begin(), Node->end());
+    }
+  }
+  if (Cold.empty())
+    return false;
+
+  // Pick maximal cold subtrees, outermost first.  The entry block stays (a
+  // fully cold function isn't worth splitting), and a landing pad itself
+  // can't head a region since its invokes stay behind.
+  SmallVector<SmallVector<BasicBlock *, 8>, 4> Regions;
+  SmallVector<DomTreeNode *, 16> Stack(1, DT.getRootNode());
+  while (!Stack.empty()) {
+    DomTreeNode *N = Stack.pop_back_val();
+    BasicBlock *BB = N->getBlock();
+    if (Cold.count(BB) && BB != &F.getEntryBlock() && !BB->isLandingPad()) {
+      SmallVector<BasicBlock *, 8> Region;
+      SmallVector<DomTreeNode *, 8> Work(1, N);
+      while (!Work.empty()) {
+        DomTreeNode *Node = Work.pop_back_val();
+        Region.push_back(Node->getBlock());
+        Work.append(Node->begin(), Node->end());
+      }
+      if (isViableRegion(Region)) {
+        Regions.push_back(Region);
+        continue;   // Don't carve smaller regions out of this one.
+      }
+    }
+    Stack.append(N->begin(), N->end());
+  }
+
+  // The regions are disjoint subtrees, so extracting one leaves the others'
+  // blocks and dominance untouched; CodeExtractor keeps DT up to date.
+  bool Changed = false;
+  for (unsigned i = 0, e = Regions.size(); i != e; ++i) {
+    Function *Outlined = CodeExtractor(Regions[i], &DT).extractCodeRegion();
+    if (!Outlined)
+      continue;
+    DEBUG(dbgs() << "hotcoldsplit: outlined " << Outlined->getName()
+                 << " from " << F.getName() << "\n");
+    Outlined->addFnAttr(Attribute::MinSize);
+    Outlined->addFnAttr(Attribute::OptimizeForSize);
+    Outlined->addFnAttr(Attribute::NoInline);
+    if (!ColdSectionName.empty())
+      Outlined->setSection(ColdSectionName);
+    ++NumColdRegionsOutlined;
+    Changed = true;
+  }
+  return Changed;
+}
+
+bool HotColdSplitting::runOnModule(Module &M) {
+  // Collect the worklist first; extraction appends new functions to the
+  // module and those must not be reprocessed.
+  SmallVector<Function *, 16> Worklist;
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F)
+    if (!F->isDeclaration())
+      Worklist.push_back(F);
+
+  bool Changed = false;
+  for (unsigned i = 0, e = Worklist.size(); i != e; ++i)
+    Changed |= processFunction(*Worklist[i]);
+  return Changed;
+}
@@ -37,10 +37,14 @@ void llvm::initializeIPO(PassRegistry &Registry) {
   initializeBlockExtractorPassPass(Registry);
   initializeSingleLoopExtractorPass(Registry);
   initializeMergeFunctionsPass(Registry);
+  initializeHotColdSplittingPass(Registry);
   initializePartialInlinerPass(Registry);
   initializePruneEHPass(Registry);
   initializeStripDeadPrototypesPassPass(Registry);
   initializeStripSymbolsPass(Registry);
+  initializeMetadataStashPass(Registry);
+  initializeMetadataDetachPass(Registry);
+  initializeMetadataReattachPass(Registry);
   initializeStripDebugDeclarePass(Registry);
   initializeStripDeadDebugInfoPass(Registry);
   initializeStripNonDebugSymbolsPass(Registry);
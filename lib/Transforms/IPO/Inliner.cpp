@@ -15,6 +15,7 @@
 
 #define DEBUG_TYPE "inline"
 #include "llvm/Transforms/IPO/InlinerPass.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/CallGraph.h"
@@ -30,6 +31,7 @@
 #include "llvm/Target/TargetLibraryInfo.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/Local.h"
+#include <algorithm>
 using namespace llvm;
 
 STATISTIC(NumInlined, "Number of functions inlined");
@@ -50,16 +52,178 @@ static cl::opt<int>
 HintThreshold("inlinehint-threshold", cl::Hidden, cl::init(325),
               cl::desc("Threshold for inlining functions with inline hint"));
 
+static cl::opt<bool>
+InlinePriorityQueue("inline-priority-queue", cl::Hidden, cl::init(false),
+        cl::desc("Visit inline candidates in order of increasing cost "
+                 "instead of in call graph order"));
+
+static cl::opt<int>
+InlineModuleBudget("inline-module-budget", cl::Hidden, cl::init(-1),
+        cl::desc("Stop inlining once the total estimated cost of inlined "
+                 "call sites exceeds this value (default = no limit)"));
+
 // Threshold to use when optsize is specified (and there is no -inline-limit).
 const int OptSizeThreshold = 75;
 
-Inliner::Inliner(char &ID) 
-  : CallGraphSCCPass(ID), InlineThreshold(InlineLimit), InsertLifetime(true) {}
+namespace llvm {
+/// InlineCostCache - Memoizes the policy's inline cost queries for the
+/// duration of one SCC visit.  Entries are keyed on the call instruction and
+/// validated against per-function version numbers, which the inliner bumps
+/// whenever it changes a function's body, so a cached cost is only reused
+/// while both the caller and the callee are unchanged.
+class InlineCostCache {
+public:
+  enum CostKind { CK_Variable, CK_Always, CK_Never };
+
+  struct CachedCost {
+    Function *Caller, *Callee;
+    unsigned CallerVersion, CalleeVersion;
+    CostKind Kind;
+    int Cost, Threshold;
+
+    InlineCost rebuild() const {
+      if (Kind == CK_Always)
+        return InlineCost::getAlways();
+      if (Kind == CK_Never)
+        return InlineCost::getNever();
+      return InlineCost::get(Cost, Threshold);
+    }
+  };
+
+  /// SharedKey - Key for costs shared between call sites: the callee, the
+  /// threshold the policy used, and the bits of call-site context the
+  /// analyzer specializes on (caller recursion, last-call-to-static bonus).
+  typedef std::pair<Function*, std::pair<int, unsigned> > SharedKey;
+
+private:
+  DenseMap<Function*, unsigned> Versions;
+  DenseMap<Instruction*, CachedCost> Cache;
+  DenseMap<SharedKey, CachedCost> SharedCache;
+  DenseMap<Function*, std::pair<unsigned, bool> > RecursionCache;
+
+public:
+  /// lookup - Return the still-valid cached cost for this call site, or null.
+  const CachedCost *lookup(CallSite CS) const {
+    DenseMap<Instruction*, CachedCost>::const_iterator I =
+      Cache.find(CS.getInstruction());
+    if (I == Cache.end())
+      return 0;
+    const CachedCost &C = I->second;
+    // The instruction's memory may have been recycled for a different call
+    // since the entry was made, so check the identity of both functions as
+    // well as their versions.
+    if (C.Caller != CS.getCaller() || C.Callee != CS.getCalledFunction() ||
+        C.CallerVersion != Versions.lookup(C.Caller) ||
+        C.CalleeVersion != Versions.lookup(C.Callee))
+      return 0;
+    return &C;
+  }
+
+  void insert(CallSite CS, const InlineCost &IC) {
+    Function *Callee = CS.getCalledFunction();
+    if (!Callee)
+      return;
+    CachedCost &C = Cache[CS.getInstruction()];
+    C.Caller = CS.getCaller();
+    C.Callee = Callee;
+    C.CallerVersion = Versions.lookup(C.Caller);
+    C.CalleeVersion = Versions.lookup(Callee);
+    if (IC.isAlways()) {
+      C.Kind = CK_Always;
+      C.Cost = C.Threshold = 0;
+    } else if (IC.isNever()) {
+      C.Kind = CK_Never;
+      C.Cost = C.Threshold = 0;
+    } else {
+      C.Kind = CK_Variable;
+      C.Cost = IC.getCost();
+      C.Threshold = IC.getCost() + IC.getCostDelta();
+    }
+  }
+
+  /// lookupShared - Return the still-valid cost shared by all shape-neutral
+  /// call sites with this key, or null.
+  const CachedCost *lookupShared(Function *Callee, int Threshold,
+                                 unsigned Bits) const {
+    DenseMap<SharedKey, CachedCost>::const_iterator I =
+      SharedCache.find(SharedKey(Callee, std::make_pair(Threshold, Bits)));
+    if (I == SharedCache.end())
+      return 0;
+    const CachedCost &C = I->second;
+    if (C.CalleeVersion != Versions.lookup(Callee))
+      return 0;
+    return &C;
+  }
+
+  void insertShared(Function *Callee, int Threshold, unsigned Bits,
+                    const InlineCost &IC) {
+    CachedCost &C = SharedCache[SharedKey(Callee,
+                                          std::make_pair(Threshold, Bits))];
+    C.Caller = 0;
+    C.Callee = Callee;
+    C.CallerVersion = 0;
+    C.CalleeVersion = Versions.lookup(Callee);
+    if (IC.isAlways()) {
+      C.Kind = CK_Always;
+      C.Cost = C.Threshold = 0;
+    } else if (IC.isNever()) {
+      C.Kind = CK_Never;
+      C.Cost = C.Threshold = 0;
+    } else {
+      C.Kind = CK_Variable;
+      C.Cost = IC.getCost();
+      C.Threshold = IC.getCost() + IC.getCostDelta();
+    }
+  }
+
+  /// isRecursiveCaller - Return true if any use of F is a call site inside F
+  /// itself.  The answer is memoized against F's version; any change to F's
+  /// body (which is what adds or removes such self calls) invalidates it.
+  bool isRecursiveCaller(Function *F) {
+    std::pair<unsigned, bool> &Entry = RecursionCache[F];
+    // Entry.first holds the version the answer was computed at, plus one so
+    // that the default-constructed entry is never mistaken for a real one.
+    unsigned Version = Versions.lookup(F);
+    if (Entry.first == Version + 1)
+      return Entry.second;
+    bool Recursive = false;
+    for (Value::use_iterator U = F->use_begin(), E = F->use_end();
+         U != E; ++U) {
+      CallSite Site(cast<Value>(*U));
+      if (Site && Site.getInstruction()->getParent()->getParent() == F) {
+        Recursive = true;
+        break;
+      }
+    }
+    Entry = std::make_pair(Version + 1, Recursive);
+    return Recursive;
+  }
+
+  /// invalidateFunction - Note that F's body has changed, invalidating every
+  /// cached cost involving it.
+  void invalidateFunction(Function *F) { ++Versions[F]; }
+
+  /// forgetFunction - Drop the version entry for a function that is being
+  /// deleted.
+  void forgetFunction(Function *F) {
+    Versions.erase(F);
+    RecursionCache.erase(F);
+  }
+
+  /// eraseCallSite - Drop the entry for a call instruction that is being
+  /// deleted.
+  void eraseCallSite(Instruction *I) { Cache.erase(I); }
+};
+} // End llvm namespace
+
+Inliner::Inliner(char &ID)
+  : CallGraphSCCPass(ID), InlineThreshold(InlineLimit), InsertLifetime(true),
+    CostCache(0), InlinedCostTotal(0) {}
 
 Inliner::Inliner(char &ID, int Threshold, bool InsertLifetime)
   : CallGraphSCCPass(ID), InlineThreshold(InlineLimit.getNumOccurrences() > 0 ?
                                           InlineLimit : Threshold),
-    InsertLifetime(InsertLifetime) {}
+    InsertLifetime(InsertLifetime), CostCache(0), InlinedCostTotal(0) {}
 
 /// getAnalysisUsage - For this class, we declare that we require and preserve
 /// the call graph.  If the derived class implements this method, it should
@@ -257,11 +421,82 @@ unsigned Inliner::getInlineThreshold(CallSite CS) const {
   return thres;
 }
 
+/// isShapeNeutralCallSite - Return true if the cost analysis cannot tell
+/// this call site apart from any other site with the same callee, threshold,
+/// and caller-recursion status.  The analyzer specializes on constant
+/// arguments, alloca-derived and constant-offset pointers, byval copies,
+/// repeated pointer arguments, noinline markings, and calls whose
+/// continuation is unreachable; a site with any of those only gets the
+/// per-site cache.
+static bool isShapeNeutralCallSite(CallSite CS) {
+  if (CS.isNoInline())
+    return false;
+
+  // A call followed by unreachable is analyzed with a threshold of 1.
+  Instruction *I = CS.getInstruction();
+  if (InvokeInst *II = dyn_cast<InvokeInst>(I)) {
+    if (isa<UnreachableInst>(II->getNormalDest()->begin()))
+      return false;
+  } else if (isa<UnreachableInst>(++BasicBlock::iterator(I)))
+    return false;
+
+  SmallPtrSet<Value*, 8> PtrArgs;
+  for (unsigned i = 0, e = CS.arg_size(); i != e; ++i) {
+    Value *V = CS.getArgument(i);
+    if (isa<Constant>(V))
+      return false;
+    if (!V->getType()->isPointerTy())
+      continue;
+    // The analyzer models SROA of allocas and folds away known constant
+    // pointer offsets; only pass-through pointers look the same everywhere.
+    if (CS.isByValArgument(i) || isa<AllocaInst>(V) ||
+        V->stripInBoundsConstantOffsets() != V)
+      return false;
+    // Passing the same pointer twice lets the analyzer fold comparisons
+    // between the corresponding formals.
+    if (!PtrArgs.insert(V))
+      return false;
+  }
+  return true;
+}
+
+/// getCachedInlineCost - Like getInlineCost, but memoizes the result in
+/// CostCache when one is active, so that repeated queries for a call site
+/// whose caller and callee are unchanged do not rerun the cost analysis.
+/// Shape-neutral call sites additionally share one cached cost per callee,
+/// so re-evaluating the same small callee from many sites is a hash lookup.
+InlineCost Inliner::getCachedInlineCost(CallSite CS) {
+  if (!CostCache)
+    return getInlineCost(CS);
+  if (const InlineCostCache::CachedCost *C = CostCache->lookup(CS))
+    return C->rebuild();
+
+  Function *Callee = CS.getCalledFunction();
+  bool Shareable = Callee && !Callee->isDeclaration() &&
+                   isShapeNeutralCallSite(CS);
+  int Threshold = 0;
+  unsigned Bits = 0;
+  if (Shareable) {
+    Threshold = getInlineThreshold(CS);
+    Bits = (CostCache->isRecursiveCaller(CS.getCaller()) ? 1u : 0u) |
+           ((Callee->hasLocalLinkage() && Callee->hasOneUse()) ? 2u : 0u);
+    if (const InlineCostCache::CachedCost *C =
+          CostCache->lookupShared(Callee, Threshold, Bits))
+      return C->rebuild();
+  }
+
+  InlineCost IC = getInlineCost(CS);
+  CostCache->insert(CS, IC);
+  if (Shareable)
+    CostCache->insertShared(Callee, Threshold, Bits, IC);
+  return IC;
+}
+
 /// shouldInline - Return true if the inliner should attempt to inline
 /// at the given CallSite.
 bool Inliner::shouldInline(CallSite CS) {
-  InlineCost IC = getInlineCost(CS);
-  
+  InlineCost IC = getCachedInlineCost(CS);
+
   if (IC.isAlways()) {
     DEBUG(dbgs() << "    Inlining: cost=always"
           << ", Call: " << *CS.getInstruction() << "\n");
@@ -273,7 +508,15 @@ bool Inliner::shouldInline(CallSite CS) {
           << ", Call: " << *CS.getInstruction() << "\n");
     return false;
   }
-  
+
+  // If a module-wide budget is in effect and it has been used up, only
+  // always-inline call sites may still be inlined.
+  if (InlineModuleBudget >= 0 && InlinedCostTotal > InlineModuleBudget) {
+    DEBUG(dbgs() << "    NOT Inlining: module budget exhausted"
+          << ", Call: " << *CS.getInstruction() << "\n");
+    return false;
+  }
+
   Function *Caller = CS.getCaller();
   if (!IC) {
     DEBUG(dbgs() << "    NOT Inlining: cost=" << IC.getCost()
@@ -319,7 +562,7 @@ bool Inliner::shouldInline(CallSite CS) {
         continue;
       }
 
-      InlineCost IC2 = getInlineCost(CS2);
+      InlineCost IC2 = getCachedInlineCost(CS2);
       ++NumCallerCallersAnalyzed;
       if (!IC2) {
         callerWillBeRemoved = false;
@@ -371,6 +614,13 @@ static bool InlineHistoryIncludes(Function *F, int InlineHistoryID,
   return false;
 }
 
+typedef std::pair<int, std::pair<CallSite, int> > PrioritizedCallSite;
+
+static bool lowerCostKey(const PrioritizedCallSite &LHS,
+                         const PrioritizedCallSite &RHS) {
+  return LHS.first < RHS.first;
+}
+
 bool Inliner::runOnSCC(CallGraphSCC &SCC) {
   CallGraph &CG = getAnalysis<CallGraph>();
   const DataLayout *TD = getAnalysisIfAvailable<DataLayout>();
@@ -434,13 +684,48 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
   
   InlinedArrayAllocasTy InlinedArrayAllocas;
   InlineFunctionInfo InlineInfo(&CG, TD);
-  
+
+  // Memoize inline costs for the duration of this SCC visit.  The do/while
+  // loop below revisits every remaining call site each round, and without the
+  // cache each visit reruns the full cost analysis even when neither the
+  // caller nor the callee has changed since the last round.
+  InlineCostCache Cache;
+  CostCache = &Cache;
+
   // Now that we have all of the call sites, loop over them and inline them if
   // it looks profitable to do so.
   bool Changed = false;
   bool LocalChange;
   do {
     LocalChange = false;
+
+    // In priority mode, order the remaining candidates by how far their
+    // estimated cost falls below their threshold, so the most profitable
+    // (typically small, hot) callees are inlined first while the budget
+    // lasts.  This supersedes the SCC-calls-last heuristic above.  Keys are
+    // computed once per round from the cost cache; candidates invalidated by
+    // this round's inlining are re-keyed at the start of the next round.
+    if (InlinePriorityQueue && CallSites.size() > 1) {
+      SmallVector<PrioritizedCallSite, 16> Keyed;
+      Keyed.reserve(CallSites.size());
+      for (unsigned i = 0, e = CallSites.size(); i != e; ++i) {
+        CallSite CS = CallSites[i].first;
+        Function *Callee = CS.getCalledFunction();
+        int Key = INT_MAX; // Indirect calls and declarations sort last.
+        if (Callee && !Callee->isDeclaration()) {
+          InlineCost IC = getCachedInlineCost(CS);
+          if (IC.isAlways())
+            Key = INT_MIN;
+          else if (!IC.isNever())
+            Key = -IC.getCostDelta();
+        }
+        Keyed.push_back(std::make_pair(Key, CallSites[i]));
+      }
+      std::stable_sort(Keyed.begin(), Keyed.end(), lowerCostKey);
+      for (unsigned i = 0, e = Keyed.size(); i != e; ++i)
+        CallSites[i] = Keyed[i].second;
+    }
+
     // Iterate over the outer loop because inlining functions can cause indirect
     // calls to become direct calls.
     for (unsigned CSi = 0; CSi != CallSites.size(); ++CSi) {
@@ -458,6 +743,7 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
                      << *CS.getInstruction() << "\n");
         // Update the call graph by deleting the edge from Callee to Caller.
         CG[Caller]->removeCallEdgeFor(CS);
+        Cache.eraseCallSite(CS.getInstruction());
         CS.getInstruction()->eraseFromParent();
         ++NumCallsDeleted;
       } else {
@@ -480,12 +766,28 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
         if (!shouldInline(CS))
           continue;
 
+        // Read the estimate off the cache now if we are charging a budget;
+        // the call instruction dies when inlining succeeds.
+        int ChargedCost = 0;
+        if (InlineModuleBudget >= 0) {
+          InlineCost IC = getCachedInlineCost(CS);
+          if (IC.isVariable())
+            ChargedCost = IC.getCost();
+        }
+        Instruction *TheCall = CS.getInstruction();
+
         // Attempt to inline the function.
         if (!InlineCallIfPossible(CS, InlineInfo, InlinedArrayAllocas,
                                   InlineHistoryID, InsertLifetime))
           continue;
         ++NumInlined;
-        
+        InlinedCostTotal += ChargedCost;
+
+        // The call instruction is gone and the caller's body has changed, so
+        // costs involving the caller must be recomputed.
+        Cache.eraseCallSite(TheCall);
+        Cache.invalidateFunction(Caller);
+
         // If inlining this function gave us any new call sites, throw them
         // onto our worklist to process.  They are useful inline candidates.
         if (!InlineInfo.InlinedCalls.empty()) {
@@ -518,7 +820,9 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
         
         // Remove any call graph edges from the callee to its callees.
         CalleeNode->removeAllCalledFunctions();
-        
+
+        Cache.forgetFunction(Callee);
+
         // Removing the node for callee from the call graph and delete it.
         delete CG.removeFunctionFromModule(CalleeNode);
         ++NumDeleted;
@@ -541,6 +845,7 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
     }
   } while (LocalChange);
 
+  CostCache = 0;
   return Changed;
 }
 
@@ -72,9 +72,26 @@ STATISTIC(NumThunksWritten, "Number of thunks generated");
 STATISTIC(NumAliasesWritten, "Number of aliases generated");
 STATISTIC(NumDoubleWeak, "Number of new functions created");
 
+/// Hash a coarse type kind. The comparator considers a pointer and the
+/// integer type of pointer width interchangeable when DataLayout is
+/// available, so the two kinds must fold to the same value.
+static unsigned profileTypeKind(Type *Ty) {
+  unsigned TypeID = Ty->getTypeID();
+  if (TypeID == Type::PointerTyID)
+    TypeID = Type::IntegerTyID;
+  return TypeID;
+}
+
 /// Creates a hash-code for the function which is the same for any two
-/// functions that will compare equal, without looking at the instructions
-/// inside the function.
+/// functions that will compare equal. In addition to the signature, this
+/// folds in the structure of the body: the opcode sequence, operand counts,
+/// operand constant-ness and result type kinds, visited in the same
+/// CFG-ordered walk the comparator uses. Only properties the comparator
+/// treats as significant may be hashed: GEPs can compare equal on their
+/// computed offset alone, and constants on bitcast equivalence, so neither
+/// contributes more than its presence. The result is that the full
+/// structural comparison only runs between functions that already agree on
+/// their entire instruction skeleton.
 static unsigned profileFunction(const Function *F) {
   FunctionType *FTy = F->getFunctionType();
 
@@ -83,9 +100,42 @@ static unsigned profileFunction(const Function *F) {
   ID.AddInteger(F->getCallingConv());
   ID.AddBoolean(F->hasGC());
   ID.AddBoolean(FTy->isVarArg());
-  ID.AddInteger(FTy->getReturnType()->getTypeID());
+  ID.AddInteger(profileTypeKind(FTy->getReturnType()));
   for (unsigned i = 0, e = FTy->getNumParams(); i != e; ++i)
-    ID.AddInteger(FTy->getParamType(i)->getTypeID());
+    ID.AddInteger(profileTypeKind(FTy->getParamType(i)));
+
+  // Walk the CFG in the same order as FunctionComparator::compare so that
+  // unreachable blocks are ignored and block layout doesn't matter.
+  SmallVector<const BasicBlock *, 8> BBs;
+  SmallSet<const BasicBlock *, 128> VisitedBBs;
+
+  BBs.push_back(&F->getEntryBlock());
+  VisitedBBs.insert(BBs[0]);
+  while (!BBs.empty()) {
+    const BasicBlock *BB = BBs.pop_back_val();
+    for (BasicBlock::const_iterator I = BB->begin(), E = BB->end();
+         I != E; ++I) {
+      ID.AddInteger(I->getOpcode());
+      // With DataLayout two GEPs are equivalent whenever they compute the
+      // same offset, regardless of their index lists, so nothing beyond the
+      // opcode can be hashed for them.
+      if (isa<GetElementPtrInst>(I))
+        continue;
+      ID.AddInteger(I->getNumOperands());
+      ID.AddInteger(profileTypeKind(I->getType()));
+      // A constant operand never pairs with a non-constant one, but its
+      // type may vary across bitcast-equivalent constants, so only the
+      // constant-ness is hashed.
+      for (unsigned i = 0, e = I->getNumOperands(); i != e; ++i)
+        ID.AddBoolean(isa<Constant>(I->getOperand(i)));
+    }
+
+    const TerminatorInst *TI = BB->getTerminator();
+    for (unsigned i = 0, e = TI->getNumSuccessors(); i != e; ++i)
+      if (VisitedBBs.insert(TI->getSuccessor(i)))
+        BBs.push_back(TI->getSuccessor(i));
+  }
+
   return ID.ComputeHash();
 }
 
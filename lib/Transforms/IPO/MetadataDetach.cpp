@@ -0,0 +1,203 @@
+//===- MetadataDetach.cpp - Stash metadata around the IPO pipeline --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// When the same bitcode feeds both debug and release codegen, dragging debug
+// metadata through the heavy interprocedural passes costs compile time even
+// if a later consumer strips it anyway.  The MetadataDetach pass unhooks
+// non-essential instruction metadata (debug locations and attachments other
+// than a configurable keep list, by default just tbaa) into a sidecar map
+// before IPO; MetadataReattach restores whatever mappings survived -- the
+// sidecar tracks instruction deletion, so metadata for code that was
+// optimized away simply evaporates.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "metadata-detach"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/ValueMap.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+using namespace llvm;
+
+STATISTIC(NumDetached,   "Number of metadata attachments detached");
+STATISTIC(NumReattached, "Number of metadata attachments reattached");
+
+static cl::list<std::string>
+KeepMDKinds("detach-md-keep", cl::CommaSeparated, cl::Hidden,
+            cl::desc("Metadata kinds to keep attached through the pipeline "
+                     "(default: tbaa)"));
+
+namespace {
+  /// StashMapConfig - ValueMap configuration for the stash.  Deletion
+  /// callbacks are all we want: the default FollowRAUW behavior would try to
+  /// re-key an entry onto the replacement value, which need not be an
+  /// Instruction at all -- instcombine and friends routinely RAUW an
+  /// instruction with a Constant, and casting that back to an Instruction
+  /// key is not survivable.  The old metadata does not describe the
+  /// replacement anyway, so let the entry die with the original instruction.
+  struct StashMapConfig : public ValueMapConfig<Instruction*> {
+    enum { FollowRAUW = false };
+  };
+
+  /// MetadataStash - Immutable analysis holding the detached metadata between
+  /// the detach and reattach passes.  Using a ValueMap means entries for
+  /// instructions that IPO deletes disappear automatically.
+  class MetadataStash : public ImmutablePass {
+  public:
+    static char ID; // Pass identification, replacement for typeid
+
+    struct Entry {
+      DebugLoc DL;
+      SmallVector<std::pair<unsigned, MDNode*>, 2> MDs;
+    };
+    typedef ValueMap<Instruction*, Entry, StashMapConfig> MapTy;
+    MapTy Stash;
+
+    MetadataStash() : ImmutablePass(ID) {
+      initializeMetadataStashPass(*PassRegistry::getPassRegistry());
+    }
+  };
+
+  class MetadataDetach : public ModulePass {
+  public:
+    static char ID; // Pass identification, replacement for typeid
+    MetadataDetach() : ModulePass(ID) {
+      initializeMetadataDetachPass(*PassRegistry::getPassRegistry());
+    }
+
+    virtual bool runOnModule(Module &M);
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.addRequired<MetadataStash>();
+      AU.setPreservesCFG();
+    }
+  };
+
+  class MetadataReattach : public ModulePass {
+  public:
+    static char ID; // Pass identification, replacement for typeid
+    MetadataReattach() : ModulePass(ID) {
+      initializeMetadataReattachPass(*PassRegistry::getPassRegistry());
+    }
+
+    virtual bool runOnModule(Module &M);
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.addRequired<MetadataStash>();
+      AU.setPreservesCFG();
+    }
+  };
+}
+
+char MetadataStash::ID = 0;
+INITIALIZE_PASS(MetadataStash, "metadata-stash",
+                "Detached metadata sidecar", false, true)
+
+char MetadataDetach::ID = 0;
+INITIALIZE_PASS_BEGIN(MetadataDetach, "metadata-detach",
+                "Detach non-essential metadata into a sidecar", false, false)
+INITIALIZE_PASS_DEPENDENCY(MetadataStash)
+INITIALIZE_PASS_END(MetadataDetach, "metadata-detach",
+                "Detach non-essential metadata into a sidecar", false, false)
+
+char MetadataReattach::ID = 0;
+INITIALIZE_PASS_BEGIN(MetadataReattach, "metadata-reattach",
+                "Reattach metadata from the sidecar", false, false)
+INITIALIZE_PASS_DEPENDENCY(MetadataStash)
+INITIALIZE_PASS_END(MetadataReattach, "metadata-reattach",
+                "Reattach metadata from the sidecar", false, false)
+
+ModulePass *llvm::createMetadataDetachPass() { return new MetadataDetach(); }
+ModulePass *llvm::createMetadataReattachPass() {
+  return new MetadataReattach();
+}
+
+bool MetadataDetach::runOnModule(Module &M) {
+  MetadataStash::MapTy &Stash = getAnalysis<MetadataStash>().Stash;
+  LLVMContext &Context = M.getContext();
+
+  // Kinds that stay attached.  Semantically load-bearing metadata like tbaa
+  // must keep flowing through the optimizers by default.
+  SmallSet<unsigned, 4> KeepKinds;
+  if (KeepMDKinds.empty())
+    KeepKinds.insert(Context.getMDKindID("tbaa"));
+  for (unsigned i = 0, e = KeepMDKinds.size(); i != e; ++i)
+    KeepKinds.insert(Context.getMDKindID(KeepMDKinds[i]));
+
+  bool Changed = false;
+  SmallVector<std::pair<unsigned, MDNode*>, 4> MDs;
+  for (Module::iterator F = M.begin(), FE = M.end(); F != FE; ++F)
+    for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB)
+      for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I){
+        bool HasDebugLoc = !I->getDebugLoc().isUnknown();
+        if (!I->hasMetadataOtherThanDebugLoc() && !HasDebugLoc)
+          continue;
+
+        MetadataStash::Entry Entry;
+        if (I->hasMetadataOtherThanDebugLoc()) {
+          MDs.clear();
+          I->getAllMetadataOtherThanDebugLoc(MDs);
+          for (unsigned i = 0, e = MDs.size(); i != e; ++i) {
+            if (KeepKinds.count(MDs[i].first))
+              continue;
+            Entry.MDs.push_back(MDs[i]);
+            I->setMetadata(MDs[i].first, 0);
+            ++NumDetached;
+          }
+        }
+        if (HasDebugLoc) {
+          Entry.DL = I->getDebugLoc();
+          I->setDebugLoc(DebugLoc());
+          ++NumDetached;
+        }
+
+        if (HasDebugLoc || !Entry.MDs.empty()) {
+          Stash[I] = Entry;
+          Changed = true;
+        }
+      }
+  return Changed;
+}
+
+bool MetadataReattach::runOnModule(Module &M) {
+  MetadataStash::MapTy &Stash = getAnalysis<MetadataStash>().Stash;
+
+  bool Changed = false;
+  for (MetadataStash::MapTy::iterator SI = Stash.begin(), SE = Stash.end();
+       SI != SE; ++SI) {
+    Instruction *I = SI->first;
+    // Deleting an instruction drops its entry, but an instruction can also
+    // be unlinked from its block without being destroyed; there is nothing
+    // to reattach to in that case.
+    if (!I->getParent() || !I->getParent()->getParent())
+      continue;
+    // The stash is process-wide state; only touch instructions that belong
+    // to this module.
+    if (I->getParent()->getParent()->getParent() != &M)
+      continue;
+    const MetadataStash::Entry &Entry = SI->second;
+
+    if (!Entry.DL.isUnknown()) {
+      I->setDebugLoc(Entry.DL);
+      ++NumReattached;
+    }
+    for (unsigned i = 0, e = Entry.MDs.size(); i != e; ++i) {
+      I->setMetadata(Entry.MDs[i].first, Entry.MDs[i].second);
+      ++NumReattached;
+    }
+    Changed = true;
+  }
+  Stash.clear();
+  return Changed;
+}
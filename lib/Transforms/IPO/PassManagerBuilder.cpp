@@ -17,6 +17,7 @@
 #include "llvm-c/Transforms/PassManagerBuilder.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Analysis/Passes.h"
+#include "llvm/Analysis/ProfileDataLoader.h"
 #include "llvm/Analysis/Verifier.h"
 #include "llvm/PassManager.h"
 #include "llvm/Support/CommandLine.h"
@@ -32,6 +33,10 @@ static cl::opt<bool>
 RunLoopVectorization("vectorize-loops",
                      cl::desc("Run the Loop vectorization passes"));
 
+static cl::opt<bool>
+RunSLPVectorization("vectorize-slp",
+                    cl::desc("Run the SLP vectorization passes"));
+
 static cl::opt<bool>
 RunBBVectorization("vectorize", cl::desc("Run the BB vectorization passes"));
 
@@ -49,11 +54,13 @@ PassManagerBuilder::PassManagerBuilder() {
     SizeLevel = 0;
     LibraryInfo = 0;
     Inliner = 0;
+    ProfileDataFile = "";
     DisableSimplifyLibCalls = false;
     DisableUnitAtATime = false;
     DisableUnrollLoops = false;
     Vectorize = RunBBVectorization;
     LoopVectorize = RunLoopVectorization;
+    SLPVectorize = RunSLPVectorization;
 }
 
 PassManagerBuilder::~PassManagerBuilder() {
@@ -114,6 +121,13 @@ void PassManagerBuilder::populateFunctionPassManager(FunctionPassManager &FPM) {
 }
 
 void PassManagerBuilder::populateModulePassManager(PassManagerBase &MPM) {
+  // Load profile data first so that branch weight metadata is laid down
+  // before any pass clones or restructures the CFG; the metadata is then
+  // carried through the rest of the pipeline and into codegen, where block
+  // placement lays out code from the measured frequencies.
+  if (!ProfileDataFile.empty())
+    MPM.add(createProfileMetadataLoaderPass(ProfileDataFile));
+
   // If all optimizations are disabled, just run the always-inline pass.
   if (OptLevel == 0) {
     if (Inliner) {
@@ -207,6 +221,9 @@ void PassManagerBuilder::populateModulePassManager(PassManagerBase &MPM) {
 
   addExtensionsToPM(EP_ScalarOptimizerLate, MPM);
 
+  if (SLPVectorize)
+    MPM.add(createSLPVectorizerPass());         // Vectorize parallel scalar chains.
+
   if (Vectorize) {
     MPM.add(createBBVectorizePass());
     MPM.add(createInstructionCombiningPass());
@@ -1804,12 +1804,20 @@ Instruction *InstCombiner::visitOr(BinaryOperator &I) {
   Value *A = 0, *B = 0;
   ConstantInt *C1 = 0, *C2 = 0;
 
+  // Decode the operand structure once.  Most of the patterns below only
+  // apply when one or both operands are binary operators with a specific
+  // opcode, so test the decoded opcodes directly instead of re-running a
+  // match() chain for each pattern.
+  BinaryOperator *Op0BO = dyn_cast<BinaryOperator>(Op0);
+  BinaryOperator *Op1BO = dyn_cast<BinaryOperator>(Op1);
+  unsigned Opc0 = Op0BO ? Op0BO->getOpcode() : 0;
+  unsigned Opc1 = Op1BO ? Op1BO->getOpcode() : 0;
+
   // (A | B) | C  and  A | (B | C)                  -> bswap if possible.
   // (A >> B) | (C << D)  and  (A << B) | (B >> C)  -> bswap if possible.
-  if (match(Op0, m_Or(m_Value(), m_Value())) ||
-      match(Op1, m_Or(m_Value(), m_Value())) ||
-      (match(Op0, m_LogicalShift(m_Value(), m_Value())) &&
-       match(Op1, m_LogicalShift(m_Value(), m_Value())))) {
+  if (Opc0 == Instruction::Or || Opc1 == Instruction::Or ||
+      (Op0BO && Op1BO &&
+       Op0BO->isLogicalShift() && Op1BO->isLogicalShift())) {
     if (Instruction *BSwap = MatchBSwap(I))
       return BSwap;
   }
@@ -1834,8 +1842,9 @@ Instruction *InstCombiner::visitOr(BinaryOperator &I) {
 
   // (A & C)|(B & D)
   Value *C = 0, *D = 0;
-  if (match(Op0, m_And(m_Value(A), m_Value(C))) &&
-      match(Op1, m_And(m_Value(B), m_Value(D)))) {
+  if (Opc0 == Instruction::And && Opc1 == Instruction::And) {
+    A = Op0BO->getOperand(0); C = Op0BO->getOperand(1);
+    B = Op1BO->getOperand(0); D = Op1BO->getOperand(1);
     Value *V1 = 0, *V2 = 0;
     C1 = dyn_cast<ConstantInt>(C);
     C2 = dyn_cast<ConstantInt>(D);
@@ -1941,16 +1950,13 @@ Instruction *InstCombiner::visitOr(BinaryOperator &I) {
   }
 
   // (X >> Z) | (Y >> Z)  -> (X|Y) >> Z  for all shifts.
-  if (BinaryOperator *SI1 = dyn_cast<BinaryOperator>(Op1)) {
-    if (BinaryOperator *SI0 = dyn_cast<BinaryOperator>(Op0))
-      if (SI0->isShift() && SI0->getOpcode() == SI1->getOpcode() &&
-          SI0->getOperand(1) == SI1->getOperand(1) &&
-          (SI0->hasOneUse() || SI1->hasOneUse())) {
-        Value *NewOp = Builder->CreateOr(SI0->getOperand(0), SI1->getOperand(0),
-                                         SI0->getName());
-        return BinaryOperator::Create(SI1->getOpcode(), NewOp,
-                                      SI1->getOperand(1));
-      }
+  if (Op0BO && Op1BO && Op0BO->isShift() && Opc0 == Opc1 &&
+      Op0BO->getOperand(1) == Op1BO->getOperand(1) &&
+      (Op0BO->hasOneUse() || Op1BO->hasOneUse())) {
+    Value *NewOp = Builder->CreateOr(Op0BO->getOperand(0),
+                                     Op1BO->getOperand(0), Op0BO->getName());
+    return BinaryOperator::Create(Op1BO->getOpcode(), NewOp,
+                                  Op1BO->getOperand(1));
   }
 
   // (~A | ~B) == (~(A & B)) - De Morgan's Law
@@ -1964,15 +1970,19 @@ Instruction *InstCombiner::visitOr(BinaryOperator &I) {
 
   // Canonicalize xor to the RHS.
   bool SwappedForXor = false;
-  if (match(Op0, m_Xor(m_Value(), m_Value()))) {
+  if (Opc0 == Instruction::Xor) {
     std::swap(Op0, Op1);
+    std::swap(Op0BO, Op1BO);
+    std::swap(Opc0, Opc1);
     SwappedForXor = true;
   }
 
   // A | ( A ^ B) -> A |  B
   // A | (~A ^ B) -> A | ~B
   // (A & B) | (A ^ B)
-  if (match(Op1, m_Xor(m_Value(A), m_Value(B)))) {
+  if (Opc1 == Instruction::Xor) {
+    A = Op1BO->getOperand(0);
+    B = Op1BO->getOperand(1);
     if (Op0 == A || Op0 == B)
       return BinaryOperator::CreateOr(A, B);
 
@@ -2228,10 +2238,12 @@ Instruction *InstCombiner::visitXor(BinaryOperator &I) {
         return NV;
   }
 
+  // As in visitOr, decode the operand structure once and test the opcodes
+  // directly rather than re-running match() per pattern.
   BinaryOperator *Op1I = dyn_cast<BinaryOperator>(Op1);
   if (Op1I) {
-    Value *A, *B;
-    if (match(Op1I, m_Or(m_Value(A), m_Value(B)))) {
+    Value *A = Op1I->getOperand(0), *B = Op1I->getOperand(1);
+    if (Op1I->getOpcode() == Instruction::Or) {
       if (A == Op0) {              // B^(B|A) == (A|B)^B
         Op1I->swapOperands();
         I.swapOperands();
@@ -2240,7 +2252,7 @@ Instruction *InstCombiner::visitXor(BinaryOperator &I) {
         I.swapOperands();     // Simplified below.
         std::swap(Op0, Op1);
       }
-    } else if (match(Op1I, m_And(m_Value(A), m_Value(B))) &&
+    } else if (Op1I->getOpcode() == Instruction::And &&
                Op1I->hasOneUse()){
       if (A == Op0) {                                      // A^(A&B) -> A^(B&A)
         Op1I->swapOperands();
@@ -2255,14 +2267,14 @@ Instruction *InstCombiner::visitXor(BinaryOperator &I) {
 
   BinaryOperator *Op0I = dyn_cast<BinaryOperator>(Op0);
   if (Op0I) {
-    Value *A, *B;
-    if (match(Op0I, m_Or(m_Value(A), m_Value(B))) &&
+    Value *A = Op0I->getOperand(0), *B = Op0I->getOperand(1);
+    if (Op0I->getOpcode() == Instruction::Or &&
         Op0I->hasOneUse()) {
       if (A == Op1)                                  // (B|A)^B == (A|B)^B
         std::swap(A, B);
       if (B == Op1)                                  // (A|B)^B == A & ~B
         return BinaryOperator::CreateAnd(A, Builder->CreateNot(Op1));
-    } else if (match(Op0I, m_And(m_Value(A), m_Value(B))) &&
+    } else if (Op0I->getOpcode() == Instruction::And &&
                Op0I->hasOneUse()){
       if (A == Op1)                                        // (A&B)^A -> (B&A)^A
         std::swap(A, B);
@@ -2285,20 +2297,17 @@ Instruction *InstCombiner::visitXor(BinaryOperator &I) {
                                   Op1I->getOperand(1));
   }
 
-  if (Op0I && Op1I) {
-    Value *A, *B, *C, *D;
-    // (A & B)^(A | B) -> A ^ B
-    if (match(Op0I, m_And(m_Value(A), m_Value(B))) &&
-        match(Op1I, m_Or(m_Value(C), m_Value(D)))) {
-      if ((A == C && B == D) || (A == D && B == C))
-        return BinaryOperator::CreateXor(A, B);
-    }
-    // (A | B)^(A & B) -> A ^ B
-    if (match(Op0I, m_Or(m_Value(A), m_Value(B))) &&
-        match(Op1I, m_And(m_Value(C), m_Value(D)))) {
-      if ((A == C && B == D) || (A == D && B == C))
-        return BinaryOperator::CreateXor(A, B);
-    }
+  // (A & B)^(A | B) -> A ^ B
+  // (A | B)^(A & B) -> A ^ B
+  if (Op0I && Op1I &&
+      ((Op0I->getOpcode() == Instruction::And &&
+        Op1I->getOpcode() == Instruction::Or) ||
+       (Op0I->getOpcode() == Instruction::Or &&
+        Op1I->getOpcode() == Instruction::And))) {
+    Value *A = Op0I->getOperand(0), *B = Op0I->getOperand(1);
+    Value *C = Op1I->getOperand(0), *D = Op1I->getOperand(1);
+    if ((A == C && B == D) || (A == D && B == C))
+      return BinaryOperator::CreateXor(A, B);
   }
 
   // (icmp1 A, B) ^ (icmp2 A, B) --> (icmp3 A, B)
@@ -25,17 +25,55 @@ namespace llvm {
 class LLVM_LIBRARY_VISIBILITY InstCombineWorklist {
   SmallVector<Instruction*, 256> Worklist;
   DenseMap<Instruction*, unsigned> WorklistMap;
+  // When generation tracking is enabled, records for each instruction the
+  // generation (iteration number) at which it was last marked changed.
+  // Instructions seeded by AddInitialGroup are deliberately not stamped;
+  // only instructions something actually changed are.
+  DenseMap<Instruction*, unsigned> ChangeGen;
+  unsigned Generation;
+  bool TrackGenerations;
 
   void operator=(const InstCombineWorklist&RHS) LLVM_DELETED_FUNCTION;
   InstCombineWorklist(const InstCombineWorklist&) LLVM_DELETED_FUNCTION;
 public:
-  InstCombineWorklist() {}
+  InstCombineWorklist() : Generation(0), TrackGenerations(false) {}
 
   bool isEmpty() const { return Worklist.empty(); }
 
+  /// beginGeneration - Start a new worklist generation and enable
+  /// generation tracking. Until the next call, MarkChanged stamps
+  /// instructions with Gen.
+  void beginGeneration(unsigned Gen) {
+    Generation = Gen;
+    TrackGenerations = true;
+  }
+
+  /// resetGenerations - Drop all generation stamps and disable tracking.
+  /// Call this when the current function is done; stamps must not leak
+  /// into the next function since instruction memory may be recycled.
+  void resetGenerations() {
+    ChangeGen.clear();
+    TrackGenerations = false;
+  }
+
+  /// MarkChanged - Record that I was created or modified in the current
+  /// generation, without adding it to the worklist.
+  void MarkChanged(Instruction *I) {
+    if (TrackGenerations)
+      ChangeGen[I] = Generation;
+  }
+
+  /// changedSince - Return true if I has been marked changed at or after
+  /// generation Gen.
+  bool changedSince(Instruction *I, unsigned Gen) const {
+    DenseMap<Instruction*, unsigned>::const_iterator It = ChangeGen.find(I);
+    return It != ChangeGen.end() && It->second >= Gen;
+  }
+
   /// Add - Add the specified instruction to the worklist if it isn't already
   /// in it.
   void Add(Instruction *I) {
+    MarkChanged(I);
     if (WorklistMap.insert(std::make_pair(I, Worklist.size())).second) {
       DEBUG(errs() << "IC: ADD: " << *I << '\n');
       Worklist.push_back(I);
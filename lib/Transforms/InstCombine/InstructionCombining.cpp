@@ -71,6 +71,19 @@ static cl::opt<bool> UnsafeFPShrink("enable-double-float-shrink", cl::Hidden,
                                    cl::desc("Enable unsafe double to float "
                                             "shrinking for math lib calls"));
 
+// After the first iteration the worklist is reseeded with every reachable
+// instruction, although most of them were just proven unsimplifiable and
+// nothing around them has changed. With this option instructions are only
+// revisited when they or one of their operands were touched in the previous
+// iteration. Changes still propagate one def-use level per iteration, but
+// folds that only become visible through deeper chains (e.g. known-bits
+// recursion) may be missed relative to a full re-scan.
+static cl::opt<bool>
+MemoizeIterations("instcombine-memoize-iterations", cl::Hidden,
+                  cl::init(false),
+                  cl::desc("Only revisit instructions that changed since the "
+                           "previous instcombine iteration"));
+
 // Initialization Routines
 void llvm::initializeInstCombine(PassRegistry &Registry) {
   initializeInstCombinerPass(Registry);
@@ -2189,7 +2202,8 @@ static bool AddReachableCodeToWorklist(BasicBlock *BB,
                                        SmallPtrSet<BasicBlock*, 64> &Visited,
                                        InstCombiner &IC,
                                        const DataLayout *TD,
-                                       const TargetLibraryInfo *TLI) {
+                                       const TargetLibraryInfo *TLI,
+                                       unsigned Iteration) {
   bool MadeIRChange = false;
   SmallVector<BasicBlock*, 256> Worklist;
   Worklist.push_back(BB);
@@ -2245,6 +2259,24 @@ static bool AddReachableCodeToWorklist(BasicBlock *BB,
         }
       }
 
+      // In memoized mode, an instruction that survived an earlier iteration
+      // unchanged was proven unsimplifiable then, and the proof still holds
+      // unless the instruction or one of its operands was touched in the
+      // previous iteration.
+      if (MemoizeIterations && Iteration != 0 &&
+          !IC.Worklist.changedSince(Inst, Iteration - 1)) {
+        bool OperandChanged = false;
+        for (User::op_iterator i = Inst->op_begin(), e = Inst->op_end();
+             i != e; ++i)
+          if (Instruction *OpI = dyn_cast<Instruction>(*i))
+            if (IC.Worklist.changedSince(OpI, Iteration - 1)) {
+              OperandChanged = true;
+              break;
+            }
+        if (!OperandChanged)
+          continue;
+      }
+
       InstrsForInstCombineWorklist.push_back(Inst);
     }
 
@@ -2296,13 +2328,16 @@ bool InstCombiner::DoOneIteration(Function &F, unsigned Iteration) {
   DEBUG(errs() << "\n\nINSTCOMBINE ITERATION #" << Iteration << " on "
                << F.getName() << "\n");
 
+  if (MemoizeIterations)
+    Worklist.beginGeneration(Iteration);
+
   {
     // Do a depth-first traversal of the function, populate the worklist with
     // the reachable instructions.  Ignore blocks that are not reachable.  Keep
     // track of which blocks we visit.
     SmallPtrSet<BasicBlock*, 64> Visited;
     MadeIRChange |= AddReachableCodeToWorklist(F.begin(), Visited, *this, TD,
-                                               TLI);
+                                               TLI, Iteration);
 
     // Do a quick scan over the function.  If we find any blocks that are
     // unreachable, remove any instructions inside of them.  This prevents
@@ -2317,8 +2352,14 @@ bool InstCombiner::DoOneIteration(Function &F, unsigned Iteration) {
         // Delete the next to last instruction.
         BasicBlock::iterator I = EndInst;
         Instruction *Inst = --I;
-        if (!Inst->use_empty())
+        if (!Inst->use_empty()) {
+          // The users keep their value but see a new (undef) operand; make
+          // sure the memoized reseeding revisits them next iteration.
+          for (Value::use_iterator UI = Inst->use_begin(),
+                 UE = Inst->use_end(); UI != UE; ++UI)
+            Worklist.MarkChanged(cast<Instruction>(*UI));
           Inst->replaceAllUsesWith(UndefValue::get(Inst->getType()));
+        }
         if (isa<LandingPadInst>(Inst)) {
           EndInst = Inst;
           continue;
@@ -2499,6 +2540,10 @@ bool InstCombiner::runOnFunction(Function &F) {
   while (DoOneIteration(F, Iteration++))
     EverMadeChange = true;
 
+  // Generation stamps refer to this function's instructions; drop them so
+  // they cannot alias recycled instruction memory in the next function.
+  Worklist.resetGenerations();
+
   Builder = 0;
   return EverMadeChange;
 }
@@ -19,6 +19,7 @@
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/CaptureTracking.h"
@@ -33,6 +34,7 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Target/TargetLibraryInfo.h"
 #include "llvm/Transforms/Utils/Local.h"
@@ -40,6 +42,20 @@ using namespace llvm;
 
 STATISTIC(NumFastStores, "Number of stores deleted");
 STATISTIC(NumFastOther , "Number of other instrs removed");
+STATISTIC(NumCrossBlockStores, "Number of cross-block stores deleted");
+
+static cl::opt<bool>
+EnableCrossBlockDSE("enable-cross-block-dse", cl::init(true), cl::Hidden,
+  cl::desc("Remove stores made dead by overwrites in later blocks"));
+
+// Pruning the dead-stack-object set costs one alias query per surviving
+// object for every call or load scanned, which goes quadratic on pathological
+// blocks.  Budget the queries and give up on the remaining candidates when
+// it runs out; stopping early is always safe, it just deletes fewer stores.
+static cl::opt<unsigned>
+EndBlockQueryBudget("dse-end-block-query-budget", cl::init(10000), cl::Hidden,
+  cl::desc("Maximum alias queries to spend pruning dead stack objects "
+           "per block (0 = no limit)"));
 
 namespace {
   struct DSE : public FunctionPass {
@@ -60,6 +76,10 @@ namespace {
       TLI = AA->getTargetLibraryInfo();
 
       bool Changed = false;
+      // DSE issues a long run of queries against IR that only changes when
+      // instructions are deleted (which deleteValue announces), so let the
+      // alias analysis memoize across them.
+      AliasAnalysis::QueryBatch Batch(*AA);
       for (Function::iterator I = F.begin(), E = F.end(); I != E; ++I)
         // Only check non-dead blocks.  Dead blocks may have strange pointer
         // cycles that will confuse alias analysis.
@@ -71,10 +91,13 @@ namespace {
     }
 
     bool runOnBasicBlock(BasicBlock &BB);
+    bool handleNonLocalStore(Instruction *Inst,
+                             const AliasAnalysis::Location &Loc);
     bool HandleFree(CallInst *F);
     bool handleEndBlock(BasicBlock &BB);
-    void RemoveAccessedObjects(const AliasAnalysis::Location &LoadedLoc,
-                               SmallSetVector<Value*, 16> &DeadStackObjects);
+    bool RemoveAccessedObjects(const AliasAnalysis::Location &LoadedLoc,
+                               SmallSetVector<Value*, 16> &DeadStackObjects,
+                               unsigned &QueryBudget);
 
     virtual void getAnalysisUsage(AnalysisUsage &AU) const {
       AU.setPreservesCFG();
@@ -109,6 +132,7 @@ FunctionPass *llvm::createDeadStoreEliminationPass() { return new DSE(); }
 ///
 static void DeleteDeadInstruction(Instruction *I,
                                   MemoryDependenceAnalysis &MD,
+                                  AliasAnalysis &AA,
                                   const TargetLibraryInfo *TLI,
                                   SmallSetVector<Value*, 16> *ValueSet = 0) {
   SmallVector<Instruction*, 32> NowDeadInsts;
@@ -123,8 +147,10 @@ static void DeleteDeadInstruction(Instruction *I,
 
     // This instruction is dead, zap it, in stages.  Start by removing it from
     // MemDep, which needs to know the operands and needs it to be in the
-    // function.
+    // function.  Tell the alias analysis too, so any memoized results keyed
+    // on this instruction are dropped.
     MD.removeInstruction(DeadInst);
+    AA.deleteValue(DeadInst);
 
     for (unsigned op = 0, e = DeadInst->getNumOperands(); op != e; ++op) {
       Value *Op = DeadInst->getOperand(op);
@@ -507,10 +533,18 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
 
     MemDepResult InstDep = MD->getDependency(Inst);
 
-    // Ignore any store where we can't find a local dependence.
-    // FIXME: cross-block DSE would be fun. :)
-    if (!InstDep.isDef() && !InstDep.isClobber())
+    // If there is no local dependence, nothing earlier in this block reads or
+    // writes the stored-to location, so 'Inst' kills the location all the way
+    // back to the block entry.  Chase the store backwards through any
+    // predecessors that unconditionally lead here.
+    if (!InstDep.isDef() && !InstDep.isClobber()) {
+      if (EnableCrossBlockDSE && InstDep.isNonLocal()) {
+        AliasAnalysis::Location Loc = getLocForWrite(Inst, *AA);
+        if (Loc.Ptr)
+          MadeChange |= handleNonLocalStore(Inst, Loc);
+      }
       continue;
+    }
 
     // If we're storing the same value back to a pointer that we just
     // loaded from, then the store can be removed.
@@ -525,7 +559,7 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
           // in case we need it.
           WeakVH NextInst(BBI);
 
-          DeleteDeadInstruction(SI, *MD, TLI);
+          DeleteDeadInstruction(SI, *MD, *AA, TLI);
 
           if (NextInst == 0)  // Next instruction deleted.
             BBI = BB.begin();
@@ -572,7 +606,7 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
                 << *DepWrite << "\n  KILLER: " << *Inst << '\n');
 
           // Delete the store and now-dead instructions that feed it.
-          DeleteDeadInstruction(DepWrite, *MD, TLI);
+          DeleteDeadInstruction(DepWrite, *MD, *AA, TLI);
           ++NumFastStores;
           MadeChange = true;
 
@@ -618,14 +652,25 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
       //   store -> P
       // we can remove the first store to P even though we don't know if P and Q
       // alias.
-      if (DepWrite == &BB.front()) break;
-
       // Can't look past this instruction if it might read 'Loc'.
       if (AA->getModRefInfo(DepWrite, Loc) & AliasAnalysis::Ref)
         break;
 
+      // If the skippable write is the first instruction of the block, the
+      // walk has legally searched past everything above 'Inst'; record that
+      // so it can continue through unconditional predecessors below.
+      if (DepWrite == &BB.front()) {
+        InstDep = MemDepResult::getNonLocal();
+        break;
+      }
+
       InstDep = MD->getPointerDependencyFrom(Loc, false, DepWrite, &BB);
     }
+
+    // If the walk searched past everything above 'Inst' without finding a
+    // read, continue it through unconditional predecessors.
+    if (EnableCrossBlockDSE && InstDep.isNonLocal())
+      MadeChange |= handleNonLocalStore(Inst, Loc);
   }
 
   // If this block ends in a return, unwind, or unreachable, all allocas are
@@ -652,6 +697,71 @@ static void FindUnconditionalPreds(SmallVectorImpl<BasicBlock *> &Blocks,
   }
 }
 
+/// handleNonLocalStore - 'Inst' writes to 'Loc' and has no dependence in its
+/// own block.  Every path through an unconditional predecessor reaches 'Inst'
+/// with nothing in between touching 'Loc', so stores to 'Loc' found by walking
+/// those predecessors are dead.  This is the chain of memory defs ending at
+/// 'Inst'; following it catches stores that field-by-field initialization
+/// spreads across several blocks, which the block-local walk never sees.
+bool DSE::handleNonLocalStore(Instruction *Inst,
+                              const AliasAnalysis::Location &Loc) {
+  bool MadeChange = false;
+
+  SmallVector<BasicBlock *, 16> Blocks;
+  SmallPtrSet<BasicBlock *, 16> Visited;
+  // Never rescan the killer's own block; in a loop the first dependency found
+  // there would be 'Inst' itself.
+  Visited.insert(Inst->getParent());
+  FindUnconditionalPreds(Blocks, Inst->getParent(), DT);
+
+  while (!Blocks.empty()) {
+    BasicBlock *BB = Blocks.pop_back_val();
+    if (!Visited.insert(BB))
+      continue;
+
+    MemDepResult Dep =
+      MD->getPointerDependencyFrom(Loc, false, BB->getTerminator(), BB);
+    while (Dep.isDef() || Dep.isClobber()) {
+      Instruction *DepWrite = Dep.getInst();
+      AliasAnalysis::Location DepLoc = getLocForWrite(DepWrite, *AA);
+      if (DepLoc.Ptr == 0)
+        break;
+
+      if (isRemovable(DepWrite) &&
+          !isPossibleSelfRead(Inst, Loc, DepWrite, *AA)) {
+        int64_t InstWriteOffset, DepWriteOffset;
+        if (isOverwrite(Loc, DepLoc, *AA, DepWriteOffset, InstWriteOffset) ==
+              OverwriteComplete) {
+          DEBUG(dbgs() << "DSE: Remove Non-Local Dead Store:\n  DEAD: "
+                       << *DepWrite << "\n  KILLER: " << *Inst << '\n');
+
+          Instruction *Next = llvm::next(BasicBlock::iterator(DepWrite));
+          DeleteDeadInstruction(DepWrite, *MD, *AA, TLI);
+          ++NumCrossBlockStores;
+          MadeChange = true;
+
+          // There may be another dead store above the one just deleted.
+          Dep = MD->getPointerDependencyFrom(Loc, false, Next, BB);
+          continue;
+        }
+      }
+
+      // As in the block-local walk, we can search past a may-aliased store as
+      // long as it cannot read the location.
+      if (AA->getModRefInfo(DepWrite, Loc) & AliasAnalysis::Ref)
+        break;
+
+      Dep = MD->getPointerDependencyFrom(Loc, false, DepWrite, BB);
+    }
+
+    // Nothing in this block touches the location either; keep walking up.
+    if (Dep.isNonLocal())
+      FindUnconditionalPreds(Blocks, BB, DT);
+  }
+
+  return MadeChange;
+}
+
 /// HandleFree - Handle frees of entire structures whose dependency is a store
 /// to a field of that structure.
 bool DSE::HandleFree(CallInst *F) {
@@ -682,7 +792,7 @@ bool DSE::HandleFree(CallInst *F) {
       Instruction *Next = llvm::next(BasicBlock::iterator(Dependency));
 
       // DCE instructions only used to calculate that store
-      DeleteDeadInstruction(Dependency, *MD, TLI);
+      DeleteDeadInstruction(Dependency, *MD, *AA, TLI);
       ++NumFastStores;
       MadeChange = true;
 
@@ -750,6 +860,7 @@ bool DSE::handleEndBlock(BasicBlock &BB) {
       DeadStackObjects.insert(AI);
 
   // Scan the basic block backwards
+  unsigned QueryBudget = EndBlockQueryBudget;
   for (BasicBlock::iterator BBI = BB.end(); BBI != BB.begin(); ){
     --BBI;
 
@@ -782,7 +893,7 @@ bool DSE::handleEndBlock(BasicBlock &BB) {
               dbgs() << '\n');
 
         // DCE instructions only used to calculate that store.
-        DeleteDeadInstruction(Dead, *MD, TLI, &DeadStackObjects);
+        DeleteDeadInstruction(Dead, *MD, *AA, TLI, &DeadStackObjects);
         ++NumFastStores;
         MadeChange = true;
         continue;
@@ -792,7 +903,7 @@ bool DSE::handleEndBlock(BasicBlock &BB) {
     // Remove any dead non-memory-mutating instructions.
     if (isInstructionTriviallyDead(BBI, TLI)) {
       Instruction *Inst = BBI++;
-      DeleteDeadInstruction(Inst, *MD, TLI, &DeadStackObjects);
+      DeleteDeadInstruction(Inst, *MD, *AA, TLI, &DeadStackObjects);
       ++NumFastOther;
       MadeChange = true;
       continue;
@@ -817,7 +928,13 @@ bool DSE::handleEndBlock(BasicBlock &BB) {
         continue;
 
       // If the call might load from any of our allocas, then any store above
-      // the call is live.
+      // the call is live.  This prunes with one mod/ref query per surviving
+      // object; stop scanning if that would exhaust the query budget.
+      if (EndBlockQueryBudget) {
+        if (QueryBudget < DeadStackObjects.size())
+          break;
+        QueryBudget -= DeadStackObjects.size();
+      }
       CouldRef Pred = { CS, AA };
       DeadStackObjects.remove_if(Pred);
 
@@ -850,8 +967,10 @@ bool DSE::handleEndBlock(BasicBlock &BB) {
     }
 
     // Remove any allocas from the DeadPointer set that are loaded, as this
-    // makes any stores above the access live.
-    RemoveAccessedObjects(LoadedLoc, DeadStackObjects);
+    // makes any stores above the access live.  Stop scanning if doing so
+    // would exhaust the query budget.
+    if (!RemoveAccessedObjects(LoadedLoc, DeadStackObjects, QueryBudget))
+      break;
 
     // If all of the allocas were clobbered by the access then we're not going
     // to find anything else to process.
@@ -878,23 +997,34 @@ namespace {
 
 /// RemoveAccessedObjects - Check to see if the specified location may alias any
 /// of the stack objects in the DeadStackObjects set.  If so, they become live
-/// because the location is being loaded.
-void DSE::RemoveAccessedObjects(const AliasAnalysis::Location &LoadedLoc,
-                                SmallSetVector<Value*, 16> &DeadStackObjects) {
+/// because the location is being loaded.  Returns false if the alias queries
+/// this needs would exhaust \p QueryBudget, in which case the caller should
+/// give up on the remaining candidates.
+bool DSE::RemoveAccessedObjects(const AliasAnalysis::Location &LoadedLoc,
+                                SmallSetVector<Value*, 16> &DeadStackObjects,
+                                unsigned &QueryBudget) {
   const Value *UnderlyingPointer = GetUnderlyingObject(LoadedLoc.Ptr);
 
   // A constant can't be in the dead pointer set.
   if (isa<Constant>(UnderlyingPointer))
-    return;
+    return true;
 
   // If the kill pointer can be easily reduced to an alloca, don't bother doing
   // extraneous AA queries.
   if (isa<AllocaInst>(UnderlyingPointer) || isa<Argument>(UnderlyingPointer)) {
     DeadStackObjects.remove(const_cast<Value*>(UnderlyingPointer));
-    return;
+    return true;
+  }
+
+  // Pruning costs one alias query per surviving object.
+  if (EndBlockQueryBudget) {
+    if (QueryBudget < DeadStackObjects.size())
+      return false;
+    QueryBudget -= DeadStackObjects.size();
   }
 
   // Remove objects that could alias LoadedLoc.
   CouldAlias Pred = { LoadedLoc, AA };
   DeadStackObjects.remove_if(Pred);
+  return true;
 }
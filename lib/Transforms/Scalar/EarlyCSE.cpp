@@ -39,6 +39,9 @@ static unsigned getHash(const void *V) {
   return DenseMapInfo<const void*>::getHashValue(V);
 }
 
+static unsigned getSimpleValueHash(Instruction *Inst);
+static unsigned getCallValueHash(Instruction *Inst);
+
 //===----------------------------------------------------------------------===//
 // SimpleValue
 //===----------------------------------------------------------------------===//
@@ -49,8 +52,16 @@ namespace {
   struct SimpleValue {
     Instruction *Inst;
 
-    SimpleValue(Instruction *I) : Inst(I) {
+    /// Hash - The hash of Inst, computed once at construction.  Keys are
+    /// built from instructions that are not mutated while they are live, so
+    /// caching the hash here makes the lookup/insert pair for each
+    /// instruction (and any table growth) hash it only once.
+    unsigned Hash;
+
+    SimpleValue(Instruction *I) : Inst(I), Hash(0) {
       assert((isSentinel() || canHandle(I)) && "Inst can't be handled!");
+      if (!isSentinel())
+        Hash = getSimpleValueHash(I);
     }
 
     bool isSentinel() const {
@@ -90,7 +101,10 @@ template<> struct DenseMapInfo<SimpleValue> {
 }
 
 unsigned DenseMapInfo<SimpleValue>::getHashValue(SimpleValue Val) {
-  Instruction *Inst = Val.Inst;
+  return Val.Hash;
+}
+
+static unsigned getSimpleValueHash(Instruction *Inst) {
   // Hash in all of the operands as pointers.
   if (BinaryOperator* BinOp = dyn_cast<BinaryOperator>(Inst)) {
     Value *LHS = BinOp->getOperand(0);
@@ -197,8 +211,14 @@ namespace {
   struct CallValue {
     Instruction *Inst;
 
-    CallValue(Instruction *I) : Inst(I) {
+    /// Hash - The hash of Inst, computed once at construction (see
+    /// SimpleValue::Hash).
+    unsigned Hash;
+
+    CallValue(Instruction *I) : Inst(I), Hash(0) {
       assert((isSentinel() || canHandle(I)) && "Inst can't be handled!");
+      if (!isSentinel())
+        Hash = getCallValueHash(I);
     }
 
     bool isSentinel() const {
@@ -237,7 +257,10 @@ namespace llvm {
   };
 }
 unsigned DenseMapInfo<CallValue>::getHashValue(CallValue Val) {
-  Instruction *Inst = Val.Inst;
+  return Val.Hash;
+}
+
+static unsigned getCallValueHash(Instruction *Inst) {
   // Hash in all of the operands as pointers.
   unsigned Res = 0;
   for (unsigned i = 0, e = Inst->getNumOperands(); i != e; ++i) {
@@ -453,8 +476,12 @@ bool EarlyCSE::processNode(DomTreeNode *Node) {
 
     // If this is a simple instruction that we can value number, process it.
     if (SimpleValue::canHandle(Inst)) {
+      // Build the key once so that the lookup and the insert below share one
+      // hash computation.
+      SimpleValue SV(Inst);
+
       // See if the instruction has an available value.  If so, use it.
-      if (Value *V = AvailableValues->lookup(Inst)) {
+      if (Value *V = AvailableValues->lookup(SV)) {
         DEBUG(dbgs() << "EarlyCSE CSE: " << *Inst << "  to: " << *V << '\n');
         Inst->replaceAllUsesWith(V);
         Inst->eraseFromParent();
@@ -464,7 +491,7 @@ bool EarlyCSE::processNode(DomTreeNode *Node) {
       }
 
       // Otherwise, just remember that this value is available.
-      AvailableValues->insert(Inst, Inst);
+      AvailableValues->insert(SV, Inst);
       continue;
     }
 
@@ -503,9 +530,13 @@ bool EarlyCSE::processNode(DomTreeNode *Node) {
 
     // If this is a read-only call, process it.
     if (CallValue::canHandle(Inst)) {
+      // Build the key once so that the lookup and the insert below share one
+      // hash computation.
+      CallValue CV(Inst);
+
       // If we have an available version of this call, and if it is the right
       // generation, replace this instruction.
-      std::pair<Value*, unsigned> InVal = AvailableCalls->lookup(Inst);
+      std::pair<Value*, unsigned> InVal = AvailableCalls->lookup(CV);
       if (InVal.first != 0 && InVal.second == CurrentGeneration) {
         DEBUG(dbgs() << "EarlyCSE CSE CALL: " << *Inst << "  to: "
                      << *InVal.first << '\n');
@@ -517,7 +548,7 @@ bool EarlyCSE::processNode(DomTreeNode *Node) {
       }
 
       // Otherwise, remember that we have this instruction.
-      AvailableCalls->insert(Inst,
+      AvailableCalls->insert(CV,
                          std::pair<Value*, unsigned>(Inst, CurrentGeneration));
       continue;
     }
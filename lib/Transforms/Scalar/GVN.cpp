@@ -65,6 +65,15 @@ static cl::opt<uint32_t>
 MaxRecurseDepth("max-recurse-depth", cl::Hidden, cl::init(1000), cl::ZeroOrMore,
                 cl::desc("Max recurse depth (default = 1000)"));
 
+// Iteration budget for the main GVN loop and the PRE loop.  Each iteration
+// walks the whole function, so on huge single-function inputs the fixpoint
+// can cost far more than the redundancy it removes; the budget trades the
+// tail of that fixpoint for bounded compile time.
+static cl::opt<uint32_t>
+MaxIterations("gvn-max-iterations", cl::Hidden, cl::init(0), cl::ZeroOrMore,
+              cl::desc("Max GVN and PRE iterations per function "
+                       "(default = 0, no limit)"));
+
 //===----------------------------------------------------------------------===//
 //                         ValueTable Class
 //===----------------------------------------------------------------------===//
@@ -560,8 +569,10 @@ namespace {
     /// removeFromLeaderTable - Scan the list of values corresponding to a given
     /// value number, and remove the given instruction if encountered.
     void removeFromLeaderTable(uint32_t N, Instruction *I, BasicBlock *BB) {
+      DenseMap<uint32_t, LeaderTableEntry>::iterator LI = LeaderTable.find(N);
+      assert(LI != LeaderTable.end() && "Removing value not in leader table!");
       LeaderTableEntry* Prev = 0;
-      LeaderTableEntry* Curr = &LeaderTable[N];
+      LeaderTableEntry* Curr = &LI->second;
 
       while (Curr->Val != I || Curr->BB != BB) {
         Prev = Curr;
@@ -1681,6 +1692,7 @@ bool GVN::processNonLocalLoad(LoadInst *LI) {
     while (!NewInsts.empty()) {
       Instruction *I = NewInsts.pop_back_val();
       if (MD) MD->removeInstruction(I);
+      getAliasAnalysis()->deleteValue(I);
       I->eraseFromParent();
     }
     return false;
@@ -1981,7 +1993,12 @@ bool GVN::processLoad(LoadInst *L) {
 // question.  This is fast because dominator tree queries consist of only
 // a few comparisons of DFS numbers.
 Value *GVN::findLeader(const BasicBlock *BB, uint32_t num) {
-  LeaderTableEntry Vals = LeaderTable[num];
+  // Use find() rather than operator[]: most queried numbers have no leader,
+  // and inserting an empty entry for every miss bloats the table on large
+  // functions.
+  DenseMap<uint32_t, LeaderTableEntry>::iterator I = LeaderTable.find(num);
+  if (I == LeaderTable.end()) return 0;
+  LeaderTableEntry Vals = I->second;
   if (!Vals.Val) return 0;
 
   Value *Val = 0;
@@ -2316,6 +2333,12 @@ bool GVN::runOnFunction(Function& F) {
     Changed |= removedBlock;
   }
 
+  // From here on the IR only changes through deletions and replacements by
+  // equivalent values, all of which are announced to the alias analysis, so
+  // its results can be memoized for the duration.  The block merging above
+  // is not announced, which is why the batch only starts here.
+  VN.getAliasAnalysis()->beginQueryBatch();
+
   unsigned Iteration = 0;
   while (ShouldContinue) {
     DEBUG(dbgs() << "GVN iteration: " << Iteration << "\n");
@@ -2324,13 +2347,25 @@ bool GVN::runOnFunction(Function& F) {
       ShouldContinue = true;
     Changed |= ShouldContinue;
     ++Iteration;
+    if (MaxIterations && Iteration >= MaxIterations)
+      break;
+    // Every iteration leaves the function in a consistent state, so the
+    // -pass-budget bail-out point is between iterations.
+    if (PassBudgetExceeded())
+      break;
   }
 
   if (EnablePRE) {
+    unsigned PREIteration = 0;
     bool PREChanged = true;
     while (PREChanged) {
       PREChanged = performPRE(F);
       Changed |= PREChanged;
+      ++PREIteration;
+      if (MaxIterations && PREIteration >= MaxIterations)
+        break;
+      if (PassBudgetExceeded())
+        break;
     }
   }
   // FIXME: Should perform GVN again after PRE does something.  PRE can move
@@ -2338,6 +2373,8 @@ bool GVN::runOnFunction(Function& F) {
   // we can't do this until PRE's critical edge splitting updates memdep.
   // Actually, when this happens, we should just fully integrate PRE into GVN.
 
+  VN.getAliasAnalysis()->endQueryBatch();
+
   cleanupGlobalSets();
 
   return Changed;
@@ -2371,6 +2408,7 @@ bool GVN::processBlock(BasicBlock *BB) {
          E = InstrsToErase.end(); I != E; ++I) {
       DEBUG(dbgs() << "GVN removed: " << **I << '\n');
       if (MD) MD->removeInstruction(*I);
+      getAliasAnalysis()->deleteValue(*I);
       (*I)->eraseFromParent();
       DEBUG(verifyRemoved(*I));
     }
@@ -2551,6 +2589,7 @@ bool GVN::performPRE(Function &F) {
 
       DEBUG(dbgs() << "GVN PRE removed: " << *CurInst << '\n');
       if (MD) MD->removeInstruction(CurInst);
+      getAliasAnalysis()->deleteValue(CurInst);
       CurInst->eraseFromParent();
       DEBUG(verifyRemoved(CurInst));
       Changed = true;
@@ -20,6 +20,7 @@
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/ConstantFolding.h"
+#include "llvm/Analysis/Dominators.h"
 #include "llvm/Analysis/InstructionSimplify.h"
 #include "llvm/Analysis/LazyValueInfo.h"
 #include "llvm/Analysis/Loads.h"
@@ -610,10 +611,10 @@ static unsigned GetBestDestForJumpOnUndef(BasicBlock *BB) {
   unsigned MinSucc = 0;
   BasicBlock *TestBB = BBTerm->getSuccessor(MinSucc);
   // Compute the successor with the minimum number of predecessors.
-  unsigned MinNumPreds = std::distance(pred_begin(TestBB), pred_end(TestBB));
+  unsigned MinNumPreds = TestBB->getNumPredecessors();
   for (unsigned i = 1, e = BBTerm->getNumSuccessors(); i != e; ++i) {
     TestBB = BBTerm->getSuccessor(i);
-    unsigned NumPreds = std::distance(pred_begin(TestBB), pred_end(TestBB));
+    unsigned NumPreds = TestBB->getNumPredecessors();
     if (NumPreds < MinNumPreds) {
       MinSucc = i;
       MinNumPreds = NumPreds;
@@ -657,7 +658,7 @@ bool JumpThreading::ProcessBlock(BasicBlock *BB) {
       // will need to move BB back to the entry position.
       bool isEntry = SinglePred == &SinglePred->getParent()->getEntryBlock();
       LVI->eraseBlock(SinglePred);
-      MergeBasicBlockIntoOnlyPred(BB);
+      MergeBasicBlockIntoOnlyPred(BB, this);
 
       if (isEntry && BB != &BB->getParent()->getEntryBlock())
         BB->moveBefore(&BB->getParent()->getEntryBlock());
@@ -1461,6 +1462,14 @@ bool JumpThreading::ThreadEdge(BasicBlock *BB,
       PredTerm->setSuccessor(i, NewBB);
     }
 
+  // If a dominator tree is still alive, patch it instead of leaving it to be
+  // recomputed from scratch.  NewBB's only predecessor is PredBB.
+  if (DominatorTree *DT = getAnalysisIfAvailable<DominatorTree>()) {
+    DT->addNewBlock(NewBB, PredBB);
+    DT->insertEdge(NewBB, SuccBB);
+    DT->deleteEdge(PredBB, BB);
+  }
+
   // At this point, the IR is fully up to date and consistent.  Do a quick scan
   // over the new instructions and zap any that are constants or dead.  This
   // frequently happens because of phi translation.
@@ -1611,6 +1620,15 @@ bool JumpThreading::DuplicateCondBranchOnPHIIntoPred(BasicBlock *BB,
   // Remove the unconditional branch at the end of the PredBB block.
   OldPredBranch->eraseFromParent();
 
+  // Keep an available dominator tree in sync with the rewired edges: PredBB
+  // now branches directly to BB's successors instead of to BB.
+  if (DominatorTree *DT = getAnalysisIfAvailable<DominatorTree>()) {
+    TerminatorInst *PredTerm = PredBB->getTerminator();
+    for (unsigned i = 0, e = PredTerm->getNumSuccessors(); i != e; ++i)
+      DT->insertEdge(PredBB, PredTerm->getSuccessor(i));
+    DT->deleteEdge(PredBB, BB);
+  }
+
   ++NumDupes;
   return true;
 }
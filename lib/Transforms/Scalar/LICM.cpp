@@ -70,7 +70,7 @@ DisablePromotion("disable-licm-promotion", cl::Hidden,
 namespace {
   struct LICM : public LoopPass {
     static char ID; // Pass identification, replacement for typeid
-    LICM() : LoopPass(ID) {
+    LICM() : LoopPass(ID), SinkSSA(&SinkNewPHIs) {
       initializeLICMPass(*PassRegistry::getPassRegistry());
     }
 
@@ -114,6 +114,26 @@ namespace {
     bool MayThrow;           // The current loop contains an instruction which
                              // may throw, thus preventing code motion of
                              // instructions with side effects.
+
+    // The unique exit blocks of CurLoop, gathered once per loop so sink()
+    // does not recompute them for every sunk instruction, and the SSAUpdater
+    // (with its PHI scratch vector) reused across all of them.
+    SmallVector<BasicBlock*, 8> LoopExitBlocks;
+    SmallVector<PHINode*, 8> SinkNewPHIs;
+    SSAUpdater SinkSSA;
+
+    // True if any alias set of CurLoop may be modified within the loop.
+    // Neither sinking nor hoisting changes what the tracker would report (an
+    // alias set's access bits are never downgraded), so one scan per loop in
+    // runOnLoop replaces a scan per read-only call in canSinkOrHoistInst.
+    bool LoopMayWriteMemory;
+
+    // The exit blocks of CurLoop and, per block, whether it dominates all of
+    // them.  Code motion never changes the CFG, so both are computed at most
+    // once per loop instead of once per isGuaranteedToExecute query.
+    SmallVector<BasicBlock*, 8> GuaranteeExitBlocks;
+    DenseMap<BasicBlock*, bool> GuaranteeCache;
+
     DenseMap<Loop*, AliasSetTracker*> LoopToAliasSetMap;
 
     /// cloneBasicBlockAnalysis - Simple Analysis hook. Clone alias set info.
@@ -255,6 +275,21 @@ bool LICM::runOnLoop(Loop *L, LPPassManager &LPM) {
          (I != E) && !MayThrow; ++I)
       MayThrow |= I->mayThrow();
 
+  // Preflight the alias sets once: code motion never upgrades an alias set
+  // to modified, so read-only calls can consult this summary rather than
+  // rescanning the tracker.
+  LoopMayWriteMemory = false;
+  for (AliasSetTracker::iterator I = CurAST->begin(), E = CurAST->end();
+       I != E; ++I)
+    if (!I->isForwardingAliasSet() && I->isMod()) {
+      LoopMayWriteMemory = true;
+      break;
+    }
+
+  // Likewise gather the exit blocks used by isGuaranteedToExecute up front;
+  // neither sinking nor hoisting changes the CFG.
+  CurLoop->getExitBlocks(GuaranteeExitBlocks);
+
   // We want to visit all of the instructions in this loop... that are not parts
   // of our subloops (they have already had their invariants hoisted out of
   // their loop, into this loop, so there is no need to process the BODIES of
@@ -265,8 +300,13 @@ bool LICM::runOnLoop(Loop *L, LPPassManager &LPM) {
   // us to sink instructions in one pass, without iteration.  After sinking
   // instructions, we perform another pass to hoist them out of the loop.
   //
-  if (L->hasDedicatedExits())
+  if (L->hasDedicatedExits()) {
+    // Gather the loop's unique exit blocks once; sinking does not change the
+    // CFG, so every instruction sunk out of this loop shares the list.
+    CurLoop->getUniqueExitBlocks(LoopExitBlocks);
     SinkRegion(DT->getNode(L->getHeader()));
+    LoopExitBlocks.clear();
+  }
   if (Preheader)
     HoistRegion(DT->getNode(L->getHeader()));
 
@@ -285,6 +325,8 @@ bool LICM::runOnLoop(Loop *L, LPPassManager &LPM) {
   // Clear out loops state information for the next iteration
   CurLoop = 0;
   Preheader = 0;
+  GuaranteeExitBlocks.clear();
+  GuaranteeCache.clear();
 
   // If this loop is nested inside of another one, save the alias information
   // for when we process the outer loop.
@@ -420,17 +462,9 @@ bool LICM::canSinkOrHoistInst(Instruction &I) {
       return true;
     if (AliasAnalysis::onlyReadsMemory(Behavior)) {
       // If this call only reads from memory and there are no writes to memory
-      // in the loop, we can hoist or sink the call as appropriate.
-      bool FoundMod = false;
-      for (AliasSetTracker::iterator I = CurAST->begin(), E = CurAST->end();
-           I != E; ++I) {
-        AliasSet &AS = *I;
-        if (!AS.isForwardingAliasSet() && AS.isMod()) {
-          FoundMod = true;
-          break;
-        }
-      }
-      if (!FoundMod) return true;
+      // in the loop, we can hoist or sink the call as appropriate.  The
+      // summary was computed once in runOnLoop.
+      if (!LoopMayWriteMemory) return true;
     }
 
     // FIXME: This should use mod/ref information to see if we can hoist or
@@ -479,8 +513,8 @@ bool LICM::isNotUsedInLoop(Instruction &I) {
 void LICM::sink(Instruction &I) {
   DEBUG(dbgs() << "LICM sinking instruction: " << I << "\n");
 
-  SmallVector<BasicBlock*, 8> ExitBlocks;
-  CurLoop->getUniqueExitBlocks(ExitBlocks);
+  // The loop's exit blocks were gathered once in runOnLoop.
+  SmallVectorImpl<BasicBlock*> &ExitBlocks = LoopExitBlocks;
 
   if (isa<LoadInst>(I)) ++NumMovedLoads;
   else if (isa<CallInst>(I)) ++NumMovedCalls;
@@ -526,9 +560,12 @@ void LICM::sink(Instruction &I) {
   }
 
   // Otherwise, if we have multiple exits, use the SSAUpdater to do all of the
-  // hard work of inserting PHI nodes as necessary.
-  SmallVector<PHINode*, 8> NewPHIs;
-  SSAUpdater SSA(&NewPHIs);
+  // hard work of inserting PHI nodes as necessary.  The updater and its PHI
+  // scratch vector are reused for every instruction sunk out of the loop;
+  // Initialize just clears the old state without freeing its buffers.
+  SinkNewPHIs.clear();
+  SmallVectorImpl<PHINode*> &NewPHIs = SinkNewPHIs;
+  SSAUpdater &SSA = SinkSSA;
 
   if (!I.use_empty())
     SSA.Initialize(I.getType(), I.getName());
@@ -636,24 +673,27 @@ bool LICM::isGuaranteedToExecute(Instruction &Inst) {
   // If the instruction is in the header block for the loop (which is very
   // common), it is always guaranteed to dominate the exit blocks.  Since this
   // is a common case, and can save some work, check it now.
-  if (Inst.getParent() == CurLoop->getHeader())
+  BasicBlock *BB = Inst.getParent();
+  if (BB == CurLoop->getHeader())
     return true;
 
-  // Get the exit blocks for the current loop.
-  SmallVector<BasicBlock*, 8> ExitBlocks;
-  CurLoop->getExitBlocks(ExitBlocks);
-
-  // Verify that the block dominates each of the exit blocks of the loop.
-  for (unsigned i = 0, e = ExitBlocks.size(); i != e; ++i)
-    if (!DT->dominates(Inst.getParent(), ExitBlocks[i]))
-      return false;
-
-  // As a degenerate case, if the loop is statically infinite then we haven't
-  // proven anything since there are no exit blocks.
-  if (ExitBlocks.empty())
-    return false;
-
-  return true;
+  // The answer only depends on the block, so cache it per loop.
+  DenseMap<BasicBlock*, bool>::iterator Cached = GuaranteeCache.find(BB);
+  if (Cached != GuaranteeCache.end())
+    return Cached->second;
+
+  // Verify that the block dominates each of the exit blocks of the loop,
+  // which were gathered once in runOnLoop.  As a degenerate case, if the
+  // loop is statically infinite then we haven't proven anything since there
+  // are no exit blocks.
+  bool Guaranteed = !GuaranteeExitBlocks.empty();
+  for (unsigned i = 0, e = GuaranteeExitBlocks.size();
+       Guaranteed && i != e; ++i)
+    if (!DT->dominates(BB, GuaranteeExitBlocks[i]))
+      Guaranteed = false;
+
+  GuaranteeCache[BB] = Guaranteed;
+  return Guaranteed;
 }
 
 namespace {
@@ -0,0 +1,249 @@
+//===- LoadWidening.cpp - Merge adjacent narrow loads ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass merges pairs of adjacent narrow integer loads into a single wider
+// load plus shift/truncate sequences.  Packed structures are commonly read
+// field by field as i8/i16 loads that neither GVN nor MemCpyOpt combines
+// because no individual load is redundant.  Two loads may be merged when they
+// read adjacent bytes off the same base pointer, nothing between them writes
+// memory, the widened access provably stays inside the underlying object
+// (immediate for an exact union of the two ranges, otherwise shown from the
+// allocation size computed by MemoryBuiltins), and the target's TTI reports
+// the wide integer type as legal.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "load-widening"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/MemoryBuiltins.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetLibraryInfo.h"
+using namespace llvm;
+
+STATISTIC(NumWidened, "Number of adjacent load pairs widened");
+
+/// MaxCandidates - Loads tracked per block between memory writes.  Keeps the
+/// partner search linear in practice; packed-struct reads cluster tightly.
+static const unsigned MaxCandidates = 16;
+
+namespace {
+  /// CandidateLoad - A simple integer load decomposed into a base pointer and
+  /// a constant byte offset from it.
+  struct CandidateLoad {
+    LoadInst *Load;
+    Value *Base;
+    int64_t Offset;
+    uint64_t Size;      // Access size in bytes.
+  };
+
+  class LoadWidening : public FunctionPass {
+    const DataLayout *TD;
+    const TargetTransformInfo *TTI;
+    const TargetLibraryInfo *TLI;
+  public:
+    static char ID; // Pass identification, replacement for typeid
+    LoadWidening() : FunctionPass(ID), TD(0), TTI(0), TLI(0) {
+      initializeLoadWideningPass(*PassRegistry::getPassRegistry());
+    }
+
+    virtual bool runOnFunction(Function &F);
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.setPreservesCFG();
+      AU.addRequired<TargetTransformInfo>();
+      AU.addRequired<TargetLibraryInfo>();
+    }
+
+  private:
+    bool processBlock(BasicBlock &BB);
+    bool tryToWiden(const CandidateLoad &A, const CandidateLoad &B);
+    bool isSafeWideAccess(const CandidateLoad &Lo, uint64_t WideBytes,
+                          uint64_t PairBytes);
+  };
+}
+
+char LoadWidening::ID = 0;
+INITIALIZE_PASS_BEGIN(LoadWidening, "load-widening",
+                      "Widen adjacent narrow loads", false, false)
+INITIALIZE_AG_DEPENDENCY(TargetTransformInfo)
+INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfo)
+INITIALIZE_PASS_END(LoadWidening, "load-widening",
+                    "Widen adjacent narrow loads", false, false)
+
+FunctionPass *llvm::createLoadWideningPass() { return new LoadWidening(); }
+
+/// isSafeWideAccess - Return true if loading WideBytes starting at Lo's
+/// address cannot read outside the underlying object.  When the wide access
+/// covers exactly the union of the two original accesses this is immediate;
+/// when the union was rounded up to a power of two the tail bytes must be
+/// shown in bounds from the object's allocation size.
+bool LoadWidening::isSafeWideAccess(const CandidateLoad &Lo,
+                                    uint64_t WideBytes, uint64_t PairBytes) {
+  if (WideBytes == PairBytes)
+    return true;
+
+  uint64_t ObjectSize;
+  if (!getObjectSize(Lo.Base, ObjectSize, TD, TLI))
+    return false;
+  return Lo.Offset >= 0 &&
+         (uint64_t)Lo.Offset + WideBytes <= ObjectSize;
+}
+
+/// tryToWiden - A and B load adjacent bytes with no intervening write; merge
+/// them into one wide load if the widened access is safe and the target likes
+/// the wide type.  Returns true if the transformation was performed.
+bool LoadWidening::tryToWiden(const CandidateLoad &A, const CandidateLoad &B) {
+  const CandidateLoad &Lo = A.Offset < B.Offset ? A : B;
+  const CandidateLoad &Hi = A.Offset < B.Offset ? B : A;
+
+  uint64_t PairBytes = Lo.Size + Hi.Size;
+  uint64_t WideBytes = NextPowerOf2(PairBytes - 1);
+  if (WideBytes > 8)   // Never grow past an i64.
+    return false;
+
+  if (!isSafeWideAccess(Lo, WideBytes, PairBytes))
+    return false;
+
+  LLVMContext &Ctx = Lo.Load->getContext();
+  IntegerType *WideTy = IntegerType::get(Ctx, WideBytes * 8);
+  if (!TTI->isTypeLegal(WideTy))
+    return false;
+
+  // The wide load replaces the earlier of the two loads; the later one's
+  // bytes were proven unmodified since that point.
+  LoadInst *First = A.Load;  // A was seen before B in the block scan.
+  IRBuilder<> Builder(First);
+
+  // Rebase onto the earlier load's pointer, which dominates the insertion
+  // point, and step to the low end of the union.
+  int64_t FirstOff = First == Lo.Load ? Lo.Offset : Hi.Offset;
+  int64_t Delta = Lo.Offset - FirstOff;
+  unsigned AS = First->getPointerAddressSpace();
+  Value *Ptr = First->getPointerOperand();
+  if (Delta != 0) {
+    Ptr = Builder.CreateBitCast(Ptr, Type::getInt8PtrTy(Ctx, AS));
+    Ptr = Builder.CreateGEP(Ptr, ConstantInt::getSigned(Type::getInt64Ty(Ctx),
+                                                        Delta));
+  }
+  Ptr = Builder.CreateBitCast(Ptr, WideTy->getPointerTo(AS), "widened.ptr");
+
+  // The wide load starts at Lo's address, so Lo's alignment carries over.
+  unsigned Align = Lo.Load->getAlignment();
+  if (Align == 0)
+    Align = TD->getABITypeAlignment(Lo.Load->getType());
+  LoadInst *Wide = Builder.CreateLoad(Ptr, "widened.load");
+  Wide->setAlignment(Align);
+
+  // Extract each original value.  On a little-endian target the load at byte
+  // offset N from the union's base holds bits [8N, 8N+size); big-endian
+  // counts from the top instead.
+  uint64_t WideBits = WideBytes * 8;
+  const CandidateLoad *Parts[2] = { &Lo, &Hi };
+  for (unsigned i = 0; i != 2; ++i) {
+    const CandidateLoad &Part = *Parts[i];
+    uint64_t ByteOff = Part.Offset - Lo.Offset;
+    uint64_t Shift = TD->isLittleEndian()
+                         ? ByteOff * 8
+                         : WideBits - ByteOff * 8 - Part.Size * 8;
+    Value *V = Wide;
+    if (Shift)
+      V = Builder.CreateLShr(V, Shift);
+    V = Builder.CreateTrunc(V, Part.Load->getType());
+    V->takeName(Part.Load);
+    Part.Load->replaceAllUsesWith(V);
+  }
+
+  DEBUG(dbgs() << "LoadWidening: merged " << *Lo.Load << " and " << *Hi.Load
+               << " into " << *Wide << '\n');
+
+  Lo.Load->eraseFromParent();
+  Hi.Load->eraseFromParent();
+  ++NumWidened;
+  return true;
+}
+
+bool LoadWidening::processBlock(BasicBlock &BB) {
+  bool Changed = false;
+  SmallVector<CandidateLoad, MaxCandidates> Candidates;
+
+  for (BasicBlock::iterator I = BB.begin(), E = BB.end(); I != E; ) {
+    Instruction *Inst = I++;
+
+    // A write invalidates everything seen so far; an instruction that may
+    // throw does too, since the widened load would otherwise read the later
+    // load's bytes on a path where it never executed.
+    if (Inst->mayWriteToMemory() || Inst->mayThrow()) {
+      Candidates.clear();
+      continue;
+    }
+
+    LoadInst *LI = dyn_cast<LoadInst>(Inst);
+    if (!LI || !LI->isSimple() || !LI->getType()->isIntegerTy())
+      continue;
+
+    uint64_t Bits = LI->getType()->getPrimitiveSizeInBits();
+    if (Bits != 8 && Bits != 16 && Bits != 32)
+      continue;
+
+    CandidateLoad C;
+    C.Load = LI;
+    C.Offset = 0;
+    C.Base = GetPointerBaseWithConstantOffset(LI->getPointerOperand(),
+                                              C.Offset, TD);
+    C.Size = Bits / 8;
+
+    // Look for a partner whose access ends where this one starts or starts
+    // where this one ends.
+    bool Merged = false;
+    for (unsigned i = 0, e = Candidates.size(); i != e; ++i) {
+      const CandidateLoad &P = Candidates[i];
+      if (P.Base != C.Base ||
+          P.Load->getPointerAddressSpace() != LI->getPointerAddressSpace())
+        continue;
+      if (P.Offset + (int64_t)P.Size != C.Offset &&
+          C.Offset + (int64_t)C.Size != P.Offset)
+        continue;
+      if (tryToWiden(P, C)) {
+        Candidates.erase(Candidates.begin() + i);
+        Changed = Merged = true;
+        break;
+      }
+    }
+    if (Merged)
+      continue;
+
+    if (Candidates.size() == MaxCandidates)
+      Candidates.erase(Candidates.begin());
+    Candidates.push_back(C);
+  }
+  return Changed;
+}
+
+bool LoadWidening::runOnFunction(Function &F) {
+  TD = getAnalysisIfAvailable<DataLayout>();
+  if (!TD)
+    return false;   // Without a DataLayout we know neither sizes nor byte order.
+  TTI = &getAnalysis<TargetTransformInfo>();
+  TLI = &getAnalysis<TargetLibraryInfo>();
+
+  bool Changed = false;
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
+    Changed |= processBlock(*BB);
+  return Changed;
+}
@@ -0,0 +1,176 @@
+//===- LoopDataPrefetch.cpp - Loop Data Prefetching Pass ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass inserts llvm.prefetch intrinsics ahead of strided loads in
+// innermost loops.  Strides are recognized with ScalarEvolution: a load whose
+// pointer is an affine SCEVAddRecExpr with a constant step advances through
+// memory at a fixed rate, so the address it will use a few iterations from
+// now can be computed and prefetched today, hiding the memory latency.  The
+// lookahead distance comes from TargetTransformInfo::getPrefetchDistance()
+// and can be overridden on the command line; with a distance of zero the
+// pass does nothing.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "loop-data-prefetch"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/LoopPass.h"
+#include "llvm/Analysis/ScalarEvolutionExpander.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace llvm;
+
+STATISTIC(NumPrefetches, "Number of prefetch instructions inserted");
+
+static cl::opt<unsigned>
+PrefetchDistance("loop-prefetch-distance",
+                 cl::desc("Number of bytes to prefetch ahead of a strided "
+                          "load (0: use the target's preference)"),
+                 cl::init(0), cl::Hidden);
+
+namespace {
+  class LoopDataPrefetch : public LoopPass {
+    ScalarEvolution *SE;
+    const TargetTransformInfo *TTI;
+  public:
+    static char ID;
+    LoopDataPrefetch() : LoopPass(ID) {
+      initializeLoopDataPrefetchPass(*PassRegistry::getPassRegistry());
+    }
+
+    bool runOnLoop(Loop *L, LPPassManager &LPM);
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.addRequired<LoopInfo>();
+      AU.addPreserved<LoopInfo>();
+      AU.addRequired<ScalarEvolution>();
+      AU.addPreserved<ScalarEvolution>();
+      AU.addRequired<TargetTransformInfo>();
+      AU.setPreservesCFG();
+    }
+  };
+}
+
+char LoopDataPrefetch::ID = 0;
+INITIALIZE_PASS_BEGIN(LoopDataPrefetch, "loop-data-prefetch",
+                      "Loop Data Prefetch", false, false)
+INITIALIZE_PASS_DEPENDENCY(LoopInfo)
+INITIALIZE_PASS_DEPENDENCY(ScalarEvolution)
+INITIALIZE_AG_DEPENDENCY(TargetTransformInfo)
+INITIALIZE_PASS_END(LoopDataPrefetch, "loop-data-prefetch",
+                    "Loop Data Prefetch", false, false)
+
+Pass *llvm::createLoopDataPrefetchPass() { return new LoopDataPrefetch(); }
+
+bool LoopDataPrefetch::runOnLoop(Loop *L, LPPassManager &LPM) {
+  // Only prefetch in innermost loops; outer loop bodies rarely stream.
+  if (!L->empty())
+    return false;
+
+  SE = &getAnalysis<ScalarEvolution>();
+  TTI = &getAnalysis<TargetTransformInfo>();
+
+  unsigned Distance =
+    PrefetchDistance.getNumOccurrences() ? PrefetchDistance
+                                         : TTI->getPrefetchDistance();
+  if (Distance == 0)
+    return false;
+  unsigned CacheLineSize = TTI->getCacheLineSize();
+
+  // Streams we already prefetch this iteration; a second load less than a
+  // cache line away from one of them rides on the same prefetch.
+  SmallVector<const SCEVAddRecExpr *, 16> PrefetchedStreams;
+
+  bool Changed = false;
+  for (Loop::block_iterator BI = L->block_begin(), BE = L->block_end();
+       BI != BE; ++BI) {
+    for (BasicBlock::iterator I = (*BI)->begin(), E = (*BI)->end();
+         I != E; ++I) {
+      LoadInst *LI = dyn_cast<LoadInst>(I);
+      if (!LI || !LI->isSimple())
+        continue;
+
+      const SCEVAddRecExpr *LSCEVAddRec =
+        dyn_cast<SCEVAddRecExpr>(SE->getSCEV(LI->getPointerOperand()));
+      if (!LSCEVAddRec || LSCEVAddRec->getLoop() != L ||
+          !LSCEVAddRec->isAffine())
+        continue;
+
+      const SCEVConstant *Step =
+        dyn_cast<SCEVConstant>(LSCEVAddRec->getStepRecurrence(*SE));
+      if (!Step)
+        continue;
+      int64_t StepBytes = Step->getValue()->getSExtValue();
+      if (StepBytes == 0)
+        continue;
+
+      // Check whether this load shares a cache line stream with one we
+      // already prefetch.
+      bool Duplicate = false;
+      for (unsigned i = 0, e = PrefetchedStreams.size(); i != e; ++i) {
+        const SCEV *Delta = SE->getMinusSCEV(LSCEVAddRec,
+                                             PrefetchedStreams[i]);
+        if (const SCEVConstant *CDelta = dyn_cast<SCEVConstant>(Delta)) {
+          int64_t D = CDelta->getValue()->getSExtValue();
+          if (D > -(int64_t)CacheLineSize && D < (int64_t)CacheLineSize) {
+            Duplicate = true;
+            break;
+          }
+        }
+      }
+      if (Duplicate)
+        continue;
+      PrefetchedStreams.push_back(LSCEVAddRec);
+
+      // Look at least one iteration ahead, and far enough that Distance
+      // bytes have gone by.
+      int64_t AbsStep = StepBytes < 0 ? -StepBytes : StepBytes;
+      int64_t ItersAhead = (Distance + AbsStep - 1) / AbsStep;
+      if (ItersAhead < 1)
+        ItersAhead = 1;
+
+      const SCEV *NextLSCEV = SE->getAddExpr(
+          LSCEVAddRec,
+          SE->getMulExpr(SE->getConstant(LSCEVAddRec->getType(), ItersAhead),
+                         LSCEVAddRec->getStepRecurrence(*SE)));
+      if (!isSafeToExpand(NextLSCEV))
+        continue;
+
+      Type *I8Ptr = Type::getInt8PtrTy((*BI)->getContext(),
+                                       LI->getPointerAddressSpace());
+      SCEVExpander Expander(*SE, "prefaddr");
+      Value *PrefPtrValue = Expander.expandCodeFor(NextLSCEV, I8Ptr, LI);
+
+      IRBuilder<> Builder(LI);
+      Module *M = (*BI)->getParent()->getParent();
+      Type *I32 = Type::getInt32Ty((*BI)->getContext());
+      Value *PrefetchFunc = Intrinsic::getDeclaration(M, Intrinsic::prefetch);
+      Builder.CreateCall4(PrefetchFunc, PrefPtrValue,
+                          ConstantInt::get(I32, 0),   // read
+                          ConstantInt::get(I32, 3),   // high locality
+                          ConstantInt::get(I32, 1));  // data cache
+
+      DEBUG(dbgs() << "LDP: inserted prefetch " << ItersAhead
+                   << " iterations ahead of " << *LI << "\n");
+      ++NumPrefetches;
+      Changed = true;
+    }
+  }
+
+  return Changed;
+}
@@ -23,10 +23,10 @@
 #define DEBUG_TYPE "reassociate"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/ADT/DenseMap.h"
-#include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/RPOTraversal.h"
 #include "llvm/Assembly/Writer.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -127,6 +127,7 @@ namespace {
     bool runOnFunction(Function &F);
 
     virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.addRequired<RPOTraversal>();
       AU.setPreservesCFG();
     }
   private:
@@ -149,7 +150,10 @@ namespace {
 }
 
 char Reassociate::ID = 0;
-INITIALIZE_PASS(Reassociate, "reassociate",
+INITIALIZE_PASS_BEGIN(Reassociate, "reassociate",
+                "Reassociate expressions", false, false)
+INITIALIZE_PASS_DEPENDENCY(RPOTraversal)
+INITIALIZE_PASS_END(Reassociate, "reassociate",
                 "Reassociate expressions", false, false)
 
 // Public interface to the Reassociate pass
@@ -189,9 +193,10 @@ void Reassociate::BuildRankMap(Function &F) {
   for (Function::arg_iterator I = F.arg_begin(), E = F.arg_end(); I != E; ++I)
     ValueRankMap[&*I] = ++i;
 
-  ReversePostOrderTraversal<Function*> RPOT(&F);
-  for (ReversePostOrderTraversal<Function*>::rpo_iterator I = RPOT.begin(),
-         E = RPOT.end(); I != E; ++I) {
+  // Use the cached traversal analysis rather than recomputing the order.
+  RPOTraversal &RPOT = getAnalysis<RPOTraversal>();
+  for (RPOTraversal::rpo_iterator I = RPOT.rpo_begin(),
+         E = RPOT.rpo_end(); I != E; ++I) {
     BasicBlock *BB = *I;
     unsigned BBRank = RankMap[BB] = ++i << 16;
 
@@ -753,6 +753,10 @@ void SCCPSolver::visitTerminatorInst(TerminatorInst &TI) {
 }
 
 void SCCPSolver::visitCastInst(CastInst &I) {
+  // Fast path: once overdefined there is nothing left to learn, so don't
+  // touch the operand's state at all.
+  if (ValueState[&I].isOverdefined()) return;
+
   LatticeVal OpSt = getValueState(I.getOperand(0));
   if (OpSt.isOverdefined())          // Inherit overdefinedness of operand
     markOverdefined(&I);
@@ -822,6 +826,8 @@ void SCCPSolver::visitSelectInst(SelectInst &I) {
   if (I.getType()->isStructTy())
     return markAnythingOverdefined(&I);
 
+  if (ValueState[&I].isOverdefined()) return;
+
   LatticeVal CondValue = getValueState(I.getCondition());
   if (CondValue.isUndefined())
     return;
@@ -852,11 +858,15 @@ void SCCPSolver::visitSelectInst(SelectInst &I) {
 
 // Handle Binary Operators.
 void SCCPSolver::visitBinaryOperator(Instruction &I) {
+  // Check this first so the common already-overdefined case costs one map
+  // lookup instead of three.  Note that looking up the operand states below
+  // may grow ValueState, so the reference must be re-fetched afterwards.
+  if (ValueState[&I].isOverdefined()) return;
+
   LatticeVal V1State = getValueState(I.getOperand(0));
   LatticeVal V2State = getValueState(I.getOperand(1));
 
   LatticeVal &IV = ValueState[&I];
-  if (IV.isOverdefined()) return;
 
   if (V1State.isConstant() && V2State.isConstant())
     return markConstant(IV, &I,
@@ -910,11 +920,14 @@ void SCCPSolver::visitBinaryOperator(Instruction &I) {
 
 // Handle ICmpInst instruction.
 void SCCPSolver::visitCmpInst(CmpInst &I) {
+  // As in visitBinaryOperator, take the overdefined fast path before looking
+  // at the operands.
+  if (ValueState[&I].isOverdefined()) return;
+
   LatticeVal V1State = getValueState(I.getOperand(0));
   LatticeVal V2State = getValueState(I.getOperand(1));
 
   LatticeVal &IV = ValueState[&I];
-  if (IV.isOverdefined()) return;
 
   if (V1State.isConstant() && V2State.isConstant())
     return markConstant(IV, &I, ConstantExpr::getCompare(I.getPredicate(),
@@ -1048,11 +1061,12 @@ void SCCPSolver::visitLoadInst(LoadInst &I) {
   if (I.getType()->isStructTy())
     return markAnythingOverdefined(&I);
 
+  if (ValueState[&I].isOverdefined()) return;
+
   LatticeVal PtrVal = getValueState(I.getOperand(0));
   if (PtrVal.isUndefined()) return;   // The pointer is not resolved yet!
 
   LatticeVal &IV = ValueState[&I];
-  if (IV.isOverdefined()) return;
 
   if (!PtrVal.isConstant() || I.isVolatile())
     return markOverdefined(IV, &I);
@@ -25,6 +25,8 @@
 
 #define DEBUG_TYPE "sroa"
 #include "llvm/Transforms/Scalar.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallVector.h"
@@ -59,6 +61,7 @@
 using namespace llvm;
 
 STATISTIC(NumAllocasAnalyzed, "Number of allocas analyzed for replacement");
+STATISTIC(NumAllocaVisitsSkipped, "Number of re-visits skipped as unchanged");
 STATISTIC(NumNewAllocas,      "Number of new, smaller allocas introduced");
 STATISTIC(NumPromoted,        "Number of allocas promoted to SSA values");
 STATISTIC(NumLoadsSpeculated, "Number of loads speculated to allow promotion");
@@ -1320,6 +1323,16 @@ class SROA : public FunctionPass {
   /// \brief A collection of alloca instructions we can directly promote.
   std::vector<AllocaInst *> PromotableAllocas;
 
+  /// \brief Use-list fingerprints of allocas the last visit failed to change.
+  ///
+  /// runOnAlloca is re-entered whenever a rewrite touches a use of some other
+  /// alloca, but most such revisits see an identical use list and would just
+  /// rebuild an identical partitioning.  After an unproductive visit we record
+  /// a fingerprint of the use list and skip re-slicing until it changes.  A
+  /// fingerprint collision can only suppress a revisit, costing a missed
+  /// simplification rather than a miscompile.
+  DenseMap<AllocaInst *, uint64_t> UnchangedAllocaFingerprints;
+
 public:
   SROA(bool RequiresDomTree = true)
       : FunctionPass(ID), RequiresDomTree(RequiresDomTree),
@@ -3490,6 +3503,19 @@ bool SROA::splitAlloca(AllocaInst &AI, AllocaPartitioning &P) {
   return Changed;
 }
 
+/// \brief Compute a fingerprint of an alloca's use list.
+///
+/// The partitioning of an alloca is a pure function of its (transitive) use
+/// list, so an unchanged fingerprint means a repeat visit would re-derive the
+/// same result.
+static uint64_t fingerprintAllocaUses(AllocaInst &AI) {
+  uint64_t Hash = 0;
+  for (Value::use_iterator UI = AI.use_begin(), UE = AI.use_end(); UI != UE;
+       ++UI)
+    Hash = hash_combine(Hash, *UI, UI.getOperandNo());
+  return Hash;
+}
+
 /// \brief Analyze an alloca for SROA.
 ///
 /// This analyzes the alloca to ensure we can reason about it, builds
@@ -3501,6 +3527,7 @@ bool SROA::runOnAlloca(AllocaInst &AI) {
 
   // Special case dead allocas, as they're trivial.
   if (AI.use_empty()) {
+    UnchangedAllocaFingerprints.erase(&AI);
     AI.eraseFromParent();
     return true;
   }
@@ -3510,6 +3537,17 @@ bool SROA::runOnAlloca(AllocaInst &AI) {
       TD->getTypeAllocSize(AI.getAllocatedType()) == 0)
     return false;
 
+  // If the last visit failed to change this alloca and its use list is
+  // unchanged, re-slicing it would rebuild the same partitioning.
+  uint64_t UseFingerprint = fingerprintAllocaUses(AI);
+  DenseMap<AllocaInst *, uint64_t>::iterator FPI =
+      UnchangedAllocaFingerprints.find(&AI);
+  if (FPI != UnchangedAllocaFingerprints.end() &&
+      FPI->second == UseFingerprint) {
+    ++NumAllocaVisitsSkipped;
+    return false;
+  }
+
   bool Changed = false;
 
   // First, split any FCA loads and stores touching this alloca to promote
@@ -3520,8 +3558,11 @@ bool SROA::runOnAlloca(AllocaInst &AI) {
   // Build the partition set using a recursive instruction-visiting builder.
   AllocaPartitioning P(*TD, AI);
   DEBUG(P.print(dbgs()));
-  if (P.isEscaped())
+  if (P.isEscaped()) {
+    if (!Changed)
+      UnchangedAllocaFingerprints[&AI] = UseFingerprint;
     return Changed;
+  }
 
   // Delete all the dead users of this alloca before splitting and rewriting it.
   for (AllocaPartitioning::dead_user_iterator DI = P.dead_user_begin(),
@@ -3545,10 +3586,16 @@ bool SROA::runOnAlloca(AllocaInst &AI) {
   }
 
   // No partitions to split. Leave the dead alloca for a later pass to clean up.
-  if (P.begin() == P.end())
+  if (P.begin() == P.end()) {
+    if (!Changed)
+      UnchangedAllocaFingerprints[&AI] = UseFingerprint;
     return Changed;
+  }
 
-  return splitAlloca(AI, P) || Changed;
+  Changed = splitAlloca(AI, P) || Changed;
+  if (!Changed)
+    UnchangedAllocaFingerprints[&AI] = UseFingerprint;
+  return Changed;
 }
 
 /// \brief Delete the dead instructions accumulated in this run.
@@ -3667,11 +3714,18 @@ bool SROA::runOnFunction(Function &F) {
   }
   DT = getAnalysisIfAvailable<DominatorTree>();
 
+  // Seed the worklist in reverse so that pop_back_val visits allocas in entry
+  // block (and thus dominance) order: slicing a dominating alloca first
+  // rewrites the uses of later allocas before they are themselves sliced,
+  // rather than forcing them back onto the worklist afterwards.
   BasicBlock &EntryBB = F.getEntryBlock();
+  SmallVector<AllocaInst *, 16> EntryAllocas;
   for (BasicBlock::iterator I = EntryBB.begin(), E = llvm::prior(EntryBB.end());
        I != E; ++I)
     if (AllocaInst *AI = dyn_cast<AllocaInst>(I))
-      Worklist.insert(AI);
+      EntryAllocas.push_back(AI);
+  while (!EntryAllocas.empty())
+    Worklist.insert(EntryAllocas.pop_back_val());
 
   bool Changed = false;
   // A set of deleted alloca instruction pointers which should be removed from
@@ -3686,6 +3740,10 @@ bool SROA::runOnFunction(Function &F) {
       // Remove the deleted allocas from various lists so that we don't try to
       // continue processing them.
       if (!DeletedAllocas.empty()) {
+        for (SmallPtrSet<AllocaInst *, 4>::iterator
+               AI = DeletedAllocas.begin(),
+               AE = DeletedAllocas.end(); AI != AE; ++AI)
+          UnchangedAllocaFingerprints.erase(*AI);
         Worklist.remove_if(IsAllocaInSet(DeletedAllocas));
         PostPromotionWorklist.remove_if(IsAllocaInSet(DeletedAllocas));
         PromotableAllocas.erase(std::remove_if(PromotableAllocas.begin(),
@@ -3702,6 +3760,8 @@ bool SROA::runOnFunction(Function &F) {
     PostPromotionWorklist.clear();
   } while (!Worklist.empty());
 
+  UnchangedAllocaFingerprints.clear();
+
   return Changed;
 }
 
@@ -35,11 +35,25 @@
 #include "llvm/IR/Module.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/CFG.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ValueHandle.h"
 #include "llvm/Transforms/Utils/Local.h"
 using namespace llvm;
 
 STATISTIC(NumSimpl, "Number of blocks simplified");
 
+// SimplifyCFG's transformations are local to a block and its CFG neighbors,
+// so after the initial sweep only the neighborhood of blocks that actually
+// changed can expose new opportunities.  The worklist mode below exploits
+// this to make the fixpoint cost proportional to the number of mutations
+// instead of the number of blocks, which matters for huge machine-generated
+// functions.  It is opt-in because the neighborhood propagation is a
+// heuristic rather than a proven closure of every transformation.
+static cl::opt<bool>
+WorklistSimplify("simplifycfg-worklist", cl::Hidden, cl::init(false),
+                 cl::desc("Reiterate SimplifyCFG only on the neighborhood of "
+                          "changed blocks instead of the whole function"));
+
 namespace {
   struct CFGSimplifyPass : public FunctionPass {
     static char ID; // Pass identification, replacement for typeid
@@ -67,159 +81,13 @@ FunctionPass *llvm::createCFGSimplificationPass() {
   return new CFGSimplifyPass();
 }
 
-/// changeToUnreachable - Insert an unreachable instruction before the specified
-/// instruction, making it and the rest of the code in the block dead.
-static void changeToUnreachable(Instruction *I, bool UseLLVMTrap) {
-  BasicBlock *BB = I->getParent();
-  // Loop over all of the successors, removing BB's entry from any PHI
-  // nodes.
-  for (succ_iterator SI = succ_begin(BB), SE = succ_end(BB); SI != SE; ++SI)
-    (*SI)->removePredecessor(BB);
-
-  // Insert a call to llvm.trap right before this.  This turns the undefined
-  // behavior into a hard fail instead of falling through into random code.
-  if (UseLLVMTrap) {
-    Function *TrapFn =
-      Intrinsic::getDeclaration(BB->getParent()->getParent(), Intrinsic::trap);
-    CallInst *CallTrap = CallInst::Create(TrapFn, "", I);
-    CallTrap->setDebugLoc(I->getDebugLoc());
-  }
-  new UnreachableInst(I->getContext(), I);
-
-  // All instructions after this are dead.
-  BasicBlock::iterator BBI = I, BBE = BB->end();
-  while (BBI != BBE) {
-    if (!BBI->use_empty())
-      BBI->replaceAllUsesWith(UndefValue::get(BBI->getType()));
-    BB->getInstList().erase(BBI++);
-  }
-}
-
-/// changeToCall - Convert the specified invoke into a normal call.
-static void changeToCall(InvokeInst *II) {
-  SmallVector<Value*, 8> Args(II->op_begin(), II->op_end() - 3);
-  CallInst *NewCall = CallInst::Create(II->getCalledValue(), Args, "", II);
-  NewCall->takeName(II);
-  NewCall->setCallingConv(II->getCallingConv());
-  NewCall->setAttributes(II->getAttributes());
-  NewCall->setDebugLoc(II->getDebugLoc());
-  II->replaceAllUsesWith(NewCall);
-
-  // Follow the call by a branch to the normal destination.
-  BranchInst::Create(II->getNormalDest(), II);
-
-  // Update PHI nodes in the unwind destination
-  II->getUnwindDest()->removePredecessor(II->getParent());
-  II->eraseFromParent();
-}
-
-static bool markAliveBlocks(BasicBlock *BB,
-                            SmallPtrSet<BasicBlock*, 128> &Reachable) {
-
-  SmallVector<BasicBlock*, 128> Worklist;
-  Worklist.push_back(BB);
-  Reachable.insert(BB);
-  bool Changed = false;
-  do {
-    BB = Worklist.pop_back_val();
-
-    // Do a quick scan of the basic block, turning any obviously unreachable
-    // instructions into LLVM unreachable insts.  The instruction combining pass
-    // canonicalizes unreachable insts into stores to null or undef.
-    for (BasicBlock::iterator BBI = BB->begin(), E = BB->end(); BBI != E;++BBI){
-      if (CallInst *CI = dyn_cast<CallInst>(BBI)) {
-        if (CI->doesNotReturn()) {
-          // If we found a call to a no-return function, insert an unreachable
-          // instruction after it.  Make sure there isn't *already* one there
-          // though.
-          ++BBI;
-          if (!isa<UnreachableInst>(BBI)) {
-            // Don't insert a call to llvm.trap right before the unreachable.
-            changeToUnreachable(BBI, false);
-            Changed = true;
-          }
-          break;
-        }
-      }
-
-      // Store to undef and store to null are undefined and used to signal that
-      // they should be changed to unreachable by passes that can't modify the
-      // CFG.
-      if (StoreInst *SI = dyn_cast<StoreInst>(BBI)) {
-        // Don't touch volatile stores.
-        if (SI->isVolatile()) continue;
-
-        Value *Ptr = SI->getOperand(1);
-
-        if (isa<UndefValue>(Ptr) ||
-            (isa<ConstantPointerNull>(Ptr) &&
-             SI->getPointerAddressSpace() == 0)) {
-          changeToUnreachable(SI, true);
-          Changed = true;
-          break;
-        }
-      }
-    }
-
-    // Turn invokes that call 'nounwind' functions into ordinary calls.
-    if (InvokeInst *II = dyn_cast<InvokeInst>(BB->getTerminator())) {
-      Value *Callee = II->getCalledValue();
-      if (isa<ConstantPointerNull>(Callee) || isa<UndefValue>(Callee)) {
-        changeToUnreachable(II, true);
-        Changed = true;
-      } else if (II->doesNotThrow()) {
-        if (II->use_empty() && II->onlyReadsMemory()) {
-          // jump to the normal destination branch.
-          BranchInst::Create(II->getNormalDest(), II);
-          II->getUnwindDest()->removePredecessor(II->getParent());
-          II->eraseFromParent();
-        } else
-          changeToCall(II);
-        Changed = true;
-      }
-    }
-
-    Changed |= ConstantFoldTerminator(BB, true);
-    for (succ_iterator SI = succ_begin(BB), SE = succ_end(BB); SI != SE; ++SI)
-      if (Reachable.insert(*SI))
-        Worklist.push_back(*SI);
-  } while (!Worklist.empty());
-  return Changed;
-}
-
-/// removeUnreachableBlocksFromFn - Remove blocks that are not reachable, even
-/// if they are in a dead cycle.  Return true if a change was made, false
-/// otherwise.
+/// removeUnreachableBlocksFromFn - Remove blocks that are not reachable,
+/// even if they are in a dead cycle, keeping the pass statistics updated.
 static bool removeUnreachableBlocksFromFn(Function &F) {
-  SmallPtrSet<BasicBlock*, 128> Reachable;
-  bool Changed = markAliveBlocks(F.begin(), Reachable);
-
-  // If there are unreachable blocks in the CFG...
-  if (Reachable.size() == F.size())
-    return Changed;
-
-  assert(Reachable.size() < F.size());
-  NumSimpl += F.size()-Reachable.size();
-
-  // Loop over all of the basic blocks that are not reachable, dropping all of
-  // their internal references...
-  for (Function::iterator BB = ++F.begin(), E = F.end(); BB != E; ++BB) {
-    if (Reachable.count(BB))
-      continue;
-
-    for (succ_iterator SI = succ_begin(BB), SE = succ_end(BB); SI != SE; ++SI)
-      if (Reachable.count(*SI))
-        (*SI)->removePredecessor(BB);
-    BB->dropAllReferences();
-  }
-
-  for (Function::iterator I = ++F.begin(); I != F.end();)
-    if (!Reachable.count(I))
-      I = F.getBasicBlockList().erase(I);
-    else
-      ++I;
-
-  return true;
+  unsigned Size = F.size();
+  bool Changed = removeUnreachableBlocks(F);
+  NumSimpl += Size - F.size();
+  return Changed;
 }
 
 /// mergeEmptyReturnBlocks - If we have more than one empty (other than phi
@@ -298,10 +166,64 @@ static bool mergeEmptyReturnBlocks(Function &F) {
   return Changed;
 }
 
+/// captureNeighborhood - Record BB and its current predecessors and
+/// successors as WeakVHs.  SimplifyCFG may delete any of these blocks, so
+/// the snapshot must be taken before the call and the handles checked for
+/// null afterwards.
+static void captureNeighborhood(BasicBlock *BB,
+                                SmallVectorImpl<WeakVH> &Neighbors) {
+  Neighbors.push_back(BB);
+  for (pred_iterator PI = pred_begin(BB), E = pred_end(BB); PI != E; ++PI)
+    Neighbors.push_back(*PI);
+  for (succ_iterator SI = succ_begin(BB), E = succ_end(BB); SI != E; ++SI)
+    Neighbors.push_back(*SI);
+}
+
+/// worklistSimplifyCFG - Like iterativelySimplifyCFG, but after the initial
+/// sweep over the function only revisit blocks adjacent to a change,
+/// propagating the dirty set along CFG edges until it drains.
+static bool worklistSimplifyCFG(Function &F, const TargetTransformInfo &TTI,
+                                const DataLayout *TD) {
+  bool Changed = false;
+  SmallVector<WeakVH, 64> Worklist;
+
+  // Initial sweep: visit every block once, seeding the worklist with the
+  // neighborhood of each block that changed.
+  for (Function::iterator BBIt = F.begin(); BBIt != F.end(); ) {
+    BasicBlock *BB = BBIt++;
+    SmallVector<WeakVH, 8> Neighbors;
+    captureNeighborhood(BB, Neighbors);
+    if (SimplifyCFG(BB, TTI, TD)) {
+      Changed = true;
+      ++NumSimpl;
+      Worklist.append(Neighbors.begin(), Neighbors.end());
+    }
+  }
+
+  // Drain the worklist.  Duplicate entries are harmless (SimplifyCFG simply
+  // reports no change) and entries for deleted blocks have nulled out.
+  while (!Worklist.empty()) {
+    BasicBlock *BB = cast_or_null<BasicBlock>((Value*)Worklist.pop_back_val());
+    if (!BB)
+      continue;
+    SmallVector<WeakVH, 8> Neighbors;
+    captureNeighborhood(BB, Neighbors);
+    if (SimplifyCFG(BB, TTI, TD)) {
+      Changed = true;
+      ++NumSimpl;
+      Worklist.append(Neighbors.begin(), Neighbors.end());
+    }
+  }
+  return Changed;
+}
+
 /// iterativelySimplifyCFG - Call SimplifyCFG on all the blocks in the function,
 /// iterating until no more changes are made.
 static bool iterativelySimplifyCFG(Function &F, const TargetTransformInfo &TTI,
                                    const DataLayout *TD) {
+  if (WorklistSimplify)
+    return worklistSimplifyCFG(F, TTI, TD);
+
   bool Changed = false;
   bool LocalChange = true;
   while (LocalChange) {
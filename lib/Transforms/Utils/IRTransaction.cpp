@@ -0,0 +1,190 @@
+//===-- IRTransaction.cpp - Journaled speculative IR mutation -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the IRTransaction class.  Each mutation is journaled
+// as an Action object that knows how to undo itself; abort replays the
+// journal in reverse and commit finalizes deferred deletions.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Utils/IRTransaction.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Instruction.h"
+using namespace llvm;
+
+/// Action - One journaled mutation.  undo() restores the previous state;
+/// commit() performs any finalization (e.g. deleting a removed instruction).
+class IRTransaction::Action {
+public:
+  virtual ~Action() {}
+  virtual void undo() = 0;
+  virtual void commit() {}
+};
+
+namespace {
+
+/// InsertPos - A remembered position in a basic block, independent of any
+/// instruction that might itself move later in the transaction.
+struct InsertPos {
+  BasicBlock *BB;
+  Instruction *Next;   // Null means "at the end of BB".
+
+  InsertPos() : BB(0), Next(0) {}
+  explicit InsertPos(Instruction *I)
+    : BB(I->getParent()), Next(I->getNextNode()) {}
+
+  /// reinsert - Put the detached instruction I back at this position.
+  void reinsert(Instruction *I) const {
+    if (Next)
+      BB->getInstList().insert(Next, I);
+    else
+      BB->getInstList().push_back(I);
+  }
+};
+
+/// OperandSetter - Journal entry for a single setOperand call.
+class OperandSetter : public IRTransaction::Action {
+  Instruction *Inst;
+  unsigned Idx;
+  Value *Origin;
+public:
+  OperandSetter(Instruction *I, unsigned Idx, Value *NewVal)
+    : Inst(I), Idx(Idx), Origin(I->getOperand(Idx)) {
+    Inst->setOperand(Idx, NewVal);
+  }
+  virtual void undo() {
+    Inst->setOperand(Idx, Origin);
+  }
+};
+
+/// UsesReplacer - Journal entry for replaceAllUsesWith.  Records each
+/// rewritten use as a (user, operand index) pair.
+class UsesReplacer : public IRTransaction::Action {
+  typedef std::pair<Instruction*, unsigned> UseRec;
+  Instruction *Inst;
+  SmallVector<UseRec, 8> OriginalUses;
+public:
+  UsesReplacer(Instruction *I, Value *New) : Inst(I) {
+    for (Value::use_iterator UI = I->use_begin(), E = I->use_end();
+         UI != E; ++UI) {
+      Instruction *User = cast<Instruction>(*UI);
+      OriginalUses.push_back(UseRec(User, UI.getOperandNo()));
+    }
+    Inst->replaceAllUsesWith(New);
+  }
+  virtual void undo() {
+    for (unsigned i = 0, e = OriginalUses.size(); i != e; ++i)
+      OriginalUses[i].first->setOperand(OriginalUses[i].second, Inst);
+  }
+};
+
+/// InstructionMoveRecord - Journal entry for moveBefore.
+class InstructionMoveRecord : public IRTransaction::Action {
+  Instruction *Inst;
+  InsertPos Origin;
+public:
+  InstructionMoveRecord(Instruction *I, Instruction *Before)
+    : Inst(I), Origin(I) {
+    Inst->moveBefore(Before);
+  }
+  virtual void undo() {
+    Inst->removeFromParent();
+    Origin.reinsert(Inst);
+  }
+};
+
+/// InstructionInserter - Journal entry for insertBefore of a newly created
+/// instruction.  Aborting deletes the instruction.
+class InstructionInserter : public IRTransaction::Action {
+  Instruction *Inst;
+public:
+  InstructionInserter(Instruction *I, Instruction *Before) : Inst(I) {
+    assert(I->getParent() == 0 &&
+           "insertBefore expects a detached instruction; use moveBefore");
+    Inst->insertBefore(Before);
+  }
+  virtual void undo() {
+    Inst->eraseFromParent();
+  }
+};
+
+/// InstructionRemover - Journal entry for remove.  The instruction is
+/// unlinked but stays alive until commit deletes it.
+class InstructionRemover : public IRTransaction::Action {
+  Instruction *Inst;
+  InsertPos Origin;
+  UsesReplacer *Replacer;
+public:
+  InstructionRemover(Instruction *I, Value *ReplaceWith)
+    : Inst(I), Origin(I), Replacer(0) {
+    if (ReplaceWith)
+      Replacer = new UsesReplacer(I, ReplaceWith);
+    assert(Inst->use_empty() && "Removed instruction still has uses!");
+    Inst->removeFromParent();
+  }
+  virtual ~InstructionRemover() {
+    delete Replacer;
+  }
+  virtual void undo() {
+    Origin.reinsert(Inst);
+    if (Replacer)
+      Replacer->undo();
+  }
+  virtual void commit() {
+    delete Inst;
+    Inst = 0;
+  }
+};
+
+} // end anonymous namespace
+
+IRTransaction::~IRTransaction() {
+  abort();
+}
+
+void IRTransaction::setOperand(Instruction *I, unsigned Idx, Value *V) {
+  Actions.push_back(new OperandSetter(I, Idx, V));
+}
+
+void IRTransaction::replaceAllUsesWith(Instruction *I, Value *V) {
+  Actions.push_back(new UsesReplacer(I, V));
+}
+
+void IRTransaction::moveBefore(Instruction *I, Instruction *Before) {
+  Actions.push_back(new InstructionMoveRecord(I, Before));
+}
+
+void IRTransaction::insertBefore(Instruction *I, Instruction *Before) {
+  Actions.push_back(new InstructionInserter(I, Before));
+}
+
+void IRTransaction::remove(Instruction *I, Value *ReplaceWith) {
+  Actions.push_back(new InstructionRemover(I, ReplaceWith));
+}
+
+void IRTransaction::rollbackTo(SavePoint SP) {
+  assert(SP <= Actions.size() && "Save point is from a later journal state!");
+  while (Actions.size() > SP) {
+    Actions.back()->undo();
+    delete Actions.back();
+    Actions.pop_back();
+  }
+}
+
+void IRTransaction::commit() {
+  for (unsigned i = 0, e = Actions.size(); i != e; ++i) {
+    Actions[i]->commit();
+    delete Actions[i];
+  }
+  Actions.clear();
+}
+
+void IRTransaction::abort() {
+  rollbackTo(0);
+}
@@ -13,6 +13,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Analysis/CallGraph.h"
@@ -436,20 +437,40 @@ static bool hasLifetimeMarkers(AllocaInst *AI) {
   return false;
 }
 
+/// LocationCache - Memoized debug location translations for one inlined call
+/// site, keyed by the pieces of the original location.  The instructions
+/// inlined from one function overwhelmingly share a handful of locations, and
+/// rebuilding the inlined-at chain costs a uniquing lookup (and potentially a
+/// fresh MDNode) per chain link, so translate each distinct location once.
+typedef DenseMap<std::pair<std::pair<MDNode*, MDNode*>, unsigned>, DebugLoc>
+LocationCache;
+
 /// updateInlinedAtInfo - Helper function used by fixupLineNumbers to
 /// recursively update InlinedAtEntry of a DebugLoc.
-static DebugLoc updateInlinedAtInfo(const DebugLoc &DL, 
+static DebugLoc updateInlinedAtInfo(const DebugLoc &DL,
                                     const DebugLoc &InlinedAtDL,
-                                    LLVMContext &Ctx) {
+                                    LLVMContext &Ctx, LocationCache &Cache) {
+  std::pair<std::pair<MDNode*, MDNode*>, unsigned> Key =
+    std::make_pair(std::make_pair(DL.getScope(Ctx), DL.getInlinedAt(Ctx)),
+                   DL.getLine() | (DL.getCol() << 24));
+  LocationCache::iterator It = Cache.find(Key);
+  if (It != Cache.end())
+    return It->second;
+
+  DebugLoc NewDL;
   if (MDNode *IA = DL.getInlinedAt(Ctx)) {
-    DebugLoc NewInlinedAtDL 
-      = updateInlinedAtInfo(DebugLoc::getFromDILocation(IA), InlinedAtDL, Ctx);
-    return DebugLoc::get(DL.getLine(), DL.getCol(), DL.getScope(Ctx),
-                         NewInlinedAtDL.getAsMDNode(Ctx));
+    DebugLoc NewInlinedAtDL
+      = updateInlinedAtInfo(DebugLoc::getFromDILocation(IA), InlinedAtDL,
+                            Ctx, Cache);
+    NewDL = DebugLoc::get(DL.getLine(), DL.getCol(), DL.getScope(Ctx),
+                          NewInlinedAtDL.getAsMDNode(Ctx));
+  } else {
+    NewDL = DebugLoc::get(DL.getLine(), DL.getCol(), DL.getScope(Ctx),
+                          InlinedAtDL.getAsMDNode(Ctx));
   }
 
-  return DebugLoc::get(DL.getLine(), DL.getCol(), DL.getScope(Ctx),
-                       InlinedAtDL.getAsMDNode(Ctx));
+  Cache[Key] = NewDL;
+  return NewDL;
 }
 
 /// fixupLineNumbers - Update inlined instructions' line numbers to 
@@ -460,17 +481,25 @@ static void fixupLineNumbers(Function *Fn, Function::iterator FI,
   if (TheCallDL.isUnknown())
     return;
 
+  LocationCache Cache;
+  DenseMap<std::pair<MDNode*, MDNode*>, MDNode*> InlinedVariables;
   for (; FI != Fn->end(); ++FI) {
     for (BasicBlock::iterator BI = FI->begin(), BE = FI->end();
          BI != BE; ++BI) {
       DebugLoc DL = BI->getDebugLoc();
       if (!DL.isUnknown()) {
-        BI->setDebugLoc(updateInlinedAtInfo(DL, TheCallDL, BI->getContext()));
+        BI->setDebugLoc(updateInlinedAtInfo(DL, TheCallDL, BI->getContext(),
+                                            Cache));
         if (DbgValueInst *DVI = dyn_cast<DbgValueInst>(BI)) {
           LLVMContext &Ctx = BI->getContext();
           MDNode *InlinedAt = BI->getDebugLoc().getInlinedAt(Ctx);
-          DVI->setOperand(2, createInlinedVariable(DVI->getVariable(), 
-                                                   InlinedAt, Ctx));
+          // Variables are repeated across dbg.value uses; only build the
+          // inlined variant of each once.
+          MDNode *&Var = InlinedVariables[std::make_pair(
+              static_cast<MDNode*>(DVI->getVariable()), InlinedAt)];
+          if (!Var)
+            Var = createInlinedVariable(DVI->getVariable(), InlinedAt, Ctx);
+          DVI->setOperand(2, Var);
         }
       }
     }
@@ -143,6 +143,16 @@ bool LoopSimplify::runOnLoop(Loop *l, LPPassManager &LPM) {
 ///
 bool LoopSimplify::ProcessLoop(Loop *L, LPPassManager &LPM) {
   bool Changed = false;
+
+  // Fast path: if neither this loop nor anything nested inside it has been
+  // structurally modified since we last put it into canonical form, there is
+  // nothing to re-verify.  Re-check the cheap canonical-form properties so a
+  // mutation that slipped past the dirty tagging still forces a full
+  // reprocess.
+  if (L->isAnalysisClean() && L->getLoopPreheader() &&
+      L->getNumBackEdges() == 1)
+    return false;
+
 ReprocessLoop:
 
   // Check to see that no blocks (other than the header) in this loop have
@@ -360,6 +370,13 @@ ReprocessLoop:
     }
   }
 
+  // Remember that this loop has been canonicalized so the next run can skip
+  // it if nothing in its subtree changes in the meantime.  Loops we failed
+  // to canonicalize (e.g. indirectbr entries) stay dirty and get another
+  // look next time.
+  if (L->getLoopPreheader() && L->getNumBackEdges() == 1)
+    L->setAnalysisClean();
+
   return Changed;
 }
 
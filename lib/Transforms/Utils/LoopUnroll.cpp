@@ -18,6 +18,7 @@
 
 #define DEBUG_TYPE "loop-unroll"
 #include "llvm/Transforms/Utils/UnrollLoop.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/InstructionSimplify.h"
 #include "llvm/Analysis/LoopIterator.h"
@@ -42,6 +43,10 @@ static inline void RemapInstruction(Instruction *I,
                                     ValueToValueMapTy &VMap) {
   for (unsigned op = 0, E = I->getNumOperands(); op != E; ++op) {
     Value *Op = I->getOperand(op);
+    // Only instructions and basic blocks are ever remapped; don't pay for a
+    // hash lookup on constants, arguments and globals.
+    if (!isa<Instruction>(Op) && !isa<BasicBlock>(Op))
+      continue;
     ValueToValueMapTy::iterator It = VMap.find(Op);
     if (It != VMap.end())
       I->setOperand(op, It->second);
@@ -58,10 +63,13 @@ static inline void RemapInstruction(Instruction *I,
 
 /// FoldBlockIntoPredecessor - Folds a basic block into its predecessor if it
 /// only has one predecessor, and that predecessor only has one successor.
-/// The LoopInfo Analysis that is passed will be kept consistent.
+/// The LoopInfo Analysis that is passed will be kept consistent.  If
+/// ForgottenLoop is given, ScalarEvolution has already been told to forget
+/// that loop and blocks inside it are folded without notifying it again.
 /// Returns the new combined block.
 static BasicBlock *FoldBlockIntoPredecessor(BasicBlock *BB, LoopInfo* LI,
-                                            LPPassManager *LPM) {
+                                            LPPassManager *LPM,
+                                            Loop *ForgottenLoop = 0) {
   // Merge basic blocks into their predecessor if there is only one distinct
   // pred, and if there is only one distinct successor of the predecessor, and
   // if there are no PHI nodes.
@@ -98,7 +106,8 @@ static BasicBlock *FoldBlockIntoPredecessor(BasicBlock *BB, LoopInfo* LI,
   if (LPM) {
     if (ScalarEvolution *SE = LPM->getAnalysisIfAvailable<ScalarEvolution>()) {
       if (Loop *L = LI->getLoopFor(BB))
-        SE->forgetLoop(L);
+        if (L != ForgottenLoop)
+          SE->forgetLoop(L);
     }
   }
   LI->removeBlock(BB);
@@ -246,7 +255,6 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount,
 
   // For the first iteration of the loop, we should use the precloned values for
   // PHI nodes.  Insert associations now.
-  ValueToValueMapTy LastValueMap;
   std::vector<PHINode*> OrigPHINode;
   for (BasicBlock::iterator I = Header->begin(); isa<PHINode>(I); ++I) {
     OrigPHINode.push_back(cast<PHINode>(I));
@@ -257,8 +265,8 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount,
   Headers.push_back(Header);
   Latches.push_back(LatchBlock);
 
-  // The current on-the-fly SSA update requires blocks to be processed in
-  // reverse postorder so that LastValueMap contains the correct value at each
+  // The on-the-fly SSA update requires blocks to be processed in reverse
+  // postorder so that each iteration's map contains the correct value at each
   // exit.
   LoopBlocksDFS DFS(L);
   DFS.perform(LI);
@@ -267,64 +275,80 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount,
   LoopBlocksDFS::RPOIterator BlockBegin = DFS.beginRPO();
   LoopBlocksDFS::RPOIterator BlockEnd = DFS.endRPO();
 
+  // Clone the loop body in a single traversal of the original blocks, making
+  // all Count-1 copies of each block while its instructions are still hot in
+  // cache.  Each unrolled iteration keeps its own value map so the SSA fixup
+  // below only ever probes the map for one body's worth of values.
+  std::vector<BasicBlock*> OrigBlocks;
+  std::vector<std::vector<BasicBlock*> > NewBlocks(Count);
+  std::vector<ValueToValueMapTy*> IterationMaps(Count, (ValueToValueMapTy*)0);
+  for (unsigned It = 1; It != Count; ++It)
+    IterationMaps[It] = new ValueToValueMapTy();
+
+  for (LoopBlocksDFS::RPOIterator BB = BlockBegin; BB != BlockEnd; ++BB) {
+    OrigBlocks.push_back(*BB);
+    for (unsigned It = 1; It != Count; ++It) {
+      ValueToValueMapTy &VMap = *IterationMaps[It];
+      BasicBlock *New = CloneBasicBlock(*BB, VMap, "." + Twine(It));
+      VMap[*BB] = New;
+      NewBlocks[It].push_back(New);
+
+      // Keep track of new headers and latches as we create them, so that
+      // we can insert the proper branches later.
+      if (*BB == Header)
+        Headers.push_back(New);
+      if (*BB == LatchBlock)
+        Latches.push_back(New);
+    }
+  }
+
+  // Now wire each iteration up: thread the header PHI values through from the
+  // previous iteration, populate exit block PHIs, and remap the cloned
+  // instructions' operands from the original body to this iteration's clones.
   for (unsigned It = 1; It != Count; ++It) {
-    std::vector<BasicBlock*> NewBlocks;
+    ValueToValueMapTy &VMap = *IterationMaps[It];
 
-    for (LoopBlocksDFS::RPOIterator BB = BlockBegin; BB != BlockEnd; ++BB) {
-      ValueToValueMapTy VMap;
-      BasicBlock *New = CloneBasicBlock(*BB, VMap, "." + Twine(It));
+    for (unsigned i = 0, e = OrigBlocks.size(); i != e; ++i) {
+      BasicBlock *OrigBB = OrigBlocks[i];
+      BasicBlock *New = NewBlocks[It][i];
       Header->getParent()->getBasicBlockList().push_back(New);
 
       // Loop over all of the PHI nodes in the block, changing them to use the
-      // incoming values from the previous block.
-      if (*BB == Header)
-        for (unsigned i = 0, e = OrigPHINode.size(); i != e; ++i) {
-          PHINode *NewPHI = cast<PHINode>(VMap[OrigPHINode[i]]);
+      // incoming values from the previous iteration.
+      if (OrigBB == Header)
+        for (unsigned p = 0, pe = OrigPHINode.size(); p != pe; ++p) {
+          PHINode *NewPHI = cast<PHINode>(VMap[OrigPHINode[p]]);
           Value *InVal = NewPHI->getIncomingValueForBlock(LatchBlock);
           if (Instruction *InValI = dyn_cast<Instruction>(InVal))
             if (It > 1 && L->contains(InValI))
-              InVal = LastValueMap[InValI];
-          VMap[OrigPHINode[i]] = InVal;
+              InVal = (*IterationMaps[It-1])[InValI];
+          VMap[OrigPHINode[p]] = InVal;
           New->getInstList().erase(NewPHI);
         }
 
-      // Update our running map of newest clones
-      LastValueMap[*BB] = New;
-      for (ValueToValueMapTy::iterator VI = VMap.begin(), VE = VMap.end();
-           VI != VE; ++VI)
-        LastValueMap[VI->first] = VI->second;
-
       L->addBasicBlockToLoop(New, LI->getBase());
 
       // Add phi entries for newly created values to all exit blocks.
-      for (succ_iterator SI = succ_begin(*BB), SE = succ_end(*BB);
+      for (succ_iterator SI = succ_begin(OrigBB), SE = succ_end(OrigBB);
            SI != SE; ++SI) {
         if (L->contains(*SI))
           continue;
         for (BasicBlock::iterator BBI = (*SI)->begin();
              PHINode *phi = dyn_cast<PHINode>(BBI); ++BBI) {
-          Value *Incoming = phi->getIncomingValueForBlock(*BB);
-          ValueToValueMapTy::iterator It = LastValueMap.find(Incoming);
-          if (It != LastValueMap.end())
-            Incoming = It->second;
+          Value *Incoming = phi->getIncomingValueForBlock(OrigBB);
+          ValueToValueMapTy::iterator VI = VMap.find(Incoming);
+          if (VI != VMap.end())
+            Incoming = VI->second;
           phi->addIncoming(Incoming, New);
         }
       }
-      // Keep track of new headers and latches as we create them, so that
-      // we can insert the proper branches later.
-      if (*BB == Header)
-        Headers.push_back(New);
-      if (*BB == LatchBlock)
-        Latches.push_back(New);
-
-      NewBlocks.push_back(New);
     }
 
-    // Remap all instructions in the most recent iteration
-    for (unsigned i = 0; i < NewBlocks.size(); ++i)
-      for (BasicBlock::iterator I = NewBlocks[i]->begin(),
-           E = NewBlocks[i]->end(); I != E; ++I)
-        ::RemapInstruction(I, LastValueMap);
+    // Remap all instructions in this iteration.
+    for (unsigned i = 0, e = NewBlocks[It].size(); i != e; ++i)
+      for (BasicBlock::iterator I = NewBlocks[It][i]->begin(),
+           E = NewBlocks[It][i]->end(); I != E; ++I)
+        ::RemapInstruction(I, VMap);
   }
 
   // Loop over the PHI nodes in the original block, setting incoming values.
@@ -340,13 +364,16 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount,
       // last iteration of the loop.
       if (Instruction *InValI = dyn_cast<Instruction>(InVal)) {
         if (L->contains(InValI))
-          InVal = LastValueMap[InVal];
+          InVal = (*IterationMaps[Count-1])[InVal];
       }
-      assert(Latches.back() == LastValueMap[LatchBlock] && "bad last latch");
+      assert(Latches.back() == (*IterationMaps[Count-1])[LatchBlock] &&
+             "bad last latch");
       PN->addIncoming(InVal, Latches.back());
     }
   }
 
+  DeleteContainerPointers(IterationMaps);
+
   // Now that all the basic blocks for the unrolled iterations are in place,
   // set up the branches to connect them.
   for (unsigned i = 0, e = Latches.size(); i != e; ++i) {
@@ -404,7 +431,9 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount,
     BranchInst *Term = cast<BranchInst>(Latches[i]->getTerminator());
     if (Term->isUnconditional()) {
       BasicBlock *Dest = Term->getSuccessor(0);
-      if (BasicBlock *Fold = FoldBlockIntoPredecessor(Dest, LI, LPM))
+      // ScalarEvolution was already told to forget this loop above; don't
+      // have each fold walk the now much larger body forgetting it again.
+      if (BasicBlock *Fold = FoldBlockIntoPredecessor(Dest, LI, LPM, L))
         std::replace(Latches.begin(), Latches.end(), Dest, Fold);
     }
   }
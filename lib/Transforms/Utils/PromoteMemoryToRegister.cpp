@@ -246,8 +246,6 @@ namespace {
     /// DomLevels - Maps DomTreeNodes to their level in the dominator tree.
     DenseMap<DomTreeNode*, unsigned> DomLevels;
 
-    /// BBNumPreds - Lazily compute the number of predecessors a block has.
-    DenseMap<const BasicBlock*, unsigned> BBNumPreds;
   public:
     PromoteMem2Reg(const std::vector<AllocaInst*> &A, DominatorTree &dt,
                    AliasSetTracker *ast)
@@ -272,10 +270,7 @@ namespace {
     }
 
     unsigned getNumPreds(const BasicBlock *BB) {
-      unsigned &NP = BBNumPreds[BB];
-      if (NP == 0)
-        NP = std::distance(pred_begin(BB), pred_end(BB))+1;
-      return NP-1;
+      return BB->getNumPredecessors();
     }
 
     void DetermineInsertionPoint(AllocaInst *AI, unsigned AllocaNum,
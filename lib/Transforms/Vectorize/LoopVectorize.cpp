@@ -100,6 +100,16 @@ static cl::opt<bool>
 EnableIfConversion("enable-if-conversion", cl::init(true), cl::Hidden,
                    cl::desc("Enable if-conversion during vectorization."));
 
+static cl::opt<bool>
+EnableInterleavedMemAccesses("enable-interleaved-mem-accesses",
+                   cl::init(false), cl::Hidden,
+                   cl::desc("Vectorize full groups of interleaved strided "
+                            "loads with wide loads and shuffles."));
+
+/// The largest interleave factor we form groups for.  Larger factors produce
+/// shuffle sequences no current target digests profitably.
+static const unsigned MaxInterleaveFactor = 8;
+
 /// We don't vectorize loops with a known constant trip count below this number.
 static cl::opt<unsigned>
 TinyTripCountVectorThreshold("vectorizer-min-trip-count", cl::init(16),
@@ -196,6 +206,13 @@ private:
   void vectorizeMemoryInstruction(Instruction *Instr,
                                   LoopVectorizationLegality *Legal);
 
+  /// Vectorize the interleave group that Instr belongs to with one wide load
+  /// and a strided shuffle per member.  All codegen for the group happens
+  /// when its first member is visited; later members find their entries
+  /// already widened.
+  void vectorizeInterleaveGroup(Instruction *Instr,
+                                LoopVectorizationLegality *Legal);
+
   /// Create a broadcast instruction. This method generates a broadcast
   /// instruction (shuffle) for loop invariant values and for the induction
   /// value. If this is the induction variable then we extend it to N, N+1, ...
@@ -322,6 +339,11 @@ public:
                             DominatorTree *DT)
       : TheLoop(L), SE(SE), DL(DL), DT(DT), Induction(0) {}
 
+  ~LoopVectorizationLegality() {
+    for (unsigned i = 0, e = InterleaveGroups.size(); i != e; ++i)
+      delete InterleaveGroups[i];
+  }
+
   /// This enum represents the kinds of reductions that we support.
   enum ReductionKind {
     RK_NoReduction, ///< Not a reduction.
@@ -443,6 +465,33 @@ public:
 
   /// Returns the information that we collected about runtime memory check.
   RuntimePointerCheck *getRuntimePointerCheck() { return &PtrRtCheck; }
+
+  /// InterleaveGroup - A complete set of strided loads over one array where
+  /// member i reads element Factor*n + i on iteration n.  Because every
+  /// index in [0, Factor) is covered, one wide load of Factor*VF elements
+  /// touches exactly the bytes the members touch, and each member's vector
+  /// value is a strided shuffle of it.
+  struct InterleaveGroup {
+    /// The interleave factor, i.e. the stride of the members in elements.
+    unsigned Factor;
+    /// The alignment of the index-0 member's address, used for the wide load.
+    unsigned Align;
+    /// The interleave index of InsertPos.
+    unsigned InsertIndex;
+    /// The first member in program order; codegen for the whole group is
+    /// anchored here so that every member's operands are already widened.
+    Instruction *InsertPos;
+    /// All members, indexed by their interleave index.
+    SmallVector<Instruction*, 8> Members;
+  };
+
+  /// Return the interleave group I is a member of, or null.
+  InterleaveGroup *getInterleaveGroup(Instruction *I) {
+    DenseMap<Instruction*, InterleaveGroup*>::iterator It =
+      InterleaveMap.find(I);
+    return It == InterleaveMap.end() ? 0 : It->second;
+  }
+
 private:
   /// Check if a single basic block loop is vectorizable.
   /// At this point we know that this is a loop with a constant trip count
@@ -462,6 +511,11 @@ private:
   /// Collect the variables that need to stay uniform after vectorization.
   void collectLoopUniforms();
 
+  /// Find complete groups of interleaved strided loads that can be widened
+  /// into one wide load plus shuffles.  Only called once the loop has passed
+  /// the memory legality checks.
+  void collectInterleaveGroups();
+
   /// Return true if all of the instructions in the block can be speculatively
   /// executed.
   bool blockCanBePredicated(BasicBlock *BB);
@@ -508,6 +562,10 @@ private:
   /// We need to check that all of the pointers in this list are disjoint
   /// at runtime.
   RuntimePointerCheck PtrRtCheck;
+  /// The interleave groups found in the loop.  Owned by this object.
+  SmallVector<InterleaveGroup*, 4> InterleaveGroups;
+  /// Maps each member load to its interleave group.
+  DenseMap<Instruction*, InterleaveGroup*> InterleaveMap;
 };
 
 /// LoopVectorizationCostModel - estimates the expected speedups due to
@@ -519,11 +577,19 @@ private:
 /// different operations.
 class LoopVectorizationCostModel {
 public:
+  /// Memo table for TTI cost queries whose answer depends only on the opcode
+  /// and the (already widened) operand types.  The target does not change for
+  /// the lifetime of the pass, so one table is shared across all of the loops
+  /// that a LoopVectorize pass instance visits.
+  typedef DenseMap<std::pair<unsigned, std::pair<Type*, Type*> >,
+                   unsigned> CostTableTy;
+
   LoopVectorizationCostModel(Loop *L, ScalarEvolution *SE, LoopInfo *LI,
                              LoopVectorizationLegality *Legal,
                              const TargetTransformInfo &TTI,
-                             DataLayout *DL)
-      : TheLoop(L), SE(SE), LI(LI), Legal(Legal), TTI(TTI), DL(DL) {}
+                             DataLayout *DL, CostTableTy &CostTable)
+      : TheLoop(L), SE(SE), LI(LI), Legal(Legal), TTI(TTI), DL(DL),
+        CostTable(CostTable) {}
 
   /// Information about vectorization costs
   struct VectorizationFactor {
@@ -575,6 +641,13 @@ private:
   /// width. Vector width of one means scalar.
   unsigned getInstructionCost(Instruction *I, unsigned VF);
 
+  /// Returns the TTI cost of a binary operator, compare/select or cast,
+  /// consulting the memo table first.  These queries are pure functions of
+  /// \p Opcode and the types, and expectedCost repeats them for every
+  /// occurrence of an (opcode, type) pair in every candidate VF of every
+  /// loop, so the table hit rate is very high on large numeric code.
+  unsigned getMemoizedInstrCost(unsigned Opcode, Type *Ty0, Type *Ty1 = 0);
+
   /// A helper function for converting Scalar types to vector types.
   /// If the incoming type is void, we return void. If the VF is 1, we return
   /// the scalar type.
@@ -596,6 +669,8 @@ private:
   const TargetTransformInfo &TTI;
   /// Target data layout information.
   DataLayout *DL;
+  /// Memoized TTI cost queries, owned by the pass.
+  CostTableTy &CostTable;
 };
 
 /// The LoopVectorize Pass.
@@ -613,6 +688,11 @@ struct LoopVectorize : public LoopPass {
   TargetTransformInfo *TTI;
   DominatorTree *DT;
 
+  /// TTI cost queries memoized across all of the loops that this pass
+  /// instance visits.  TargetTransformInfo is an immutable pass, so the
+  /// answers cannot change between loops (or functions).
+  LoopVectorizationCostModel::CostTableTy TTICostTable;
+
   virtual bool runOnLoop(Loop *L, LPPassManager &LPM) {
     // We only vectorize innermost loops.
     if (!L->empty())
@@ -635,7 +715,7 @@ struct LoopVectorize : public LoopPass {
     }
 
     // Use the cost model.
-    LoopVectorizationCostModel CM(L, SE, LI, &LVL, *TTI, DL);
+    LoopVectorizationCostModel CM(L, SE, LI, &LVL, *TTI, DL, TTICostTable);
 
     // Check the function attribues to find out if this function should be
     // optimized for size.
@@ -855,6 +935,61 @@ Value *InnerLoopVectorizer::reverseVector(Value *Vec) {
 }
 
 
+void InnerLoopVectorizer::vectorizeInterleaveGroup(Instruction *Instr,
+                                             LoopVectorizationLegality *Legal) {
+  LoopVectorizationLegality::InterleaveGroup *IG =
+    Legal->getInterleaveGroup(Instr);
+  assert(IG && "Not a member of an interleave group");
+
+  // The whole group is emitted when its first member is visited; the other
+  // members find their WidenMap entries already filled in.
+  if (Instr != IG->InsertPos)
+    return;
+
+  LoadInst *LI = cast<LoadInst>(Instr);
+  unsigned Factor = IG->Factor;
+  Type *ScalarDataTy = LI->getType();
+  VectorType *WideDataTy = VectorType::get(ScalarDataTy, VF * Factor);
+
+  // Build the scalar address of this member for the current vector iteration
+  // by cloning its GEP with lane zero of the widened last index, exactly like
+  // the consecutive case, then step down to the index-0 element of the group.
+  GetElementPtrInst *Gep = cast<GetElementPtrInst>(LI->getPointerOperand());
+  unsigned NumOperands = Gep->getNumOperands();
+  VectorParts &GEPParts = getVectorValue(Gep->getOperand(NumOperands - 1));
+  Value *LastIndex = Builder.CreateExtractElement(GEPParts[0],
+                                                  Builder.getInt32(0));
+  GetElementPtrInst *Gep2 = cast<GetElementPtrInst>(Gep->clone());
+  Gep2->setOperand(NumOperands - 1, LastIndex);
+  Gep2->setName("gep.interleave.base");
+  Value *Ptr = Builder.Insert(Gep2);
+  if (IG->InsertIndex)
+    Ptr = Builder.CreateGEP(Ptr, Builder.getInt32(-(int)IG->InsertIndex),
+                            "interleave.base");
+
+  unsigned AS = Gep->getPointerAddressSpace();
+  for (unsigned Part = 0; Part < UF; ++Part) {
+    // Each unroll part reads the next VF * Factor elements.
+    Value *PartPtr = Builder.CreateGEP(Ptr,
+                                       Builder.getInt32(Part * VF * Factor));
+    Value *VecPtr = Builder.CreateBitCast(PartPtr,
+                                          WideDataTy->getPointerTo(AS));
+    Value *WideLoad = Builder.CreateLoad(VecPtr, "wide.vec");
+    cast<LoadInst>(WideLoad)->setAlignment(IG->Align);
+
+    // De-interleave: member i takes lanes i, i + Factor, i + 2*Factor, ...
+    for (unsigned i = 0; i != Factor; ++i) {
+      SmallVector<Constant*, 8> Mask;
+      for (unsigned Lane = 0; Lane != VF; ++Lane)
+        Mask.push_back(Builder.getInt32(i + Lane * Factor));
+      Value *Strided =
+        Builder.CreateShuffleVector(WideLoad, UndefValue::get(WideDataTy),
+                                    ConstantVector::get(Mask), "strided.vec");
+      WidenMap.get(IG->Members[i])[Part] = Strided;
+    }
+  }
+}
+
 void InnerLoopVectorizer::vectorizeMemoryInstruction(Instruction *Instr,
                                              LoopVectorizationLegality *Legal) {
   // Attempt to issue a wide load.
@@ -863,6 +998,11 @@ void InnerLoopVectorizer::vectorizeMemoryInstruction(Instruction *Instr,
 
   assert((LI || SI) && "Invalid Load/Store instruction");
 
+  // Loads that belong to an interleave group are widened together with the
+  // rest of their group.
+  if (LI && VF > 1 && Legal->getInterleaveGroup(Instr))
+    return vectorizeInterleaveGroup(Instr, Legal);
+
   Type *ScalarDataTy = LI ? LI->getType() : SI->getValueOperand()->getType();
   Type *DataTy = VectorType::get(ScalarDataTy, VF);
   Value *Ptr = LI ? LI->getPointerOperand() : SI->getPointerOperand();
@@ -939,8 +1079,10 @@ void InnerLoopVectorizer::vectorizeMemoryInstruction(Instruction *Instr,
       Value *VecPtr = Builder.CreateBitCast(PartPtr, DataTy->getPointerTo());
       Builder.CreateStore(StoredVal[Part], VecPtr)->setAlignment(Alignment);
     }
+    return;
   }
 
+  // Handle loads.
   for (unsigned Part = 0; Part < UF; ++Part) {
     // Calculate the pointer for the specific unroll-part.
     Value *PartPtr = Builder.CreateGEP(Ptr, Builder.getInt32(Part * VF));
@@ -2033,7 +2175,7 @@ bool LoopVectorizationLegality::canVectorizeWithIfConvert() {
 
     // We must have at most two predecessors because we need to convert
     // all PHIs to selects.
-    unsigned Preds = std::distance(pred_begin(BB), pred_end(BB));
+    unsigned Preds = BB->getNumPredecessors();
     if (Preds > 2)
       return false;
 
@@ -2101,6 +2243,10 @@ bool LoopVectorizationLegality::canVectorize() {
     return false;
   }
 
+  // Now that the memory legality checks have passed, look for groups of
+  // interleaved strided loads that we can widen.
+  collectInterleaveGroups();
+
   // Collect all of the variables that remain uniform after vectorization.
   collectLoopUniforms();
 
@@ -2246,6 +2392,183 @@ bool LoopVectorizationLegality::canVectorizeInstrs() {
   return true;
 }
 
+namespace {
+/// ProtoInterleaveGroup - An interleave group under construction.  Slots may
+/// still be empty; only groups with every slot filled are kept.
+struct ProtoInterleaveGroup {
+  const SCEV *BaseStart;  ///< Pointer start SCEV of the index-0 slot.
+  int64_t Size;           ///< Element size in bytes.
+  unsigned Factor;
+  Type *ElemTy;
+  SmallVector<Instruction*, 8> Members;  ///< Slot-indexed; null means a hole.
+
+  ProtoInterleaveGroup(const SCEV *Start, int64_t Size, unsigned Factor,
+                       Type *ElemTy)
+    : BaseStart(Start), Size(Size), Factor(Factor), ElemTy(ElemTy),
+      Members(Factor, (Instruction*)0) {}
+};
+} // end anonymous namespace
+
+void LoopVectorizationLegality::collectInterleaveGroups() {
+  if (!EnableInterleavedMemAccesses || !DL)
+    return;
+
+  // Gather candidates per block.  Groups never span blocks: program order
+  // within one block gives us the insert position and makes the
+  // no-intervening-store check below a single linear scan.
+  for (Loop::block_iterator bb = TheLoop->block_begin(),
+       be = TheLoop->block_end(); bb != be; ++bb) {
+    BasicBlock *BB = *bb;
+    // Loads in predicated blocks do not execute on every iteration; a wide
+    // load would.
+    if (blockNeedsPredication(BB))
+      continue;
+
+    SmallVector<ProtoInterleaveGroup*, 4> Protos;
+    for (BasicBlock::iterator it = BB->begin(), e = BB->end(); it != e; ++it) {
+      LoadInst *Ld = dyn_cast<LoadInst>(it);
+      if (!Ld || !Ld->isSimple())
+        continue;
+      Type *ElemTy = Ld->getType();
+      if (ElemTy->isAggregateType() || ElemTy->isVectorTy())
+        continue;
+
+      // We only handle the same GEP shape the consecutive-pointer path
+      // handles: a loop-invariant base, loop-invariant leading indices, and a
+      // strided last index, so codegen can clone the GEP with a scalar index.
+      GetElementPtrInst *Gep = dyn_cast<GetElementPtrInst>(
+          Ld->getPointerOperand());
+      if (!Gep || cast<PointerType>(Gep->getType())->getElementType() != ElemTy)
+        continue;
+      if (!SE->isLoopInvariant(SE->getSCEV(Gep->getPointerOperand()), TheLoop))
+        continue;
+      unsigned NumOperands = Gep->getNumOperands();
+      bool InvariantIndices = true;
+      for (unsigned i = 1; i < NumOperands - 1; ++i)
+        if (!SE->isLoopInvariant(SE->getSCEV(Gep->getOperand(i)), TheLoop))
+          InvariantIndices = false;
+      if (!InvariantIndices || !isa<Instruction>(Gep->getOperand(NumOperands-1)))
+        continue;
+
+      // The pointer must advance by a small positive constant multiple of the
+      // element size every iteration.
+      const SCEVAddRecExpr *PtrAR =
+        dyn_cast<SCEVAddRecExpr>(SE->getSCEV(Gep));
+      if (!PtrAR || PtrAR->getLoop() != TheLoop || !PtrAR->isAffine())
+        continue;
+      const SCEVConstant *StepC =
+        dyn_cast<SCEVConstant>(PtrAR->getStepRecurrence(*SE));
+      if (!StepC)
+        continue;
+      int64_t Step = StepC->getValue()->getSExtValue();
+      int64_t Size = DL->getTypeAllocSize(ElemTy);
+      if (Size <= 0 || Step <= Size || Step % Size)
+        continue;
+      int64_t Factor = Step / Size;
+      if (Factor > (int64_t)MaxInterleaveFactor)
+        continue;
+      const SCEV *Start = PtrAR->getStart();
+
+      // Join an existing proto-group whose base differs from this load by a
+      // constant number of elements below the factor, or start a new one.
+      bool Joined = false;
+      for (unsigned g = 0, ge = Protos.size(); g != ge && !Joined; ++g) {
+        ProtoInterleaveGroup &P = *Protos[g];
+        if (P.Factor != (unsigned)Factor || P.Size != Size ||
+            P.ElemTy != ElemTy)
+          continue;
+        const SCEVConstant *Delta =
+          dyn_cast<SCEVConstant>(SE->getMinusSCEV(Start, P.BaseStart));
+        if (!Delta)
+          continue;
+        int64_t Off = Delta->getValue()->getSExtValue();
+        if (Off % Size)
+          continue;
+        int64_t Slot = Off / Size;
+        if (Slot < 0) {
+          // This load sits below the presumed base; shift the group so it
+          // becomes slot zero, unless a member would fall off the end.
+          int64_t Shift = -Slot;
+          bool Fits = true;
+          for (unsigned i = 0; i != P.Factor; ++i)
+            if (P.Members[i] && i + Shift >= P.Factor)
+              Fits = false;
+          if (!Fits)
+            continue;
+          for (int64_t i = P.Factor - 1; i >= Shift; --i) {
+            P.Members[i] = P.Members[i - Shift];
+            P.Members[i - Shift] = 0;
+          }
+          P.BaseStart = Start;
+          Slot = 0;
+        }
+        if (Slot >= (int64_t)P.Factor || P.Members[Slot])
+          continue;
+        P.Members[Slot] = Ld;
+        Joined = true;
+      }
+      if (!Joined) {
+        Protos.push_back(new ProtoInterleaveGroup(Start, Size, Factor, ElemTy));
+        Protos.back()->Members[0] = Ld;
+      }
+    }
+
+    // Keep the complete groups.
+    for (unsigned g = 0, ge = Protos.size(); g != ge; ++g) {
+      ProtoInterleaveGroup &P = *Protos[g];
+      bool Full = true;
+      for (unsigned i = 0; i != P.Factor; ++i)
+        if (!P.Members[i])
+          Full = false;
+
+      if (Full) {
+        // Find the first and last member in program order, and make sure
+        // nothing between them may write memory: codegen hoists every member
+        // up to the first one.
+        Instruction *First = 0, *Last = 0;
+        unsigned FirstSlot = 0, Seen = 0;
+        bool Clobbered = false;
+        for (BasicBlock::iterator it = BB->begin();
+             Seen != P.Factor; ++it) {
+          unsigned Slot = P.Factor;
+          for (unsigned i = 0; i != P.Factor; ++i)
+            if (P.Members[i] == it)
+              Slot = i;
+          if (Slot != P.Factor) {
+            if (!First) {
+              First = it;
+              FirstSlot = Slot;
+            }
+            Last = it;
+            ++Seen;
+          } else if (First && it->mayWriteToMemory()) {
+            Clobbered = true;
+            break;
+          }
+        }
+        (void)Last;
+
+        if (!Clobbered) {
+          InterleaveGroup *IG = new InterleaveGroup();
+          IG->Factor = P.Factor;
+          IG->InsertIndex = FirstSlot;
+          IG->InsertPos = First;
+          IG->Members = P.Members;
+          IG->Align = cast<LoadInst>(P.Members[0])->getAlignment();
+          if (!IG->Align)
+            IG->Align = DL->getABITypeAlignment(P.ElemTy);
+          InterleaveGroups.push_back(IG);
+          for (unsigned i = 0; i != P.Factor; ++i)
+            InterleaveMap[P.Members[i]] = IG;
+          DEBUG(dbgs() << "LV: Found an interleave group with factor "
+                       << P.Factor << ":" << *First << "\n");
+        }
+      }
+      delete Protos[g];
+    }
+  }
+}
+
 void LoopVectorizationLegality::collectLoopUniforms() {
   // We now know that the loop is vectorizable!
   // Collect variables that will remain uniform after vectorization.
@@ -3043,6 +3366,27 @@ unsigned LoopVectorizationCostModel::expectedCost(unsigned VF) {
   return Cost;
 }
 
+unsigned
+LoopVectorizationCostModel::getMemoizedInstrCost(unsigned Opcode, Type *Ty0,
+                                                 Type *Ty1) {
+  std::pair<unsigned, std::pair<Type*, Type*> > Key(Opcode,
+                                                    std::make_pair(Ty0, Ty1));
+  CostTableTy::iterator It = CostTable.find(Key);
+  if (It != CostTable.end())
+    return It->second;
+
+  unsigned Cost;
+  if (Instruction::isBinaryOp(Opcode))
+    Cost = TTI.getArithmeticInstrCost(Opcode, Ty0);
+  else if (Instruction::isCast(Opcode))
+    Cost = TTI.getCastInstrCost(Opcode, Ty0, Ty1);
+  else
+    Cost = TTI.getCmpSelInstrCost(Opcode, Ty0, Ty1);
+
+  CostTable[Key] = Cost;
+  return Cost;
+}
+
 unsigned
 LoopVectorizationCostModel::getInstructionCost(Instruction *I, unsigned VF) {
   // If we know that this instruction will remain uniform, check the cost of
@@ -3084,7 +3428,7 @@ LoopVectorizationCostModel::getInstructionCost(Instruction *I, unsigned VF) {
   case Instruction::And:
   case Instruction::Or:
   case Instruction::Xor:
-    return TTI.getArithmeticInstrCost(I->getOpcode(), VectorTy);
+    return getMemoizedInstrCost(I->getOpcode(), VectorTy);
   case Instruction::Select: {
     SelectInst *SI = cast<SelectInst>(I);
     const SCEV *CondSCEV = SE->getSCEV(SI->getCondition());
@@ -3093,13 +3437,13 @@ LoopVectorizationCostModel::getInstructionCost(Instruction *I, unsigned VF) {
     if (ScalarCond)
       CondTy = VectorType::get(CondTy, VF);
 
-    return TTI.getCmpSelInstrCost(I->getOpcode(), VectorTy, CondTy);
+    return getMemoizedInstrCost(I->getOpcode(), VectorTy, CondTy);
   }
   case Instruction::ICmp:
   case Instruction::FCmp: {
     Type *ValTy = I->getOperand(0)->getType();
     VectorTy = ToVectorTy(ValTy, VF);
-    return TTI.getCmpSelInstrCost(I->getOpcode(), VectorTy);
+    return getMemoizedInstrCost(I->getOpcode(), VectorTy);
   }
   case Instruction::Store:
   case Instruction::Load: {
@@ -3117,6 +3461,24 @@ LoopVectorizationCostModel::getInstructionCost(Instruction *I, unsigned VF) {
     if (VF == 1)
       return TTI.getMemoryOpCost(I->getOpcode(), VectorTy, Alignment, AS);
 
+    // Interleaved loads.  The whole group is priced at its insert position:
+    // one wide load plus a strided shuffle per member.  The other members
+    // are free.
+    if (LoopVectorizationLegality::InterleaveGroup *IG =
+          LI ? Legal->getInterleaveGroup(I) : 0) {
+      if (I != IG->InsertPos)
+        return 0;
+      Type *WideVecTy = VectorType::get(ValTy, VF * IG->Factor);
+      unsigned Cost = TTI.getMemoryOpCost(I->getOpcode(), WideVecTy,
+                                          IG->Align, AS);
+      // There is no strided shuffle kind; subvector extraction is the
+      // closest-priced single-source shuffle.
+      for (unsigned i = 0; i != IG->Factor; ++i)
+        Cost += TTI.getShuffleCost(TargetTransformInfo::SK_ExtractSubvector,
+                                   WideVecTy, i * VF, VectorTy);
+      return Cost;
+    }
+
     // Scalarized loads/stores.
     int Stride = Legal->isConsecutivePtr(Ptr);
     bool Reverse = Stride < 0;
@@ -3169,7 +3531,7 @@ LoopVectorizationCostModel::getInstructionCost(Instruction *I, unsigned VF) {
                                   I->getOperand(0)->getType());
 
     Type *SrcVecTy = ToVectorTy(I->getOperand(0)->getType(), VF);
-    return TTI.getCastInstrCost(I->getOpcode(), VectorTy, SrcVecTy);
+    return getMemoizedInstrCost(I->getOpcode(), VectorTy, SrcVecTy);
   }
   case Instruction::Call: {
     assert(isTriviallyVectorizableIntrinsic(I));
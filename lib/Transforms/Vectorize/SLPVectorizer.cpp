@@ -0,0 +1,573 @@
+//===- SLPVectorizer.cpp - A bottom up SLP Vectorizer ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// This pass implements the Bottom Up SLP vectorizer. It detects consecutive
+// stores that can be put together into vector-stores. Next, it attempts to
+// construct vectorizable trees using the use-def chains that feed the stores.
+// If a profitable tree was found, the SLP vectorizer performs vectorization
+// on the tree.
+//
+// The pass is inspired by the work described in the paper:
+//  "Loop-Aware SLP in GCC" by Ira Rosen, Dorit Nuzman, Ayal Zaks.
+//
+//===----------------------------------------------------------------------===//
+#define SV_NAME "slp-vectorizer"
+#define DEBUG_TYPE SV_NAME
+
+#include "llvm/Transforms/Vectorize.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Type.h"
+#include "llvm/IR/Value.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <map>
+
+using namespace llvm;
+
+static cl::opt<int>
+SLPCostThreshold("slp-threshold", cl::init(0), cl::Hidden,
+                 cl::desc("Only vectorize trees if the gain is above this "
+                          "number. (gain = -cost of vectorization)"));
+
+STATISTIC(NumVectorInstructions, "Number of vector instructions generated");
+
+namespace {
+
+/// Maximum recursion depth when building a vectorizable tree.
+static const unsigned RecursionMaxDepth = 12;
+
+/// A cost that is known to make a tree unprofitable; used when a bundle of
+/// scalars cannot be vectorized at all.
+static const int MaxCost = 1 << 20;
+
+/// BoUpSLP - The bottom-up SLP builder.  It scans one basic block for chains
+/// of consecutive stores, builds a tree of vectorizable scalars rooted at
+/// each chain by walking the use-def edges bottom up, costs the tree using
+/// the target cost model, and emits vector code when that is profitable.
+class BoUpSLP {
+public:
+  typedef SmallVector<Value *, 8> ValueList;
+
+  BoUpSLP(BasicBlock *BB, AliasAnalysis *AA, TargetTransformInfo *TTI,
+          DataLayout *DL)
+    : BB(BB), AA(AA), TTI(TTI), DL(DL), Builder(BB->getContext()) {
+    // Number the instructions in the block so that we can quickly compare
+    // program order and scan scheduling windows.
+    unsigned Loc = 0;
+    for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I)
+      InstrIdx[I] = Loc++;
+  }
+
+  /// vectorizeStoreChains - Find chains of consecutive stores in the block
+  /// and try to vectorize them.  Returns true if the block was modified.
+  bool vectorizeStoreChains();
+
+private:
+  /// The kind of vector value that a bundle of scalars can become.
+  enum BundleKind {
+    BK_Splat,     ///< All scalars are the same value; emit a splat.
+    BK_Constant,  ///< All scalars are constants; emit a constant vector.
+    BK_Load,      ///< Consecutive loads; emit a wide load.
+    BK_BinOp,     ///< Isomorphic binary operators; vectorize the operands.
+    BK_Gather     ///< Anything else; emit an insertelement sequence.
+  };
+
+  /// getBundleKind - Classify the bundle \p VL.  Must be kept in sync between
+  /// the costing walk and the emission walk.
+  BundleKind getBundleKind(ArrayRef<Value *> VL, unsigned Depth);
+
+  /// getBundleCost - Return the cost of vectorizing the bundle \p VL minus
+  /// the cost of the scalars it replaces, and record the scalars that become
+  /// part of the tree.  Returns MaxCost if the bundle must not be vectorized.
+  int getBundleCost(ArrayRef<Value *> VL, unsigned Depth);
+
+  /// vectorizeBundle - Emit the vector value for the bundle \p VL at the
+  /// current builder insertion point.
+  Value *vectorizeBundle(ArrayRef<Value *> VL, unsigned Depth);
+
+  /// vectorizeStoreChain - Try to vectorize one run of consecutive stores.
+  /// Returns the number of stores that were combined (zero on failure).
+  unsigned vectorizeStoreChain(ArrayRef<StoreInst *> Chain);
+
+  /// isConsecutiveAccess - Return true if \p B accesses the memory location
+  /// immediately following the one accessed by \p A.
+  bool isConsecutiveAccess(Value *PtrA, Value *PtrB, Type *Ty);
+
+  /// isSafeToScheduleTree - Verify that the memory operations in the tree can
+  /// all be moved to the position of the last store in \p Seeds without
+  /// conflicting with the instructions in between.
+  bool isSafeToScheduleTree(ArrayRef<StoreInst *> Seeds);
+
+  /// getVecTy - Return the vector type for \p VL.
+  VectorType *getVecTy(ArrayRef<Value *> VL) {
+    return VectorType::get(VL[0]->getType(), VL.size());
+  }
+
+  /// getLastSeed - Return the seed store that comes last in program order.
+  /// The seeds are sorted by address, which need not match program order.
+  StoreInst *getLastSeed(ArrayRef<StoreInst *> Seeds) {
+    StoreInst *Last = Seeds[0];
+    for (unsigned i = 1, e = Seeds.size(); i != e; ++i)
+      if (InstrIdx[Seeds[i]] > InstrIdx[Last])
+        Last = Seeds[i];
+    return Last;
+  }
+
+  BasicBlock *BB;
+  AliasAnalysis *AA;
+  TargetTransformInfo *TTI;
+  DataLayout *DL;
+  IRBuilder<> Builder;
+
+  /// Numbering of the instructions in BB, in program order.
+  DenseMap<Instruction *, unsigned> InstrIdx;
+
+  /// The scalars that the current tree replaces, collected while costing.
+  SmallPtrSet<Instruction *, 16> TreeScalars;
+  /// The loads in the current tree, for the scheduling legality check.
+  SmallVector<LoadInst *, 8> TreeLoads;
+  /// The lowest instruction number in the current tree.
+  unsigned TreeFirstIdx;
+};
+
+/// getSameOpcode - Return the common opcode of the instructions in \p VL, or
+/// zero if they are not all binary operators with the same opcode.
+static unsigned getSameOpcode(ArrayRef<Value *> VL) {
+  BinaryOperator *B0 = dyn_cast<BinaryOperator>(VL[0]);
+  if (!B0)
+    return 0;
+  for (unsigned i = 1, e = VL.size(); i != e; ++i) {
+    BinaryOperator *B = dyn_cast<BinaryOperator>(VL[i]);
+    if (!B || B->getOpcode() != B0->getOpcode())
+      return 0;
+  }
+  return B0->getOpcode();
+}
+
+/// allDistinct - Return true if no value appears twice in \p VL.
+static bool allDistinct(ArrayRef<Value *> VL) {
+  SmallPtrSet<Value *, 8> Seen;
+  for (unsigned i = 0, e = VL.size(); i != e; ++i)
+    if (!Seen.insert(VL[i]))
+      return false;
+  return true;
+}
+
+bool BoUpSLP::isConsecutiveAccess(Value *PtrA, Value *PtrB, Type *Ty) {
+  int64_t OffsetA = 0, OffsetB = 0;
+  Value *BaseA = GetPointerBaseWithConstantOffset(PtrA, OffsetA, DL);
+  Value *BaseB = GetPointerBaseWithConstantOffset(PtrB, OffsetB, DL);
+  if (BaseA != BaseB)
+    return false;
+  return OffsetB - OffsetA == (int64_t)DL->getTypeStoreSize(Ty);
+}
+
+BoUpSLP::BundleKind BoUpSLP::getBundleKind(ArrayRef<Value *> VL,
+                                           unsigned Depth) {
+  // A bundle of identical values becomes a splat, and one of constants a
+  // constant vector.  Neither needs any scalars to be removed.
+  bool AllSame = true, AllConst = true;
+  for (unsigned i = 0, e = VL.size(); i != e; ++i) {
+    AllSame &= VL[i] == VL[0];
+    AllConst &= isa<Constant>(VL[i]);
+  }
+  if (AllConst)
+    return BK_Constant;
+  if (AllSame)
+    return BK_Splat;
+
+  if (Depth == RecursionMaxDepth || !allDistinct(VL))
+    return BK_Gather;
+
+  // Every scalar that we replace must be an instruction in our block so that
+  // the scheduling check below can reason about it.
+  for (unsigned i = 0, e = VL.size(); i != e; ++i) {
+    Instruction *I = dyn_cast<Instruction>(VL[i]);
+    if (!I || I->getParent() != BB)
+      return BK_Gather;
+  }
+
+  // Consecutive simple loads become a single wide load.
+  if (isa<LoadInst>(VL[0])) {
+    for (unsigned i = 0, e = VL.size(); i != e; ++i) {
+      LoadInst *L = dyn_cast<LoadInst>(VL[i]);
+      if (!L || !L->isSimple())
+        return BK_Gather;
+      if (i && !isConsecutiveAccess(cast<LoadInst>(VL[i - 1])->getPointerOperand(),
+                                    L->getPointerOperand(), L->getType()))
+        return BK_Gather;
+    }
+    return BK_Load;
+  }
+
+  // Isomorphic single-use binary operators are vectorized by recursively
+  // vectorizing their operand bundles.
+  if (getSameOpcode(VL)) {
+    for (unsigned i = 0, e = VL.size(); i != e; ++i)
+      if (!VL[i]->hasOneUse())
+        return BK_Gather;
+    return BK_BinOp;
+  }
+
+  return BK_Gather;
+}
+
+int BoUpSLP::getBundleCost(ArrayRef<Value *> VL, unsigned Depth) {
+  Type *ScalarTy = VL[0]->getType();
+  for (unsigned i = 1, e = VL.size(); i != e; ++i)
+    if (VL[i]->getType() != ScalarTy)
+      return MaxCost;
+  if (!VectorType::isValidElementType(ScalarTy))
+    return MaxCost;
+  VectorType *VecTy = getVecTy(VL);
+
+  switch (getBundleKind(VL, Depth)) {
+  case BK_Constant:
+    return 0;
+  case BK_Splat:
+    return TTI->getShuffleCost(TargetTransformInfo::SK_Broadcast, VecTy);
+  case BK_Load: {
+    LoadInst *L0 = cast<LoadInst>(VL[0]);
+    for (unsigned i = 0, e = VL.size(); i != e; ++i) {
+      LoadInst *L = cast<LoadInst>(VL[i]);
+      TreeScalars.insert(L);
+      TreeLoads.push_back(L);
+      TreeFirstIdx = std::min(TreeFirstIdx, InstrIdx[L]);
+    }
+    int ScalarCost = VL.size() *
+      TTI->getMemoryOpCost(Instruction::Load, ScalarTy, L0->getAlignment(),
+                           L0->getPointerAddressSpace());
+    int VecCost =
+      TTI->getMemoryOpCost(Instruction::Load, VecTy, L0->getAlignment(),
+                           L0->getPointerAddressSpace());
+    return VecCost - ScalarCost;
+  }
+  case BK_BinOp: {
+    ValueList Left, Right;
+    for (unsigned i = 0, e = VL.size(); i != e; ++i) {
+      Instruction *I = cast<Instruction>(VL[i]);
+      TreeScalars.insert(I);
+      TreeFirstIdx = std::min(TreeFirstIdx, InstrIdx[I]);
+      Left.push_back(I->getOperand(0));
+      Right.push_back(I->getOperand(1));
+    }
+    int LeftCost = getBundleCost(Left, Depth + 1);
+    int RightCost = getBundleCost(Right, Depth + 1);
+    if (LeftCost == MaxCost || RightCost == MaxCost)
+      return MaxCost;
+    unsigned Opcode = cast<Instruction>(VL[0])->getOpcode();
+    int ScalarCost = VL.size() * TTI->getArithmeticInstrCost(Opcode, ScalarTy);
+    int VecCost = TTI->getArithmeticInstrCost(Opcode, VecTy);
+    return LeftCost + RightCost + VecCost - ScalarCost;
+  }
+  case BK_Gather: {
+    int Cost = 0;
+    for (unsigned i = 0, e = VL.size(); i != e; ++i)
+      Cost += TTI->getVectorInstrCost(Instruction::InsertElement, VecTy, i);
+    return Cost;
+  }
+  }
+  llvm_unreachable("Invalid bundle kind");
+}
+
+Value *BoUpSLP::vectorizeBundle(ArrayRef<Value *> VL, unsigned Depth) {
+  VectorType *VecTy = getVecTy(VL);
+
+  switch (getBundleKind(VL, Depth)) {
+  case BK_Constant: {
+    SmallVector<Constant *, 8> Elts;
+    for (unsigned i = 0, e = VL.size(); i != e; ++i)
+      Elts.push_back(cast<Constant>(VL[i]));
+    return ConstantVector::get(Elts);
+  }
+  case BK_Splat:
+    ++NumVectorInstructions;
+    return Builder.CreateVectorSplat(VL.size(), VL[0]);
+  case BK_Load: {
+    LoadInst *L0 = cast<LoadInst>(VL[0]);
+    Value *Ptr = Builder.CreateBitCast(L0->getPointerOperand(),
+                       VecTy->getPointerTo(L0->getPointerAddressSpace()));
+    LoadInst *LI = Builder.CreateLoad(Ptr);
+    LI->setAlignment(L0->getAlignment());
+    ++NumVectorInstructions;
+    return LI;
+  }
+  case BK_BinOp: {
+    ValueList Left, Right;
+    for (unsigned i = 0, e = VL.size(); i != e; ++i) {
+      Instruction *I = cast<Instruction>(VL[i]);
+      Left.push_back(I->getOperand(0));
+      Right.push_back(I->getOperand(1));
+    }
+    Value *L = vectorizeBundle(Left, Depth + 1);
+    Value *R = vectorizeBundle(Right, Depth + 1);
+    ++NumVectorInstructions;
+    return Builder.CreateBinOp(cast<BinaryOperator>(VL[0])->getOpcode(), L, R);
+  }
+  case BK_Gather: {
+    Value *Vec = UndefValue::get(VecTy);
+    for (unsigned i = 0, e = VL.size(); i != e; ++i) {
+      Vec = Builder.CreateInsertElement(Vec, VL[i], Builder.getInt32(i));
+      ++NumVectorInstructions;
+    }
+    return Vec;
+  }
+  }
+  llvm_unreachable("Invalid bundle kind");
+}
+
+bool BoUpSLP::isSafeToScheduleTree(ArrayRef<StoreInst *> Seeds) {
+  // All of the vector code is emitted at the position of the seed store that
+  // comes last in program order, so every memory operation in the window
+  // between the first tree instruction and that store is effectively
+  // reordered with the tree.
+  StoreInst *LastStore = getLastSeed(Seeds);
+
+  BasicBlock::iterator I = LastStore;
+  // Rewind to the first instruction that is part of the tree.
+  while (InstrIdx[I] > TreeFirstIdx)
+    --I;
+
+  for (BasicBlock::iterator E = LastStore; I != E; ++I) {
+    if (TreeScalars.count(I) || std::count(Seeds.begin(), Seeds.end(), &*I))
+      continue;
+    if (!I->mayReadOrWriteMemory())
+      continue;
+
+    if (I->mayWriteToMemory()) {
+      // A write in the window must not clobber any of the tree loads (the
+      // wide load may now execute after it) and must not touch the stored
+      // locations (the scalar stores move down past it).
+      for (unsigned i = 0, e = TreeLoads.size(); i != e; ++i)
+        if (AA->getModRefInfo(I, AA->getLocation(TreeLoads[i])) !=
+            AliasAnalysis::NoModRef)
+          return false;
+      for (unsigned i = 0, e = Seeds.size(); i != e; ++i)
+        if (AA->getModRefInfo(I, AA->getLocation(Seeds[i])) !=
+            AliasAnalysis::NoModRef)
+          return false;
+    } else {
+      // A read in the window must not observe the stored locations, because
+      // the scalar stores that preceded it move down to the vector store.
+      for (unsigned i = 0, e = Seeds.size(); i != e; ++i)
+        if (AA->getModRefInfo(I, AA->getLocation(Seeds[i])) !=
+            AliasAnalysis::NoModRef)
+          return false;
+    }
+  }
+  return true;
+}
+
+unsigned BoUpSLP::vectorizeStoreChain(ArrayRef<StoreInst *> Chain) {
+  StoreInst *S0 = Chain[0];
+  Type *ScalarTy = S0->getValueOperand()->getType();
+  if (!VectorType::isValidElementType(ScalarTy))
+    return 0;
+
+  unsigned ScalarBits = DL->getTypeSizeInBits(ScalarTy);
+  if (!ScalarBits)
+    return 0;
+  unsigned MaxVF = TTI->getRegisterBitWidth(true) / ScalarBits;
+
+  // Use the widest power-of-two number of lanes that both the chain and the
+  // target vector registers allow.
+  unsigned VF = 1;
+  while (VF * 2 <= Chain.size() && VF * 2 <= MaxVF)
+    VF *= 2;
+  if (VF < 2)
+    return 0;
+
+  ArrayRef<StoreInst *> Seeds = Chain.slice(0, VF);
+  TreeScalars.clear();
+  TreeLoads.clear();
+  TreeFirstIdx = InstrIdx[Seeds[0]];
+  for (unsigned i = 0, e = Seeds.size(); i != e; ++i)
+    TreeFirstIdx = std::min(TreeFirstIdx, InstrIdx[Seeds[i]]);
+
+  ValueList Operands;
+  for (unsigned i = 0; i != VF; ++i)
+    Operands.push_back(Seeds[i]->getValueOperand());
+
+  int Cost = getBundleCost(Operands, 0);
+  if (Cost == MaxCost)
+    return 0;
+
+  VectorType *VecTy = VectorType::get(ScalarTy, VF);
+  int ScalarStoreCost = VF *
+    TTI->getMemoryOpCost(Instruction::Store, ScalarTy, S0->getAlignment(),
+                         S0->getPointerAddressSpace());
+  int VecStoreCost =
+    TTI->getMemoryOpCost(Instruction::Store, VecTy, S0->getAlignment(),
+                         S0->getPointerAddressSpace());
+  Cost += VecStoreCost - ScalarStoreCost;
+
+  DEBUG(dbgs() << SV_NAME << ": Found a chain of " << VF
+               << " stores with cost " << Cost << "\n");
+  if (Cost >= -SLPCostThreshold)
+    return 0;
+
+  if (!isSafeToScheduleTree(Seeds))
+    return 0;
+
+  // Emit the vector tree right before the seed store that comes last in
+  // program order, so that every scalar it uses dominates the new code.
+  Builder.SetInsertPoint(getLastSeed(Seeds));
+  Value *Vec = vectorizeBundle(Operands, 0);
+  Value *Ptr = Builder.CreateBitCast(S0->getPointerOperand(),
+                     VecTy->getPointerTo(S0->getPointerAddressSpace()));
+  StoreInst *VS = Builder.CreateStore(Vec, Ptr);
+  VS->setAlignment(S0->getAlignment());
+  ++NumVectorInstructions;
+
+  // Remove the scalar stores, then sweep the tree scalars that died.  Walk
+  // the block backwards so that users are removed before their operands.
+  for (unsigned i = 0; i != VF; ++i)
+    Seeds[i]->eraseFromParent();
+  for (BasicBlock::iterator I = BB->end(); I != BB->begin();) {
+    Instruction *Inst = --I;
+    if (TreeScalars.count(Inst) && Inst->use_empty()) {
+      ++I;
+      Inst->eraseFromParent();
+    }
+  }
+
+  // The block changed; renumber it so that the window checks for the
+  // remaining chains see the new instructions.
+  InstrIdx.clear();
+  unsigned Loc = 0;
+  for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I)
+    InstrIdx[I] = Loc++;
+  return VF;
+}
+
+bool BoUpSLP::vectorizeStoreChains() {
+  // Bucket the simple stores in the block by the underlying object of their
+  // pointer operand.
+  MapVector<Value *, SmallVector<StoreInst *, 8> > StoreBuckets;
+  for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I) {
+    StoreInst *SI = dyn_cast<StoreInst>(I);
+    if (!SI || !SI->isSimple())
+      continue;
+    if (!VectorType::isValidElementType(SI->getValueOperand()->getType()))
+      continue;
+    Value *Base = GetUnderlyingObject(SI->getPointerOperand(), DL);
+    StoreBuckets[Base].push_back(SI);
+  }
+
+  bool Changed = false;
+  for (unsigned Bucket = 0, NumBuckets = StoreBuckets.size();
+       Bucket != NumBuckets; ++Bucket) {
+    SmallVector<StoreInst *, 8> &Stores = StoreBuckets.begin()[Bucket].second;
+    if (Stores.size() < 2)
+      continue;
+
+    // Sort the stores by the constant offset from the common base.  Stores
+    // whose offset is not constant cannot join a chain.
+    std::map<int64_t, StoreInst *> OffsetMap;
+    for (unsigned i = 0, e = Stores.size(); i != e; ++i) {
+      int64_t Offset = 0;
+      GetPointerBaseWithConstantOffset(Stores[i]->getPointerOperand(), Offset,
+                                       DL);
+      // If two stores share an offset keep the first; the second is either
+      // dead or a repeat that a chain cannot contain anyway.
+      if (!OffsetMap.count(Offset))
+        OffsetMap[Offset] = Stores[i];
+    }
+
+    // Walk the stores in address order and collect maximal runs of
+    // consecutive accesses.
+    SmallVector<StoreInst *, 8> Chain;
+    for (std::map<int64_t, StoreInst *>::iterator MI = OffsetMap.begin(),
+         ME = OffsetMap.end(); MI != ME; ++MI) {
+      StoreInst *SI = MI->second;
+      if (!Chain.empty() &&
+          !isConsecutiveAccess(Chain.back()->getPointerOperand(),
+                               SI->getPointerOperand(),
+                               Chain.back()->getValueOperand()->getType())) {
+        if (Chain.size() >= 2)
+          Changed |= vectorizeStoreChain(Chain) != 0;
+        Chain.clear();
+      }
+      Chain.push_back(SI);
+    }
+    if (Chain.size() >= 2)
+      Changed |= vectorizeStoreChain(Chain) != 0;
+  }
+  return Changed;
+}
+
+/// The SLPVectorizer Pass.
+struct SLPVectorizer : public FunctionPass {
+  static char ID; // Pass identification, replacement for typeid
+
+  SLPVectorizer() : FunctionPass(ID) {
+    initializeSLPVectorizerPass(*PassRegistry::getPassRegistry());
+  }
+
+  AliasAnalysis *AA;
+  TargetTransformInfo *TTI;
+  DataLayout *DL;
+
+  virtual bool runOnFunction(Function &F) {
+    AA = &getAnalysis<AliasAnalysis>();
+    TTI = &getAnalysis<TargetTransformInfo>();
+    DL = getAnalysisIfAvailable<DataLayout>();
+
+    // We need the sizes of memory accesses to reason about consecutive
+    // pointers; without target data there is nothing we can do.
+    if (!DL)
+      return false;
+
+    DEBUG(dbgs() << SV_NAME << ": Analyzing blocks in " << F.getName()
+                 << ".\n");
+
+    bool Changed = false;
+    for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+      BoUpSLP R(BB, AA, TTI, DL);
+      Changed |= R.vectorizeStoreChains();
+    }
+    return Changed;
+  }
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    FunctionPass::getAnalysisUsage(AU);
+    AU.addRequired<AliasAnalysis>();
+    AU.addRequired<TargetTransformInfo>();
+    AU.setPreservesCFG();
+  }
+};
+
+} // end anonymous namespace
+
+char SLPVectorizer::ID = 0;
+static const char sv_name[] = "SLP Vectorizer";
+INITIALIZE_PASS_BEGIN(SLPVectorizer, SV_NAME, sv_name, false, false)
+INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
+INITIALIZE_AG_DEPENDENCY(TargetTransformInfo)
+INITIALIZE_PASS_END(SLPVectorizer, SV_NAME, sv_name, false, false)
+
+namespace llvm {
+  Pass *createSLPVectorizerPass() {
+    return new SLPVectorizer();
+  }
+}
@@ -0,0 +1,21 @@
+; RUN: llvm-as -compress %s -o %t.bc
+; RUN: opt -S %t.bc -o - | FileCheck %s
+; Round-trip through the compressed bitcode container.
+
+; CHECK: @gv = global i32 42
+@gv = global i32 42
+
+; CHECK: define i32 @add(i32 %a, i32 %b)
+define i32 @add(i32 %a, i32 %b) nounwind {
+entry:
+  %sum = add i32 %a, %b
+; CHECK: ret i32 %sum
+  ret i32 %sum
+}
+
+; CHECK: define i32 @caller(i32 %x)
+define i32 @caller(i32 %x) nounwind {
+entry:
+  %r = call i32 @add(i32 %x, i32 1)
+  ret i32 %r
+}
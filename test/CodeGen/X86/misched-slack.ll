@@ -0,0 +1,21 @@
+; RUN: llc < %s -mtriple=x86_64-apple-macosx -mcpu=core2 -enable-misched -misched=slack | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-apple-macosx -mcpu=core2 -enable-misched -misched=slack -slack-sched-budget=2 | FileCheck %s
+;
+; Verify that the slack scheduler, with and without an exhausted budget,
+; schedules the region and emits the arithmetic.  Whatever order the
+; scheduler picks, the subtraction needs two of the additions as inputs and
+; feeds the final one, so this ordering is schedule-independent.
+;
+; CHECK: addss
+; CHECK: addss
+; CHECK: subss
+; CHECK: addss
+define float @slacksched(float %a, float %b, float %c, float %d, float %e, float %f) nounwind uwtable readnone ssp {
+entry:
+  %add = fadd float %a, %b
+  %add1 = fadd float %c, %d
+  %add2 = fadd float %e, %f
+  %add3 = fsub float %add1, %add2
+  %add4 = fadd float %add, %add3
+  ret float %add4
+}
@@ -0,0 +1,8 @@
+define i32 @callee(i32 %x) {
+  %y = add i32 %x, 42
+  ret i32 %y
+}
+
+define i32 @helper() {
+  ret i32 1
+}
@@ -0,0 +1,16 @@
+define i32 @small(i32 %x) {
+  %y = add i32 %x, 1
+  ret i32 %y
+}
+
+define i32 @big(i32 %x) {
+  %y1 = add i32 %x, 1
+  %y2 = add i32 %y1, 2
+  %y3 = add i32 %y2, 3
+  %y4 = mul i32 %y3, %y1
+  ret i32 %y4
+}
+
+define i32 @unused() {
+  ret i32 0
+}
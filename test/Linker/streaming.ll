@@ -0,0 +1,15 @@
+; Test the bounded-memory streaming link mode: later inputs are loaded
+; lazily and the linker materializes one function body at a time.  The
+; result must be identical to a normal link.
+; RUN: llvm-as %S/Inputs/streaming.ll -o %t.lib.bc
+; RUN: llvm-link -streaming %s %t.lib.bc -S | FileCheck %s
+
+; CHECK: define i32 @callee(i32 %x)
+; CHECK: define i32 @helper()
+
+declare i32 @callee(i32)
+
+define i32 @main() {
+  %r = call i32 @callee(i32 7)
+  ret i32 %r
+}
@@ -0,0 +1,25 @@
+; Test the summary-driven thin link mode: only referenced function bodies
+; under the import limit are pulled out of the second module.
+; RUN: llvm-as %s -o %t.main.bc
+; RUN: llvm-as %S/Inputs/thin-import.ll -o %t.lib.bc
+; RUN: llvm-link -thin -thin-import-limit=3 %t.main.bc %t.lib.bc -S | FileCheck %s
+
+; @small is referenced and has a 2 instruction body, so it is imported.
+; CHECK: define i32 @small(i32 %x)
+
+; @big is referenced but its summary reports more instructions than the
+; limit, so only the declaration remains.
+; CHECK: declare i32 @big(i32)
+
+; @unused is never referenced, so its body is not imported either.
+; CHECK-NOT: define i32 @unused
+; CHECK-NOT: define i32 @big
+
+declare i32 @small(i32)
+declare i32 @big(i32)
+
+define i32 @main() {
+  %a = call i32 @small(i32 1)
+  %b = call i32 @big(i32 %a)
+  ret i32 %b
+}
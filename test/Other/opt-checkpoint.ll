@@ -0,0 +1,23 @@
+; Write a checkpoint after instcombine, then resume from it, running only the
+; passes after the checkpoint point.  The resumed run must see the instcombined
+; module, and skipped passes must not run again.
+; RUN: opt -checkpoint-file=%t -checkpoint-after=instcombine -instcombine -simplifycfg -S < %s > /dev/null
+; RUN: llvm-dis < %t | FileCheck %s
+; RUN: opt -checkpoint-file=%t -checkpoint-after=instcombine -resume -instcombine -simplifycfg -S < %s | FileCheck %s --check-prefix=RESUME
+
+; RUN: not opt -checkpoint-after=instcombine -instcombine -S < %s 2>&1 | FileCheck %s --check-prefix=NOFILE
+; RUN: not opt -checkpoint-file=%t -checkpoint-after=gvn -instcombine -S < %s 2>&1 | FileCheck %s --check-prefix=NOPASS
+
+; CHECK: @test
+; CHECK: ret i32 %a
+
+; RESUME: @test
+; RESUME: ret i32 %a
+
+; NOFILE: -checkpoint-after and -resume require -checkpoint-file
+; NOPASS: pass 'gvn' not found in pass list
+
+define i32 @test(i32 %a) {
+  %b = add i32 %a, 0
+  ret i32 %b
+}
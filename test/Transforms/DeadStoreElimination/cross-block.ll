@@ -0,0 +1,98 @@
+; RUN: opt < %s -basicaa -dse -S | FileCheck %s
+target datalayout = "E-p:64:64:64-a0:0:8-f32:32:32-f64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:32:64-v64:64:64-v128:128:128"
+
+; The store in the entry block is dead: every path leads unconditionally to
+; the overwrite in %next with nothing reading %p in between.
+define void @test1(i32* nocapture %p) {
+; CHECK: @test1
+; CHECK-NOT: store i32 0
+; CHECK: store i32 1
+entry:
+  store i32 0, i32* %p
+  br label %next
+next:
+  store i32 1, i32* %p
+  ret void
+}
+
+; The dead store is two blocks above the killer.
+define void @test2(i32* nocapture %p) {
+; CHECK: @test2
+; CHECK-NOT: store i32 0
+; CHECK: store i32 1
+entry:
+  store i32 0, i32* %p
+  br label %mid
+mid:
+  br label %next
+next:
+  store i32 1, i32* %p
+  ret void
+}
+
+; The predecessor branches conditionally, so the first store is live on the
+; path through %b.
+define i32 @test3(i32* nocapture %p, i1 %c) {
+; CHECK: @test3
+; CHECK: store i32 0
+entry:
+  store i32 0, i32* %p
+  br i1 %c, label %a, label %b
+a:
+  store i32 1, i32* %p
+  ret i32 0
+b:
+  %v = load i32* %p
+  ret i32 %v
+}
+
+; A load between the two stores keeps the first one alive.
+define i32 @test4(i32* nocapture %p) {
+; CHECK: @test4
+; CHECK: store i32 0
+; CHECK: store i32 1
+entry:
+  store i32 0, i32* %p
+  br label %mid
+mid:
+  %v = load i32* %p
+  br label %next
+next:
+  store i32 1, i32* %p
+  ret i32 %v
+}
+
+; A store to a may-aliased pointer between the two stores does not keep the
+; first one alive; it cannot read it.
+define void @test5(i32* nocapture %p, i32* %q) {
+; CHECK: @test5
+; CHECK-NOT: store i32 0
+; CHECK: store i32 10
+; CHECK: store i32 1
+entry:
+  store i32 0, i32* %p
+  br label %next
+next:
+  store i32 10, i32* %q
+  store i32 1, i32* %p
+  ret void
+}
+
+; The killer is inside a loop; the store in the preheader is still dead
+; because the loop body overwrites it before any read.
+define void @test6(i32* nocapture %p, i32 %n) {
+; CHECK: @test6
+; CHECK-NOT: store i32 0
+; CHECK: store i32 1
+entry:
+  store i32 0, i32* %p
+  br label %loop
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  store i32 1, i32* %p
+  %i.next = add i32 %i, 1
+  %cmp = icmp slt i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+exit:
+  ret void
+}
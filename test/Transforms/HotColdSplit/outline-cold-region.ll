@@ -0,0 +1,46 @@
+; RUN: opt < %s -hotcoldsplit -S | FileCheck %s
+
+; The error path ends in unreachable, so it is statically cold and gets
+; outlined into a size-optimized function in the cold section.
+
+declare void @log_error(i32)
+declare void @abort() noreturn
+
+; CHECK-LABEL: define i32 @hot(
+; CHECK: call void @hot_coldbb
+; CHECK-NOT: call void @log_error
+define i32 @hot(i32 %x) {
+entry:
+  %c = icmp eq i32 %x, 0
+  br i1 %c, label %coldbb, label %exit
+
+coldbb:
+  call void @log_error(i32 1)
+  call void @log_error(i32 2)
+  call void @log_error(i32 3)
+  call void @abort()
+  unreachable
+
+exit:
+  %r = add i32 %x, 1
+  ret i32 %r
+}
+
+; CHECK: define {{.*}}void @hot_coldbb({{.*}}#[[ATTR:[0-9]+]] section ".text.unlikely"
+; CHECK: call void @log_error
+; CHECK: attributes #[[ATTR]] = { {{.*}}minsize{{.*}}noinline{{.*}}optsize
+
+; A tiny cold block is not worth a call.
+; CHECK-LABEL: define i32 @too_small(
+; CHECK-NOT: call void @too_small_coldbb
+define i32 @too_small(i32 %x) {
+entry:
+  %c = icmp eq i32 %x, 0
+  br i1 %c, label %coldbb, label %exit
+
+coldbb:
+  unreachable
+
+exit:
+  ret i32 %x
+}
@@ -0,0 +1,92 @@
+; RUN: opt < %s -load-widening -S | FileCheck %s
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+
+%struct.msg = type { i16, i16, i8, i8, i16 }
+
+; Two adjacent i16 fields become one i32 load plus shifts.
+; CHECK: @adjacent_i16
+; CHECK: load i32*
+; CHECK: trunc i32
+; CHECK: lshr i32
+; CHECK-NOT: load i16
+define i32 @adjacent_i16(%struct.msg* %m) {
+entry:
+  %p0 = getelementptr inbounds %struct.msg* %m, i64 0, i32 0
+  %a = load i16* %p0, align 2
+  %p1 = getelementptr inbounds %struct.msg* %m, i64 0, i32 1
+  %b = load i16* %p1, align 2
+  %az = zext i16 %a to i32
+  %bz = zext i16 %b to i32
+  %r = add i32 %az, %bz
+  ret i32 %r
+}
+
+; Two adjacent i8 fields become one i16 load.
+; CHECK: @adjacent_i8
+; CHECK: load i16*
+; CHECK-NOT: load i8
+define i8 @adjacent_i8(%struct.msg* %m) {
+entry:
+  %p0 = getelementptr inbounds %struct.msg* %m, i64 0, i32 2
+  %a = load i8* %p0, align 1
+  %p1 = getelementptr inbounds %struct.msg* %m, i64 0, i32 3
+  %b = load i8* %p1, align 1
+  %r = add i8 %a, %b
+  ret i8 %r
+}
+
+; An intervening store may clobber the second field, so the loads must not
+; be merged.
+; CHECK: @intervening_store
+; CHECK: load i16*
+; CHECK: store
+; CHECK: load i16*
+define i32 @intervening_store(%struct.msg* %m, i16* %q) {
+entry:
+  %p0 = getelementptr inbounds %struct.msg* %m, i64 0, i32 0
+  %a = load i16* %p0, align 2
+  store i16 0, i16* %q, align 2
+  %p1 = getelementptr inbounds %struct.msg* %m, i64 0, i32 1
+  %b = load i16* %p1, align 2
+  %az = zext i16 %a to i32
+  %bz = zext i16 %b to i32
+  %r = add i32 %az, %bz
+  ret i32 %r
+}
+
+; i8 + i16 rounds the union up to i32, reading one byte of padding; this is
+; only legal because the allocation is known large enough to cover it.
+; CHECK: @rounded_union
+; CHECK: load i32*
+; CHECK-NOT: load i8
+; CHECK-NOT: load i16
+define i32 @rounded_union() {
+entry:
+  %buf = alloca [8 x i8], align 4
+  %p0 = getelementptr inbounds [8 x i8]* %buf, i64 0, i64 0
+  %a = load i8* %p0, align 4
+  %p1 = getelementptr inbounds [8 x i8]* %buf, i64 0, i64 1
+  %c = bitcast i8* %p1 to i16*
+  %b = load i16* %c, align 1
+  %az = zext i8 %a to i32
+  %bz = zext i16 %b to i32
+  %r = add i32 %az, %bz
+  ret i32 %r
+}
+
+; Volatile loads must be left alone.
+; CHECK: @volatile_loads
+; CHECK: load volatile i16*
+; CHECK: load volatile i16*
+define i32 @volatile_loads(%struct.msg* %m) {
+entry:
+  %p0 = getelementptr inbounds %struct.msg* %m, i64 0, i32 0
+  %a = load volatile i16* %p0, align 2
+  %p1 = getelementptr inbounds %struct.msg* %m, i64 0, i32 1
+  %b = load volatile i16* %p1, align 2
+  %az = zext i16 %a to i32
+  %bz = zext i16 %b to i32
+  %r = add i32 %az, %bz
+  ret i32 %r
+}
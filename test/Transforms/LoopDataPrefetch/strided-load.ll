@@ -0,0 +1,71 @@
+; RUN: opt < %s -loop-data-prefetch -loop-prefetch-distance=256 -S | FileCheck %s
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+
+; A strided load gets a prefetch ahead of it.
+; CHECK-LABEL: @sum
+; CHECK: call void @llvm.prefetch(i8* %{{.*}}, i32 0, i32 3, i32 1)
+; CHECK: load i32
+define i32 @sum(i32* nocapture %a, i64 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi i32 [ 0, %entry ], [ %acc.next, %loop ]
+  %p = getelementptr inbounds i32* %a, i64 %i
+  %v = load i32* %p, align 4
+  %acc.next = add i32 %acc, %v
+  %i.next = add i64 %i, 1
+  %cmp = icmp slt i64 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret i32 %acc
+}
+
+; Two loads less than a cache line apart share one prefetch.
+; CHECK-LABEL: @pair_sum
+; CHECK: call void @llvm.prefetch
+; CHECK-NOT: call void @llvm.prefetch
+define i32 @pair_sum(i32* nocapture %a, i64 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi i32 [ 0, %entry ], [ %acc.next, %loop ]
+  %j = shl i64 %i, 1
+  %p0 = getelementptr inbounds i32* %a, i64 %j
+  %v0 = load i32* %p0, align 4
+  %j1 = or i64 %j, 1
+  %p1 = getelementptr inbounds i32* %a, i64 %j1
+  %v1 = load i32* %p1, align 4
+  %s = add i32 %v0, %v1
+  %acc.next = add i32 %acc, %s
+  %i.next = add i64 %i, 1
+  %cmp = icmp slt i64 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret i32 %acc
+}
+
+; A pointer loaded from memory has no SCEV stride: no prefetch.
+; CHECK-LABEL: @pointer_chase
+; CHECK-NOT: call void @llvm.prefetch
+define i32 @pointer_chase(i32** nocapture %head) {
+entry:
+  br label %loop
+
+loop:
+  %p = phi i32** [ %head, %entry ], [ %next, %loop ]
+  %q = load i32** %p, align 8
+  %v = load i32* %q, align 4
+  %next = bitcast i32* %q to i32**
+  %cmp = icmp eq i32 %v, 0
+  br i1 %cmp, label %exit, label %loop
+
+exit:
+  ret i32 %v
+}
@@ -0,0 +1,65 @@
+; RUN: opt < %s -loop-vectorize -force-vector-unroll=1 -force-vector-width=4 -enable-interleaved-mem-accesses -dce -S | FileCheck %s
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.8.0"
+
+; A complete stride-2 load pair becomes one wide load plus two strided
+; shuffles:
+;   for (i = 0; i < n; i++)
+;     out[i] = in[2*i] + in[2*i+1];
+
+;CHECK: @stride2
+;CHECK: load <8 x i32>
+;CHECK: shufflevector {{.*}} <4 x i32> <i32 0, i32 2, i32 4, i32 6>
+;CHECK: shufflevector {{.*}} <4 x i32> <i32 1, i32 3, i32 5, i32 7>
+;CHECK: store <4 x i32>
+;CHECK: ret void
+define void @stride2(i32* noalias nocapture %out, i32* noalias nocapture %in, i64 %n) nounwind uwtable ssp {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %mul = shl nsw i64 %i, 1
+  %gep0 = getelementptr inbounds i32* %in, i64 %mul
+  %a = load i32* %gep0, align 4
+  %idx1 = or i64 %mul, 1
+  %gep1 = getelementptr inbounds i32* %in, i64 %idx1
+  %b = load i32* %gep1, align 4
+  %sum = add nsw i32 %a, %b
+  %gepo = getelementptr inbounds i32* %out, i64 %i
+  store i32 %sum, i32* %gepo, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %cond = icmp eq i64 %i.next, %n
+  br i1 %cond, label %exit, label %loop
+
+exit:
+  ret void
+}
+
+; An incomplete group (no odd-element load) must not use a wide load; the
+; gaps would be read speculatively.
+
+;CHECK: @stride2_gap
+;CHECK-NOT: load <8 x i32>
+;CHECK: ret void
+define void @stride2_gap(i32* noalias nocapture %out, i32* noalias nocapture %in, i64 %n) nounwind uwtable ssp {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %mul = shl nsw i64 %i, 1
+  %gep0 = getelementptr inbounds i32* %in, i64 %mul
+  %a = load i32* %gep0, align 4
+  %gepo = getelementptr inbounds i32* %out, i64 %i
+  store i32 %a, i32* %gepo, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %cond = icmp eq i64 %i.next, %n
+  br i1 %cond, label %exit, label %loop
+
+exit:
+  ret void
+}
@@ -0,0 +1,44 @@
+; RUN: opt < %s -metadata-detach -S | FileCheck %s --check-prefix=DETACH
+; RUN: opt < %s -metadata-detach -metadata-reattach -S | FileCheck %s --check-prefix=ROUNDTRIP
+; RUN: opt < %s -metadata-detach -detach-md-keep=range -S | FileCheck %s --check-prefix=KEEPRANGE
+; RUN: opt < %s -metadata-detach -instcombine -sccp -metadata-reattach -S | FileCheck %s --check-prefix=FOLD
+
+; Detaching removes debug locations and the range attachment; tbaa is kept by
+; default and is the only attachment left on the load.
+; DETACH: load i32* %p, !tbaa !0{{$}}
+; DETACH-NOT: !dbg
+; DETACH-NOT: !range
+
+; Reattaching restores everything that was detached.
+; ROUNDTRIP: load i32* %p, !dbg !{{[0-9]+}}, !tbaa !{{[0-9]+}}, !range !{{[0-9]+}}
+; ROUNDTRIP: ret i32 %v, !dbg !{{[0-9]+}}
+
+; With an explicit keep list only the listed kinds stay attached.
+; KEEPRANGE: load i32* %p, !range !0{{$}}
+; KEEPRANGE-NOT: !tbaa
+; KEEPRANGE-NOT: !dbg
+
+; A stashed instruction that the optimizers fold to a constant is deleted, and
+; its stash entry must die with it rather than follow the RAUW to the
+; replacement constant.  The surviving ret still gets its location back.
+; FOLD: @fold
+; FOLD-NOT: add i32
+; FOLD: ret i32 5, !dbg !{{[0-9]+}}
+
+define i32 @foo(i32* %p) nounwind {
+entry:
+  %v = load i32* %p, !tbaa !0, !range !2, !dbg !3
+  ret i32 %v, !dbg !3
+}
+
+define i32 @fold() nounwind {
+entry:
+  %x = add i32 2, 3, !dbg !3
+  ret i32 %x, !dbg !3
+}
+
+!0 = metadata !{metadata !"int", metadata !1}
+!1 = metadata !{metadata !"root"}
+!2 = metadata !{i32 0, i32 100}
+!3 = metadata !{i32 4, i32 0, metadata !4, null}
+!4 = metadata !{i32 0}
@@ -0,0 +1,77 @@
+; RUN: opt < %s -basicaa -slp-vectorizer -dce -S -mtriple=x86_64-apple-macosx10.8.0 -mcpu=corei7 | FileCheck %s
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.8.0"
+
+; Four consecutive stores of "A[i] + B[i]" become one vector add and one
+; vector store.
+; CHECK: @add4
+; CHECK: load <4 x i32>
+; CHECK: add {{(nsw )?}}<4 x i32>
+; CHECK: store <4 x i32>
+; CHECK: ret
+define void @add4(i32* noalias nocapture %dst, i32* noalias nocapture %a, i32* noalias nocapture %b) {
+entry:
+  %a0 = load i32* %a, align 4
+  %b0 = load i32* %b, align 4
+  %add0 = add nsw i32 %a0, %b0
+  store i32 %add0, i32* %dst, align 4
+  %pa1 = getelementptr inbounds i32* %a, i64 1
+  %a1 = load i32* %pa1, align 4
+  %pb1 = getelementptr inbounds i32* %b, i64 1
+  %b1 = load i32* %pb1, align 4
+  %add1 = add nsw i32 %a1, %b1
+  %pd1 = getelementptr inbounds i32* %dst, i64 1
+  store i32 %add1, i32* %pd1, align 4
+  %pa2 = getelementptr inbounds i32* %a, i64 2
+  %a2 = load i32* %pa2, align 4
+  %pb2 = getelementptr inbounds i32* %b, i64 2
+  %b2 = load i32* %pb2, align 4
+  %add2 = add nsw i32 %a2, %b2
+  %pd2 = getelementptr inbounds i32* %dst, i64 2
+  store i32 %add2, i32* %pd2, align 4
+  %pa3 = getelementptr inbounds i32* %a, i64 3
+  %a3 = load i32* %pa3, align 4
+  %pb3 = getelementptr inbounds i32* %b, i64 3
+  %b3 = load i32* %pb3, align 4
+  %add3 = add nsw i32 %a3, %b3
+  %pd3 = getelementptr inbounds i32* %dst, i64 3
+  store i32 %add3, i32* %pd3, align 4
+  ret void
+}
+
+; A store to the destination in the middle of the chain may alias the inputs,
+; so the chain must not be vectorized.
+; CHECK: @no_vectorize_aliasing_store
+; CHECK-NOT: store <4 x i32>
+; CHECK: ret
+define void @no_vectorize_aliasing_store(i32* noalias nocapture %dst, i32* nocapture %a, i32* nocapture %b) {
+entry:
+  %a0 = load i32* %a, align 4
+  %b0 = load i32* %b, align 4
+  %add0 = add nsw i32 %a0, %b0
+  store i32 %add0, i32* %dst, align 4
+  store i32 0, i32* %a, align 4
+  %pa1 = getelementptr inbounds i32* %a, i64 1
+  %a1 = load i32* %pa1, align 4
+  %pb1 = getelementptr inbounds i32* %b, i64 1
+  %b1 = load i32* %pb1, align 4
+  %add1 = add nsw i32 %a1, %b1
+  %pd1 = getelementptr inbounds i32* %dst, i64 1
+  store i32 %add1, i32* %pd1, align 4
+  %pa2 = getelementptr inbounds i32* %a, i64 2
+  %a2 = load i32* %pa2, align 4
+  %pb2 = getelementptr inbounds i32* %b, i64 2
+  %b2 = load i32* %pb2, align 4
+  %add2 = add nsw i32 %a2, %b2
+  %pd2 = getelementptr inbounds i32* %dst, i64 2
+  store i32 %add2, i32* %pd2, align 4
+  %pa3 = getelementptr inbounds i32* %a, i64 3
+  %a3 = load i32* %pa3, align 4
+  %pb3 = getelementptr inbounds i32* %b, i64 3
+  %b3 = load i32* %pb3, align 4
+  %add3 = add nsw i32 %a3, %b3
+  %pd3 = getelementptr inbounds i32* %dst, i64 3
+  store i32 %add3, i32* %pd3, align 4
+  ret void
+}
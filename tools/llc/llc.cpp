@@ -14,8 +14,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Assembly/PrintModulePass.h"
+#include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/CodeGen/LinkAllAsmWriterComponents.h"
 #include "llvm/CodeGen/LinkAllCodegenComponents.h"
@@ -30,11 +32,14 @@
 #include "llvm/Support/Host.h"
 #include "llvm/Support/IRReader.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/PluginLoader.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetLibraryInfo.h"
 #include "llvm/Target/TargetMachine.h"
@@ -45,8 +50,9 @@ using namespace llvm;
 // within the corresponding llc passes, and target-specific options
 // and back-end code generation options are specified with the target machine.
 //
-static cl::opt<std::string>
-InputFilename(cl::Positional, cl::desc("<input bitcode>"), cl::init("-"));
+static cl::list<std::string>
+InputFilenames(cl::Positional, cl::desc("<input bitcode files>"),
+               cl::ZeroOrMore);
 
 static cl::opt<std::string>
 OutputFilename("o", cl::desc("Output filename"), cl::value_desc("filename"));
@@ -56,6 +62,17 @@ TimeCompilations("time-compilations", cl::Hidden, cl::init(1u),
                  cl::value_desc("N"),
                  cl::desc("Repeat compilation N times for timing"));
 
+static cl::opt<unsigned>
+CodeGenThreads("codegen-threads", cl::init(1u), cl::value_desc("N"),
+               cl::desc("Partition the module's functions across N threads "
+                        "and run the codegen pipeline on each shard "
+                        "(assembly output only)"));
+
+static cl::opt<unsigned>
+BatchThreads("batch-threads", cl::init(1u), cl::value_desc("N"),
+             cl::desc("Number of worker threads compiling inputs from the "
+                      "batch when multiple input files are given"));
+
 // Determine optimization level.
 static cl::opt<char>
 OptLevel("O",
@@ -76,7 +93,8 @@ DisableSimplifyLibCalls("disable-simplify-libcalls",
                         cl::desc("Disable simplify-libcalls"),
                         cl::init(false));
 
-static int compileModule(char**, LLVMContext&);
+static int compileModule(char **argv, LLVMContext &Context,
+                         const std::string &InputFilename, bool Batch);
 
 // GetFileNameRoot - Helper function to get the basename of a filename.
 static inline std::string
@@ -95,40 +113,56 @@ GetFileNameRoot(const std::string &InputFilename) {
   return outputFilename;
 }
 
+// DeriveOutputFilename - Construct an output file name from the input file
+// name and the requested file type.
+static std::string DeriveOutputFilename(const char *TargetName,
+                                        Triple::OSType OS,
+                                        const std::string &InputFilename) {
+  std::string Name = GetFileNameRoot(InputFilename);
+
+  switch (FileType) {
+  case TargetMachine::CGFT_AssemblyFile:
+    if (TargetName[0] == 'c') {
+      if (TargetName[1] == 0)
+        Name += ".cbe.c";
+      else if (TargetName[1] == 'p' && TargetName[2] == 'p')
+        Name += ".cpp";
+      else
+        Name += ".s";
+    } else
+      Name += ".s";
+    break;
+  case TargetMachine::CGFT_ObjectFile:
+    if (OS == Triple::Win32)
+      Name += ".obj";
+    else
+      Name += ".o";
+    break;
+  case TargetMachine::CGFT_Null:
+    Name += ".null";
+    break;
+  }
+  return Name;
+}
+
 static tool_output_file *GetOutputStream(const char *TargetName,
                                          Triple::OSType OS,
-                                         const char *ProgName) {
-  // If we don't yet have an output filename, make one.
-  if (OutputFilename.empty()) {
+                                         const char *ProgName,
+                                         const std::string &InputFilename,
+                                         bool Batch) {
+  // In batch mode every input derives its own output name (-o is rejected up
+  // front) and the global -o value is left alone, since the workers run
+  // concurrently.  Otherwise fill in the global as before.
+  std::string BatchFilename;
+  if (Batch)
+    BatchFilename = DeriveOutputFilename(TargetName, OS, InputFilename);
+  else if (OutputFilename.empty()) {
     if (InputFilename == "-")
       OutputFilename = "-";
-    else {
-      OutputFilename = GetFileNameRoot(InputFilename);
-
-      switch (FileType) {
-      case TargetMachine::CGFT_AssemblyFile:
-        if (TargetName[0] == 'c') {
-          if (TargetName[1] == 0)
-            OutputFilename += ".cbe.c";
-          else if (TargetName[1] == 'p' && TargetName[2] == 'p')
-            OutputFilename += ".cpp";
-          else
-            OutputFilename += ".s";
-        } else
-          OutputFilename += ".s";
-        break;
-      case TargetMachine::CGFT_ObjectFile:
-        if (OS == Triple::Win32)
-          OutputFilename += ".obj";
-        else
-          OutputFilename += ".o";
-        break;
-      case TargetMachine::CGFT_Null:
-        OutputFilename += ".null";
-        break;
-      }
-    }
+    else
+      OutputFilename = DeriveOutputFilename(TargetName, OS, InputFilename);
   }
+  const std::string &OutFile = Batch ? BatchFilename : OutputFilename;
 
   // Decide if we need "binary" output.
   bool Binary = false;
@@ -145,7 +179,7 @@ static tool_output_file *GetOutputStream(const char *TargetName,
   std::string error;
   unsigned OpenFlags = 0;
   if (Binary) OpenFlags |= raw_fd_ostream::F_Binary;
-  tool_output_file *FDOut = new tool_output_file(OutputFilename.c_str(), error,
+  tool_output_file *FDOut = new tool_output_file(OutFile.c_str(), error,
                                                  OpenFlags);
   if (!error.empty()) {
     errs() << error << '\n';
@@ -156,6 +190,325 @@ static tool_output_file *GetOutputStream(const char *TargetName,
   return FDOut;
 }
 
+// GetTargetOptions - Package up the codegen flags into a TargetOptions
+// object.  This only reads command line options, so it is safe to call
+// concurrently from the codegen worker threads.
+static TargetOptions GetTargetOptions() {
+  TargetOptions Options;
+  Options.LessPreciseFPMADOption = EnableFPMAD;
+  Options.NoFramePointerElim = DisableFPElim;
+  Options.NoFramePointerElimNonLeaf = DisableFPElimNonLeaf;
+  Options.AllowFPOpFusion = FuseFPOps;
+  Options.UnsafeFPMath = EnableUnsafeFPMath;
+  Options.NoInfsFPMath = EnableNoInfsFPMath;
+  Options.NoNaNsFPMath = EnableNoNaNsFPMath;
+  Options.HonorSignDependentRoundingFPMathOption =
+      EnableHonorSignDependentRoundingFPMath;
+  Options.UseSoftFloat = GenerateSoftFloatCalls;
+  if (FloatABIForCalls != FloatABI::Default)
+    Options.FloatABIType = FloatABIForCalls;
+  Options.NoZerosInBSS = DontPlaceZerosInBSS;
+  Options.GuaranteedTailCallOpt = EnableGuaranteedTailCallOpt;
+  Options.DisableTailCalls = DisableTailCalls;
+  Options.StackAlignmentOverride = OverrideStackAlignment;
+  Options.RealignStack = EnableRealignStack;
+  Options.TrapFuncName = TrapFuncName;
+  Options.PositionIndependentExecutable = EnablePIE;
+  Options.EnableSegmentedStacks = SegmentedStacks;
+  Options.UseInitArray = UseInitArray;
+  Options.SSPBufferSize = SSPBufferSize;
+  return Options;
+}
+
+// ApplyMCOptions - Apply the MC-related command line flags to a freshly
+// created target machine.
+static void ApplyMCOptions(TargetMachine &Target, const Triple &TheTriple) {
+  if (DisableDotLoc)
+    Target.setMCUseLoc(false);
+
+  if (DisableCFI)
+    Target.setMCUseCFI(false);
+
+  if (EnableDwarfDirectory)
+    Target.setMCUseDwarfDirectory(true);
+
+  // Disable .loc support for older OS X versions.
+  if (TheTriple.isMacOSX() &&
+      TheTriple.isMacOSXVersionLT(10, 6))
+    Target.setMCUseLoc(false);
+}
+
+namespace {
+  /// ShardCompileInfo - Everything a codegen worker thread needs to compile
+  /// its slice of the module, plus the output it produces.  The bitcode image
+  /// is shared read-only; each worker reparses it into a private LLVMContext
+  /// so no IR is shared between threads.
+  struct ShardCompileInfo {
+    StringRef Bitcode;
+    unsigned ShardIndex;
+    unsigned NumShards;
+    const Target *TheTarget;
+    std::string TripleStr;
+    std::string FeaturesStr;
+    CodeGenOpt::Level OLvl;
+
+    std::string Output;
+    std::string ErrorMessage;
+    bool Failed;
+
+    ShardCompileInfo() : ShardIndex(0), NumShards(1), TheTarget(0),
+                         OLvl(CodeGenOpt::Default), Failed(false) {}
+  };
+}
+
+// PrepareModuleShard - Reduce a private copy of the module to the slice of
+// function bodies owned by shard \p Shard of \p NumShards.  Local-linkage
+// definitions are promoted to hidden external symbols with a shard-invariant
+// rename so cross-shard references still resolve when the per-shard assembly
+// is concatenated.  Global variable initializers and aliases are emitted by
+// shard 0 only.
+static void PrepareModuleShard(Module &M, unsigned Shard, unsigned NumShards) {
+  // Promote local definitions.  Every worker applies the same renaming to its
+  // copy, so iteration order keeps the names consistent across shards.
+  unsigned NextID = 0;
+  for (Module::global_iterator I = M.global_begin(), E = M.global_end();
+       I != E; ++I)
+    if (I->hasLocalLinkage()) {
+      I->setLinkage(GlobalValue::ExternalLinkage);
+      I->setVisibility(GlobalValue::HiddenVisibility);
+      I->setName(I->getName() + ".llc_shard." + Twine(NextID++));
+    }
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I)
+    if (I->hasLocalLinkage()) {
+      I->setLinkage(GlobalValue::ExternalLinkage);
+      I->setVisibility(GlobalValue::HiddenVisibility);
+      I->setName(I->getName() + ".llc_shard." + Twine(NextID++));
+    }
+
+  // Keep every NumShards'th function body, round robin; the rest become
+  // declarations.
+  unsigned Index = 0;
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
+    if (I->isDeclaration())
+      continue;
+    if (Index++ % NumShards != Shard)
+      I->deleteBody();
+  }
+
+  if (Shard != 0) {
+    for (Module::global_iterator I = M.global_begin(), E = M.global_end();
+         I != E; ++I)
+      if (I->hasInitializer()) {
+        I->setInitializer(0);
+        I->setLinkage(GlobalValue::ExternalLinkage);
+      }
+    // Aliases cannot be turned into declarations; refer to the aliasee
+    // directly instead.
+    for (Module::alias_iterator I = M.alias_begin(), E = M.alias_end();
+         I != E; ) {
+      GlobalAlias *GA = I++;
+      GA->replaceAllUsesWith(GA->getAliasee());
+      GA->eraseFromParent();
+    }
+  }
+}
+
+// CompileShard - Worker thread entry point: reparse the module into a private
+// context, prune it down to this shard's functions and run the usual codegen
+// pipeline over the result, capturing the assembly in memory.
+static void CompileShard(void *Arg) {
+  ShardCompileInfo *Info = static_cast<ShardCompileInfo*>(Arg);
+
+  LLVMContext Context;
+  OwningPtr<MemoryBuffer> Buffer(
+    MemoryBuffer::getMemBuffer(Info->Bitcode, "<shard>", false));
+  std::string ErrMsg;
+  OwningPtr<Module> M(ParseBitcodeFile(Buffer.get(), Context, &ErrMsg));
+  if (!M) {
+    Info->ErrorMessage = ErrMsg;
+    Info->Failed = true;
+    return;
+  }
+
+  PrepareModuleShard(*M, Info->ShardIndex, Info->NumShards);
+
+  Triple TheTriple(Info->TripleStr);
+  OwningPtr<TargetMachine>
+    target(Info->TheTarget->createTargetMachine(Info->TripleStr, MCPU,
+                                                Info->FeaturesStr,
+                                                GetTargetOptions(),
+                                                RelocModel, CMModel,
+                                                Info->OLvl));
+  if (!target) {
+    Info->ErrorMessage = "could not allocate target machine";
+    Info->Failed = true;
+    return;
+  }
+  ApplyMCOptions(*target, TheTriple);
+
+  PassManager PM;
+
+  TargetLibraryInfo *TLI = new TargetLibraryInfo(TheTriple);
+  if (DisableSimplifyLibCalls)
+    TLI->disableAllFunctions();
+  PM.add(TLI);
+
+  target->addAnalysisPasses(PM);
+
+  if (const DataLayout *TD = target->getDataLayout())
+    PM.add(new DataLayout(*TD));
+  else
+    PM.add(new DataLayout(M.get()));
+
+  {
+    raw_string_ostream OS(Info->Output);
+    formatted_raw_ostream FOS(OS);
+
+    if (target->addPassesToEmitFile(PM, FOS, TargetMachine::CGFT_AssemblyFile,
+                                    NoVerify)) {
+      Info->ErrorMessage = "target does not support generation of this"
+                           " file type";
+      Info->Failed = true;
+      return;
+    }
+
+    PM.run(*M);
+  }
+}
+
+// compileModuleParallel - Partition the module's functions across
+// -codegen-threads workers, run the codegen pipeline on each shard
+// independently and stitch the per-shard assembly into the output file in
+// shard order.
+static int compileModuleParallel(char **argv, Module *mod,
+                                 const Target *TheTarget,
+                                 const Triple &TheTriple,
+                                 const std::string &FeaturesStr,
+                                 CodeGenOpt::Level OLvl,
+                                 tool_output_file &Out) {
+  // Make the support libraries safe for concurrent codegen.
+  if (!llvm_is_multithreaded())
+    llvm_start_multithreaded();
+
+  // Override default to generate verbose assembly.
+  TargetMachine::setAsmVerbosityDefault(true);
+
+  // Serialize the module once; the workers reparse it rather than touching
+  // shared IR.
+  std::string Bitcode;
+  {
+    raw_string_ostream BOS(Bitcode);
+    WriteBitcodeToFile(mod, BOS);
+  }
+
+  unsigned NumShards = CodeGenThreads;
+  std::vector<ShardCompileInfo> Shards(NumShards);
+  for (unsigned i = 0; i != NumShards; ++i) {
+    Shards[i].Bitcode = StringRef(Bitcode);
+    Shards[i].ShardIndex = i;
+    Shards[i].NumShards = NumShards;
+    Shards[i].TheTarget = TheTarget;
+    Shards[i].TripleStr = TheTriple.getTriple();
+    Shards[i].FeaturesStr = FeaturesStr;
+    Shards[i].OLvl = OLvl;
+  }
+
+  // Before executing passes, print the final values of the LLVM options.
+  cl::PrintOptionValues();
+
+  // Shard 0 is compiled on this thread while the workers run.
+  std::vector<void*> Threads(NumShards, (void*)0);
+  for (unsigned i = 1; i != NumShards; ++i)
+    Threads[i] = llvm_launch_thread(CompileShard, &Shards[i]);
+  CompileShard(&Shards[0]);
+  for (unsigned i = 1; i != NumShards; ++i)
+    llvm_join_thread(Threads[i]);
+
+  for (unsigned i = 0; i != NumShards; ++i)
+    if (Shards[i].Failed) {
+      errs() << argv[0] << ": " << Shards[i].ErrorMessage << "\n";
+      return 1;
+    }
+
+  for (unsigned i = 0; i != NumShards; ++i)
+    Out.os() << Shards[i].Output;
+
+  // Declare success.
+  Out.keep();
+
+  return 0;
+}
+
+namespace {
+  /// BatchState - State shared by the -batch-threads workers: a cursor into
+  /// the input list protected by Lock, and a result slot per input.
+  struct BatchState {
+    sys::SmartMutex<true> Lock;
+    unsigned NextInput;
+    char **Argv;
+    std::vector<int> Results;
+
+    BatchState() : NextInput(0), Argv(0) {}
+  };
+}
+
+// BatchWorker - Worker thread entry point for batch compilation.  Each worker
+// owns a private LLVMContext and pulls inputs off the shared queue until it
+// is drained; nothing is shared between compilations.
+static void BatchWorker(void *Arg) {
+  BatchState *State = static_cast<BatchState*>(Arg);
+  LLVMContext Context;
+  for (;;) {
+    unsigned Index;
+    {
+      sys::SmartScopedLock<true> Guard(State->Lock);
+      if (State->NextInput == InputFilenames.size())
+        return;
+      Index = State->NextInput++;
+    }
+    State->Results[Index] = compileModule(State->Argv, Context,
+                                          InputFilenames[Index], true);
+  }
+}
+
+// compileBatch - Compile every input file, farming them out to -batch-threads
+// workers.  This amortizes process startup, target registration and pass
+// initialization across the whole batch instead of paying them per file.
+static int compileBatch(char **argv) {
+  if (CodeGenThreads > 1) {
+    errs() << argv[0] << ": -codegen-threads cannot be combined with "
+                         "multiple input files\n";
+    return 1;
+  }
+
+  unsigned NumThreads = BatchThreads;
+  if (NumThreads < 1)
+    NumThreads = 1;
+  if (NumThreads > InputFilenames.size())
+    NumThreads = InputFilenames.size();
+
+  // Make the support libraries safe for concurrent codegen.
+  if (NumThreads > 1 && !llvm_is_multithreaded())
+    llvm_start_multithreaded();
+
+  BatchState State;
+  State.Argv = argv;
+  State.Results.assign(InputFilenames.size(), 0);
+
+  // This thread works the queue alongside the extra workers.
+  std::vector<void*> Threads(NumThreads, (void*)0);
+  for (unsigned i = 1; i != NumThreads; ++i)
+    Threads[i] = llvm_launch_thread(BatchWorker, &State);
+  BatchWorker(&State);
+  for (unsigned i = 1; i != NumThreads; ++i)
+    llvm_join_thread(Threads[i]);
+
+  int Res = 0;
+  for (unsigned i = 0, e = State.Results.size(); i != e; ++i)
+    Res |= State.Results[i];
+  return Res;
+}
+
 // main - Entry point for the llc compiler.
 //
 int main(int argc, char **argv) {
@@ -188,15 +541,33 @@ int main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "llvm system compiler\n");
 
+  if (InputFilenames.empty())
+    InputFilenames.push_back("-");
+
+  if (InputFilenames.size() > 1) {
+    if (!OutputFilename.empty()) {
+      errs() << argv[0] << ": -o is not supported with multiple input "
+                           "files\n";
+      return 1;
+    }
+    for (unsigned i = 0, e = InputFilenames.size(); i != e; ++i)
+      if (InputFilenames[i] == "-") {
+        errs() << argv[0] << ": standard input cannot be part of a batch\n";
+        return 1;
+      }
+    return compileBatch(argv);
+  }
+
   // Compile the module TimeCompilations times to give better compile time
   // metrics.
   for (unsigned I = TimeCompilations; I; --I)
-    if (int RetVal = compileModule(argv, Context))
+    if (int RetVal = compileModule(argv, Context, InputFilenames[0], false))
       return RetVal;
   return 0;
 }
 
-static int compileModule(char **argv, LLVMContext &Context) {
+static int compileModule(char **argv, LLVMContext &Context,
+                         const std::string &InputFilename, bool Batch) {
   // Load the module to be compiled...
   SMDiagnostic Err;
   std::auto_ptr<Module> M;
@@ -256,29 +627,7 @@ static int compileModule(char **argv, LLVMContext &Context) {
   case '3': OLvl = CodeGenOpt::Aggressive; break;
   }
 
-  TargetOptions Options;
-  Options.LessPreciseFPMADOption = EnableFPMAD;
-  Options.NoFramePointerElim = DisableFPElim;
-  Options.NoFramePointerElimNonLeaf = DisableFPElimNonLeaf;
-  Options.AllowFPOpFusion = FuseFPOps;
-  Options.UnsafeFPMath = EnableUnsafeFPMath;
-  Options.NoInfsFPMath = EnableNoInfsFPMath;
-  Options.NoNaNsFPMath = EnableNoNaNsFPMath;
-  Options.HonorSignDependentRoundingFPMathOption =
-      EnableHonorSignDependentRoundingFPMath;
-  Options.UseSoftFloat = GenerateSoftFloatCalls;
-  if (FloatABIForCalls != FloatABI::Default)
-    Options.FloatABIType = FloatABIForCalls;
-  Options.NoZerosInBSS = DontPlaceZerosInBSS;
-  Options.GuaranteedTailCallOpt = EnableGuaranteedTailCallOpt;
-  Options.DisableTailCalls = DisableTailCalls;
-  Options.StackAlignmentOverride = OverrideStackAlignment;
-  Options.RealignStack = EnableRealignStack;
-  Options.TrapFuncName = TrapFuncName;
-  Options.PositionIndependentExecutable = EnablePIE;
-  Options.EnableSegmentedStacks = SegmentedStacks;
-  Options.UseInitArray = UseInitArray;
-  Options.SSPBufferSize = SSPBufferSize;
+  TargetOptions Options = GetTargetOptions();
 
   std::auto_ptr<TargetMachine>
     target(TheTarget->createTargetMachine(TheTriple.getTriple(),
@@ -288,28 +637,27 @@ static int compileModule(char **argv, LLVMContext &Context) {
   assert(mod && "Should have exited after outputting help!");
   TargetMachine &Target = *target.get();
 
-  if (DisableDotLoc)
-    Target.setMCUseLoc(false);
-
-  if (DisableCFI)
-    Target.setMCUseCFI(false);
-
-  if (EnableDwarfDirectory)
-    Target.setMCUseDwarfDirectory(true);
+  ApplyMCOptions(Target, TheTriple);
 
   if (GenerateSoftFloatCalls)
     FloatABIForCalls = FloatABI::Soft;
 
-  // Disable .loc support for older OS X versions.
-  if (TheTriple.isMacOSX() &&
-      TheTriple.isMacOSXVersionLT(10, 6))
-    Target.setMCUseLoc(false);
-
   // Figure out where we are going to send the output.
   OwningPtr<tool_output_file> Out
-    (GetOutputStream(TheTarget->getName(), TheTriple.getOS(), argv[0]));
+    (GetOutputStream(TheTarget->getName(), TheTriple.getOS(), argv[0],
+                     InputFilename, Batch));
   if (!Out) return 1;
 
+  // Hand off to the parallel driver if the user asked for sharded codegen.
+  if (CodeGenThreads > 1) {
+    if (FileType != TargetMachine::CGFT_AssemblyFile)
+      errs() << argv[0] << ": warning: ignoring -codegen-threads because "
+                           "filetype != asm\n";
+    else
+      return compileModuleParallel(argv, mod, TheTarget, TheTriple,
+                                   FeaturesStr, OLvl, *Out);
+  }
+
   // Build up all of the passes that we want to do to the module.
   PassManager PM;
 
@@ -13,13 +13,23 @@
 //===----------------------------------------------------------------------===//
 
 #include "RemoteTarget.h"
+#include "RemoteTargetExternal.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Config/config.h"
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/Memory.h"
 #include <stdlib.h>
 #include <string>
 using namespace llvm;
 
+RemoteTarget *RemoteTarget::createRemoteTarget(bool UseExternalChannel) {
+#ifdef LLVM_ON_UNIX
+  if (UseExternalChannel)
+    return new RemoteTargetExternal();
+#endif
+  return new RemoteTarget();
+}
+
 bool RemoteTarget::allocateSpace(size_t Size, unsigned Alignment,
                                  uint64_t &Address) {
   sys::MemoryBlock *Prev = Allocations.size() ? &Allocations.back() : NULL;
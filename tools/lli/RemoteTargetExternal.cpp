@@ -0,0 +1,336 @@
+//===- RemoteTargetExternal.cpp - LLVM out-of-process JIT execution -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Implementation of the RemoteTargetExternal class which runs JITed code in
+// a forked child process over an asynchronous message channel.
+//
+//===----------------------------------------------------------------------===//
+
+#include "RemoteTargetExternal.h"
+#include "RemoteTargetMessage.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Config/config.h"
+#include <cstring>
+
+#ifdef LLVM_ON_UNIX
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace llvm;
+
+RemoteTargetExternal::~RemoteTargetExternal() {
+  if (IsRunning)
+    stop();
+}
+
+#ifdef LLVM_ON_UNIX
+
+void RemoteTargetExternal::create() {
+  int SockPair[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, SockPair) != 0) {
+    ErrorMsg = "unable to create a socket pair for the remote target";
+    return;
+  }
+
+  int PID = fork();
+  if (PID < 0) {
+    close(SockPair[0]);
+    close(SockPair[1]);
+    ErrorMsg = "unable to fork the remote target process";
+    return;
+  }
+
+  if (PID == 0) {
+    // Child: service commands until told to terminate.
+    close(SockPair[0]);
+    doRemoteTargeting(SockPair[1], SockPair[1]);
+    _exit(0);
+  }
+
+  close(SockPair[1]);
+  ChildFD = SockPair[0];
+  ChildPID = PID;
+  IsRunning = true;
+}
+
+void RemoteTargetExternal::stop() {
+  if (ChildFD >= 0) {
+    appendMessage(LLI_Terminate, 0, 0);
+    flushMessages();
+    close(ChildFD);
+    ChildFD = -1;
+  }
+  if (ChildPID > 0) {
+    int Status;
+    while (waitpid(ChildPID, &Status, 0) < 0 && errno == EINTR)
+      ;
+    ChildPID = -1;
+  }
+  IsRunning = false;
+}
+
+bool RemoteTargetExternal::allocateSpace(size_t Size, unsigned Alignment,
+                                         uint64_t &Address) {
+  uint32_t Args[2] = { (uint32_t)Alignment, (uint32_t)Size };
+  appendMessage(LLI_AllocateSpace, Args, sizeof(Args));
+
+  uint32_t PayloadSize;
+  if (!expectReply(LLI_AllocationResult, PayloadSize))
+    return true;
+  if (PayloadSize != sizeof(uint64_t) || !readBytes(&Address, sizeof(Address))) {
+    ErrorMsg = "malformed allocation result from remote target";
+    return true;
+  }
+  return false;
+}
+
+bool RemoteTargetExternal::loadData(uint64_t Address, const void *Data,
+                                    size_t Size) {
+  if (ChildFD < 0)
+    return true;
+  appendMessage(LLI_LoadDataSection, &Address, sizeof(Address), Data, Size);
+  ++PendingLoadAcks;
+  return false;
+}
+
+bool RemoteTargetExternal::loadCode(uint64_t Address, const void *Data,
+                                    size_t Size) {
+  if (ChildFD < 0)
+    return true;
+  appendMessage(LLI_LoadCodeSection, &Address, sizeof(Address), Data, Size);
+  ++PendingLoadAcks;
+  return false;
+}
+
+bool RemoteTargetExternal::executeCode(uint64_t Address, int &RetVal) {
+  appendMessage(LLI_Execute, &Address, sizeof(Address));
+
+  uint32_t PayloadSize;
+  if (!expectReply(LLI_ExecutionResult, PayloadSize))
+    return true;
+  int32_t Result;
+  if (PayloadSize != sizeof(Result) || !readBytes(&Result, sizeof(Result))) {
+    ErrorMsg = "malformed execution result from remote target";
+    return true;
+  }
+  RetVal = Result;
+  return false;
+}
+
+void RemoteTargetExternal::appendMessage(int Type, const void *Payload1,
+                                         size_t Size1, const void *Payload2,
+                                         size_t Size2) {
+  int32_t MsgType = Type;
+  uint32_t PayloadSize = Size1 + Size2;
+  OutBuf.append((const char *)&MsgType, (const char *)&MsgType + sizeof(MsgType));
+  OutBuf.append((const char *)&PayloadSize,
+                (const char *)&PayloadSize + sizeof(PayloadSize));
+  if (Size1)
+    OutBuf.append((const char *)Payload1, (const char *)Payload1 + Size1);
+  if (Size2)
+    OutBuf.append((const char *)Payload2, (const char *)Payload2 + Size2);
+}
+
+bool RemoteTargetExternal::flushMessages() {
+  if (ChildFD < 0)
+    return false;
+  const char *Data = OutBuf.data();
+  size_t Remaining = OutBuf.size();
+  while (Remaining) {
+    ssize_t Written = write(ChildFD, Data, Remaining);
+    if (Written < 0) {
+      if (errno == EINTR)
+        continue;
+      ErrorMsg = "unable to write to the remote target channel";
+      return false;
+    }
+    Data += Written;
+    Remaining -= Written;
+  }
+  OutBuf.clear();
+  return true;
+}
+
+bool RemoteTargetExternal::readBytes(void *Data, size_t Size) {
+  char *Buf = (char *)Data;
+  while (Size) {
+    ssize_t Read = read(ChildFD, Buf, Size);
+    if (Read < 0 && errno == EINTR)
+      continue;
+    if (Read <= 0) {
+      ErrorMsg = "unable to read from the remote target channel";
+      return false;
+    }
+    Buf += Read;
+    Size -= Read;
+  }
+  return true;
+}
+
+bool RemoteTargetExternal::expectReply(int Type, uint32_t &PayloadSize) {
+  if (ChildFD < 0) {
+    if (ErrorMsg.empty())
+      ErrorMsg = "remote target process is not running";
+    return false;
+  }
+  if (!flushMessages())
+    return false;
+
+  // Acknowledgements for pipelined loads arrive, in order, ahead of the
+  // reply we are waiting for.
+  for (;;) {
+    int32_t MsgType;
+    if (!readBytes(&MsgType, sizeof(MsgType)) ||
+        !readBytes(&PayloadSize, sizeof(PayloadSize)))
+      return false;
+    if (MsgType == LLI_LoadComplete && PendingLoadAcks) {
+      --PendingLoadAcks;
+      continue;
+    }
+    if (MsgType != Type) {
+      ErrorMsg = "unexpected message from remote target";
+      return false;
+    }
+    return true;
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// The child side of the channel.
+//===----------------------------------------------------------------------===//
+
+static bool readAll(int FD, void *Data, size_t Size) {
+  char *Buf = (char *)Data;
+  while (Size) {
+    ssize_t Read = read(FD, Buf, Size);
+    if (Read < 0 && errno == EINTR)
+      continue;
+    if (Read <= 0)
+      return false;
+    Buf += Read;
+    Size -= Read;
+  }
+  return true;
+}
+
+static bool writeAll(int FD, const void *Data, size_t Size) {
+  const char *Buf = (const char *)Data;
+  while (Size) {
+    ssize_t Written = write(FD, Buf, Size);
+    if (Written < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    Buf += Written;
+    Size -= Written;
+  }
+  return true;
+}
+
+static bool sendMessage(int FD, int Type, const void *Payload, size_t Size) {
+  int32_t MsgType = Type;
+  uint32_t PayloadSize = Size;
+  return writeAll(FD, &MsgType, sizeof(MsgType)) &&
+         writeAll(FD, &PayloadSize, sizeof(PayloadSize)) &&
+         (Size == 0 || writeAll(FD, Payload, Size));
+}
+
+void RemoteTargetExternal::doRemoteTargeting(int CmdFD, int OutFD) {
+  // Execution in the child's address space goes through the plain
+  // in-process target; this loop only speaks the message protocol.
+  RemoteTarget Target;
+  Target.create();
+
+  for (;;) {
+    int32_t MsgType;
+    uint32_t PayloadSize;
+    if (!readAll(CmdFD, &MsgType, sizeof(MsgType)) ||
+        !readAll(CmdFD, &PayloadSize, sizeof(PayloadSize)))
+      break;
+
+    switch (MsgType) {
+    case LLI_AllocateSpace: {
+      uint32_t Args[2];
+      if (PayloadSize != sizeof(Args) || !readAll(CmdFD, Args, sizeof(Args)))
+        return;
+      uint64_t Address = 0;
+      Target.allocateSpace(Args[1], Args[0], Address);
+      if (!sendMessage(OutFD, LLI_AllocationResult, &Address, sizeof(Address)))
+        return;
+      break;
+    }
+    case LLI_LoadCodeSection:
+    case LLI_LoadDataSection: {
+      uint64_t Address;
+      if (PayloadSize < sizeof(Address) ||
+          !readAll(CmdFD, &Address, sizeof(Address)))
+        return;
+      size_t Size = PayloadSize - sizeof(Address);
+      OwningArrayPtr<char> Buf(new char[Size]);
+      if (!readAll(CmdFD, Buf.get(), Size))
+        return;
+      if (MsgType == LLI_LoadCodeSection)
+        Target.loadCode(Address, Buf.get(), Size);
+      else
+        Target.loadData(Address, Buf.get(), Size);
+      if (!sendMessage(OutFD, LLI_LoadComplete, 0, 0))
+        return;
+      break;
+    }
+    case LLI_Execute: {
+      uint64_t Address;
+      if (PayloadSize != sizeof(Address) ||
+          !readAll(CmdFD, &Address, sizeof(Address)))
+        return;
+      int RetVal = 0;
+      Target.executeCode(Address, RetVal);
+      int32_t Result = RetVal;
+      if (!sendMessage(OutFD, LLI_ExecutionResult, &Result, sizeof(Result)))
+        return;
+      break;
+    }
+    case LLI_Terminate:
+      Target.stop();
+      return;
+    default:
+      return;
+    }
+  }
+}
+
+#else // !LLVM_ON_UNIX
+
+// Process spawning for the external channel is only implemented for Unix
+// hosts; createRemoteTarget() never constructs this class elsewhere.
+void RemoteTargetExternal::create() {
+  ErrorMsg = "external remote target channel is not supported on this host";
+}
+void RemoteTargetExternal::stop() { IsRunning = false; }
+bool RemoteTargetExternal::allocateSpace(size_t, unsigned, uint64_t &) {
+  return true;
+}
+bool RemoteTargetExternal::loadData(uint64_t, const void *, size_t) {
+  return true;
+}
+bool RemoteTargetExternal::loadCode(uint64_t, const void *, size_t) {
+  return true;
+}
+bool RemoteTargetExternal::executeCode(uint64_t, int &) { return true; }
+void RemoteTargetExternal::appendMessage(int, const void *, size_t,
+                                         const void *, size_t) {}
+bool RemoteTargetExternal::flushMessages() { return false; }
+bool RemoteTargetExternal::readBytes(void *, size_t) { return false; }
+bool RemoteTargetExternal::expectReply(int, uint32_t &) { return false; }
+void RemoteTargetExternal::doRemoteTargeting(int, int) {}
+
+#endif
@@ -0,0 +1,81 @@
+//===- RemoteTargetExternal.h - LLVM out-of-process JIT execution ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Definition of the RemoteTargetExternal class which runs JITed code in a
+// forked child process reached over a socket-pair message channel.  Section
+// payloads are batched into the outgoing buffer and load messages are
+// pipelined, so a slow link pays one flush per execution rather than one
+// round trip per section.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLI_REMOTETARGETEXTERNAL_H
+#define LLI_REMOTETARGETEXTERNAL_H
+
+#include "RemoteTarget.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/DataTypes.h"
+#include <string>
+
+namespace llvm {
+
+class RemoteTargetExternal : public RemoteTarget {
+  /// ChildFD - Our end of the command socket, or -1 when no child is
+  /// running (or starting one failed).
+  int ChildFD;
+  int ChildPID;
+
+  /// OutBuf - Framed messages not yet written to the channel.  Load
+  /// messages accumulate here and go out in a single write at the next
+  /// synchronization point.
+  SmallVector<char, 512> OutBuf;
+
+  /// PendingLoadAcks - Number of LLI_LoadComplete acknowledgements the
+  /// child owes us.  They are consumed lazily, before the reply to the
+  /// next synchronous message.
+  unsigned PendingLoadAcks;
+
+public:
+  RemoteTargetExternal() : ChildFD(-1), ChildPID(-1), PendingLoadAcks(0) {}
+  virtual ~RemoteTargetExternal();
+
+  virtual bool allocateSpace(size_t Size, unsigned Alignment,
+                             uint64_t &Address);
+  virtual bool loadData(uint64_t Address, const void *Data, size_t Size);
+  virtual bool loadCode(uint64_t Address, const void *Data, size_t Size);
+  virtual bool executeCode(uint64_t Address, int &RetVal);
+
+  /// Fork the child process and connect the message channel.  On failure
+  /// ErrorMsg is set and every subsequent operation fails.
+  virtual void create();
+  virtual void stop();
+
+private:
+  void appendMessage(int Type, const void *Payload1, size_t Size1,
+                     const void *Payload2 = 0, size_t Size2 = 0);
+  bool flushMessages();
+  bool readBytes(void *Data, size_t Size);
+
+  /// expectReply - Flush outgoing messages, consume any pipelined load
+  /// acknowledgements, and read the header of a reply of type Type.
+  /// Returns false and sets ErrorMsg on channel errors or unexpected
+  /// messages.
+  bool expectReply(int Type, uint32_t &PayloadSize);
+
+  /// doRemoteTargeting - Body of the child process: services command
+  /// messages arriving on CmdFD and sends replies on OutFD until it
+  /// receives LLI_Terminate.  Never returns control to the caller's JIT;
+  /// execution happens on a plain in-process RemoteTarget in the child's
+  /// own address space.
+  static void doRemoteTargeting(int CmdFD, int OutFD);
+};
+
+} // end namespace llvm
+
+#endif
@@ -0,0 +1,46 @@
+//===- RemoteTargetMessage.h - LLI out-of-process message protocol --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Definition of the LLIMessageType enum which is used for communication with a
+// child process for remote execution.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLI_REMOTETARGETMESSAGE_H
+#define LLI_REMOTETARGETMESSAGE_H
+
+namespace llvm {
+
+// LLI messages from the remote target should never have an LLI_Error value.
+// It is used as a return value to denote errors in the message channel
+// itself rather than in the remote target.
+//
+// Each message on the wire is a 32-bit type tag followed by a 32-bit payload
+// size and the payload bytes.  Load messages are pipelined: the host may send
+// any number of them without waiting, and the target acknowledges each with
+// LLI_LoadComplete in order.  Only LLI_AllocateSpace and LLI_Execute require
+// the host to wait for a reply.
+enum LLIMessageType {
+  LLI_Error = -1,
+  LLI_AllocateSpace = 0,  // Payload: uint32_t Alignment, uint32_t Size
+  LLI_AllocationResult,   // Payload: uint64_t Address
+
+  LLI_LoadCodeSection,    // Payload: uint64_t Address, section contents
+  LLI_LoadDataSection,    // Payload: uint64_t Address, section contents
+  LLI_LoadComplete,       // No payload
+
+  LLI_Execute,            // Payload: uint64_t Address
+  LLI_ExecutionResult,    // Payload: int32_t Result
+
+  LLI_Terminate           // No payload
+};
+
+} // end namespace llvm
+
+#endif
@@ -17,6 +17,7 @@
 #include "llvm/IR/LLVMContext.h"
 #include "RecordingMemoryManager.h"
 #include "RemoteTarget.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/LinkAllCodegenComponents.h"
@@ -77,6 +78,15 @@ namespace {
     cl::desc("Execute MCJIT'ed code in a separate process."),
     cl::init(false));
 
+  // The in-process stub above simulates the remote target; with this option
+  // the code instead runs in a forked child process reached over a message
+  // channel that pipelines section loads, so transfer isn't paced by one
+  // round trip per section.
+  cl::opt<bool> RemoteMCJITExternal("remote-mcjit-external",
+    cl::desc("With -remote-mcjit, execute in a forked child process "
+             "over an asynchronous message channel (Unix only)."),
+    cl::init(false));
+
   // Determine optimization level.
   cl::opt<char>
   OptLevel("O",
@@ -307,9 +317,19 @@ int main(int argc, char **argv, char * const *envp) {
   if (DisableCoreFiles)
     sys::Process::PreventCoreFiles();
 
-  // Load the bitcode...
+  // Load the bitcode.  When jitting lazily, open the file as a lazy
+  // materialization module instead of parsing it up front: function bodies
+  // are deserialized the first time the JIT needs them, so the parse cost is
+  // proportional to the code actually executed and the rest of the file stays
+  // in the mmap'd buffer, which the OS shares between processes running the
+  // same bitcode.  The interpreter and MCJIT walk whole-module IR, so they
+  // still need a fully parsed module.
   SMDiagnostic Err;
-  Module *Mod = ParseIRFile(InputFile, Err, Context);
+  Module *Mod;
+  if (!NoLazyCompilation && !ForceInterpreter && !UseMCJIT)
+    Mod = getLazyIRFileModule(InputFile, Err, Context);
+  else
+    Mod = ParseIRFile(InputFile, Err, Context);
   if (!Mod) {
     Err.print(argv[0], errs());
     return 1;
@@ -470,8 +490,11 @@ int main(int argc, char **argv, char * const *envp) {
     // Everything is prepared now, so lay out our program for the target
     // address space, assign the section addresses to resolve any relocations,
     // and send it to the target.
-    RemoteTarget Target;
-    Target.create();
+    OwningPtr<RemoteTarget> Target(
+      RemoteTarget::createRemoteTarget(RemoteMCJITExternal));
+    Target->create();
+    if (!Target->getErrorMsg().empty())
+      report_fatal_error(Target->getErrorMsg());
 
     // Ask for a pointer to the entry function. This triggers the actual
     // compilation.
@@ -479,7 +502,7 @@ int main(int argc, char **argv, char * const *envp) {
 
     // Enough has been compiled to execute the entry function now, so
     // layout the target memory.
-    layoutRemoteTargetMemory(&Target, MM);
+    layoutRemoteTargetMemory(Target.get(), MM);
 
     // Since we're executing in a (at least simulated) remote address space,
     // we can't use the ExecutionEngine::runFunctionAsMain(). We have to
@@ -491,10 +514,10 @@ int main(int argc, char **argv, char * const *envp) {
     DEBUG(dbgs() << "Executing '" << EntryFn->getName() << "' at "
                  << format("%p", Entry) << "\n");
 
-    if (Target.executeCode(Entry, Result))
-      errs() << "ERROR: " << Target.getErrorMsg() << "\n";
+    if (Target->executeCode(Entry, Result))
+      errs() << "ERROR: " << Target->getErrorMsg() << "\n";
 
-    Target.stop();
+    Target->stop();
   } else {
     // Trigger compilation separately so code regions that need to be 
     // invalidated will be known.
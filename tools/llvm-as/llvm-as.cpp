@@ -50,6 +50,10 @@ static cl::opt<bool>
 DisableVerify("disable-verify", cl::Hidden,
               cl::desc("Do not run verifier on input LLVM (dangerous!)"));
 
+static cl::opt<bool>
+CompressBitcode("compress",
+                cl::desc("Emit the compressed bitcode container"));
+
 static void WriteOutputFile(const Module *M) {
   // Infer the output filename if needed.
   if (OutputFilename.empty()) {
@@ -77,8 +81,12 @@ static void WriteOutputFile(const Module *M) {
     exit(1);
   }
 
-  if (Force || !CheckBitcodeOutputToConsole(Out->os(), true))
-    WriteBitcodeToFile(M, Out->os());
+  if (Force || !CheckBitcodeOutputToConsole(Out->os(), true)) {
+    if (CompressBitcode)
+      WriteCompressedBitcodeToFile(M, Out->os());
+    else
+      WriteBitcodeToFile(M, Out->os());
+  }
 
   // Declare success.
   Out->keep();
@@ -28,12 +28,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Analysis/Verifier.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Bitcode/LLVMBitCodes.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/PathV2.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
@@ -44,8 +47,9 @@
 #include <map>
 using namespace llvm;
 
-static cl::opt<std::string>
-  InputFilename(cl::Positional, cl::desc("<input bitcode>"), cl::init("-"));
+static cl::list<std::string>
+  InputFilenames(cl::Positional, cl::desc("<input bitcode files/directories>"),
+                 cl::ZeroOrMore);
 
 static cl::opt<bool> Dump("dump", cl::desc("Dump low level bitcode trace"));
 
@@ -278,7 +282,15 @@ struct PerRecordStats {
   unsigned NumAbbrev;
   uint64_t TotalBits;
 
+  /// SizeSamples - A fixed-size reservoir sample of individual record bit
+  /// sizes, so that aggregation over many files can report the size
+  /// distribution (median/max) without remembering every record.
+  enum { MaxSizeSamples = 64 };
+  std::vector<uint32_t> SizeSamples;
+
   PerRecordStats() : NumInstances(0), NumAbbrev(0), TotalBits(0) {}
+
+  void addSizeSample(uint64_t Bits);
 };
 
 struct PerBlockIDStats {
@@ -308,7 +320,29 @@ struct PerBlockIDStats {
 
 static std::map<unsigned, PerBlockIDStats> BlockIDStats;
 
+/// ReservoirRand - A small deterministic xorshift generator for reservoir
+/// sampling; the analysis should produce the same report on every run over
+/// the same inputs.
+static uint64_t ReservoirRand() {
+  static uint64_t State = 0x853c49e6748fea9bULL;
+  State ^= State << 13;
+  State ^= State >> 7;
+  State ^= State << 17;
+  return State;
+}
 
+void PerRecordStats::addSizeSample(uint64_t Bits) {
+  if (Bits > ~(uint32_t)0)
+    Bits = ~(uint32_t)0;
+  if (SizeSamples.size() < (unsigned)MaxSizeSamples) {
+    SizeSamples.push_back((uint32_t)Bits);
+    return;
+  }
+  // Algorithm R: replace a random slot with probability MaxSizeSamples/N.
+  uint64_t Slot = ReservoirRand() % NumInstances;
+  if (Slot < (unsigned)MaxSizeSamples)
+    SizeSamples[Slot] = (uint32_t)Bits;
+}
 
 /// Error - All bitcode analysis errors go through this function, making this a
 /// good place to breakpoint if debugging.
@@ -417,11 +451,13 @@ static bool ParseBlock(BitstreamCursor &Stream, unsigned BlockID,
     // Increment the # occurrences of this code.
     if (BlockStats.CodeFreq.size() <= Code)
       BlockStats.CodeFreq.resize(Code+1);
-    BlockStats.CodeFreq[Code].NumInstances++;
-    BlockStats.CodeFreq[Code].TotalBits +=
-      Stream.GetCurrentBitNo()-RecordStartBit;
+    PerRecordStats &RecStats = BlockStats.CodeFreq[Code];
+    RecStats.NumInstances++;
+    uint64_t RecordBits = Stream.GetCurrentBitNo()-RecordStartBit;
+    RecStats.TotalBits += RecordBits;
+    RecStats.addSizeSample(RecordBits);
     if (Entry.ID != bitc::UNABBREV_RECORD) {
-      BlockStats.CodeFreq[Code].NumAbbrev++;
+      RecStats.NumAbbrev++;
       ++BlockStats.NumAbbreviatedRecords;
     }
 
@@ -472,14 +508,18 @@ static void PrintSize(uint64_t Bits) {
 }
 
 
-/// AnalyzeBitcode - Analyze the bitcode file specified by InputFilename.
-static int AnalyzeBitcode() {
+/// AnalyzeBitcodeFile - Parse one bitcode file, accumulating statistics into
+/// the global tables.  On success the reader is handed back through
+/// StreamFileOut; the caller keeps the last one alive so the report can look
+/// up symbolic block/record names.
+static int AnalyzeBitcodeFile(const std::string &Filename,
+                              uint64_t &BufferSizeBits,
+                              unsigned &NumTopBlocks,
+                              OwningPtr<MemoryBuffer> &MemBuf,
+                              OwningPtr<BitstreamReader> &StreamFileOut) {
   // Read the input file.
-  OwningPtr<MemoryBuffer> MemBuf;
-
-  if (error_code ec =
-        MemoryBuffer::getFileOrSTDIN(InputFilename.c_str(), MemBuf))
-    return Error("Error reading '" + InputFilename + "': " + ec.message());
+  if (error_code ec = MemoryBuffer::getFileOrSTDIN(Filename.c_str(), MemBuf))
+    return Error("Error reading '" + Filename + "': " + ec.message());
 
   if (MemBuf->getBufferSize() & 3)
     return Error("Bitcode stream should be a multiple of 4 bytes in length");
@@ -493,7 +533,8 @@ static int AnalyzeBitcode() {
     if (SkipBitcodeWrapperHeader(BufPtr, EndBufPtr, true))
       return Error("Invalid bitcode wrapper header");
 
-  BitstreamReader StreamFile(BufPtr, EndBufPtr);
+  StreamFileOut.reset(new BitstreamReader(BufPtr, EndBufPtr));
+  BitstreamReader &StreamFile = *StreamFileOut;
   BitstreamCursor Stream(StreamFile);
   StreamFile.CollectBlockInfoNames();
 
@@ -513,8 +554,6 @@ static int AnalyzeBitcode() {
       Signature[4] == 0xE && Signature[5] == 0xD)
     CurStreamType = LLVMIRBitstream;
 
-  unsigned NumTopBlocks = 0;
-
   // Parse the top-level structure.  We only allow blocks at the top-level.
   while (!Stream.AtEndOfStream()) {
     unsigned Code = Stream.ReadCode();
@@ -524,15 +563,23 @@ static int AnalyzeBitcode() {
     unsigned BlockID = Stream.ReadSubBlockID();
 
     if (ParseBlock(Stream, BlockID, 0))
-      return true;
+      return 1;
     ++NumTopBlocks;
   }
 
+  BufferSizeBits += (EndBufPtr-BufPtr)*CHAR_BIT;
+  return 0;
+}
+
+/// PrintAnalysis - Emit the aggregated per-block/per-record report for
+/// everything parsed so far.
+static void PrintAnalysis(const std::string &Title, uint64_t BufferSizeBits,
+                          unsigned NumTopBlocks,
+                          const BitstreamReader &StreamFile) {
   if (Dump) outs() << "\n\n";
 
-  uint64_t BufferSizeBits = (EndBufPtr-BufPtr)*CHAR_BIT;
-  // Print a summary of the read file.
-  outs() << "Summary of " << InputFilename << ":\n";
+  // Print a summary of the read file(s).
+  outs() << "Summary of " << Title << ":\n";
   outs() << "         Total size: ";
   PrintSize(BufferSizeBits);
   outs() << "\n";
@@ -591,7 +638,7 @@ static int AnalyzeBitcode() {
       std::reverse(FreqPairs.begin(), FreqPairs.end());
 
       outs() << "\tRecord Histogram:\n";
-      outs() << "\t\t  Count    # Bits   %% Abv  Record Kind\n";
+      outs() << "\t\t  Count    # Bits  Median     Max   %% Abv  Record Kind\n";
       for (unsigned i = 0, e = FreqPairs.size(); i != e; ++i) {
         const PerRecordStats &RecStats = Stats.CodeFreq[FreqPairs[i].second];
 
@@ -599,6 +646,13 @@ static int AnalyzeBitcode() {
                          RecStats.NumInstances,
                          (unsigned long)RecStats.TotalBits);
 
+        // Size distribution from the reservoir sample.
+        std::vector<uint32_t> Samples(RecStats.SizeSamples);
+        std::sort(Samples.begin(), Samples.end());
+        outs() << format(" %7lu %7lu",
+                         (unsigned long)Samples[Samples.size()/2],
+                         (unsigned long)Samples.back());
+
         if (RecStats.NumAbbrev)
           outs() <<
               format("%7.2f  ",
@@ -616,9 +670,41 @@ static int AnalyzeBitcode() {
 
     }
   }
-  return 0;
 }
 
+/// CollectInputFiles - Expand the positional arguments into a list of bitcode
+/// files.  A directory argument adds every .bc file directly inside it, so a
+/// whole artifact store can be analyzed in one aggregated run.
+static bool CollectInputFiles(std::vector<std::string> &Files) {
+  if (InputFilenames.empty()) {
+    Files.push_back("-");
+    return false;
+  }
+
+  for (unsigned i = 0, e = InputFilenames.size(); i != e; ++i) {
+    const std::string &Arg = InputFilenames[i];
+    bool IsDir = false;
+    if (Arg != "-")
+      sys::fs::is_directory(Arg, IsDir);
+    if (!IsDir) {
+      Files.push_back(Arg);
+      continue;
+    }
+
+    error_code EC;
+    for (sys::fs::directory_iterator DI(Arg, EC), DE; DI != DE && !EC;
+         DI.increment(EC))
+      if (sys::path::extension(DI->path()) == ".bc")
+        Files.push_back(DI->path());
+    if (EC)
+      return Error("Error reading directory '" + Arg + "': " + EC.message());
+  }
+
+  if (Files.empty())
+    return Error("No bitcode files found");
+  std::sort(Files.begin(), Files.end());
+  return false;
+}
 
 int main(int argc, char **argv) {
   // Print a stack trace if we signal out.
@@ -627,5 +713,22 @@ int main(int argc, char **argv) {
   llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
   cl::ParseCommandLineOptions(argc, argv, "llvm-bcanalyzer file analyzer\n");
 
-  return AnalyzeBitcode();
+  std::vector<std::string> Files;
+  if (CollectInputFiles(Files))
+    return 1;
+
+  // Parse every input in turn; the statistics tables aggregate across files.
+  uint64_t BufferSizeBits = 0;
+  unsigned NumTopBlocks = 0;
+  OwningPtr<MemoryBuffer> MemBuf;
+  OwningPtr<BitstreamReader> StreamFile;
+  for (unsigned i = 0, e = Files.size(); i != e; ++i)
+    if (AnalyzeBitcodeFile(Files[i], BufferSizeBits, NumTopBlocks,
+                           MemBuf, StreamFile))
+      return 1;
+
+  std::string Title = Files.size() == 1
+    ? Files[0] : utostr(Files.size()) + " files";
+  PrintAnalysis(Title, BufferSizeBits, NumTopBlocks, *StreamFile);
+  return 0;
 }
@@ -0,0 +1,211 @@
+//===- llvm-cost-bench.cpp - Compare TTI estimates to measured time -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This tool JIT-compiles benchmark functions from an IR file and reports the
+// cost the target's TargetTransformInfo stack predicts for each next to its
+// measured execution time, so target cost tables can be recalibrated against
+// hardware instead of guessed at.
+//
+// Every defined function that takes no arguments is treated as a benchmark:
+// it is called repeatedly through MCJIT and the best time per call over a
+// number of samples is reported.  The predicted column is the sum of the TTI
+// estimates over the function body; instructions the cost model cannot price
+// are counted separately so a large "unknown" count flags an untrustworthy
+// prediction.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/JIT.h"
+#include "llvm/ExecutionEngine/MCJIT.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/IRReader.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include <vector>
+using namespace llvm;
+
+static cl::opt<std::string>
+InputFile(cl::desc("<input IR file>"), cl::Positional, cl::init("-"));
+
+static cl::opt<unsigned>
+MinSampleMillis("min-sample-time",
+                cl::desc("Minimum time per sample in milliseconds"),
+                cl::init(50));
+
+static cl::opt<unsigned>
+NumSamples("samples",
+           cl::desc("Samples per function; the best one is reported"),
+           cl::init(3));
+
+namespace {
+
+/// The summed TTI estimate for one function, plus the number of instructions
+/// the cost model could not price.
+struct PredictedCost {
+  int64_t Units;
+  unsigned Unknown;
+  PredictedCost() : Units(0), Unknown(0) {}
+};
+
+/// CostEstimator - Sums the per-instruction TTI estimate over each function.
+/// Run below a target's addAnalysisPasses so the prediction comes from the
+/// same analysis stack the vectorizers query.
+class CostEstimator : public FunctionPass {
+  DenseMap<const Function*, PredictedCost> &Costs;
+
+public:
+  static char ID;
+  explicit CostEstimator(DenseMap<const Function*, PredictedCost> &costs)
+    : FunctionPass(ID), Costs(costs) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    AU.setPreservesAll();
+  }
+
+  virtual bool runOnFunction(Function &F) {
+    const TargetTransformInfo *TTI =
+      getAnalysisIfAvailable<TargetTransformInfo>();
+    PredictedCost &PC = Costs[&F];
+    for (Function::iterator B = F.begin(), BE = F.end(); B != BE; ++B) {
+      for (BasicBlock::iterator I = B->begin(), E = B->end(); I != E; ++I) {
+        unsigned Cost = TTI ? TTI->getInstructionCost(I) : (unsigned)-1;
+        if (Cost == (unsigned)-1)
+          ++PC.Unknown;
+        else
+          PC.Units += Cost;
+      }
+    }
+    return false;
+  }
+};
+
+} // end anonymous namespace
+
+char CostEstimator::ID = 0;
+
+/// Time one call of Fn, in nanoseconds, by running it in batches that double
+/// until a batch takes at least the minimum sample time.
+static double timeFunction(void (*Fn)()) {
+  double Best = -1.0;
+  uint64_t MinSampleNS = uint64_t(MinSampleMillis) * 1000000;
+  for (unsigned Sample = 0; Sample != NumSamples; ++Sample) {
+    for (uint64_t Iters = 1;; Iters *= 2) {
+      sys::TimeValue Start = sys::TimeValue::now();
+      for (uint64_t i = 0; i != Iters; ++i)
+        Fn();
+      sys::TimeValue Elapsed = sys::TimeValue::now() - Start;
+      uint64_t NS = uint64_t(Elapsed.seconds()) * 1000000000 +
+                    Elapsed.nanoseconds();
+      if (NS < MinSampleNS && Iters < (uint64_t(1) << 40))
+        continue;
+      double PerCall = double(NS) / double(Iters);
+      if (Best < 0 || PerCall < Best)
+        Best = PerCall;
+      break;
+    }
+  }
+  return Best;
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  LLVMContext &Context = getGlobalContext();
+  llvm_shutdown_obj Y;
+  cl::ParseCommandLineOptions(argc, argv, "llvm cost model benchmark\n");
+
+  SMDiagnostic Err;
+  Module *M = ParseIRFile(InputFile, Err, Context);
+  if (M == 0) {
+    Err.print(argv[0], errs());
+    return 1;
+  }
+
+  InitializeNativeTarget();
+  InitializeNativeTargetAsmPrinter();
+  InitializeNativeTargetAsmParser();
+
+  // Every defined zero-argument function is a benchmark.
+  std::vector<Function*> Benchmarks;
+  for (Module::iterator F = M->begin(), E = M->end(); F != E; ++F)
+    if (!F->isDeclaration() && F->arg_empty())
+      Benchmarks.push_back(F);
+  if (Benchmarks.empty()) {
+    errs() << argv[0] << ": no zero-argument function definitions found\n";
+    return 1;
+  }
+
+  std::string ErrorMsg;
+  EngineBuilder Builder(M);
+  Builder.setErrorStr(&ErrorMsg);
+  Builder.setEngineKind(EngineKind::JIT);
+  Builder.setUseMCJIT(true);
+  Builder.setJITMemoryManager(new SectionMemoryManager());
+
+  TargetMachine *TM = Builder.selectTarget();
+  if (TM == 0) {
+    errs() << argv[0] << ": could not select a target: " << ErrorMsg << '\n';
+    return 1;
+  }
+
+  // Predict costs before the JIT compiles the module, through the same TTI
+  // stack LoopVectorize and BBVectorize would use for this target.
+  DenseMap<const Function*, PredictedCost> Predicted;
+  {
+    PassManager PM;
+    TM->addAnalysisPasses(PM);
+    PM.add(new CostEstimator(Predicted));
+    PM.run(*M);
+  }
+
+  OwningPtr<ExecutionEngine> EE(Builder.create(TM));
+  if (!EE) {
+    errs() << argv[0] << ": failed to construct ExecutionEngine: "
+           << ErrorMsg << '\n';
+    return 1;
+  }
+  EE->finalizeObject();
+
+  outs() << "Target: " << TM->getTargetTriple()
+         << " cpu=" << TM->getTargetCPU() << "\n\n";
+  outs() << format("%-40s %10s %8s %16s\n", (const char*)"Function",
+                   (const char*)"Predicted", (const char*)"Unknown",
+                   (const char*)"Measured ns/call");
+  for (unsigned i = 0, e = Benchmarks.size(); i != e; ++i) {
+    Function *F = Benchmarks[i];
+    void (*Fn)() = (void(*)())(intptr_t)EE->getPointerToFunction(F);
+    if (Fn == 0) {
+      errs() << argv[0] << ": could not JIT '" << F->getName() << "'\n";
+      continue;
+    }
+    const PredictedCost &PC = Predicted[F];
+    double NS = timeFunction(Fn);
+    outs() << format("%-40s %10lld %8u %16.2f\n",
+                     F->getName().str().c_str(), (long long)PC.Units,
+                     PC.Unknown, NS);
+  }
+
+  return 0;
+}
@@ -27,9 +27,30 @@ DumpGCOV("dump", cl::init(false), cl::desc("dump gcov file"));
 static cl::opt<std::string>
 InputGCNO("gcno", cl::desc("<input gcno file>"), cl::init(""));
 
+static cl::list<std::string>
+InputGCDA("gcda", cl::desc("<input gcda files>"));
+
 static cl::opt<std::string>
-InputGCDA("gcda", cl::desc("<input gcda file>"), cl::init(""));
+InputGCDAList("gcda-list", cl::init(""),
+              cl::desc("<file with one gcda path per line>"));
 
+/// readGCDAFile - Map a .gcda file into memory and merge its counters into
+/// GF.  The file is mapped rather than read since batch aggregation visits
+/// thousands of files and only touches a fraction of each one's pages.
+static bool readGCDAFile(StringRef Filename, GCOVFile &GF) {
+  OwningPtr<MemoryBuffer> GCDA_Buff;
+  if (error_code ec = MemoryBuffer::getFile(Filename, GCDA_Buff, -1,
+                                            /*RequiresNullTerminator=*/false)) {
+    errs() << Filename << ": " << ec.message() << "\n";
+    return false;
+  }
+  GCOVBuffer GCDA_GB(GCDA_Buff.take());
+  if (!GF.read(GCDA_GB)) {
+    errs() << Filename << ": Invalid .gcda File!\n";
+    return false;
+  }
+  return true;
+}
 
 //===----------------------------------------------------------------------===//
 int main(int argc, char **argv) {
@@ -55,17 +76,28 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  if (!InputGCDA.empty()) {
-    OwningPtr<MemoryBuffer> GCDA_Buff;
-    if (error_code ec = MemoryBuffer::getFileOrSTDIN(InputGCDA, GCDA_Buff)) {
-      errs() << InputGCDA << ": " << ec.message() << "\n";
+  // Merge every requested .gcda file into the one GCOVFile; block counters
+  // accumulate across reads, giving a single combined report.
+  for (unsigned i = 0, e = InputGCDA.size(); i != e; ++i)
+    if (!readGCDAFile(InputGCDA[i], GF))
       return 1;
-    }
-    GCOVBuffer GCDA_GB(GCDA_Buff.take());
-    if (!GF.read(GCDA_GB)) {
-      errs() << "Invalid .gcda File!\n";
+
+  if (!InputGCDAList.empty()) {
+    OwningPtr<MemoryBuffer> List_Buff;
+    if (error_code ec = MemoryBuffer::getFileOrSTDIN(InputGCDAList,
+                                                     List_Buff)) {
+      errs() << InputGCDAList << ": " << ec.message() << "\n";
       return 1;
     }
+    SmallVector<StringRef, 64> Paths;
+    List_Buff->getBuffer().split(Paths, "\n");
+    for (unsigned i = 0, e = Paths.size(); i != e; ++i) {
+      StringRef Path = Paths[i].trim();
+      if (Path.empty())
+        continue;
+      if (!readGCDAFile(Path, GF))
+        return 1;
+    }
   }
 
 
@@ -13,6 +13,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Linker.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/Analysis/Verifier.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/LLVMContext.h"
@@ -20,11 +21,13 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/IRReader.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/SystemUtils.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/system_error.h"
 #include <memory>
 using namespace llvm;
 
@@ -49,12 +52,33 @@ Verbose("v", cl::desc("Print information about actions taken"));
 static cl::opt<bool>
 DumpAsm("d", cl::desc("Print assembly as linked"), cl::Hidden);
 
+static cl::opt<bool>
+ThinMode("thin",
+         cl::desc("Link the first module in full, then import from the "
+                  "remaining (bitcode) modules only the function bodies the "
+                  "composite references, deciding from their function "
+                  "summary blocks"));
+
+static cl::opt<unsigned>
+ThinImportLimit("thin-import-limit", cl::init(100), cl::Hidden,
+                cl::desc("In -thin mode, do not import function bodies whose "
+                         "summary reports more instructions than this"));
+
+static cl::opt<bool>
+StreamingMode("streaming",
+              cl::desc("Load inputs after the first lazily; the linker then "
+                       "materializes one function body at a time and frees "
+                       "it once copied, bounding peak memory"));
+
 // LoadFile - Read the specified bitcode file in and return it.  This routine
-// searches the link path for the specified file to try to find it...
+// searches the link path for the specified file to try to find it...  If
+// Lazy is set, bitcode function bodies are left in the file and materialized
+// on demand instead of being parsed up front.
 //
 static inline std::auto_ptr<Module> LoadFile(const char *argv0,
-                                             const std::string &FN, 
-                                             LLVMContext& Context) {
+                                             const std::string &FN,
+                                             LLVMContext& Context,
+                                             bool Lazy = false) {
   sys::Path Filename;
   if (!Filename.set(FN)) {
     errs() << "Invalid file name: '" << FN << "'\n";
@@ -64,15 +88,78 @@ static inline std::auto_ptr<Module> LoadFile(const char *argv0,
   SMDiagnostic Err;
   if (Verbose) errs() << "Loading '" << Filename.c_str() << "'\n";
   Module* Result = 0;
-  
+
   const std::string &FNStr = Filename.str();
-  Result = ParseIRFile(FNStr, Err, Context);
+  Result = Lazy ? getLazyIRFileModule(FNStr, Err, Context)
+                : ParseIRFile(FNStr, Err, Context);
   if (Result) return std::auto_ptr<Module>(Result);   // Load successful!
 
   Err.print(argv0, errs());
   return std::auto_ptr<Module>();
 }
 
+// ImportModuleThin - Lazily load the bitcode file FN and link into Composite
+// only the function bodies that the composite references and that the file's
+// function summary block reports as small enough; nothing else is ever
+// materialized.  Returns true on error.
+static bool ImportModuleThin(const char *argv0, Module *Composite,
+                             const std::string &FN, LLVMContext &Context) {
+  OwningPtr<MemoryBuffer> Buffer;
+  if (error_code ec = MemoryBuffer::getFileOrSTDIN(FN, Buffer)) {
+    errs() << argv0 << ": error loading file '" << FN << "': "
+           << ec.message() << "\n";
+    return true;
+  }
+
+  std::string ErrorMessage;
+  StringMap<FunctionSummary> Summaries;
+  if (getBitcodeFunctionSummaries(Buffer.get(), Context, Summaries,
+                                  &ErrorMessage)) {
+    errs() << argv0 << ": error reading summaries of '" << FN << "': "
+           << ErrorMessage << "\n";
+    return true;
+  }
+
+  Module *Src = getLazyBitcodeModule(Buffer.take(), Context, &ErrorMessage);
+  if (Src == 0) {
+    errs() << argv0 << ": error loading file '" << FN << "': "
+           << ErrorMessage << "\n";
+    return true;
+  }
+
+  // Decide what to import: bodies the composite references but does not
+  // define, and whose summary stays under the import limit.  Bodies without
+  // a summary entry (older bitcode) are assumed importable.
+  SmallPtrSet<Function*, 8> Imports;
+  for (Module::iterator F = Src->begin(), E = Src->end(); F != E; ++F) {
+    if (F->isDeclaration() && !F->isMaterializable())
+      continue;
+    Function *DstF = Composite->getFunction(F->getName());
+    if (DstF == 0 || !DstF->isDeclaration() || DstF->use_empty())
+      continue;
+    StringMap<FunctionSummary>::iterator S = Summaries.find(F->getName());
+    if (S != Summaries.end() && S->second.NumInsts > ThinImportLimit) {
+      if (Verbose)
+        errs() << "  Not importing '" << F->getName() << "' ("
+               << S->second.NumInsts << " instructions)\n";
+      continue;
+    }
+    if (Verbose) errs() << "  Importing '" << F->getName() << "'\n";
+    Imports.insert(F);
+  }
+
+  if (Linker::LinkModules(Composite, Src, Linker::DestroySource, &Imports,
+                          &ErrorMessage)) {
+    errs() << argv0 << ": link error in '" << FN << "': "
+           << ErrorMessage << "\n";
+    delete Src;
+    return true;
+  }
+
+  delete Src;
+  return false;
+}
+
 int main(int argc, char **argv) {
   // Print a stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -94,8 +181,22 @@ int main(int argc, char **argv) {
   }
 
   for (unsigned i = BaseArg+1; i < InputFilenames.size(); ++i) {
+    // In thin mode, later modules are lazily loaded and only selected
+    // function bodies are linked in.
+    if (ThinMode) {
+      if (Verbose) errs() << "Importing from '" << InputFilenames[i] << "'\n";
+      if (ImportModuleThin(argv[0], Composite.get(), InputFilenames[i],
+                           Context))
+        return 1;
+      continue;
+    }
+
+    // In streaming mode, load the source lazily; LinkModules materializes
+    // one function body at a time and dematerializes it after it has been
+    // copied, so the whole source is never in memory at once.
     std::auto_ptr<Module> M(LoadFile(argv[0],
-                                     InputFilenames[i], Context));
+                                     InputFilenames[i], Context,
+                                     StreamingMode));
     if (M.get() == 0) {
       errs() << argv[0] << ": error loading file '" <<InputFilenames[i]<< "'\n";
       return 1;
@@ -14,6 +14,7 @@
 
 #include "Disassembler.h"
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/MC/MCAsmBackend.h"
 #include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/MCCodeEmitter.h"
@@ -34,6 +35,7 @@
 #include "llvm/Support/Host.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PathV2.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/SourceMgr.h"
@@ -43,8 +45,8 @@
 #include "llvm/Support/system_error.h"
 using namespace llvm;
 
-static cl::opt<std::string>
-InputFilename(cl::Positional, cl::desc("<input file>"), cl::init("-"));
+static cl::list<std::string>
+InputFilenames(cl::Positional, cl::desc("<input files>"), cl::ZeroOrMore);
 
 static cl::opt<std::string>
 OutputFilename("o", cl::desc("Output filename"),
@@ -208,12 +210,22 @@ static const Target *GetTarget(const char *ProgName) {
   return TheTarget;
 }
 
-static tool_output_file *GetOutputStream() {
-  if (OutputFilename == "")
-    OutputFilename = "-";
+/// GetOutputFilename - Pick the output name for an input file.  A single
+/// input keeps the old behavior of honoring -o and defaulting to stdout;
+/// in batch mode (several inputs in one invocation) each output name is
+/// derived from its input.
+static std::string GetOutputFilename(StringRef Input, bool Batch) {
+  if (!Batch)
+    return OutputFilename.empty() ? std::string("-") : OutputFilename;
+
+  SmallString<128> Path(Input);
+  sys::path::replace_extension(Path, FileType == OFT_AssemblyFile ? "s" : "o");
+  return Path.str();
+}
 
+static tool_output_file *GetOutputStream(StringRef OutFile) {
   std::string Err;
-  tool_output_file *Out = new tool_output_file(OutputFilename.c_str(), Err,
+  tool_output_file *Out = new tool_output_file(OutFile.str().c_str(), Err,
                                                raw_fd_ostream::F_Binary);
   if (!Err.empty()) {
     errs() << Err << '\n';
@@ -340,32 +352,14 @@ static int AssembleInput(const char *ProgName, const Target *TheTarget,
   return Res;
 }
 
-int main(int argc, char **argv) {
-  // Print a stack trace if we signal out.
-  sys::PrintStackTraceOnErrorSignal();
-  PrettyStackTraceProgram X(argc, argv);
-  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
-
-  // Initialize targets and assembly printers/parsers.
-  llvm::InitializeAllTargetInfos();
-  llvm::InitializeAllTargetMCs();
-  llvm::InitializeAllAsmParsers();
-  llvm::InitializeAllDisassemblers();
-
-  // Register the target printer for --version.
-  cl::AddExtraVersionPrinter(TargetRegistry::printRegisteredTargetsForVersion);
-
-  cl::ParseCommandLineOptions(argc, argv, "llvm machine code playground\n");
-  TripleName = Triple::normalize(TripleName);
-  setDwarfDebugFlags(argc, argv);
-
-  setDwarfDebugProducer();
-
-  const char *ProgName = argv[0];
-  const Target *TheTarget = GetTarget(ProgName);
-  if (!TheTarget)
-    return 1;
-
+/// ProcessFile - Assemble (or lex, or disassemble) a single input file.  All
+/// per-file state (source manager, MC context, streamer) is created fresh
+/// here; target-level objects that are immutable across files are passed in
+/// so that batch invocations build them only once.
+static int ProcessFile(const char *ProgName, const Target *TheTarget,
+                       MCAsmInfo &MAI, MCRegisterInfo &MRI, MCInstrInfo &MCII,
+                       StringRef FeaturesStr, StringRef InputFilename,
+                       StringRef OutFile) {
   OwningPtr<MemoryBuffer> BufferPtr;
   if (error_code ec = MemoryBuffer::getFileOrSTDIN(InputFilename, BufferPtr)) {
     errs() << ProgName << ": " << ec.message() << '\n';
@@ -382,16 +376,10 @@ int main(int argc, char **argv) {
   // it later.
   SrcMgr.setIncludeDirs(IncludeDirs);
 
-  llvm::OwningPtr<MCAsmInfo> MAI(TheTarget->createMCAsmInfo(TripleName));
-  assert(MAI && "Unable to create target asm info!");
-
-  llvm::OwningPtr<MCRegisterInfo> MRI(TheTarget->createMCRegInfo(TripleName));
-  assert(MRI && "Unable to create target register info!");
-
   // FIXME: This is not pretty. MCContext has a ptr to MCObjectFileInfo and
   // MCObjectFileInfo needs a MCContext reference in order to initialize itself.
   OwningPtr<MCObjectFileInfo> MOFI(new MCObjectFileInfo());
-  MCContext Ctx(*MAI, *MRI, MOFI.get(), &SrcMgr);
+  MCContext Ctx(MAI, MRI, MOFI.get(), &SrcMgr);
   MOFI->InitMCObjectFileInfo(TripleName, RelocModel, CMModel, Ctx);
 
   if (SaveTempLabels)
@@ -407,34 +395,26 @@ int main(int argc, char **argv) {
   if (!MainFileName.empty())
     Ctx.setMainFileName(MainFileName);
 
-  // Package up features to be passed to target/subtarget
-  std::string FeaturesStr;
-  if (MAttrs.size()) {
-    SubtargetFeatures Features;
-    for (unsigned i = 0; i != MAttrs.size(); ++i)
-      Features.AddFeature(MAttrs[i]);
-    FeaturesStr = Features.getString();
-  }
-
-  OwningPtr<tool_output_file> Out(GetOutputStream());
+  OwningPtr<tool_output_file> Out(GetOutputStream(OutFile));
   if (!Out)
     return 1;
 
   formatted_raw_ostream FOS(Out->os());
   OwningPtr<MCStreamer> Str;
 
-  OwningPtr<MCInstrInfo> MCII(TheTarget->createMCInstrInfo());
+  // The subtarget info is per-file: target parsers may mutate it through
+  // directives like .cpu.
   OwningPtr<MCSubtargetInfo>
     STI(TheTarget->createMCSubtargetInfo(TripleName, MCPU, FeaturesStr));
 
   MCInstPrinter *IP;
   if (FileType == OFT_AssemblyFile) {
     IP =
-      TheTarget->createMCInstPrinter(OutputAsmVariant, *MAI, *MCII, *MRI, *STI);
+      TheTarget->createMCInstPrinter(OutputAsmVariant, MAI, MCII, MRI, *STI);
     MCCodeEmitter *CE = 0;
     MCAsmBackend *MAB = 0;
     if (ShowEncoding) {
-      CE = TheTarget->createMCCodeEmitter(*MCII, *MRI, *STI, Ctx);
+      CE = TheTarget->createMCCodeEmitter(MCII, MRI, *STI, Ctx);
       MAB = TheTarget->createMCAsmBackend(TripleName, MCPU);
     }
     bool UseCFI = !DisableCFI;
@@ -448,7 +428,7 @@ int main(int argc, char **argv) {
     Str.reset(createNullStreamer(Ctx));
   } else {
     assert(FileType == OFT_ObjectFile && "Invalid file type!");
-    MCCodeEmitter *CE = TheTarget->createMCCodeEmitter(*MCII, *MRI, *STI, Ctx);
+    MCCodeEmitter *CE = TheTarget->createMCCodeEmitter(MCII, MRI, *STI, Ctx);
     MCAsmBackend *MAB = TheTarget->createMCAsmBackend(TripleName, MCPU);
     Str.reset(TheTarget->createMCObjectStreamer(TripleName, Ctx, *MAB,
                                                 FOS, CE, RelaxAll,
@@ -459,10 +439,10 @@ int main(int argc, char **argv) {
   bool disassemble = false;
   switch (Action) {
   case AC_AsLex:
-    Res = AsLexInput(SrcMgr, *MAI, Out.get());
+    Res = AsLexInput(SrcMgr, MAI, Out.get());
     break;
   case AC_Assemble:
-    Res = AssembleInput(ProgName, TheTarget, SrcMgr, Ctx, *Str, *MAI, *STI);
+    Res = AssembleInput(ProgName, TheTarget, SrcMgr, Ctx, *Str, MAI, *STI);
     break;
   case AC_MDisassemble:
     IP->setUseMarkup(1);
@@ -484,3 +464,74 @@ int main(int argc, char **argv) {
   if (Res == 0) Out->keep();
   return Res;
 }
+
+int main(int argc, char **argv) {
+  // Print a stack trace if we signal out.
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+
+  // Initialize targets and assembly printers/parsers.
+  llvm::InitializeAllTargetInfos();
+  llvm::InitializeAllTargetMCs();
+  llvm::InitializeAllAsmParsers();
+  llvm::InitializeAllDisassemblers();
+
+  // Register the target printer for --version.
+  cl::AddExtraVersionPrinter(TargetRegistry::printRegisteredTargetsForVersion);
+
+  cl::ParseCommandLineOptions(argc, argv, "llvm machine code playground\n");
+  TripleName = Triple::normalize(TripleName);
+  setDwarfDebugFlags(argc, argv);
+
+  setDwarfDebugProducer();
+
+  const char *ProgName = argv[0];
+  const Target *TheTarget = GetTarget(ProgName);
+  if (!TheTarget)
+    return 1;
+
+  if (InputFilenames.empty())
+    InputFilenames.push_back("-");
+
+  // Batch mode: several input files in one invocation, each assembled into
+  // its own derived output file.  This amortizes process startup and target
+  // construction across the whole set, which dominates when assembling many
+  // generated .s files.
+  bool Batch = InputFilenames.size() > 1;
+  if (Batch && !OutputFilename.empty()) {
+    errs() << ProgName
+           << ": error: -o may not be used with multiple input files\n";
+    return 1;
+  }
+
+  llvm::OwningPtr<MCAsmInfo> MAI(TheTarget->createMCAsmInfo(TripleName));
+  assert(MAI && "Unable to create target asm info!");
+
+  llvm::OwningPtr<MCRegisterInfo> MRI(TheTarget->createMCRegInfo(TripleName));
+  assert(MRI && "Unable to create target register info!");
+
+  OwningPtr<MCInstrInfo> MCII(TheTarget->createMCInstrInfo());
+
+  // Package up features to be passed to target/subtarget
+  std::string FeaturesStr;
+  if (MAttrs.size()) {
+    SubtargetFeatures Features;
+    for (unsigned i = 0; i != MAttrs.size(); ++i)
+      Features.AddFeature(MAttrs[i]);
+    FeaturesStr = Features.getString();
+  }
+
+  int Res = 0;
+  for (unsigned i = 0, e = InputFilenames.size(); i != e; ++i) {
+    StringRef InputFilename = InputFilenames[i];
+    if (Batch && InputFilename == "-") {
+      errs() << ProgName
+             << ": error: stdin may not be mixed with named input files\n";
+      return 1;
+    }
+    Res |= ProcessFile(ProgName, TheTarget, *MAI, *MRI, *MCII, FeaturesStr,
+                       InputFilename, GetOutputFilename(InputFilename, Batch));
+  }
+  return Res;
+}
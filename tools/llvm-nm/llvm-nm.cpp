@@ -17,6 +17,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Bitcode/Archive.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/Module.h"
@@ -301,29 +302,26 @@ static void DumpSymbolNamesFromModule(Module *M) {
 }
 
 static void DumpSymbolNamesFromObject(ObjectFile *obj) {
-  error_code ec;
-  symbol_iterator ibegin = obj->begin_symbols();
-  symbol_iterator iend = obj->end_symbols();
-  if (DynamicSyms) {
-    ibegin = obj->begin_dynamic_symbols();
-    iend = obj->end_dynamic_symbols();
-  }
-  for (symbol_iterator i = ibegin; i != iend; i.increment(ec)) {
-    if (error(ec)) break;
-    uint32_t symflags;
-    if (error(i->getFlags(symflags))) break;
-    if (!DebugSyms && (symflags & SymbolRef::SF_FormatSpecific))
+  // Read the whole symbol table in one pass; object formats can implement
+  // this as a direct walk of their symbol table rather than a virtual call
+  // per attribute per symbol.
+  SmallVector<ObjectFile::SymbolDesc, 64> Syms;
+  // On a malformed object, report the error but still print whatever was
+  // collected before it, matching the old incremental behavior.
+  error(obj->readSymbols(Syms, DynamicSyms));
+  for (unsigned i = 0, e = Syms.size(); i != e; ++i) {
+    const ObjectFile::SymbolDesc &D = Syms[i];
+    if (!DebugSyms && (D.Flags & SymbolRef::SF_FormatSpecific))
       continue;
     NMSymbol s;
     s.Size = object::UnknownAddressOrSize;
     s.Address = object::UnknownAddressOrSize;
-    if (PrintSize || SizeSort) {
-      if (error(i->getSize(s.Size))) break;
-    }
+    if (PrintSize || SizeSort)
+      s.Size = D.Size;
     if (PrintAddress)
-      if (error(i->getAddress(s.Address))) break;
-    if (error(i->getNMTypeChar(s.TypeChar))) break;
-    if (error(i->getName(s.Name))) break;
+      s.Address = D.Address;
+    s.TypeChar = D.TypeChar;
+    s.Name = D.Name;
     SymbolList.push_back(s);
   }
 
@@ -33,6 +33,7 @@
 #include "llvm/Object/COFF.h"
 #include "llvm/Object/MachO.h"
 #include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/Atomic.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
@@ -48,6 +49,7 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/system_error.h"
 #include <algorithm>
@@ -108,6 +110,11 @@ static cl::opt<bool>
 NoShowRawInsn("no-show-raw-insn", cl::desc("When disassembling instructions, "
                                            "do not print the instruction bytes."));
 
+static cl::opt<unsigned>
+DisassembleThreads("disassemble-threads", cl::init(1),
+  cl::desc("Number of threads used to disassemble symbol ranges "
+           "(default = 1)"));
+
 static cl::opt<bool>
 UnwindInfo("unwind-info", cl::desc("Display unwind information"));
 
@@ -159,6 +166,10 @@ static const Target *getTarget(const ObjectFile *Obj = NULL) {
 void llvm::StringRefMemoryObject::anchor() { }
 
 void llvm::DumpBytes(StringRef bytes) {
+  DumpBytes(bytes, outs());
+}
+
+void llvm::DumpBytes(StringRef bytes, raw_ostream &OS) {
   static const char hex_rep[] = "0123456789abcdef";
   // FIXME: The real way to do this is to figure out the longest instruction
   //        and align to that size before printing. I'll fix this when I get
@@ -181,7 +192,7 @@ void llvm::DumpBytes(StringRef bytes) {
   }
 
   output[sizeof(output) - 1] = 0;
-  outs() << output;
+  OS << output;
 }
 
 bool llvm::RelocAddressLess(RelocationRef a, RelocationRef b) {
@@ -191,6 +202,128 @@ bool llvm::RelocAddressLess(RelocationRef a, RelocationRef b) {
   return a_addr < b_addr;
 }
 
+namespace {
+// SymbolRange - A run of instructions between two symbol boundaries in a
+// text section, together with the relocations that fall inside it.
+struct SymbolRange {
+  uint64_t Start, End;
+  StringRef Name;
+  unsigned RelBegin, RelEnd;
+};
+} // end anonymous namespace
+
+/// DisassembleRange - Disassemble one symbol range and print it to OS.
+static void DisassembleRange(const MCDisassembler &DisAsm, MCInstPrinter &IP,
+                             const MemoryObject &Memory, StringRef Bytes,
+                             uint64_t SectionAddr, const SymbolRange &R,
+                             const std::vector<RelocationRef> &Rels,
+                             raw_ostream &OS) {
+  OS << '\n' << R.Name << ":\n";
+
+#ifndef NDEBUG
+  raw_ostream &DebugOut = DebugFlag ? dbgs() : nulls();
+#else
+  raw_ostream &DebugOut = nulls();
+#endif
+
+  unsigned RelCur = R.RelBegin;
+  uint64_t Size;
+  for (uint64_t Index = R.Start; Index < R.End; Index += Size) {
+    MCInst Inst;
+
+    if (DisAsm.getInstruction(Inst, Size, Memory, Index,
+                              DebugOut, nulls())) {
+      OS << format("%8" PRIx64 ":", SectionAddr + Index);
+      if (!NoShowRawInsn) {
+        OS << "\t";
+        DumpBytes(StringRef(Bytes.data() + Index, Size), OS);
+      }
+      IP.printInst(&Inst, OS, "");
+      OS << "\n";
+    } else {
+      errs() << ToolName << ": warning: invalid instruction encoding\n";
+      if (Size == 0)
+        Size = 1; // skip illegible bytes
+    }
+
+    // Print relocation for instruction.
+    while (RelCur != R.RelEnd) {
+      bool hidden = false;
+      uint64_t addr;
+      SmallString<16> name;
+      SmallString<32> val;
+
+      // If this relocation is hidden, skip it.
+      if (error(Rels[RelCur].getHidden(hidden))) goto skip_print_rel;
+      if (hidden) goto skip_print_rel;
+
+      if (error(Rels[RelCur].getAddress(addr))) goto skip_print_rel;
+      // Stop when the relocation's address is past the current instruction.
+      if (addr >= Index + Size) break;
+      if (error(Rels[RelCur].getTypeName(name))) goto skip_print_rel;
+      if (error(Rels[RelCur].getValueString(val))) goto skip_print_rel;
+
+      OS << format("\t\t\t%8" PRIx64 ": ", SectionAddr + addr) << name
+         << "\t" << val << "\n";
+
+    skip_print_rel:
+      ++RelCur;
+    }
+  }
+}
+
+namespace {
+// DisassembleContext - Shared state for the parallel disassembly workers.
+// Everything reachable from here is read-only except the output slots,
+// which are disjoint per range, and the atomic claim counter.
+struct DisassembleContext {
+  const Target *TheTarget;
+  const std::string *FeaturesStr;
+  const StringRefMemoryObject *Memory;
+  StringRef Bytes;
+  uint64_t SectionAddr;
+  const std::vector<SymbolRange> *Ranges;
+  const std::vector<RelocationRef> *Rels;
+  std::vector<std::string> *Outputs;
+  volatile sys::cas_flag NextIdx;
+  volatile sys::cas_flag Failed;
+};
+} // end anonymous namespace
+
+static void DisassembleWorker(void *Arg) {
+  DisassembleContext &Ctx = *static_cast<DisassembleContext*>(Arg);
+
+  // Each worker gets private MC objects; the disassembler and the
+  // instruction printer carry mutable state.
+  OwningPtr<const MCAsmInfo> AsmInfo(
+    Ctx.TheTarget->createMCAsmInfo(TripleName));
+  OwningPtr<const MCSubtargetInfo> STI(
+    Ctx.TheTarget->createMCSubtargetInfo(TripleName, "", *Ctx.FeaturesStr));
+  OwningPtr<const MCRegisterInfo> MRI(
+    Ctx.TheTarget->createMCRegInfo(TripleName));
+  OwningPtr<const MCInstrInfo> MII(Ctx.TheTarget->createMCInstrInfo());
+  OwningPtr<const MCDisassembler> DisAsm;
+  if (STI)
+    DisAsm.reset(Ctx.TheTarget->createMCDisassembler(*STI));
+  OwningPtr<MCInstPrinter> IP;
+  if (AsmInfo && STI && MRI && MII)
+    IP.reset(Ctx.TheTarget->createMCInstPrinter(
+               AsmInfo->getAssemblerDialect(), *AsmInfo, *MII, *MRI, *STI));
+  if (!DisAsm || !IP) {
+    Ctx.Failed = 1;
+    return;
+  }
+
+  for (;;) {
+    unsigned Idx = sys::AtomicIncrement(&Ctx.NextIdx) - 1;
+    if (Idx >= Ctx.Ranges->size())
+      return;
+    raw_string_ostream OS((*Ctx.Outputs)[Idx]);
+    DisassembleRange(*DisAsm, *IP, *Ctx.Memory, Ctx.Bytes, Ctx.SectionAddr,
+                     (*Ctx.Ranges)[Idx], *Ctx.Rels, OS);
+  }
+}
+
 static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   const Target *TheTarget = getTarget(Obj);
   // getTarget() will have already issued a diagnostic if necessary, so
@@ -318,14 +451,13 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
     StringRef Bytes;
     if (error(i->getContents(Bytes))) break;
     StringRefMemoryObject memoryObject(Bytes);
-    uint64_t Size;
-    uint64_t Index;
     uint64_t SectSize;
     if (error(i->getSize(SectSize))) break;
 
-    std::vector<RelocationRef>::const_iterator rel_cur = Rels.begin();
-    std::vector<RelocationRef>::const_iterator rel_end = Rels.end();
-    // Disassemble symbol by symbol.
+    // Split the section into symbol ranges, assigning each range the
+    // relocations that fall inside it.
+    std::vector<SymbolRange> Ranges;
+    unsigned RelIdx = 0;
     for (unsigned si = 0, se = Symbols.size(); si != se; ++si) {
       uint64_t Start = Symbols[si].first;
       uint64_t End;
@@ -340,57 +472,58 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
         // This symbol has the same address as the next symbol. Skip it.
         continue;
 
-      outs() << '\n' << Symbols[si].second << ":\n";
-
-#ifndef NDEBUG
-        raw_ostream &DebugOut = DebugFlag ? dbgs() : nulls();
-#else
-        raw_ostream &DebugOut = nulls();
-#endif
-
-      for (Index = Start; Index < End; Index += Size) {
-        MCInst Inst;
-
-        if (DisAsm->getInstruction(Inst, Size, memoryObject, Index,
-                                   DebugOut, nulls())) {
-          outs() << format("%8" PRIx64 ":", SectionAddr + Index);
-          if (!NoShowRawInsn) {
-            outs() << "\t";
-            DumpBytes(StringRef(Bytes.data() + Index, Size));
-          }
-          IP->printInst(&Inst, outs(), "");
-          outs() << "\n";
-        } else {
-          errs() << ToolName << ": warning: invalid instruction encoding\n";
-          if (Size == 0)
-            Size = 1; // skip illegible bytes
-        }
-
-        // Print relocation for instruction.
-        while (rel_cur != rel_end) {
-          bool hidden = false;
-          uint64_t addr;
-          SmallString<16> name;
-          SmallString<32> val;
-
-          // If this relocation is hidden, skip it.
-          if (error(rel_cur->getHidden(hidden))) goto skip_print_rel;
-          if (hidden) goto skip_print_rel;
-
-          if (error(rel_cur->getAddress(addr))) goto skip_print_rel;
-          // Stop when rel_cur's address is past the current instruction.
-          if (addr >= Index + Size) break;
-          if (error(rel_cur->getTypeName(name))) goto skip_print_rel;
-          if (error(rel_cur->getValueString(val))) goto skip_print_rel;
-
-          outs() << format("\t\t\t%8" PRIx64 ": ", SectionAddr + addr) << name
-                 << "\t" << val << "\n";
+      SymbolRange R;
+      R.Start = Start;
+      R.End = End;
+      R.Name = Symbols[si].second;
+      R.RelBegin = RelIdx;
+      uint64_t addr;
+      while (RelIdx != Rels.size() && !Rels[RelIdx].getAddress(addr) &&
+             addr < End)
+        ++RelIdx;
+      R.RelEnd = RelIdx;
+      Ranges.push_back(R);
+    }
 
-        skip_print_rel:
-          ++rel_cur;
-        }
-      }
+    // Disassemble the ranges on worker threads if requested, buffering each
+    // range's output and printing the buffers in order.  Otherwise print as
+    // we go.
+    bool Parallel = DisassembleThreads > 1 && Ranges.size() > 1 &&
+                    llvm_is_multithreaded();
+    if (Parallel) {
+      std::vector<std::string> Outputs(Ranges.size());
+      DisassembleContext Ctx;
+      Ctx.TheTarget = TheTarget;
+      Ctx.FeaturesStr = &FeaturesStr;
+      Ctx.Memory = &memoryObject;
+      Ctx.Bytes = Bytes;
+      Ctx.SectionAddr = SectionAddr;
+      Ctx.Ranges = &Ranges;
+      Ctx.Rels = &Rels;
+      Ctx.Outputs = &Outputs;
+      Ctx.NextIdx = 0;
+      Ctx.Failed = 0;
+
+      unsigned NumThreads = DisassembleThreads;
+      if (NumThreads > Ranges.size())
+        NumThreads = Ranges.size();
+      std::vector<void*> Workers(NumThreads);
+      for (unsigned ti = 0; ti != NumThreads; ++ti)
+        Workers[ti] = llvm_launch_thread(DisassembleWorker, &Ctx);
+      for (unsigned ti = 0; ti != NumThreads; ++ti)
+        llvm_join_thread(Workers[ti]);
+
+      if (!Ctx.Failed) {
+        for (unsigned ri = 0, re = Outputs.size(); ri != re; ++ri)
+          outs() << Outputs[ri];
+      } else
+        // A worker could not build its MC objects; disassemble in place.
+        Parallel = false;
     }
+    if (!Parallel)
+      for (unsigned ri = 0, re = Ranges.size(); ri != re; ++ri)
+        DisassembleRange(*DisAsm, *IP, memoryObject, Bytes, SectionAddr,
+                         Ranges[ri], Rels, outs());
   }
 }
 
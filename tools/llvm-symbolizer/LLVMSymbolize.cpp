@@ -223,6 +223,14 @@ ModuleInfo *LLVMSymbolizer::getOrCreateModuleInfo(
     }
     Context = DIContext::getDWARFContext(DbgObj);
     assert(Context);
+    // Point the context at a per-module index file so the address range
+    // table survives across runs against the same binary.
+    if (!Opts.CacheDir.empty()) {
+      SmallString<256> CachePath = StringRef(Opts.CacheDir);
+      sys::path::append(CachePath,
+                        Twine(sys::path::filename(ModuleName)) + ".aridx");
+      Context->setArangesCachePath(CachePath.str());
+    }
   }
 
   ModuleInfo *Info = new ModuleInfo(Obj, Context);
@@ -35,12 +35,17 @@ public:
     bool PrintFunctions : 1;
     bool PrintInlining : 1;
     bool Demangle : 1;
+    // Directory used to cache symbolization indexes (currently the DWARF
+    // address range tables) between runs.  Empty means no caching.
+    std::string CacheDir;
     Options(bool UseSymbolTable = true, bool PrintFunctions = true,
-            bool PrintInlining = true, bool Demangle = true)
+            bool PrintInlining = true, bool Demangle = true,
+            const std::string &CacheDir = "")
         : UseSymbolTable(UseSymbolTable),
           PrintFunctions(PrintFunctions),
           PrintInlining(PrintInlining),
-          Demangle(Demangle) { }
+          Demangle(Demangle),
+          CacheDir(CacheDir) { }
   };
 
   LLVMSymbolizer(const Options &Opts = Options()) : Opts(Opts) { }
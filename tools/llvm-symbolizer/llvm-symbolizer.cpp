@@ -48,6 +48,11 @@ static cl::opt<bool>
 ClDemangle("demangle", cl::init(true),
          cl::desc("Demangle function names"));
 
+static cl::opt<std::string>
+ClCacheDir("cache-dir", cl::init(""),
+         cl::desc("Directory used to cache symbolization indexes "
+                  "between runs"));
+
 static bool parseCommand(bool &IsData,
                          std::string &ModuleName,
                          uint64_t &ModuleOffset) {
@@ -91,7 +96,7 @@ int main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "llvm symbolizer for compiler-rt\n");
   LLVMSymbolizer::Options Opts(ClUseSymbolTable, ClPrintFunctions,
-                               ClPrintInlining, ClDemangle);
+                               ClPrintInlining, ClDemangle, ClCacheDir);
   LLVMSymbolizer Symbolizer(Opts);
 
   bool IsData = false;
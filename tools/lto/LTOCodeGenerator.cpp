@@ -14,7 +14,9 @@
 
 #include "LTOCodeGenerator.h"
 #include "LTOModule.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/Twine.h"
 #include "llvm/Analysis/Passes.h"
 #include "llvm/Analysis/Verifier.h"
 #include "llvm/Bitcode/ReaderWriter.h"
@@ -36,6 +38,7 @@
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/system_error.h"
 #include "llvm/Target/Mangler.h"
@@ -54,6 +57,8 @@ static cl::opt<bool>
 DisableGVNLoadPRE("disable-gvn-loadpre", cl::init(false),
   cl::desc("Do not run the GVN load PRE pass"));
 
+static Reloc::Model getRelocModel(lto_codegen_model model);
+
 const char* LTOCodeGenerator::getVersionString() {
 #ifdef LLVM_VERSION_INFO
   return PACKAGE_NAME " version " PACKAGE_VERSION ", " LLVM_VERSION_INFO;
@@ -67,7 +72,7 @@ LTOCodeGenerator::LTOCodeGenerator()
     _linker("LinkTimeOptimizer", "ld-temp.o", _context), _target(NULL),
     _emitDwarfDebugInfo(false), _scopeRestrictionsDone(false),
     _codeModel(LTO_CODEGEN_PIC_MODEL_DYNAMIC),
-    _nativeObjectFile(NULL) {
+    _nativeObjectFile(NULL), _parallelism(1) {
   InitializeAllTargets();
   InitializeAllTargetMCs();
   InitializeAllAsmPrinters();
@@ -187,6 +192,245 @@ bool LTOCodeGenerator::compile_to_file(const char** name, std::string& errMsg) {
   return false;
 }
 
+namespace {
+  /// PartitionCompileInfo - Everything a codegen worker thread needs to
+  /// compile its partition of the merged module, plus the result.  The
+  /// bitcode image is shared read-only; each worker reparses it into a
+  /// private LLVMContext so no IR is shared between threads.
+  struct PartitionCompileInfo {
+    StringRef Bitcode;
+    unsigned PartitionIndex;
+    unsigned NumPartitions;
+    const Target *march;
+    std::string TripleStr;
+    std::string CPU;
+    Reloc::Model RelocModel;
+    std::string ObjectPath;
+
+    std::string ErrorMessage;
+    bool Failed;
+
+    PartitionCompileInfo() : PartitionIndex(0), NumPartitions(1), march(NULL),
+                             RelocModel(Reloc::Default), Failed(false) {}
+  };
+}
+
+/// prepareModulePartition - Reduce a private copy of the merged module to the
+/// function bodies owned by partition \p Partition of \p NumPartitions.
+/// Local-linkage definitions are promoted to hidden external symbols with a
+/// partition-invariant rename, since the partitions become separate object
+/// files and cross-partition references must resolve at the final link.
+/// Global variable initializers and aliases are emitted by partition 0 only.
+static void prepareModulePartition(Module &M, unsigned Partition,
+                                   unsigned NumPartitions) {
+  // Every worker applies the same renaming to its copy, so iteration order
+  // keeps the promoted names consistent across partitions.
+  unsigned NextID = 0;
+  for (Module::global_iterator I = M.global_begin(), E = M.global_end();
+       I != E; ++I)
+    if (I->hasLocalLinkage()) {
+      I->setLinkage(GlobalValue::ExternalLinkage);
+      I->setVisibility(GlobalValue::HiddenVisibility);
+      I->setName(I->getName() + ".lto_priv." + Twine(NextID++));
+    }
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I)
+    if (I->hasLocalLinkage()) {
+      I->setLinkage(GlobalValue::ExternalLinkage);
+      I->setVisibility(GlobalValue::HiddenVisibility);
+      I->setName(I->getName() + ".lto_priv." + Twine(NextID++));
+    }
+
+  // Keep every NumPartitions'th function body, round robin; the rest become
+  // declarations.
+  unsigned Index = 0;
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
+    if (I->isDeclaration())
+      continue;
+    if (Index++ % NumPartitions != Partition)
+      I->deleteBody();
+  }
+
+  if (Partition != 0) {
+    for (Module::global_iterator I = M.global_begin(), E = M.global_end();
+         I != E; ++I)
+      if (I->hasInitializer()) {
+        I->setInitializer(NULL);
+        I->setLinkage(GlobalValue::ExternalLinkage);
+      }
+    // Aliases cannot be turned into declarations; refer to the aliasee
+    // directly instead.
+    for (Module::alias_iterator I = M.alias_begin(), E = M.alias_end();
+         I != E; ) {
+      GlobalAlias *GA = I++;
+      GA->replaceAllUsesWith(GA->getAliasee());
+      GA->eraseFromParent();
+    }
+  }
+}
+
+/// compilePartition - Worker thread entry point: reparse the merged module
+/// into a private context, prune it down to this worker's partition and run
+/// the codegen pipeline over it, writing a native object file to the
+/// partition's temp path.
+static void compilePartition(void *Arg) {
+  PartitionCompileInfo *Info = static_cast<PartitionCompileInfo*>(Arg);
+
+  LLVMContext Context;
+  OwningPtr<MemoryBuffer> Buffer(
+    MemoryBuffer::getMemBuffer(Info->Bitcode, "<partition>", false));
+  std::string ParseError;
+  OwningPtr<Module> M(ParseBitcodeFile(Buffer.get(), Context, &ParseError));
+  if (!M) {
+    Info->ErrorMessage = ParseError;
+    Info->Failed = true;
+    return;
+  }
+
+  prepareModulePartition(*M, Info->PartitionIndex, Info->NumPartitions);
+
+  SubtargetFeatures Features;
+  Features.getDefaultSubtargetFeatures(llvm::Triple(Info->TripleStr));
+  TargetOptions Options;
+  LTOModule::getTargetOptions(Options);
+  OwningPtr<TargetMachine>
+    target(Info->march->createTargetMachine(Info->TripleStr, Info->CPU,
+                                            Features.getString(), Options,
+                                            Info->RelocModel,
+                                            CodeModel::Default,
+                                            CodeGenOpt::Aggressive));
+  if (!target) {
+    Info->ErrorMessage = "could not create target machine";
+    Info->Failed = true;
+    return;
+  }
+
+  std::string OpenError;
+  raw_fd_ostream OS(Info->ObjectPath.c_str(), OpenError,
+                    raw_fd_ostream::F_Binary);
+  if (!OpenError.empty()) {
+    Info->ErrorMessage = OpenError;
+    Info->Failed = true;
+    return;
+  }
+
+  {
+    formatted_raw_ostream FOS(OS);
+
+    FunctionPassManager codeGenPasses(M.get());
+    codeGenPasses.add(new DataLayout(*target->getDataLayout()));
+    target->addAnalysisPasses(codeGenPasses);
+
+    if (target->addPassesToEmitFile(codeGenPasses, FOS,
+                                    TargetMachine::CGFT_ObjectFile)) {
+      Info->ErrorMessage = "target file type not supported";
+      Info->Failed = true;
+      return;
+    }
+
+    codeGenPasses.doInitialization();
+    for (Module::iterator it = M->begin(), e = M->end(); it != e; ++it)
+      if (!it->isDeclaration())
+        codeGenPasses.run(*it);
+    codeGenPasses.doFinalization();
+  }
+
+  OS.close();
+  if (OS.has_error()) {
+    OS.clear_error();
+    Info->ErrorMessage = "could not write object file: " + Info->ObjectPath;
+    Info->Failed = true;
+  }
+}
+
+bool LTOCodeGenerator::compile_to_files(const char*** names, size_t* numNames,
+                                        std::string& errMsg) {
+  _nativeObjectPaths.clear();
+  _nativeObjectPathRefs.clear();
+
+  // With no parallelism requested this degenerates to the single object
+  // file path.
+  if (_parallelism < 2) {
+    const char *name;
+    if (compile_to_file(&name, errMsg))
+      return true;
+    _nativeObjectPaths.push_back(name);
+    _nativeObjectPathRefs.push_back(_nativeObjectPaths[0].c_str());
+    *names = &_nativeObjectPathRefs[0];
+    *numNames = 1;
+    return false;
+  }
+
+  // Run the IPO pipeline over the merged module once, up front.
+  if (this->optimizeMergedModule(errMsg))
+    return true;
+
+  // Make the support libraries safe for concurrent codegen.
+  if (!llvm_is_multithreaded())
+    llvm_start_multithreaded();
+
+  // Serialize the optimized module; the workers reparse it rather than
+  // touching shared IR.
+  std::string Bitcode;
+  {
+    raw_string_ostream BOS(Bitcode);
+    WriteBitcodeToFile(_linker.getModule(), BOS);
+  }
+
+  std::string TripleStr = _linker.getModule()->getTargetTriple();
+  if (TripleStr.empty())
+    TripleStr = sys::getDefaultTargetTriple();
+  const Target *march = TargetRegistry::lookupTarget(TripleStr, errMsg);
+  if (march == NULL)
+    return true;
+
+  // Make a unique temp .o file per partition.
+  std::vector<PartitionCompileInfo> Partitions(_parallelism);
+  for (unsigned i = 0; i != _parallelism; ++i) {
+    sys::PathWithStatus uniqueObjPath("lto-llvm.o");
+    if (uniqueObjPath.createTemporaryFileOnDisk(false, &errMsg)) {
+      uniqueObjPath.eraseFromDisk();
+      for (unsigned j = 0; j != i; ++j)
+        sys::Path(Partitions[j].ObjectPath).eraseFromDisk();
+      return true;
+    }
+    sys::RemoveFileOnSignal(uniqueObjPath);
+
+    Partitions[i].Bitcode = StringRef(Bitcode);
+    Partitions[i].PartitionIndex = i;
+    Partitions[i].NumPartitions = _parallelism;
+    Partitions[i].march = march;
+    Partitions[i].TripleStr = TripleStr;
+    Partitions[i].CPU = _mCpu;
+    Partitions[i].RelocModel = getRelocModel(_codeModel);
+    Partitions[i].ObjectPath = uniqueObjPath.str();
+  }
+
+  // Partition 0 is compiled on this thread while the workers run.
+  std::vector<void*> Threads(_parallelism, (void*)0);
+  for (unsigned i = 1; i != _parallelism; ++i)
+    Threads[i] = llvm_launch_thread(compilePartition, &Partitions[i]);
+  compilePartition(&Partitions[0]);
+  for (unsigned i = 1; i != _parallelism; ++i)
+    llvm_join_thread(Threads[i]);
+
+  for (unsigned i = 0; i != _parallelism; ++i)
+    if (Partitions[i].Failed) {
+      errMsg = Partitions[i].ErrorMessage;
+      for (unsigned j = 0; j != _parallelism; ++j)
+        sys::Path(Partitions[j].ObjectPath).eraseFromDisk();
+      return true;
+    }
+
+  for (unsigned i = 0; i != _parallelism; ++i)
+    _nativeObjectPaths.push_back(Partitions[i].ObjectPath);
+  for (unsigned i = 0; i != _parallelism; ++i)
+    _nativeObjectPathRefs.push_back(_nativeObjectPaths[i].c_str());
+
+  *names = &_nativeObjectPathRefs[0];
+  *numNames = _nativeObjectPathRefs.size();
+  return false;
+}
+
 const void* LTOCodeGenerator::compile(size_t* length, std::string& errMsg) {
   const char *name;
   if (compile_to_file(&name, errMsg))
@@ -214,6 +458,20 @@ const void* LTOCodeGenerator::compile(size_t* length, std::string& errMsg) {
   return _nativeObjectFile->getBufferStart();
 }
 
+// The relocation model is actually a static member of TargetMachine and needs
+// to be set before the TargetMachine is instantiated.
+static Reloc::Model getRelocModel(lto_codegen_model model) {
+  switch (model) {
+  case LTO_CODEGEN_PIC_MODEL_STATIC:
+    return Reloc::Static;
+  case LTO_CODEGEN_PIC_MODEL_DYNAMIC:
+    return Reloc::PIC_;
+  case LTO_CODEGEN_PIC_MODEL_DYNAMIC_NO_PIC:
+    return Reloc::DynamicNoPIC;
+  }
+  llvm_unreachable("Unknown PIC model!");
+}
+
 bool LTOCodeGenerator::determineTarget(std::string& errMsg) {
   if (_target != NULL)
     return false;
@@ -228,20 +486,7 @@ bool LTOCodeGenerator::determineTarget(std::string& errMsg) {
   if (march == NULL)
     return true;
 
-  // The relocation model is actually a static member of TargetMachine and
-  // needs to be set before the TargetMachine is instantiated.
-  Reloc::Model RelocModel = Reloc::Default;
-  switch (_codeModel) {
-  case LTO_CODEGEN_PIC_MODEL_STATIC:
-    RelocModel = Reloc::Static;
-    break;
-  case LTO_CODEGEN_PIC_MODEL_DYNAMIC:
-    RelocModel = Reloc::PIC_;
-    break;
-  case LTO_CODEGEN_PIC_MODEL_DYNAMIC_NO_PIC:
-    RelocModel = Reloc::DynamicNoPIC;
-    break;
-  }
+  Reloc::Model RelocModel = getRelocModel(_codeModel);
 
   // construct LTOModule, hand over ownership of module and target
   SubtargetFeatures Features;
@@ -347,9 +592,8 @@ void LTOCodeGenerator::applyScopeRestrictions() {
   _scopeRestrictionsDone = true;
 }
 
-/// Optimize merged modules using various IPO passes
-bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
-                                          std::string &errMsg) {
+/// Optimize the merged module using various IPO passes
+bool LTOCodeGenerator::optimizeMergedModule(std::string &errMsg) {
   if (this->determineTarget(errMsg))
     return true;
 
@@ -384,6 +628,19 @@ bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
   // Make sure everything is still good.
   passes.add(createVerifierPass());
 
+  // Run our queue of passes all at once now, efficiently.
+  passes.run(*mergedModule);
+
+  return false;
+}
+
+bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
+                                          std::string &errMsg) {
+  if (this->optimizeMergedModule(errMsg))
+    return true;
+
+  Module* mergedModule = _linker.getModule();
+
   FunctionPassManager *codeGenPasses = new FunctionPassManager(mergedModule);
 
   codeGenPasses->add(new DataLayout(*_target->getDataLayout()));
@@ -397,9 +654,6 @@ bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
     return true;
   }
 
-  // Run our queue of passes all at once now, efficiently.
-  passes.run(*mergedModule);
-
   // Run the code generator, and write assembly file
   codeGenPasses->doInitialization();
 
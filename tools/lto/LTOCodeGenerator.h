@@ -45,17 +45,24 @@ struct LTOCodeGenerator {
 
   void setCpu(const char* mCpu) { _mCpu = mCpu; }
 
+  void setCodeGenParallelism(unsigned parallelism) {
+    _parallelism = parallelism ? parallelism : 1;
+  }
+
   void addMustPreserveSymbol(const char* sym) {
     _mustPreserveSymbols[sym] = 1;
   }
 
   bool writeMergedModules(const char *path, std::string &errMsg);
   bool compile_to_file(const char **name, std::string &errMsg);
+  bool compile_to_files(const char ***names, size_t *numNames,
+                        std::string &errMsg);
   const void *compile(size_t *length, std::string &errMsg);
   void setCodeGenDebugOptions(const char *opts);
 
 private:
   bool generateObjectFile(llvm::raw_ostream &out, std::string &errMsg);
+  bool optimizeMergedModule(std::string &errMsg);
   void applyScopeRestrictions();
   void applyRestriction(llvm::GlobalValue &GV,
                         std::vector<const char*> &mustPreserveList,
@@ -77,6 +84,9 @@ private:
   std::vector<char*>          _codegenOptions;
   std::string                 _mCpu;
   std::string                 _nativeObjectPath;
+  unsigned                    _parallelism;
+  std::vector<std::string>    _nativeObjectPaths;
+  std::vector<const char*>    _nativeObjectPathRefs;
 };
 
 #endif // LTO_CODE_GENERATOR_H
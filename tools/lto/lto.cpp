@@ -206,6 +206,21 @@ bool lto_codegen_compile_to_file(lto_code_gen_t cg, const char **name) {
   return cg->compile_to_file(name, sLastErrorString);
 }
 
+/// lto_codegen_set_parallelism - Sets the number of partitions (and worker
+/// threads) used by lto_codegen_compile_to_files().
+void lto_codegen_set_parallelism(lto_code_gen_t cg, unsigned int parallelism) {
+  cg->setCodeGenParallelism(parallelism);
+}
+
+/// lto_codegen_compile_to_files - Generates code for all added modules into
+/// one native object file per partition, running code generation for the
+/// partitions on parallel threads. The file paths are written to names and
+/// num_names. Returns true on error.
+bool lto_codegen_compile_to_files(lto_code_gen_t cg, const char ***names,
+                                  size_t *num_names) {
+  return cg->compile_to_files(names, num_names, sLastErrorString);
+}
+
 /// lto_codegen_debug_options - Used to pass extra options to the code
 /// generator.
 void lto_codegen_debug_options(lto_code_gen_t cg, const char *opt) {
@@ -24,9 +24,17 @@
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/DebugInfo.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
 #include "llvm/LinkAllIR.h"
+#include "llvm/Linker.h"
 #include "llvm/LinkAllPasses.h"
 #include "llvm/MC/SubtargetFeature.h"
 #include "llvm/PassManager.h"
@@ -156,6 +164,33 @@ DefaultDataLayout("default-data-layout",
           cl::desc("data layout string to use if not specified by module"),
           cl::value_desc("layout-string"), cl::init(""));
 
+static cl::opt<std::string>
+CheckpointFile("checkpoint-file",
+               cl::desc("Bitcode file used to hold a mid-pipeline checkpoint"),
+               cl::value_desc("filename"));
+
+static cl::opt<std::string>
+CheckpointAfter("checkpoint-after",
+                cl::desc("Write the module to -checkpoint-file after the "
+                         "first run of the named pass"),
+                cl::value_desc("pass-name"));
+
+static cl::opt<bool>
+ResumeFromCheckpoint("resume",
+    cl::desc("Load the module from -checkpoint-file and skip every pass in "
+             "the pass list up to and including -checkpoint-after"));
+
+static cl::opt<bool>
+Incremental("incremental",
+    cl::desc("Stamp structural hashes of the input functions into the output "
+             "for later -incremental-base runs"));
+
+static cl::opt<std::string>
+IncrementalBase("incremental-base",
+    cl::desc("Previously optimized module (written with -incremental) whose "
+             "unchanged function bodies are reused instead of re-optimized"),
+    cl::value_desc("filename"), cl::init(""));
+
 // ---------- Define Printers for module and function passes ------------
 namespace {
 
@@ -415,6 +450,386 @@ static inline void addPass(PassManagerBase &PM, Pass *P) {
   if (VerifyEach) PM.add(createVerifierPass());
 }
 
+//===----------------------------------------------------------------------===//
+// Incremental recompilation support.
+//
+// With -incremental, opt stamps a structural hash of every input function
+// into the output module as named metadata.  A later run handed that output
+// via -incremental-base hashes its own input, splices in the previously
+// optimized body of every function whose hash still matches, and re-runs the
+// function pipeline only on the functions that changed and on their
+// transitive callers, whose old bodies may have inlined a stale callee.
+//===----------------------------------------------------------------------===//
+
+static const char *IncrementalHashesMDName = "llvm.incremental.hashes";
+
+/// Functions whose optimized bodies were spliced in from the incremental
+/// base; the function pipeline must not run on them.
+static StringSet<> PreservedFunctions;
+
+/// ProfileIncrementalType - Fold a process-independent description of Ty
+/// into ID.  Type pointers are context-specific and cannot be hashed, so the
+/// structure is walked instead; Depth bounds recursion through recursive
+/// struct types.
+static void ProfileIncrementalType(Type *Ty, FoldingSetNodeID &ID,
+                                   unsigned Depth) {
+  ID.AddInteger(Ty->getTypeID());
+  switch (Ty->getTypeID()) {
+  case Type::IntegerTyID:
+    ID.AddInteger(cast<IntegerType>(Ty)->getBitWidth());
+    break;
+  case Type::PointerTyID:
+    ID.AddInteger(cast<PointerType>(Ty)->getAddressSpace());
+    break;
+  case Type::ArrayTyID:
+    ID.AddInteger((unsigned)cast<ArrayType>(Ty)->getNumElements());
+    break;
+  case Type::VectorTyID:
+    ID.AddInteger(cast<VectorType>(Ty)->getNumElements());
+    break;
+  case Type::StructTyID:
+    ID.AddBoolean(cast<StructType>(Ty)->isPacked());
+    break;
+  case Type::FunctionTyID:
+    ID.AddBoolean(cast<FunctionType>(Ty)->isVarArg());
+    break;
+  default:
+    break;
+  }
+  if (Depth == 0)
+    return;
+  for (Type::subtype_iterator I = Ty->subtype_begin(), E = Ty->subtype_end();
+       I != E; ++I)
+    ProfileIncrementalType(*I, ID, Depth - 1);
+}
+
+/// ProfileIncrementalOperand - Fold a non-local operand (anything that is
+/// not an argument, block or instruction of the function being hashed) into
+/// ID.  Each case starts with a distinct tag so different operand kinds can
+/// never profile identically.
+static void ProfileIncrementalOperand(const Value *V, FoldingSetNodeID &ID,
+                                      unsigned Depth) {
+  if (const ConstantInt *CI = dyn_cast<ConstantInt>(V)) {
+    ID.AddInteger(1u);
+    const APInt &Val = CI->getValue();
+    ID.AddInteger(Val.getBitWidth());
+    for (unsigned i = 0, e = Val.getNumWords(); i != e; ++i)
+      ID.AddInteger(Val.getRawData()[i]);
+  } else if (const ConstantFP *CF = dyn_cast<ConstantFP>(V)) {
+    ID.AddInteger(2u);
+    APInt Val = CF->getValueAPF().bitcastToAPInt();
+    ID.AddInteger(Val.getBitWidth());
+    for (unsigned i = 0, e = Val.getNumWords(); i != e; ++i)
+      ID.AddInteger(Val.getRawData()[i]);
+  } else if (const GlobalValue *GV = dyn_cast<GlobalValue>(V)) {
+    // Globals are identified by name, which is how they are matched back up
+    // on the next run.  Unnamed globals all profile alike; the collision is
+    // conservative only if the referenced initializer changed, which renames
+    // nothing, so it is accepted.
+    ID.AddInteger(3u);
+    ID.AddString(GV->getName());
+  } else if (const ConstantExpr *CE = dyn_cast<ConstantExpr>(V)) {
+    ID.AddInteger(4u);
+    ID.AddInteger(CE->getOpcode());
+    if (Depth)
+      for (unsigned i = 0, e = CE->getNumOperands(); i != e; ++i)
+        ProfileIncrementalOperand(CE->getOperand(i), ID, Depth - 1);
+  } else if (const InlineAsm *IA = dyn_cast<InlineAsm>(V)) {
+    ID.AddInteger(5u);
+    ID.AddString(IA->getAsmString());
+    ID.AddString(IA->getConstraintString());
+  } else if (isa<ConstantAggregateZero>(V) || isa<ConstantPointerNull>(V)) {
+    ID.AddInteger(6u);
+  } else if (isa<UndefValue>(V)) {
+    ID.AddInteger(7u);
+  } else if (const ConstantDataSequential *CDS =
+                 dyn_cast<ConstantDataSequential>(V)) {
+    ID.AddInteger(8u);
+    ID.AddString(CDS->getRawDataValues());
+  } else if (const Constant *C = dyn_cast<Constant>(V)) {
+    ID.AddInteger(9u);
+    if (Depth)
+      for (unsigned i = 0, e = C->getNumOperands(); i != e; ++i)
+        ProfileIncrementalOperand(C->getOperand(i), ID, Depth - 1);
+  } else {
+    // Metadata operands do not affect the generated code.
+    ID.AddInteger(10u);
+  }
+}
+
+/// HashFunctionDefinition - Compute a structural hash of F's signature and
+/// body.  Unlike the deliberately coarse MergeFunctions profile, this must
+/// distinguish any two functions the optimizer could treat differently, so
+/// constant values, intra-function operand numbering and per-instruction
+/// flags are all folded in.  Equal hashes are taken to mean an unchanged
+/// function.
+static unsigned HashFunctionDefinition(const Function *F) {
+  FoldingSetNodeID ID;
+  ProfileIncrementalType(F->getFunctionType(), ID, 8);
+  ID.AddInteger(F->getCallingConv());
+  ID.AddBoolean(F->hasGC());
+  if (F->hasGC())
+    ID.AddString(F->getGC());
+
+  // Number everything a body operand can reference locally, in layout order.
+  DenseMap<const Value*, unsigned> Numbers;
+  unsigned NextNumber = 0;
+  for (Function::const_arg_iterator A = F->arg_begin(), AE = F->arg_end();
+       A != AE; ++A)
+    Numbers[A] = ++NextNumber;
+  for (Function::const_iterator BB = F->begin(), BE = F->end();
+       BB != BE; ++BB) {
+    Numbers[BB] = ++NextNumber;
+    for (BasicBlock::const_iterator I = BB->begin(), E = BB->end();
+         I != E; ++I)
+      Numbers[I] = ++NextNumber;
+  }
+
+  for (Function::const_iterator BB = F->begin(), BE = F->end();
+       BB != BE; ++BB) {
+    for (BasicBlock::const_iterator I = BB->begin(), E = BB->end();
+         I != E; ++I) {
+      ID.AddInteger(I->getOpcode());
+      ID.AddInteger(I->getRawSubclassOptionalData());
+      ProfileIncrementalType(I->getType(), ID, 8);
+
+      // Fold in the state that lives outside the operand list.
+      if (const CmpInst *Cmp = dyn_cast<CmpInst>(I)) {
+        ID.AddInteger(Cmp->getPredicate());
+      } else if (const CallInst *Call = dyn_cast<CallInst>(I)) {
+        ID.AddInteger(Call->getCallingConv());
+        ID.AddBoolean(Call->isTailCall());
+      } else if (const InvokeInst *Invoke = dyn_cast<InvokeInst>(I)) {
+        ID.AddInteger(Invoke->getCallingConv());
+      } else if (const LoadInst *Load = dyn_cast<LoadInst>(I)) {
+        ID.AddBoolean(Load->isVolatile());
+        ID.AddInteger(Load->getAlignment());
+        ID.AddInteger((unsigned)Load->getOrdering());
+      } else if (const StoreInst *Store = dyn_cast<StoreInst>(I)) {
+        ID.AddBoolean(Store->isVolatile());
+        ID.AddInteger(Store->getAlignment());
+        ID.AddInteger((unsigned)Store->getOrdering());
+      } else if (const AllocaInst *Alloca = dyn_cast<AllocaInst>(I)) {
+        ID.AddInteger(Alloca->getAlignment());
+      } else if (const ExtractValueInst *EV = dyn_cast<ExtractValueInst>(I)) {
+        for (ExtractValueInst::idx_iterator It = EV->idx_begin(),
+             IE = EV->idx_end(); It != IE; ++It)
+          ID.AddInteger(*It);
+      } else if (const InsertValueInst *IV = dyn_cast<InsertValueInst>(I)) {
+        for (InsertValueInst::idx_iterator It = IV->idx_begin(),
+             IE = IV->idx_end(); It != IE; ++It)
+          ID.AddInteger(*It);
+      } else if (const AtomicRMWInst *RMW = dyn_cast<AtomicRMWInst>(I)) {
+        ID.AddInteger(RMW->getOperation());
+        ID.AddInteger((unsigned)RMW->getOrdering());
+      } else if (const AtomicCmpXchgInst *CX = dyn_cast<AtomicCmpXchgInst>(I)) {
+        ID.AddInteger((unsigned)CX->getOrdering());
+      } else if (const FenceInst *Fence = dyn_cast<FenceInst>(I)) {
+        ID.AddInteger((unsigned)Fence->getOrdering());
+      }
+
+      for (unsigned i = 0, e = I->getNumOperands(); i != e; ++i) {
+        const Value *Op = I->getOperand(i);
+        DenseMap<const Value*, unsigned>::iterator N = Numbers.find(Op);
+        if (N != Numbers.end()) {
+          ID.AddInteger(0u);
+          ID.AddInteger(N->second);
+        } else {
+          ProfileIncrementalOperand(Op, ID, 8);
+        }
+      }
+    }
+  }
+  return ID.ComputeHash();
+}
+
+/// ReadIncrementalHashes - Extract the hash stamps a previous -incremental
+/// run wrote into Base.  Returns false if the module carries none.
+static bool ReadIncrementalHashes(Module &Base, StringMap<unsigned> &Hashes) {
+  NamedMDNode *NMD = Base.getNamedMetadata(IncrementalHashesMDName);
+  if (!NMD)
+    return false;
+  for (unsigned i = 0, e = NMD->getNumOperands(); i != e; ++i) {
+    MDNode *N = NMD->getOperand(i);
+    if (N->getNumOperands() != 2)
+      continue;
+    MDString *Name = dyn_cast_or_null<MDString>(N->getOperand(0));
+    ConstantInt *Hash = dyn_cast_or_null<ConstantInt>(N->getOperand(1));
+    if (Name && Hash)
+      Hashes[Name->getString()] = (unsigned)Hash->getZExtValue();
+  }
+  return true;
+}
+
+/// WriteIncrementalHashes - Stamp the pre-optimization hashes of this run's
+/// input functions into M, replacing any stamps inherited from the base.
+static void WriteIncrementalHashes(Module &M,
+                                   const StringMap<unsigned> &Hashes) {
+  if (NamedMDNode *Old = M.getNamedMetadata(IncrementalHashesMDName))
+    M.eraseNamedMetadata(Old);
+  NamedMDNode *NMD = M.getOrInsertNamedMetadata(IncrementalHashesMDName);
+  Type *Int32Ty = Type::getInt32Ty(M.getContext());
+  for (StringMap<unsigned>::const_iterator I = Hashes.begin(),
+       E = Hashes.end(); I != E; ++I) {
+    Value *Ops[] = { MDString::get(M.getContext(), I->getKey()),
+                     ConstantInt::get(Int32Ty, I->getValue()) };
+    NMD->addOperand(MDNode::get(M.getContext(), Ops));
+  }
+}
+
+/// MarkCallersDirty - A changed function invalidates every function that may
+/// have inlined its old body: walk its users, through constants, to the
+/// enclosing functions and dirty them transitively.
+static void MarkCallersDirty(const Function *Changed,
+                             SmallPtrSet<const Function*, 32> &Dirty) {
+  SmallVector<const Value*, 32> Worklist;
+  Worklist.push_back(Changed);
+  while (!Worklist.empty()) {
+    const Value *V = Worklist.pop_back_val();
+    for (Value::const_use_iterator UI = V->use_begin(), UE = V->use_end();
+         UI != UE; ++UI) {
+      if (const Instruction *I = dyn_cast<Instruction>(*UI)) {
+        const Function *Caller = I->getParent()->getParent();
+        if (Dirty.insert(Caller))
+          Worklist.push_back(Caller);
+      } else if (isa<Constant>(*UI)) {
+        Worklist.push_back(*UI);
+      }
+    }
+  }
+}
+
+/// SpliceBaseFunctions - Replace the bodies of the preserved functions in
+/// NewM with the already-optimized ones from Base.  Base is first reduced to
+/// those definitions plus the local symbols they reference, then linked in,
+/// which maps types across modules and renames colliding locals.  The caller
+/// still owns Base afterwards.
+static bool SpliceBaseFunctions(Module &NewM, Module *Base,
+                                std::string &Err) {
+  // The stamps travel on named metadata, which linking concatenates; drop
+  // the base's copy so only the fresh stamps survive.
+  if (NamedMDNode *Old = Base->getNamedMetadata(IncrementalHashesMDName))
+    Base->eraseNamedMetadata(Old);
+
+  for (Module::iterator F = NewM.begin(), E = NewM.end(); F != E; ++F)
+    if (PreservedFunctions.count(F->getName()))
+      F->deleteBody();
+
+  // Local functions may be called from preserved bodies and are renamed
+  // around collisions by the linker; every other non-preserved body resolves
+  // against the new module's definition.
+  for (Module::iterator F = Base->begin(), E = Base->end(); F != E; ++F) {
+    if (F->isDeclaration() || PreservedFunctions.count(F->getName()))
+      continue;
+    if (!F->hasLocalLinkage())
+      F->deleteBody();
+  }
+
+  // Globals are owned by the new input; reduce the base's non-local ones to
+  // declarations so the two definitions cannot collide.
+  for (Module::global_iterator G = Base->global_begin(),
+       E = Base->global_end(); G != E; ++G)
+    if (G->hasInitializer() && !G->hasLocalLinkage()) {
+      G->setInitializer(0);
+      G->setLinkage(GlobalValue::ExternalLinkage);
+    }
+
+  // Aliases cannot be reduced to declarations; forward them to their
+  // aliasees instead.
+  for (Module::alias_iterator A = Base->alias_begin();
+       A != Base->alias_end(); ) {
+    GlobalAlias *GA = A++;
+    GA->replaceAllUsesWith(GA->getAliasee());
+    GA->eraseFromParent();
+  }
+
+  // Shed the local definitions only the deleted bodies referenced.
+  bool Erased = true;
+  while (Erased) {
+    Erased = false;
+    for (Module::iterator F = Base->begin(); F != Base->end(); ) {
+      Function *Fn = F++;
+      if (Fn->hasLocalLinkage() && Fn->use_empty()) {
+        Fn->eraseFromParent();
+        Erased = true;
+      }
+    }
+    for (Module::global_iterator G = Base->global_begin();
+         G != Base->global_end(); ) {
+      GlobalVariable *GV = G++;
+      if (GV->hasLocalLinkage() && GV->use_empty()) {
+        GV->eraseFromParent();
+        Erased = true;
+      }
+    }
+  }
+
+  return !Linker::LinkModules(&NewM, Base, Linker::DestroySource, &Err);
+}
+
+/// SetUpIncremental - Hash the freshly parsed input and, when a base module
+/// was given, record which functions' optimized bodies can be reused and
+/// splice them in.  NewHashes receives the input hashes for restamping the
+/// output.  Returns false on error.
+static bool SetUpIncremental(Module &M, StringMap<unsigned> &NewHashes,
+                             const char *Argv0) {
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F)
+    if (!F->isDeclaration())
+      NewHashes[F->getName()] = HashFunctionDefinition(F);
+  if (IncrementalBase.empty())
+    return true;
+
+  SMDiagnostic BaseErr;
+  std::auto_ptr<Module> Base(ParseIRFile(IncrementalBase, BaseErr,
+                                         M.getContext()));
+  if (Base.get() == 0) {
+    BaseErr.print(Argv0, errs());
+    return false;
+  }
+
+  StringMap<unsigned> BaseHashes;
+  if (!ReadIncrementalHashes(*Base, BaseHashes)) {
+    errs() << Argv0 << ": warning: '" << IncrementalBase
+           << "' carries no -incremental hash stamps; optimizing "
+              "everything.\n";
+    return true;
+  }
+
+  // A function changed if its stamp is missing or stale; its callers are
+  // dirtied transitively because their optimized bodies may have inlined
+  // the old version.
+  SmallPtrSet<const Function*, 32> Dirty;
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F) {
+    if (F->isDeclaration())
+      continue;
+    StringMap<unsigned>::iterator Old = BaseHashes.find(F->getName());
+    if (Old == BaseHashes.end() ||
+        Old->getValue() != NewHashes[F->getName()]) {
+      Dirty.insert(F);
+      MarkCallersDirty(F, Dirty);
+    }
+  }
+
+  // Only externally named bodies can be matched back up across runs; local
+  // functions are renamed freely and always re-optimized.
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F) {
+    if (F->isDeclaration() || F->hasLocalLinkage() || Dirty.count(F))
+      continue;
+    Function *BaseF = Base->getFunction(F->getName());
+    if (BaseF == 0 || BaseF->isDeclaration())
+      continue;
+    PreservedFunctions.insert(F->getName());
+  }
+
+  std::string LinkErr;
+  if (!SpliceBaseFunctions(M, Base.get(), LinkErr)) {
+    errs() << Argv0 << ": error linking incremental base: " << LinkErr
+           << "\n";
+    return false;
+  }
+  return true;
+}
+
 /// AddOptimizationPasses - This routine adds optimization passes
 /// based on selected optimization level, OptLevel. This routine
 /// duplicates llvm-gcc behaviour.
@@ -447,7 +862,11 @@ static void AddOptimizationPasses(PassManagerBase &MPM,FunctionPassManager &FPM,
   Builder.DisableSimplifyLibCalls = DisableSimplifyLibCalls;
   
   Builder.populateFunctionPassManager(FPM);
-  Builder.populateModulePassManager(MPM);
+  // With an incremental base the function pipeline is the whole pipeline:
+  // module passes such as the inliner would rewrite the preserved bodies and
+  // forfeit the reuse.
+  if (IncrementalBase.empty())
+    Builder.populateModulePassManager(MPM);
 }
 
 static void AddStandardCompilePasses(PassManagerBase &PM) {
@@ -585,11 +1004,20 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  if ((ResumeFromCheckpoint || !CheckpointAfter.empty()) &&
+      CheckpointFile.empty()) {
+    errs() << argv[0] << ": -checkpoint-after and -resume require "
+              "-checkpoint-file.\n";
+    return 1;
+  }
+
   SMDiagnostic Err;
 
-  // Load the input module...
+  // Load the input module.  When resuming, read the checkpoint instead; it is
+  // an ordinary bitcode file holding the module as it was at the checkpoint.
   std::auto_ptr<Module> M;
-  M.reset(ParseIRFile(InputFilename, Err, Context));
+  M.reset(ParseIRFile(ResumeFromCheckpoint ? CheckpointFile : InputFilename,
+                      Err, Context));
 
   if (M.get() == 0) {
     Err.print(argv[0], errs());
@@ -600,6 +1028,13 @@ int main(int argc, char **argv) {
   if (!TargetTriple.empty())
     M->setTargetTriple(Triple::normalize(TargetTriple));
 
+  // Incremental mode: hash the input now, before anything rewrites it, and
+  // splice in the optimized bodies of unchanged functions from the base.
+  StringMap<unsigned> IncrementalHashes;
+  if (Incremental || !IncrementalBase.empty())
+    if (!SetUpIncremental(*M.get(), IncrementalHashes, argv[0]))
+      return 1;
+
   // Figure out what stream we are supposed to write to...
   OwningPtr<tool_output_file> Out;
   if (NoOutput) {
@@ -691,6 +1126,17 @@ int main(int argc, char **argv) {
   if (StripDebug && !StandardCompileOpts)
     addPass(Passes, createStripSymbolsPass(true));
 
+  // When resuming from a checkpoint, skip every pass up to and including the
+  // checkpointed one; the loaded module already reflects their effect.  Note
+  // that only passes named in the pass list are skipped; -std-compile-opts
+  // and the -O levels expand to fixed pipelines with no checkpoint points.
+  bool SkippingToCheckpoint = ResumeFromCheckpoint;
+
+  // The stream holding a checkpoint being written, if any.  The bitcode
+  // writer pass added below writes to it during the pass run, so it must
+  // stay open until the run finishes.
+  OwningPtr<tool_output_file> CheckpointOut;
+
   // Create a new optimization pass for each one specified on the command line
   for (unsigned i = 0; i < PassList.size(); ++i) {
     // Check to see if -std-compile-opts was specified before this option.  If
@@ -733,6 +1179,13 @@ int main(int argc, char **argv) {
     }
 
     const PassInfo *PassInf = PassList[i];
+
+    if (SkippingToCheckpoint) {
+      if (CheckpointAfter == PassInf->getPassArgument())
+        SkippingToCheckpoint = false;
+      continue;
+    }
+
     Pass *P = 0;
     if (PassInf->getNormalCtor())
       P = PassInf->getNormalCtor()();
@@ -743,6 +1196,22 @@ int main(int argc, char **argv) {
       PassKind Kind = P->getPassKind();
       addPass(Passes, P);
 
+      // If this is the checkpoint point, snapshot the module right after the
+      // pass runs.  Only the first occurrence of the named pass counts.
+      if (!ResumeFromCheckpoint && !CheckpointOut &&
+          !CheckpointAfter.empty() &&
+          CheckpointAfter == PassInf->getPassArgument()) {
+        std::string ErrorInfo;
+        CheckpointOut.reset(new tool_output_file(CheckpointFile.c_str(),
+                                                 ErrorInfo,
+                                                 raw_fd_ostream::F_Binary));
+        if (!ErrorInfo.empty()) {
+          errs() << ErrorInfo << '\n';
+          return 1;
+        }
+        Passes.add(createBitcodeWriterPass(CheckpointOut->os()));
+      }
+
       if (AnalyzeOnly) {
         switch (Kind) {
         case PT_BasicBlock:
@@ -800,7 +1269,8 @@ int main(int argc, char **argv) {
   if (OptLevelO1 || OptLevelO2 || OptLevelOs || OptLevelOz || OptLevelO3) {
     FPasses->doInitialization();
     for (Module::iterator F = M->begin(), E = M->end(); F != E; ++F)
-      FPasses->run(*F);
+      if (!PreservedFunctions.count(F->getName()))
+        FPasses->run(*F);
     FPasses->doFinalization();
   }
 
@@ -816,9 +1286,21 @@ int main(int argc, char **argv) {
       Passes.add(createBitcodeWriterPass(Out->os()));
   }
 
+  // Restamp the output with the hashes of this run's input so it can serve
+  // as the next run's -incremental-base.
+  if (Incremental || !IncrementalBase.empty())
+    WriteIncrementalHashes(*M.get(), IncrementalHashes);
+
   // Before executing passes, print the final values of the LLVM options.
   cl::PrintOptionValues();
 
+  if (SkippingToCheckpoint ||
+      (!CheckpointAfter.empty() && !ResumeFromCheckpoint && !CheckpointOut)) {
+    errs() << argv[0] << ": -checkpoint-after pass '" << CheckpointAfter
+           << "' not found in pass list.\n";
+    return 1;
+  }
+
   // Now that we have all of the passes ready, run them.
   Passes.run(*M.get());
 
@@ -826,5 +1308,8 @@ int main(int argc, char **argv) {
   if (!NoOutput || PrintBreakpoints)
     Out->keep();
 
+  if (CheckpointOut)
+    CheckpointOut->keep();
+
   return 0;
 }
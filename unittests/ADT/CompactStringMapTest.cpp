@@ -0,0 +1,111 @@
+//===- llvm/unittest/ADT/CompactStringMapTest.cpp - CompactStringMap tests ===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/CompactStringMap.h"
+#include "llvm/Support/Allocator.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <string>
+
+using namespace llvm;
+
+namespace {
+
+TEST(CompactStringMapTest, EmptyMap) {
+  CompactStringMap<int> Map;
+  EXPECT_EQ(0u, Map.size());
+  EXPECT_TRUE(Map.empty());
+  EXPECT_EQ(0u, Map.count("foo"));
+  EXPECT_EQ(0, Map.lookup("foo"));
+  EXPECT_TRUE(Map.begin() == Map.end());
+}
+
+TEST(CompactStringMapTest, InsertAndLookup) {
+  CompactStringMap<int> Map;
+  Map["a"] = 1;
+  Map["b"] = 2;
+  EXPECT_EQ(2u, Map.size());
+  EXPECT_EQ(1, Map.lookup("a"));
+  EXPECT_EQ(2, Map.lookup("b"));
+  EXPECT_EQ(0, Map.lookup("c"));
+  EXPECT_EQ(1u, Map.count("a"));
+  EXPECT_EQ(0u, Map.count("c"));
+
+  // Existing keys are found again, not re-inserted.
+  Map["a"] = 3;
+  EXPECT_EQ(2u, Map.size());
+  EXPECT_EQ(3, Map.lookup("a"));
+}
+
+TEST(CompactStringMapTest, GetOrCreateValue) {
+  CompactStringMap<int> Map;
+  CompactStringMapEntry<int> &E = Map.GetOrCreateValue("key");
+  EXPECT_EQ("key", E.getKey());
+  EXPECT_EQ(0, E.getValue());
+  E.setValue(42);
+  EXPECT_EQ(42, Map.lookup("key"));
+}
+
+TEST(CompactStringMapTest, LongKeysSurviveRehash) {
+  // Keys longer than the inline storage are spilled to the allocator and
+  // must stay valid while the table grows.
+  CompactStringMap<unsigned> Map;
+  std::string Long(100, 'x');
+  StringRef Key = Map.GetOrCreateValue(Long).getKey();
+  EXPECT_EQ(100u, Key.size());
+
+  for (unsigned i = 0; i != 1000; ++i) {
+    std::string Name("key");
+    Name += 'a' + (i % 26);
+    Name += '0' + (i % 10);
+    char Buf[16];
+    sprintf(Buf, "%u", i);
+    Name += Buf;
+    Map[Name] = i;
+  }
+  EXPECT_EQ(1001u, Map.size());
+  EXPECT_EQ(Long, Key.str());
+  EXPECT_EQ(0u, Map.lookup(Long));
+  EXPECT_EQ(999u, Map.lookup("keyl9999"));
+}
+
+TEST(CompactStringMapTest, Iteration) {
+  CompactStringMap<int> Map;
+  Map["one"] = 1;
+  Map["two"] = 2;
+  Map["three"] = 3;
+
+  int Sum = 0;
+  unsigned Count = 0;
+  for (CompactStringMap<int>::const_iterator I = Map.begin(), E = Map.end();
+       I != E; ++I) {
+    Sum += I->getValue();
+    ++Count;
+  }
+  EXPECT_EQ(3u, Count);
+  EXPECT_EQ(6, Sum);
+}
+
+TEST(CompactStringMapTest, Clear) {
+  CompactStringMap<int, BumpPtrAllocator&> *Map;
+  BumpPtrAllocator Alloc;
+  Map = new CompactStringMap<int, BumpPtrAllocator&>(Alloc);
+  (*Map)["hello"] = 5;
+  (*Map)[std::string(50, 'y')] = 6;
+  EXPECT_EQ(2u, Map->size());
+  Map->clear();
+  EXPECT_EQ(0u, Map->size());
+  EXPECT_TRUE(Map->empty());
+  EXPECT_EQ(0, Map->lookup("hello"));
+  (*Map)["hello"] = 7;
+  EXPECT_EQ(7, Map->lookup("hello"));
+  delete Map;
+}
+
+} // end anonymous namespace
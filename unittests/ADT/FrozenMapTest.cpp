@@ -0,0 +1,88 @@
+//===- unittests/ADT/FrozenMapTest.cpp - FrozenMap unit tests ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/FrozenMap.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+TEST(FrozenMapTest, EmptyMap) {
+  FrozenMap<int, int> FM;
+  EXPECT_TRUE(FM.empty());
+  EXPECT_EQ(0u, FM.size());
+  EXPECT_EQ(FM.size(), FM.find(42));
+  EXPECT_FALSE(FM.count(42));
+  EXPECT_EQ(0, FM.lookup(42));
+}
+
+TEST(FrozenMapTest, FreezeFromDenseMap) {
+  DenseMap<int, int> M;
+  M[3] = 30;
+  M[1] = 10;
+  M[2] = 20;
+
+  FrozenMap<int, int> FM;
+  FM.freeze(M);
+
+  EXPECT_EQ(3u, FM.size());
+  EXPECT_EQ(10, FM.lookup(1));
+  EXPECT_EQ(20, FM.lookup(2));
+  EXPECT_EQ(30, FM.lookup(3));
+  EXPECT_FALSE(FM.count(4));
+  EXPECT_EQ(0, FM.lookup(4));
+}
+
+TEST(FrozenMapTest, SortedColumns) {
+  MapVector<int, int> M;
+  M[5] = 50;
+  M[1] = 10;
+  M[9] = 90;
+
+  FrozenMap<int, int> FM;
+  FM.freeze(M);
+
+  // Keys are sorted and the value column stays aligned with the key column.
+  ASSERT_EQ(3u, FM.size());
+  EXPECT_EQ(1, FM.getKey(0));
+  EXPECT_EQ(5, FM.getKey(1));
+  EXPECT_EQ(9, FM.getKey(2));
+  for (FrozenMap<int, int>::size_type i = 0; i != FM.size(); ++i)
+    EXPECT_EQ(FM.getKey(i) * 10, FM.getValue(i));
+
+  int LastKey = 0;
+  for (FrozenMap<int, int>::key_iterator I = FM.key_begin(),
+       E = FM.key_end(); I != E; ++I) {
+    EXPECT_LT(LastKey, *I);
+    LastKey = *I;
+  }
+}
+
+TEST(FrozenMapTest, Refreeze) {
+  DenseMap<int, int> M;
+  M[1] = 10;
+
+  FrozenMap<int, int> FM;
+  FM.freeze(M);
+  EXPECT_EQ(1u, FM.size());
+
+  M[2] = 20;
+  FM.freeze(M);
+  EXPECT_EQ(2u, FM.size());
+  EXPECT_EQ(20, FM.lookup(2));
+
+  FM.clear();
+  EXPECT_TRUE(FM.empty());
+  EXPECT_FALSE(FM.count(1));
+}
+
+} // end anonymous namespace
@@ -13,6 +13,8 @@
 
 #include "gtest/gtest.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include <cstdlib>
+#include <set>
 
 using namespace llvm;
 
@@ -70,3 +72,72 @@ TEST(SmallPtrSetTest, SwapTest) {
   EXPECT_TRUE(a.count(&buf[1]));
   EXPECT_TRUE(a.count(&buf[3]));
 }
+
+// Erasing an element must shift later elements of its probe chain back so
+// that lookups which rely on the probe-distance early exit still find them.
+// Interleave erasure with enough insertion to force growth so the chains are
+// rebuilt several times.
+TEST(SmallPtrSetTest, EraseTest) {
+  int buf[1024];
+
+  SmallPtrSet<int *, 8> s;
+  for (unsigned i = 0; i != 1024; ++i)
+    s.insert(&buf[i]);
+  EXPECT_EQ(1024U, s.size());
+
+  // Erase every other element, checking that the survivors stay findable.
+  for (unsigned i = 0; i != 1024; i += 2)
+    EXPECT_TRUE(s.erase(&buf[i]));
+  EXPECT_EQ(512U, s.size());
+  for (unsigned i = 0; i != 1024; ++i)
+    EXPECT_EQ(i % 2 != 0, s.count(&buf[i]));
+  for (unsigned i = 0; i != 1024; i += 2)
+    EXPECT_FALSE(s.erase(&buf[i]));
+
+  // Erased slots must be reusable: re-insert everything.
+  for (unsigned i = 0; i != 1024; i += 2)
+    EXPECT_TRUE(s.insert(&buf[i]));
+  EXPECT_EQ(1024U, s.size());
+  for (unsigned i = 0; i != 1024; ++i)
+    EXPECT_TRUE(s.count(&buf[i]));
+}
+
+// Randomized differential test against std::set: the two containers must
+// agree on every insert/erase return value, every membership query, and on
+// what iteration visits.  The operation mix drives the set across the
+// small/big boundary and interleaves erasure with growth.
+TEST(SmallPtrSetTest, DifferentialTest) {
+  static int Pool[512];
+  srand(12345);
+
+  for (unsigned Trial = 0; Trial != 50; ++Trial) {
+    SmallPtrSet<int *, 8> s;
+    std::set<int *> Ref;
+
+    for (unsigned Op = 0; Op != 2000; ++Op) {
+      int *P = &Pool[rand() % 512];
+      if (rand() % 3 != 0) {
+        EXPECT_EQ(Ref.insert(P).second, s.insert(P));
+      } else {
+        EXPECT_EQ(Ref.erase(P) != 0, s.erase(P));
+      }
+      EXPECT_EQ(Ref.size(), s.size());
+    }
+
+    for (unsigned i = 0; i != 512; ++i)
+      EXPECT_EQ(Ref.count(&Pool[i]) != 0, s.count(&Pool[i]) != 0);
+
+    // Iteration must visit exactly the members, each once.
+    std::set<int *> Seen;
+    for (SmallPtrSet<int *, 8>::iterator I = s.begin(), E = s.end(); I != E;
+         ++I)
+      EXPECT_TRUE(Seen.insert(*I).second);
+    EXPECT_EQ(Ref, Seen);
+
+    // The copy constructor must preserve the contents.
+    SmallPtrSet<int *, 8> Copy(s);
+    EXPECT_EQ(s.size(), Copy.size());
+    for (std::set<int *>::iterator I = Ref.begin(), E = Ref.end(); I != E; ++I)
+      EXPECT_TRUE(Copy.count(*I));
+  }
+}
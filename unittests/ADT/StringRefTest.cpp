@@ -271,6 +271,10 @@ TEST(StringRefTest, Find) {
   EXPECT_EQ(2U, Str.find("ll", 2));
   EXPECT_EQ(StringRef::npos, Str.find("ll", 3));
   EXPECT_EQ(0U, Str.find(""));
+  EXPECT_EQ(5U, Str.find("", 5));
+  EXPECT_EQ(StringRef::npos, Str.find("", 6));
+  EXPECT_EQ(2U, Str.find("l", 2));
+  EXPECT_EQ(StringRef::npos, Str.find("l", 4));
   StringRef LongStr("hellx xello hell ello world foo bar hello");
   EXPECT_EQ(36U, LongStr.find("hello"));
   EXPECT_EQ(28U, LongStr.find("foo"));
@@ -63,6 +63,38 @@ TEST(ilistTest, SpliceOne) {
   EXPECT_EQ(3, List.back().Value);
 }
 
+struct IsEven {
+  bool operator()(const Node &N) const { return (N.Value & 1) == 0; }
+};
+
+TEST(ilistTest, SpliceIf) {
+  ilist<Node> From, To;
+  for (int i = 1; i <= 6; ++i)
+    From.push_back(i);
+  To.push_back(10);
+
+  // Move the even nodes, preserving their relative order.
+  To.splice_if(To.end(), From, From.begin(), From.end(), IsEven());
+  EXPECT_EQ(3u, From.size());
+  EXPECT_EQ(4u, To.size());
+
+  ilist<Node>::iterator I = From.begin();
+  EXPECT_EQ(1, I->Value);
+  EXPECT_EQ(3, (++I)->Value);
+  EXPECT_EQ(5, (++I)->Value);
+
+  I = To.begin();
+  EXPECT_EQ(10, I->Value);
+  EXPECT_EQ(2, (++I)->Value);
+  EXPECT_EQ(4, (++I)->Value);
+  EXPECT_EQ(6, (++I)->Value);
+
+  // Nothing matches: no change.
+  To.splice_if(To.begin(), From, From.begin(), From.end(), IsEven());
+  EXPECT_EQ(3u, From.size());
+  EXPECT_EQ(4u, To.size());
+}
+
 TEST(ilistTest, UnsafeClear) {
   ilist<Node> List;
 
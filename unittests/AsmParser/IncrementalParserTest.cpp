@@ -0,0 +1,94 @@
+//===- llvm/unittest/AsmParser/IncrementalParserTest.cpp ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Analysis/Verifier.h"
+#include "llvm/Assembly/Parser.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+namespace llvm {
+namespace {
+
+TEST(IncrementalParserTest, TwoChunks) {
+  LLVMContext Context;
+  OwningPtr<Module> M(new Module("test", Context));
+  SMDiagnostic Err;
+  IncrementalAssemblyParser Parser(M.get(), Err);
+
+  EXPECT_FALSE(Parser.ParseChunk("@g = global i32 7\n"));
+  EXPECT_FALSE(Parser.ParseChunk("define i32 @f() {\n"
+                                 "  %v = load i32* @g\n"
+                                 "  ret i32 %v\n"
+                                 "}\n"));
+  EXPECT_FALSE(Parser.Finish());
+
+  GlobalVariable *G = M->getGlobalVariable("g");
+  ASSERT_TRUE(G != 0);
+  Function *F = M->getFunction("f");
+  ASSERT_TRUE(F != 0);
+  EXPECT_FALSE(F->isDeclaration());
+  EXPECT_FALSE(verifyModule(*M, ReturnStatusAction));
+}
+
+TEST(IncrementalParserTest, ForwardReferenceAcrossChunks) {
+  LLVMContext Context;
+  OwningPtr<Module> M(new Module("test", Context));
+  SMDiagnostic Err;
+  IncrementalAssemblyParser Parser(M.get(), Err);
+
+  // @later is not defined until the second chunk.
+  EXPECT_FALSE(Parser.ParseChunk("define i32 @f() {\n"
+                                 "  %v = call i32 @later()\n"
+                                 "  ret i32 %v\n"
+                                 "}\n"));
+  EXPECT_FALSE(Parser.ParseChunk("define i32 @later() {\n"
+                                 "  ret i32 0\n"
+                                 "}\n"));
+  EXPECT_FALSE(Parser.Finish());
+
+  Function *Later = M->getFunction("later");
+  ASSERT_TRUE(Later != 0);
+  EXPECT_FALSE(Later->isDeclaration());
+  EXPECT_FALSE(verifyModule(*M, ReturnStatusAction));
+}
+
+TEST(IncrementalParserTest, NamedTypeAcrossChunks) {
+  LLVMContext Context;
+  OwningPtr<Module> M(new Module("test", Context));
+  SMDiagnostic Err;
+  IncrementalAssemblyParser Parser(M.get(), Err);
+
+  EXPECT_FALSE(Parser.ParseChunk("%pair = type { i32, i32 }\n"));
+  EXPECT_FALSE(Parser.ParseChunk("@p = global %pair zeroinitializer\n"));
+  EXPECT_FALSE(Parser.Finish());
+
+  GlobalVariable *P = M->getGlobalVariable("p");
+  ASSERT_TRUE(P != 0);
+  StructType *STy = dyn_cast<StructType>(P->getType()->getElementType());
+  ASSERT_TRUE(STy != 0);
+  EXPECT_EQ("pair", STy->getName());
+}
+
+TEST(IncrementalParserTest, UnresolvedReferenceAtFinish) {
+  LLVMContext Context;
+  OwningPtr<Module> M(new Module("test", Context));
+  SMDiagnostic Err;
+  IncrementalAssemblyParser Parser(M.get(), Err);
+
+  EXPECT_FALSE(Parser.ParseChunk("@g = global i32* @missing\n"));
+  EXPECT_TRUE(Parser.Finish());
+}
+
+} // end anonymous namespace
+} // end namespace llvm
@@ -256,5 +256,32 @@ TEST(ConstantsTest, AsInstructionsTest) {
 
 #undef CHECK
 
+TEST(ConstantsTest, SharedConstantData) {
+  uint32_t Table[] = { 10, 20, 30, 40, 50 };
+
+  LLVMContext C1, C2;
+  C1.enableSharedConstantData();
+  C2.enableSharedConstantData();
+
+  Constant *A1 = ConstantDataArray::get(C1, Table);
+  Constant *A2 = ConstantDataArray::get(C2, Table);
+
+  // Each context has its own handle object...
+  EXPECT_NE(A1, A2);
+
+  // ...but identical payloads share one copy of the bytes.
+  StringRef D1 = cast<ConstantDataArray>(A1)->getRawDataValues();
+  StringRef D2 = cast<ConstantDataArray>(A2)->getRawDataValues();
+  EXPECT_EQ(D1.data(), D2.data());
+  EXPECT_EQ(D1, D2);
+
+  // A context that did not opt in keeps a private copy.
+  LLVMContext C3;
+  Constant *A3 = ConstantDataArray::get(C3, Table);
+  StringRef D3 = cast<ConstantDataArray>(A3)->getRawDataValues();
+  EXPECT_NE(D1.data(), D3.data());
+  EXPECT_EQ(D1, D3);
+}
+
 }  // end anonymous namespace
 }  // end namespace llvm
@@ -196,6 +196,62 @@ namespace llvm {
       Passes.add(P);
       Passes.run(*M);
     }
+
+    TEST(DominatorTree, IncrementalUpdates) {
+      const char *ModuleString =
+        "define void @f(i1 %cond) {\n"
+        "entry:\n"
+        "  br i1 %cond, label %a, label %b\n"
+        "a:\n"
+        "  br label %c\n"
+        "b:\n"
+        "  br label %c\n"
+        "c:\n"
+        "  br label %d\n"
+        "d:\n"
+        "  ret void\n"
+        "}\n";
+      LLVMContext &C = getGlobalContext();
+      SMDiagnostic Err;
+      OwningPtr<Module> M(ParseAssemblyString(ModuleString, NULL, Err, C));
+      Function *F = M->getFunction("f");
+
+      Function::iterator FI = F->begin();
+      BasicBlock *Entry = FI++;
+      BasicBlock *A = FI++;
+      BasicBlock *B = FI++;
+      BasicBlock *CBlock = FI++;
+      BasicBlock *D = FI++;
+
+      DominatorTree DT;
+      DT.getBase().recalculate(*F);
+
+      // Retarget a's branch from c to d, then tell the tree about the two
+      // edge changes.
+      A->getTerminator()->setSuccessor(0, D);
+      DT.deleteEdge(A, CBlock);
+      DT.insertEdge(A, D);
+
+      EXPECT_TRUE(DT.dominates(Entry, D));
+      EXPECT_TRUE(DT.dominates(B, CBlock));
+      EXPECT_FALSE(DT.dominates(CBlock, D));
+
+      // The patched tree must match one computed from scratch.
+      DominatorTree Fresh;
+      Fresh.getBase().recalculate(*F);
+      EXPECT_FALSE(DT.compare(Fresh));
+
+      // Apply a second round of updates, including a self loop, and check
+      // the tree again.
+      EXPECT_TRUE(DT.dominates(Entry, CBlock));
+      CBlock->getTerminator()->setSuccessor(0, CBlock);
+      DT.deleteEdge(CBlock, D);
+      DT.insertEdge(CBlock, CBlock);
+
+      DominatorTree Fresh2;
+      Fresh2.getBase().recalculate(*F);
+      EXPECT_FALSE(DT.compare(Fresh2));
+    }
   }
 }
 
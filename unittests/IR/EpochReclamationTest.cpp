@@ -0,0 +1,138 @@
+//===- llvm/unittest/IR/EpochReclamationTest.cpp - Deferred deletion ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/EpochReclamation.h"
+#include "llvm/IR/Argument.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/ValueHandle.h"
+#include "gtest/gtest.h"
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+/// Deferred reclamation only engages in multithreaded mode; these tests skip
+/// themselves when threading support is not compiled in.
+struct MultiThreadedMode {
+  bool Enabled;
+  MultiThreadedMode() : Enabled(llvm_start_multithreaded()) {}
+  ~MultiThreadedMode() {
+    if (Enabled)
+      llvm_stop_multithreaded();
+  }
+};
+
+static unsigned NumDeleted;
+static void countingDeleter(void *) { ++NumDeleted; }
+
+TEST(EpochReclamationTest, ImmediateWhenSingleThreaded) {
+  ASSERT_FALSE(llvm_is_multithreaded());
+  sys::EpochReclamationManager M;
+  int Obj;
+  NumDeleted = 0;
+  M.retire(&Obj, countingDeleter);
+  EXPECT_EQ(1u, NumDeleted);
+}
+
+TEST(EpochReclamationTest, GracePeriod) {
+  MultiThreadedMode MT;
+  if (!MT.Enabled)
+    return;
+  sys::EpochReclamationManager M;
+  int Obj;
+  NumDeleted = 0;
+  M.retire(&Obj, countingDeleter);
+  EXPECT_EQ(0u, NumDeleted);
+
+  // One epoch is not enough: a thread could still be inside the epoch the
+  // object was retired in.
+  M.collect();
+  EXPECT_EQ(0u, NumDeleted);
+
+  // Two epochs later nobody can reference it.
+  M.collect();
+  EXPECT_EQ(1u, NumDeleted);
+}
+
+TEST(EpochReclamationTest, ReaderHoldsBackReclamation) {
+  MultiThreadedMode MT;
+  if (!MT.Enabled)
+    return;
+  sys::EpochReclamationManager M;
+  int Obj;
+  NumDeleted = 0;
+
+  M.enterCriticalRegion();
+  M.retire(&Obj, countingDeleter);
+
+  // The first collection may advance the epoch once past the reader, but a
+  // reader that never leaves pins it there, so the object never ages out.
+  M.collect();
+  M.collect();
+  M.collect();
+  EXPECT_EQ(0u, NumDeleted);
+
+  M.exitCriticalRegion();
+  M.collect();
+  EXPECT_EQ(1u, NumDeleted);
+}
+
+TEST(EpochReclamationTest, DrainAtQuiescentPoint) {
+  MultiThreadedMode MT;
+  if (!MT.Enabled)
+    return;
+  sys::EpochReclamationManager M;
+  int Objs[10];
+  NumDeleted = 0;
+  for (unsigned i = 0; i != 10; ++i)
+    M.retire(&Objs[i], countingDeleter);
+  EXPECT_EQ(10u, M.drain());
+  EXPECT_EQ(10u, NumDeleted);
+  EXPECT_EQ(0u, M.drain());
+}
+
+TEST(EpochReclamationTest, DeferredValueDeletion) {
+  MultiThreadedMode MT;
+  if (!MT.Enabled)
+    return;
+  LLVMContext C;
+  Value *V = new Argument(Type::getInt32Ty(C), "a");
+  WeakVH H(V);
+  V->deleteDeferred();
+
+  // The value is queued, not destroyed; the handle still sees it.
+  EXPECT_EQ(V, (Value*)H);
+
+  getValueReclamationManager().drain();
+  EXPECT_EQ((Value*)0, (Value*)H);
+}
+
+TEST(EpochReclamationTest, ManyValuesAcrossEpochs) {
+  MultiThreadedMode MT;
+  if (!MT.Enabled)
+    return;
+  LLVMContext C;
+  sys::EpochReclamationManager &M = getValueReclamationManager();
+  std::vector<WeakVH> Handles;
+  for (unsigned i = 0; i != 1000; ++i) {
+    Value *V = new Argument(Type::getInt32Ty(C), "a");
+    Handles.push_back(WeakVH(V));
+    V->deleteDeferred();
+    if ((i & 63) == 0)
+      M.collect();
+  }
+  M.drain();
+  for (unsigned i = 0, e = Handles.size(); i != e; ++i)
+    EXPECT_EQ((Value*)0, (Value*)Handles[i]);
+}
+
+} // end anonymous namespace
@@ -92,6 +92,34 @@ TEST(AllocatorTest, TestOverflow) {
   EXPECT_EQ(2U, Alloc.GetNumSlabs());
 }
 
+// Test that the slab size doubles once the growth delay is reached.
+TEST(AllocatorTest, TestGrowthDelay) {
+  MallocSlabAllocator SlabAlloc;
+  BumpPtrAllocator Alloc(4096, 4096, SlabAlloc, /*growthDelay=*/2);
+
+  // The first two slabs are the base size; the third one is doubled, so the
+  // fourth allocation still fits in it.
+  for (unsigned i = 0; i != 4; ++i)
+    Alloc.Allocate(3000, 0);
+  EXPECT_EQ(3U, Alloc.GetNumSlabs());
+}
+
+// Test the mmap-backed slab allocator.
+TEST(AllocatorTest, TestMmapSlabAllocator) {
+  MmapSlabAllocator SlabAlloc;
+  BumpPtrAllocator Alloc(4096, 4096, SlabAlloc);
+
+  int *a = (int*)Alloc.Allocate(sizeof(int), 0);
+  *a = 1;
+  Alloc.Allocate(3000, 0);
+  Alloc.Allocate(3000, 0);
+  EXPECT_EQ(1, *a);
+  EXPECT_EQ(2U, Alloc.GetNumSlabs());
+
+  Alloc.Reset();
+  EXPECT_EQ(1U, Alloc.GetNumSlabs());
+}
+
 // Test allocating with a size larger than the initial slab size.
 TEST(AllocatorTest, TestSmallSlabSize) {
   BumpPtrAllocator Alloc(128);
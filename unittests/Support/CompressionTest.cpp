@@ -0,0 +1,75 @@
+//===- llvm/unittest/Support/CompressionTest.cpp - Compression tests ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements unit tests for the Compression functions.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/Compression.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "gtest/gtest.h"
+#include <cstdlib>
+
+using namespace llvm;
+
+namespace {
+
+static void TestRoundTrip(StringRef Input) {
+  SmallVector<char, 0> Compressed;
+  SmallVector<char, 0> Uncompressed;
+  compression::compress(Input, Compressed);
+  EXPECT_TRUE(compression::uncompress(
+      StringRef(Compressed.data(), Compressed.size()), Uncompressed,
+      Input.size()));
+  EXPECT_EQ(Input.size(), Uncompressed.size());
+  EXPECT_EQ(Input, StringRef(Uncompressed.data(), Uncompressed.size()));
+}
+
+TEST(CompressionTest, RoundTrip) {
+  TestRoundTrip("");
+  TestRoundTrip("a");
+  TestRoundTrip("hello, world!");
+  TestRoundTrip(std::string(100000, 'x'));
+
+  std::string Repetitive;
+  for (unsigned i = 0; i != 1000; ++i)
+    Repetitive += "the quick brown fox jumps over the lazy dog ";
+  TestRoundTrip(Repetitive);
+}
+
+TEST(CompressionTest, RoundTripRandom) {
+  std::string Random;
+  srand(42);
+  for (unsigned i = 0; i != 50000; ++i)
+    Random += (char)(rand() & 0xFF);
+  TestRoundTrip(Random);
+}
+
+TEST(CompressionTest, RepetitiveInputShrinks) {
+  std::string Repetitive(100000, 'x');
+  SmallVector<char, 0> Compressed;
+  compression::compress(Repetitive, Compressed);
+  EXPECT_LT(Compressed.size(), Repetitive.size() / 10);
+}
+
+TEST(CompressionTest, TruncatedInputFails) {
+  std::string Repetitive;
+  for (unsigned i = 0; i != 1000; ++i)
+    Repetitive += "the quick brown fox jumps over the lazy dog ";
+  SmallVector<char, 0> Compressed;
+  compression::compress(Repetitive, Compressed);
+
+  SmallVector<char, 0> Uncompressed;
+  EXPECT_FALSE(compression::uncompress(
+      StringRef(Compressed.data(), Compressed.size() / 2), Uncompressed,
+      Repetitive.size()));
+}
+
+}
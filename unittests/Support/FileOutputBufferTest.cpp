@@ -117,6 +117,31 @@ TEST(FileOutputBuffer, Test) {
   bool IsExecutable = (Status.permissions() & fs::owner_exe);
   EXPECT_TRUE(IsExecutable);
 
+  // TEST 5: Verify group commit, with one durable buffer.
+  SmallString<128> File5(TestDirectory);
+	File5.append("/file5");
+  SmallString<128> File6(TestDirectory);
+	File6.append("/file6");
+  {
+    OwningPtr<FileOutputBuffer> Buffer5, Buffer6;
+    ASSERT_NO_ERROR(FileOutputBuffer::create(File5, 8192, Buffer5,
+                                              FileOutputBuffer::F_durable));
+    ASSERT_NO_ERROR(FileOutputBuffer::create(File6, 8192, Buffer6));
+    memcpy(Buffer5->getBufferStart(), "AABBCCDDEEFFGGHHIIJJ", 20);
+    memcpy(Buffer6->getBufferStart(), "AABBCCDDEEFFGGHHIIJJ", 20);
+    // Commit both buffers together.
+    FileOutputBuffer *Buffers[] = { Buffer5.get(), Buffer6.get() };
+    ASSERT_NO_ERROR(FileOutputBuffer::commitAll(Buffers));
+  }
+  // Verify both files exist and start with the special header.
+  bool MagicMatches5 = false, MagicMatches6 = false;
+  ASSERT_NO_ERROR(fs::has_magic(Twine(File5), Twine("AABBCCDDEEFFGGHHIIJJ"),
+                                                              MagicMatches5));
+  EXPECT_TRUE(MagicMatches5);
+  ASSERT_NO_ERROR(fs::has_magic(Twine(File6), Twine("AABBCCDDEEFFGGHHIIJJ"),
+                                                              MagicMatches6));
+  EXPECT_TRUE(MagicMatches6);
+
   // Clean up.
   uint32_t RemovedCount;
   ASSERT_NO_ERROR(fs::remove_all(TestDirectory.str(), RemovedCount));
@@ -0,0 +1,128 @@
+//===- IRTransaction.cpp - Unit tests for IRTransaction -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Utils/IRTransaction.h"
+#include "llvm/IR/Argument.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+/// A one-block test fixture:  %add = add %x, %x
+///                            %mul = mul %add, %x
+///                            ret %mul
+class IRTransactionTest : public testing::Test {
+protected:
+  LLVMContext C;
+  BasicBlock *BB;
+  Argument *X;
+  BinaryOperator *Add;
+  BinaryOperator *Mul;
+  ReturnInst *Ret;
+
+  virtual void SetUp() {
+    Type *Int32 = Type::getInt32Ty(C);
+    X = new Argument(Int32, "x");
+    BB = BasicBlock::Create(C);
+    IRBuilder<> Builder(BB);
+    Add = cast<BinaryOperator>(Builder.CreateAdd(X, X, "add"));
+    Mul = cast<BinaryOperator>(Builder.CreateMul(Add, X, "mul"));
+    Ret = Builder.CreateRet(Mul);
+  }
+
+  virtual void TearDown() {
+    BB->dropAllReferences();
+    delete BB;
+    delete X;
+  }
+};
+
+TEST_F(IRTransactionTest, AbortRestoresOperands) {
+  {
+    IRTransaction TX;
+    TX.setOperand(Mul, 0, X);
+    EXPECT_EQ(X, Mul->getOperand(0));
+    // TX aborts on destruction.
+  }
+  EXPECT_EQ(Add, Mul->getOperand(0));
+}
+
+TEST_F(IRTransactionTest, CommitKeepsChanges) {
+  IRTransaction TX;
+  TX.setOperand(Mul, 0, X);
+  TX.commit();
+  EXPECT_EQ(X, Mul->getOperand(0));
+}
+
+TEST_F(IRTransactionTest, AbortRestoresUses) {
+  IRTransaction TX;
+  TX.replaceAllUsesWith(Add, X);
+  EXPECT_TRUE(Add->use_empty());
+  EXPECT_EQ(X, Mul->getOperand(0));
+  TX.abort();
+  EXPECT_EQ(Add, Mul->getOperand(0));
+  EXPECT_TRUE(Add->hasOneUse());
+}
+
+TEST_F(IRTransactionTest, AbortRestoresPosition) {
+  IRTransaction TX;
+  TX.moveBefore(Mul, Add);
+  EXPECT_EQ(Mul, &BB->front());
+  TX.abort();
+  EXPECT_EQ(Add, &BB->front());
+  EXPECT_EQ(Mul, Add->getNextNode());
+}
+
+TEST_F(IRTransactionTest, AbortDeletesInsertions) {
+  IRTransaction TX;
+  Instruction *Sub = BinaryOperator::CreateSub(X, X, "sub");
+  TX.insertBefore(Sub, Ret);
+  EXPECT_EQ(Sub, Mul->getNextNode());
+  TX.abort();
+  EXPECT_EQ(Ret, Mul->getNextNode());
+}
+
+TEST_F(IRTransactionTest, AbortReinsertsRemovals) {
+  IRTransaction TX;
+  TX.remove(Add, X);
+  EXPECT_EQ(Mul, &BB->front());
+  EXPECT_EQ(X, Mul->getOperand(0));
+  TX.abort();
+  EXPECT_EQ(Add, &BB->front());
+  EXPECT_EQ(Add, Mul->getOperand(0));
+}
+
+TEST_F(IRTransactionTest, CommitDeletesRemovals) {
+  IRTransaction TX;
+  TX.remove(Add, X);
+  TX.commit();
+  // Add is gone; the remaining instructions reference %x directly.
+  EXPECT_EQ(Mul, &BB->front());
+  EXPECT_EQ(X, Mul->getOperand(0));
+}
+
+TEST_F(IRTransactionTest, PartialRollback) {
+  IRTransaction TX;
+  TX.setOperand(Mul, 1, Add);
+  IRTransaction::SavePoint SP = TX.getSavePoint();
+  TX.replaceAllUsesWith(Add, X);
+  TX.rollbackTo(SP);
+  // The RAUW is undone, the earlier setOperand is kept.
+  EXPECT_EQ(Add, Mul->getOperand(0));
+  EXPECT_EQ(Add, Mul->getOperand(1));
+  TX.commit();
+  EXPECT_EQ(Add, Mul->getOperand(1));
+}
+
+}
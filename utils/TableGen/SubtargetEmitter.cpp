@@ -25,6 +25,7 @@
 #include "llvm/TableGen/TableGenBackend.h"
 #include <algorithm>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 using namespace llvm;
@@ -229,6 +230,25 @@ unsigned SubtargetEmitter::FeatureKeyValues(raw_ostream &OS) {
   return NumFeatures;
 }
 
+//
+// CollectImpliedFeatures - Collect into Implied the features transitively
+// implied by Feature. Only features visible on the command line participate,
+// matching the closure SubtargetFeatures computes for explicit +feature
+// requests.
+//
+static void CollectImpliedFeatures(std::set<Record*> &Implied,
+                                   Record *Feature) {
+  const std::vector<Record*> &ImpliesList =
+    Feature->getValueAsListOfDefs("Implies");
+  for (unsigned i = 0, e = ImpliesList.size(); i != e; ++i) {
+    Record *R = ImpliesList[i];
+    if (R->getValueAsString("Name").empty())
+      continue;
+    if (Implied.insert(R).second)
+      CollectImpliedFeatures(Implied, R);
+  }
+}
+
 //
 // CPUKeyValues - Emit data of all the subtarget processors.  Used by command
 // line.
@@ -253,16 +273,31 @@ unsigned SubtargetEmitter::CPUKeyValues(raw_ostream &OS) {
     const std::vector<Record*> &FeatureList =
       Processor->getValueAsListOfDefs("Features");
 
+    // Fold the transitive closure of implied features into the processor's
+    // mask, so SubtargetFeatures::getFeatureBits does not have to recompute
+    // it at every MCSubtargetInfo creation.
+    std::set<Record*> ImpliedFeatures;
+    for (unsigned j = 0, M = FeatureList.size(); j < M; ++j)
+      if (!FeatureList[j]->getValueAsString("Name").empty())
+        CollectImpliedFeatures(ImpliedFeatures, FeatureList[j]);
+
+    std::vector<Record*> AllFeatures = FeatureList;
+    for (std::set<Record*>::iterator I = ImpliedFeatures.begin(),
+           E = ImpliedFeatures.end(); I != E; ++I)
+      if (std::find(FeatureList.begin(), FeatureList.end(), *I) ==
+          FeatureList.end())
+        AllFeatures.push_back(*I);
+
     // Emit as { "cpu", "description", f1 | f2 | ... fn },
     OS << "  { "
        << "\"" << Name << "\", "
        << "\"Select the " << Name << " processor\", ";
 
-    if (FeatureList.empty()) {
+    if (AllFeatures.empty()) {
       OS << "0ULL";
     } else {
-      for (unsigned j = 0, M = FeatureList.size(); j < M;) {
-        OS << Target << "::" << FeatureList[j]->getName();
+      for (unsigned j = 0, M = AllFeatures.size(); j < M;) {
+        OS << Target << "::" << AllFeatures[j]->getName();
         if (++j < M) OS << " | ";
       }
     }